@@ -0,0 +1,146 @@
+/*
+
+  ESP-IDF Driver Benchmark
+
+  Measures the hot paths of the DMX driver on the target and prints one JSON
+  object per result, so that results may be compared across releases. Lines
+  which start with '{' can be collected from the serial monitor:
+
+    {"name":"dmx_uart_isr.rx_data.mean","value":612.000,"unit":"cycles"}
+
+  DMX port 1 sends DMX packets and RDM requests to DMX port 2. The cycles spent
+  in each branch of the UART interrupt handler, the latency from a received
+  DMX break until dmx_receive() returns, the latency from a call to dmx_send()
+  until the DMX break starts, and the round-trip time of RDM GET requests are
+  reported. Port 2 answers the RDM requests with the RDM responder task.
+
+  Connect the A and B lines of the two DMX transceivers. The driver must be
+  built with CONFIG_DMX_PROFILE, which is enabled in menuconfig under
+  Component config -> ESP-DMX, or by adding the following to the sdkconfig
+  of the project:
+
+    CONFIG_DMX_PROFILE=y
+
+  Note: this example is for use with the ESP-IDF. It will not work on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+#include "esp_rdm_client.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#define CONTROLLER_TX_PIN 17  // the pin we are using to TX with on port 1
+#define CONTROLLER_RX_PIN 16  // the pin we are using to RX with on port 1
+#define CONTROLLER_EN_PIN 21  // the pin we are using to enable TX on port 1
+#define RESPONDER_TX_PIN 25   // the pin we are using to TX with on port 2
+#define RESPONDER_RX_PIN 26   // the pin we are using to RX with on port 2
+#define RESPONDER_EN_PIN 27   // the pin we are using to enable TX on port 2
+
+#define NUM_PACKETS 1000
+#define NUM_REQUESTS 1000
+
+static const char *TAG = "main";
+
+static const char *const isr_branch_names[DMX_ISR_BRANCH_MAX] = {
+    "rx_err", "rx_break", "rx_data", "tx_data", "tx_done"};
+
+static void report(const char *name, double value, const char *unit) {
+  printf("{\"name\":\"%s\",\"value\":%.3f,\"unit\":\"%s\"}\n", name, value,
+         unit);
+}
+
+static void report_stat(const char *name, const dmx_profile_stat_t *stat,
+                        const char *unit) {
+  char key[64];
+  snprintf(key, sizeof(key), "%s.mean", name);
+  report(key, stat->count ? (double)stat->total / stat->count : 0, unit);
+  snprintf(key, sizeof(key), "%s.max", name);
+  report(key, stat->max, unit);
+}
+
+static void report_isr(const char *port, const dmx_profile_t *profile) {
+  char name[48];
+  for (int i = 0; i < DMX_ISR_BRANCH_MAX; ++i) {
+    snprintf(name, sizeof(name), "dmx_uart_isr.%s.%s", port,
+             isr_branch_names[i]);
+    report_stat(name, &profile->isr_cycles[i], "cycles");
+  }
+}
+
+void app_main() {
+  const dmx_port_t controller_num = DMX_NUM_1;
+  const dmx_port_t responder_num = DMX_NUM_2;
+  ESP_ERROR_CHECK(dmx_driver_install(controller_num, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_set_pin(controller_num, CONTROLLER_TX_PIN,
+                              CONTROLLER_RX_PIN, CONTROLLER_EN_PIN));
+  ESP_ERROR_CHECK(dmx_driver_install(responder_num, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_set_pin(responder_num, RESPONDER_TX_PIN,
+                              RESPONDER_RX_PIN, RESPONDER_EN_PIN));
+
+  dmx_profile_t profile;
+  if (!dmx_get_profile(controller_num, &profile)) {
+    ESP_LOGE(TAG, "the driver was built without CONFIG_DMX_PROFILE");
+    return;
+  }
+
+  // Send DMX packets from the controller to the responder
+  uint8_t data[DMX_MAX_PACKET_SIZE] = {0};
+  dmx_write(controller_num, data, DMX_MAX_PACKET_SIZE);
+  for (int i = 0; i < NUM_PACKETS; ++i) {
+    dmx_send(controller_num, 0);
+    dmx_packet_t packet;
+    if (!dmx_receive(responder_num, &packet, DMX_TIMEOUT_TICK) || packet.err) {
+      ESP_LOGW(TAG, "packet %i was not received", i);
+    }
+  }
+  dmx_get_profile(controller_num, &profile);
+  report_isr("controller", &profile);
+  report_stat("dmx_send.call_to_break", &profile.tx_break_us, "us");
+  dmx_get_profile(responder_num, &profile);
+  report_isr("responder", &profile);
+  report_stat("dmx_receive.wake_from_break", &profile.rx_wake_us, "us");
+
+  // Send RDM requests to the responder task
+  rdm_client_init(responder_num, 1, 1, "Benchmark", "Default");
+  if (!rdm_client_responder_start(responder_num, NULL)) {
+    ESP_LOGE(TAG, "failed to start the RDM responder task");
+    return;
+  }
+  dmx_reset_profile(controller_num);
+  const rdm_uid_t uid = rdm_get_uid(responder_num);
+  uint8_t pd[RDM_MAX_PDL];
+  int64_t total = 0, max = 0;
+  int num_answered = 0;
+  for (int i = 0; i < NUM_REQUESTS; ++i) {
+    rdm_response_t response;
+    const int64_t start = esp_timer_get_time();
+    rdm_get_generic(controller_num, uid, RDM_ROOT_DEVICE, RDM_PID_DEVICE_INFO,
+                    NULL, 0, &response, pd, sizeof(pd));
+    const int64_t elapsed = esp_timer_get_time() - start;
+    if (response.err || response.type != RDM_RESPONSE_TYPE_ACK) {
+      continue;
+    }
+    ++num_answered;
+    total += elapsed;
+    if (elapsed > max) {
+      max = elapsed;
+    }
+  }
+  report("rdm_get_generic.round_trip.mean",
+         num_answered ? (double)total / num_answered : 0, "us");
+  report("rdm_get_generic.round_trip.max", max, "us");
+  report("rdm_get_generic.answered", num_answered, "requests");
+  dmx_get_profile(controller_num, &profile);
+  report_isr("rdm_controller", &profile);
+
+  rdm_client_responder_stop(responder_num);
+  dmx_driver_delete(controller_num);
+  dmx_driver_delete(responder_num);
+  ESP_LOGI(TAG, "terminating program");
+}
@@ -0,0 +1,137 @@
+/*
+
+  ESP-IDF RDM Codec Benchmark
+
+  Compares the table-driven RDM parameter data codec against the encode and
+  decode functions of the library which it replaces in the RDM controller and
+  responder. DEVICE_INFO, SUPPORTED_PARAMETERS, and SOFTWARE_VERSION_LABEL
+  parameter data are each encoded and decoded many times and the average time
+  per operation is logged. No DMX hardware is needed to run this example.
+
+  Note: this example is for use with the ESP-IDF. It will not work on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include "dmx_types.h"
+#include "esp_log.h"
+#include "esp_rdm_codec.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "private/rdm_encode/functions.h"
+#include "rdm_types.h"
+
+#define ITERATIONS 100000
+
+static const char *TAG = "main";
+
+// Keeps the compiler from optimizing the benchmarked code away.
+static volatile uint32_t sink;
+
+static void report(const char *name, int64_t elapsed) {
+  ESP_LOGI(TAG, "%-36s %6lld ns/op", name,
+           (long long)(elapsed * 1000 / ITERATIONS));
+}
+
+void app_main() {
+  const rdm_device_info_t info = {.major_rdm_version = 1,
+                                  .minor_rdm_version = 0,
+                                  .model_id = 0x1234,
+                                  .coarse_product_category = 0x01,
+                                  .fine_product_category = 0x00,
+                                  .software_version_id = 0x01020304,
+                                  .footprint = 16,
+                                  .current_personality = 1,
+                                  .personality_count = 3,
+                                  .start_address = 1,
+                                  .sub_device_count = 0,
+                                  .sensor_count = 1};
+  const rdm_pid_t pids[] = {RDM_PID_DEVICE_LABEL, RDM_PID_DMX_PERSONALITY,
+                            RDM_PID_DMX_PERSONALITY_DESCRIPTION,
+                            RDM_PID_SENSOR_DEFINITION, RDM_PID_SENSOR_VALUE,
+                            RDM_PID_RECORD_SENSORS};
+  const size_t num_pids = sizeof(pids) / sizeof(pids[0]);
+  const char label[] = "esp_dmx codec benchmark";
+  const rdm_format_t *info_format = rdm_pid_desc_find(RDM_PID_DEVICE_INFO)->data;
+  const rdm_format_t *pid_format =
+      rdm_pid_desc_find(RDM_PID_SUPPORTED_PARAMETERS)->data;
+  const rdm_format_t *label_format =
+      rdm_pid_desc_find(RDM_PID_SOFTWARE_VERSION_LABEL)->data;
+
+  uint8_t pd[RDM_MAX_PDL];
+  rdm_device_info_t decoded_info;
+  rdm_pid_t decoded_pids[sizeof(pids) / sizeof(pids[0])];
+  char decoded_label[33];
+  size_t pdl;
+  int64_t start;
+
+  start = esp_timer_get_time();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    sink = rdm_encode_device_info_(pd, &info);
+  }
+  report("DEVICE_INFO encode (library)", esp_timer_get_time() - start);
+
+  start = esp_timer_get_time();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    sink = rdm_codec_encode(info_format, pd, &info, 1);
+  }
+  report("DEVICE_INFO encode (table)", esp_timer_get_time() - start);
+
+  pdl = rdm_codec_encode(info_format, pd, &info, 1);
+  start = esp_timer_get_time();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    sink = rdm_decode_device_info(pd, &decoded_info, 1, pdl);
+  }
+  report("DEVICE_INFO decode (library)", esp_timer_get_time() - start);
+
+  start = esp_timer_get_time();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    sink = rdm_codec_decode(info_format, pd, &decoded_info, 1, pdl);
+  }
+  report("DEVICE_INFO decode (table)", esp_timer_get_time() - start);
+
+  start = esp_timer_get_time();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    sink = rdm_encode_16bit(pd, pids, num_pids);
+  }
+  report("SUPPORTED_PARAMETERS encode (library)",
+         esp_timer_get_time() - start);
+
+  start = esp_timer_get_time();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    sink = rdm_codec_encode(pid_format, pd, pids, num_pids);
+  }
+  report("SUPPORTED_PARAMETERS encode (table)", esp_timer_get_time() - start);
+
+  pdl = rdm_codec_encode(pid_format, pd, pids, num_pids);
+  start = esp_timer_get_time();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    sink = rdm_decode_16bit(pd, decoded_pids, num_pids, pdl);
+  }
+  report("SUPPORTED_PARAMETERS decode (library)",
+         esp_timer_get_time() - start);
+
+  start = esp_timer_get_time();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    sink = rdm_codec_decode(pid_format, pd, decoded_pids, num_pids, pdl);
+  }
+  report("SUPPORTED_PARAMETERS decode (table)", esp_timer_get_time() - start);
+
+  pdl = rdm_codec_encode(label_format, pd, label, 1);
+  start = esp_timer_get_time();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    sink = rdm_decode_string(pd, decoded_label, sizeof(decoded_label), pdl);
+  }
+  report("SOFTWARE_VERSION_LABEL decode (library)",
+         esp_timer_get_time() - start);
+
+  start = esp_timer_get_time();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    sink = rdm_codec_decode(label_format, pd, decoded_label,
+                            sizeof(decoded_label), pdl);
+  }
+  report("SOFTWARE_VERSION_LABEL decode (table)",
+         esp_timer_get_time() - start);
+
+  ESP_LOGI(TAG, "terminating program");
+}
@@ -0,0 +1,136 @@
+/*
+
+  Host DMX Timing Analyzer
+
+  Runs the DMX driver on Linux against a simulated UART with its receive line
+  wired to the DMX sniffer pin. Packets with a short DMX break, a short
+  mark-after-break, a short break-to-break time, no slots, too many slots, and
+  a long mark between slots are received among packets which are within the
+  E1.11 receive timing limits, while the DMX timing analyzer is enabled. The
+  events and counters of the analyzer are logged.
+
+  Exits with a non-zero status if the analyzer did not count exactly the
+  violations which were received.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+#include <string.h>
+
+#include "dmx_sim.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+
+#define SNIFFER_PIN 4
+#define GAP_NS 1000000LL          // The gap between packets.
+#define LONG_MARK_NS 1200000000LL  // The long mark between slots.
+
+static const char *TAG = "main";
+
+static const char *const check_names[DMX_ANALYZER_CHECK_MAX] = {
+    "break", "mab", "break-to-break", "slot count", "mark between slots"};
+
+static int num_errors = 0;
+
+// Receives a packet with a DMX break, a mark-after-break and some slots.
+// Returns the virtual time at which the packet ends.
+static int64_t receive_packet(dmx_port_t dmx_num, int64_t start, size_t size,
+                              uint32_t break_len, uint32_t mab_len) {
+  uint8_t data[600];
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = i == 0 ? DMX_SC : i * 7;
+  }
+  return dmx_sim_receive_packet(dmx_num, start, data, size, break_len,
+                                mab_len);
+}
+
+// Receives a packet of five slots with a long mark after the third slot.
+static int64_t receive_long_mark(dmx_port_t dmx_num, int64_t start) {
+  const uint8_t data[] = {DMX_SC, 1, 2, 3, 4};
+  int64_t time = dmx_sim_receive_packet(dmx_num, start, data, 3,
+                                        DMX_BREAK_LEN_US, DMX_MAB_LEN_US);
+  return dmx_sim_receive_packet(dmx_num, time + LONG_MARK_NS, data + 3, 2, 0,
+                                0);
+}
+
+static void receive_packets(dmx_port_t dmx_num) {
+  int64_t time = dmx_sim_get_time() + GAP_NS;
+  time = receive_packet(dmx_num, time, 25, 176, 12) + GAP_NS;
+  time = receive_packet(dmx_num, time, 25, 176, 12) + GAP_NS;
+  time = receive_packet(dmx_num, time, 25, 60, 12) + GAP_NS;  // Short break
+  time = receive_packet(dmx_num, time, 25, 176, 4) + GAP_NS;  // Short MAB
+
+  // No slots, so the break-to-break time is short too
+  time = receive_packet(dmx_num, time, 0, 176, 12) + GAP_NS / 4;
+
+  // A short break-to-break time
+  time = receive_packet(dmx_num, time, 1, 92, 12) + 20000;
+
+  time = receive_packet(dmx_num, time, 600, 176, 12) + GAP_NS;  // Too long
+  time = receive_long_mark(dmx_num, time) + GAP_NS;
+  time = receive_packet(dmx_num, time, 25, 176, 12) + GAP_NS;
+  receive_packet(dmx_num, time, 25, 176, 12);
+}
+
+static void app_main(void *arg) {
+  const dmx_port_t dmx_num = DMX_NUM_1;
+  ESP_ERROR_CHECK(dmx_driver_install(dmx_num, DMX_DEFAULT_INTR_FLAGS));
+  dmx_sim_connect_gpio(dmx_num, SNIFFER_PIN);
+  ESP_ERROR_CHECK(dmx_sniffer_enable(dmx_num, SNIFFER_PIN));
+
+  // Raise an event for each violation
+  dmx_analyzer_config_t config = DMX_ANALYZER_DEFAULT_CONFIG;
+  config.event_interval_ms = 0;
+  ESP_ERROR_CHECK(dmx_analyzer_enable(dmx_num, &config));
+
+  receive_packets(dmx_num);
+  vTaskDelay(pdMS_TO_TICKS(1500));
+
+  uint32_t num_events[DMX_ANALYZER_CHECK_MAX] = {0};
+  dmx_analyzer_event_t event;
+  while (dmx_analyzer_get_event(dmx_num, &event, 0)) {
+    ESP_LOGW(TAG, "%lld us: %s out of specification %u times (%u to %u)",
+             (long long)event.timestamp, check_names[event.check],
+             (unsigned)event.num_violations, (unsigned)event.min,
+             (unsigned)event.max);
+    num_events[event.check] += event.num_violations;
+  }
+
+  // Nine packets are checked when the DMX break of the next is received, but
+  // the DMX break and mark-after-break of all ten are checked
+  static const uint32_t expected_checked[DMX_ANALYZER_CHECK_MAX] = {10, 10, 9,
+                                                                    9, 9};
+  static const uint32_t expected_violations[DMX_ANALYZER_CHECK_MAX] = {1, 1, 2,
+                                                                       2, 1};
+  dmx_analyzer_stats_t stats;
+  if (!dmx_analyzer_get_stats(dmx_num, &stats)) {
+    ESP_LOGE(TAG, "the analyzer has no counters");
+    ++num_errors;
+  }
+  for (int i = 0; i < DMX_ANALYZER_CHECK_MAX; ++i) {
+    const dmx_analyzer_stat_t *const stat = &stats.checks[i];
+    printf("%-18s %2u checked, %u violations, %u to %u\n", check_names[i],
+           (unsigned)stat->num_checked, (unsigned)stat->num_violations,
+           (unsigned)stat->min, (unsigned)stat->max);
+    if (stat->num_checked != expected_checked[i] ||
+        stat->num_violations != expected_violations[i] ||
+        num_events[i] != expected_violations[i]) {
+      ESP_LOGE(TAG, "the %s check did not count the expected violations",
+               check_names[i]);
+      ++num_errors;
+    }
+  }
+
+  dmx_analyzer_disable(dmx_num);
+  dmx_sniffer_disable(dmx_num);
+  dmx_driver_delete(dmx_num);
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
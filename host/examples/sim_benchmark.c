@@ -0,0 +1,241 @@
+/*
+
+  Host Driver Benchmark
+
+  Measures the hot paths of the DMX driver on Linux and prints one JSON object
+  per result to stdout, so that results may be compared across releases:
+
+    {"name":"codec.rdm_encode_header","value":12.345,"unit":"ns/op"}
+
+  The RDM header codec is timed on the host clock. The driver is then run in
+  the host simulation: DMX port 1 sends DMX packets to DMX port 2 and sends
+  RDM requests and discovery to virtual responders on a simulated line. The
+  interrupt handler is timed on the host clock, and latencies on the virtual
+  clock of the simulation. Logs are printed to stderr.
+
+  The driver must be built with CONFIG_DMX_PROFILE, which host/CMakeLists.txt
+  defines when the DMX_PROFILE option is ON. The results can be written to a
+  file with:
+
+    cmake --build build-host --target benchmark
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_bus.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+#include "private/rdm_encode/functions.h"
+
+#define CODEC_ITERATIONS 1000000
+#define NUM_PACKETS 1000
+#define NUM_REQUESTS 1000
+
+static const char *TAG = "main";
+
+static const size_t device_counts[] = {1, 10, 100, 1000};
+
+static const char *const isr_branch_names[DMX_ISR_BRANCH_MAX] = {
+    "rx_err", "rx_break", "rx_data", "tx_data", "tx_done"};
+
+static int num_errors = 0;
+
+// Keeps the compiler from optimizing the benchmarked code away.
+static volatile uint32_t sink;
+
+static void report(const char *name, double value, const char *unit) {
+  printf("{\"name\":\"%s\",\"value\":%.3f,\"unit\":\"%s\"}\n", name, value,
+         unit);
+}
+
+static void report_stat(const char *name, const dmx_profile_stat_t *stat,
+                        const char *unit) {
+  char key[64];
+  snprintf(key, sizeof(key), "%s.mean", name);
+  report(key, stat->count ? (double)stat->total / stat->count : 0, unit);
+  snprintf(key, sizeof(key), "%s.max", name);
+  report(key, stat->max, unit);
+}
+
+static double get_wall_time(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void benchmark_codec(void) {
+  const rdm_header_t header = {.destination_uid = 0x05e012345678,
+                               .source_uid = 0x05e087654321,
+                               .tn = 1,
+                               .port_id = 1,
+                               .message_count = 0,
+                               .sub_device = RDM_ROOT_DEVICE,
+                               .cc = RDM_CC_GET_COMMAND,
+                               .pid = RDM_PID_DEVICE_INFO,
+                               .pdl = 0};
+  uint8_t data[RDM_BASE_PACKET_SIZE];
+  rdm_header_t decoded;
+
+  double start = get_wall_time();
+  for (int i = 0; i < CODEC_ITERATIONS; ++i) {
+    sink = rdm_encode_header(data, &header);
+  }
+  report("codec.rdm_encode_header",
+         (get_wall_time() - start) * 1e9 / CODEC_ITERATIONS, "ns/op");
+
+  start = get_wall_time();
+  for (int i = 0; i < CODEC_ITERATIONS; ++i) {
+    sink = rdm_decode_header(data, &decoded);
+  }
+  report("codec.rdm_decode_header",
+         (get_wall_time() - start) * 1e9 / CODEC_ITERATIONS, "ns/op");
+}
+
+static void benchmark_dmx(dmx_port_t tx_num, dmx_port_t rx_num) {
+  dmx_sim_connect(tx_num, rx_num);
+  dmx_reset_profile(tx_num);
+  dmx_reset_profile(rx_num);
+
+  uint8_t data[DMX_MAX_PACKET_SIZE] = {0};
+  dmx_write(tx_num, data, DMX_MAX_PACKET_SIZE);
+  for (int i = 0; i < NUM_PACKETS; ++i) {
+    dmx_send(tx_num, 0);
+    dmx_packet_t packet;
+    if (!dmx_receive(rx_num, &packet, DMX_TIMEOUT_TICK) || packet.err) {
+      ESP_LOGE(TAG, "packet %i was not received", i);
+      ++num_errors;
+    }
+  }
+
+  // Interrupt handler branches of both ports
+  dmx_profile_t tx_profile, rx_profile;
+  dmx_get_profile(tx_num, &tx_profile);
+  dmx_get_profile(rx_num, &rx_profile);
+  for (int i = 0; i < DMX_ISR_BRANCH_MAX; ++i) {
+    dmx_profile_stat_t stat = tx_profile.isr_cycles[i];
+    const dmx_profile_stat_t *const rx_stat = &rx_profile.isr_cycles[i];
+    stat.count += rx_stat->count;
+    stat.total += rx_stat->total;
+    if (rx_stat->max > stat.max) {
+      stat.max = rx_stat->max;
+    }
+    char name[48];
+    snprintf(name, sizeof(name), "dmx_uart_isr.%s", isr_branch_names[i]);
+    report_stat(name, &stat, "ns");
+  }
+  report("dmx_uart_isr.calls_per_packet",
+         (double)(tx_profile.isr_calls + rx_profile.isr_calls) / NUM_PACKETS,
+         "calls");
+  report_stat("dmx_receive.wake_from_break", &rx_profile.rx_wake_us, "us");
+  report_stat("dmx_send.call_to_break", &tx_profile.tx_break_us, "us");
+}
+
+static void benchmark_rdm(dmx_port_t dmx_num) {
+  dmx_sim_bus_t *const bus = dmx_sim_bus_create(NULL);
+  if (bus == NULL) {
+    ESP_LOGE(TAG, "failed to create the line");
+    ++num_errors;
+    return;
+  }
+  ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, dmx_num));
+  const rdm_uid_t uid = 0x05e000000001;
+  ESP_ERROR_CHECK(dmx_sim_bus_add_responder(bus, uid));
+
+  // The virtual responders NACK DEVICE_INFO, which is a full round trip
+  int64_t total = 0, max = 0;
+  for (int i = 0; i < NUM_REQUESTS; ++i) {
+    rdm_response_t response;
+    const int64_t start = dmx_sim_get_time();
+    rdm_get_generic(dmx_num, uid, RDM_ROOT_DEVICE, RDM_PID_DEVICE_INFO, NULL,
+                    0, &response, NULL, 0);
+    const int64_t elapsed = dmx_sim_get_time() - start;
+    if (response.type != RDM_RESPONSE_TYPE_NACK_REASON) {
+      ESP_LOGE(TAG, "request %i was not answered", i);
+      ++num_errors;
+    }
+    total += elapsed;
+    if (elapsed > max) {
+      max = elapsed;
+    }
+  }
+  report("rdm_get_generic.round_trip.mean", total / 1e3 / NUM_REQUESTS, "us");
+  report("rdm_get_generic.round_trip.max", max / 1e3, "us");
+
+  vTaskDelay(pdMS_TO_TICKS(10));
+  dmx_sim_bus_delete(bus);
+}
+
+static void on_device_found(dmx_port_t dmx_num, rdm_uid_t uid,
+                            size_t device_num, rdm_disc_mute_t *mute_params,
+                            void *context) {}
+
+static void benchmark_discovery(dmx_port_t dmx_num) {
+  for (size_t i = 0; i < sizeof(device_counts) / sizeof(device_counts[0]);
+       ++i) {
+    const size_t num_devices = device_counts[i];
+    dmx_sim_bus_t *const bus = dmx_sim_bus_create(NULL);
+    if (bus == NULL) {
+      ESP_LOGE(TAG, "failed to create the line");
+      ++num_errors;
+      return;
+    }
+    ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, dmx_num));
+    dmx_sim_bus_add_random_responders(bus, 0x05e0, num_devices);
+
+    const int64_t start = dmx_sim_get_time();
+    const size_t num_found =
+        rdm_discover_with_callback(dmx_num, on_device_found, NULL);
+    const double elapsed_ms = (dmx_sim_get_time() - start) / 1e6;
+    if (num_found != num_devices) {
+      ESP_LOGE(TAG, "found %zu of %zu devices", num_found, num_devices);
+      ++num_errors;
+    }
+
+    dmx_sim_bus_stats_t stats;
+    dmx_sim_bus_get_stats(bus, &stats);
+    char name[64];
+    snprintf(name, sizeof(name), "discovery.%zu.requests_per_device",
+             num_devices);
+    report(name, (double)stats.requests / num_devices, "packets");
+    snprintf(name, sizeof(name), "discovery.%zu.time_per_device", num_devices);
+    report(name, elapsed_ms / num_devices, "ms");
+
+    vTaskDelay(pdMS_TO_TICKS(10));
+    dmx_sim_bus_delete(bus);
+  }
+}
+
+static void app_main(void *arg) {
+  const dmx_port_t tx_num = DMX_NUM_1;
+  const dmx_port_t rx_num = DMX_NUM_2;
+  ESP_ERROR_CHECK(dmx_driver_install(tx_num, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_driver_install(rx_num, DMX_DEFAULT_INTR_FLAGS));
+
+  dmx_profile_t profile;
+  if (!dmx_get_profile(tx_num, &profile)) {
+    ESP_LOGE(TAG, "the driver was built without CONFIG_DMX_PROFILE");
+    ++num_errors;
+  } else {
+    benchmark_dmx(tx_num, rx_num);
+    benchmark_rdm(tx_num);
+    benchmark_discovery(tx_num);
+  }
+
+  dmx_driver_delete(tx_num);
+  dmx_driver_delete(rx_num);
+}
+
+int main(void) {
+  benchmark_codec();
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+/*
+
+  Host DMX Interrupt Capture
+
+  Runs the DMX driver on Linux against a simulated UART and writes a capture
+  of the interrupt handlers of DMX port 1 to stdout while it receives a full
+  DMX packet, a short DMX packet, a packet with a framing error, an RDM
+  request for another device, and then nothing until dmx_receive() times out.
+  Then it sends a DMX packet. The calls to dmx_receive() and dmx_send() and
+  their outcomes are written to the capture too, so that dmx_replay can check
+  that the driver still handles the same interrupts the same way:
+
+    ./build-host/sim_capture > rx.cap && ./build-host/dmx_replay rx.cap
+
+  Exits with a non-zero status if the driver was built without
+  CONFIG_DMX_ISR_CAPTURE.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+
+#include "dmx_sim.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+
+#define RECEIVE_TIMEOUT_MS 50
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+
+// Writes a pass of an interrupt handler as a line of the capture.
+static void write_capture(dmx_port_t dmx_num, const dmx_isr_capture_t *capture,
+                          void *context) {
+  FILE *const file = context;
+  if (capture->source == DMX_ISR_CAPTURE_TIMER) {
+    fprintf(file, "%lld timer\n", (long long)capture->timestamp);
+    return;
+  }
+  fprintf(file, "%lld uart %x %u", (long long)capture->timestamp,
+          capture->intr_flags, capture->rx_len);
+  if (capture->rx_read > 0) {
+    fputc(' ', file);
+    for (uint32_t i = 0; i < capture->rx_read; ++i) {
+      fprintf(file, "%02x", capture->rx_data[i]);
+    }
+  }
+  fputc('\n', file);
+}
+
+// Receives a packet with a break and a framing error on one of its slots.
+static int64_t receive_corrupt_packet(dmx_port_t dmx_num, int64_t start,
+                                      size_t size, size_t corrupt_slot) {
+  const int64_t slot_duration = dmx_sim_slot_duration(DMX_BAUD_RATE);
+  dmx_sim_symbol_t symbol = {.start = start,
+                             .duration = DMX_BREAK_LEN_US * 1000,
+                             .type = DMX_SIM_SYMBOL_BREAK};
+  dmx_sim_receive(dmx_num, &symbol);
+  symbol.start += symbol.duration + DMX_MAB_LEN_US * 1000;
+  symbol.duration = slot_duration;
+  symbol.type = DMX_SIM_SYMBOL_SLOT;
+  for (size_t i = 0; i < size; ++i) {
+    symbol.value = i;
+    symbol.framing_error = i == corrupt_slot;
+    dmx_sim_receive(dmx_num, &symbol);
+    symbol.start += slot_duration;
+  }
+  return symbol.start;
+}
+
+static void app_main(void *arg) {
+  const dmx_port_t dmx_num = DMX_NUM_1;
+  ESP_ERROR_CHECK(dmx_driver_install(dmx_num, DMX_DEFAULT_INTR_FLAGS));
+  if (dmx_set_isr_capture_cb(dmx_num, write_capture, stdout) != ESP_OK) {
+    ESP_LOGE(TAG, "the driver was built without CONFIG_DMX_ISR_CAPTURE");
+    ++num_errors;
+    dmx_driver_delete(dmx_num);
+    return;
+  }
+
+  // An RDM GET DEVICE_INFO request for another device
+  uint8_t rdm[26] = {0xcc, 0x01, 24,   0x05, 0xe0, 0x00, 0x00, 0x00, 0x99,
+                     0x05, 0xe0, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00,
+                     0x00, 0x00, 0x20, 0x00, 0x60, 0x00};
+  uint16_t checksum = 0;
+  for (int i = 0; i < 24; ++i) {
+    checksum += rdm[i];
+  }
+  rdm[24] = checksum >> 8;
+  rdm[25] = checksum & 0xff;
+
+  // Schedule the packets on the line
+  uint8_t data[DMX_PACKET_SIZE] = {0};
+  for (int slot = 1; slot < DMX_PACKET_SIZE; ++slot) {
+    data[slot] = slot;
+  }
+  int64_t time = 1000000;
+  time = dmx_sim_receive_packet(dmx_num, time, data, DMX_PACKET_SIZE,
+                                DMX_BREAK_LEN_US, DMX_MAB_LEN_US);
+  time = dmx_sim_receive_packet(dmx_num, time + 1000000, data, 25,
+                                DMX_BREAK_LEN_US, DMX_MAB_LEN_US);
+  time = receive_corrupt_packet(dmx_num, time + 1000000, 25, 10);
+  dmx_sim_receive_packet(dmx_num, time + 1000000, rdm, sizeof(rdm),
+                         DMX_BREAK_LEN_US, DMX_MAB_LEN_US);
+
+  // Receive the packets, and then time out
+  for (int i = 0; i < 5; ++i) {
+    printf("%lld receive %i\n", (long long)(dmx_sim_get_time() / 1000),
+           RECEIVE_TIMEOUT_MS);
+    dmx_packet_t packet;
+    const size_t size =
+        dmx_receive(dmx_num, &packet, pdMS_TO_TICKS(RECEIVE_TIMEOUT_MS));
+    printf("expect receive %s %zu %s%02x\n", esp_err_to_name(packet.err), size,
+           packet.sc < 0 ? "-" : "", packet.sc < 0 ? -packet.sc : packet.sc);
+  }
+
+  // Send a packet
+  printf("%lld send %i\n", (long long)(dmx_sim_get_time() / 1000),
+         DMX_PACKET_SIZE);
+  printf("expect send %zu\n", dmx_send(dmx_num, DMX_PACKET_SIZE));
+  dmx_wait_sent(dmx_num, DMX_TIMEOUT_TICK);
+
+  dmx_set_isr_capture_cb(dmx_num, NULL, NULL);
+  dmx_driver_delete(dmx_num);
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
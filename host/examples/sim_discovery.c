@@ -0,0 +1,149 @@
+/*
+
+  Host RDM Discovery Benchmark
+
+  Runs RDM discovery on Linux against a simulated line with 1, 10, 100, and
+  1000 virtual RDM responders. DMX port 1 is the RDM controller. For each
+  line, the number of devices that were found, the number of requests that
+  were needed, and the virtual and real time of the discovery are printed.
+  Exits with a non-zero status if a device was not found.
+
+  Usage: sim_discovery [seed] [max turnaround in us] [noise in ppm]
+
+  The seed selects the UIDs of the responders and their response times. When
+  the maximum turnaround is longer than 176us, DISC_UNIQUE_BRANCH responses
+  are no longer aligned. Noise corrupts random slots on the line, so devices
+  may be missed when noise is injected.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_bus.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+
+#define MAX_DEVICES 1000
+
+static const char *TAG = "main";
+
+static const size_t device_counts[] = {1, 10, 100, MAX_DEVICES};
+
+static dmx_sim_bus_config_t bus_config = DMX_SIM_BUS_CONFIG_DEFAULT;
+static int num_errors = 0;
+
+typedef struct discovery_t {
+  size_t num_found;
+  rdm_uid_t uids[MAX_DEVICES];
+} discovery_t;
+
+static void on_device_found(dmx_port_t dmx_num, rdm_uid_t uid,
+                            size_t device_num, rdm_disc_mute_t *mute_params,
+                            void *context) {
+  discovery_t *const discovery = context;
+  if (discovery->num_found < MAX_DEVICES) {
+    discovery->uids[discovery->num_found] = uid;
+  }
+  ++discovery->num_found;
+}
+
+static int compare_uids(const void *a, const void *b) {
+  const rdm_uid_t uid_a = *(const rdm_uid_t *)a;
+  const rdm_uid_t uid_b = *(const rdm_uid_t *)b;
+  return uid_a < uid_b ? -1 : uid_a > uid_b;
+}
+
+static double get_wall_time(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void app_main(void *arg) {
+  const dmx_port_t dmx_num = DMX_NUM_1;
+  ESP_ERROR_CHECK(dmx_driver_install(dmx_num, DMX_DEFAULT_INTR_FLAGS));
+
+  static discovery_t discovery;
+  static rdm_uid_t expected[MAX_DEVICES];
+
+  printf("%8s %8s %10s %10s %10s %12s %10s %10s\n", "devices", "found",
+         "requests", "dub", "collisions", "virtual_ms", "wall_ms", "speedup");
+  for (size_t i = 0; i < sizeof(device_counts) / sizeof(device_counts[0]);
+       ++i) {
+    const size_t num_devices = device_counts[i];
+
+    // Create a line with a new set of responders
+    dmx_sim_bus_t *const bus = dmx_sim_bus_create(&bus_config);
+    if (bus == NULL) {
+      ESP_LOGE(TAG, "failed to create the line");
+      ++num_errors;
+      break;
+    }
+    ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, dmx_num));
+    dmx_sim_bus_add_random_responders(bus, 0x05e0, num_devices);
+    dmx_sim_bus_get_responders(bus, expected, MAX_DEVICES);
+
+    // Discover the responders
+    memset(&discovery, 0, sizeof(discovery));
+    const int64_t virtual_start = dmx_sim_get_time();
+    const double wall_start = get_wall_time();
+    rdm_discover_with_callback(dmx_num, on_device_found, &discovery);
+    const double wall_time = get_wall_time() - wall_start;
+    const double virtual_time = (dmx_sim_get_time() - virtual_start) / 1e9;
+
+    dmx_sim_bus_stats_t stats;
+    dmx_sim_bus_get_stats(bus, &stats);
+    printf("%8zu %8zu %10llu %10llu %10llu %12.1f %10.1f %10.1f\n",
+           num_devices, discovery.num_found,
+           (unsigned long long)stats.requests,
+           (unsigned long long)stats.disc_unique_branch,
+           (unsigned long long)stats.collisions, virtual_time * 1e3,
+           wall_time * 1e3, virtual_time / wall_time);
+
+    // Verify that each responder was found exactly once
+    qsort(discovery.uids, discovery.num_found, sizeof(rdm_uid_t),
+          compare_uids);
+    if (discovery.num_found != num_devices ||
+        memcmp(discovery.uids, expected, num_devices * sizeof(rdm_uid_t))) {
+      ESP_LOGE(TAG, "found %zu of %zu devices", discovery.num_found,
+               num_devices);
+      ++num_errors;
+    }
+
+    // Let the line become idle before deleting it
+    vTaskDelay(pdMS_TO_TICKS(10));
+    dmx_sim_bus_delete(bus);
+  }
+
+  dmx_driver_delete(dmx_num);
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1) {
+    bus_config.seed = strtoull(argv[1], NULL, 0);
+  }
+  if (argc > 2) {
+    bus_config.turnaround_max_us = strtoul(argv[2], NULL, 0);
+    if (bus_config.turnaround_max_us < bus_config.turnaround_min_us) {
+      bus_config.turnaround_min_us = bus_config.turnaround_max_us;
+    }
+  }
+  if (argc > 3) {
+    bus_config.noise_ppm = strtoul(argv[3], NULL, 0);
+  }
+
+  const bool finished = dmx_sim_run(app_main, NULL);
+
+  // Devices may be missed on a noisy line
+  const bool is_noisy = bus_config.noise_ppm > 0;
+  return finished && (num_errors == 0 || is_noisy) ? 0 : 1;
+}
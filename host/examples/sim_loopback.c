@@ -0,0 +1,83 @@
+/*
+
+  Host DMX Loopback
+
+  Runs the DMX driver on Linux against simulated UARTs. DMX port 1 sends DMX
+  packets to DMX port 2 over a simulated line and port 2 verifies that each
+  packet is received intact. The virtual time of the simulation and the
+  number of interrupts are logged, along with how much faster than real time
+  the simulation ran. Exits with a non-zero status if a packet was lost or
+  corrupted.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "dmx_sim.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+
+#define NUM_PACKETS 1000
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+
+static void app_main(void *arg) {
+  const dmx_port_t tx_num = DMX_NUM_1;
+  const dmx_port_t rx_num = DMX_NUM_2;
+  ESP_ERROR_CHECK(dmx_driver_install(tx_num, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_driver_install(rx_num, DMX_DEFAULT_INTR_FLAGS));
+  dmx_sim_connect(tx_num, rx_num);
+
+  uint8_t data[DMX_MAX_PACKET_SIZE] = {0};
+  uint8_t received[DMX_MAX_PACKET_SIZE];
+  for (int i = 0; i < NUM_PACKETS; ++i) {
+    // Send a packet which is different each time
+    for (int slot = 1; slot < DMX_MAX_PACKET_SIZE; ++slot) {
+      data[slot] = i + slot;
+    }
+    dmx_write(tx_num, data, DMX_MAX_PACKET_SIZE);
+    dmx_send(tx_num, 0);
+
+    // Wait for the packet to arrive on the other port
+    dmx_packet_t packet;
+    const size_t size = dmx_receive(rx_num, &packet, DMX_TIMEOUT_TICK);
+    dmx_read(rx_num, received, size);
+    if (packet.err || size != DMX_MAX_PACKET_SIZE ||
+        memcmp(data, received, size) != 0) {
+      ESP_LOGE(TAG, "packet %i was not received intact", i);
+      ++num_errors;
+    }
+  }
+
+  dmx_driver_delete(tx_num);
+  dmx_driver_delete(rx_num);
+}
+
+int main(void) {
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  const bool finished = dmx_sim_run(app_main, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  dmx_sim_stats_t stats;
+  dmx_sim_get_stats(&stats);
+  const double wall_time = (end.tv_sec - start.tv_sec) +
+                           (end.tv_nsec - start.tv_nsec) / 1e9;
+  const double virtual_time = dmx_sim_get_time() / 1e9;
+  printf("%i packets in %.3f s of virtual time (%.1fx real time)\n",
+         NUM_PACKETS, virtual_time, virtual_time / wall_time);
+  printf("%llu UART interrupts, %llu timer interrupts, %llu slots sent\n",
+         (unsigned long long)stats.uart_isr_calls,
+         (unsigned long long)stats.timer_isr_calls,
+         (unsigned long long)stats.slots_sent);
+
+  return finished && num_errors == 0 ? 0 : 1;
+}
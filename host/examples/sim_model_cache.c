@@ -0,0 +1,194 @@
+/*
+
+  Host RDM Device Model Cache
+
+  Sends GET requests through the RDM device model cache of DMX port 0 to
+  virtual RDM responders of DMX port 1 on a simulated line. Three of the
+  responders are the same model and one is another model. Once the first
+  device of a model has answered a model-static request, the other devices of
+  that model must only be asked for their DEVICE_INFO, while requests for
+  parameters of each device must always be sent. The cache is then saved,
+  cleared, and loaded again, and must still answer for the models it knew.
+
+  Exits with a non-zero status if a request was answered with the wrong
+  parameter data, or if a different number of requests reached the responders
+  than expected.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_bus.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+#include "esp_rdm_client.h"
+#include "esp_rdm_model_cache.h"
+#include "esp_rdm_virtual.h"
+
+#define NUM_DEVICES 4
+#define DEVICE_UID 0x05e000000101
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+
+static const rdm_client_personality_t personalities[] = {{4, "Dimmer"},
+                                                         {8, "Dimmer 16-bit"}};
+
+static const rdm_virtual_config_t model_a = {
+    .model_id = 0x0100,
+    .software_version_id = 1,
+    .start_address = 1,
+    .personalities = personalities,
+    .personality_count = 2,
+    .model_description = "Model A",
+    .software_version_label = "1.0"};
+
+static const rdm_virtual_config_t model_b = {
+    .model_id = 0x0200,
+    .software_version_id = 1,
+    .start_address = 1,
+    .personalities = personalities,
+    .personality_count = 1,
+    .model_description = "Model B",
+    .software_version_label = "1.0"};
+
+// Returns the number of requests which the responders of port 1 have handled.
+static uint32_t num_handled(void) {
+  vTaskDelay(pdMS_TO_TICKS(1));
+  rdm_responder_stats_t stats;
+  rdm_client_get_responder_stats(DMX_NUM_1, &stats);
+  return stats.num_handled;
+}
+
+// Sends a GET request through the model cache and checks the parameter data
+// of the response and the number of requests which reached the responders.
+static void get(int device, rdm_pid_t pid, uint8_t param, const char *expected,
+                uint32_t num_requests) {
+  const rdm_uid_t uid = DEVICE_UID + device;
+  const uint32_t num_before = num_handled();
+  rdm_response_t response;
+  char pd[33];
+  const size_t pdl =
+      rdm_get_cached(DMX_NUM_0, uid, RDM_ROOT_DEVICE, pid, &param,
+                     param > 0 ? 1 : 0, &response, pd, sizeof(pd) - 1);
+  const uint32_t num_sent = num_handled() - num_before;
+
+  // Personality descriptions start with the personality and its footprint
+  const size_t offset = pid == RDM_PID_DMX_PERSONALITY_DESCRIPTION ? 3 : 0;
+  pd[pdl < sizeof(pd) - 1 ? pdl : sizeof(pd) - 1] = '\0';
+  printf(UIDSTR " PID 0x%04x: '%s' with %u requests\n", UID2STR(uid), pid,
+         pdl > offset ? &pd[offset] : "", (unsigned)num_sent);
+  if (response.type != RDM_RESPONSE_TYPE_ACK ||
+      pdl != offset + strlen(expected) ||
+      strcmp(&pd[offset], expected) != 0 || num_sent != num_requests) {
+    ESP_LOGE(TAG, "unexpected response from " UIDSTR " for PID 0x%04x",
+             UID2STR(uid), pid);
+    ++num_errors;
+  }
+}
+
+static void app_main(void *arg) {
+  const dmx_port_t controller_num = DMX_NUM_0;
+  const dmx_port_t responder_num = DMX_NUM_1;
+  dmx_sim_bus_t *const bus = dmx_sim_bus_create(NULL);
+  if (bus == NULL) {
+    ESP_LOGE(TAG, "failed to create the line");
+    ++num_errors;
+    return;
+  }
+  ESP_ERROR_CHECK(dmx_driver_install(controller_num, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_driver_install(responder_num, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, controller_num));
+  ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, responder_num));
+
+  // Devices 0 to 2 are model A and device 3 is model B
+  rdm_client_init(responder_num, 1, 4, "responder", "Default");
+  ESP_ERROR_CHECK(rdm_virtual_install(responder_num, NUM_DEVICES));
+  for (int i = 0; i < NUM_DEVICES; ++i) {
+    rdm_virtual_config_t config = i < 3 ? model_a : model_b;
+    static const char *const labels[NUM_DEVICES] = {"A0", "A1", "A2", "B0"};
+    config.device_label = labels[i];
+    ESP_ERROR_CHECK(rdm_virtual_add(responder_num, DEVICE_UID + i, &config));
+  }
+  rdm_client_responder_start(responder_num, NULL);
+
+  const rdm_model_cache_config_t config = RDM_MODEL_CACHE_DEFAULT_CONFIG;
+  ESP_ERROR_CHECK(rdm_model_cache_install(controller_num, &config));
+
+  // The first device of a model answers the request, the others only their
+  // DEVICE_INFO, and then not even that
+  get(0, RDM_PID_DEVICE_MODEL_DESCRIPTION, 0, "Model A", 2);
+  get(1, RDM_PID_DEVICE_MODEL_DESCRIPTION, 0, "Model A", 1);
+  get(1, RDM_PID_DEVICE_MODEL_DESCRIPTION, 0, "Model A", 0);
+  get(3, RDM_PID_DEVICE_MODEL_DESCRIPTION, 0, "Model B", 2);
+
+  // Responses are cached for each parameter of the request
+  get(0, RDM_PID_DMX_PERSONALITY_DESCRIPTION, 1, "Dimmer", 1);
+  get(0, RDM_PID_DMX_PERSONALITY_DESCRIPTION, 2, "Dimmer 16-bit", 1);
+  get(1, RDM_PID_DMX_PERSONALITY_DESCRIPTION, 2, "Dimmer 16-bit", 0);
+
+  // Parameters of each device are never cached
+  get(1, RDM_PID_DEVICE_LABEL, 0, "A1", 1);
+  get(2, RDM_PID_DEVICE_LABEL, 0, "A2", 1);
+  get(2, RDM_PID_DEVICE_LABEL, 0, "A2", 1);
+
+  // A loaded cache answers for the models it knew, but the devices must be
+  // asked for their DEVICE_INFO again
+  const size_t blob_size = rdm_model_cache_save(controller_num, NULL, 0);
+  uint8_t *blob = malloc(blob_size);
+  if (blob == NULL ||
+      rdm_model_cache_save(controller_num, blob, blob_size) != blob_size) {
+    ESP_LOGE(TAG, "the cache was not saved");
+    ++num_errors;
+  } else {
+    rdm_model_cache_clear(controller_num);
+    ESP_ERROR_CHECK(rdm_model_cache_load(controller_num, blob, blob_size));
+    get(2, RDM_PID_DEVICE_MODEL_DESCRIPTION, 0, "Model A", 1);
+    get(3, RDM_PID_DEVICE_MODEL_DESCRIPTION, 0, "Model B", 1);
+    get(3, RDM_PID_DMX_PERSONALITY_DESCRIPTION, 1, "Dimmer", 1);
+
+    rdm_model_key_t key;
+    if (!rdm_model_cache_get_key(controller_num, DEVICE_UID, &key) ||
+        key.manufacturer_id != (DEVICE_UID >> 32) ||
+        key.model_id != model_a.model_id ||
+        key.software_version_id != model_a.software_version_id) {
+      ESP_LOGE(TAG, "the model of " UIDSTR " is wrong", UID2STR(DEVICE_UID));
+      ++num_errors;
+    }
+
+    // A blob which was not saved by the model cache is refused
+    const esp_err_t truncated_err =
+        rdm_model_cache_load(controller_num, blob, blob_size - 1);
+    blob[0] ^= 0xff;
+    if (truncated_err != ESP_ERR_INVALID_VERSION ||
+        rdm_model_cache_load(controller_num, blob, blob_size) !=
+            ESP_ERR_INVALID_VERSION) {
+      ESP_LOGE(TAG, "an invalid blob was loaded");
+      ++num_errors;
+    }
+    get(1, RDM_PID_DEVICE_MODEL_DESCRIPTION, 0, "Model A", 1);
+  }
+  free(blob);
+
+  rdm_model_cache_delete(controller_num);
+  rdm_client_responder_stop(responder_num);
+  rdm_virtual_delete(responder_num);
+  rdm_client_deinit(responder_num);
+  dmx_sim_bus_delete(bus);
+  dmx_driver_delete(responder_num);
+  dmx_driver_delete(controller_num);
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+/*
+
+  Host DMX Packet Capture
+
+  Runs the DMX driver on Linux against a simulated line with one virtual RDM
+  responder and captures every frame on all three DMX ports. Port 0 sends DMX
+  packets back to back at the full DMX rate, then sends a DISC_UNIQUE_BRANCH
+  request and a DISC_MUTE request to the responder. Ports 1 and 2 only listen.
+  The capture stream of port 1 is written to stdout, so that it can be
+  converted to CSV or pcap:
+
+    ./build-host/sim_packet_capture | ./build-host/dmx_capture_convert
+
+  The streams of the other ports are kept in memory and read back with the
+  capture reader. Exits with a non-zero status if a port did not capture every
+  frame on the line.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_capture_reader.h"
+#include "dmx_sim.h"
+#include "dmx_sim_bus.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+
+#define NUM_PACKETS 200
+#define RESPONDER_UID 0x05e000000001
+
+// The DMX packets, the two RDM requests, and their two responses
+#define NUM_FRAMES (NUM_PACKETS + 4)
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+
+// A capture stream which is kept in memory.
+typedef struct stream_t {
+  uint8_t *data;
+  size_t size;
+} stream_t;
+
+static size_t write_stdout(const void *data, size_t size, void *context) {
+  return fwrite(data, 1, size, stdout);
+}
+
+static size_t write_memory(const void *data, size_t size, void *context) {
+  stream_t *const stream = context;
+  uint8_t *const grown = realloc(stream->data, stream->size + size);
+  if (grown == NULL) {
+    return 0;
+  }
+  memcpy(grown + stream->size, data, size);
+  stream->data = grown;
+  stream->size += size;
+  return size;
+}
+
+// Reads a capture stream back and checks that it holds every frame.
+static void check_stream(dmx_port_t dmx_num, const stream_t *stream) {
+  FILE *const file = fmemopen(stream->data, stream->size, "rb");
+  dmx_capture_reader_t reader;
+  dmx_capture_frame_t frame;
+  size_t num_sent = 0;
+  size_t num_no_break = 0;
+  if (file == NULL || dmx_capture_reader_open(&reader, file) != 0) {
+    ESP_LOGE(TAG, "port %u: the stream has no header", dmx_num);
+    ++num_errors;
+    return;
+  }
+  int result;
+  while ((result = dmx_capture_reader_next(&reader, &frame)) > 0) {
+    num_sent += (frame.header.flags & DMX_CAPTURE_FLAG_SENT) != 0;
+    num_no_break += (frame.header.flags & DMX_CAPTURE_FLAG_NO_BREAK) != 0;
+  }
+  fclose(file);
+
+  ESP_LOGI(TAG, "port %u: %llu frames, %zu sent, %zu without a break",
+           dmx_num, (unsigned long long)reader.num_frames, num_sent,
+           num_no_break);
+  if (result < 0 || reader.num_frames != NUM_FRAMES ||
+      reader.num_dropped > 0 || dmx_capture_get_num_dropped(dmx_num) > 0) {
+    ESP_LOGE(TAG, "port %u: not every frame was captured", dmx_num);
+    ++num_errors;
+  }
+}
+
+static void app_main(void *arg) {
+  dmx_sim_bus_t *const bus = dmx_sim_bus_create(NULL);
+  if (bus == NULL) {
+    ESP_LOGE(TAG, "failed to create the line");
+    ++num_errors;
+    return;
+  }
+  ESP_ERROR_CHECK(dmx_sim_bus_add_responder(bus, RESPONDER_UID));
+
+  stream_t streams[DMX_NUM_MAX] = {0};
+  for (dmx_port_t dmx_num = 0; dmx_num < DMX_NUM_MAX; ++dmx_num) {
+    ESP_ERROR_CHECK(dmx_driver_install(dmx_num, DMX_DEFAULT_INTR_FLAGS));
+    ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, dmx_num));
+    const dmx_capture_config_t config =
+        dmx_num == DMX_NUM_1
+            ? (dmx_capture_config_t)DMX_CAPTURE_DEFAULT_CONFIG(write_stdout,
+                                                               NULL)
+            : (dmx_capture_config_t)DMX_CAPTURE_DEFAULT_CONFIG(
+                  write_memory, &streams[dmx_num]);
+    ESP_ERROR_CHECK(dmx_capture_start(dmx_num, &config));
+  }
+
+  // Send DMX packets back to back
+  uint8_t data[DMX_PACKET_SIZE] = {0};
+  for (int i = 0; i < NUM_PACKETS; ++i) {
+    for (int slot = 1; slot < DMX_PACKET_SIZE; ++slot) {
+      data[slot] = i + slot;
+    }
+    dmx_write(DMX_NUM_0, data, DMX_PACKET_SIZE);
+    dmx_send(DMX_NUM_0, 0);
+    dmx_wait_sent(DMX_NUM_0, DMX_TIMEOUT_TICK);
+  }
+
+  // Find and mute the responder
+  rdm_response_t response;
+  rdm_disc_unique_branch_t branch = {.lower_bound = 0,
+                                     .upper_bound = RDM_MAX_UID};
+  rdm_disc_mute_t mute;
+  if (rdm_send_disc_unique_branch(DMX_NUM_0, &branch, &response) !=
+          RESPONDER_UID ||
+      !rdm_send_disc_mute(DMX_NUM_0, RESPONDER_UID, true, &response, &mute)) {
+    ESP_LOGE(TAG, "the responder did not respond");
+    ++num_errors;
+  }
+
+  // Let the line become idle before stopping the captures
+  vTaskDelay(pdMS_TO_TICKS(10));
+  for (dmx_port_t dmx_num = 0; dmx_num < DMX_NUM_MAX; ++dmx_num) {
+    dmx_capture_stop(dmx_num);
+    if (dmx_num != DMX_NUM_1) {
+      check_stream(dmx_num, &streams[dmx_num]);
+      free(streams[dmx_num].data);
+    } else if (dmx_capture_get_num_dropped(dmx_num) > 0) {
+      ESP_LOGE(TAG, "port %u: frames were dropped", dmx_num);
+      ++num_errors;
+    }
+  }
+
+  dmx_sim_bus_delete(bus);
+  for (dmx_port_t dmx_num = 0; dmx_num < DMX_NUM_MAX; ++dmx_num) {
+    dmx_driver_delete(dmx_num);
+  }
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+/*
+
+  Host RDM Patch Planner
+
+  Plans the start addresses of fleets of devices with rdm_patch_plan(), which
+  sends no RDM requests, and compares each planned start address and status
+  with the expected layout: fixed addresses are reserved first, then groups
+  and ungrouped devices are packed at the lowest address with enough room.
+
+  Exits with a non-zero status if a layout differs from the expected layout.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+
+#include "dmx_sim.h"
+#include "esp_log.h"
+#include "esp_rdm_patch.h"
+
+#define MAX_DEVICES 8
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+
+// A device of a test case and its expected plan.
+typedef struct device_case_t {
+  int fixed_address;
+  uint16_t group;
+  size_t footprint;
+  rdm_patch_status_t status;  // The status before planning.
+  int expected_address;       // The expected start address, or -1.
+  rdm_patch_status_t expected_status;
+} device_case_t;
+
+typedef struct plan_case_t {
+  const char *name;
+  int first_address;
+  int last_address;
+  size_t num_planned;  // The expected return value of rdm_patch_plan().
+  size_t num_devices;
+  device_case_t devices[MAX_DEVICES];
+} plan_case_t;
+
+static const plan_case_t cases[] = {
+    {"packed in order", 1, 512, 3, 3,
+     {{0, 0, 10, RDM_PATCH_PENDING, 1, RDM_PATCH_PENDING},
+      {0, 0, 5, RDM_PATCH_PENDING, 11, RDM_PATCH_PENDING},
+      {0, 0, 20, RDM_PATCH_PENDING, 16, RDM_PATCH_PENDING}}},
+    {"fixed address first", 1, 512, 2, 2,
+     {{0, 0, 10, RDM_PATCH_PENDING, 5, RDM_PATCH_PENDING},
+      {1, 0, 4, RDM_PATCH_PENDING, 1, RDM_PATCH_PENDING}}},
+    {"gap before a fixed address", 1, 512, 3, 3,
+     {{10, 0, 5, RDM_PATCH_PENDING, 10, RDM_PATCH_PENDING},
+      {0, 0, 9, RDM_PATCH_PENDING, 1, RDM_PATCH_PENDING},
+      {0, 0, 3, RDM_PATCH_PENDING, 15, RDM_PATCH_PENDING}}},
+    {"fixed address conflict", 1, 512, 1, 2,
+     {{100, 0, 8, RDM_PATCH_PENDING, 100, RDM_PATCH_PENDING},
+      {104, 0, 8, RDM_PATCH_PENDING, -1, RDM_PATCH_CONFLICT}}},
+    {"fixed address out of range", 10, 100, 0, 2,
+     {{5, 0, 4, RDM_PATCH_PENDING, -1, RDM_PATCH_NO_SPACE},
+      {98, 0, 4, RDM_PATCH_PENDING, -1, RDM_PATCH_NO_SPACE}}},
+    {"group is contiguous", 1, 512, 4, 4,
+     {{0, 1, 3, RDM_PATCH_PENDING, 1, RDM_PATCH_PENDING},
+      {0, 0, 2, RDM_PATCH_PENDING, 7, RDM_PATCH_PENDING},
+      {0, 1, 3, RDM_PATCH_PENDING, 4, RDM_PATCH_PENDING},
+      {0, 2, 1, RDM_PATCH_PENDING, 9, RDM_PATCH_PENDING}}},
+    {"group skips a fixed member", 1, 512, 3, 3,
+     {{0, 1, 4, RDM_PATCH_PENDING, 11, RDM_PATCH_PENDING},
+      {1, 1, 10, RDM_PATCH_PENDING, 1, RDM_PATCH_PENDING},
+      {0, 1, 4, RDM_PATCH_PENDING, 15, RDM_PATCH_PENDING}}},
+    {"universe is full", 1, 20, 2, 3,
+     {{0, 0, 15, RDM_PATCH_PENDING, 1, RDM_PATCH_PENDING},
+      {0, 0, 10, RDM_PATCH_PENDING, -1, RDM_PATCH_NO_SPACE},
+      {0, 0, 5, RDM_PATCH_PENDING, 16, RDM_PATCH_PENDING}}},
+    {"group does not fit", 1, 20, 1, 3,
+     {{0, 1, 8, RDM_PATCH_PENDING, -1, RDM_PATCH_NO_SPACE},
+      {0, 1, 16, RDM_PATCH_PENDING, -1, RDM_PATCH_NO_SPACE},
+      {0, 0, 20, RDM_PATCH_PENDING, 1, RDM_PATCH_PENDING}}},
+    {"failed devices are skipped", 1, 512, 1, 3,
+     {{0, 0, 10, RDM_PATCH_NO_RESPONSE, 0, RDM_PATCH_NO_RESPONSE},
+      {0, 0, 0, RDM_PATCH_NO_FOOTPRINT, 0, RDM_PATCH_NO_FOOTPRINT},
+      {0, 0, 10, RDM_PATCH_PENDING, 1, RDM_PATCH_PENDING}}},
+};
+
+static void check(const plan_case_t *plan_case) {
+  const rdm_patch_config_t config = {.first_address = plan_case->first_address,
+                                     .last_address = plan_case->last_address,
+                                     .attempts = 1,
+                                     .verify = false};
+  rdm_patch_device_t devices[MAX_DEVICES] = {0};
+  for (size_t i = 0; i < plan_case->num_devices; ++i) {
+    const device_case_t *d = &plan_case->devices[i];
+    devices[i].uid = 0x05e000000001 + i;
+    devices[i].fixed_address = d->fixed_address;
+    devices[i].group = d->group;
+    devices[i].footprint = d->footprint;
+    devices[i].status = d->status;
+  }
+
+  const size_t num_planned =
+      rdm_patch_plan(devices, plan_case->num_devices, &config);
+  bool matched = num_planned == plan_case->num_planned;
+  printf("%s:", plan_case->name);
+  for (size_t i = 0; i < plan_case->num_devices; ++i) {
+    const device_case_t *d = &plan_case->devices[i];
+    printf(" %i/%i", devices[i].start_address, devices[i].status);
+    matched = matched && devices[i].start_address == d->expected_address &&
+              devices[i].status == d->expected_status;
+  }
+  printf("\n");
+  if (!matched) {
+    ESP_LOGE(TAG, "unexpected plan for '%s'", plan_case->name);
+    ++num_errors;
+  }
+}
+
+static void app_main(void *arg) {
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+    check(&cases[i]);
+  }
+
+  // An invalid configuration plans nothing
+  rdm_patch_device_t device = {.uid = 0x05e000000001, .footprint = 1};
+  const rdm_patch_config_t invalid = {.first_address = 0, .last_address = 512};
+  if (rdm_patch_plan(&device, 1, &invalid) != 0) {
+    ESP_LOGE(TAG, "a device was planned with an invalid configuration");
+    ++num_errors;
+  }
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
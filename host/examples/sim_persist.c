@@ -0,0 +1,157 @@
+/*
+
+  Host RDM Parameter Persistence
+
+  Changes the parameters of an RDM client the way SET requests would and
+  checks when they reach NVS. A sweep of changes within the commit window must
+  be written once, when the window ends, a change which is reverted must not
+  be written at all, and a flush must write pending changes immediately. The
+  stored parameters must be applied again when persistence is installed after
+  a restart.
+
+  Exits with a non-zero status if a record was written early, late, or with the
+  wrong parameters, or if the stored parameters were not applied.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+#include <string.h>
+
+#include "dmx_sim.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm_client.h"
+#include "esp_rdm_persist.h"
+#include "nvs.h"
+
+static const char *TAG = "main";
+
+static const char *nvs_namespace = "sim_persist";
+static const char *nvs_key = "rdm_port0";  // The key of the record of port 0.
+
+static int num_errors = 0;
+
+// Reads the start address and the device label of the stored record, and
+// returns false if there is no record.
+static bool read_record(uint16_t *start_address, char *device_label) {
+  nvs_handle_t nvs;
+  ESP_ERROR_CHECK(nvs_open(nvs_namespace, NVS_READONLY, &nvs));
+  uint8_t record[64];
+  size_t size = sizeof(record);
+  const esp_err_t err = nvs_get_blob(nvs, nvs_key, record, &size);
+  nvs_close(nvs);
+  if (err != ESP_OK) {
+    return false;
+  }
+
+  // The record is packed: version, fields, start address, personality, and
+  // the length and characters of the device label
+  memcpy(start_address, &record[2], sizeof(*start_address));
+  const size_t label_len = record[5];
+  memcpy(device_label, &record[6], label_len);
+  device_label[label_len] = '\0';
+  return true;
+}
+
+// Checks that the stored record has a start address and a device label, or
+// that there is no record if device_label is NULL.
+static void check(const char *when, uint16_t start_address,
+                  const char *device_label) {
+  uint16_t stored_address;
+  char stored_label[33];
+  const bool is_stored = read_record(&stored_address, stored_label);
+  if (is_stored) {
+    printf("%s: start address %u, device label '%s'\n", when, stored_address,
+           stored_label);
+  } else {
+    printf("%s: nothing stored\n", when);
+  }
+
+  if (device_label == NULL ? is_stored
+                           : !is_stored || stored_address != start_address ||
+                                 strcmp(stored_label, device_label) != 0) {
+    ESP_LOGE(TAG, "unexpected record %s", when);
+    ++num_errors;
+  }
+}
+
+// Sets the device label the way a SET DEVICE_LABEL request does.
+static void set_device_label(dmx_port_t dmx_num, const char *device_label) {
+  rdm_parameters_t *params = &rdm_parameters[dmx_num];
+  memset(params->device_label, 0, sizeof(params->device_label));
+  params->device_label_len = strlen(device_label);
+  memcpy(params->device_label, device_label, params->device_label_len);
+  rdm_persist_mark_dirty(dmx_num, RDM_PERSIST_DEVICE_LABEL);
+}
+
+static void app_main(void *arg) {
+  const dmx_port_t dmx_num = DMX_NUM_0;
+  rdm_persist_config_t config = RDM_PERSIST_DEFAULT_CONFIG;
+  config.nvs_namespace = nvs_namespace;
+  config.commit_delay_ms = 100;
+
+  ESP_ERROR_CHECK(dmx_driver_install(dmx_num, DMX_DEFAULT_INTR_FLAGS));
+  rdm_client_init(dmx_num, 1, 4, "sim_persist", "Default");
+  ESP_ERROR_CHECK(rdm_persist_install(dmx_num, &config));
+  check("after install", 0, NULL);
+
+  // A sweep of the start address is written once, when the commit window of
+  // its first change ends
+  for (int i = 0; i < 8; ++i) {
+    rdm_client_set_start_address(dmx_num, 10 + i * 10);
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+  check("during the sweep", 0, NULL);
+  vTaskDelay(pdMS_TO_TICKS(50));
+  check("after the sweep", 80, "sim_persist");
+
+  // A change which is reverted within the commit window is not written
+  nvs_handle_t nvs;
+  ESP_ERROR_CHECK(nvs_open(nvs_namespace, NVS_READWRITE, &nvs));
+  ESP_ERROR_CHECK(nvs_erase_key(nvs, nvs_key));
+  nvs_close(nvs);
+  set_device_label(dmx_num, "changed");
+  set_device_label(dmx_num, "sim_persist");
+  vTaskDelay(pdMS_TO_TICKS(200));
+  check("after a reverted change", 0, NULL);
+
+  // A flush writes pending changes before the commit window ends
+  set_device_label(dmx_num, "flushed");
+  ESP_ERROR_CHECK(rdm_persist_flush(dmx_num));
+  check("after a flush", 80, "flushed");
+
+  // Deleting writes pending changes too
+  rdm_client_set_start_address(dmx_num, 100);
+  ESP_ERROR_CHECK(rdm_persist_delete(dmx_num));
+  check("after delete", 100, "flushed");
+
+  // The stored parameters are applied when persistence is installed again
+  rdm_client_set_start_address(dmx_num, 1);
+  set_device_label(dmx_num, "sim_persist");
+  ESP_ERROR_CHECK(rdm_persist_install(dmx_num, &config));
+  const rdm_parameters_t *params = &rdm_parameters[dmx_num];
+  printf("after restart: start address %u, device label '%.*s'\n",
+         params->device_info.start_address, (int)params->device_label_len,
+         params->device_label);
+  if (params->device_info.start_address != 100 ||
+      params->device_label_len != strlen("flushed") ||
+      memcmp(params->device_label, "flushed", params->device_label_len) != 0) {
+    ESP_LOGE(TAG, "the stored parameters were not applied");
+    ++num_errors;
+  }
+  vTaskDelay(pdMS_TO_TICKS(200));
+  check("after restart", 100, "flushed");
+
+  ESP_ERROR_CHECK(rdm_persist_delete(dmx_num));
+  rdm_client_deinit(dmx_num);
+  dmx_driver_delete(dmx_num);
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
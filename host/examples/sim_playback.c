@@ -0,0 +1,239 @@
+/*
+
+  Host DMX Playback
+
+  Runs the DMX driver on Linux against a simulated line with one virtual RDM
+  responder. DMX port 0 sends DMX packets of different sizes, DMX breaks, and
+  mark-after-breaks with irregular gaps between them, and a DISC_MUTE request
+  to the responder, while its frames are captured into memory with
+  dmx_capture_start(). Then the capture is played back on the same port with
+  dmx_playback_start() while it is captured again, and the two captures are
+  compared. The response of the responder is in the first capture, but it is
+  not played back, because the responder answers the replayed request itself.
+
+  Exits with a non-zero status if a sent frame was not played back with the
+  same slots, DMX break, and mark-after-break, if the gap before it differs
+  from the capture by more than a few microseconds, or if a frame other than
+  the response was skipped.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_capture_reader.h"
+#include "dmx_sim.h"
+#include "dmx_sim_bus.h"
+#include "esp_dmx.h"
+#include "esp_dmx_playback.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+
+#define NUM_PACKETS 30
+#define MAX_FRAMES (NUM_PACKETS + 2)
+#define RESPONDER_UID 0x05e000000001
+#define MAX_GAP_ERROR_US 5
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+
+// A capture stream which is kept in memory.
+typedef struct stream_t {
+  uint8_t *data;
+  size_t size;
+} stream_t;
+
+static size_t write_memory(const void *data, size_t size, void *context) {
+  stream_t *const stream = context;
+  uint8_t *const grown = realloc(stream->data, stream->size + size);
+  if (grown == NULL) {
+    return 0;
+  }
+  memcpy(grown + stream->size, data, size);
+  stream->data = grown;
+  stream->size += size;
+  return size;
+}
+
+// Reads the frames which were sent from a capture stream. Returns the number
+// of frames which were read.
+static size_t read_sent_frames(const stream_t *stream,
+                               dmx_capture_frame_t *frames) {
+  FILE *const file = fmemopen(stream->data, stream->size, "rb");
+  dmx_capture_reader_t reader;
+  size_t num_frames = 0;
+  if (file == NULL || dmx_capture_reader_open(&reader, file) != 0) {
+    ESP_LOGE(TAG, "the stream has no header");
+    ++num_errors;
+    return 0;
+  }
+  while (num_frames < MAX_FRAMES &&
+         dmx_capture_reader_next(&reader, &frames[num_frames]) > 0) {
+    if (frames[num_frames].header.flags & DMX_CAPTURE_FLAG_SENT) {
+      ++num_frames;
+    }
+  }
+  fclose(file);
+  return num_frames;
+}
+
+// Returns the number of frames of a capture stream which are RDM responses or
+// discovery responses.
+static size_t count_responses(const stream_t *stream) {
+  FILE *const file = fmemopen(stream->data, stream->size, "rb");
+  dmx_capture_reader_t reader;
+  dmx_capture_frame_t frame;
+  size_t num_responses = 0;
+  if (file == NULL || dmx_capture_reader_open(&reader, file) != 0) {
+    return 0;
+  }
+  while (dmx_capture_reader_next(&reader, &frame) > 0) {
+    if (frame.header.type == DMX_CAPTURE_TYPE_RESPONSE ||
+        frame.header.type == DMX_CAPTURE_TYPE_DISCOVERY_RESPONSE) {
+      ++num_responses;
+    }
+  }
+  fclose(file);
+  return num_responses;
+}
+
+// Starts capturing the frames of port 0 into a stream.
+static void start_capture(stream_t *stream) {
+  const dmx_capture_config_t config =
+      DMX_CAPTURE_DEFAULT_CONFIG(write_memory, stream);
+  ESP_ERROR_CHECK(dmx_capture_start(DMX_NUM_0, &config));
+}
+
+static void record(void) {
+  static const uint32_t break_lens[] = {176, 120, 250, 92};
+  static const uint32_t mab_lens[] = {12, 20, 40, 16};
+  static const size_t sizes[] = {DMX_PACKET_SIZE, 25, 100, 200, 1};
+  uint8_t data[DMX_PACKET_SIZE] = {0};
+  for (int i = 0; i < NUM_PACKETS; ++i) {
+    for (int slot = 1; slot < DMX_PACKET_SIZE; ++slot) {
+      data[slot] = i * 3 + slot;
+    }
+    dmx_set_break_len(DMX_NUM_0, break_lens[i % 4]);
+    dmx_set_mab_len(DMX_NUM_0, mab_lens[i % 4]);
+    dmx_write(DMX_NUM_0, data, DMX_PACKET_SIZE);
+    dmx_send(DMX_NUM_0, sizes[i % 5]);
+    dmx_wait_sent(DMX_NUM_0, DMX_TIMEOUT_TICK);
+    vTaskDelay(i % 3);
+
+    if (i == NUM_PACKETS / 2) {
+      rdm_response_t response;
+      rdm_disc_mute_t mute;
+      if (!rdm_send_disc_mute(DMX_NUM_0, RESPONDER_UID, true, &response,
+                              &mute)) {
+        ESP_LOGE(TAG, "the responder did not respond");
+        ++num_errors;
+      }
+    }
+  }
+}
+
+static void compare(const stream_t *recording, const stream_t *playback) {
+  static dmx_capture_frame_t expected[MAX_FRAMES];
+  static dmx_capture_frame_t actual[MAX_FRAMES];
+  const size_t num_expected = read_sent_frames(recording, expected);
+  const size_t num_actual = read_sent_frames(playback, actual);
+  if (num_expected != NUM_PACKETS + 1 || num_actual != num_expected) {
+    ESP_LOGE(TAG, "%zu frames were recorded and %zu were played back",
+             num_expected, num_actual);
+    ++num_errors;
+    return;
+  }
+
+  int64_t max_gap_error = 0;
+  for (size_t i = 0; i < num_actual; ++i) {
+    const dmx_capture_header_t *const a = &actual[i].header;
+    const dmx_capture_header_t *const e = &expected[i].header;
+    if (actual[i].num_slots != expected[i].num_slots ||
+        memcmp(actual[i].slots, expected[i].slots, actual[i].num_slots) != 0 ||
+        a->break_len != e->break_len || a->mab_len != e->mab_len) {
+      ESP_LOGE(TAG, "frame %zu was not played back as it was recorded", i);
+      ++num_errors;
+    }
+    if (i > 0) {
+      const int64_t gap_error =
+          llabs((a->timestamp - actual[i - 1].header.timestamp) -
+                (e->timestamp - expected[i - 1].header.timestamp));
+      if (gap_error > max_gap_error) {
+        max_gap_error = gap_error;
+      }
+    }
+  }
+  ESP_LOGI(TAG, "%zu frames played back, largest gap error %lld us",
+           num_actual, (long long)max_gap_error);
+  if (max_gap_error > MAX_GAP_ERROR_US) {
+    ESP_LOGE(TAG, "the gaps between frames were not reproduced");
+    ++num_errors;
+  }
+}
+
+static void app_main(void *arg) {
+  dmx_sim_bus_t *const bus = dmx_sim_bus_create(NULL);
+  if (bus == NULL) {
+    ESP_LOGE(TAG, "failed to create the line");
+    ++num_errors;
+    return;
+  }
+  ESP_ERROR_CHECK(dmx_sim_bus_add_responder(bus, RESPONDER_UID));
+  ESP_ERROR_CHECK(dmx_driver_install(DMX_NUM_0, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, DMX_NUM_0));
+
+  // Record the frames on the line
+  stream_t recording = {0};
+  start_capture(&recording);
+  record();
+  vTaskDelay(pdMS_TO_TICKS(10));
+  dmx_capture_stop(DMX_NUM_0);
+
+  // Play the recording back while capturing it again
+  stream_t playback = {0};
+  dmx_playback_memory_t memory = {.data = recording.data,
+                                  .size = recording.size};
+  const dmx_playback_config_t config =
+      DMX_PLAYBACK_DEFAULT_CONFIG(dmx_playback_memory_source, &memory);
+  start_capture(&playback);
+  ESP_ERROR_CHECK(dmx_playback_start(DMX_NUM_0, &config));
+  const esp_err_t err = dmx_playback_wait(DMX_NUM_0, pdMS_TO_TICKS(1000));
+  dmx_playback_stats_t stats;
+  dmx_playback_get_stats(DMX_NUM_0, &stats);
+  dmx_playback_stop(DMX_NUM_0);
+  vTaskDelay(pdMS_TO_TICKS(10));
+  dmx_capture_stop(DMX_NUM_0);
+
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "the playback failed: %s", esp_err_to_name(err));
+    ++num_errors;
+  }
+  ESP_LOGI(TAG, "%u frames sent, %u skipped, latest by %u us",
+           (unsigned)stats.num_sent, (unsigned)stats.num_skipped,
+           (unsigned)stats.max_late_us);
+  compare(&recording, &playback);
+
+  // Only the response to the DISC_MUTE request is skipped
+  const size_t num_responses = count_responses(&recording);
+  if (num_responses != 1 || stats.num_skipped != num_responses) {
+    ESP_LOGE(TAG, "%zu responses were recorded and %u frames were skipped",
+             num_responses, (unsigned)stats.num_skipped);
+    ++num_errors;
+  }
+
+  free(playback.data);
+  free(recording.data);
+  dmx_sim_bus_delete(bus);
+  dmx_driver_delete(DMX_NUM_0);
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
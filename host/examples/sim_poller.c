@@ -0,0 +1,133 @@
+/*
+
+  Host RDM Fleet Poller
+
+  Polls a PID of virtual RDM responders on a simulated line and of a device
+  which is absent with the RDM fleet poller. The responders NACK the requests
+  with RDM_NR_UNKNOWN_PID, and the requests to the absent device are lost, so
+  it must be backed off rather than polled at the rate of the others. The
+  poller is run in a task of its own, and must not be uninstalled while that
+  task is running it.
+
+  Exits with a non-zero status if a result was not recorded, if the absent
+  device was not backed off, or if the poller was uninstalled while in use.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_bus.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+#include "esp_rdm_poller.h"
+#include "freertos/semphr.h"
+
+#define NUM_DEVICES 4
+#define ABSENT_UID 0x05e0ffffff00
+#define POLL_INTERVAL_MS 50
+#define POLL_TIME_MS 1000
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+static size_t num_sent = 0;
+
+// Runs the poller of port 0, then gives the semaphore in arg.
+static void poll_task(void *arg) {
+  num_sent = rdm_poller_run(DMX_NUM_0, pdMS_TO_TICKS(POLL_TIME_MS));
+  xSemaphoreGive((SemaphoreHandle_t)arg);
+  vTaskDelete(NULL);
+}
+
+static void app_main(void *arg) {
+  const dmx_port_t dmx_num = DMX_NUM_0;
+  dmx_sim_bus_t *const bus = dmx_sim_bus_create(NULL);
+  if (bus == NULL) {
+    ESP_LOGE(TAG, "failed to create the line");
+    ++num_errors;
+    return;
+  }
+  static rdm_uid_t uids[NUM_DEVICES + 1];
+  for (int i = 0; i < NUM_DEVICES; ++i) {
+    uids[i] = 0x05e000000001 + i;
+    ESP_ERROR_CHECK(dmx_sim_bus_add_responder(bus, uids[i]));
+  }
+  uids[NUM_DEVICES] = ABSENT_UID;
+  ESP_ERROR_CHECK(dmx_driver_install(dmx_num, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, dmx_num));
+
+  const rdm_poller_config_t config = RDM_POLLER_DEFAULT_CONFIG;
+  ESP_ERROR_CHECK(rdm_poller_install(dmx_num, &config));
+  const int job = rdm_poller_add(dmx_num, uids, NUM_DEVICES + 1,
+                                 RDM_PID_DEVICE_INFO, POLL_INTERVAL_MS, 0);
+  if (job < 0) {
+    ESP_LOGE(TAG, "the job was not added");
+    ++num_errors;
+  }
+
+  // The poller must not be freed while another task is running it
+  SemaphoreHandle_t done = xSemaphoreCreateBinary();
+  xTaskCreatePinnedToCore(poll_task, "poll", 4096, done, 1, NULL,
+                          tskNO_AFFINITY);
+  vTaskDelay(pdMS_TO_TICKS(POLL_TIME_MS / 2));
+  if (rdm_poller_delete(dmx_num) != ESP_ERR_INVALID_STATE) {
+    ESP_LOGE(TAG, "the poller was uninstalled while it was running");
+    ++num_errors;
+  }
+  xSemaphoreTake(done, portMAX_DELAY);
+  vSemaphoreDelete(done);
+
+  // Each present device is polled about once per interval, and the absent
+  // device only a few times because it is backed off after each lost request
+  const size_t max_absent = POLL_TIME_MS * 1000 / config.backoff_base_us + 1;
+  const size_t min_sent =
+      NUM_DEVICES * (POLL_TIME_MS / POLL_INTERVAL_MS - 1);
+  printf("%zu requests sent\n", num_sent);
+  if (num_sent < min_sent || num_sent > min_sent + NUM_DEVICES + max_absent) {
+    ESP_LOGE(TAG, "%zu requests were sent instead of about %zu", num_sent,
+             min_sent + NUM_DEVICES);
+    ++num_errors;
+  }
+  for (int i = 0; i <= NUM_DEVICES; ++i) {
+    rdm_poller_result_t result;
+    if (!rdm_poller_get_result(dmx_num, job, uids[i], &result, NULL, 0)) {
+      ESP_LOGE(TAG, "no result for " UIDSTR, UID2STR(uids[i]));
+      ++num_errors;
+      continue;
+    }
+    printf(UIDSTR ": type %i, NACK reason 0x%04x\n", UID2STR(uids[i]),
+           result.type, result.nack_reason);
+    const bool is_absent = uids[i] == ABSENT_UID;
+    if (is_absent ? result.type != RDM_RESPONSE_TYPE_NONE
+                  : result.type != RDM_RESPONSE_TYPE_NACK_REASON ||
+                        result.nack_reason != RDM_NR_UNKNOWN_PID) {
+      ESP_LOGE(TAG, "unexpected result for " UIDSTR, UID2STR(uids[i]));
+      ++num_errors;
+    }
+  }
+  rdm_poller_result_t result;
+  if (rdm_poller_get_result(dmx_num, job, 0x05e0fffffffe, &result, NULL, 0)) {
+    ESP_LOGE(TAG, "a result was returned for a device which is not polled");
+    ++num_errors;
+  }
+
+  if (rdm_poller_delete(dmx_num) != ESP_OK ||
+      rdm_poller_get_result(dmx_num, job, uids[0], &result, NULL, 0)) {
+    ESP_LOGE(TAG, "the poller was not uninstalled");
+    ++num_errors;
+  }
+
+  dmx_sim_bus_delete(bus);
+  dmx_driver_delete(dmx_num);
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
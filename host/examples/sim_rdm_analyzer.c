@@ -0,0 +1,168 @@
+/*
+
+  Host RDM Transaction Analyzer
+
+  Runs the DMX driver on Linux against a simulated line with virtual RDM
+  responders, which respond after random turnaround times. DMX port 0 is the
+  RDM controller. It discovers the responders and sends each of them GET
+  requests, which they NACK, and sends GET requests to a device which is not
+  on the line. DMX port 1 only listens to the line, with the RDM transaction
+  analyzer started. The counters of the analyzer are printed for the line and
+  for each responder.
+
+  Exits with a non-zero status if the analyzer did not pair every request with
+  its response, or if it did not count the NACKs, lost requests, and
+  DISC_UNIQUE_BRANCH requests which were sent.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+#include <string.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_bus.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+#include "esp_rdm_analyzer.h"
+
+#define NUM_DEVICES 20
+#define NUM_GETS 3
+#define ABSENT_UID 0x05e0ffffff00
+#define TURNAROUND_MAX_US 1000
+#define TURNAROUND_ERROR_US 50
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+
+static void check_device(dmx_port_t dmx_num, rdm_uid_t uid) {
+  rdm_analyzer_device_stats_t stats;
+  if (!rdm_analyzer_get_device_stats(dmx_num, uid, &stats)) {
+    ESP_LOGE(TAG, "no counters for " UIDSTR, UID2STR(uid));
+    ++num_errors;
+    return;
+  }
+  const uint32_t avg_turnaround =
+      stats.num_responses ? stats.total_turnaround_us / stats.num_responses : 0;
+  const uint32_t avg_latency =
+      stats.num_responses ? stats.total_latency_us / stats.num_responses : 0;
+  printf(UIDSTR " %8u %9u %5u %5u %5u %5u/%u/%u %5u/%u/%u\n", UID2STR(uid),
+         (unsigned)stats.num_requests, (unsigned)stats.num_responses,
+         (unsigned)stats.num_lost, (unsigned)stats.num_acks,
+         (unsigned)stats.num_nacks, (unsigned)stats.min_turnaround_us,
+         (unsigned)avg_turnaround, (unsigned)stats.max_turnaround_us,
+         (unsigned)stats.min_latency_us, (unsigned)avg_latency,
+         (unsigned)stats.max_latency_us);
+
+  if (uid == ABSENT_UID) {
+    if (stats.num_requests != NUM_GETS || stats.num_lost != NUM_GETS) {
+      ESP_LOGE(TAG, "the requests to the absent device were not lost");
+      ++num_errors;
+    }
+    return;
+  }
+  if (stats.num_responses != stats.num_requests || stats.num_lost > 0 ||
+      stats.num_disc_responses == 0 || stats.num_nacks != NUM_GETS ||
+      stats.nack_reasons[RDM_NR_UNKNOWN_PID] != NUM_GETS) {
+    ESP_LOGE(TAG, "the transactions of " UIDSTR " were not counted",
+             UID2STR(uid));
+    ++num_errors;
+  }
+  if (stats.min_turnaround_us + TURNAROUND_ERROR_US < RDM_BREAK_LEN_US ||
+      stats.max_turnaround_us > TURNAROUND_MAX_US + TURNAROUND_ERROR_US) {
+    ESP_LOGE(TAG, "the turnaround of " UIDSTR " was not measured",
+             UID2STR(uid));
+    ++num_errors;
+  }
+}
+
+static void app_main(void *arg) {
+  const dmx_port_t controller_num = DMX_NUM_0;
+  const dmx_port_t analyzer_num = DMX_NUM_1;
+  dmx_sim_bus_config_t bus_config = DMX_SIM_BUS_CONFIG_DEFAULT;
+  bus_config.turnaround_max_us = TURNAROUND_MAX_US;
+  dmx_sim_bus_t *const bus = dmx_sim_bus_create(&bus_config);
+  if (bus == NULL) {
+    ESP_LOGE(TAG, "failed to create the line");
+    ++num_errors;
+    return;
+  }
+  dmx_sim_bus_add_random_responders(bus, 0x05e0, NUM_DEVICES);
+  ESP_ERROR_CHECK(dmx_driver_install(controller_num, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_driver_install(analyzer_num, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, controller_num));
+  ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, analyzer_num));
+
+  const rdm_analyzer_config_t config = RDM_ANALYZER_DEFAULT_CONFIG;
+  ESP_ERROR_CHECK(rdm_analyzer_start(analyzer_num, &config));
+
+  // Discover the responders and send each of them requests which are NACKed
+  static rdm_uid_t uids[NUM_DEVICES];
+  const size_t num_found =
+      rdm_discover_devices_simple(controller_num, uids, NUM_DEVICES);
+  if (num_found != NUM_DEVICES) {
+    ESP_LOGE(TAG, "found %zu of %i devices", num_found, NUM_DEVICES);
+    ++num_errors;
+  }
+  for (int i = 0; i < NUM_GETS; ++i) {
+    for (size_t j = 0; j < num_found; ++j) {
+      rdm_response_t response;
+      rdm_device_info_t device_info;
+      rdm_get_device_info(controller_num, uids[j], RDM_ROOT_DEVICE, &response,
+                          &device_info);
+    }
+    rdm_response_t response;
+    rdm_device_info_t device_info;
+    rdm_get_device_info(controller_num, ABSENT_UID, RDM_ROOT_DEVICE, &response,
+                        &device_info);
+  }
+
+  // A DMX packet ends the wait for the last request
+  const uint8_t data[DMX_PACKET_SIZE] = {0};
+  vTaskDelay(pdMS_TO_TICKS(10));
+  dmx_write(controller_num, data, DMX_PACKET_SIZE);
+  dmx_send(controller_num, DMX_PACKET_SIZE);
+  dmx_wait_sent(controller_num, DMX_TIMEOUT_TICK);
+  vTaskDelay(pdMS_TO_TICKS(10));
+
+  rdm_analyzer_stats_t stats;
+  rdm_analyzer_get_stats(analyzer_num, &stats);
+  printf("%u frames, %u requests, %u broadcasts, %u responses, %u unmatched, "
+         "%u lost, %u invalid\n",
+         (unsigned)stats.num_frames, (unsigned)stats.num_requests,
+         (unsigned)stats.num_broadcasts, (unsigned)stats.num_responses,
+         (unsigned)stats.num_unmatched, (unsigned)stats.num_lost,
+         (unsigned)stats.num_invalid);
+  printf("%u DISC_UNIQUE_BRANCH: %u answered, %u collided, %u silent\n",
+         (unsigned)stats.num_discoveries, (unsigned)stats.num_disc_responses,
+         (unsigned)stats.num_disc_collisions, (unsigned)stats.num_disc_silent);
+  if (stats.num_unmatched > 0 || stats.num_lost != NUM_GETS ||
+      stats.num_devices != NUM_DEVICES + 1 ||
+      stats.num_disc_responses + stats.num_disc_collisions +
+              stats.num_disc_silent != stats.num_discoveries) {
+    ESP_LOGE(TAG, "the transactions on the line were not counted");
+    ++num_errors;
+  }
+
+  printf("%-14s %8s %9s %5s %5s %5s %15s %15s\n", "uid", "requests",
+         "responses", "lost", "acks", "nacks", "turnaround_us", "latency_us");
+  for (size_t i = 0; i < num_found; ++i) {
+    check_device(analyzer_num, uids[i]);
+  }
+  check_device(analyzer_num, ABSENT_UID);
+
+  rdm_analyzer_stop(analyzer_num);
+  dmx_sim_bus_delete(bus);
+  dmx_driver_delete(analyzer_num);
+  dmx_driver_delete(controller_num);
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
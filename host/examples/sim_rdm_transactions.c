@@ -0,0 +1,186 @@
+/*
+
+  Host RDM Transaction Matching
+
+  Sends hand-made RDM requests and responses on a simulated line while a
+  second DMX port listens with rdm_analyzer_start(), whose transaction table
+  is kept small so that it is always full. Several requests are outstanding at
+  once and are answered out of order, so each response removes a table entry
+  which other entries may have probed past, and the entries after it must be
+  shifted back for the remaining responses to be paired. Then requests which
+  are never answered must expire as lost, including a request which is given
+  up on because the table is full.
+
+  Exits with a non-zero status if a response was not paired with its request,
+  or if a request was not counted as lost.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_bus.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+#include "esp_rdm_analyzer.h"
+
+#define NUM_RESPONDERS 4
+#define NUM_ROUNDS 8
+#define CONTROLLER_UID 0x7a7000000001
+#define RESPONDER_UID 0x05e000000001
+#define RESPONSE_TIMEOUT_US 50000
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+
+// Sends an RDM message without a parameter data from port 0.
+static void send_message(rdm_uid_t source_uid, rdm_uid_t destination_uid,
+                         uint8_t tn, rdm_cc_t cc) {
+  uint8_t data[RDM_BASE_PACKET_SIZE];
+  data[0] = RDM_SC;
+  data[1] = RDM_SUB_SC;
+  data[2] = RDM_BASE_PACKET_SIZE - 2;  // The message length
+  uid_to_buf(&data[3], destination_uid);
+  uid_to_buf(&data[9], source_uid);
+  data[15] = tn;
+  data[16] = cc & 1 ? RDM_RESPONSE_TYPE_ACK : 1;  // The response type or port
+  data[17] = 0;                                   // The message count
+  data[18] = 0;                                   // The sub-device
+  data[19] = 0;
+  data[20] = cc;
+  data[21] = RDM_PID_DEVICE_INFO >> 8;
+  data[22] = RDM_PID_DEVICE_INFO & 0xff;
+  data[23] = 0;  // The parameter data length
+  uint16_t checksum = 0;
+  for (int i = 0; i < RDM_BASE_PACKET_SIZE - 2; ++i) {
+    checksum += data[i];
+  }
+  data[24] = checksum >> 8;
+  data[25] = checksum & 0xff;
+
+  dmx_write(DMX_NUM_0, data, sizeof(data));
+  dmx_send(DMX_NUM_0, sizeof(data));
+  dmx_wait_sent(DMX_NUM_0, DMX_TIMEOUT_TICK);
+}
+
+static void send_request(int responder, uint8_t tn) {
+  send_message(CONTROLLER_UID, RESPONDER_UID + responder, tn,
+               RDM_CC_GET_COMMAND);
+}
+
+static void send_response(int responder, uint8_t tn) {
+  send_message(RESPONDER_UID + responder, CONTROLLER_UID, tn,
+               RDM_CC_GET_COMMAND_RESPONSE);
+}
+
+// Waits for the analyzer to read the frames on the line, then compares its
+// counters with the expected counters.
+static void check(const char *when, uint32_t num_requests,
+                  uint32_t num_responses, uint32_t num_unmatched,
+                  uint32_t num_lost) {
+  vTaskDelay(pdMS_TO_TICKS(10));
+  rdm_analyzer_stats_t stats;
+  rdm_analyzer_get_stats(DMX_NUM_1, &stats);
+  printf("%s: %u requests, %u responses, %u unmatched, %u lost\n", when,
+         (unsigned)stats.num_requests, (unsigned)stats.num_responses,
+         (unsigned)stats.num_unmatched, (unsigned)stats.num_lost);
+  if (stats.num_requests != num_requests ||
+      stats.num_responses != num_responses ||
+      stats.num_unmatched != num_unmatched || stats.num_lost != num_lost ||
+      stats.num_invalid != 0) {
+    ESP_LOGE(TAG, "unexpected counters %s", when);
+    ++num_errors;
+  }
+}
+
+static void app_main(void *arg) {
+  dmx_sim_bus_t *const bus = dmx_sim_bus_create(NULL);
+  if (bus == NULL) {
+    ESP_LOGE(TAG, "failed to create the line");
+    ++num_errors;
+    return;
+  }
+  ESP_ERROR_CHECK(dmx_driver_install(DMX_NUM_0, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_driver_install(DMX_NUM_1, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, DMX_NUM_0));
+  ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, DMX_NUM_1));
+
+  rdm_analyzer_config_t config = RDM_ANALYZER_DEFAULT_CONFIG;
+  config.max_transactions = NUM_RESPONDERS;
+  config.response_timeout_us = RESPONSE_TIMEOUT_US;
+  ESP_ERROR_CHECK(rdm_analyzer_start(DMX_NUM_1, &config));
+
+  // Fill the transaction table, then answer the requests in a different
+  // order each round
+  static const int orders[NUM_ROUNDS][NUM_RESPONDERS] = {
+      {0, 1, 2, 3}, {3, 2, 1, 0}, {1, 3, 0, 2}, {2, 0, 3, 1},
+      {0, 2, 1, 3}, {3, 1, 2, 0}, {1, 0, 3, 2}, {2, 3, 0, 1}};
+  uint8_t tn = 0;
+  for (int round = 0; round < NUM_ROUNDS; ++round) {
+    for (int i = 0; i < NUM_RESPONDERS; ++i) {
+      send_request(i, tn + i);
+    }
+    for (int i = 0; i < NUM_RESPONDERS; ++i) {
+      const int responder = orders[round][i];
+      send_response(responder, tn + responder);
+    }
+    tn += NUM_RESPONDERS;
+  }
+
+  // A response to a request which was already answered is not paired. The
+  // driver only sends a response soon after the frame before it.
+  send_response(0, tn - NUM_RESPONDERS);
+  const uint32_t num_paired = NUM_ROUNDS * NUM_RESPONDERS;
+  check("after answering out of order", num_paired, num_paired, 1, 0);
+
+  // Requests which are not answered expire when a later frame starts after
+  // the response timeout. The table is full, so the fifth request replaces
+  // the request in its home entry, which is counted as lost at once.
+  for (int i = 0; i < NUM_RESPONDERS; ++i) {
+    send_request(i, tn + i);
+  }
+  send_request(0, tn + NUM_RESPONDERS);
+  check("after overfilling the table", num_paired + NUM_RESPONDERS + 1,
+        num_paired, 1, 1);
+  vTaskDelay(pdMS_TO_TICKS(RESPONSE_TIMEOUT_US / 1000 * 2));
+  const uint8_t data[DMX_PACKET_SIZE] = {0};
+  dmx_write(DMX_NUM_0, data, DMX_PACKET_SIZE);
+  dmx_send(DMX_NUM_0, DMX_PACKET_SIZE);
+  dmx_wait_sent(DMX_NUM_0, DMX_TIMEOUT_TICK);
+  check("after the response timeout", num_paired + NUM_RESPONDERS + 1,
+        num_paired, 1, NUM_RESPONDERS + 1);
+
+  // An answer to an expired request is not paired
+  send_request(2, tn + NUM_RESPONDERS + 1);
+  send_response(1, tn + 1);
+  check("after a late response", num_paired + NUM_RESPONDERS + 2, num_paired,
+        2, NUM_RESPONDERS + 1);
+
+  // Each responder answered every round
+  for (int i = 0; i < NUM_RESPONDERS; ++i) {
+    const rdm_uid_t uid = RESPONDER_UID + i;
+    rdm_analyzer_device_stats_t stats;
+    if (!rdm_analyzer_get_device_stats(DMX_NUM_1, uid, &stats) ||
+        stats.num_responses != NUM_ROUNDS || stats.num_acks != NUM_ROUNDS) {
+      ESP_LOGE(TAG, "the responses of " UIDSTR " were not counted",
+               UID2STR(uid));
+      ++num_errors;
+    }
+  }
+
+  rdm_analyzer_stop(DMX_NUM_1);
+  dmx_sim_bus_delete(bus);
+  dmx_driver_delete(DMX_NUM_1);
+  dmx_driver_delete(DMX_NUM_0);
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/*
+
+  Host RDM Response Cache
+
+  Sends GET requests from two controllers, on DMX ports 0 and 2, to the RDM
+  responder task of DMX port 1 on a simulated line. The responder answers
+  requests for static PIDs with pre-encoded responses, whose destination UID
+  and transaction number are patched for each request. There are more static
+  responses than slots in the cache, so they replace each other. A change to
+  the parameters of the responder which bypasses the setters must not be seen
+  until a setter invalidates the cache, and must be seen at once after that.
+
+  Exits with a non-zero status if a response was not addressed to the
+  controller which sent the request, if a response changed while it was
+  cached, or if a response was stale after a setter was called.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+#include <string.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_bus.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+#include "esp_rdm_client.h"
+
+#define NUM_ROUNDS 3
+#define NUM_REQUESTS 9
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+
+static const rdm_client_personality_t personalities[] = {
+    {4, "Dimmer"}, {8, "Dimmer 16-bit"}, {3, "RGB"}, {6, "RGB 16-bit"}};
+
+// A static GET request and the parameter data of its first response.
+typedef struct request_t {
+  rdm_pid_t pid;
+  uint8_t param;  // The personality of a description, or 0.
+  size_t pdl;
+  uint8_t pd[RDM_MAX_PDL];
+} request_t;
+
+static request_t requests[NUM_REQUESTS] = {
+    {RDM_PID_SUPPORTED_PARAMETERS},
+    {RDM_PID_DEVICE_INFO},
+    {RDM_PID_DEVICE_MODEL_DESCRIPTION},
+    {RDM_PID_MANUFACTURER_LABEL},
+    {RDM_PID_SOFTWARE_VERSION_LABEL},
+    {RDM_PID_DMX_PERSONALITY_DESCRIPTION, 1},
+    {RDM_PID_DMX_PERSONALITY_DESCRIPTION, 2},
+    {RDM_PID_DMX_PERSONALITY_DESCRIPTION, 3},
+    {RDM_PID_DMX_PERSONALITY_DESCRIPTION, 4},
+};
+
+// Sends GET DEVICE_INFO and checks the start address and the footprint.
+static void check_device_info(dmx_port_t dmx_num, const char *when,
+                              uint16_t start_address, uint16_t footprint) {
+  rdm_response_t response;
+  rdm_device_info_t device_info;
+  rdm_get_device_info(dmx_num, rdm_get_uid(DMX_NUM_1), RDM_ROOT_DEVICE,
+                      &response, &device_info);
+  if (response.err || response.type != RDM_RESPONSE_TYPE_ACK) {
+    ESP_LOGE(TAG, "port %i got no DEVICE_INFO %s", dmx_num, when);
+    ++num_errors;
+    return;
+  }
+  printf("port %i %s: start address %u, footprint %u\n", dmx_num, when,
+         device_info.start_address, (unsigned)device_info.footprint);
+  if (device_info.start_address != start_address ||
+      device_info.footprint != footprint) {
+    ESP_LOGE(TAG, "port %i got a stale DEVICE_INFO %s", dmx_num, when);
+    ++num_errors;
+  }
+}
+
+static void app_main(void *arg) {
+  const dmx_port_t responder_num = DMX_NUM_1;
+  dmx_sim_bus_t *const bus = dmx_sim_bus_create(NULL);
+  if (bus == NULL) {
+    ESP_LOGE(TAG, "failed to create the line");
+    ++num_errors;
+    return;
+  }
+  for (dmx_port_t dmx_num = 0; dmx_num < DMX_NUM_MAX; ++dmx_num) {
+    ESP_ERROR_CHECK(dmx_driver_install(dmx_num, DMX_DEFAULT_INTR_FLAGS));
+    ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, dmx_num));
+  }
+  const rdm_uid_t uid = rdm_get_uid(responder_num);
+  rdm_client_init(responder_num, 1, 4, "responder", "Dimmer");
+  rdm_client_set_personalities(responder_num, personalities, 4);
+  rdm_client_responder_start(responder_num, NULL);
+
+  // Static responses are cached, replaced, and encoded again, and each copy
+  // is addressed to the controller which asked for it
+  for (int round = 0; round < NUM_ROUNDS; ++round) {
+    for (int i = 0; i < NUM_REQUESTS; ++i) {
+      request_t *const request = &requests[i];
+      const dmx_port_t dmx_num = (i + round) % 2 == 0 ? DMX_NUM_0 : DMX_NUM_2;
+      rdm_response_t response;
+      uint8_t pd[RDM_MAX_PDL];
+      const size_t pdl = rdm_get_generic(
+          dmx_num, uid, RDM_ROOT_DEVICE, request->pid, &request->param,
+          request->param > 0 ? 1 : 0, &response, pd, sizeof(pd));
+      if (response.err || response.type != RDM_RESPONSE_TYPE_ACK) {
+        ESP_LOGE(TAG, "port %i got no response for PID 0x%04x", dmx_num,
+                 request->pid);
+        ++num_errors;
+      } else if (round == 0) {
+        request->pdl = pdl;
+        memcpy(request->pd, pd, pdl);
+      } else if (pdl != request->pdl || memcmp(pd, request->pd, pdl) != 0) {
+        ESP_LOGE(TAG, "the response for PID 0x%04x changed in round %i",
+                 request->pid, round);
+        ++num_errors;
+      }
+    }
+  }
+  check_device_info(DMX_NUM_0, "at first", 1, 4);
+  check_device_info(DMX_NUM_2, "at first", 1, 4);
+
+  // A change which bypasses the setters is not seen while the response is
+  // cached, but is seen as soon as a setter invalidates the cache
+  rdm_parameters[responder_num].device_info.start_address = 100;
+  check_device_info(DMX_NUM_0, "without a setter", 1, 4);
+  rdm_client_set_start_address(responder_num, 200);
+  check_device_info(DMX_NUM_2, "after the start address was set", 200, 4);
+  check_device_info(DMX_NUM_0, "after the start address was set", 200, 4);
+  rdm_client_set_personality(responder_num, 2);
+  check_device_info(DMX_NUM_0, "after the personality was set", 200, 8);
+
+  rdm_responder_stats_t stats;
+  rdm_client_get_responder_stats(responder_num, &stats);
+  printf("%u requests handled, %u responses, %u missed\n",
+         (unsigned)stats.num_handled, (unsigned)stats.num_responses,
+         (unsigned)stats.num_missed);
+  if (stats.num_missed > 0 || stats.num_responses != stats.num_handled) {
+    ESP_LOGE(TAG, "the responder did not answer every request");
+    ++num_errors;
+  }
+
+  rdm_client_responder_stop(responder_num);
+  rdm_client_deinit(responder_num);
+  dmx_sim_bus_delete(bus);
+  for (dmx_port_t dmx_num = 0; dmx_num < DMX_NUM_MAX; ++dmx_num) {
+    dmx_driver_delete(dmx_num);
+  }
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+/*
+
+  Host RDM Sensors
+
+  Adds sensors to the sensor registry of DMX port 1 and publishes values to
+  them. The first value must seed the minimum, maximum, and recorded values,
+  later values must only move the minimum and maximum, and recording and
+  resetting must act on the current value. Sensors without history must
+  report their minimum, maximum, and recorded values as 0. Then a sampling
+  task publishes a rising value while DMX port 0 reads it with SENSOR_VALUE
+  requests to the RDM responder task of port 1 on a simulated line. Each
+  response must be from a single publish.
+
+  Exits with a non-zero status if a sensor value differs from the expected
+  value or a response mixes the values of two publishes.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+#include <string.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_bus.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+#include "esp_rdm_client.h"
+#include "rdmsensors.h"
+
+#define NUM_SENSORS 2
+#define NUM_SAMPLES 200
+#define NUM_READS 20
+#define FIRST_SAMPLE 1000
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+static volatile bool is_sampling = false;
+
+// Checks the values of a sensor.
+static void check(const char *when, uint8_t sensor_num, int16_t value,
+                  int16_t min, int16_t max, int16_t recorded) {
+  sensorData_t data;
+  if (!rdm_sensor_get_value(DMX_NUM_1, sensor_num, &data)) {
+    ESP_LOGE(TAG, "sensor %u does not exist", sensor_num);
+    ++num_errors;
+    return;
+  }
+  printf("sensor %u %s: value %i, min %i, max %i, recorded %i\n", sensor_num,
+         when, data.sensorVal, data.minVal, data.maxVal, data.recVal);
+  if (data.sensorNum != sensor_num || data.sensorVal != value ||
+      data.minVal != min || data.maxVal != max || data.recVal != recorded) {
+    ESP_LOGE(TAG, "unexpected values of sensor %u %s", sensor_num, when);
+    ++num_errors;
+  }
+}
+
+// Publishes a rising value to sensor 0 once per tick.
+static void sample_task(void *arg) {
+  for (int i = 0; i < NUM_SAMPLES; ++i) {
+    rdm_sensor_set_value(DMX_NUM_1, 0, FIRST_SAMPLE + i);
+    vTaskDelay(1);
+  }
+  is_sampling = false;
+  vTaskDelete(NULL);
+}
+
+static void app_main(void *arg) {
+  const dmx_port_t controller_num = DMX_NUM_0;
+  const dmx_port_t responder_num = DMX_NUM_1;
+
+  // The registry is full after the sensors are added
+  ESP_ERROR_CHECK(rdm_sensors_install(responder_num, NUM_SENSORS));
+  sensorDef_t def = {.sensorType = SENS_TEMPERATURE,
+                     .sensorUnit = UNITS_CENTIGRADE,
+                     .range_min = -400,
+                     .range_max = 1200,
+                     .normal_min = 0,
+                     .normal_max = 800,
+                     .sensorHistory = MINMAXANDRECSUPPORTED,
+                     .sensorDesc = "Temperature"};
+  const int temperature = rdm_sensor_add(responder_num, &def);
+  def.sensorHistory = NOHISTORY;
+  strcpy(def.sensorDesc, "Fan");
+  const int fan = rdm_sensor_add(responder_num, &def);
+  if (temperature != 0 || fan != 1 ||
+      rdm_sensor_add(responder_num, &def) >= 0 ||
+      rdm_sensor_count(responder_num) != NUM_SENSORS) {
+    ESP_LOGE(TAG, "the sensors were not added");
+    ++num_errors;
+  }
+
+  // The first value seeds the history, and later values extend it
+  rdm_sensor_set_value(responder_num, 0, 50);
+  check("after the first value", 0, 50, 50, 50, 50);
+  rdm_sensor_set_value(responder_num, 0, 20);
+  rdm_sensor_set_value(responder_num, 0, 80);
+  rdm_sensor_set_value(responder_num, 0, 60);
+  check("after more values", 0, 60, 20, 80, 50);
+  rdm_sensor_record(responder_num, 0);
+  rdm_sensor_set_value(responder_num, 0, 70);
+  check("after recording", 0, 70, 20, 80, 60);
+  rdm_sensor_reset(responder_num, RDM_SENSOR_ALL);
+  check("after resetting", 0, 70, 70, 70, 70);
+
+  // A sensor without history only reports its value
+  rdm_sensor_set_value(responder_num, 1, 5);
+  rdm_sensor_set_value(responder_num, 1, -7);
+  check("without history", 1, -7, 0, 0, 0);
+  if (rdm_sensor_record(responder_num, 1)) {
+    ESP_LOGE(TAG, "a value was recorded for a sensor without history");
+    ++num_errors;
+  }
+
+  dmx_sim_bus_t *const bus = dmx_sim_bus_create(NULL);
+  if (bus == NULL) {
+    ESP_LOGE(TAG, "failed to create the line");
+    ++num_errors;
+    return;
+  }
+  ESP_ERROR_CHECK(dmx_driver_install(controller_num, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_driver_install(responder_num, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, controller_num));
+  ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, responder_num));
+  rdm_client_init(responder_num, 1, 4, "responder", "Default");
+  rdm_client_responder_start(responder_num, NULL);
+  const rdm_uid_t uid = rdm_get_uid(responder_num);
+
+  rdm_response_t response;
+  rdm_device_info_t device_info;
+  rdm_get_device_info(controller_num, uid, RDM_ROOT_DEVICE, &response,
+                      &device_info);
+  if (response.type != RDM_RESPONSE_TYPE_ACK ||
+      device_info.sensor_count != NUM_SENSORS) {
+    ESP_LOGE(TAG, "DEVICE_INFO did not report the sensors");
+    ++num_errors;
+  }
+
+  // Each response is from one publish of the sampling task: the value is the
+  // maximum, and the minimum is the value when the sensor was reset
+  rdm_sensor_set_value(responder_num, 0, FIRST_SAMPLE - 1);
+  rdm_sensor_reset(responder_num, 0);
+  is_sampling = true;
+  xTaskCreatePinnedToCore(sample_task, "sample", 4096, NULL, 1, NULL,
+                          tskNO_AFFINITY);
+  int num_reads = 0;
+  int16_t last_value = FIRST_SAMPLE - 1;
+  while (is_sampling && num_reads < NUM_READS) {
+    const uint8_t sensor_num = 0;
+    sensorData_t data;
+    if (rdm_get_parameter(controller_num, uid, RDM_ROOT_DEVICE,
+                          RDM_PID_SENSOR_VALUE, &sensor_num, 1, &response,
+                          &data, 1) != 1 ||
+        response.type != RDM_RESPONSE_TYPE_ACK) {
+      ESP_LOGE(TAG, "no response to SENSOR_VALUE");
+      ++num_errors;
+      break;
+    }
+    if (data.sensorVal != data.maxVal || data.minVal != FIRST_SAMPLE - 1 ||
+        data.recVal != FIRST_SAMPLE - 1 || data.sensorVal < last_value) {
+      ESP_LOGE(TAG, "inconsistent SENSOR_VALUE: %i, min %i, max %i, rec %i",
+               data.sensorVal, data.minVal, data.maxVal, data.recVal);
+      ++num_errors;
+    }
+    last_value = data.sensorVal;
+    ++num_reads;
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+  printf("%i reads while sampling, last value %i\n", num_reads, last_value);
+  if (num_reads < NUM_READS || last_value == FIRST_SAMPLE - 1) {
+    ESP_LOGE(TAG, "the samples were not read while they were published");
+    ++num_errors;
+  }
+  while (is_sampling) {
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+
+  rdm_client_responder_stop(responder_num);
+  rdm_client_deinit(responder_num);
+  dmx_sim_bus_delete(bus);
+  dmx_driver_delete(responder_num);
+  dmx_driver_delete(controller_num);
+  rdm_sensors_delete(responder_num);
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
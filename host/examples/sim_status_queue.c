@@ -0,0 +1,125 @@
+/*
+
+  Host RDM Status Message Queue
+
+  Posts status messages of mixed severities to the queued message ring of a
+  DMX port, as sensor alarms of an RDM responder would be, and reads them back
+  the way the RDM responder serves STATUS_MESSAGES requests with different
+  status types. Messages below the requested severity must stay pending for a
+  later request.
+
+  Exits with a non-zero status if a message was lost, returned twice, or
+  returned for a request of a higher severity.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+
+#include "dmx_sim.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm_queue.h"
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+
+// Posts a status message whose message ID identifies it.
+static void post(dmx_port_t dmx_num, rdm_status_t status_type, int id) {
+  const rdm_status_message_t message = {.sub_device = RDM_ROOT_DEVICE,
+                                        .status_type = status_type,
+                                        .message_id = id};
+  if (!rdm_queue_post_status(dmx_num, &message)) {
+    ESP_LOGE(TAG, "status message %i was not posted", id);
+    ++num_errors;
+  }
+}
+
+// Reads the status messages of a status type and compares their message IDs
+// with the expected IDs.
+static void check(dmx_port_t dmx_num, rdm_status_t status_type,
+                  const int *expected, size_t num_expected) {
+  rdm_status_message_t messages[RDM_QUEUE_MAX_STATUS_MESSAGES];
+  const size_t num_messages = rdm_queue_pop_status(
+      dmx_num, status_type, messages, RDM_QUEUE_MAX_STATUS_MESSAGES);
+  printf("status type 0x%02x:", status_type);
+  for (size_t i = 0; i < num_messages; ++i) {
+    printf(" %u/0x%02x", messages[i].message_id, messages[i].status_type);
+  }
+  printf("\n");
+
+  bool matched = num_messages == num_expected;
+  for (size_t i = 0; matched && i < num_messages; ++i) {
+    matched = messages[i].message_id == expected[i] &&
+              (messages[i].status_type & 0x0f) >= status_type;
+  }
+  if (!matched) {
+    ESP_LOGE(TAG, "unexpected status messages for status type 0x%02x",
+             status_type);
+    ++num_errors;
+  }
+}
+
+static void app_main(void *arg) {
+  const dmx_port_t dmx_num = DMX_NUM_0;
+  ESP_ERROR_CHECK(rdm_queue_install(dmx_num, 8));
+
+  post(dmx_num, RDM_STATUS_ADVISORY, 1);
+  post(dmx_num, RDM_STATUS_WARNING, 2);
+  post(dmx_num, RDM_STATUS_ERROR, 3);
+  post(dmx_num, RDM_STATUS_ADVISORY_CLEARED, 4);
+  post(dmx_num, RDM_STATUS_WARNING_CLEARED, 5);
+  post(dmx_num, RDM_STATUS_ERROR, 6);
+
+  // Only advisory, warning, and error statuses may be posted
+  const rdm_status_message_t invalid = {.status_type = RDM_STATUS_NONE};
+  if (rdm_queue_post_status(dmx_num, &invalid)) {
+    ESP_LOGE(TAG, "a status message without a severity was posted");
+    ++num_errors;
+  }
+  if (rdm_queue_count(dmx_num) != 6) {
+    ESP_LOGE(TAG, "%zu messages are pending", rdm_queue_count(dmx_num));
+    ++num_errors;
+  }
+
+  // Each request returns the most severe messages first, oldest first, and
+  // leaves the messages below its severity pending
+  static const int errors[] = {3, 6};
+  check(dmx_num, RDM_STATUS_ERROR, errors, 2);
+  check(dmx_num, RDM_STATUS_ERROR, NULL, 0);
+  post(dmx_num, RDM_STATUS_ERROR_CLEARED, 7);
+  static const int warnings[] = {7, 2, 5};
+  check(dmx_num, RDM_STATUS_WARNING, warnings, 3);
+  static const int advisories[] = {1, 4};
+  check(dmx_num, RDM_STATUS_ADVISORY, advisories, 2);
+  if (rdm_queue_count(dmx_num) != 0) {
+    ESP_LOGE(TAG, "%zu messages are still pending", rdm_queue_count(dmx_num));
+    ++num_errors;
+  }
+
+  // A full response leaves the remaining messages pending
+  for (int i = 0; i < 8; ++i) {
+    post(dmx_num, RDM_STATUS_WARNING, 10 + i);
+    post(dmx_num, RDM_STATUS_ADVISORY, 20 + i);
+  }
+  rdm_status_message_t messages[4];
+  if (rdm_queue_pop_status(dmx_num, RDM_STATUS_ADVISORY, messages, 4) != 4 ||
+      messages[0].message_id != 10 || messages[3].message_id != 13) {
+    ESP_LOGE(TAG, "a full response did not return the oldest warnings");
+    ++num_errors;
+  }
+  static const int remaining[] = {14, 15, 16, 17, 20, 21, 22, 23,
+                                  24, 25, 26, 27};
+  check(dmx_num, RDM_STATUS_ADVISORY, remaining, 12);
+
+  rdm_queue_delete(dmx_num);
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
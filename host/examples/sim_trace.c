@@ -0,0 +1,98 @@
+/*
+
+  Host DMX Trace
+
+  Runs the DMX driver on Linux against a simulated line with one virtual RDM
+  responder, and writes the trace of DMX port 1 to stdout. Port 1 sends a DMX
+  packet, then sends an RDM DISC_MUTE request to the responder and receives
+  its response. The records are written as they are copied by
+  dmx_trace_drain(), so that they can be decoded into a timeline:
+
+    ./build-host/sim_trace | ./build-host/dmx_trace_decode
+
+  Exits with a non-zero status if the driver was built without
+  CONFIG_DMX_TRACE or the responder did not respond.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_bus.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+
+#define RESPONDER_UID 0x05e000000001
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+
+// Writes the records of the trace of a DMX port to a file and returns the
+// number of records which were written.
+static size_t write_trace(dmx_port_t dmx_num, FILE *file) {
+  dmx_trace_record_t records[64];
+  size_t num_records;
+  size_t num_written = 0;
+  uint32_t num_lost;
+  while ((num_records = dmx_trace_drain(dmx_num, records, 64, &num_lost)) >
+         0) {
+    if (num_lost > 0) {
+      const dmx_trace_record_t lost = {
+          .arg = num_lost > UINT16_MAX ? UINT16_MAX : num_lost,
+          .event = DMX_TRACE_LOST};
+      fwrite(&lost, sizeof(lost), 1, file);
+    }
+    num_written += fwrite(records, sizeof(dmx_trace_record_t), num_records,
+                          file);
+  }
+  return num_written;
+}
+
+static void app_main(void *arg) {
+  const dmx_port_t dmx_num = DMX_NUM_1;
+  ESP_ERROR_CHECK(dmx_driver_install(dmx_num, DMX_DEFAULT_INTR_FLAGS));
+
+  dmx_sim_bus_t *const bus = dmx_sim_bus_create(NULL);
+  if (bus == NULL) {
+    ESP_LOGE(TAG, "failed to create the line");
+    ++num_errors;
+    return;
+  }
+  ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, dmx_num));
+  ESP_ERROR_CHECK(dmx_sim_bus_add_responder(bus, RESPONDER_UID));
+
+  // Send a DMX packet
+  uint8_t data[DMX_PACKET_SIZE] = {0};
+  dmx_write(dmx_num, data, DMX_PACKET_SIZE);
+  dmx_send(dmx_num, 0);
+  dmx_wait_sent(dmx_num, DMX_TIMEOUT_TICK);
+
+  // Send an RDM request and receive the response
+  rdm_response_t response;
+  rdm_disc_mute_t mute;
+  if (!rdm_send_disc_mute(dmx_num, RESPONDER_UID, true, &response, &mute)) {
+    ESP_LOGE(TAG, "the responder did not respond");
+    ++num_errors;
+  }
+
+  if (write_trace(dmx_num, stdout) == 0) {
+    ESP_LOGE(TAG, "the driver was built without CONFIG_DMX_TRACE");
+    ++num_errors;
+  }
+
+  // Let the line become idle before deleting it
+  vTaskDelay(pdMS_TO_TICKS(10));
+  dmx_sim_bus_delete(bus);
+  dmx_driver_delete(dmx_num);
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
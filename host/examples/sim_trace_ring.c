@@ -0,0 +1,113 @@
+/*
+
+  Host DMX Trace Ring
+
+  Calls dmx_write() with a different size many more times than the trace of a
+  DMX port has records, without draining it, so that the ring wraps several
+  times. Then the trace is drained a few records at a time. The records which
+  were kept must be the newest writes, in the order in which they were made,
+  and every older write must be counted as lost. The trace of the other DMX
+  port must be untouched.
+
+  Exits with a non-zero status if a record was reordered, duplicated, or not
+  counted as lost, or if the driver was built without CONFIG_DMX_TRACE.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+
+#include "dmx_sim.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+
+#define NUM_WRITES 1000
+#define DRAIN_SIZE 7
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+
+// The size which is written by the write with the index.
+static size_t write_size(int index) { return index % DMX_PACKET_SIZE + 1; }
+
+static void app_main(void *arg) {
+  ESP_ERROR_CHECK(dmx_driver_install(DMX_NUM_0, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_driver_install(DMX_NUM_1, DMX_DEFAULT_INTR_FLAGS));
+
+  // The first write turns the bus around, so it is drained with the records of
+  // the driver installation
+  const uint8_t data[DMX_PACKET_SIZE] = {0};
+  dmx_trace_record_t records[DRAIN_SIZE];
+  dmx_write(DMX_NUM_0, data, DMX_PACKET_SIZE);
+  while (dmx_trace_drain(DMX_NUM_0, records, DRAIN_SIZE, NULL) > 0) {
+  }
+  while (dmx_trace_drain(DMX_NUM_1, records, DRAIN_SIZE, NULL) > 0) {
+  }
+
+  for (int i = 0; i < NUM_WRITES; ++i) {
+    dmx_write(DMX_NUM_0, data, write_size(i));
+  }
+
+  // The kept records continue on from the lost records, in order
+  uint32_t total_lost = 0;
+  int num_drained = 0;
+  size_t num_records;
+  uint32_t num_lost;
+  uint32_t last_cycles = 0;
+  while ((num_records = dmx_trace_drain(DMX_NUM_0, records, DRAIN_SIZE,
+                                        &num_lost)) > 0) {
+    if (num_lost > 0 && num_drained > 0) {
+      ESP_LOGE(TAG, "%u records were lost after %i were drained",
+               (unsigned)num_lost, num_drained);
+      ++num_errors;
+    }
+    total_lost += num_lost;
+    for (size_t i = 0; i < num_records; ++i) {
+      const int index = (int)total_lost + num_drained;
+      if (records[i].event != DMX_TRACE_WRITE ||
+          records[i].arg != write_size(index) ||
+          records[i].cycles < last_cycles) {
+        ESP_LOGE(TAG, "record %i is event %i with argument %i", index,
+                 records[i].event, records[i].arg);
+        ++num_errors;
+      }
+      last_cycles = records[i].cycles;
+      ++num_drained;
+    }
+  }
+  printf("%i records drained, %u records lost\n", num_drained,
+         (unsigned)total_lost);
+  if (num_drained == 0) {
+    ESP_LOGE(TAG, "the driver was built without CONFIG_DMX_TRACE");
+    ++num_errors;
+  } else if (num_drained + (int)total_lost != NUM_WRITES ||
+             num_drained >= NUM_WRITES / 2) {
+    ESP_LOGE(TAG, "%i writes were traced instead of %i",
+             num_drained + (int)total_lost, NUM_WRITES);
+    ++num_errors;
+  }
+
+  // The trace is now empty, and the other port traced nothing
+  if (dmx_trace_drain(DMX_NUM_0, records, DRAIN_SIZE, &num_lost) != 0 ||
+      num_lost != 0) {
+    ESP_LOGE(TAG, "the trace of port 0 was not emptied");
+    ++num_errors;
+  }
+  if (dmx_trace_drain(DMX_NUM_1, records, DRAIN_SIZE, &num_lost) != 0 ||
+      num_lost != 0) {
+    ESP_LOGE(TAG, "the writes of port 0 were traced by port 1");
+    ++num_errors;
+  }
+
+  dmx_driver_delete(DMX_NUM_1);
+  dmx_driver_delete(DMX_NUM_0);
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+/*
+
+  Host RDM Virtual Responders
+
+  Adds virtual RDM responders to DMX port 1, fills their table, and removes
+  some of them again so that the remaining UIDs must be found past the removed
+  ones. Then DMX port 0 discovers the responders on a simulated line, sets the
+  start address of each one, and identifies all of them with a broadcast. The
+  table must not change while the RDM responder task is running.
+
+  Exits with a non-zero status if a responder was not discovered, a removed
+  responder answered, a change was not applied or reported, or the table was
+  changed while the responder task was running.
+
+  Note: this example is for the host simulation in host/sim. It will not work
+  on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_bus.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+#include "esp_rdm_client.h"
+#include "esp_rdm_virtual.h"
+
+#define NUM_RESPONDERS 40
+#define MAX_RESPONDERS 48
+#define MAX_UIDS 64
+
+static const char *TAG = "main";
+
+static int num_errors = 0;
+static int num_changes = 0;
+
+static const rdm_client_personality_t personalities[] = {{4, "Dimmer"}};
+
+static const rdm_virtual_config_t config = {
+    .model_id = 0x0100,
+    .software_version_id = 1,
+    .start_address = 1,
+    .personalities = personalities,
+    .personality_count = 1,
+    .software_version_label = "1.0"};
+
+// The UIDs are spread out so that discovery has to branch.
+static rdm_uid_t virtual_uid(int i) {
+  return 0x05e000000000 + (i + 1) * 0x01000003;
+}
+
+// Every fourth responder is removed after the table is filled.
+static bool is_removed(int i) { return i % 4 == 1; }
+
+static void changed_cb(dmx_port_t dmx_num, rdm_uid_t uid, rdm_pid_t pid,
+                       void *context) {
+  if (pid == RDM_PID_DMX_START_ADDRESS) {
+    ++num_changes;
+  }
+}
+
+static void app_main(void *arg) {
+  const dmx_port_t controller_num = DMX_NUM_0;
+  const dmx_port_t responder_num = DMX_NUM_1;
+  dmx_sim_bus_t *const bus = dmx_sim_bus_create(NULL);
+  if (bus == NULL) {
+    ESP_LOGE(TAG, "failed to create the line");
+    ++num_errors;
+    return;
+  }
+  ESP_ERROR_CHECK(dmx_driver_install(controller_num, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_driver_install(responder_num, DMX_DEFAULT_INTR_FLAGS));
+  ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, controller_num));
+  ESP_ERROR_CHECK(dmx_sim_bus_attach(bus, responder_num));
+  rdm_client_init(responder_num, 1, 4, "responder", "Default");
+
+  // Fill the table, then remove responders from the middle of it
+  ESP_ERROR_CHECK(rdm_virtual_install(responder_num, MAX_RESPONDERS));
+  for (int i = 0; i < MAX_RESPONDERS; ++i) {
+    ESP_ERROR_CHECK(rdm_virtual_add(responder_num, virtual_uid(i), &config));
+  }
+  if (rdm_virtual_add(responder_num, virtual_uid(MAX_RESPONDERS), &config) !=
+          ESP_ERR_NO_MEM ||
+      rdm_virtual_add(responder_num, rdm_get_uid(responder_num), &config) !=
+          ESP_ERR_INVALID_ARG) {
+    ESP_LOGE(TAG, "a responder was added to a full table or as the port");
+    ++num_errors;
+  }
+  int num_remaining = 0;
+  for (int i = 0; i < MAX_RESPONDERS; ++i) {
+    if (i >= NUM_RESPONDERS || is_removed(i)) {
+      ESP_ERROR_CHECK(rdm_virtual_remove(responder_num, virtual_uid(i)));
+    } else {
+      ++num_remaining;
+    }
+  }
+  if (rdm_virtual_remove(responder_num, virtual_uid(1)) != ESP_ERR_NOT_FOUND ||
+      rdm_virtual_add(responder_num, virtual_uid(0), &config) !=
+          ESP_ERR_INVALID_ARG ||
+      rdm_virtual_count(responder_num) != (size_t)num_remaining) {
+    ESP_LOGE(TAG, "%zu responders remain instead of %i",
+             rdm_virtual_count(responder_num), num_remaining);
+    ++num_errors;
+  }
+
+  // The table is frozen while the responder task is running
+  rdm_virtual_set_changed_cb(responder_num, changed_cb);
+  rdm_client_responder_start(responder_num, NULL);
+  if (rdm_virtual_add(responder_num, virtual_uid(1), &config) !=
+          ESP_ERR_INVALID_STATE ||
+      rdm_virtual_remove(responder_num, virtual_uid(0)) !=
+          ESP_ERR_INVALID_STATE ||
+      rdm_virtual_delete(responder_num) != ESP_ERR_INVALID_STATE) {
+    ESP_LOGE(TAG, "the table was changed while the responder was running");
+    ++num_errors;
+  }
+
+  // The remaining responders and the port itself are discovered
+  static rdm_uid_t uids[MAX_UIDS];
+  const size_t num_found =
+      rdm_discover_devices_simple(controller_num, uids, MAX_UIDS);
+  printf("%zu devices found\n", num_found);
+  bool found_port = false;
+  int num_found_virtual = 0;
+  for (size_t i = 0; i < num_found && i < MAX_UIDS; ++i) {
+    found_port = found_port || uids[i] == rdm_get_uid(responder_num);
+    for (int j = 0; j < NUM_RESPONDERS; ++j) {
+      if (uids[i] == virtual_uid(j) && !is_removed(j)) {
+        ++num_found_virtual;
+      }
+    }
+  }
+  if (num_found != (size_t)num_remaining + 1 || !found_port ||
+      num_found_virtual != num_remaining) {
+    ESP_LOGE(TAG, "found %zu devices instead of %i", num_found,
+             num_remaining + 1);
+    ++num_errors;
+  }
+
+  // Each remaining responder takes its own start address, and removed
+  // responders do not answer
+  for (int i = 0; i < NUM_RESPONDERS; ++i) {
+    const rdm_uid_t uid = virtual_uid(i);
+    rdm_response_t response;
+    rdm_set_dmx_start_address(controller_num, uid, RDM_ROOT_DEVICE, &response,
+                              10 + i);
+    const bool is_answered = response.type != RDM_RESPONSE_TYPE_NONE;
+    if (is_answered == is_removed(i)) {
+      ESP_LOGE(TAG, UIDSTR " %s", UID2STR(uid),
+               is_answered ? "answered after it was removed"
+                           : "did not answer");
+      ++num_errors;
+    }
+  }
+  vTaskDelay(pdMS_TO_TICKS(10));
+  if (num_changes != num_remaining) {
+    ESP_LOGE(TAG, "%i changes were reported instead of %i", num_changes,
+             num_remaining);
+    ++num_errors;
+  }
+
+  // A broadcast is applied to every responder
+  rdm_response_t response;
+  rdm_set_identify_device(controller_num, RDM_BROADCAST_ALL_UID,
+                          RDM_ROOT_DEVICE, &response, true);
+  vTaskDelay(pdMS_TO_TICKS(10));
+  for (int i = 0; i < NUM_RESPONDERS; ++i) {
+    const rdm_uid_t uid = virtual_uid(i);
+    rdm_parameters_t params;
+    if (is_removed(i)) {
+      if (rdm_virtual_get_parameters(responder_num, uid, &params)) {
+        ESP_LOGE(TAG, UIDSTR " was not removed", UID2STR(uid));
+        ++num_errors;
+      }
+    } else if (!rdm_virtual_get_parameters(responder_num, uid, &params) ||
+               params.device_info.start_address != 10 + i ||
+               !params.identify_device) {
+      ESP_LOGE(TAG, "the changes to " UIDSTR " were not applied",
+               UID2STR(uid));
+      ++num_errors;
+    }
+  }
+
+  rdm_client_responder_stop(responder_num);
+  ESP_ERROR_CHECK(rdm_virtual_delete(responder_num));
+  rdm_client_deinit(responder_num);
+  dmx_sim_bus_delete(bus);
+  dmx_driver_delete(responder_num);
+  dmx_driver_delete(controller_num);
+}
+
+int main(void) {
+  const bool finished = dmx_sim_run(app_main, NULL);
+  return finished && num_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+/*
+
+  Packet Classifier Fuzzer
+
+  Feeds arbitrary slots to the classifier which the DMX interrupt handler uses
+  to decide when a received packet is complete, one slot at a time as they
+  would arrive from the RX FIFO. The driver buffer is always full sized, so
+  the classifier may read slots which have not been received yet. Aborts if
+  the classifier changes its mind about a packet once it is complete, or if
+  an RDM packet is complete before its header has been received. Decoded
+  UIDs must fit in 48 bits.
+
+  Packets which are complete are decoded as the driver would decode them, so
+  the RDM header and DISC_UNIQUE_BRANCH decoders are also fuzzed with the
+  buffer contents that the classifier accepts.
+
+  The first two bytes of the input are the expected size of DMX packets. The
+  rest are the received slots.
+
+  Note: this is for the host build in host/. It will not work on the ESP-IDF
+  or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_types.h"
+#include "private/dmx_classify.h"
+#include "private/rdm_encode/functions.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (size < 2) {
+    return 0;
+  }
+  const int rx_size = ((data[0] << 8) | data[1]) % (DMX_MAX_PACKET_SIZE + 1);
+  data += 2;
+  size -= 2;
+
+  // Slots past the end of the buffer are counted but discarded by the driver
+  uint8_t buffer[DMX_MAX_PACKET_SIZE] = {0};
+  memcpy(buffer, data, size < sizeof(buffer) ? size : sizeof(buffer));
+
+  int complete_type = -1;
+  for (int head = 1; head <= (int)size; ++head) {
+    int type;
+    const bool is_complete = dmx_classify_packet(buffer, head, rx_size, &type);
+    if (complete_type >= 0) {
+      // More slots must not change the decision
+      if (!is_complete || type != complete_type) {
+        abort();
+      }
+      continue;
+    } else if (!is_complete) {
+      continue;
+    }
+    complete_type = type;
+
+    if (type == RDM_PACKET_TYPE_DISCOVERY_RESPONSE) {
+      rdm_uid_t uid;
+      if (rdm_decode_disc_response(buffer, &uid) &&
+          uid > RDM_BROADCAST_ALL_UID) {
+        abort();
+      }
+    } else if (type != RDM_PACKET_TYPE_NON_RDM) {
+      if (head < RDM_BASE_PACKET_SIZE) {
+        abort();
+      }
+      rdm_header_t header;
+      rdm_decode_header(buffer, &header);
+    }
+  }
+
+  return 0;
+}
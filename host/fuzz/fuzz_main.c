@@ -0,0 +1,84 @@
+/*
+
+  Fuzzer Driver
+
+  Runs a fuzz target with compilers which do not provide libFuzzer, so that
+  crashing inputs and corpora can be replayed with any sanitizer. Each
+  argument is a file which is passed to the fuzz target. Without arguments,
+  random inputs are generated from a fixed seed, which is a quick smoke test
+  but not coverage-guided:
+
+    fuzz_rdm_header crash-0123abcd
+    fuzz_rdm_header
+
+  Note: this is for the host build in host/. It will not work on the ESP-IDF
+  or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FUZZ_RANDOM_RUNS 10000
+#define FUZZ_MAX_INPUT_SIZE 600
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static int run_file(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    perror(path);
+    return 1;
+  }
+  uint8_t *data = NULL;
+  size_t size = 0;
+  uint8_t chunk[4096];
+  size_t read;
+  while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    uint8_t *const grown = realloc(data, size + read);
+    if (grown == NULL) {
+      free(data);
+      fclose(file);
+      return 1;
+    }
+    data = grown;
+    for (size_t i = 0; i < read; ++i) {
+      data[size + i] = chunk[i];
+    }
+    size += read;
+  }
+  fclose(file);
+
+  fprintf(stderr, "Running: %s (%zu bytes)\n", path, size);
+  LLVMFuzzerTestOneInput(data, size);
+  free(data);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    int err = 0;
+    for (int i = 1; i < argc; ++i) {
+      err |= run_file(argv[i]);
+    }
+    return err;
+  }
+
+  // Inputs are biased towards RDM start codes so that decoders are reached
+  static const uint8_t interesting[] = {0x00, 0x01, 0x10, 0x18, 0x20, 0x21,
+                                        0xaa, 0xcc, 0xfe, 0xff};
+  srand(1);
+  uint8_t data[FUZZ_MAX_INPUT_SIZE];
+  for (int run = 0; run < FUZZ_RANDOM_RUNS; ++run) {
+    const size_t size = rand() % (sizeof(data) + 1);
+    for (size_t i = 0; i < size; ++i) {
+      data[i] = rand() % 2 ? interesting[rand() % sizeof(interesting)]
+                           : (uint8_t)rand();
+    }
+    LLVMFuzzerTestOneInput(data, size);
+  }
+  fprintf(stderr, "Done: %d random inputs\n", FUZZ_RANDOM_RUNS);
+  return 0;
+}
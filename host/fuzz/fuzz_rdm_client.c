@@ -0,0 +1,148 @@
+/*
+
+  RDM Responder Fuzzer
+
+  Passes arbitrary requests to rdm_client_handle_rdm_message() on a DMX port
+  of the host simulation. The responder is configured with personalities, a
+  sensor, sparse sub-devices and a virtual responder so that every built-in
+  PID handler can be reached. The request is copied into a buffer of exactly
+  its size so that reads past the end of the request are caught by
+  AddressSanitizer. Responses are sent on a line to which nothing is
+  connected. The state of the responder is kept between inputs, as it would
+  be on a DMX line.
+
+  Random bytes rarely form a request which is addressed to the responder and
+  has a valid checksum, so the first byte of the input selects fix-ups which
+  are applied to the request before it is handled:
+
+    bit 0: the destination UID is set to the UID of the port.
+    bit 1: the destination UID is set to the UID of the virtual responder.
+    bit 2: the message length is set to match the parameter data length.
+    bit 3: the checksum is set to match the message.
+
+  Note: this is for the host simulation in host/sim. It will not work on the
+  ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_sim.h"
+#include "esp_dmx.h"
+#include "esp_rdm.h"
+#include "esp_rdm_client.h"
+#include "esp_rdm_virtual.h"
+#include "rdmsensors.h"
+
+#define FUZZ_PORT DMX_NUM_1
+#define FUZZ_VIRTUAL_UID 0x05e000000001
+
+enum fuzz_fixup_t {
+  FUZZ_FIXUP_PORT_UID = 1 << 0,
+  FUZZ_FIXUP_VIRTUAL_UID = 1 << 1,
+  FUZZ_FIXUP_MESSAGE_LEN = 1 << 2,
+  FUZZ_FIXUP_CHECKSUM = 1 << 3,
+};
+
+typedef struct fuzz_request_t {
+  const uint8_t *data;
+  size_t size;
+} fuzz_request_t;
+
+static const rdm_client_personality_t virtual_personalities[] = {
+    {.footprint = 1, .description = "Dimmer"},
+    {.footprint = 0, .description = "Off"},
+};
+
+static void fuzz_setup(void *arg) {
+  if (dmx_driver_install(FUZZ_PORT, DMX_DEFAULT_INTR_FLAGS) != ESP_OK) {
+    abort();
+  }
+  rdm_client_init(FUZZ_PORT, 1, 4, "Fuzz", "Default");
+  rdm_client_add_personality(FUZZ_PORT, 8, "Extended");
+  rdm_client_add_personality(FUZZ_PORT, 0, "Off");
+  rdm_client_add_sub_device(FUZZ_PORT, 1, 0x0001, 2, 10);
+  rdm_client_add_sub_device(FUZZ_PORT, 512, 0x0002, 0, 0);
+
+  const sensorDef_t sensor = {.sensorType = 0x00,
+                              .sensorUnit = 0x01,
+                              .range_min = -40,
+                              .range_max = 125,
+                              .normal_min = 0,
+                              .normal_max = 85,
+                              .sensorHistory = 0x03,
+                              .sensorDesc = "Temperature"};
+  rdm_sensor_add(FUZZ_PORT, &sensor);
+
+  const rdm_virtual_config_t config = {
+      .model_id = 0x0003,
+      .start_address = 1,
+      .personalities = virtual_personalities,
+      .personality_count = 2,
+      .device_label = "Virtual",
+      .model_description = "Virtual Dimmer",
+      .software_version_label = "1.0",
+  };
+  if (rdm_virtual_install(FUZZ_PORT, 1) != ESP_OK ||
+      rdm_virtual_add(FUZZ_PORT, FUZZ_VIRTUAL_UID, &config) != ESP_OK) {
+    abort();
+  }
+}
+
+static void fuzz_handle(void *arg) {
+  const fuzz_request_t *const request = arg;
+  rdm_client_handle_rdm_message(FUZZ_PORT, NULL, request->data,
+                                request->size);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  static bool is_setup = false;
+  if (!is_setup) {
+    if (!dmx_sim_run(fuzz_setup, NULL)) {
+      abort();
+    }
+    is_setup = true;
+  }
+
+  if (size < 1 || size - 1 > UINT16_MAX) {
+    return 0;
+  }
+  const uint8_t fixups = data[0];
+  uint8_t *const slots = malloc(size - 1);
+  if (slots == NULL) {
+    return 0;
+  }
+  memcpy(slots, data + 1, size - 1);
+  size -= 1;
+
+  if (size >= RDM_BASE_PACKET_SIZE) {
+    if (fixups & FUZZ_FIXUP_PORT_UID) {
+      uid_to_buf(&slots[3], rdm_get_uid(FUZZ_PORT));
+    } else if (fixups & FUZZ_FIXUP_VIRTUAL_UID) {
+      uid_to_buf(&slots[3], FUZZ_VIRTUAL_UID);
+    }
+    if (fixups & FUZZ_FIXUP_MESSAGE_LEN) {
+      slots[2] = RDM_BASE_PACKET_SIZE - 2 + slots[23];
+    }
+    const size_t message_len = slots[2];
+    if ((fixups & FUZZ_FIXUP_CHECKSUM) && message_len + 2 <= size) {
+      uint16_t checksum = 0;
+      for (size_t i = 0; i < message_len; ++i) {
+        checksum += slots[i];
+      }
+      slots[message_len] = checksum >> 8;
+      slots[message_len + 1] = checksum;
+    }
+  }
+
+  const fuzz_request_t request = {.data = slots, .size = size};
+  if (!dmx_sim_run(fuzz_handle, (void *)&request)) {
+    abort();
+  }
+
+  free(slots);
+  return 0;
+}
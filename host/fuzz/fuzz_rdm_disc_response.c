@@ -0,0 +1,46 @@
+/*
+
+  DISC_UNIQUE_BRANCH Response Decoder Fuzzer
+
+  Decodes arbitrary bytes as a DISC_UNIQUE_BRANCH response with
+  rdm_decode_disc_response(). Responses on the line may collide, so any
+  combination of preamble, delimiter and encoded UID must be handled. The
+  bytes are copied into a buffer the size of the driver buffer, which is how
+  the RDM API calls the decoder. UIDs which are decoded are encoded again with
+  a full preamble, and the program aborts if the UID does not survive the
+  round trip.
+
+  Note: this is for the host build in host/. It will not work on the ESP-IDF
+  or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_types.h"
+#include "private/rdm_encode/functions.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  uint8_t buffer[DMX_MAX_PACKET_SIZE] = {0};
+  memcpy(buffer, data, size < sizeof(buffer) ? size : sizeof(buffer));
+
+  rdm_uid_t uid;
+  if (!rdm_decode_disc_response(buffer, &uid)) {
+    return 0;
+  }
+  if (uid > RDM_BROADCAST_ALL_UID) {
+    abort();
+  }
+
+  uint8_t encoded[DMX_MAX_PACKET_SIZE] = {0};
+  rdm_encode_disc_response(encoded, 7, uid);
+  rdm_uid_t decoded;
+  if (!rdm_decode_disc_response(encoded, &decoded) || decoded != uid) {
+    abort();
+  }
+
+  return 0;
+}
@@ -0,0 +1,53 @@
+/*
+
+  RDM Header Decoder Fuzzer
+
+  Decodes arbitrary bytes as an RDM header with rdm_decode_header(). The bytes
+  are copied into a buffer the size of the driver buffer, which is how the
+  driver and the RDM API call the decoder. Valid headers are encoded again and
+  decoded a second time, and the program aborts if any field of the header
+  does not survive the round trip or the checksum of the encoded header is
+  not valid.
+
+  Note: this is for the host build in host/. It will not work on the ESP-IDF
+  or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_types.h"
+#include "private/rdm_encode/functions.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  uint8_t buffer[DMX_MAX_PACKET_SIZE] = {0};
+  memcpy(buffer, data, size < sizeof(buffer) ? size : sizeof(buffer));
+
+  // Headers with parameter data longer than RDM_MAX_PDL cannot be encoded
+  rdm_header_t header;
+  if (!rdm_decode_header(buffer, &header) || header.pdl > RDM_MAX_PDL) {
+    return 0;
+  }
+
+  // The parameter data is left in place, after the encoded header
+  uint8_t encoded[DMX_MAX_PACKET_SIZE];
+  memcpy(encoded, buffer, sizeof(encoded));
+  rdm_encode_header(encoded, &header);
+  rdm_header_t decoded;
+  if (!rdm_decode_header(encoded, &decoded) || !decoded.checksum_is_valid) {
+    abort();
+  }
+  if (decoded.destination_uid != header.destination_uid ||
+      decoded.source_uid != header.source_uid || decoded.tn != header.tn ||
+      decoded.port_id != header.port_id ||
+      decoded.message_count != header.message_count ||
+      decoded.sub_device != header.sub_device || decoded.cc != header.cc ||
+      decoded.pid != header.pid || decoded.pdl != header.pdl) {
+    abort();
+  }
+
+  return 0;
+}
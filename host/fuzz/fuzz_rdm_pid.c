@@ -0,0 +1,105 @@
+/*
+
+  RDM Parameter Data Decoder Fuzzer
+
+  Decodes arbitrary parameter data with the decoder of a PID. The first two
+  bytes of the input are the PID and the rest is the parameter data, which is
+  copied into a buffer of exactly its length so that reads past the parameter
+  data length are caught by AddressSanitizer. For PIDs in the descriptor
+  table, the request and response formats are decoded with
+  rdm_codec_decode() into a buffer of exactly the number of items which the
+  decoder reports as available. The DISC_MUTE and 16-bit decoders, which the
+  RDM API uses for discovery, ACK_TIMER and NACK_REASON responses, are run for
+  every input with at least two bytes of parameter data. The legacy 8-bit,
+  16-bit, string and DEVICE_INFO decoders in private/rdm_encode are run for
+  every input, and the program aborts if they report more items than the
+  parameter data holds.
+
+  Note: this is for the host build in host/. It will not work on the ESP-IDF
+  or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_types.h"
+#include "esp_rdm_codec.h"
+#include "private/rdm_encode/functions.h"
+
+static void fuzz_format(const rdm_format_t *format, const uint8_t *pd,
+                        size_t pdl) {
+  if (format == NULL) {
+    return;
+  }
+
+  // Strings are sized in bytes and must be null-terminated
+  if (format->host_size == 0) {
+    char label[RDM_MAX_PDL + 1];
+    const size_t len = rdm_codec_decode(format, pd, label, sizeof(label), pdl);
+    if (len > pdl || strlen(label) > len) {
+      abort();
+    }
+    return;
+  }
+
+  const size_t available = rdm_codec_decode(format, pd, NULL, 0, pdl);
+  if (available == 0) {
+    return;
+  }
+  void *const items = malloc(available * format->host_size);
+  if (items == NULL) {
+    return;
+  }
+  if (rdm_codec_decode(format, pd, items, available, pdl) != available) {
+    abort();
+  }
+  free(items);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (size < 2 || size - 2 > RDM_MAX_PDL) {
+    return 0;
+  }
+  const rdm_pid_t pid = (data[0] << 8) | data[1];
+  const size_t pdl = size - 2;
+  uint8_t *const pd = malloc(pdl > 0 ? pdl : 1);
+  if (pd == NULL) {
+    return 0;
+  }
+  memcpy(pd, data + 2, pdl);
+
+  const rdm_pid_desc_t *const desc = rdm_pid_desc_find(pid);
+  if (desc != NULL) {
+    fuzz_format(desc->param, pd, pdl);
+    fuzz_format(desc->data, pd, pdl);
+  }
+  fuzz_format(&rdm_format_raw, pd, pdl);
+
+  // The RDM API checks that there is at least one 16-bit field first
+  if (pdl >= 2) {
+    rdm_disc_mute_t mute;
+    rdm_decode_mute(pd, &mute, 1, pdl);
+    uint32_t value = 0;
+    rdm_decode_16bit(pd, &value, 1, pdl);
+  }
+
+  uint8_t bytes[RDM_MAX_PDL];
+  uint16_t words[RDM_MAX_PDL / 2];
+  char label[RDM_MAX_PDL + 1];
+  rdm_device_info_t device_info;
+  if (rdm_decode_8bit(pd, bytes, RDM_MAX_PDL, pdl) != pdl ||
+      rdm_decode_16bit(pd, words, RDM_MAX_PDL / 2, pdl) != pdl / 2 ||
+      rdm_decode_device_info(pd, &device_info, 1, pdl) > 1) {
+    abort();
+  }
+  const size_t len = rdm_decode_string(pd, label, sizeof(label), pdl);
+  if (len > pdl || strlen(label) > len) {
+    abort();
+  }
+
+  free(pd);
+  return 0;
+}
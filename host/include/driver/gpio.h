@@ -0,0 +1,40 @@
+/**
+ * @file gpio.h
+ * @brief Host replacement for the ESP-IDF GPIO driver. GPIO interrupt handlers
+ * may be added and removed but are never invoked by the simulation.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GPIO_NUM_MAX 40
+#define GPIO_IS_VALID_GPIO(gpio_num) ((gpio_num) >= 0 && (gpio_num) < GPIO_NUM_MAX)
+#define GPIO_IS_VALID_OUTPUT_GPIO(gpio_num) GPIO_IS_VALID_GPIO(gpio_num)
+
+typedef int gpio_num_t;
+typedef void (*gpio_isr_t)(void *arg);
+
+typedef enum {
+  GPIO_INTR_DISABLE,
+  GPIO_INTR_POSEDGE,
+  GPIO_INTR_NEGEDGE,
+  GPIO_INTR_ANYEDGE,
+  GPIO_INTR_LOW_LEVEL,
+  GPIO_INTR_HIGH_LEVEL,
+} gpio_int_type_t;
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags);
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler,
+                               void *args);
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num);
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,12 @@
+/**
+ * @file timer.h
+ * @brief Host replacement for the ESP-IDF timer group types. The simulated
+ * timer is accessed with the dmx_timer_* functions of dmx_sim_backend.h.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+typedef int timer_group_t;
+typedef int timer_idx_t;
+typedef bool (*timer_isr_t)(void *arg);
@@ -0,0 +1,43 @@
+/**
+ * @file uart.h
+ * @brief Host replacement for the ESP-IDF UART driver. Only the interrupt bits
+ * and pin routing which the DMX driver uses are provided.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "hal/uart_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UART_PIN_NO_CHANGE (-1)
+
+// The bits of the UART interrupt registers.
+#define UART_INTR_RXFIFO_FULL (1 << 0)
+#define UART_INTR_TXFIFO_EMPTY (1 << 1)
+#define UART_INTR_PARITY_ERR (1 << 2)
+#define UART_INTR_FRAM_ERR (1 << 3)
+#define UART_INTR_RXFIFO_OVF (1 << 4)
+#define UART_INTR_DSR_CHG (1 << 5)
+#define UART_INTR_CTS_CHG (1 << 6)
+#define UART_INTR_BRK_DET (1 << 7)
+#define UART_INTR_RXFIFO_TOUT (1 << 8)
+#define UART_INTR_SW_XON (1 << 9)
+#define UART_INTR_SW_XOFF (1 << 10)
+#define UART_INTR_GLITCH_DET (1 << 11)
+#define UART_INTR_TX_BRK_DONE (1 << 12)
+#define UART_INTR_TX_BRK_IDLE (1 << 13)
+#define UART_INTR_TX_DONE (1 << 14)
+#define UART_INTR_RS485_PARITY_ERR (1 << 15)
+#define UART_INTR_RS485_FRM_ERR (1 << 16)
+#define UART_INTR_RS485_CLASH (1 << 17)
+#define UART_INTR_CMD_CHAR_DET (1 << 18)
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num,
+                       int rts_io_num, int cts_io_num);
+
+#ifdef __cplusplus
+}
+#endif
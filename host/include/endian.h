@@ -0,0 +1,18 @@
+/**
+ * @file endian.h
+ * @brief Adds the byte swap macros of the newlib endian.h, which the driver
+ * uses, to the endian.h of the host C library.
+ */
+#pragma once
+
+#include_next <endian.h>
+
+#ifndef bswap16
+#define bswap16(x) __builtin_bswap16(x)
+#endif
+#ifndef bswap32
+#define bswap32(x) __builtin_bswap32(x)
+#endif
+#ifndef bswap64
+#define bswap64(x) __builtin_bswap64(x)
+#endif
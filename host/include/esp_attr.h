@@ -0,0 +1,11 @@
+/**
+ * @file esp_attr.h
+ * @brief Host replacement for the ESP-IDF memory placement attributes, which
+ * have no meaning on the host.
+ */
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define FORCE_INLINE_ATTR static inline __attribute__((always_inline))
@@ -0,0 +1,19 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief Host replacement for the ESP-IDF capability-based allocator. All
+ * capabilities are served from the C heap.
+ */
+#pragma once
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_32BIT (1 << 1)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+#define heap_caps_malloc(size, caps) malloc(size)
+#define heap_caps_calloc(n, size, caps) calloc(n, size)
+#define heap_caps_realloc(ptr, size, caps) realloc(ptr, size)
+#define heap_caps_free(ptr) free(ptr)
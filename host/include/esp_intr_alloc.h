@@ -0,0 +1,27 @@
+/**
+ * @file esp_intr_alloc.h
+ * @brief Host replacement for the ESP-IDF interrupt allocator types. Simulated
+ * interrupts are installed with the functions in dmx_sim_backend.h.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "soc/soc_caps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_INTR_FLAG_LEVEL1 (1 << 1)
+#define ESP_INTR_FLAG_LEVEL2 (1 << 2)
+#define ESP_INTR_FLAG_LEVEL3 (1 << 3)
+#define ESP_INTR_FLAG_SHARED (1 << 8)
+#define ESP_INTR_FLAG_EDGE (1 << 9)
+#define ESP_INTR_FLAG_IRAM (1 << 10)
+
+typedef void (*intr_handler_t)(void *arg);
+typedef struct intr_handle_data_t *intr_handle_t;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,38 @@
+/**
+ * @file esp_log.h
+ * @brief Host replacement for the ESP-IDF logging macros. Messages are written
+ * to stderr with the virtual time of the simulation. Define
+ * CONFIG_LOG_MAXIMUM_LEVEL to 3 or 4 to include info or debug messages.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef CONFIG_LOG_MAXIMUM_LEVEL
+#define CONFIG_LOG_MAXIMUM_LEVEL 2
+#endif
+
+int64_t esp_timer_get_time(void);
+
+#define DMX_SIM_LOG(level, letter, tag, format, ...)                         \
+  do {                                                                     \
+    if (level <= CONFIG_LOG_MAXIMUM_LEVEL) {                               \
+      fprintf(stderr, letter " (%lld) %s: " format "\n",                   \
+              (long long)esp_timer_get_time(), tag, ##__VA_ARGS__);        \
+    }                                                                      \
+  } while (0)
+
+#define ESP_LOGE(tag, format, ...) DMX_SIM_LOG(1, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) DMX_SIM_LOG(2, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) DMX_SIM_LOG(3, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) DMX_SIM_LOG(4, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) DMX_SIM_LOG(5, "V", tag, format, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,22 @@
+/**
+ * @file esp_rom_sys.h
+ * @brief Host replacement for the ESP-IDF ROM system functions.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Delays the running task by a number of microseconds of virtual time.
+ * Time only passes in the simulation while every task is blocked, so the task
+ * blocks instead of spinning.
+ */
+void esp_rom_delay_us(uint32_t us);
+
+#ifdef __cplusplus
+}
+#endif
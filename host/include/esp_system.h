@@ -0,0 +1,23 @@
+/**
+ * @file esp_system.h
+ * @brief Host replacement for the ESP-IDF system functions.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Gets the MAC address of the simulated chip, which is set with
+ * dmx_sim_set_mac().
+ */
+esp_err_t esp_efuse_mac_get_default(uint8_t *mac);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,65 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host replacement for the FreeRTOS types and port macros. Tasks run as
+ * threads, but only one runs at a time and the scheduler of the simulation
+ * decides which one, so critical sections need no locking.
+ */
+#pragma once
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef configTICK_RATE_HZ
+#define configTICK_RATE_HZ 1000
+#endif
+#define configMAX_PRIORITIES 25
+#define configMINIMAL_STACK_SIZE 768
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS (pdTRUE)
+#define pdFAIL (pdFALSE)
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) \
+  ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / 1000U))
+#define tskNO_AFFINITY INT_MAX
+#define tskIDLE_PRIORITY ((UBaseType_t)0)
+
+typedef struct {
+  uint32_t owner;
+  uint32_t count;
+} portMUX_TYPE;
+typedef portMUX_TYPE spinlock_t;
+
+#define portMUX_INITIALIZER_UNLOCKED {0, 0}
+#define portMUX_INITIALIZE(mux) ((mux)->owner = 0, (mux)->count = 0)
+
+#define taskENTER_CRITICAL(mux) ((void)(mux))
+#define taskEXIT_CRITICAL(mux) ((void)(mux))
+#define taskENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define taskEXIT_CRITICAL_ISR(mux) ((void)(mux))
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+
+// Interrupt handlers run while no task is running, so there is nothing to
+// yield from.
+#define portYIELD_FROM_ISR(...) ((void)0)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,32 @@
+/**
+ * @file queue.h
+ * @brief Host replacement for the FreeRTOS queue API.
+ */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct dmx_sim_queue_t *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item,
+                      TickType_t ticks_to_wait);
+#define xQueueSendToBack(queue, item, ticks) xQueueSend(queue, item, ticks)
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item,
+                             BaseType_t *woken);
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item);
+BaseType_t xQueueOverwriteFromISR(QueueHandle_t queue, const void *item,
+                                  BaseType_t *woken);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item,
+                         TickType_t ticks_to_wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+BaseType_t xQueueReset(QueueHandle_t queue);
+
+#ifdef __cplusplus
+}
+#endif
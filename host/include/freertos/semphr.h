@@ -0,0 +1,34 @@
+/**
+ * @file semphr.h
+ * @brief Host replacement for the FreeRTOS semaphore and mutex API.
+ */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct dmx_sim_semaphore_t *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count,
+                                           UBaseType_t initial_count);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void);
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore,
+                          TickType_t ticks_to_wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore,
+                                 BaseType_t *woken);
+#define xSemaphoreTakeRecursive(semaphore, ticks) \
+  xSemaphoreTake(semaphore, ticks)
+#define xSemaphoreGiveRecursive(semaphore) xSemaphoreGive(semaphore)
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,60 @@
+/**
+ * @file task.h
+ * @brief Host replacement for the FreeRTOS task and task notification API.
+ */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct dmx_sim_task_t *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+typedef enum {
+  eNoAction = 0,
+  eSetBits,
+  eIncrement,
+  eSetValueWithOverwrite,
+  eSetValueWithoutOverwrite,
+} eNotifyAction;
+
+typedef struct {
+  TickType_t entry_ticks;
+} TimeOut_t;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+                                   uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core_id);
+#define xTaskCreate(fn, name, stack_depth, arg, priority, handle) \
+  xTaskCreatePinnedToCore(fn, name, stack_depth, arg, priority, handle, \
+                          tskNO_AFFINITY)
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void taskYIELD(void);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+const char *pcTaskGetName(TaskHandle_t task);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+
+void vTaskSetTimeOutState(TimeOut_t *timeout);
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *timeout, TickType_t *ticks_to_wait);
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value,
+                       eNotifyAction action);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value,
+                              eNotifyAction action, BaseType_t *woken);
+#define xTaskNotifyGive(task) xTaskNotify(task, 0, eIncrement)
+#define vTaskNotifyGiveFromISR(task, woken) \
+  ((void)xTaskNotifyFromISR(task, 0, eIncrement, woken))
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit,
+                           uint32_t *value, TickType_t ticks_to_wait);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+BaseType_t xTaskNotifyStateClear(TaskHandle_t task);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,8 @@
+/**
+ * @file uart_hal.h
+ * @brief Host replacement for the UART HAL. The simulated UART is accessed
+ * with the dmx_uart_* functions of dmx_sim_backend.h.
+ */
+#pragma once
+
+#include "hal/uart_types.h"
@@ -0,0 +1,9 @@
+/**
+ * @file uart_types.h
+ * @brief Host replacement for the UART HAL types.
+ */
+#pragma once
+
+#include "soc/uart_struct.h"
+
+typedef int uart_port_t;
@@ -0,0 +1,8 @@
+/**
+ * @file soc_caps.h
+ * @brief Host replacement for the capabilities of the chip. The simulated chip
+ * has as many UARTs as the ESP32.
+ */
+#pragma once
+
+#define SOC_UART_NUM 3
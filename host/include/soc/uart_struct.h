@@ -0,0 +1,8 @@
+/**
+ * @file uart_struct.h
+ * @brief Host replacement for the UART register structure. The registers of a
+ * simulated UART are the state of its model in host/sim.
+ */
+#pragma once
+
+typedef struct dmx_sim_uart_t uart_dev_t;
@@ -0,0 +1,134 @@
+#include "dmx_sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_sim_private.h"
+
+// The number of times interrupts may be serviced at one virtual time before
+// the simulation assumes that an interrupt handler cannot clear its interrupt.
+#define DMX_SIM_MAX_INTR_PASSES 1000
+
+typedef struct dmx_sim_event_t {
+  int64_t time;             // The virtual time of the event.
+  uint64_t seq;             // Orders events which are scheduled for one time.
+  dmx_sim_event_cb_t cb;    // The callback of the event.
+  void *context;            // The context passed to the callback.
+  uint32_t arg;             // The argument passed to the callback.
+} dmx_sim_event_t;
+
+pthread_mutex_t dmx_sim_mutex = PTHREAD_MUTEX_INITIALIZER;
+int64_t dmx_sim_now = 0;
+dmx_sim_stats_t dmx_sim_stats = {0};
+
+// A binary min-heap of scheduled events.
+static dmx_sim_event_t *dmx_sim_events = NULL;
+static size_t dmx_sim_num_events = 0;
+static size_t dmx_sim_events_size = 0;
+static uint64_t dmx_sim_event_seq = 0;
+
+static bool dmx_sim_event_is_before(const dmx_sim_event_t *a,
+                                    const dmx_sim_event_t *b) {
+  return a->time < b->time || (a->time == b->time && a->seq < b->seq);
+}
+
+void dmx_sim_schedule(int64_t time, dmx_sim_event_cb_t cb, void *context,
+                      uint32_t arg) {
+  if (dmx_sim_num_events == dmx_sim_events_size) {
+    dmx_sim_events_size = dmx_sim_events_size ? dmx_sim_events_size * 2 : 64;
+    dmx_sim_events = realloc(dmx_sim_events,
+                             dmx_sim_events_size * sizeof(dmx_sim_event_t));
+    if (dmx_sim_events == NULL) {
+      fprintf(stderr, "dmx_sim: event queue malloc error\n");
+      abort();
+    }
+  }
+
+  const dmx_sim_event_t event = {.time = time < dmx_sim_now ? dmx_sim_now : time,
+                                 .seq = dmx_sim_event_seq++,
+                                 .cb = cb,
+                                 .context = context,
+                                 .arg = arg};
+  size_t i = dmx_sim_num_events++;
+  while (i > 0) {
+    const size_t parent = (i - 1) / 2;
+    if (!dmx_sim_event_is_before(&event, &dmx_sim_events[parent])) {
+      break;
+    }
+    dmx_sim_events[i] = dmx_sim_events[parent];
+    i = parent;
+  }
+  dmx_sim_events[i] = event;
+}
+
+static dmx_sim_event_t dmx_sim_pop_event(void) {
+  const dmx_sim_event_t top = dmx_sim_events[0];
+  const dmx_sim_event_t last = dmx_sim_events[--dmx_sim_num_events];
+  size_t i = 0;
+  for (;;) {
+    size_t child = i * 2 + 1;
+    if (child >= dmx_sim_num_events) {
+      break;
+    }
+    if (child + 1 < dmx_sim_num_events &&
+        dmx_sim_event_is_before(&dmx_sim_events[child + 1],
+                                &dmx_sim_events[child])) {
+      ++child;
+    }
+    if (!dmx_sim_event_is_before(&dmx_sim_events[child], &last)) {
+      break;
+    }
+    dmx_sim_events[i] = dmx_sim_events[child];
+    i = child;
+  }
+  dmx_sim_events[i] = last;
+  return top;
+}
+
+int64_t dmx_sim_next_event_time(void) {
+  return dmx_sim_num_events > 0 ? dmx_sim_events[0].time : INT64_MAX;
+}
+
+void dmx_sim_service_interrupts(void) {
+  for (int passes = 0;; ++passes) {
+    if (passes == DMX_SIM_MAX_INTR_PASSES) {
+      fprintf(stderr, "dmx_sim: interrupt storm at %lld ns\n",
+              (long long)dmx_sim_now);
+      abort();
+    }
+    bool serviced = false;
+    for (dmx_port_t dmx_num = 0; dmx_num < DMX_NUM_MAX; ++dmx_num) {
+      serviced |= dmx_sim_uart_service(dmx_num);
+    }
+    if (!serviced) {
+      break;
+    }
+  }
+}
+
+void dmx_sim_run_events(int64_t time) {
+  if (time > dmx_sim_now) {
+    dmx_sim_now = time;
+  }
+  while (dmx_sim_num_events > 0 && dmx_sim_events[0].time <= dmx_sim_now) {
+    const dmx_sim_event_t event = dmx_sim_pop_event();
+    ++dmx_sim_stats.events;
+    event.cb(event.context, event.arg);
+    dmx_sim_service_interrupts();
+  }
+}
+
+int64_t dmx_sim_get_time(void) { return dmx_sim_now; }
+
+int64_t esp_timer_get_time(void) { return dmx_sim_now / 1000; }
+
+int64_t dmx_sim_slot_duration(uint32_t baud_rate) {
+  return (DMX_SIM_BITS_PER_SLOT * 1000000000LL + baud_rate / 2) / baud_rate;
+}
+
+void dmx_sim_get_stats(dmx_sim_stats_t *stats) { *stats = dmx_sim_stats; }
+
+void dmx_sim_reset_stats(void) {
+  memset(&dmx_sim_stats, 0, sizeof(dmx_sim_stats));
+}
@@ -0,0 +1,196 @@
+/**
+ * @file dmx_sim.h
+ * @brief This file declares the simulation in which the DMX driver runs on
+ * Linux. The UARTs and hardware timers of the DMX ports are modeled against a
+ * virtual clock with nanosecond resolution. FreeRTOS tasks run as threads, but
+ * only one runs at a time and virtual time does not pass while a task runs.
+ * When every task is blocked, the clock jumps to the next event, e.g. the end
+ * of a slot on the line or a timer alarm, and the interrupt handlers of the
+ * driver are called as they would be on the target. A simulation is therefore
+ * deterministic and runs much faster than real time.
+ *
+ * The DMX driver and the RDM API must only be called from tasks of the
+ * simulation, starting with the task which is passed to dmx_sim_run().
+ *
+ * The transmitter of each simulated UART emits symbols: a slot when its last
+ * stop bit has been shifted out, or a break when it ends. Symbols may be
+ * forwarded to other UARTs with dmx_sim_connect(), or captured with a
+ * transmit callback. Symbols can be received by any UART with
+ * dmx_sim_receive(), which is how packets are injected into the driver.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The number of bits in a DMX slot: a start bit, eight data bits, and
+ * two stop bits.
+ */
+#define DMX_SIM_BITS_PER_SLOT 11
+
+/**
+ * @brief The types of symbols on a simulated DMX line.
+ */
+typedef enum dmx_sim_symbol_type_t {
+  DMX_SIM_SYMBOL_BREAK,  // The line is held low for the duration.
+  DMX_SIM_SYMBOL_SLOT,   // A slot is sent at the baud rate of the duration.
+} dmx_sim_symbol_type_t;
+
+/**
+ * @brief A symbol on a simulated DMX line.
+ */
+typedef struct dmx_sim_symbol_t {
+  int64_t start;         // The virtual time at which the symbol starts, in nanoseconds.
+  int64_t duration;      // The duration of the symbol in nanoseconds.
+  uint8_t type;          // The type of the symbol, a dmx_sim_symbol_type_t.
+  uint8_t value;         // The value of a slot.
+  bool framing_error;    // True if the stop bits of a slot are corrupted.
+} dmx_sim_symbol_t;
+
+/**
+ * @brief Invoked when the transmitter of a simulated UART emits a symbol
+ * while its RTS is low, i.e. while the RS-485 driver is enabled.
+ */
+typedef void (*dmx_sim_tx_cb_t)(dmx_port_t dmx_num,
+                                const dmx_sim_symbol_t *symbol, void *context);
+
+/**
+ * @brief Invoked at a scheduled virtual time, with the same restrictions as
+ * an interrupt handler.
+ */
+typedef void (*dmx_sim_event_cb_t)(void *context, uint32_t arg);
+
+/**
+ * @brief Counters of the work done by the simulation.
+ */
+typedef struct dmx_sim_stats_t {
+  uint64_t uart_isr_calls;    // The number of calls to UART interrupt handlers.
+  uint64_t timer_isr_calls;   // The number of calls to timer interrupt handlers.
+  uint64_t events;            // The number of scheduled events which were run.
+  uint64_t context_switches;  // The number of times a different task was run.
+  uint64_t slots_sent;        // The number of slots sent by all UARTs.
+  uint64_t slots_received;    // The number of slots received by all UARTs.
+  uint64_t slots_overflowed;  // The number of slots lost to full RX FIFOs.
+} dmx_sim_stats_t;
+
+/**
+ * @brief Creates a task which runs the function and runs the simulation until
+ * the function returns. Tasks which were created by the function remain
+ * blocked and resume when this is called again.
+ *
+ * @param main_task The function of the main task.
+ * @param arg The argument passed to the function.
+ * @return true if the function returned, or false if every task became
+ * blocked with nothing scheduled that could wake them.
+ */
+bool dmx_sim_run(TaskFunction_t main_task, void *arg);
+
+/**
+ * @brief Gets the virtual time of the simulation in nanoseconds.
+ */
+int64_t dmx_sim_get_time(void);
+
+/**
+ * @brief Schedules a callback at a virtual time. Callbacks scheduled for the
+ * same time run in the order in which they were scheduled. Must be called from
+ * a task, an interrupt handler, or another scheduled callback.
+ *
+ * @param time The virtual time in nanoseconds. Times in the past run at the
+ * current time.
+ * @param cb The callback.
+ * @param context The context passed to the callback.
+ * @param arg The argument passed to the callback.
+ */
+void dmx_sim_schedule(int64_t time, dmx_sim_event_cb_t cb, void *context,
+                      uint32_t arg);
+
+/**
+ * @brief Gets the duration of a slot in nanoseconds at a baud rate.
+ */
+int64_t dmx_sim_slot_duration(uint32_t baud_rate);
+
+/**
+ * @brief Sets the callback which is invoked when the transmitter of a UART
+ * emits a symbol. This replaces the connection of dmx_sim_connect().
+ *
+ * @param dmx_num The DMX port number.
+ * @param cb The callback, or NULL to discard symbols.
+ * @param context The context passed to the callback.
+ */
+void dmx_sim_set_tx_cb(dmx_port_t dmx_num, dmx_sim_tx_cb_t cb, void *context);
+
+/**
+ * @brief Receives a symbol on a UART. The symbol takes effect at its end, and
+ * only if RTS of the UART is high at that time, i.e. it is receiving.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] symbol A pointer to the symbol, which is copied.
+ */
+void dmx_sim_receive(dmx_port_t dmx_num, const dmx_sim_symbol_t *symbol);
+
+/**
+ * @brief Receives a DMX or RDM packet on a UART at the baud rate of the UART.
+ *
+ * @param dmx_num The DMX port number.
+ * @param start The virtual time at which the packet starts, in nanoseconds.
+ * @param[in] data The slots of the packet.
+ * @param size The number of slots.
+ * @param break_len The length of the DMX break in microseconds, or 0 for a
+ * packet without a break, e.g. a DISC_UNIQUE_BRANCH response.
+ * @param mab_len The length of the mark-after-break in microseconds.
+ * @return The virtual time at which the last slot ends.
+ */
+int64_t dmx_sim_receive_packet(dmx_port_t dmx_num, int64_t start,
+                               const void *data, size_t size,
+                               uint32_t break_len, uint32_t mab_len);
+
+/**
+ * @brief Connects the transmitter of each of two UARTs to the receiver of the
+ * other, as two half-duplex transceivers on one line.
+ *
+ * @param a The first DMX port number.
+ * @param b The second DMX port number.
+ */
+void dmx_sim_connect(dmx_port_t a, dmx_port_t b);
+
+/**
+ * @brief Wires a GPIO to the receive line of a UART, as the sniffer pin of the
+ * DMX driver is wired on a board. The interrupt handler of the GPIO is called
+ * on each edge of the symbols which the UART receives after they are wired.
+ * The edges of a symbol which started before it was received, such as a DMX
+ * break of a simulated UART, which is only known when it ends, are not seen.
+ *
+ * @param dmx_num The DMX port of the UART.
+ * @param gpio_num The GPIO, or 0 to unwire the line.
+ */
+void dmx_sim_connect_gpio(dmx_port_t dmx_num, int gpio_num);
+
+/**
+ * @brief Sets the MAC address which esp_efuse_mac_get_default() reports, from
+ * which the default RDM UID is derived.
+ */
+void dmx_sim_set_mac(const uint8_t mac[6]);
+
+/**
+ * @brief Copies the counters of the simulation.
+ */
+void dmx_sim_get_stats(dmx_sim_stats_t *stats);
+
+/**
+ * @brief Resets the counters of the simulation.
+ */
+void dmx_sim_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,78 @@
+/**
+ * @file dmx_sim_backend.h
+ * @brief This file declares the simulated hardware backend of the DMX driver,
+ * which private/dmx_backend.h includes when CONFIG_DMX_BACKEND_SIM is defined.
+ * The functions have the signatures of the UART HAL and the timer helpers of
+ * the ESP-IDF backend, and operate on the models in dmx_sim_uart.c and
+ * dmx_sim_timer.c.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "driver/timer.h"
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_intr_alloc.h"
+#include "private/driver.h"
+#include "soc/uart_struct.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* UART HAL */
+void dmx_uart_init(uart_dev_t *uart);
+uint32_t dmx_uart_get_baud_rate(uart_dev_t *uart);
+void dmx_uart_set_baud_rate(uart_dev_t *uart, uint32_t baud_rate);
+void dmx_uart_set_rxfifo_full(uart_dev_t *uart, uint8_t threshold);
+void dmx_uart_set_txfifo_empty(uart_dev_t *uart, uint8_t threshold);
+uint32_t dmx_uart_get_interrupt_status(uart_dev_t *uart);
+void dmx_uart_enable_interrupt(uart_dev_t *uart, uint32_t mask);
+void dmx_uart_disable_interrupt(uart_dev_t *uart, uint32_t mask);
+void dmx_uart_clear_interrupt(uart_dev_t *uart, uint32_t mask);
+uint32_t dmx_uart_get_rxfifo_len(uart_dev_t *uart);
+void dmx_uart_read_rxfifo(uart_dev_t *uart, uint8_t *buf, int *size);
+void dmx_uart_rxfifo_reset(uart_dev_t *uart);
+uint32_t dmx_uart_get_txfifo_len(uart_dev_t *uart);
+void dmx_uart_write_txfifo(uart_dev_t *uart, const void *buf, size_t *size);
+void dmx_uart_txfifo_reset(uart_dev_t *uart);
+int dmx_uart_get_rts(uart_dev_t *uart);
+void dmx_uart_set_rts(uart_dev_t *uart, int set);
+void dmx_uart_invert_tx(uart_dev_t *uart, uint32_t invert);
+int dmx_uart_get_rx_level(uart_dev_t *uart);
+
+/* UART peripheral */
+uart_dev_t *dmx_uart_get_dev(dmx_port_t dmx_num);
+void dmx_uart_module_enable(dmx_port_t dmx_num, uart_dev_t *uart);
+void dmx_uart_module_disable(dmx_port_t dmx_num);
+esp_err_t dmx_uart_isr_install(dmx_driver_t *driver, int intr_flags,
+                               intr_handler_t isr);
+void dmx_uart_isr_uninstall(dmx_driver_t *driver);
+esp_err_t dmx_uart_set_pin(dmx_port_t dmx_num, int tx_pin, int rx_pin,
+                           int rts_pin);
+
+/* Hardware timer */
+void dmx_timer_init(dmx_driver_t *driver, timer_isr_t isr, int intr_flags);
+void dmx_timer_deinit(dmx_driver_t *driver);
+void dmx_timer_start(dmx_driver_t *driver, uint64_t counter, uint64_t alarm);
+void dmx_timer_pause(dmx_driver_t *driver);
+void dmx_timer_pause_in_isr(dmx_driver_t *driver);
+void dmx_timer_set_alarm_in_isr(dmx_driver_t *driver, uint64_t alarm);
+uint64_t dmx_timer_get_counter_in_isr(dmx_driver_t *driver);
+void dmx_timer_resume_in_isr(dmx_driver_t *driver);
+
+/* CPU */
+// Returns nanoseconds of the host clock, since the virtual clock does not
+// advance while an interrupt handler runs.
+uint32_t dmx_cpu_get_cycle_count(void);
+// Returns the virtual time in cycles of a 240MHz CPU, so that traces of the
+// simulation have the same timeline as traces of the target.
+uint32_t dmx_cpu_get_trace_cycle_count(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,625 @@
+#include "dmx_sim_bus.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_private.h"
+
+#define DMX_SIM_BUS_NO_ENTRY UINT32_MAX
+
+// A symbol which is driven onto the line by one or more nodes.
+typedef struct dmx_sim_bus_entry_t {
+  dmx_sim_symbol_t symbol;  // The symbol, with the OR of the colliding values.
+  uint32_t num_drivers;     // The number of nodes which drive the symbol.
+  uint32_t ports;           // A mask of the DMX ports which drive the symbol.
+  bool is_resolved;         // True once received or merged into another symbol.
+  uint32_t active_pos;      // The position of the entry in the active list.
+  uint32_t next;            // The next entry in its hash bucket or the free list.
+} dmx_sim_bus_entry_t;
+
+typedef struct dmx_sim_bus_responder_t {
+  rdm_uid_t uid;
+  bool is_muted;
+} dmx_sim_bus_responder_t;
+
+struct dmx_sim_bus_t {
+  dmx_sim_bus_config_t config;
+  uint64_t rng;             // The state of the random number generator.
+  uint32_t ports;           // A mask of the attached DMX ports.
+  uint32_t num_pending;     // The number of scheduled events of the line.
+  dmx_sim_bus_stats_t stats;
+
+  // Symbols which have not been received yet, by index into entries. Slots
+  // which may still be merged are hashed by their start and duration.
+  dmx_sim_bus_entry_t *entries;
+  uint32_t entries_size;
+  uint32_t free_entry;
+  uint32_t *active;
+  uint32_t num_active;
+  uint32_t *buckets;
+
+  // The virtual responders, in ascending order of UID
+  dmx_sim_bus_responder_t *responders;
+  size_t num_responders;
+  size_t responders_size;
+
+  // The packet which the virtual responders are receiving
+  bool is_receiving;
+  size_t rx_size;
+  uint8_t rx_buffer[RDM_BASE_PACKET_SIZE + RDM_MAX_PDL];
+};
+
+static void *dmx_sim_bus_realloc(void *ptr, size_t size) {
+  void *const new_ptr = realloc(ptr, size);
+  if (new_ptr == NULL) {
+    fprintf(stderr, "dmx_sim: bus malloc error\n");
+    abort();
+  }
+  return new_ptr;
+}
+
+// SplitMix64, which is fast and passes BigCrush from any seed.
+static uint64_t dmx_sim_bus_rand(dmx_sim_bus_t *bus) {
+  uint64_t z = (bus->rng += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static uint64_t dmx_sim_bus_rand_range(dmx_sim_bus_t *bus, uint64_t min,
+                                       uint64_t max) {
+  return max > min ? min + dmx_sim_bus_rand(bus) % (max - min + 1) : min;
+}
+
+static rdm_uid_t dmx_sim_bus_get_uid(const uint8_t *buf) {
+  rdm_uid_t uid = 0;
+  for (int i = 0; i < 6; ++i) {
+    uid = uid << 8 | buf[i];
+  }
+  return uid;
+}
+
+static void dmx_sim_bus_put_uid(uint8_t *buf, rdm_uid_t uid) {
+  for (int i = 5; i >= 0; --i) {
+    buf[i] = uid;
+    uid >>= 8;
+  }
+}
+
+static uint16_t dmx_sim_bus_checksum(const uint8_t *data, size_t size) {
+  uint16_t sum = 0;
+  for (size_t i = 0; i < size; ++i) {
+    sum += data[i];
+  }
+  return sum;
+}
+
+/* Symbols on the line */
+
+static void dmx_sim_bus_resolve(void *context, uint32_t index);
+static void dmx_sim_bus_listen_event(void *context, uint32_t arg);
+static void dmx_sim_bus_listen(dmx_sim_bus_t *bus, uint8_t type,
+                               bool framing_error, uint8_t value);
+
+static int64_t dmx_sim_bus_end(const dmx_sim_symbol_t *symbol) {
+  return symbol->start + symbol->duration;
+}
+
+static uint32_t *dmx_sim_bus_bucket(dmx_sim_bus_t *bus, int64_t start,
+                                    int64_t duration) {
+  const uint64_t hash =
+      ((uint64_t)start ^ (uint64_t)duration << 32) * 0x9e3779b97f4a7c15ULL;
+  return &bus->buckets[(hash >> 32) & (bus->entries_size - 1)];
+}
+
+static void dmx_sim_bus_hash(dmx_sim_bus_t *bus, uint32_t index) {
+  dmx_sim_bus_entry_t *const entry = &bus->entries[index];
+  uint32_t *const bucket =
+      dmx_sim_bus_bucket(bus, entry->symbol.start, entry->symbol.duration);
+  entry->next = *bucket;
+  *bucket = index;
+}
+
+// Marks a symbol as received, so that it can no longer be merged.
+static void dmx_sim_bus_set_resolved(dmx_sim_bus_t *bus, uint32_t index) {
+  dmx_sim_bus_entry_t *const entry = &bus->entries[index];
+  entry->is_resolved = true;
+  if (entry->symbol.type != DMX_SIM_SYMBOL_SLOT) {
+    return;
+  }
+  uint32_t *link =
+      dmx_sim_bus_bucket(bus, entry->symbol.start, entry->symbol.duration);
+  while (*link != index) {
+    link = &bus->entries[*link].next;
+  }
+  *link = entry->next;
+}
+
+// Drives a symbol onto the line. Slots which start at the same time as
+// another slot of the same duration are merged immediately, so that a
+// collision of many responders costs as much as a single response.
+static void dmx_sim_bus_drive(dmx_sim_bus_t *bus, uint32_t ports,
+                              const dmx_sim_symbol_t *symbol) {
+  if (symbol->type == DMX_SIM_SYMBOL_SLOT && bus->entries_size > 0) {
+    uint32_t i = *dmx_sim_bus_bucket(bus, symbol->start, symbol->duration);
+    for (; i != DMX_SIM_BUS_NO_ENTRY; i = bus->entries[i].next) {
+      dmx_sim_bus_entry_t *const entry = &bus->entries[i];
+      if (entry->symbol.start == symbol->start &&
+          entry->symbol.duration == symbol->duration) {
+        entry->symbol.value |= symbol->value;
+        entry->symbol.framing_error |= symbol->framing_error;
+        entry->ports |= ports;
+        ++entry->num_drivers;
+        return;
+      }
+    }
+  }
+
+  // Get a free entry, growing the pool and rehashing if needed
+  if (bus->free_entry == DMX_SIM_BUS_NO_ENTRY) {
+    const uint32_t old_size = bus->entries_size;
+    bus->entries_size = old_size ? old_size * 2 : 64;
+    bus->entries = dmx_sim_bus_realloc(
+        bus->entries, bus->entries_size * sizeof(dmx_sim_bus_entry_t));
+    bus->active = dmx_sim_bus_realloc(bus->active,
+                                      bus->entries_size * sizeof(uint32_t));
+    bus->buckets = dmx_sim_bus_realloc(bus->buckets,
+                                       bus->entries_size * sizeof(uint32_t));
+    for (uint32_t i = old_size; i < bus->entries_size; ++i) {
+      bus->entries[i].next =
+          i + 1 < bus->entries_size ? i + 1 : DMX_SIM_BUS_NO_ENTRY;
+    }
+    bus->free_entry = old_size;
+    for (uint32_t i = 0; i < bus->entries_size; ++i) {
+      bus->buckets[i] = DMX_SIM_BUS_NO_ENTRY;
+    }
+    for (uint32_t i = 0; i < bus->num_active; ++i) {
+      const dmx_sim_bus_entry_t *const entry = &bus->entries[bus->active[i]];
+      if (!entry->is_resolved && entry->symbol.type == DMX_SIM_SYMBOL_SLOT) {
+        dmx_sim_bus_hash(bus, bus->active[i]);
+      }
+    }
+  }
+  const uint32_t index = bus->free_entry;
+  dmx_sim_bus_entry_t *const entry = &bus->entries[index];
+  bus->free_entry = entry->next;
+  entry->symbol = *symbol;
+  entry->num_drivers = 1;
+  entry->ports = ports;
+  entry->is_resolved = false;
+  entry->active_pos = bus->num_active;
+  bus->active[bus->num_active++] = index;
+  if (symbol->type == DMX_SIM_SYMBOL_SLOT) {
+    dmx_sim_bus_hash(bus, index);
+  }
+
+  ++bus->num_pending;
+  dmx_sim_schedule(dmx_sim_bus_end(symbol), dmx_sim_bus_resolve, bus, index);
+}
+
+static void dmx_sim_bus_free(dmx_sim_bus_t *bus, uint32_t index) {
+  dmx_sim_bus_entry_t *const entry = &bus->entries[index];
+  const uint32_t last = bus->active[--bus->num_active];
+  bus->active[entry->active_pos] = last;
+  bus->entries[last].active_pos = entry->active_pos;
+  entry->next = bus->free_entry;
+  bus->free_entry = index;
+}
+
+// Corrupts a random bit of a slot.
+static void dmx_sim_bus_add_noise(dmx_sim_bus_t *bus,
+                                  dmx_sim_symbol_t *symbol) {
+  const int bit = dmx_sim_bus_rand(bus) % DMX_SIM_BITS_PER_SLOT;
+  if (bit >= 1 && bit <= 8) {
+    symbol->value ^= 1 << (bit - 1);
+  } else {
+    // The start bit or a stop bit was corrupted
+    symbol->framing_error = true;
+  }
+  ++bus->stats.noise_errors;
+}
+
+// Receives a symbol at its end, merging it with the symbols which overlap it.
+static void dmx_sim_bus_resolve(void *context, uint32_t index) {
+  dmx_sim_bus_t *const bus = context;
+  dmx_sim_bus_entry_t *const entry = &bus->entries[index];
+  --bus->num_pending;
+  if (entry->is_resolved) {
+    // The symbol was received as part of another symbol
+    dmx_sim_bus_free(bus, index);
+    return;
+  }
+  dmx_sim_bus_set_resolved(bus, index);
+
+  dmx_sim_symbol_t symbol = entry->symbol;
+  uint32_t num_drivers = entry->num_drivers;
+  uint32_t ports = entry->ports;
+  int64_t start = symbol.start;
+  int64_t end = dmx_sim_bus_end(&symbol);
+  const int64_t half_bit = symbol.duration / (DMX_SIM_BITS_PER_SLOT * 2);
+  for (uint32_t i = 0; i < bus->num_active; ++i) {
+    const uint32_t other_index = bus->active[i];
+    dmx_sim_bus_entry_t *const other = &bus->entries[other_index];
+    if (other->is_resolved || other->symbol.start >= end ||
+        dmx_sim_bus_end(&other->symbol) <= symbol.start) {
+      continue;
+    }
+    if (symbol.type != other->symbol.type) {
+      // A slot which overlaps a break is corrupted
+      if (symbol.type == DMX_SIM_SYMBOL_SLOT) {
+        symbol.framing_error = true;
+      } else {
+        other->symbol.framing_error = true;
+      }
+      continue;
+    }
+
+    // Colliding symbols of the same type are received as one symbol
+    if (symbol.type == DMX_SIM_SYMBOL_SLOT) {
+      const int64_t skew = other->symbol.start - symbol.start;
+      if (skew > half_bit || skew < -half_bit) {
+        symbol.framing_error = true;
+      }
+      symbol.value |= other->symbol.value;
+      symbol.framing_error |= other->symbol.framing_error;
+    }
+    if (other->symbol.start < start) {
+      start = other->symbol.start;
+    }
+    if (dmx_sim_bus_end(&other->symbol) > end) {
+      end = dmx_sim_bus_end(&other->symbol);
+    }
+    num_drivers += other->num_drivers;
+    ports |= other->ports;
+    dmx_sim_bus_set_resolved(bus, other_index);
+  }
+  symbol.start = start;
+  symbol.duration = end - start;
+  dmx_sim_bus_free(bus, index);
+
+  if (num_drivers > 1) {
+    ++bus->stats.collisions;
+  }
+  if (symbol.type == DMX_SIM_SYMBOL_SLOT) {
+    ++bus->stats.slots;
+    if (bus->config.noise_ppm > 0 &&
+        dmx_sim_bus_rand(bus) % 1000000 < bus->config.noise_ppm) {
+      dmx_sim_bus_add_noise(bus, &symbol);
+    }
+  } else {
+    ++bus->stats.breaks;
+  }
+
+  // Nodes do not receive the symbols which they drive
+  for (dmx_port_t dmx_num = 0; dmx_num < DMX_NUM_MAX; ++dmx_num) {
+    if ((bus->ports & ~ports) & (1 << dmx_num)) {
+      dmx_sim_receive(dmx_num, &symbol);
+    }
+  }
+  if (end > dmx_sim_now) {
+    const uint32_t arg = (uint32_t)symbol.type << 16 |
+                         (uint32_t)symbol.framing_error << 8 | symbol.value;
+    ++bus->num_pending;
+    dmx_sim_schedule(end, dmx_sim_bus_listen_event, bus, arg);
+  } else {
+    dmx_sim_bus_listen(bus, symbol.type, symbol.framing_error, symbol.value);
+  }
+}
+
+static void dmx_sim_bus_port_tx(dmx_port_t dmx_num,
+                                const dmx_sim_symbol_t *symbol,
+                                void *context) {
+  dmx_sim_bus_drive(context, 1 << dmx_num, symbol);
+}
+
+/* Virtual responders */
+
+// Sends a packet from a virtual responder starting at a virtual time.
+static void dmx_sim_bus_send(dmx_sim_bus_t *bus, int64_t start,
+                             bool with_break, const uint8_t *data,
+                             size_t size) {
+  dmx_sim_symbol_t symbol = {.start = start};
+  if (with_break) {
+    symbol.type = DMX_SIM_SYMBOL_BREAK;
+    symbol.duration = bus->config.break_len_us * 1000LL;
+    dmx_sim_bus_drive(bus, 0, &symbol);
+    symbol.start += symbol.duration + bus->config.mab_len_us * 1000LL;
+  }
+  symbol.type = DMX_SIM_SYMBOL_SLOT;
+  symbol.duration = dmx_sim_slot_duration(bus->config.baud_rate);
+  for (size_t i = 0; i < size; ++i) {
+    symbol.value = data[i];
+    dmx_sim_bus_drive(bus, 0, &symbol);
+    symbol.start += symbol.duration;
+  }
+  ++bus->stats.responses;
+}
+
+static int64_t dmx_sim_bus_turnaround(dmx_sim_bus_t *bus) {
+  return dmx_sim_now +
+         (int64_t)dmx_sim_bus_rand_range(bus, bus->config.turnaround_min_us,
+                                         bus->config.turnaround_max_us) *
+             1000;
+}
+
+static void dmx_sim_bus_send_disc_response(dmx_sim_bus_t *bus,
+                                           rdm_uid_t uid) {
+  uint8_t response[24];
+  memset(response, RDM_PREAMBLE, 7);
+  response[7] = RDM_DELIMITER;
+  uint8_t uid_buf[6];
+  dmx_sim_bus_put_uid(uid_buf, uid);
+  uint16_t checksum = 0;
+  for (int i = 0; i < 6; ++i) {
+    response[8 + i * 2] = uid_buf[i] | 0xaa;
+    response[9 + i * 2] = uid_buf[i] | 0x55;
+    checksum += response[8 + i * 2] + response[9 + i * 2];
+  }
+  response[20] = (checksum >> 8) | 0xaa;
+  response[21] = (checksum >> 8) | 0x55;
+  response[22] = (checksum & 0xff) | 0xaa;
+  response[23] = (checksum & 0xff) | 0x55;
+  dmx_sim_bus_send(bus, dmx_sim_bus_turnaround(bus), false, response,
+                   sizeof(response));
+}
+
+static void dmx_sim_bus_send_response(dmx_sim_bus_t *bus, rdm_uid_t uid,
+                                      const uint8_t *request,
+                                      uint8_t response_type, const void *pd,
+                                      uint8_t pdl) {
+  uint8_t response[RDM_BASE_PACKET_SIZE + RDM_MAX_PDL];
+  response[0] = RDM_SC;
+  response[1] = RDM_SUB_SC;
+  response[2] = RDM_BASE_PACKET_SIZE - 2 + pdl;
+  memcpy(&response[3], &request[9], 6);  // Destination is the controller
+  dmx_sim_bus_put_uid(&response[9], uid);
+  response[15] = request[15];  // Transaction number
+  response[16] = response_type;
+  response[17] = 0;                           // Message count
+  memcpy(&response[18], &request[18], 2);     // Sub-device
+  response[20] = request[20] + 1;             // Command class response
+  memcpy(&response[21], &request[21], 2);     // PID
+  response[23] = pdl;
+  memcpy(&response[24], pd, pdl);
+  const uint16_t checksum = dmx_sim_bus_checksum(response, response[2]);
+  response[response[2]] = checksum >> 8;
+  response[response[2] + 1] = checksum & 0xff;
+  dmx_sim_bus_send(bus, dmx_sim_bus_turnaround(bus), true, response,
+                   response[2] + 2);
+}
+
+// Returns the index of the first responder with a UID not less than uid.
+static size_t dmx_sim_bus_lower_bound(const dmx_sim_bus_t *bus, rdm_uid_t uid) {
+  size_t low = 0;
+  size_t high = bus->num_responders;
+  while (low < high) {
+    const size_t mid = low + (high - low) / 2;
+    if (bus->responders[mid].uid < uid) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+static void dmx_sim_bus_handle_request(dmx_sim_bus_t *bus,
+                                       const uint8_t *request) {
+  const uint8_t message_len = request[2];
+  const uint8_t cc = request[20];
+  const uint16_t pid = request[21] << 8 | request[22];
+  const uint8_t pdl = request[23];
+  if (message_len < RDM_BASE_PACKET_SIZE - 2 ||
+      pdl != message_len - (RDM_BASE_PACKET_SIZE - 2) ||
+      dmx_sim_bus_checksum(request, message_len) !=
+          (request[message_len] << 8 | request[message_len + 1])) {
+    return;
+  }
+  if (cc != RDM_CC_DISC_COMMAND && cc != RDM_CC_GET_COMMAND &&
+      cc != RDM_CC_SET_COMMAND) {
+    return;  // Responses of other nodes
+  }
+  ++bus->stats.requests;
+
+  const rdm_uid_t dest = dmx_sim_bus_get_uid(&request[3]);
+  const bool is_broadcast = (uint32_t)dest == 0xffffffff;
+  size_t first = 0;
+  size_t last = 0;
+  if (!is_broadcast) {
+    first = dmx_sim_bus_lower_bound(bus, dest);
+    last = first < bus->num_responders && bus->responders[first].uid == dest
+               ? first + 1
+               : first;
+  } else if (dest >> 32 == 0xffff) {
+    last = bus->num_responders;
+  } else {
+    first = dmx_sim_bus_lower_bound(bus, dest & 0xffff00000000);
+    last = dmx_sim_bus_lower_bound(bus, dest + 1);
+  }
+
+  if (cc == RDM_CC_DISC_COMMAND && pid == RDM_PID_DISC_UNIQUE_BRANCH) {
+    ++bus->stats.disc_unique_branch;
+    if (pdl != 12) {
+      return;
+    }
+    const rdm_uid_t lower = dmx_sim_bus_get_uid(&request[24]);
+    const rdm_uid_t upper = dmx_sim_bus_get_uid(&request[30]);
+    for (size_t i = dmx_sim_bus_lower_bound(bus, lower);
+         i < bus->num_responders && bus->responders[i].uid <= upper; ++i) {
+      if (!bus->responders[i].is_muted) {
+        dmx_sim_bus_send_disc_response(bus, bus->responders[i].uid);
+      }
+    }
+  } else if (cc == RDM_CC_DISC_COMMAND && (pid == RDM_PID_DISC_MUTE ||
+                                           pid == RDM_PID_DISC_UN_MUTE)) {
+    const uint8_t control_field[2] = {0, 0};
+    for (size_t i = first; i < last; ++i) {
+      bus->responders[i].is_muted = pid == RDM_PID_DISC_MUTE;
+      if (!is_broadcast) {
+        dmx_sim_bus_send_response(bus, bus->responders[i].uid, request,
+                                  RDM_RESPONSE_TYPE_ACK, control_field,
+                                  sizeof(control_field));
+      }
+    }
+  } else if (!is_broadcast && first < last) {
+    const uint8_t nack_reason[2] = {RDM_NR_UNKNOWN_PID >> 8,
+                                    RDM_NR_UNKNOWN_PID & 0xff};
+    dmx_sim_bus_send_response(bus, dest, request,
+                              RDM_RESPONSE_TYPE_NACK_REASON, nack_reason,
+                              sizeof(nack_reason));
+  }
+}
+
+// Receives a symbol for the virtual responders.
+static void dmx_sim_bus_listen(dmx_sim_bus_t *bus, uint8_t type,
+                               bool framing_error, uint8_t value) {
+  if (type == DMX_SIM_SYMBOL_BREAK) {
+    bus->is_receiving = true;
+    bus->rx_size = 0;
+    return;
+  } else if (!bus->is_receiving) {
+    return;
+  } else if (framing_error) {
+    bus->is_receiving = false;
+    return;
+  }
+
+  bus->rx_buffer[bus->rx_size++] = value;
+  if ((bus->rx_size == 1 && value != RDM_SC) ||
+      (bus->rx_size == 2 && value != RDM_SUB_SC)) {
+    bus->is_receiving = false;  // Not an RDM packet
+  } else if (bus->rx_size >= 3 &&
+             (bus->rx_size == (size_t)bus->rx_buffer[2] + 2 ||
+              bus->rx_size == sizeof(bus->rx_buffer))) {
+    bus->is_receiving = false;
+    dmx_sim_bus_handle_request(bus, bus->rx_buffer);
+  }
+}
+
+static void dmx_sim_bus_listen_event(void *context, uint32_t arg) {
+  dmx_sim_bus_t *const bus = context;
+  --bus->num_pending;
+  dmx_sim_bus_listen(bus, arg >> 16, (arg >> 8) & 1, arg & 0xff);
+}
+
+/* Public API */
+
+dmx_sim_bus_t *dmx_sim_bus_create(const dmx_sim_bus_config_t *config) {
+  const dmx_sim_bus_config_t default_config = DMX_SIM_BUS_CONFIG_DEFAULT;
+  if (config == NULL) {
+    config = &default_config;
+  }
+  if (config->baud_rate == 0 ||
+      config->turnaround_min_us > config->turnaround_max_us) {
+    return NULL;
+  }
+  dmx_sim_bus_t *const bus = calloc(1, sizeof(dmx_sim_bus_t));
+  if (bus == NULL) {
+    return NULL;
+  }
+  bus->config = *config;
+  bus->rng = config->seed;
+  bus->free_entry = DMX_SIM_BUS_NO_ENTRY;
+  return bus;
+}
+
+void dmx_sim_bus_delete(dmx_sim_bus_t *bus) {
+  if (bus->num_pending > 0) {
+    fprintf(stderr, "dmx_sim: bus deleted with %u symbols in flight\n",
+            bus->num_pending);
+    abort();
+  }
+  for (dmx_port_t dmx_num = 0; dmx_num < DMX_NUM_MAX; ++dmx_num) {
+    if (bus->ports & (1 << dmx_num)) {
+      dmx_sim_set_tx_cb(dmx_num, NULL, NULL);
+    }
+  }
+  free(bus->entries);
+  free(bus->active);
+  free(bus->buckets);
+  free(bus->responders);
+  free(bus);
+}
+
+esp_err_t dmx_sim_bus_attach(dmx_sim_bus_t *bus, dmx_port_t dmx_num) {
+  if (bus == NULL || dmx_num >= DMX_NUM_MAX) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  bus->ports |= 1 << dmx_num;
+  dmx_sim_set_tx_cb(dmx_num, dmx_sim_bus_port_tx, bus);
+  return ESP_OK;
+}
+
+esp_err_t dmx_sim_bus_add_responder(dmx_sim_bus_t *bus, rdm_uid_t uid) {
+  if (bus == NULL || uid == 0 || uid > RDM_MAX_UID ||
+      (uint32_t)uid == 0xffffffff || uid >> 32 == 0xffff) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const size_t i = dmx_sim_bus_lower_bound(bus, uid);
+  if (i < bus->num_responders && bus->responders[i].uid == uid) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (bus->num_responders == DMX_SIM_BUS_MAX_RESPONDERS) {
+    return ESP_ERR_NO_MEM;
+  }
+  if (bus->num_responders == bus->responders_size) {
+    const size_t size = bus->responders_size ? bus->responders_size * 2 : 16;
+    dmx_sim_bus_responder_t *const responders =
+        realloc(bus->responders, size * sizeof(dmx_sim_bus_responder_t));
+    if (responders == NULL) {
+      return ESP_ERR_NO_MEM;
+    }
+    bus->responders = responders;
+    bus->responders_size = size;
+  }
+  memmove(&bus->responders[i + 1], &bus->responders[i],
+          (bus->num_responders - i) * sizeof(dmx_sim_bus_responder_t));
+  bus->responders[i].uid = uid;
+  bus->responders[i].is_muted = false;
+  ++bus->num_responders;
+  return ESP_OK;
+}
+
+size_t dmx_sim_bus_add_random_responders(dmx_sim_bus_t *bus,
+                                         uint16_t manufacturer_id,
+                                         size_t count) {
+  if (manufacturer_id == 0xffff) {
+    return 0;  // Broadcast manufacturer ID
+  }
+  size_t num_added = 0;
+  while (num_added < count) {
+    const rdm_uid_t uid = (rdm_uid_t)manufacturer_id << 32 |
+                          (uint32_t)dmx_sim_bus_rand(bus);
+    const esp_err_t err = dmx_sim_bus_add_responder(bus, uid);
+    if (err == ESP_ERR_NO_MEM) {
+      break;
+    } else if (err == ESP_OK) {
+      ++num_added;
+    }
+  }
+  return num_added;
+}
+
+size_t dmx_sim_bus_get_responders(const dmx_sim_bus_t *bus, rdm_uid_t *uids,
+                                  size_t size) {
+  for (size_t i = 0; uids != NULL && i < size && i < bus->num_responders;
+       ++i) {
+    uids[i] = bus->responders[i].uid;
+  }
+  return bus->num_responders;
+}
+
+void dmx_sim_bus_set_noise(dmx_sim_bus_t *bus, uint32_t noise_ppm) {
+  bus->config.noise_ppm = noise_ppm;
+}
+
+void dmx_sim_bus_get_stats(const dmx_sim_bus_t *bus,
+                           dmx_sim_bus_stats_t *stats) {
+  *stats = bus->stats;
+}
+
+void dmx_sim_bus_reset_stats(dmx_sim_bus_t *bus) {
+  memset(&bus->stats, 0, sizeof(bus->stats));
+}
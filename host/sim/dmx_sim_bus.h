@@ -0,0 +1,173 @@
+/**
+ * @file dmx_sim_bus.h
+ * @brief This file declares a simulated half-duplex RS-485 line which is
+ * shared by DMX ports of the simulation and by virtual RDM responders, so that
+ * RDM controllers can be tested against hundreds of devices. Every symbol that
+ * is driven onto the line is received by every other node at the end of the
+ * symbol.
+ *
+ * Symbols which are driven at the same time by several nodes collide. Slots
+ * which start within half a bit of each other are received as the bitwise OR
+ * of their values, which is how simultaneous DISC_UNIQUE_BRANCH responses
+ * appear to a controller. Slots which overlap otherwise are received with a
+ * framing error, as are slots which overlap a break that ends after them.
+ * Noise may be injected to corrupt a random bit of random slots.
+ *
+ * The virtual responders of a bus answer DISC_UNIQUE_BRANCH, DISC_MUTE, and
+ * DISC_UN_MUTE requests, and NACK other requests which are addressed to them
+ * with RDM_NR_UNKNOWN_PID. Each response starts a random turnaround time
+ * after the end of the request. All randomness is drawn from a generator
+ * which is seeded from the bus configuration, so a simulation which uses the
+ * same seed runs identically.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "esp_err.h"
+#include "rdm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The maximum number of virtual responders on a simulated line.
+ */
+#define DMX_SIM_BUS_MAX_RESPONDERS 4096
+
+/**
+ * @brief Configuration of a simulated line.
+ */
+typedef struct dmx_sim_bus_config_t {
+  uint64_t seed;               // Seeds the random number generator of the line.
+  uint32_t baud_rate;          // The baud rate at which virtual responders send.
+  uint32_t turnaround_min_us;  // The minimum time from the end of a request to the start of a response, in microseconds.
+  uint32_t turnaround_max_us;  // The maximum time from the end of a request to the start of a response, in microseconds.
+  uint32_t break_len_us;       // The break length of responses other than DISC_UNIQUE_BRANCH responses, in microseconds.
+  uint32_t mab_len_us;         // The mark-after-break length of responses, in microseconds.
+  uint32_t noise_ppm;          // The probability that a slot on the line is corrupted, in parts per million.
+} dmx_sim_bus_config_t;
+
+/**
+ * @brief The default configuration of a simulated line. Virtual responders
+ * respond after the minimum turnaround time of ANSI-ESTA E1.20, so their
+ * DISC_UNIQUE_BRANCH responses are aligned, and no noise is injected.
+ */
+#define DMX_SIM_BUS_CONFIG_DEFAULT                                          \
+  {                                                                         \
+    .seed = 1, .baud_rate = DMX_BAUD_RATE, .turnaround_min_us = 176,        \
+    .turnaround_max_us = 176, .break_len_us = RDM_BREAK_LEN_US,             \
+    .mab_len_us = RDM_MAB_LEN_US, .noise_ppm = 0                            \
+  }
+
+/**
+ * @brief Counters of the traffic on a simulated line.
+ */
+typedef struct dmx_sim_bus_stats_t {
+  uint64_t slots;               // The number of slots received from the line.
+  uint64_t breaks;              // The number of breaks received from the line.
+  uint64_t collisions;          // The number of slots or breaks which were driven by more than one node.
+  uint64_t noise_errors;        // The number of slots which were corrupted by injected noise.
+  uint64_t requests;            // The number of valid RDM requests seen by the virtual responders.
+  uint64_t disc_unique_branch;  // The number of DISC_UNIQUE_BRANCH requests seen by the virtual responders.
+  uint64_t responses;           // The number of responses sent by the virtual responders.
+} dmx_sim_bus_stats_t;
+
+/**
+ * @brief A simulated line.
+ */
+typedef struct dmx_sim_bus_t dmx_sim_bus_t;
+
+/**
+ * @brief Creates a simulated line without any nodes.
+ *
+ * @param[in] config A pointer to the configuration of the line, or NULL to
+ * use DMX_SIM_BUS_CONFIG_DEFAULT.
+ * @return A pointer to the line, or NULL if there was an argument error or
+ * not enough memory.
+ */
+dmx_sim_bus_t *dmx_sim_bus_create(const dmx_sim_bus_config_t *config);
+
+/**
+ * @brief Detaches the DMX ports from a simulated line and deletes it. The line
+ * must be idle, i.e. no symbols may be in flight on it.
+ *
+ * @param bus A pointer to the line.
+ */
+void dmx_sim_bus_delete(dmx_sim_bus_t *bus);
+
+/**
+ * @brief Connects a DMX port to a simulated line. This replaces the transmit
+ * callback of the port, e.g. the connection of dmx_sim_connect().
+ *
+ * @param bus A pointer to the line.
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there was an argument error.
+ */
+esp_err_t dmx_sim_bus_attach(dmx_sim_bus_t *bus, dmx_port_t dmx_num);
+
+/**
+ * @brief Adds a virtual responder to a simulated line. The responder starts
+ * un-muted.
+ *
+ * @param bus A pointer to the line.
+ * @param uid The UID of the responder.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if the UID is not a valid device UID or is
+ * already on the line.
+ * @retval ESP_ERR_NO_MEM if there are DMX_SIM_BUS_MAX_RESPONDERS on the line
+ * or not enough memory.
+ */
+esp_err_t dmx_sim_bus_add_responder(dmx_sim_bus_t *bus, rdm_uid_t uid);
+
+/**
+ * @brief Adds virtual responders with random device IDs to a simulated line.
+ *
+ * @param bus A pointer to the line.
+ * @param manufacturer_id The manufacturer ID of the UIDs of the responders.
+ * @param count The number of responders to add.
+ * @return The number of responders which were added.
+ */
+size_t dmx_sim_bus_add_random_responders(dmx_sim_bus_t *bus,
+                                         uint16_t manufacturer_id,
+                                         size_t count);
+
+/**
+ * @brief Gets the UIDs of the virtual responders on a simulated line in
+ * ascending order.
+ *
+ * @param bus A pointer to the line.
+ * @param[out] uids An array into which to copy the UIDs, or NULL.
+ * @param size The size of the array.
+ * @return The number of virtual responders on the line.
+ */
+size_t dmx_sim_bus_get_responders(const dmx_sim_bus_t *bus, rdm_uid_t *uids,
+                                  size_t size);
+
+/**
+ * @brief Sets the probability that a slot on a simulated line is corrupted.
+ *
+ * @param bus A pointer to the line.
+ * @param noise_ppm The probability in parts per million.
+ */
+void dmx_sim_bus_set_noise(dmx_sim_bus_t *bus, uint32_t noise_ppm);
+
+/**
+ * @brief Copies the counters of a simulated line.
+ */
+void dmx_sim_bus_get_stats(const dmx_sim_bus_t *bus,
+                           dmx_sim_bus_stats_t *stats);
+
+/**
+ * @brief Resets the counters of a simulated line.
+ */
+void dmx_sim_bus_reset_stats(dmx_sim_bus_t *bus);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_private.h"
+#include "driver/gpio.h"
+#include "driver/uart.h"
+#include "esp_err.h"
+#include "esp_system.h"
+#include "nvs.h"
+
+#define DMX_SIM_NVS_MAX_HANDLES 16
+#define DMX_SIM_NVS_NAME_SIZE 16
+
+typedef struct dmx_sim_nvs_entry_t {
+  char namespace_name[DMX_SIM_NVS_NAME_SIZE];
+  char key[DMX_SIM_NVS_NAME_SIZE];
+  void *value;
+  size_t length;
+  struct dmx_sim_nvs_entry_t *next;
+} dmx_sim_nvs_entry_t;
+
+static uint8_t dmx_sim_mac[6] = {0x24, 0x0a, 0xc4, 0x00, 0x00, 0x01};
+
+static dmx_sim_nvs_entry_t *dmx_sim_nvs_entries = NULL;
+static char dmx_sim_nvs_handles[DMX_SIM_NVS_MAX_HANDLES][DMX_SIM_NVS_NAME_SIZE];
+
+void dmx_sim_set_mac(const uint8_t mac[6]) { memcpy(dmx_sim_mac, mac, 6); }
+
+esp_err_t esp_efuse_mac_get_default(uint8_t *mac) {
+  memcpy(mac, dmx_sim_mac, 6);
+  return ESP_OK;
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+  switch (code) {
+    case ESP_OK:
+      return "ESP_OK";
+    case ESP_FAIL:
+      return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+      return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+      return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+      return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+      return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+      return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+      return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+      return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE:
+      return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC:
+      return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_INVALID_VERSION:
+      return "ESP_ERR_INVALID_VERSION";
+    case ESP_ERR_NOT_FINISHED:
+      return "ESP_ERR_NOT_FINISHED";
+    case ESP_ERR_NVS_NOT_FOUND:
+      return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_INVALID_LENGTH:
+      return "ESP_ERR_NVS_INVALID_LENGTH";
+    default:
+      return "UNKNOWN ERROR";
+  }
+}
+
+void _esp_error_check_failed(esp_err_t rc, const char *file, int line,
+                             const char *function, const char *expression) {
+  fprintf(stderr, "ESP_ERROR_CHECK failed: esp_err_t 0x%x (%s) at %s:%d\n",
+          rc, esp_err_to_name(rc), file, line);
+  fprintf(stderr, "func: %s\nexpression: %s\n", function, expression);
+  abort();
+}
+
+/* GPIO and UART pins */
+
+// The interrupt handler of a GPIO.
+typedef struct dmx_sim_gpio_t {
+  gpio_isr_t isr;              // The interrupt handler, or NULL.
+  void *arg;                   // The argument passed to the interrupt handler.
+  gpio_int_type_t intr_type;   // The edges on which the handler is called.
+} dmx_sim_gpio_t;
+
+static dmx_sim_gpio_t dmx_sim_gpio[GPIO_NUM_MAX];
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags) { return ESP_OK; }
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler,
+                               void *args) {
+  if (!GPIO_IS_VALID_GPIO(gpio_num)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  dmx_sim_gpio[gpio_num].isr = isr_handler;
+  dmx_sim_gpio[gpio_num].arg = args;
+  return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num) {
+  if (!GPIO_IS_VALID_GPIO(gpio_num)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  dmx_sim_gpio[gpio_num].isr = NULL;
+  dmx_sim_gpio[gpio_num].arg = NULL;
+  return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+  if (!GPIO_IS_VALID_GPIO(gpio_num)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  dmx_sim_gpio[gpio_num].intr_type = intr_type;
+  return ESP_OK;
+}
+
+void dmx_sim_gpio_call_isr(int gpio_num, int level) {
+  const dmx_sim_gpio_t *const gpio = &dmx_sim_gpio[gpio_num];
+  if (gpio->isr != NULL &&
+      (gpio->intr_type == GPIO_INTR_ANYEDGE ||
+       gpio->intr_type == (level ? GPIO_INTR_POSEDGE : GPIO_INTR_NEGEDGE))) {
+    gpio->isr(gpio->arg);
+  }
+}
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num,
+                       int rts_io_num, int cts_io_num) {
+  return ESP_OK;
+}
+
+/* Non-volatile storage */
+
+static dmx_sim_nvs_entry_t *dmx_sim_nvs_find(nvs_handle_t handle,
+                                             const char *key) {
+  for (dmx_sim_nvs_entry_t *entry = dmx_sim_nvs_entries; entry != NULL;
+       entry = entry->next) {
+    if (strcmp(entry->namespace_name, dmx_sim_nvs_handles[handle - 1]) == 0 &&
+        strcmp(entry->key, key) == 0) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static bool dmx_sim_nvs_is_open(nvs_handle_t handle) {
+  return handle > 0 && handle <= DMX_SIM_NVS_MAX_HANDLES &&
+         dmx_sim_nvs_handles[handle - 1][0] != '\0';
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode,
+                   nvs_handle_t *out_handle) {
+  if (name == NULL || name[0] == '\0' ||
+      strlen(name) >= DMX_SIM_NVS_NAME_SIZE) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  for (nvs_handle_t i = 0; i < DMX_SIM_NVS_MAX_HANDLES; ++i) {
+    if (dmx_sim_nvs_handles[i][0] == '\0') {
+      strcpy(dmx_sim_nvs_handles[i], name);
+      *out_handle = i + 1;
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_NO_MEM;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value,
+                       size_t *length) {
+  if (!dmx_sim_nvs_is_open(handle)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const dmx_sim_nvs_entry_t *entry = dmx_sim_nvs_find(handle, key);
+  if (entry == NULL) {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+  if (out_value == NULL) {
+    *length = entry->length;
+    return ESP_OK;
+  }
+  if (*length < entry->length) {
+    *length = entry->length;
+    return ESP_ERR_NVS_INVALID_LENGTH;
+  }
+  memcpy(out_value, entry->value, entry->length);
+  *length = entry->length;
+  return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value,
+                       size_t length) {
+  if (!dmx_sim_nvs_is_open(handle) || key == NULL ||
+      strlen(key) >= DMX_SIM_NVS_NAME_SIZE) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  void *copy = malloc(length > 0 ? length : 1);
+  if (copy == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  memcpy(copy, value, length);
+
+  dmx_sim_nvs_entry_t *entry = dmx_sim_nvs_find(handle, key);
+  if (entry == NULL) {
+    entry = calloc(1, sizeof(dmx_sim_nvs_entry_t));
+    if (entry == NULL) {
+      free(copy);
+      return ESP_ERR_NO_MEM;
+    }
+    strcpy(entry->namespace_name, dmx_sim_nvs_handles[handle - 1]);
+    strcpy(entry->key, key);
+    entry->next = dmx_sim_nvs_entries;
+    dmx_sim_nvs_entries = entry;
+  } else {
+    free(entry->value);
+  }
+  entry->value = copy;
+  entry->length = length;
+  return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+  if (!dmx_sim_nvs_is_open(handle)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  for (dmx_sim_nvs_entry_t **entry = &dmx_sim_nvs_entries; *entry != NULL;
+       entry = &(*entry)->next) {
+    if (strcmp((*entry)->namespace_name, dmx_sim_nvs_handles[handle - 1]) ==
+            0 &&
+        strcmp((*entry)->key, key) == 0) {
+      dmx_sim_nvs_entry_t *const erased = *entry;
+      *entry = erased->next;
+      free(erased->value);
+      free(erased);
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+  return dmx_sim_nvs_is_open(handle) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void nvs_close(nvs_handle_t handle) {
+  if (dmx_sim_nvs_is_open(handle)) {
+    dmx_sim_nvs_handles[handle - 1][0] = '\0';
+  }
+}
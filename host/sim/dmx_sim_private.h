@@ -0,0 +1,83 @@
+/**
+ * @file dmx_sim_private.h
+ * @brief This file declares the state which is shared by the parts of the
+ * simulation. Everything here is protected by dmx_sim_mutex, which is held by
+ * the running task, or by the scheduler while no task runs.
+ */
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dmx_sim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern pthread_mutex_t dmx_sim_mutex;
+
+extern int64_t dmx_sim_now;  // The virtual time in nanoseconds.
+
+extern dmx_sim_stats_t dmx_sim_stats;
+
+/**
+ * @brief Gets the virtual time of the next scheduled event, or INT64_MAX if
+ * nothing is scheduled.
+ */
+int64_t dmx_sim_next_event_time(void);
+
+/**
+ * @brief Advances the clock to a time and runs every event which is scheduled
+ * up to it. Pending interrupts are serviced after each event.
+ */
+void dmx_sim_run_events(int64_t time);
+
+/**
+ * @brief Calls the interrupt handlers of UARTs which have a pending enabled
+ * interrupt, until none are pending.
+ */
+void dmx_sim_service_interrupts(void);
+
+/**
+ * @brief Calls the interrupt handler of a UART if it has a pending enabled
+ * interrupt.
+ *
+ * @return true if the interrupt handler was called.
+ */
+bool dmx_sim_uart_service(dmx_port_t dmx_num);
+
+/**
+ * @brief Calls the interrupt handler of a UART, if it has one, regardless of
+ * its interrupts. Used to replay captures.
+ */
+void dmx_sim_uart_call_isr(dmx_port_t dmx_num);
+
+/**
+ * @brief Calls the interrupt handler of a GPIO, if it has one and it is
+ * enabled for an edge to the level.
+ */
+void dmx_sim_gpio_call_isr(int gpio_num, int level);
+
+/**
+ * @brief Reloads the counter of a hardware timer and calls its interrupt
+ * handler, if it has one, regardless of its alarm. Used to replay captures.
+ */
+void dmx_sim_timer_call_isr(dmx_port_t dmx_num);
+
+/**
+ * @brief Returns true while captures are replayed into a DMX port, so that its
+ * UART and timer do not generate interrupts of their own.
+ */
+bool dmx_sim_replay_is_enabled(dmx_port_t dmx_num);
+
+/**
+ * @brief Gets the next pass of the UART interrupt handler call which is being
+ * replayed, or NULL if the call has no more passes.
+ */
+const dmx_isr_capture_t *dmx_sim_replay_next_pass(dmx_port_t dmx_num);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,139 @@
+#include "dmx_sim_replay.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_private.h"
+
+// Scheduled replays are identified by the index of the capture and by the
+// generation of the replay, so that replays scheduled before replay was
+// enabled again are ignored.
+#define DMX_SIM_REPLAY_INDEX_BITS 24
+#define DMX_SIM_REPLAY_MAX_CAPTURES (1 << DMX_SIM_REPLAY_INDEX_BITS)
+
+typedef struct dmx_sim_replay_t {
+  bool is_enabled;
+  dmx_isr_capture_t *captures;  // The captures, with copies of their RX data.
+  size_t num_captures;
+  size_t captures_size;
+  size_t next;                  // The index of the next capture to replay.
+  bool is_in_call;              // True while the UART interrupt handler runs.
+  int64_t call_timestamp;       // The timestamp of the passes of the call.
+  uint8_t generation;           // Incremented each time replay is enabled.
+} dmx_sim_replay_t;
+
+static dmx_sim_replay_t dmx_sim_replay[DMX_NUM_MAX];
+
+static void dmx_sim_replay_free(dmx_sim_replay_t *replay) {
+  for (size_t i = 0; i < replay->num_captures; ++i) {
+    free((void *)replay->captures[i].rx_data);
+  }
+  free(replay->captures);
+  const uint8_t generation = replay->generation;
+  memset(replay, 0, sizeof(*replay));
+  replay->generation = generation + 1;
+}
+
+static void dmx_sim_replay_run(void *context, uint32_t arg) {
+  dmx_sim_replay_t *const replay = context;
+  const dmx_port_t dmx_num = replay - dmx_sim_replay;
+  const uint8_t generation = arg >> DMX_SIM_REPLAY_INDEX_BITS;
+  const size_t index = arg & (DMX_SIM_REPLAY_MAX_CAPTURES - 1);
+  if (!replay->is_enabled || generation != replay->generation ||
+      index != replay->next) {
+    return;  // The capture was a pass of an earlier call, or is stale
+  }
+
+  const dmx_isr_capture_t *const capture = &replay->captures[index];
+  if (capture->source == DMX_ISR_CAPTURE_TIMER) {
+    ++replay->next;
+    dmx_sim_timer_call_isr(dmx_num);
+  } else {
+    replay->is_in_call = true;
+    replay->call_timestamp = capture->timestamp;
+    dmx_sim_uart_call_isr(dmx_num);
+    replay->is_in_call = false;
+  }
+}
+
+bool dmx_sim_replay_is_enabled(dmx_port_t dmx_num) {
+  return dmx_sim_replay[dmx_num].is_enabled;
+}
+
+const dmx_isr_capture_t *dmx_sim_replay_next_pass(dmx_port_t dmx_num) {
+  dmx_sim_replay_t *const replay = &dmx_sim_replay[dmx_num];
+  if (!replay->is_in_call || replay->next == replay->num_captures) {
+    return NULL;
+  }
+  const dmx_isr_capture_t *const capture = &replay->captures[replay->next];
+  if (capture->source != DMX_ISR_CAPTURE_UART ||
+      capture->timestamp != replay->call_timestamp) {
+    return NULL;
+  }
+  ++replay->next;
+  return capture;
+}
+
+esp_err_t dmx_sim_replay_enable(dmx_port_t dmx_num) {
+  if (dmx_num >= DMX_NUM_MAX) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  dmx_sim_replay_free(&dmx_sim_replay[dmx_num]);
+  dmx_sim_replay[dmx_num].is_enabled = true;
+  return ESP_OK;
+}
+
+void dmx_sim_replay_disable(dmx_port_t dmx_num) {
+  if (dmx_num < DMX_NUM_MAX) {
+    dmx_sim_replay_free(&dmx_sim_replay[dmx_num]);
+  }
+}
+
+esp_err_t dmx_sim_replay_add(dmx_port_t dmx_num,
+                             const dmx_isr_capture_t *capture) {
+  if (dmx_num >= DMX_NUM_MAX || capture == NULL ||
+      (capture->rx_read > 0 && capture->rx_data == NULL)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  dmx_sim_replay_t *const replay = &dmx_sim_replay[dmx_num];
+  if (!replay->is_enabled ||
+      (replay->num_captures > 0 &&
+       capture->timestamp <
+           replay->captures[replay->num_captures - 1].timestamp)) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  if (replay->num_captures == DMX_SIM_REPLAY_MAX_CAPTURES) {
+    return ESP_ERR_NO_MEM;
+  } else if (replay->num_captures == replay->captures_size) {
+    const size_t size = replay->captures_size ? replay->captures_size * 2 : 64;
+    dmx_isr_capture_t *const captures =
+        realloc(replay->captures, size * sizeof(dmx_isr_capture_t));
+    if (captures == NULL) {
+      return ESP_ERR_NO_MEM;
+    }
+    replay->captures = captures;
+    replay->captures_size = size;
+  }
+  uint8_t *rx_data = NULL;
+  if (capture->rx_read > 0) {
+    rx_data = malloc(capture->rx_read);
+    if (rx_data == NULL) {
+      return ESP_ERR_NO_MEM;
+    }
+    memcpy(rx_data, capture->rx_data, capture->rx_read);
+  }
+
+  const size_t index = replay->num_captures++;
+  replay->captures[index] = *capture;
+  replay->captures[index].rx_data = rx_data;
+  dmx_sim_schedule(capture->timestamp * 1000, dmx_sim_replay_run, replay,
+                   (uint32_t)replay->generation << DMX_SIM_REPLAY_INDEX_BITS |
+                       index);
+  return ESP_OK;
+}
+
+size_t dmx_sim_replay_get_count(dmx_port_t dmx_num) {
+  return dmx_num < DMX_NUM_MAX ? dmx_sim_replay[dmx_num].next : 0;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file dmx_sim_replay.h
+ * @brief This file declares the replay of interrupt captures into the DMX
+ * driver. While replay is enabled on a DMX port, its simulated UART and timer
+ * no longer generate interrupts. Instead, each capture is replayed at its
+ * timestamp by calling the unmodified interrupt handler of the driver: the
+ * UART interrupt status reads return the captured interrupt flags, one pass
+ * of the interrupt handler loop at a time, and the RX FIFO holds the captured
+ * bytes of each pass. Bytes which the driver discarded on hardware, and were
+ * therefore not captured, are replayed as zeros. Slots written to the TX FIFO
+ * are discarded, since transmit interrupts are replayed from the capture.
+ *
+ * Captures are reported by the driver on hardware or in the simulation with
+ * dmx_set_isr_capture_cb(), so a sequence of interrupts which triggered a bug
+ * can be replayed deterministically on the host.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "dmx_types.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Enables replay on a DMX port. Must be called from a task of the
+ * simulation.
+ *
+ * @param dmx_num The DMX port number.
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_ARG if there was an argument error.
+ */
+esp_err_t dmx_sim_replay_enable(dmx_port_t dmx_num);
+
+/**
+ * @brief Disables replay on a DMX port and discards the captures which have
+ * not been replayed.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_sim_replay_disable(dmx_port_t dmx_num);
+
+/**
+ * @brief Schedules a capture to be replayed at its timestamp. Captures must be
+ * added in the order in which they were captured. Consecutive UART captures
+ * with the same timestamp are replayed as passes of one call to the
+ * interrupt handler. The capture and its RX data are copied.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] capture A pointer to the capture.
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_ARG if there was an argument error.
+ * @return ESP_ERR_INVALID_STATE if replay is not enabled or the capture is
+ * older than the last one.
+ * @return ESP_ERR_NO_MEM if there was not enough memory.
+ */
+esp_err_t dmx_sim_replay_add(dmx_port_t dmx_num,
+                             const dmx_isr_capture_t *capture);
+
+/**
+ * @brief Gets the number of captures of a DMX port which have been replayed.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The number of replayed captures.
+ */
+size_t dmx_sim_replay_get_count(dmx_port_t dmx_num);
+
+#ifdef __cplusplus
+}
+#endif
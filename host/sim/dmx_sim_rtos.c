@@ -0,0 +1,807 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_private.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define DMX_SIM_TICK_NS (1000000000LL / configTICK_RATE_HZ)
+#define DMX_SIM_STACK_SIZE (1024 * 1024)
+#define DMX_SIM_TIMER_TASK_PRIORITY 22
+
+typedef enum dmx_sim_task_state_t {
+  DMX_SIM_TASK_READY,
+  DMX_SIM_TASK_BLOCKED,
+  DMX_SIM_TASK_DELETED,
+} dmx_sim_task_state_t;
+
+struct dmx_sim_task_t {
+  pthread_t thread;
+  pthread_cond_t cond;     // Signaled when the task is chosen to run.
+  TaskFunction_t fn;
+  void *arg;
+  char name[16];
+  UBaseType_t priority;
+  dmx_sim_task_state_t state;
+  uint64_t ready_seq;      // Orders ready tasks of the same priority.
+  const void *blocked_on;  // The object for which the task waits.
+  int64_t deadline;        // The virtual time at which the wait times out, or -1.
+  bool timed_out;          // True if the last wait timed out.
+  uint32_t notify_value;
+  bool notify_pending;
+  bool is_main;            // True for the task of dmx_sim_run().
+};
+
+typedef enum dmx_sim_semaphore_type_t {
+  DMX_SIM_SEMAPHORE_COUNTING,
+  DMX_SIM_SEMAPHORE_MUTEX,
+  DMX_SIM_SEMAPHORE_RECURSIVE_MUTEX,
+} dmx_sim_semaphore_type_t;
+
+struct dmx_sim_semaphore_t {
+  dmx_sim_semaphore_type_t type;
+  UBaseType_t count;
+  UBaseType_t max_count;
+  TaskHandle_t holder;  // The task which holds the mutex.
+  UBaseType_t depth;    // The number of takes of a recursive mutex.
+};
+
+struct dmx_sim_queue_t {
+  uint8_t *items;
+  UBaseType_t length;
+  UBaseType_t item_size;
+  UBaseType_t head;
+  UBaseType_t count;
+  uint8_t receivers;  // Tasks which wait to receive block on this address.
+  uint8_t senders;    // Tasks which wait to send block on this address.
+};
+
+struct esp_timer {
+  esp_timer_cb_t callback;
+  void *arg;
+  uint64_t period;      // The period of a periodic timer, or 0.
+  uint32_t generation;  // Invalidates expirations which were scheduled earlier.
+  bool is_active;
+  bool is_expired;      // True while it waits for the timer task.
+  struct esp_timer *next_expired;
+};
+
+static TaskHandle_t *dmx_sim_tasks = NULL;
+static size_t dmx_sim_num_tasks = 0;
+static TaskHandle_t dmx_sim_current = NULL;  // The task which runs, or NULL.
+static uint64_t dmx_sim_ready_seq = 0;
+
+static pthread_cond_t dmx_sim_done_cond = PTHREAD_COND_INITIALIZER;
+static bool dmx_sim_is_done = false;
+static bool dmx_sim_is_deadlocked = false;
+
+static TaskHandle_t dmx_sim_timer_task = NULL;
+static struct esp_timer *dmx_sim_expired_head = NULL;
+static struct esp_timer *dmx_sim_expired_tail = NULL;
+
+/* Scheduler */
+
+static void dmx_sim_make_ready(TaskHandle_t task) {
+  task->state = DMX_SIM_TASK_READY;
+  task->blocked_on = NULL;
+  task->ready_seq = dmx_sim_ready_seq++;
+}
+
+static TaskHandle_t dmx_sim_highest_ready(void) {
+  TaskHandle_t best = NULL;
+  for (size_t i = 0; i < dmx_sim_num_tasks; ++i) {
+    TaskHandle_t task = dmx_sim_tasks[i];
+    if (task->state == DMX_SIM_TASK_READY &&
+        (best == NULL || task->priority > best->priority ||
+         (task->priority == best->priority &&
+          task->ready_seq < best->ready_seq))) {
+      best = task;
+    }
+  }
+  return best;
+}
+
+// Runs interrupt handlers and advances the clock until a task is ready.
+// Returns NULL if every task is blocked and nothing is scheduled.
+static TaskHandle_t dmx_sim_pick_next(void) {
+  for (;;) {
+    dmx_sim_service_interrupts();
+    TaskHandle_t next = dmx_sim_highest_ready();
+    if (next != NULL) {
+      return next;
+    }
+
+    int64_t time = dmx_sim_next_event_time();
+    for (size_t i = 0; i < dmx_sim_num_tasks; ++i) {
+      const TaskHandle_t task = dmx_sim_tasks[i];
+      if (task->state == DMX_SIM_TASK_BLOCKED && task->deadline >= 0 &&
+          task->deadline < time) {
+        time = task->deadline;
+      }
+    }
+    if (time == INT64_MAX) {
+      return NULL;
+    }
+
+    dmx_sim_run_events(time);
+    for (size_t i = 0; i < dmx_sim_num_tasks; ++i) {
+      const TaskHandle_t task = dmx_sim_tasks[i];
+      if (task->state == DMX_SIM_TASK_BLOCKED && task->deadline >= 0 &&
+          task->deadline <= dmx_sim_now) {
+        dmx_sim_make_ready(task);
+        task->timed_out = true;
+      }
+    }
+  }
+}
+
+// Gives the processor to the next task and waits until the calling task is
+// chosen again. Deleted tasks do not wait.
+static void dmx_sim_switch(void) {
+  const TaskHandle_t self = dmx_sim_current;
+  const TaskHandle_t next = dmx_sim_pick_next();
+  dmx_sim_current = next;
+  if (next == NULL) {
+    fprintf(stderr, "dmx_sim: every task is blocked at %lld ns\n",
+            (long long)dmx_sim_now);
+    dmx_sim_is_deadlocked = true;
+    dmx_sim_is_done = true;
+    pthread_cond_signal(&dmx_sim_done_cond);
+  } else if (next != self) {
+    ++dmx_sim_stats.context_switches;
+    pthread_cond_signal(&next->cond);
+  }
+  if (self->state == DMX_SIM_TASK_DELETED) {
+    return;
+  }
+  while (dmx_sim_current != self) {
+    pthread_cond_wait(&self->cond, &dmx_sim_mutex);
+  }
+}
+
+// Blocks the running task until it is made ready or the deadline passes.
+// Returns false if the wait timed out.
+static bool dmx_sim_block(const void *object, int64_t deadline) {
+  const TaskHandle_t self = dmx_sim_current;
+  if (self == NULL) {
+    return false;
+  }
+  self->state = DMX_SIM_TASK_BLOCKED;
+  self->blocked_on = object;
+  self->deadline = deadline;
+  self->timed_out = false;
+  dmx_sim_switch();
+  return !self->timed_out;
+}
+
+// Lets a ready task of higher priority preempt the running task.
+static void dmx_sim_preempt(void) {
+  const TaskHandle_t self = dmx_sim_current;
+  if (self == NULL) {
+    return;
+  }
+  const TaskHandle_t next = dmx_sim_highest_ready();
+  if (next != NULL && next != self && next->priority > self->priority) {
+    dmx_sim_make_ready(self);
+    dmx_sim_switch();
+  }
+}
+
+// Makes the waiting task of highest priority ready. Returns true if a task
+// was woken.
+static bool dmx_sim_wake_one(const void *object) {
+  TaskHandle_t best = NULL;
+  for (size_t i = 0; i < dmx_sim_num_tasks; ++i) {
+    TaskHandle_t task = dmx_sim_tasks[i];
+    if (task->state == DMX_SIM_TASK_BLOCKED && task->blocked_on == object &&
+        (best == NULL || task->priority > best->priority)) {
+      best = task;
+    }
+  }
+  if (best != NULL) {
+    dmx_sim_make_ready(best);
+  }
+  return best != NULL;
+}
+
+static int64_t dmx_sim_deadline(TickType_t ticks) {
+  if (ticks == portMAX_DELAY) {
+    return -1;
+  }
+  // Timeouts expire on tick boundaries, as they do in FreeRTOS
+  return (dmx_sim_now / DMX_SIM_TICK_NS + ticks) * DMX_SIM_TICK_NS;
+}
+
+static void *dmx_sim_task_entry(void *arg) {
+  const TaskHandle_t self = arg;
+  pthread_mutex_lock(&dmx_sim_mutex);
+  while (dmx_sim_current != self) {
+    pthread_cond_wait(&self->cond, &dmx_sim_mutex);
+  }
+  self->fn(self->arg);
+  vTaskDelete(NULL);
+  return NULL;
+}
+
+bool dmx_sim_run(TaskFunction_t main_task, void *arg) {
+  pthread_mutex_lock(&dmx_sim_mutex);
+  dmx_sim_is_done = false;
+  dmx_sim_is_deadlocked = false;
+
+  TaskHandle_t task;
+  xTaskCreatePinnedToCore(main_task, "main", 0, arg, 1, &task, 0);
+  task->is_main = true;
+
+  dmx_sim_current = dmx_sim_pick_next();
+  if (dmx_sim_current != NULL) {
+    pthread_cond_signal(&dmx_sim_current->cond);
+  }
+  while (!dmx_sim_is_done) {
+    pthread_cond_wait(&dmx_sim_done_cond, &dmx_sim_mutex);
+  }
+  const bool result = !dmx_sim_is_deadlocked;
+  pthread_mutex_unlock(&dmx_sim_mutex);
+  return result;
+}
+
+/* Tasks */
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+                                   uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core_id) {
+  TaskHandle_t task = calloc(1, sizeof(struct dmx_sim_task_t));
+  TaskHandle_t *tasks =
+      realloc(dmx_sim_tasks, (dmx_sim_num_tasks + 1) * sizeof(TaskHandle_t));
+  if (task == NULL || tasks == NULL) {
+    free(task);
+    return pdFAIL;
+  }
+  dmx_sim_tasks = tasks;
+  pthread_cond_init(&task->cond, NULL);
+  task->fn = fn;
+  task->arg = arg;
+  snprintf(task->name, sizeof(task->name), "%s", name != NULL ? name : "");
+  task->priority = priority;
+  task->deadline = -1;
+  dmx_sim_make_ready(task);
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, DMX_SIM_STACK_SIZE);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  const int err = pthread_create(&task->thread, &attr, dmx_sim_task_entry, task);
+  pthread_attr_destroy(&attr);
+  if (err != 0) {
+    pthread_cond_destroy(&task->cond);
+    free(task);
+    return pdFAIL;
+  }
+  dmx_sim_tasks[dmx_sim_num_tasks++] = task;
+
+  if (handle != NULL) {
+    *handle = task;
+  }
+  dmx_sim_preempt();
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (task == NULL) {
+    task = dmx_sim_current;
+  }
+  task->state = DMX_SIM_TASK_DELETED;
+  if (task != dmx_sim_current) {
+    return;  // The thread of the task stays parked
+  }
+
+  if (task->is_main) {
+    // The simulation pauses until it is run again
+    dmx_sim_current = NULL;
+    dmx_sim_is_done = true;
+    pthread_cond_signal(&dmx_sim_done_cond);
+  } else {
+    dmx_sim_switch();
+  }
+  pthread_mutex_unlock(&dmx_sim_mutex);
+  pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks) {
+  if (ticks == 0) {
+    taskYIELD();
+  } else {
+    dmx_sim_block(NULL, dmx_sim_deadline(ticks));
+  }
+}
+
+void esp_rom_delay_us(uint32_t us) {
+  dmx_sim_block(NULL, dmx_sim_now + (int64_t)us * 1000);
+}
+
+void taskYIELD(void) {
+  if (dmx_sim_current != NULL) {
+    dmx_sim_make_ready(dmx_sim_current);
+    dmx_sim_switch();
+  }
+}
+
+TickType_t xTaskGetTickCount(void) {
+  return (TickType_t)(dmx_sim_now / DMX_SIM_TICK_NS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return dmx_sim_current; }
+
+const char *pcTaskGetName(TaskHandle_t task) {
+  task = task != NULL ? task : dmx_sim_current;
+  return task != NULL ? task->name : NULL;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+  task = task != NULL ? task : dmx_sim_current;
+  return task != NULL ? task->priority : 0;
+}
+
+void vTaskSetTimeOutState(TimeOut_t *timeout) {
+  timeout->entry_ticks = xTaskGetTickCount();
+}
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *timeout, TickType_t *ticks_to_wait) {
+  if (*ticks_to_wait == portMAX_DELAY) {
+    return pdFALSE;
+  }
+  const TickType_t now = xTaskGetTickCount();
+  const TickType_t elapsed = now - timeout->entry_ticks;
+  if (elapsed >= *ticks_to_wait) {
+    *ticks_to_wait = 0;
+    return pdTRUE;
+  }
+  *ticks_to_wait -= elapsed;
+  timeout->entry_ticks = now;
+  return pdFALSE;
+}
+
+/* Task notifications */
+
+static BaseType_t dmx_sim_notify(TaskHandle_t task, uint32_t value,
+                                 eNotifyAction action) {
+  switch (action) {
+    case eSetBits:
+      task->notify_value |= value;
+      break;
+    case eIncrement:
+      ++task->notify_value;
+      break;
+    case eSetValueWithOverwrite:
+      task->notify_value = value;
+      break;
+    case eSetValueWithoutOverwrite:
+      if (task->notify_pending) {
+        return pdFAIL;
+      }
+      task->notify_value = value;
+      break;
+    case eNoAction:
+    default:
+      break;
+  }
+  task->notify_pending = true;
+  if (task->state == DMX_SIM_TASK_BLOCKED &&
+      task->blocked_on == &task->notify_pending) {
+    dmx_sim_make_ready(task);
+  }
+  return pdPASS;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value,
+                       eNotifyAction action) {
+  const BaseType_t result = dmx_sim_notify(task, value, action);
+  dmx_sim_preempt();
+  return result;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value,
+                              eNotifyAction action, BaseType_t *woken) {
+  const BaseType_t result = dmx_sim_notify(task, value, action);
+  if (woken != NULL && task->state == DMX_SIM_TASK_READY) {
+    *woken = pdTRUE;
+  }
+  return result;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit,
+                           uint32_t *value, TickType_t ticks_to_wait) {
+  const TaskHandle_t self = dmx_sim_current;
+  if (!self->notify_pending) {
+    self->notify_value &= ~clear_on_entry;
+    if (ticks_to_wait > 0) {
+      dmx_sim_block(&self->notify_pending, dmx_sim_deadline(ticks_to_wait));
+    }
+  }
+  if (value != NULL) {
+    *value = self->notify_value;
+  }
+  if (!self->notify_pending) {
+    return pdFALSE;
+  }
+  self->notify_pending = false;
+  self->notify_value &= ~clear_on_exit;
+  return pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+  const TaskHandle_t self = dmx_sim_current;
+  if (self->notify_value == 0 && ticks_to_wait > 0) {
+    self->notify_pending = false;
+    dmx_sim_block(&self->notify_pending, dmx_sim_deadline(ticks_to_wait));
+  }
+  const uint32_t value = self->notify_value;
+  if (value != 0) {
+    self->notify_value = clear_on_exit ? 0 : value - 1;
+  }
+  self->notify_pending = false;
+  return value;
+}
+
+BaseType_t xTaskNotifyStateClear(TaskHandle_t task) {
+  task = task != NULL ? task : dmx_sim_current;
+  if (task == NULL) {
+    return pdFALSE;
+  }
+  const BaseType_t was_pending = task->notify_pending;
+  task->notify_pending = false;
+  return was_pending;
+}
+
+/* Semaphores */
+
+static SemaphoreHandle_t dmx_sim_semaphore_create(
+    dmx_sim_semaphore_type_t type, UBaseType_t max_count,
+    UBaseType_t initial_count) {
+  SemaphoreHandle_t semaphore = calloc(1, sizeof(struct dmx_sim_semaphore_t));
+  if (semaphore != NULL) {
+    semaphore->type = type;
+    semaphore->max_count = max_count;
+    semaphore->count = initial_count;
+  }
+  return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+  return dmx_sim_semaphore_create(DMX_SIM_SEMAPHORE_COUNTING, 1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count,
+                                           UBaseType_t initial_count) {
+  return dmx_sim_semaphore_create(DMX_SIM_SEMAPHORE_COUNTING, max_count,
+                                  initial_count);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+  return dmx_sim_semaphore_create(DMX_SIM_SEMAPHORE_MUTEX, 1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+  return dmx_sim_semaphore_create(DMX_SIM_SEMAPHORE_RECURSIVE_MUTEX, 1, 1);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) { free(semaphore); }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore,
+                          TickType_t ticks_to_wait) {
+  const TaskHandle_t self = dmx_sim_current;
+  const int64_t deadline = dmx_sim_deadline(ticks_to_wait);
+  for (;;) {
+    if (semaphore->type == DMX_SIM_SEMAPHORE_RECURSIVE_MUTEX &&
+        semaphore->holder == self && self != NULL) {
+      ++semaphore->depth;
+      return pdTRUE;
+    }
+    if (semaphore->count > 0) {
+      --semaphore->count;
+      if (semaphore->type != DMX_SIM_SEMAPHORE_COUNTING) {
+        semaphore->holder = self;
+        semaphore->depth = 1;
+      }
+      return pdTRUE;
+    }
+    if (ticks_to_wait == 0 || !dmx_sim_block(semaphore, deadline)) {
+      return pdFALSE;
+    }
+  }
+}
+
+static BaseType_t dmx_sim_semaphore_give(SemaphoreHandle_t semaphore) {
+  if (semaphore->type != DMX_SIM_SEMAPHORE_COUNTING) {
+    if (semaphore->holder != dmx_sim_current || semaphore->count > 0) {
+      return pdFAIL;
+    }
+    if (--semaphore->depth > 0) {
+      return pdPASS;
+    }
+    semaphore->holder = NULL;
+  } else if (semaphore->count == semaphore->max_count) {
+    return pdFAIL;
+  }
+  ++semaphore->count;
+  dmx_sim_wake_one(semaphore);
+  return pdPASS;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  const BaseType_t result = dmx_sim_semaphore_give(semaphore);
+  dmx_sim_preempt();
+  return result;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore,
+                                 BaseType_t *woken) {
+  const BaseType_t result = dmx_sim_semaphore_give(semaphore);
+  if (woken != NULL && result == pdPASS) {
+    *woken = pdTRUE;
+  }
+  return result;
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore) {
+  return semaphore->count;
+}
+
+/* Queues */
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+  QueueHandle_t queue = calloc(1, sizeof(struct dmx_sim_queue_t));
+  if (queue == NULL) {
+    return NULL;
+  }
+  queue->items = malloc((size_t)length * item_size);
+  if (queue->items == NULL) {
+    free(queue);
+    return NULL;
+  }
+  queue->length = length;
+  queue->item_size = item_size;
+  return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+  if (queue != NULL) {
+    free(queue->items);
+    free(queue);
+  }
+}
+
+static void dmx_sim_queue_write(QueueHandle_t queue, const void *item,
+                                UBaseType_t index) {
+  memcpy(queue->items + (size_t)index * queue->item_size, item,
+         queue->item_size);
+}
+
+static BaseType_t dmx_sim_queue_push(QueueHandle_t queue, const void *item) {
+  if (queue->count == queue->length) {
+    return pdFAIL;
+  }
+  dmx_sim_queue_write(queue, item, (queue->head + queue->count) % queue->length);
+  ++queue->count;
+  dmx_sim_wake_one(&queue->receivers);
+  return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item,
+                      TickType_t ticks_to_wait) {
+  const int64_t deadline = dmx_sim_deadline(ticks_to_wait);
+  while (!dmx_sim_queue_push(queue, item)) {
+    if (ticks_to_wait == 0 || !dmx_sim_block(&queue->senders, deadline)) {
+      return pdFAIL;
+    }
+  }
+  dmx_sim_preempt();
+  return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item,
+                             BaseType_t *woken) {
+  const BaseType_t result = dmx_sim_queue_push(queue, item);
+  if (woken != NULL && result == pdPASS) {
+    *woken = pdTRUE;
+  }
+  return result;
+}
+
+static void dmx_sim_queue_overwrite(QueueHandle_t queue, const void *item) {
+  if (queue->count == 0) {
+    dmx_sim_queue_push(queue, item);
+  } else {
+    // Overwrite is only valid for queues of length 1
+    dmx_sim_queue_write(queue, item, queue->head);
+  }
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item) {
+  dmx_sim_queue_overwrite(queue, item);
+  dmx_sim_preempt();
+  return pdPASS;
+}
+
+BaseType_t xQueueOverwriteFromISR(QueueHandle_t queue, const void *item,
+                                  BaseType_t *woken) {
+  dmx_sim_queue_overwrite(queue, item);
+  if (woken != NULL) {
+    *woken = pdTRUE;
+  }
+  return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item,
+                         TickType_t ticks_to_wait) {
+  const int64_t deadline = dmx_sim_deadline(ticks_to_wait);
+  while (queue->count == 0) {
+    if (ticks_to_wait == 0 || !dmx_sim_block(&queue->receivers, deadline)) {
+      return pdFAIL;
+    }
+  }
+  memcpy(item, queue->items + (size_t)queue->head * queue->item_size,
+         queue->item_size);
+  queue->head = (queue->head + 1) % queue->length;
+  --queue->count;
+  dmx_sim_wake_one(&queue->senders);
+  dmx_sim_preempt();
+  return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  return queue->count;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+  queue->head = 0;
+  queue->count = 0;
+  while (dmx_sim_wake_one(&queue->senders)) {
+    continue;
+  }
+  return pdPASS;
+}
+
+/* High resolution timers */
+
+static void dmx_sim_timer_task_fn(void *arg) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    while (dmx_sim_expired_head != NULL) {
+      struct esp_timer *const timer = dmx_sim_expired_head;
+      dmx_sim_expired_head = timer->next_expired;
+      if (dmx_sim_expired_head == NULL) {
+        dmx_sim_expired_tail = NULL;
+      }
+      timer->is_expired = false;
+      timer->callback(timer->arg);
+    }
+  }
+}
+
+// Removes a timer from the callbacks which wait for the timer task.
+static void dmx_sim_timer_unexpire(struct esp_timer *timer) {
+  if (!timer->is_expired) {
+    return;
+  }
+  struct esp_timer *prev = NULL;
+  for (struct esp_timer *t = dmx_sim_expired_head; t != timer;
+       t = t->next_expired) {
+    prev = t;
+  }
+  if (prev != NULL) {
+    prev->next_expired = timer->next_expired;
+  } else {
+    dmx_sim_expired_head = timer->next_expired;
+  }
+  if (dmx_sim_expired_tail == timer) {
+    dmx_sim_expired_tail = prev;
+  }
+  timer->is_expired = false;
+}
+
+static void dmx_sim_timer_expire(void *context, uint32_t generation) {
+  struct esp_timer *const timer = context;
+  if (generation != timer->generation || !timer->is_active) {
+    return;
+  }
+
+  if (timer->period > 0) {
+    dmx_sim_schedule(dmx_sim_now + (int64_t)timer->period * 1000,
+                     dmx_sim_timer_expire, timer, timer->generation);
+  } else {
+    timer->is_active = false;
+  }
+
+  // Callbacks are dispatched from the timer task, as with ESP_TIMER_TASK
+  if (!timer->is_expired) {
+    timer->is_expired = true;
+    timer->next_expired = NULL;
+    if (dmx_sim_expired_tail != NULL) {
+      dmx_sim_expired_tail->next_expired = timer;
+    } else {
+      dmx_sim_expired_head = timer;
+    }
+    dmx_sim_expired_tail = timer;
+    dmx_sim_notify(dmx_sim_timer_task, 0, eIncrement);
+  }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args,
+                           esp_timer_handle_t *out_handle) {
+  if (create_args == NULL || create_args->callback == NULL ||
+      out_handle == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (dmx_sim_timer_task == NULL &&
+      !xTaskCreate(dmx_sim_timer_task_fn, "esp_timer", 0, NULL,
+                   DMX_SIM_TIMER_TASK_PRIORITY, &dmx_sim_timer_task)) {
+    return ESP_ERR_NO_MEM;
+  }
+  struct esp_timer *timer = calloc(1, sizeof(struct esp_timer));
+  if (timer == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  timer->callback = create_args->callback;
+  timer->arg = create_args->arg;
+  *out_handle = timer;
+  return ESP_OK;
+}
+
+static esp_err_t dmx_sim_timer_start(esp_timer_handle_t timer,
+                                     uint64_t timeout, uint64_t period) {
+  if (timer == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (timer->is_active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->is_active = true;
+  timer->period = period;
+  dmx_sim_schedule(dmx_sim_now + (int64_t)timeout * 1000, dmx_sim_timer_expire,
+                   timer, ++timer->generation);
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+  return dmx_sim_timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+  return dmx_sim_timer_start(timer, period, period);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  if (timer == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!timer->is_active && !timer->is_expired) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->is_active = false;
+  ++timer->generation;
+  dmx_sim_timer_unexpire(timer);
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+  if (timer == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (timer->is_active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  dmx_sim_timer_unexpire(timer);
+  free(timer);
+  return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+  return timer != NULL && timer->is_active;
+}
@@ -0,0 +1,151 @@
+#include <time.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_backend.h"
+#include "dmx_sim_private.h"
+
+// A 1MHz up-counter which reloads to 0 when it reaches its alarm.
+typedef struct dmx_sim_timer_t {
+  timer_isr_t isr;      // The interrupt handler, or NULL.
+  void *isr_arg;        // The argument passed to the interrupt handler.
+  bool is_counting;     // True while the counter is enabled.
+  bool alarm_enabled;   // True while the alarm is enabled.
+  uint64_t counter;     // The counter value at base_time, in microseconds.
+  int64_t base_time;    // The virtual time at which counter was sampled.
+  uint64_t alarm;       // The alarm value in microseconds.
+  uint32_t generation;  // Invalidates alarms which were scheduled earlier.
+} dmx_sim_timer_t;
+
+static dmx_sim_timer_t dmx_sim_timer[DMX_NUM_MAX];
+
+static uint64_t dmx_sim_timer_get_counter(const dmx_sim_timer_t *timer) {
+  if (!timer->is_counting) {
+    return timer->counter;
+  }
+  return timer->counter + (dmx_sim_now - timer->base_time) / 1000;
+}
+
+// Samples the counter so that its state may be changed.
+static void dmx_sim_timer_sample(dmx_sim_timer_t *timer) {
+  if (timer->is_counting) {
+    // Keep the fraction of the current tick so that the counter does not drift
+    const int64_t elapsed = (dmx_sim_now - timer->base_time) / 1000;
+    timer->counter += elapsed;
+    timer->base_time += elapsed * 1000;
+  } else {
+    timer->base_time = dmx_sim_now;
+  }
+}
+
+static void dmx_sim_timer_alarm(void *context, uint32_t arg);
+
+// Schedules the alarm for the current state of the timer. Alarms which were
+// scheduled for an earlier state are ignored when they run.
+static void dmx_sim_timer_reschedule(dmx_sim_timer_t *timer) {
+  ++timer->generation;
+  if (!timer->is_counting || !timer->alarm_enabled) {
+    return;
+  }
+  const uint64_t counter = dmx_sim_timer_get_counter(timer);
+  int64_t time = dmx_sim_now;
+  if (timer->alarm > counter) {
+    time = timer->base_time + (int64_t)(timer->alarm - timer->counter) * 1000;
+  }
+  dmx_sim_schedule(time, dmx_sim_timer_alarm, timer, timer->generation);
+}
+
+static void dmx_sim_timer_alarm(void *context, uint32_t generation) {
+  dmx_sim_timer_t *const timer = context;
+  if (generation != timer->generation || timer->isr == NULL ||
+      dmx_sim_replay_is_enabled(timer - dmx_sim_timer)) {
+    return;
+  }
+
+  // Reload the counter, then let the interrupt handler change the timer
+  timer->counter = 0;
+  timer->base_time = dmx_sim_now;
+  ++dmx_sim_stats.timer_isr_calls;
+  timer->isr(timer->isr_arg);
+  dmx_sim_timer_reschedule(timer);
+}
+
+void dmx_sim_timer_call_isr(dmx_port_t dmx_num) {
+  dmx_sim_timer_t *const timer = &dmx_sim_timer[dmx_num];
+  if (timer->isr == NULL) {
+    return;
+  }
+  timer->counter = 0;
+  timer->base_time = dmx_sim_now;
+  ++dmx_sim_stats.timer_isr_calls;
+  timer->isr(timer->isr_arg);
+  dmx_sim_timer_reschedule(timer);
+}
+
+void dmx_timer_init(dmx_driver_t *driver, timer_isr_t isr, int intr_flags) {
+  dmx_sim_timer_t *const timer = &dmx_sim_timer[driver->dmx_num];
+  timer->isr = isr;
+  timer->isr_arg = driver;
+  timer->is_counting = false;
+  timer->alarm_enabled = true;
+  timer->counter = 0;
+  timer->base_time = dmx_sim_now;
+  timer->alarm = 0;
+  ++timer->generation;
+}
+
+void dmx_timer_deinit(dmx_driver_t *driver) {
+  dmx_sim_timer_t *const timer = &dmx_sim_timer[driver->dmx_num];
+  timer->isr = NULL;
+  timer->is_counting = false;
+  ++timer->generation;
+}
+
+void dmx_timer_start(dmx_driver_t *driver, uint64_t counter, uint64_t alarm) {
+  dmx_sim_timer_t *const timer = &dmx_sim_timer[driver->dmx_num];
+  timer->counter = counter;
+  timer->base_time = dmx_sim_now;
+  timer->alarm = alarm;
+  timer->alarm_enabled = true;
+  timer->is_counting = true;
+  dmx_sim_timer_reschedule(timer);
+}
+
+void dmx_timer_pause(dmx_driver_t *driver) {
+  dmx_timer_pause_in_isr(driver);
+}
+
+void dmx_timer_pause_in_isr(dmx_driver_t *driver) {
+  dmx_sim_timer_t *const timer = &dmx_sim_timer[driver->dmx_num];
+  dmx_sim_timer_sample(timer);
+  timer->is_counting = false;
+  dmx_sim_timer_reschedule(timer);
+}
+
+void dmx_timer_set_alarm_in_isr(dmx_driver_t *driver, uint64_t alarm) {
+  dmx_sim_timer_t *const timer = &dmx_sim_timer[driver->dmx_num];
+  dmx_sim_timer_sample(timer);
+  timer->alarm = alarm;
+  dmx_sim_timer_reschedule(timer);
+}
+
+uint64_t dmx_timer_get_counter_in_isr(dmx_driver_t *driver) {
+  return dmx_sim_timer_get_counter(&dmx_sim_timer[driver->dmx_num]);
+}
+
+void dmx_timer_resume_in_isr(dmx_driver_t *driver) {
+  dmx_sim_timer_t *const timer = &dmx_sim_timer[driver->dmx_num];
+  dmx_sim_timer_sample(timer);
+  timer->alarm_enabled = true;
+  timer->is_counting = true;
+  dmx_sim_timer_reschedule(timer);
+}
+
+uint32_t dmx_cpu_get_cycle_count(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)(now.tv_sec * 1000000000ULL + now.tv_nsec);
+}
+
+uint32_t dmx_cpu_get_trace_cycle_count(void) {
+  return (uint32_t)(dmx_sim_now * 240 / 1000);
+}
@@ -0,0 +1,90 @@
+/*
+
+  DMX Packet Capture Converter
+
+  Converts a packet capture stream, as written by dmx_capture_start(), to CSV
+  or to pcap. Exits with a non-zero status if the stream is truncated or
+  corrupt, after converting the frames before the damage.
+
+  Usage: dmx_capture_convert [-f csv|pcap] [-l linktype] [file]
+
+  The stream is read from the file, or from stdin without one, and converted
+  to CSV by default. pcap files use LINKTYPE_USER0 unless another link type is
+  given, and each record holds the slots of a frame. The number of frames and
+  the number of frames after which frames were dropped are printed to stderr:
+
+    ./build-host/sim_packet_capture | ./build-host/dmx_capture_convert
+
+  Note: this is a host tool. It will not work on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_capture_reader.h"
+
+int main(int argc, char *argv[]) {
+  bool is_pcap = false;
+  uint32_t linktype = DMX_CAPTURE_PCAP_LINKTYPE;
+  const char *path = NULL;
+  bool is_usage_error = false;
+  for (int i = 1; i < argc && !is_usage_error; ++i) {
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+      is_pcap = strcmp(argv[++i], "pcap") == 0;
+      is_usage_error = !is_pcap && strcmp(argv[i], "csv") != 0;
+    } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+      linktype = strtoul(argv[++i], NULL, 0);
+    } else if (argv[i][0] != '-' && path == NULL) {
+      path = argv[i];
+    } else {
+      is_usage_error = true;
+    }
+  }
+  if (is_usage_error) {
+    fprintf(stderr, "Usage: dmx_capture_convert [-f csv|pcap] [-l linktype] "
+                    "[file]\n");
+    return 2;
+  }
+
+  FILE *file = path != NULL ? fopen(path, "rb") : stdin;
+  if (file == NULL) {
+    perror(path);
+    return 1;
+  }
+  dmx_capture_reader_t reader;
+  if (dmx_capture_reader_open(&reader, file) != 0) {
+    fprintf(stderr, "not a DMX packet capture stream\n");
+    return 1;
+  }
+
+  if (is_pcap) {
+    dmx_capture_write_pcap_header(stdout, linktype);
+  } else {
+    dmx_capture_write_csv_header(stdout);
+  }
+  dmx_capture_frame_t frame;
+  int result;
+  while ((result = dmx_capture_reader_next(&reader, &frame)) > 0) {
+    if (is_pcap) {
+      dmx_capture_write_pcap(stdout, &frame);
+    } else {
+      dmx_capture_write_csv(stdout, &reader, &frame);
+    }
+  }
+
+  fprintf(stderr, "%llu frames, frames dropped before %llu of them\n",
+          (unsigned long long)reader.num_frames,
+          (unsigned long long)reader.num_dropped);
+  if (result < 0) {
+    fprintf(stderr, "the stream is truncated or corrupt after frame %llu\n",
+            (unsigned long long)reader.num_frames);
+  }
+  if (file != stdin) {
+    fclose(file);
+  }
+  return result < 0 ? 1 : 0;
+}
@@ -0,0 +1,126 @@
+#include "dmx_capture_reader.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+// The names of the packet types, in the order of dmx_capture_type_t.
+static const char *const type_names[] = {
+    "dmx", "disc", "disc_response", "request", "response", "broadcast"};
+
+// The names of the flags which are written to CSV, in the order of their bits
+// in dmx_capture_flag_t. The direction is written in its own column.
+static const char *const flag_names[] = {NULL, "rx_err", "no_break",
+                                         "truncated", "dropped"};
+
+int dmx_capture_reader_open(dmx_capture_reader_t *reader, FILE *file) {
+  memset(reader, 0, sizeof(*reader));
+  reader->file = file;
+  dmx_capture_stream_header_t *const stream_header = &reader->stream_header;
+  if (fread(stream_header, sizeof(*stream_header), 1, file) != 1 ||
+      memcmp(stream_header->magic, DMX_CAPTURE_MAGIC,
+             sizeof(stream_header->magic)) != 0 ||
+      stream_header->version != DMX_CAPTURE_VERSION ||
+      stream_header->header_size < sizeof(dmx_capture_header_t)) {
+    return -1;
+  }
+  return 0;
+}
+
+int dmx_capture_reader_next(dmx_capture_reader_t *reader,
+                            dmx_capture_frame_t *frame) {
+  FILE *const file = reader->file;
+  const size_t num_read =
+      fread(&frame->header, 1, sizeof(frame->header), file);
+  if (num_read != sizeof(frame->header)) {
+    return num_read == 0 && feof(file) ? 0 : -1;
+  }
+
+  // Skip the fields which were added to the header after this version
+  const size_t header_size = reader->stream_header.header_size;
+  for (size_t i = sizeof(frame->header); i < header_size; ++i) {
+    if (fgetc(file) == EOF) {
+      return -1;
+    }
+  }
+
+  if (frame->header.size < header_size ||
+      frame->header.size - header_size > DMX_MAX_PACKET_SIZE) {
+    return -1;
+  }
+  frame->num_slots = frame->header.size - header_size;
+  if (fread(frame->slots, 1, frame->num_slots, file) != frame->num_slots) {
+    return -1;
+  }
+
+  ++reader->num_frames;
+  if (frame->header.flags & DMX_CAPTURE_FLAG_DROPPED) {
+    ++reader->num_dropped;
+  }
+  return 1;
+}
+
+void dmx_capture_write_csv_header(FILE *file) {
+  fputs("timestamp_us,port,direction,type,size,start_code,break_us,mab_us,"
+        "flags,slots\n",
+        file);
+}
+
+void dmx_capture_write_csv(FILE *file, const dmx_capture_reader_t *reader,
+                           const dmx_capture_frame_t *frame) {
+  const dmx_capture_header_t *const header = &frame->header;
+  const char *const type_name =
+      header->type < sizeof(type_names) / sizeof(type_names[0])
+          ? type_names[header->type]
+          : "unknown";
+  fprintf(file, "%lld,%u,%s,%s,%zu,", (long long)header->timestamp,
+          reader->stream_header.dmx_num,
+          header->flags & DMX_CAPTURE_FLAG_SENT ? "tx" : "rx", type_name,
+          frame->num_slots);
+  if (frame->num_slots > 0) {
+    fprintf(file, "%02x", frame->slots[0]);
+  }
+  fprintf(file, ",%u,%u,", header->break_len, header->mab_len);
+
+  // Flags are separated by '|' so that they stay in one column
+  bool is_first = true;
+  for (size_t i = 0; i < sizeof(flag_names) / sizeof(flag_names[0]); ++i) {
+    if (flag_names[i] != NULL && (header->flags & (1 << i))) {
+      fprintf(file, "%s%s", is_first ? "" : "|", flag_names[i]);
+      is_first = false;
+    }
+  }
+  fputc(',', file);
+  for (size_t i = 0; i < frame->num_slots; ++i) {
+    fprintf(file, "%02x", frame->slots[i]);
+  }
+  fputc('\n', file);
+}
+
+static void write_u32(FILE *file, uint32_t value) {
+  const uint8_t bytes[4] = {value, value >> 8, value >> 16, value >> 24};
+  fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+static void write_u16(FILE *file, uint16_t value) {
+  const uint8_t bytes[2] = {value, value >> 8};
+  fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+void dmx_capture_write_pcap_header(FILE *file, uint32_t linktype) {
+  write_u32(file, 0xa1b2c3d4);  // Magic number with microsecond timestamps
+  write_u16(file, 2);           // Major version
+  write_u16(file, 4);           // Minor version
+  write_u32(file, 0);           // Time zone offset
+  write_u32(file, 0);           // Timestamp accuracy
+  write_u32(file, DMX_MAX_PACKET_SIZE);  // Snapshot length
+  write_u32(file, linktype);
+}
+
+void dmx_capture_write_pcap(FILE *file, const dmx_capture_frame_t *frame) {
+  const int64_t timestamp = frame->header.timestamp;
+  write_u32(file, timestamp / 1000000);
+  write_u32(file, timestamp % 1000000);
+  write_u32(file, frame->num_slots);
+  write_u32(file, frame->num_slots);
+  fwrite(frame->slots, 1, frame->num_slots, file);
+}
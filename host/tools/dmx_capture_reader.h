@@ -0,0 +1,100 @@
+/**
+ * @file dmx_capture_reader.h
+ * @brief This file declares a reader of the packet capture streams which are
+ * written by dmx_capture_start(), and writers which convert the frames of a
+ * stream to CSV and to pcap. The stream is read with the little-endian layout
+ * of dmx_capture_stream_header_t and dmx_capture_header_t, which is the
+ * layout on the ESP32 and on the host.
+ *
+ * Note: this is a host library. It will not work on the ESP-IDF or on Arduino!
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "dmx_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The pcap link type which is written by default: LINKTYPE_USER0. The
+ * packet data of each record is the slots of a frame, starting with the start
+ * code.
+ */
+#define DMX_CAPTURE_PCAP_LINKTYPE 147
+
+/**
+ * @brief A reader of a packet capture stream.
+ */
+typedef struct dmx_capture_reader_t {
+  FILE *file;                                // The file from which the stream is read.
+  dmx_capture_stream_header_t stream_header;  // The header of the stream.
+  uint64_t num_frames;                       // The number of frames which have been read.
+  uint64_t num_dropped;                      // The number of frames which were flagged as dropped before another frame.
+} dmx_capture_reader_t;
+
+/**
+ * @brief A frame of a packet capture stream.
+ */
+typedef struct dmx_capture_frame_t {
+  dmx_capture_header_t header;            // The header of the frame.
+  size_t num_slots;                       // The number of slots in the frame, including the start code.
+  uint8_t slots[DMX_MAX_PACKET_SIZE];     // The slots of the frame.
+} dmx_capture_frame_t;
+
+/**
+ * @brief Reads the header of a packet capture stream.
+ *
+ * @param[out] reader A pointer to the reader to initialize.
+ * @param file The file from which to read the stream.
+ * @return 0 on success, or -1 if the stream does not start with a valid
+ * header of a supported version.
+ */
+int dmx_capture_reader_open(dmx_capture_reader_t *reader, FILE *file);
+
+/**
+ * @brief Reads the next frame of a packet capture stream.
+ *
+ * @param reader A pointer to the reader.
+ * @param[out] frame A pointer to the frame into which to read.
+ * @return 1 if a frame was read, 0 at the end of the stream, or -1 if the
+ * stream is truncated or corrupt.
+ */
+int dmx_capture_reader_next(dmx_capture_reader_t *reader,
+                            dmx_capture_frame_t *frame);
+
+/**
+ * @brief Writes the header line of the CSV format.
+ */
+void dmx_capture_write_csv_header(FILE *file);
+
+/**
+ * @brief Writes a frame as a line of CSV: the timestamp in microseconds, the
+ * DMX port, the direction, the packet type, the number of slots, the start
+ * code, the DMX break and mark-after-break in microseconds, the flags, and the
+ * slots in hex.
+ */
+void dmx_capture_write_csv(FILE *file, const dmx_capture_reader_t *reader,
+                           const dmx_capture_frame_t *frame);
+
+/**
+ * @brief Writes the global header of a pcap file.
+ *
+ * @param file The file to which to write.
+ * @param linktype The link type of the file, e.g. DMX_CAPTURE_PCAP_LINKTYPE.
+ */
+void dmx_capture_write_pcap_header(FILE *file, uint32_t linktype);
+
+/**
+ * @brief Writes a frame as a pcap record. The timestamp of the record is the
+ * timestamp of the frame, which is the time since the capturing device
+ * booted.
+ */
+void dmx_capture_write_pcap(FILE *file, const dmx_capture_frame_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
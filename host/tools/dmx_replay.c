@@ -0,0 +1,365 @@
+/*
+
+  DMX Interrupt Replay
+
+  Replays a capture of the interrupt handlers of a DMX port into the
+  unmodified DMX driver on Linux, calls dmx_receive() and dmx_send() as the
+  application did when the capture was made, and compares their outcomes
+  with the expected ones. Exits with a non-zero status if an outcome differs,
+  so that captures of bugs in the field become deterministic regression
+  tests. The time spent in each branch of the UART interrupt handler is
+  printed when the driver is built with CONFIG_DMX_PROFILE.
+
+  Usage: dmx_replay [-p port] capture
+
+  A capture is a text file with one item per line. Blank lines and text after
+  a '#' are ignored. Times are in microseconds, as returned by
+  esp_timer_get_time(), and hex bytes are written without separators:
+
+    <time> uart <flags> <rx_len> [<rx bytes>]
+      A pass of the UART interrupt handler loop, as reported to the callback
+      of dmx_set_isr_capture_cb(): the interrupt flags in hex, the length of
+      the RX FIFO, and the bytes which were read from it.
+    <time> timer
+      A call to the timer interrupt handler.
+    <time> receive <timeout_ms>
+      A call to dmx_receive() which starts at the time.
+    <time> send <size> [<bytes>]
+      A call to dmx_write() with the bytes, if any, and to dmx_send().
+    expect receive <err> <size> <sc>
+      The outcome of the previous dmx_receive(): the error name or number,
+      the size and the start code in hex, or -1 if there was none.
+    expect send <size>
+      The return value of the previous dmx_send().
+
+  Interrupts are replayed at their times. Calls are made in order by one task,
+  which waits until the time of each call if it is still in the future, as
+  the application would when it is idle.
+
+  Note: this is a host tool. It will not work on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_sim.h"
+#include "dmx_sim_replay.h"
+#include "esp_dmx.h"
+#include "freertos/semphr.h"
+
+#define REPLAY_MAX_LINE_LEN 4096
+
+typedef enum replay_call_type_t {
+  REPLAY_CALL_RECEIVE,
+  REPLAY_CALL_SEND,
+} replay_call_type_t;
+
+typedef struct replay_call_t {
+  int line_num;            // The line of the capture file.
+  replay_call_type_t type;
+  int64_t time;            // The time of the call, in microseconds.
+  uint32_t arg;            // The timeout in milliseconds, or the send size.
+  uint8_t *data;           // The bytes to write before sending, or NULL.
+  size_t data_size;
+  bool has_expected;       // True if the outcome is checked.
+  esp_err_t expected_err;  // The expected error of dmx_receive().
+  size_t expected_size;    // The expected size of the packet or send.
+  int expected_sc;         // The expected start code, or -1.
+} replay_call_t;
+
+typedef struct replay_t {
+  dmx_port_t dmx_num;
+  dmx_isr_capture_t *captures;
+  size_t num_captures;
+  replay_call_t *calls;
+  size_t num_calls;
+  int num_mismatches;
+  bool has_error;
+} replay_t;
+
+static void *replay_append(void *array, size_t *num, size_t item_size) {
+  uint8_t *const grown = realloc(array, (*num + 1) * item_size);
+  if (grown == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  memset(grown + *num * item_size, 0, item_size);
+  ++*num;
+  return grown;
+}
+
+// Parses hex bytes without separators. Returns false if the hex is invalid.
+static bool parse_hex(const char *hex, uint8_t **data, size_t *size) {
+  const size_t len = strlen(hex);
+  if (len % 2 != 0) {
+    return false;
+  }
+  *size = len / 2;
+  *data = malloc(*size > 0 ? *size : 1);
+  if (*data == NULL) {
+    return false;
+  }
+  for (size_t i = 0; i < *size; ++i) {
+    unsigned int value;
+    if (sscanf(hex + i * 2, "%2x", &value) != 1) {
+      free(*data);
+      return false;
+    }
+    (*data)[i] = value;
+  }
+  return true;
+}
+
+// Parses the name of an error, or its number.
+static bool parse_err(const char *token, esp_err_t *err) {
+  if (strcmp(token, esp_err_to_name(ESP_OK)) == 0) {
+    *err = ESP_OK;
+    return true;
+  } else if (strcmp(token, esp_err_to_name(ESP_FAIL)) == 0) {
+    *err = ESP_FAIL;
+    return true;
+  }
+  for (esp_err_t code = ESP_ERR_NO_MEM; code <= ESP_ERR_NOT_FINISHED; ++code) {
+    if (strcmp(token, esp_err_to_name(code)) == 0) {
+      *err = code;
+      return true;
+    }
+  }
+  char *end;
+  *err = strtol(token, &end, 0);
+  return *end == '\0';
+}
+
+static bool parse_line(replay_t *replay, char *line, int line_num) {
+  char *const comment = strchr(line, '#');
+  if (comment != NULL) {
+    *comment = '\0';
+  }
+  char *tokens[8];
+  int num_tokens = 0;
+  for (char *token = strtok(line, " \t\r\n"); token != NULL && num_tokens < 8;
+       token = strtok(NULL, " \t\r\n")) {
+    tokens[num_tokens++] = token;
+  }
+  if (num_tokens == 0) {
+    return true;
+  }
+
+  if (strcmp(tokens[0], "expect") == 0) {
+    if (replay->num_calls == 0 || num_tokens < 3) {
+      return false;
+    }
+    replay_call_t *const call = &replay->calls[replay->num_calls - 1];
+    call->has_expected = true;
+    if (strcmp(tokens[1], "receive") == 0) {
+      if (call->type != REPLAY_CALL_RECEIVE || num_tokens != 5) {
+        return false;
+      }
+      call->expected_size = strtoul(tokens[3], NULL, 0);
+      call->expected_sc = strtol(tokens[4], NULL, 16);
+      return parse_err(tokens[2], &call->expected_err);
+    }
+    call->expected_size = strtoul(tokens[2], NULL, 0);
+    return strcmp(tokens[1], "send") == 0 && call->type == REPLAY_CALL_SEND &&
+           num_tokens == 3;
+  }
+
+  if (num_tokens < 2) {
+    return false;
+  }
+  char *end;
+  const int64_t time = strtoll(tokens[0], &end, 0);
+  if (*end != '\0') {
+    return false;
+  }
+
+  if (strcmp(tokens[1], "uart") == 0 || strcmp(tokens[1], "timer") == 0) {
+    replay->captures = replay_append(replay->captures, &replay->num_captures,
+                                     sizeof(dmx_isr_capture_t));
+    dmx_isr_capture_t *const capture =
+        &replay->captures[replay->num_captures - 1];
+    capture->timestamp = time;
+    if (tokens[1][0] == 't') {
+      capture->source = DMX_ISR_CAPTURE_TIMER;
+      return num_tokens == 2;
+    }
+    capture->source = DMX_ISR_CAPTURE_UART;
+    if (num_tokens < 4 || num_tokens > 5) {
+      return false;
+    }
+    capture->intr_flags = strtoul(tokens[2], NULL, 16);
+    capture->rx_len = strtoul(tokens[3], NULL, 0);
+    if (num_tokens == 5) {
+      uint8_t *data;
+      size_t size;
+      if (!parse_hex(tokens[4], &data, &size)) {
+        return false;
+      }
+      capture->rx_data = data;
+      capture->rx_read = size;
+    }
+    return true;
+  }
+
+  replay->calls = replay_append(replay->calls, &replay->num_calls,
+                                sizeof(replay_call_t));
+  replay_call_t *const call = &replay->calls[replay->num_calls - 1];
+  call->line_num = line_num;
+  call->time = time;
+  if (strcmp(tokens[1], "receive") == 0 && num_tokens == 3) {
+    call->type = REPLAY_CALL_RECEIVE;
+    call->arg = strtoul(tokens[2], NULL, 0);
+    return true;
+  } else if (strcmp(tokens[1], "send") == 0 &&
+             (num_tokens == 3 || num_tokens == 4)) {
+    call->type = REPLAY_CALL_SEND;
+    call->arg = strtoul(tokens[2], NULL, 0);
+    return num_tokens == 3 ||
+           parse_hex(tokens[3], &call->data, &call->data_size);
+  }
+  return false;
+}
+
+static void replay_wake(void *context, uint32_t arg) {
+  xSemaphoreGiveFromISR((SemaphoreHandle_t)context, NULL);
+}
+
+// Blocks the calling task until a virtual time in microseconds.
+static void replay_wait_until(SemaphoreHandle_t semaphore, int64_t time) {
+  if (time * 1000 > dmx_sim_get_time()) {
+    dmx_sim_schedule(time * 1000, replay_wake, semaphore, 0);
+    xSemaphoreTake(semaphore, portMAX_DELAY);
+  }
+}
+
+static void replay_call(replay_t *replay, const replay_call_t *call) {
+  const dmx_port_t dmx_num = replay->dmx_num;
+  if (call->type == REPLAY_CALL_RECEIVE) {
+    dmx_packet_t packet;
+    const size_t size = dmx_receive(dmx_num, &packet, pdMS_TO_TICKS(call->arg));
+    printf("%lld receive returned %s %zu %s%02x\n",
+           (long long)(dmx_sim_get_time() / 1000), esp_err_to_name(packet.err),
+           size, packet.sc < 0 ? "-" : "", packet.sc < 0 ? -packet.sc : packet.sc);
+    if (call->has_expected &&
+        (packet.err != call->expected_err || size != call->expected_size ||
+         packet.sc != call->expected_sc)) {
+      fprintf(stderr,
+              "line %i: expected receive %s %zu %i, got %s %zu %i\n",
+              call->line_num, esp_err_to_name(call->expected_err),
+              call->expected_size, call->expected_sc,
+              esp_err_to_name(packet.err), size, packet.sc);
+      ++replay->num_mismatches;
+    }
+  } else {
+    if (call->data != NULL) {
+      dmx_write(dmx_num, call->data, call->data_size);
+    }
+    const size_t size = dmx_send(dmx_num, call->arg);
+    printf("%lld send returned %zu\n",
+           (long long)(dmx_sim_get_time() / 1000), size);
+    if (call->has_expected && size != call->expected_size) {
+      fprintf(stderr, "line %i: expected send %zu, got %zu\n", call->line_num,
+              call->expected_size, size);
+      ++replay->num_mismatches;
+    }
+  }
+}
+
+static void replay_main(void *arg) {
+  replay_t *const replay = arg;
+  const dmx_port_t dmx_num = replay->dmx_num;
+  if (dmx_driver_install(dmx_num, DMX_DEFAULT_INTR_FLAGS) != ESP_OK ||
+      dmx_sim_replay_enable(dmx_num) != ESP_OK) {
+    replay->has_error = true;
+    return;
+  }
+  for (size_t i = 0; i < replay->num_captures; ++i) {
+    const esp_err_t err = dmx_sim_replay_add(dmx_num, &replay->captures[i]);
+    if (err != ESP_OK) {
+      fprintf(stderr, "capture %zu: %s\n", i, esp_err_to_name(err));
+      replay->has_error = true;
+      return;
+    }
+  }
+
+  SemaphoreHandle_t semaphore = xSemaphoreCreateBinary();
+  for (size_t i = 0; i < replay->num_calls; ++i) {
+    replay_wait_until(semaphore, replay->calls[i].time);
+    replay_call(replay, &replay->calls[i]);
+  }
+
+  // Replay the interrupts which came after the last call
+  if (replay->num_captures > 0) {
+    replay_wait_until(semaphore,
+                      replay->captures[replay->num_captures - 1].timestamp);
+  }
+  vSemaphoreDelete(semaphore);
+
+  const size_t num_replayed = dmx_sim_replay_get_count(dmx_num);
+  printf("%zu of %zu interrupts replayed, %zu calls, %i mismatches\n",
+         num_replayed, replay->num_captures, replay->num_calls,
+         replay->num_mismatches);
+  dmx_profile_t profile;
+  if (dmx_get_profile(dmx_num, &profile)) {
+    static const char *const branch_names[DMX_ISR_BRANCH_MAX] = {
+        "rx_err", "rx_break", "rx_data", "tx_data", "tx_done"};
+    for (int i = 0; i < DMX_ISR_BRANCH_MAX; ++i) {
+      const dmx_profile_stat_t *const stat = &profile.isr_cycles[i];
+      if (stat->count > 0) {
+        printf("isr %-8s %8u passes %8.1f ns mean %8u ns max\n",
+               branch_names[i], stat->count,
+               (double)stat->total / stat->count, stat->max);
+      }
+    }
+  }
+  if (num_replayed != replay->num_captures) {
+    replay->has_error = true;
+  }
+
+  dmx_sim_replay_disable(dmx_num);
+  dmx_driver_delete(dmx_num);
+}
+
+int main(int argc, char *argv[]) {
+  replay_t replay = {.dmx_num = DMX_NUM_1};
+  const char *path = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+      replay.dmx_num = strtoul(argv[++i], NULL, 0);
+    } else if (argv[i][0] != '-' && path == NULL) {
+      path = argv[i];
+    } else {
+      path = NULL;
+      break;
+    }
+  }
+  if (path == NULL || replay.dmx_num >= DMX_NUM_MAX) {
+    fprintf(stderr, "Usage: %s [-p port] capture\n", argv[0]);
+    return 2;
+  }
+
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    perror(path);
+    return 1;
+  }
+  char line[REPLAY_MAX_LINE_LEN];
+  for (int line_num = 1; fgets(line, sizeof(line), file) != NULL;
+       ++line_num) {
+    if (!parse_line(&replay, line, line_num)) {
+      fprintf(stderr, "%s:%i: invalid line\n", path, line_num);
+      fclose(file);
+      return 1;
+    }
+  }
+  fclose(file);
+
+  const bool finished = dmx_sim_run(replay_main, &replay);
+  if (!finished) {
+    fprintf(stderr, "the replay blocked forever\n");
+  }
+  return finished && !replay.has_error && replay.num_mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+/*
+
+  DMX Trace Decoder
+
+  Renders the records of a DMX driver trace as a timeline. The records are
+  read as they were copied by dmx_trace_drain(): 8 bytes each, with the
+  little-endian layout of dmx_trace_record_t on the ESP32 and on the host.
+  Records with the DMX_TRACE_LOST event mark where records were lost.
+
+  Usage: dmx_trace_decode [-x] [-m cpu MHz] [file]
+
+  Records are read from the file, or from stdin without one. With -x, the
+  records are read as hex digits, e.g. from a serial console, and lines which
+  contain anything but hex digits and whitespace are ignored. Cycles are
+  converted to microseconds with the CPU frequency, which is 240MHz by
+  default. The host simulation timestamps records as a 240MHz CPU would:
+
+    ./build-host/sim_trace | ./build-host/dmx_trace_decode
+
+  Note: this is a host tool. It will not work on the ESP-IDF or on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx_types.h"
+
+#define DMX_TRACE_DECODE_RECORD_SIZE 8
+
+// The names of the packet types of the driver, in the order of its
+// rdm_packet_type_t.
+static const char *const packet_type_names[] = {
+    "DMX", "RDM discovery", "RDM discovery response",
+    "RDM request", "RDM response", "RDM broadcast"};
+
+static const char *const timer_names[] = {
+    "break end", "mark-after-break end", "RDM response timeout"};
+
+static const char *const event_names[DMX_TRACE_EVENT_MAX] = {
+    [DMX_TRACE_RX_ERR] = "rx_err",
+    [DMX_TRACE_RX_BREAK] = "rx_break",
+    [DMX_TRACE_RX_DATA] = "rx_data",
+    [DMX_TRACE_RX_PACKET] = "rx_packet",
+    [DMX_TRACE_RX_FILTERED] = "rx_filtered",
+    [DMX_TRACE_RX_DROPPED] = "rx_dropped",
+    [DMX_TRACE_DISC_FAST_PATH] = "disc_fast_path",
+    [DMX_TRACE_TX_DATA] = "tx_data",
+    [DMX_TRACE_TX_DONE] = "tx_done",
+    [DMX_TRACE_TIMER] = "timer",
+    [DMX_TRACE_NOTIFY] = "notify",
+    [DMX_TRACE_RTS] = "rts",
+    [DMX_TRACE_GPIO_EDGE] = "gpio_edge",
+    [DMX_TRACE_SEND] = "send",
+    [DMX_TRACE_RECEIVE] = "receive",
+    [DMX_TRACE_RECEIVED] = "received",
+    [DMX_TRACE_WRITE] = "write",
+};
+
+typedef struct decoder_t {
+  bool is_hex;         // True if records are read as hex digits.
+  double cpu_mhz;      // The CPU frequency of the cycle count.
+  bool has_time;       // True once the first record has been printed.
+  uint32_t last;       // The cycle count of the last record.
+  uint64_t elapsed;    // The cycles since the first record.
+  uint64_t num_lost;   // The number of lost records.
+  uint64_t num_read;   // The number of records which were read.
+} decoder_t;
+
+static void format_arg(const dmx_trace_record_t *record, char *buf,
+                       size_t size) {
+  const char *name = NULL;
+  switch (record->event) {
+    case DMX_TRACE_RX_ERR:
+    case DMX_TRACE_RX_BREAK:
+    case DMX_TRACE_RX_DATA:
+    case DMX_TRACE_TX_DATA:
+    case DMX_TRACE_TX_DONE:
+      // The head of the driver buffer is -1 while waiting for a DMX break
+      snprintf(buf, size, "head %i", (int16_t)record->arg);
+      return;
+    case DMX_TRACE_RX_PACKET:
+    case DMX_TRACE_RX_FILTERED:
+    case DMX_TRACE_RX_DROPPED:
+      if (record->arg < sizeof(packet_type_names) / sizeof(char *)) {
+        name = packet_type_names[record->arg];
+      }
+      break;
+    case DMX_TRACE_TIMER:
+      if (record->arg < sizeof(timer_names) / sizeof(char *)) {
+        name = timer_names[record->arg];
+      }
+      break;
+    case DMX_TRACE_NOTIFY:
+      snprintf(buf, size, "value %i", (int16_t)record->arg);
+      return;
+    case DMX_TRACE_RTS:
+      name = record->arg ? "receive" : "send";
+      break;
+    case DMX_TRACE_GPIO_EDGE:
+      name = record->arg ? "rising" : "falling";
+      break;
+    case DMX_TRACE_SEND:
+    case DMX_TRACE_RECEIVED:
+    case DMX_TRACE_WRITE:
+      snprintf(buf, size, "size %u", record->arg);
+      return;
+    default:
+      snprintf(buf, size, "%s", "");
+      return;
+  }
+  if (name != NULL) {
+    snprintf(buf, size, "%s", name);
+  } else {
+    snprintf(buf, size, "%u", record->arg);
+  }
+}
+
+static void decode_record(decoder_t *decoder, const uint8_t *bytes) {
+  const dmx_trace_record_t record = {
+      .cycles = bytes[0] | bytes[1] << 8 | bytes[2] << 16 |
+                (uint32_t)bytes[3] << 24,
+      .arg = bytes[4] | bytes[5] << 8,
+      .event = bytes[6],
+      .seq = bytes[7]};
+  if (record.event == DMX_TRACE_LOST) {
+    printf("%14s %10s  *** %u records lost ***\n", "", "", record.arg);
+    decoder->num_lost += record.arg;
+    return;
+  }
+  ++decoder->num_read;
+
+  // The cycle count wraps around, so only differences between records count
+  const uint32_t delta = decoder->has_time ? record.cycles - decoder->last : 0;
+  decoder->elapsed += delta;
+  decoder->last = record.cycles;
+  decoder->has_time = true;
+
+  char arg[32];
+  format_arg(&record, arg, sizeof(arg));
+  if (record.event < DMX_TRACE_EVENT_MAX) {
+    printf("%14.3f %+10.3f  %-15s %s\n", decoder->elapsed / decoder->cpu_mhz,
+           delta / decoder->cpu_mhz, event_names[record.event], arg);
+  } else {
+    printf("%14.3f %+10.3f  event %-9u %s\n",
+           decoder->elapsed / decoder->cpu_mhz, delta / decoder->cpu_mhz,
+           record.event, arg);
+  }
+}
+
+static void decode_binary(decoder_t *decoder, FILE *file) {
+  uint8_t bytes[DMX_TRACE_DECODE_RECORD_SIZE];
+  while (fread(bytes, sizeof(bytes), 1, file) == 1) {
+    decode_record(decoder, bytes);
+  }
+}
+
+static void decode_hex(decoder_t *decoder, FILE *file) {
+  uint8_t bytes[DMX_TRACE_DECODE_RECORD_SIZE];
+  size_t num_bytes = 0;
+  char line[1024];
+  while (fgets(line, sizeof(line), file) != NULL) {
+    // Skip lines which are not hex dumps, e.g. log messages
+    bool is_hex = true;
+    for (const char *c = line; *c != '\0'; ++c) {
+      if (!isxdigit((unsigned char)*c) && !isspace((unsigned char)*c)) {
+        is_hex = false;
+        break;
+      }
+    }
+    if (!is_hex) {
+      continue;
+    }
+
+    int nibble = -1;
+    for (const char *c = line; *c != '\0'; ++c) {
+      if (!isxdigit((unsigned char)*c)) {
+        continue;
+      }
+      const int value = isdigit((unsigned char)*c)
+                            ? *c - '0'
+                            : tolower((unsigned char)*c) - 'a' + 10;
+      if (nibble < 0) {
+        nibble = value;
+        continue;
+      }
+      bytes[num_bytes++] = nibble << 4 | value;
+      nibble = -1;
+      if (num_bytes == sizeof(bytes)) {
+        decode_record(decoder, bytes);
+        num_bytes = 0;
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  decoder_t decoder = {.cpu_mhz = 240};
+  const char *path = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-x") == 0) {
+      decoder.is_hex = true;
+    } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+      decoder.cpu_mhz = strtod(argv[++i], NULL);
+    } else if (argv[i][0] != '-' && path == NULL) {
+      path = argv[i];
+    } else {
+      fprintf(stderr, "Usage: %s [-x] [-m cpu MHz] [file]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (decoder.cpu_mhz <= 0) {
+    fprintf(stderr, "The CPU frequency must be positive\n");
+    return 2;
+  }
+
+  FILE *file = stdin;
+  if (path != NULL) {
+    file = fopen(path, decoder.is_hex ? "r" : "rb");
+    if (file == NULL) {
+      perror(path);
+      return 1;
+    }
+  }
+
+  printf("%14s %10s  %-15s %s\n", "time_us", "delta_us", "event", "argument");
+  if (decoder.is_hex) {
+    decode_hex(&decoder, file);
+  } else {
+    decode_binary(&decoder, file);
+  }
+  printf("%llu records, %llu lost, %.3f us\n",
+         (unsigned long long)decoder.num_read,
+         (unsigned long long)decoder.num_lost,
+         decoder.elapsed / decoder.cpu_mhz);
+
+  if (file != stdin) {
+    fclose(file);
+  }
+  return 0;
+}
@@ -91,9 +91,17 @@ enum dmx_parameter_t {
   DMX_MIN_MAB_LEN_US = 12,      // The minimum DMX mark-after-break length in microseconds.
   DMX_MAX_MAB_LEN_US = 999999,  // The maximum DMX mark-after-break length in microseconds.
 
+  DMX_RX_MIN_BREAK_LEN_US = 88,         // The minimum receivable DMX break length in microseconds.
+  DMX_RX_MIN_MAB_LEN_US = 8,            // The minimum receivable DMX mark-after-break length in microseconds.
+  DMX_RX_MAX_MAB_LEN_US = 999999,       // The maximum receivable DMX mark-after-break length in microseconds.
+  DMX_RX_MIN_PACKET_LEN_US = 1196,      // The minimum receivable DMX break-to-break length in microseconds.
+  DMX_RX_MAX_PACKET_LEN_US = 1250000,   // The maximum receivable DMX break-to-break length in microseconds.
+  DMX_RX_MAX_MBS_LEN_US = 999999,       // The maximum receivable DMX mark between slots length in microseconds.
+
   DMX_TIMEOUT_TICK = pdMS_TO_TICKS(1250),  // The DMX receive timeout length in FreeRTOS ticks. If it takes longer than this amount of time to receive the next DMX packet the signal is considered lost.
 
   RDM_BASE_PACKET_SIZE = 26,  // The base size of an RDM packet. This is the size of the packet if the parameter data length is 0.
+  RDM_MAX_PDL = 231,          // The maximum parameter data length of an RDM packet.
 
   RDM_BREAK_LEN_US = 176,      // The typical RDM break length in microseconds.
   RDM_MIN_BREAK_LEN_US = 176,  // The minimum RDM break length in microseconds.
@@ -273,6 +281,32 @@ enum dmx_start_code_t {
 #define DMX_MAB_LEN_IS_VALID(mab) \
   (mab >= DMX_MIN_MAB_LEN_US && mab <= DMX_MAX_MAB_LEN_US)
 
+/**
+ * @brief Evaluates to true if a received break duration is within the receive
+ * timing limits of DMX.
+ */
+#define DMX_RX_BREAK_LEN_IS_VALID(brk) (brk >= DMX_RX_MIN_BREAK_LEN_US)
+
+/**
+ * @brief Evaluates to true if a received mark-after-break duration is within
+ * the receive timing limits of DMX.
+ */
+#define DMX_RX_MAB_LEN_IS_VALID(mab) \
+  (mab >= DMX_RX_MIN_MAB_LEN_US && mab <= DMX_RX_MAX_MAB_LEN_US)
+
+/**
+ * @brief Evaluates to true if a received break-to-break duration is within the
+ * receive timing limits of DMX.
+ */
+#define DMX_RX_PACKET_LEN_IS_VALID(pkt) \
+  (pkt >= DMX_RX_MIN_PACKET_LEN_US && pkt <= DMX_RX_MAX_PACKET_LEN_US)
+
+/**
+ * @brief Evaluates to true if a received mark between slots duration is within
+ * the receive timing limits of DMX.
+ */
+#define DMX_RX_MBS_LEN_IS_VALID(mbs) (mbs <= DMX_RX_MAX_MBS_LEN_US)
+
 /**
  * @brief Evaluates to true if the baud rate is within RDM specification.
  */
@@ -312,6 +346,277 @@ typedef struct dmx_packet_t {
   bool is_rdm;      // True if the received packet is RDM.
 } dmx_packet_t;
 
+/**
+ * @brief The branches of the DMX UART interrupt handler. Each pass through the
+ * interrupt handler loop is attributed to the first branch whose interrupt
+ * flags are set.
+ */
+typedef enum dmx_isr_branch_t {
+  DMX_ISR_BRANCH_RX_ERR,    // A receive FIFO overflow or framing error.
+  DMX_ISR_BRANCH_RX_BREAK,  // A received DMX break.
+  DMX_ISR_BRANCH_RX_DATA,   // Data in the receive FIFO.
+  DMX_ISR_BRANCH_TX_DATA,   // Space in the transmit FIFO.
+  DMX_ISR_BRANCH_TX_DONE,   // The end of a transmitted packet.
+  DMX_ISR_BRANCH_MAX        // The number of interrupt handler branches.
+} dmx_isr_branch_t;
+
+/**
+ * @brief A summary of repeated measurements of a driver hot path.
+ */
+typedef struct dmx_profile_stat_t {
+  uint32_t count;  // The number of measurements.
+  uint32_t max;    // The largest measurement.
+  uint64_t total;  // The sum of the measurements.
+} dmx_profile_stat_t;
+
+/**
+ * @brief Profiling counters of a DMX port, which are gathered when the driver
+ * is built with CONFIG_DMX_PROFILE.
+ */
+typedef struct dmx_profile_t {
+  uint32_t isr_calls;                                // The number of times the UART interrupt handler was called.
+  dmx_profile_stat_t isr_cycles[DMX_ISR_BRANCH_MAX];  // CPU cycles spent in each branch of the UART interrupt handler. In the host simulation these are nanoseconds of the host clock.
+  dmx_profile_stat_t rx_wake_us;                     // Microseconds from the DMX break of a received packet until dmx_receive() returned it.
+  dmx_profile_stat_t tx_break_us;                    // Microseconds from a call to dmx_send() until the DMX break was started, or the first slot of a packet without a break was written.
+} dmx_profile_t;
+
+/**
+ * @brief The interrupt handlers which report to the ISR capture callback.
+ */
+typedef enum dmx_isr_capture_source_t {
+  DMX_ISR_CAPTURE_UART,   // A pass through the UART interrupt handler loop.
+  DMX_ISR_CAPTURE_TIMER,  // A call to the hardware timer interrupt handler.
+} dmx_isr_capture_source_t;
+
+/**
+ * @brief What an interrupt handler of a DMX port read from the hardware, as
+ * reported to the ISR capture callback when the driver is built with
+ * CONFIG_DMX_ISR_CAPTURE. The UART interrupt handler reports once for each
+ * pass through its loop, so passes of one call share a timestamp.
+ */
+typedef struct dmx_isr_capture_t {
+  int64_t timestamp;       // The value of esp_timer_get_time() when the interrupt handler was called.
+  uint8_t source;          // The dmx_isr_capture_source_t of the capture.
+  uint32_t intr_flags;     // The UART interrupt flags which were read in the pass. Always 0 for the timer.
+  uint32_t rx_len;         // The number of bytes in the RX FIFO at the start of the pass.
+  const uint8_t *rx_data;  // The bytes which were read from the RX FIFO, or NULL if none were read. Only valid during the callback.
+  uint32_t rx_read;        // The number of bytes which were read from the RX FIFO. The rest were discarded.
+} dmx_isr_capture_t;
+
+/**
+ * @brief The ISR capture callback. It is called from the interrupt handlers
+ * of the DMX driver, so it must be in IRAM if they are, and must return
+ * quickly.
+ */
+typedef void (*dmx_isr_capture_cb_t)(dmx_port_t dmx_num,
+                                     const dmx_isr_capture_t *capture,
+                                     void *context);
+
+/**
+ * @brief The flags of a frame in a packet capture stream.
+ */
+enum dmx_capture_flag_t {
+  DMX_CAPTURE_FLAG_SENT = 1 << 0,         // The frame was sent by the DMX port. Otherwise it was received.
+  DMX_CAPTURE_FLAG_RX_ERR = 1 << 1,       // A framing error or receive FIFO overflow occurred in the frame.
+  DMX_CAPTURE_FLAG_NO_BREAK = 1 << 2,     // The frame was not preceded by a DMX break, e.g. a DISC_UNIQUE_BRANCH response.
+  DMX_CAPTURE_FLAG_TRUNCATED = 1 << 3,    // The frame had more than DMX_MAX_PACKET_SIZE slots. Only the first DMX_MAX_PACKET_SIZE were captured.
+  DMX_CAPTURE_FLAG_DROPPED = 1 << 4,      // Frames before this one were dropped because the capture buffer was full.
+};
+
+/**
+ * @brief The classification of a frame in a packet capture stream. The values
+ * are part of the stream format and must not be renumbered.
+ */
+typedef enum dmx_capture_type_t {
+  DMX_CAPTURE_TYPE_NON_RDM,             // A DMX packet, or a frame which is not a valid RDM packet.
+  DMX_CAPTURE_TYPE_DISCOVERY,           // An RDM DISC_UNIQUE_BRANCH request.
+  DMX_CAPTURE_TYPE_DISCOVERY_RESPONSE,  // An RDM DISC_UNIQUE_BRANCH response.
+  DMX_CAPTURE_TYPE_REQUEST,             // An RDM request to one device.
+  DMX_CAPTURE_TYPE_RESPONSE,            // An RDM response.
+  DMX_CAPTURE_TYPE_BROADCAST,           // An RDM broadcast request.
+} dmx_capture_type_t;
+
+/**
+ * @brief The magic number which starts a packet capture stream.
+ */
+#define DMX_CAPTURE_MAGIC "DMXC"
+
+/**
+ * @brief The version of the packet capture stream format.
+ */
+#define DMX_CAPTURE_VERSION 1
+
+/**
+ * @brief The header of a packet capture stream. It is written once, before the
+ * first frame. All fields are little-endian.
+ */
+typedef struct dmx_capture_stream_header_t {
+  char magic[4];         // DMX_CAPTURE_MAGIC, without a null terminator.
+  uint8_t version;       // DMX_CAPTURE_VERSION.
+  uint8_t dmx_num;       // The DMX port which was captured.
+  uint16_t header_size;  // The size of a dmx_capture_header_t, so that readers may skip fields which are added later.
+} dmx_capture_stream_header_t;
+
+/**
+ * @brief The header of a frame in a packet capture stream. The slots of the
+ * frame, starting with the start code, follow the header. All fields are
+ * little-endian.
+ */
+typedef struct dmx_capture_header_t {
+  uint16_t size;       // The size of the frame in bytes, including this header.
+  uint8_t flags;       // The dmx_capture_flag_t of the frame.
+  uint8_t type;        // The dmx_capture_type_t of the frame.
+  uint16_t break_len;  // The length of the DMX break in microseconds, or 0 if it was not measured.
+  uint16_t mab_len;    // The length of the DMX mark-after-break in microseconds, or 0 if it was not measured.
+  int64_t timestamp;   // The value of esp_timer_get_time() at the end of the frame.
+} dmx_capture_header_t;
+
+/**
+ * @brief Writes bytes of a packet capture stream to a sink, such as a UART, a
+ * file, or a socket. It is called from the capture task, so it may block.
+ *
+ * @param[in] data The bytes to write.
+ * @param size The number of bytes to write.
+ * @param context The context which was passed in the capture configuration.
+ * @return The number of bytes which were written. The rest are written in the
+ * next call. Returning 0 causes the capture task to wait a tick and try again.
+ */
+typedef size_t (*dmx_capture_sink_t)(const void *data, size_t size,
+                                      void *context);
+
+/**
+ * @brief The configuration of a packet capture.
+ */
+typedef struct dmx_capture_config_t {
+  dmx_capture_sink_t sink;  // The sink to which the stream is written.
+  void *context;            // The context passed to the sink.
+  size_t buffer_size;       // The size of the capture buffer in bytes. Must be a power of two of at least 1024.
+  UBaseType_t priority;     // The priority of the capture task.
+  BaseType_t core_id;       // The core to which the capture task is pinned, or tskNO_AFFINITY.
+  uint32_t stack_size;      // The stack size of the capture task in bytes.
+} dmx_capture_config_t;
+
+/**
+ * @brief The default configuration of a packet capture. The buffer holds more
+ * than 300ms of frames at the full DMX rate.
+ */
+#define DMX_CAPTURE_DEFAULT_CONFIG(sink_cb, sink_context) \
+  {                                                       \
+    .sink = sink_cb,                                      \
+    .context = sink_context,                              \
+    .buffer_size = 8192,                                  \
+    .priority = tskIDLE_PRIORITY + 2,                     \
+    .core_id = tskNO_AFFINITY,                            \
+    .stack_size = 2048,                                   \
+  }
+
+/**
+ * @brief The E1.11 timing checks which the DMX timing analyzer makes on each
+ * received packet. The DMX break, mark-after-break, and marks between slots
+ * are measured from the edges seen by the DMX sniffer, so they are only
+ * checked while it is enabled.
+ */
+typedef enum dmx_analyzer_check_t {
+  DMX_ANALYZER_CHECK_BREAK,               // The DMX break in microseconds, checked with DMX_RX_BREAK_LEN_IS_VALID().
+  DMX_ANALYZER_CHECK_MAB,                 // The mark-after-break in microseconds, checked with DMX_RX_MAB_LEN_IS_VALID().
+  DMX_ANALYZER_CHECK_BREAK_TO_BREAK,      // The time in microseconds from the DMX break of the packet to the next, checked with DMX_RX_PACKET_LEN_IS_VALID().
+  DMX_ANALYZER_CHECK_SLOT_COUNT,          // The number of slots, including the start code, which must be from 1 to DMX_MAX_PACKET_SIZE.
+  DMX_ANALYZER_CHECK_MARK_BETWEEN_SLOTS,  // The longest mark between two slots in microseconds, checked with DMX_RX_MBS_LEN_IS_VALID().
+  DMX_ANALYZER_CHECK_MAX,                 // The number of timing checks.
+} dmx_analyzer_check_t;
+
+/**
+ * @brief The counters of one timing check of the DMX timing analyzer.
+ */
+typedef struct dmx_analyzer_stat_t {
+  uint32_t num_checked;     // The number of packets which were checked.
+  uint32_t num_violations;  // The number of packets which were out of specification.
+  uint32_t min;             // The smallest value which was measured.
+  uint32_t max;             // The largest value which was measured.
+} dmx_analyzer_stat_t;
+
+/**
+ * @brief The counters of the DMX timing analyzer, indexed by
+ * dmx_analyzer_check_t.
+ */
+typedef struct dmx_analyzer_stats_t {
+  dmx_analyzer_stat_t checks[DMX_ANALYZER_CHECK_MAX];  // The counters of each timing check.
+} dmx_analyzer_stats_t;
+
+/**
+ * @brief An event which is raised by the DMX timing analyzer when a packet is
+ * out of specification. Events of one check are at least the event interval
+ * apart, and each summarizes the violations since the previous event of its
+ * check.
+ */
+typedef struct dmx_analyzer_event_t {
+  int64_t timestamp;        // The time of the violation which raised the event.
+  uint8_t check;            // The dmx_analyzer_check_t which was violated.
+  uint32_t num_violations;  // The number of violations since the previous event of the check.
+  uint32_t min;             // The smallest value which violated the check since the previous event of the check.
+  uint32_t max;             // The largest value which violated the check since the previous event of the check.
+} dmx_analyzer_event_t;
+
+/**
+ * @brief The configuration of the DMX timing analyzer.
+ */
+typedef struct dmx_analyzer_config_t {
+  uint32_t event_interval_ms;  // The least time in milliseconds between two events of one check.
+  uint32_t queue_size;         // The number of events which may wait to be read.
+} dmx_analyzer_config_t;
+
+/**
+ * @brief The default configuration of the DMX timing analyzer.
+ */
+#define DMX_ANALYZER_DEFAULT_CONFIG \
+  {                                 \
+    .event_interval_ms = 1000,      \
+    .queue_size = 8,                \
+  }
+
+/**
+ * @brief The events which are recorded in the trace of a DMX port when the
+ * driver is built with CONFIG_DMX_TRACE. The meaning of the argument of each
+ * event is described beside it.
+ */
+typedef enum dmx_trace_event_t {
+  DMX_TRACE_RX_ERR,          // A receive FIFO overflow or framing error. The argument is the head of the driver buffer.
+  DMX_TRACE_RX_BREAK,        // A received DMX break. The argument is the head of the driver buffer before the break.
+  DMX_TRACE_RX_DATA,         // Data was read from the receive FIFO. The argument is the head of the driver buffer.
+  DMX_TRACE_RX_PACKET,       // A received packet is complete. The argument is the packet type.
+  DMX_TRACE_RX_FILTERED,     // A received RDM packet was not addressed to the port, so the responder task was not woken. The argument is the packet type.
+  DMX_TRACE_RX_DROPPED,      // A received RDM packet was dropped because the responder task was busy. The argument is the packet type.
+  DMX_TRACE_DISC_FAST_PATH,  // A DISC_UNIQUE_BRANCH response was started by the interrupt handler.
+  DMX_TRACE_TX_DATA,         // Data was written to the transmit FIFO. The argument is the head of the driver buffer.
+  DMX_TRACE_TX_DONE,         // A packet was sent. The argument is the size of the packet.
+  DMX_TRACE_TIMER,           // The hardware timer alarmed. The argument is 0 at the end of a DMX break, 1 at the end of a DMX mark-after-break, or 2 when an RDM response timed out.
+  DMX_TRACE_NOTIFY,          // A task was notified by an interrupt handler. The argument is the notification value.
+  DMX_TRACE_RTS,             // The DMX bus was turned around. The argument is the level of the RTS pin: 1 to receive or 0 to send.
+  DMX_TRACE_GPIO_EDGE,       // The sniffer interrupt handler was called. The argument is the level of the DMX line.
+  DMX_TRACE_SEND,            // dmx_send() started a packet. The argument is the size of the packet.
+  DMX_TRACE_RECEIVE,         // dmx_receive() started to wait for a packet.
+  DMX_TRACE_RECEIVED,        // dmx_receive() returned. The argument is the size of the packet, or 0 if it timed out.
+  DMX_TRACE_WRITE,           // dmx_write() was called. The argument is the size of the data.
+  DMX_TRACE_EVENT_MAX        // The number of trace events.
+} dmx_trace_event_t;
+
+/**
+ * @brief The event of a record which is never written by the driver, but may
+ * be written into a stream of drained records to mark that records were lost.
+ * The argument is the number of lost records.
+ */
+#define DMX_TRACE_LOST 0xff
+
+/**
+ * @brief A record in the trace of a DMX port.
+ */
+typedef struct dmx_trace_record_t {
+  uint32_t cycles;  // The CPU cycle count when the event occurred. In the host simulation these are cycles of a 240MHz CPU on the virtual clock.
+  uint16_t arg;     // The argument of the event.
+  uint8_t event;    // The dmx_trace_event_t of the record.
+  uint8_t seq;      // Used internally to detect records which are being written or were overwritten. Odd in a complete record.
+} dmx_trace_record_t;
+
 #ifdef __cplusplus
 }
 #endif
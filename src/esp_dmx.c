@@ -4,16 +4,19 @@
 
 #include "dmx_types.h"
 #include "driver/gpio.h"
-#include "driver/periph_ctrl.h"
-#include "driver/timer.h"
 #include "driver/uart.h"
 #include "endian.h"
 #include "esp_check.h"
 #include "esp_log.h"
 #include "esp_rdm.h"
-#include "private/dmx_hal.h"
+#include "esp_timer.h"
+#include "private/dmx_backend.h"
+#include "private/dmx_classify.h"
 #include "private/driver.h"
+#include "private/dmx_timing.h"
+#include "private/dmx_trace.h"
 #include "private/rdm_encode/types.h"
+#include "private/rdm_responder.h"
 #include "rdm_types.h"
 
 #ifdef CONFIG_DMX_ISR_IN_IRAM
@@ -33,6 +36,69 @@ DRAM_ATTR spinlock_t dmx_spinlock[DMX_NUM_MAX] = {portMUX_INITIALIZER_UNLOCKED,
                                                   portMUX_INITIALIZER_UNLOCKED
 #endif
 };
+DRAM_ATTR dmx_timing_t dmx_timing[DMX_NUM_MAX] = {0};
+DRAM_ATTR rdm_disc_fast_path_t rdm_disc_fast_path[DMX_NUM_MAX] = {0};
+DRAM_ATTR rdm_responder_isr_t rdm_responder_isr[DMX_NUM_MAX] = {0};
+DRAM_ATTR rdm_virtual_table_t rdm_virtual_table[DMX_NUM_MAX] = {0};
+#ifdef CONFIG_DMX_PROFILE
+DRAM_ATTR dmx_profile_t dmx_profile[DMX_NUM_MAX] = {0};
+#endif
+#ifdef CONFIG_DMX_TRACE
+DRAM_ATTR dmx_trace_t dmx_trace[DMX_NUM_MAX] = {0};
+#endif
+#ifdef CONFIG_DMX_ISR_CAPTURE
+// The ISR capture callback of each DMX port.
+typedef struct dmx_isr_capture_hook_t {
+  dmx_isr_capture_cb_t cb;
+  void *context;
+} dmx_isr_capture_hook_t;
+
+DRAM_ATTR dmx_isr_capture_hook_t dmx_isr_capture[DMX_NUM_MAX] = {0};
+#endif
+
+// The packet capture of each DMX port. The interrupt handler is the only
+// writer of the capture buffer and the capture task is the only reader, so the
+// head and tail are only written by one side each.
+typedef struct dmx_capture_t {
+  uint8_t *buffer;       // The capture buffer, or NULL if capture is stopped.
+  uint32_t size;         // The size of the capture buffer, a power of two.
+  uint32_t head;         // The number of bytes written by the interrupt handler.
+  uint32_t tail;         // The number of bytes drained by the capture task.
+  uint32_t num_dropped;  // The number of frames dropped since capture started.
+  bool is_running;       // True while the interrupt handler writes frames.
+  bool is_stopping;      // True when the capture task should exit.
+  bool is_dropping;      // True if a frame was dropped since the last write.
+  bool has_break;        // True if the frame being received followed a break.
+  int captured;          // The number of slots in the driver buffer which were written. Slots after them are a frame without a break.
+  TaskHandle_t task;     // The capture task.
+  SemaphoreHandle_t stopped;  // Given by the capture task when it exits.
+  dmx_capture_config_t config;
+} dmx_capture_t;
+
+DRAM_ATTR dmx_capture_t dmx_capture[DMX_NUM_MAX] = {0};
+
+// The violations of a timing check since its last event.
+typedef struct dmx_analyzer_pending_t {
+  int64_t last_event_ts;    // The time of the last event of the check.
+  uint32_t num_violations;  // The number of violations since the last event.
+  uint32_t min;             // The smallest violating value since the last event.
+  uint32_t max;             // The largest violating value since the last event.
+} dmx_analyzer_pending_t;
+
+// The timing analyzer of each DMX port. It is written by the UART and GPIO
+// interrupt handlers with the spinlock held.
+typedef struct dmx_analyzer_t {
+  QueueHandle_t queue;      // The event queue, or NULL if the analyzer is disabled.
+  int64_t event_interval;   // The least time in microseconds between events of a check.
+  int64_t last_break_ts;    // The start of the last received DMX break, or -1 if a packet was sent since.
+  bool is_in_data;          // True while the sniffer sees the slots of a received packet.
+  uint32_t longest_mark;    // The longest mark between edges in the slots of the packet.
+  uint32_t last_mark;       // The mark before the last negative edge, which is the mark before break if the edge started a DMX break.
+  dmx_analyzer_stats_t stats;
+  dmx_analyzer_pending_t pending[DMX_ANALYZER_CHECK_MAX];
+} dmx_analyzer_t;
+
+DRAM_ATTR dmx_analyzer_t dmx_analyzer[DMX_NUM_MAX] = {0};
 
 enum dmx_default_interrupt_values_t {
   DMX_UART_FULL_DEFAULT = 1,   // RX FIFO full default interrupt threshold.
@@ -56,24 +122,285 @@ enum dmx_interrupt_mask_t {
   DMX_ALL_INTR_MASK = -1
 };
 
-enum rdm_packet_timing_t {
-  RDM_DISCOVERY_NO_RESPONSE_PACKET_SPACING = 5800,
-  RDM_REQUEST_NO_RESPONSE_PACKET_SPACING = 3000,
-  RDM_BROADCAST_PACKET_SPACING = 176,
-  RDM_RESPOND_TO_REQUEST_PACKET_SPACING = 176,
+#ifdef CONFIG_DMX_PROFILE
+// Adds a measurement to a profiling counter.
+FORCE_INLINE_ATTR void dmx_profile_add(dmx_profile_stat_t *stat,
+                                       uint32_t value) {
+  ++stat->count;
+  stat->total += value;
+  if (value > stat->max) {
+    stat->max = value;
+  }
+}
 
-  RDM_CONTROLLER_RESPONSE_LOST_TIMEOUT = 2800,
-  RDM_RESPONDER_RESPONSE_LOST_TIMEOUT = 2000
-};
+// Attributes the cycles of a pass through the UART interrupt handler loop to
+// the branch which handled it.
+static void DMX_ISR_ATTR dmx_profile_add_isr(dmx_port_t dmx_num,
+                                             uint32_t intr_flags,
+                                             uint32_t cycles) {
+  dmx_isr_branch_t branch;
+  if (intr_flags & DMX_INTR_RX_ERR) {
+    branch = DMX_ISR_BRANCH_RX_ERR;
+  } else if (intr_flags & DMX_INTR_RX_BREAK) {
+    branch = DMX_ISR_BRANCH_RX_BREAK;
+  } else if (intr_flags & DMX_INTR_RX_DATA) {
+    branch = DMX_ISR_BRANCH_RX_DATA;
+  } else if (intr_flags & DMX_INTR_TX_DATA) {
+    branch = DMX_ISR_BRANCH_TX_DATA;
+  } else if (intr_flags & DMX_INTR_TX_DONE) {
+    branch = DMX_ISR_BRANCH_TX_DONE;
+  } else {
+    return;
+  }
+  dmx_profile_add(&dmx_profile[dmx_num].isr_cycles[branch], cycles);
+}
+#endif
 
-enum rdm_packet_type_t {
-  RDM_PACKET_TYPE_NON_RDM,
-  RDM_PACKET_TYPE_DISCOVERY,
-  RDM_PACKET_TYPE_DISCOVERY_RESPONSE,
-  RDM_PACKET_TYPE_REQUEST,
-  RDM_PACKET_TYPE_RESPONSE,
-  RDM_PACKET_TYPE_BROADCAST
-};
+// Copies bytes into the capture buffer of a DMX port, wrapping at its end.
+static void DMX_ISR_ATTR dmx_capture_copy(dmx_capture_t *capture,
+                                          uint32_t index, const void *src,
+                                          size_t size) {
+  const uint32_t offset = index & (capture->size - 1);
+  const size_t first = size < capture->size - offset ? size
+                                                     : capture->size - offset;
+  memcpy(capture->buffer + offset, src, first);
+  memcpy(capture->buffer, (const uint8_t *)src + first, size - first);
+}
+
+// Returns the capture type of a packet type which the driver assigned to a
+// packet. The capture type is part of the stream format, so it must not change
+// if the packet types of the driver are renumbered.
+static dmx_capture_type_t DMX_ISR_ATTR dmx_capture_type(int packet_type) {
+  switch (packet_type) {
+    case RDM_PACKET_TYPE_DISCOVERY:
+      return DMX_CAPTURE_TYPE_DISCOVERY;
+    case RDM_PACKET_TYPE_DISCOVERY_RESPONSE:
+      return DMX_CAPTURE_TYPE_DISCOVERY_RESPONSE;
+    case RDM_PACKET_TYPE_REQUEST:
+      return DMX_CAPTURE_TYPE_REQUEST;
+    case RDM_PACKET_TYPE_RESPONSE:
+      return DMX_CAPTURE_TYPE_RESPONSE;
+    case RDM_PACKET_TYPE_BROADCAST:
+      return DMX_CAPTURE_TYPE_BROADCAST;
+    default:
+      return DMX_CAPTURE_TYPE_NON_RDM;
+  }
+}
+
+// Writes the frame in the driver buffer to the packet capture of the port, if
+// it is running, and wakes the capture task. A received frame is made of the
+// slots after those which were already captured, so that a response which is
+// not preceded by a DMX break, e.g. a DISC_UNIQUE_BRANCH response, is captured
+// as its own frame. Must be called with the spinlock held.
+static void DMX_ISR_ATTR dmx_capture_frame(dmx_driver_t *driver, uint8_t flags,
+                                           int64_t now, int *task_awoken) {
+  dmx_capture_t *const capture = &dmx_capture[driver->dmx_num];
+  if (!capture->is_running) {
+    return;
+  }
+
+  dmx_capture_header_t header = {.flags = flags,
+                                 .type = dmx_capture_type(driver->data.type),
+                                 .timestamp = now};
+  const uint8_t *data = driver->data.buffer;
+  size_t size;
+  if (flags & DMX_CAPTURE_FLAG_SENT) {
+    size = driver->data.tx_size;
+    capture->captured = size;
+    if (driver->data.type == RDM_PACKET_TYPE_DISCOVERY_RESPONSE) {
+      header.flags |= DMX_CAPTURE_FLAG_NO_BREAK;
+    } else {
+      header.break_len = driver->break_len;
+      header.mab_len = driver->mab_len;
+    }
+  } else {
+    int end = driver->data.head;
+    if (end > DMX_MAX_PACKET_SIZE) {
+      end = DMX_MAX_PACKET_SIZE;
+      header.flags |= DMX_CAPTURE_FLAG_TRUNCATED;
+    }
+    const int start = capture->captured;
+    capture->captured = driver->data.head;
+    if (start >= end) {
+      return;  // The slots were not stored in the driver buffer
+    }
+    data += start;
+    size = end - start;
+
+    if (start > 0) {
+      // The slots followed a complete packet without a break
+      header.type = driver->data.type == RDM_PACKET_TYPE_DISCOVERY
+                        ? DMX_CAPTURE_TYPE_DISCOVERY_RESPONSE
+                        : DMX_CAPTURE_TYPE_NON_RDM;
+    } else if (!driver->received_a_packet) {
+      header.type = DMX_CAPTURE_TYPE_NON_RDM;  // The frame was not classified
+    }
+    if (!capture->has_break || start > 0) {
+      header.flags |= DMX_CAPTURE_FLAG_NO_BREAK;
+    } else if (driver->sniffer.queue != NULL) {
+      header.break_len = driver->sniffer.data.break_len;
+      header.mab_len = driver->sniffer.data.mab_len;
+    }
+  }
+  capture->has_break = false;
+  header.size = sizeof(header) + size;
+
+  // Drop the frame if the capture task has not made room for it
+  const uint32_t head = capture->head;
+  const uint32_t tail = __atomic_load_n(&capture->tail, __ATOMIC_ACQUIRE);
+  if (capture->size - (head - tail) < header.size) {
+    ++capture->num_dropped;
+    capture->is_dropping = true;
+    return;
+  }
+  if (capture->is_dropping) {
+    header.flags |= DMX_CAPTURE_FLAG_DROPPED;
+    capture->is_dropping = false;
+  }
+  dmx_capture_copy(capture, head, &header, sizeof(header));
+  dmx_capture_copy(capture, head + sizeof(header), data, size);
+  __atomic_store_n(&capture->head, head + header.size, __ATOMIC_RELEASE);
+  xTaskNotifyFromISR(capture->task, 0, eIncrement, task_awoken);
+}
+
+// Counts a measurement of a timing check and raises an event if it violates
+// the check and the last event of the check was long enough ago. Must be
+// called with the spinlock held.
+static void DMX_ISR_ATTR dmx_analyzer_count(dmx_analyzer_t *analyzer,
+                                            int check, uint32_t value,
+                                            bool is_valid, int64_t now,
+                                            int *task_awoken) {
+  dmx_analyzer_stat_t *const stat = &analyzer->stats.checks[check];
+  if (stat->num_checked == 0 || value < stat->min) {
+    stat->min = value;
+  }
+  if (value > stat->max) {
+    stat->max = value;
+  }
+  ++stat->num_checked;
+  if (is_valid) {
+    return;
+  }
+
+  ++stat->num_violations;
+  dmx_analyzer_pending_t *const pending = &analyzer->pending[check];
+  if (pending->num_violations == 0 || value < pending->min) {
+    pending->min = value;
+  }
+  if (pending->num_violations == 0 || value > pending->max) {
+    pending->max = value;
+  }
+  ++pending->num_violations;
+
+  // Violations are summarized by the next event if the queue is full
+  if (now - pending->last_event_ts >= analyzer->event_interval) {
+    const dmx_analyzer_event_t event = {.timestamp = now,
+                                        .check = check,
+                                        .num_violations =
+                                            pending->num_violations,
+                                        .min = pending->min,
+                                        .max = pending->max};
+    if (xQueueSendFromISR(analyzer->queue, &event, task_awoken)) {
+      pending->last_event_ts = now;
+      pending->num_violations = 0;
+    }
+  }
+}
+
+// Checks the break-to-break time and the slot count of the packet which was
+// ended by a received DMX break. Must be called with the spinlock held.
+static void DMX_ISR_ATTR dmx_analyzer_break(dmx_driver_t *driver,
+                                            dmx_analyzer_t *analyzer,
+                                            int64_t now, int *task_awoken) {
+  // The sniffer saw the break start, which is earlier than its interrupt
+  int64_t break_ts = now;
+  if (driver->sniffer.queue != NULL && driver->sniffer.last_neg_edge_ts > -1) {
+    break_ts = driver->sniffer.last_neg_edge_ts;
+  }
+
+  if (analyzer->last_break_ts > -1 && driver->data.head >= 0) {
+    const int64_t elapsed = break_ts - analyzer->last_break_ts;
+    const uint32_t pkt = elapsed < UINT32_MAX ? elapsed : UINT32_MAX;
+    dmx_analyzer_count(analyzer, DMX_ANALYZER_CHECK_BREAK_TO_BREAK, pkt,
+                       DMX_RX_PACKET_LEN_IS_VALID(pkt), now, task_awoken);
+    const uint32_t size = driver->data.head;
+    dmx_analyzer_count(analyzer, DMX_ANALYZER_CHECK_SLOT_COUNT, size,
+                       size > 0 && size <= DMX_MAX_PACKET_SIZE, now,
+                       task_awoken);
+  }
+  analyzer->last_break_ts = break_ts;
+}
+
+// Starts sending the pre-encoded DISC_UNIQUE_BRANCH response if the request in
+// the driver buffer is an intact broadcast and its bounds include the UID of
+// the port. The response is written by the timer interrupt once the
+// turnaround time has elapsed. Must be called with the spinlock held.
+static void DMX_ISR_ATTR rdm_disc_fast_path_respond(dmx_driver_t *driver) {
+  rdm_disc_fast_path_t *const fast_path = &rdm_disc_fast_path[driver->dmx_num];
+  const rdm_data_t *const rdm = (rdm_data_t *)driver->data.buffer;
+  const uint8_t *const bounds = (const uint8_t *)&rdm->pd;
+  if (rdm->pdl != 12 || driver->rdm.discovery_is_muted || driver->is_sending ||
+      !rdm_uid_is_broadcast(buf_to_uid(rdm->destination_uid)) ||
+      buf_to_uid(bounds) > fast_path->uid ||
+      buf_to_uid(bounds + 6) < fast_path->uid) {
+    return;
+  }
+
+  // Requests which were corrupted on the line must not be answered. The
+  // classifier has received the checksum which follows the message.
+  const uint8_t *const slots = driver->data.buffer;
+  const int message_len = rdm->message_len;
+  uint16_t checksum = 0;
+  for (int i = 0; i < message_len; ++i) {
+    checksum += slots[i];
+  }
+  if (checksum != (slots[message_len] << 8 | slots[message_len + 1])) {
+    return;
+  }
+
+  // Replace the request in the driver buffer with the response
+  memcpy(driver->data.buffer, fast_path->response, RDM_DISC_RESPONSE_SIZE);
+  driver->data.tx_size = RDM_DISC_RESPONSE_SIZE;
+  driver->data.head = 0;
+  driver->data.type = RDM_PACKET_TYPE_DISCOVERY_RESPONSE;
+  driver->data.sent_last = true;
+  fast_path->is_responding = true;
+  fast_path->receiver = driver->task_waiting;
+
+  // Turn the DMX bus around
+  dmx_uart_disable_interrupt(driver->uart, DMX_INTR_RX_ALL);
+  dmx_uart_set_rts(driver->uart, 0);
+  driver->is_in_break = false;
+  driver->is_sending = true;
+  DMX_TRACE(driver->dmx_num, DMX_TRACE_DISC_FAST_PATH, 0);
+
+  // The receive timer is paused - resume it and alarm after the turnaround
+  const uint64_t counter = dmx_timer_get_counter_in_isr(driver);
+  dmx_timer_set_alarm_in_isr(driver,
+                             counter + RDM_RESPOND_TO_REQUEST_PACKET_SPACING);
+  dmx_timer_resume_in_isr(driver);
+}
+
+// Returns true if the RDM packet in the driver buffer may need a response
+// from the port.
+static bool DMX_ISR_ATTR rdm_is_addressed_to_port(const dmx_driver_t *driver) {
+  const rdm_data_t *const rdm = (rdm_data_t *)driver->data.buffer;
+  const rdm_uid_t dest = buf_to_uid(rdm->destination_uid);
+  const rdm_uid_t uid = driver->rdm.uid;
+  const rdm_virtual_table_t *const table = &rdm_virtual_table[driver->dmx_num];
+  switch (driver->data.type) {
+    case RDM_PACKET_TYPE_DISCOVERY:
+      return true;
+    case RDM_PACKET_TYPE_BROADCAST:
+      // Virtual responders may use any manufacturer ID
+      return dest >> 32 == 0xffff || dest >> 32 == uid >> 32 ||
+             table->slots != NULL;
+    case RDM_PACKET_TYPE_REQUEST:
+      return dest == uid || rdm_virtual_lookup(table, dest) >= 0;
+    default:
+      return false;
+  }
+}
 
 static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
   const int64_t now = esp_timer_get_time();
@@ -81,10 +408,26 @@ static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
   spinlock_t *const restrict spinlock = &dmx_spinlock[driver->dmx_num];
   uart_dev_t *const restrict uart = driver->uart;
   int task_awoken = false;
+#ifdef CONFIG_DMX_PROFILE
+  ++dmx_profile[driver->dmx_num].isr_calls;
+#endif
 
   while (true) {
+#ifdef CONFIG_DMX_PROFILE
+    const uint32_t cycles = dmx_cpu_get_cycle_count();
+#endif
     const uint32_t intr_flags = dmx_uart_get_interrupt_status(uart);
     if (intr_flags == 0) break;
+#ifdef CONFIG_DMX_ISR_CAPTURE
+    const dmx_isr_capture_hook_t *const hook =
+        &dmx_isr_capture[driver->dmx_num];
+    dmx_isr_capture_t capture = {.timestamp = now,
+                                 .source = DMX_ISR_CAPTURE_UART,
+                                 .intr_flags = intr_flags};
+    if (hook->cb != NULL) {
+      capture.rx_len = dmx_uart_get_rxfifo_len(uart);
+    }
+#endif
 
     // DMX Receive ####################################################
     if (intr_flags & DMX_INTR_RX_ERR) {
@@ -96,6 +439,10 @@ static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
           uint8_t *data_ptr = &driver->data.buffer[driver->data.head];
           dmx_uart_read_rxfifo(uart, data_ptr, &read_len);
           driver->data.head += read_len;
+#ifdef CONFIG_DMX_ISR_CAPTURE
+          capture.rx_data = data_ptr;
+          capture.rx_read = read_len;
+#endif
         } else {
           // Data cannot be read into driver buffer
           if (driver->data.head > 0) {
@@ -114,11 +461,16 @@ static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
         driver->data.err = intr_flags & DMX_INTR_RX_FRAMING_ERR
                                ? ESP_FAIL
                                : ESP_ERR_NOT_FINISHED;
+        if (driver->data.head > dmx_capture[driver->dmx_num].captured) {
+          dmx_capture_frame(driver, DMX_CAPTURE_FLAG_RX_ERR, now,
+                            &task_awoken);
+        }
 
         // Notify the task if there is one waiting
         if (driver->task_waiting) {
           xTaskNotifyFromISR(driver->task_waiting, driver->data.head,
                              eSetValueWithOverwrite, &task_awoken);
+          DMX_TRACE(driver->dmx_num, DMX_TRACE_NOTIFY, driver->data.head);
         }
         taskEXIT_CRITICAL_ISR(spinlock);
       } else {
@@ -126,21 +478,19 @@ static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
         dmx_uart_rxfifo_reset(uart);
       }
       dmx_uart_clear_interrupt(uart, DMX_INTR_RX_ERR);
+      DMX_TRACE(driver->dmx_num, DMX_TRACE_RX_ERR, driver->data.head);
     }
 
     else if (intr_flags & DMX_INTR_RX_BREAK) {
+      DMX_TRACE(driver->dmx_num, DMX_TRACE_RX_BREAK, driver->data.head);
+
       // Reset the FIFO and clear the interrupt
       dmx_uart_rxfifo_reset(uart);
       dmx_uart_clear_interrupt(uart, DMX_INTR_RX_BREAK | DMX_INTR_RX_DATA);
 
       // Pause the receive timer alarm
-#if ESP_IDF_MAJOR_VERSION >= 5
-#error ESP-IDF v5 not supported yet!
-      // TODO
-#else
-      timer_group_set_counter_enable_in_isr(driver->timer_group,
-                                            driver->timer_idx, 0);
-#endif
+      dmx_timer_pause_in_isr(driver);
+      dmx_timing[driver->dmx_num].rx_break_ts = now;
 
       if (!driver->received_a_packet && driver->data.head > 0 &&
           driver->data.head < DMX_MAX_PACKET_SIZE) {
@@ -150,6 +500,18 @@ static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
       }
 
       taskENTER_CRITICAL_ISR(spinlock);
+      // Capture the frame which was ended by the break
+      if (driver->data.head > dmx_capture[driver->dmx_num].captured) {
+        dmx_capture_frame(driver, 0, driver->data.timestamp, &task_awoken);
+      }
+      dmx_capture[driver->dmx_num].has_break = true;
+
+      // Check the timing of the packet which was ended by the break
+      dmx_analyzer_t *const analyzer = &dmx_analyzer[driver->dmx_num];
+      if (analyzer->queue != NULL) {
+        dmx_analyzer_break(driver, analyzer, now, &task_awoken);
+      }
+
       // Set driver flags
       driver->is_in_break = true;
       driver->received_a_packet = false;
@@ -158,6 +520,12 @@ static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
     }
 
     else if (intr_flags & DMX_INTR_RX_DATA) {
+      // Record when the first slot of the packet arrived
+      if (driver->data.head == 0) {
+        dmx_timing[driver->dmx_num].rx_first_slot_ts = now;
+        dmx_capture[driver->dmx_num].captured = 0;
+      }
+
       // Read data from the FIFO into the driver buffer if possible
       if (driver->data.head >= 0 && driver->data.head < DMX_MAX_PACKET_SIZE) {
         // Data can be read into driver buffer
@@ -165,6 +533,10 @@ static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
         uint8_t *data_ptr = &driver->data.buffer[driver->data.head];
         dmx_uart_read_rxfifo(uart, data_ptr, &read_len);
         driver->data.head += read_len;
+#ifdef CONFIG_DMX_ISR_CAPTURE
+        capture.rx_data = data_ptr;
+        capture.rx_read = read_len;
+#endif
         if (driver->received_a_packet) {
           // Update expected size if already sent a packet notification
           driver->data.rx_size = driver->data.head;
@@ -178,15 +550,10 @@ static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
         dmx_uart_rxfifo_reset(uart);
       }
       dmx_uart_clear_interrupt(uart, DMX_INTR_RX_DATA);
+      DMX_TRACE(driver->dmx_num, DMX_TRACE_RX_DATA, driver->data.head);
 
       // Pause the receive timer alarm
-#if ESP_IDF_MAJOR_VERSION >= 5
-#error ESP-IDF v5 not supported yet!
-      // TODO
-#else
-      timer_group_set_counter_enable_in_isr(driver->timer_group,
-                                            driver->timer_idx, 0);
-#endif
+      dmx_timer_pause_in_isr(driver);
 
       // Set driver flags
       taskENTER_CRITICAL_ISR(spinlock);
@@ -197,64 +564,44 @@ static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
       // Determine if a complete packet has been received
       bool packet_is_complete = false;
       if (!driver->received_a_packet) {
-        const rdm_data_t *const rdm = (rdm_data_t *)driver->data.buffer;
-        if (rdm->sc == RDM_SC && rdm->sub_sc == RDM_SUB_SC) {
-          // The packet is a standard RDM packet
-          if (driver->data.head >= RDM_BASE_PACKET_SIZE &&
-              driver->data.head >= rdm->message_len + 2) {
-            if (rdm->cc == RDM_CC_DISC_COMMAND &&
-                rdm->pid == bswap16(RDM_PID_DISC_UNIQUE_BRANCH)) {
-              driver->data.type = RDM_PACKET_TYPE_DISCOVERY;
-            } else if (rdm_uid_is_broadcast(buf_to_uid(rdm->destination_uid))) {
-              driver->data.type = RDM_PACKET_TYPE_BROADCAST;
-            } else if (rdm->cc == RDM_CC_GET_COMMAND ||
-                       rdm->cc == RDM_CC_SET_COMMAND ||
-                       rdm->cc == RDM_CC_DISC_COMMAND) {
-              driver->data.type = RDM_PACKET_TYPE_REQUEST;
-            } else {
-              driver->data.type = RDM_PACKET_TYPE_RESPONSE;
-            }
-            packet_is_complete = true;
-          }
-        } else if (rdm->sc == RDM_PREAMBLE || rdm->sc == RDM_DELIMITER) {
-          // The packet is a DISC_UNIQUE_BRANCH response
-          if (driver->data.head >= 17) {
-            // Find the length of the preamble (0 to 7 bytes)
-            size_t preamble_len = 0;
-            for (; preamble_len < 7; ++preamble_len) {
-              if (driver->data.buffer[preamble_len] == RDM_DELIMITER) {
-                break;
-              }
-            }
-
-            if (driver->data.head >= preamble_len + 17) {
-              // DISC_UNIQUE_BRANCH responses should be 17 bytes after preamble
-              taskENTER_CRITICAL_ISR(spinlock);
-              driver->data.type = RDM_PACKET_TYPE_DISCOVERY_RESPONSE;
-              taskEXIT_CRITICAL_ISR(spinlock);
-              packet_is_complete = true;
-            }
-          }
-        } else {
-          // The packet is a DMX packet
-          if (driver->data.head >= driver->data.rx_size) {
-            taskENTER_CRITICAL_ISR(spinlock);
-            driver->data.type = RDM_PACKET_TYPE_NON_RDM;
-            taskEXIT_CRITICAL_ISR(spinlock);
-            packet_is_complete = true;
-          }
+        int type;
+        if (dmx_classify_packet(driver->data.buffer, driver->data.head,
+                                driver->data.rx_size, &type)) {
+          taskENTER_CRITICAL_ISR(spinlock);
+          driver->data.type = type;
+          taskEXIT_CRITICAL_ISR(spinlock);
+          packet_is_complete = true;
         }
       }
 
       // Notify tasks that the packet is complete
       if (packet_is_complete) {
+        rdm_responder_isr_t *const responder =
+            &rdm_responder_isr[driver->dmx_num];
+        dmx_timing[driver->dmx_num].rx_done_ts = now;
         taskENTER_CRITICAL_ISR(spinlock);
         driver->data.err = ESP_OK;
         driver->received_a_packet = true;
         driver->data.sent_last = false;
-        if (driver->task_waiting) {
+        DMX_TRACE(driver->dmx_num, DMX_TRACE_RX_PACKET, driver->data.type);
+        dmx_capture_frame(driver, 0, now, &task_awoken);
+        if (driver->data.type == RDM_PACKET_TYPE_DISCOVERY &&
+            rdm_disc_fast_path[driver->dmx_num].is_enabled) {
+          // DISC_UNIQUE_BRANCH is handled without notifying the task
+          rdm_disc_fast_path_respond(driver);
+        } else if (responder->is_enabled &&
+                   driver->data.type != RDM_PACKET_TYPE_NON_RDM &&
+                   !rdm_is_addressed_to_port(driver)) {
+          // The responder task does not need to wake for this packet
+          DMX_TRACE(driver->dmx_num, DMX_TRACE_RX_FILTERED, driver->data.type);
+        } else if (responder->is_enabled && !driver->task_waiting &&
+                   driver->data.type != RDM_PACKET_TYPE_NON_RDM) {
+          ++responder->num_dropped;
+          DMX_TRACE(driver->dmx_num, DMX_TRACE_RX_DROPPED, driver->data.type);
+        } else if (driver->task_waiting) {
           xTaskNotifyFromISR(driver->task_waiting, driver->data.head,
                              eSetValueWithOverwrite, &task_awoken);
+          DMX_TRACE(driver->dmx_num, DMX_TRACE_NOTIFY, driver->data.head);
         }
         taskEXIT_CRITICAL_ISR(spinlock);
       }
@@ -268,6 +615,7 @@ static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
       dmx_uart_write_txfifo(uart, src, &write_size);
       driver->data.head += write_size;
       dmx_uart_clear_interrupt(uart, DMX_INTR_TX_DATA);
+      DMX_TRACE(driver->dmx_num, DMX_TRACE_TX_DATA, driver->data.head);
 
       // Allow FIFO to empty when done writing data
       if (driver->data.head == driver->data.tx_size) {
@@ -279,16 +627,41 @@ static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
       // Disable write interrupts and clear the interrupt
       dmx_uart_disable_interrupt(uart, DMX_INTR_TX_ALL);
       dmx_uart_clear_interrupt(uart, DMX_INTR_TX_DONE);
+      DMX_TRACE(driver->dmx_num, DMX_TRACE_TX_DONE, driver->data.head);
 
       // Record timestamp, unset sending flag, and notify task
+      rdm_disc_fast_path_t *const fast_path =
+          &rdm_disc_fast_path[driver->dmx_num];
       taskENTER_CRITICAL_ISR(spinlock);
       driver->is_sending = false;
       driver->data.timestamp = now;
-      if (driver->task_waiting) {
+      dmx_timing[driver->dmx_num].tx_done_ts = now;
+      dmx_capture_frame(driver, DMX_CAPTURE_FLAG_SENT, now, &task_awoken);
+      dmx_analyzer[driver->dmx_num].last_break_ts = -1;
+      dmx_analyzer[driver->dmx_num].is_in_data = false;
+      if (driver->task_waiting &&
+          !(fast_path->is_responding &&
+            driver->task_waiting == fast_path->receiver)) {
         xTaskNotifyFromISR(driver->task_waiting, 0, eNoAction, &task_awoken);
+        DMX_TRACE(driver->dmx_num, DMX_TRACE_NOTIFY, 0);
       }
       taskEXIT_CRITICAL_ISR(spinlock);
 
+      // Resume receiving after a response sent by the interrupt handler
+      if (fast_path->is_responding) {
+        taskENTER_CRITICAL_ISR(spinlock);
+        fast_path->is_responding = false;
+        fast_path->receiver = NULL;
+        driver->received_a_packet = false;
+        driver->data.head = -1;  // Expecting a DMX break
+        dmx_uart_rxfifo_reset(uart);
+        dmx_uart_set_rts(uart, 1);
+        DMX_TRACE(driver->dmx_num, DMX_TRACE_RTS, 1);
+        dmx_uart_clear_interrupt(uart, DMX_INTR_RX_ALL);
+        dmx_uart_enable_interrupt(uart, DMX_INTR_RX_ALL);
+        taskEXIT_CRITICAL_ISR(spinlock);
+      }
+
       // Turn DMX bus around quickly if expecting an RDM response
       bool expecting_response = false;
       if (driver->data.type == RDM_PACKET_TYPE_DISCOVERY) {
@@ -303,11 +676,22 @@ static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
         driver->received_a_packet = false;
         dmx_uart_rxfifo_reset(uart);
         dmx_uart_set_rts(uart, 1);
+        DMX_TRACE(driver->dmx_num, DMX_TRACE_RTS, 1);
         dmx_uart_clear_interrupt(uart, DMX_INTR_RX_ALL);
         dmx_uart_enable_interrupt(uart, DMX_INTR_RX_ALL);
       }
       taskEXIT_CRITICAL_ISR(spinlock);
     }
+
+#ifdef CONFIG_DMX_ISR_CAPTURE
+    if (hook->cb != NULL) {
+      hook->cb(driver->dmx_num, &capture, hook->context);
+    }
+#endif
+#ifdef CONFIG_DMX_PROFILE
+    dmx_profile_add_isr(driver->dmx_num, intr_flags,
+                        dmx_cpu_get_cycle_count() - cycles);
+#endif
   }
 
   if (task_awoken) portYIELD_FROM_ISR();
@@ -316,9 +700,13 @@ static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
 static void DMX_ISR_ATTR dmx_gpio_isr(void *arg) {
   const int64_t now = esp_timer_get_time();
   dmx_driver_t *const driver = (dmx_driver_t *)arg;
+  dmx_analyzer_t *const analyzer = &dmx_analyzer[driver->dmx_num];
+  spinlock_t *const restrict spinlock = &dmx_spinlock[driver->dmx_num];
   int task_awoken = false;
+  const int level = dmx_uart_get_rx_level(driver->uart);
+  DMX_TRACE(driver->dmx_num, DMX_TRACE_GPIO_EDGE, level);
 
-  if (dmx_uart_get_rx_level(driver->uart)) {
+  if (level) {
     /* If this ISR is called on a positive edge and the current DMX frame is in
     a break and a negative edge timestamp has been recorded then a break has
     just finished. Therefore the DMX break length is able to be recorded. It can
@@ -328,6 +716,24 @@ static void DMX_ISR_ATTR dmx_gpio_isr(void *arg) {
       driver->sniffer.data.break_len = now - driver->sniffer.last_neg_edge_ts;
       driver->sniffer.is_in_mab = true;
       driver->is_in_break = false;
+
+      /* The slots of the previous packet have ended. The last mark before the
+      break is the mark before break, so it is not a mark between slots. A mark
+      is only longer than a slot can hold, which is the stop bits and all eight
+      data bits, if slots were sent apart. */
+      if (analyzer->queue != NULL && analyzer->is_in_data) {
+        const uint32_t slot_mark =
+            10000000 / dmx_uart_get_baud_rate(driver->uart);
+        const uint32_t mbs = analyzer->longest_mark > slot_mark
+                                 ? analyzer->longest_mark - slot_mark
+                                 : 0;
+        taskENTER_CRITICAL_ISR(spinlock);
+        dmx_analyzer_count(analyzer, DMX_ANALYZER_CHECK_MARK_BETWEEN_SLOTS,
+                           mbs, DMX_RX_MBS_LEN_IS_VALID(mbs), now,
+                           &task_awoken);
+        taskEXIT_CRITICAL_ISR(spinlock);
+      }
+      analyzer->is_in_data = false;
     }
     driver->sniffer.last_pos_edge_ts = now;
   } else {
@@ -342,6 +748,30 @@ static void DMX_ISR_ATTR dmx_gpio_isr(void *arg) {
       // Send the sniffer data to the queue
       xQueueOverwriteFromISR(driver->sniffer.queue, &driver->sniffer.data,
                              &task_awoken);
+
+      // Check the break and mark-after-break and start timing the slots
+      if (analyzer->queue != NULL) {
+        const uint32_t brk = driver->sniffer.data.break_len;
+        const uint32_t mab = driver->sniffer.data.mab_len;
+        taskENTER_CRITICAL_ISR(spinlock);
+        dmx_analyzer_count(analyzer, DMX_ANALYZER_CHECK_BREAK, brk,
+                           DMX_RX_BREAK_LEN_IS_VALID(brk), now,
+                           &task_awoken);
+        dmx_analyzer_count(analyzer, DMX_ANALYZER_CHECK_MAB, mab,
+                           DMX_RX_MAB_LEN_IS_VALID(mab), now,
+                           &task_awoken);
+        taskEXIT_CRITICAL_ISR(spinlock);
+        analyzer->is_in_data = true;
+        analyzer->longest_mark = 0;
+        analyzer->last_mark = 0;
+      }
+    } else if (analyzer->is_in_data) {
+      // Keep the longest mark, but hold back the latest in case it is the
+      // mark before break
+      if (analyzer->last_mark > analyzer->longest_mark) {
+        analyzer->longest_mark = analyzer->last_mark;
+      }
+      analyzer->last_mark = now - driver->sniffer.last_pos_edge_ts;
     }
     driver->sniffer.last_neg_edge_ts = now;
   }
@@ -352,50 +782,45 @@ static void DMX_ISR_ATTR dmx_gpio_isr(void *arg) {
 static bool DMX_ISR_ATTR dmx_timer_isr(void *arg) {
   dmx_driver_t *const restrict driver = (dmx_driver_t *)arg;
   int task_awoken = false;
+#ifdef CONFIG_DMX_ISR_CAPTURE
+  const dmx_isr_capture_hook_t *const hook = &dmx_isr_capture[driver->dmx_num];
+  if (hook->cb != NULL) {
+    const dmx_isr_capture_t capture = {.timestamp = esp_timer_get_time(),
+                                       .source = DMX_ISR_CAPTURE_TIMER};
+    hook->cb(driver->dmx_num, &capture, hook->context);
+  }
+#endif
 
   if (driver->is_sending) {
     if (driver->is_in_break) {
       dmx_uart_invert_tx(driver->uart, 0);
       driver->is_in_break = false;
+      DMX_TRACE(driver->dmx_num, DMX_TRACE_TIMER, 0);
 
       // Reset the alarm for the end of the DMX mark-after-break
-#if ESP_IDF_MAJOR_VERSION >= 5
-#error ESP-IDF v5 not supported yet!
-      // TODO
-#else
-      timer_group_set_alarm_value_in_isr(driver->timer_group, driver->timer_idx,
-                                         driver->mab_len);
-#endif
+      dmx_timer_set_alarm_in_isr(driver, driver->mab_len);
     } else {
       // Write data to the UART
+      DMX_TRACE(driver->dmx_num, DMX_TRACE_TIMER, 1);
       size_t write_size = driver->data.tx_size;
       dmx_uart_write_txfifo(driver->uart, driver->data.buffer, &write_size);
       driver->data.head += write_size;
 
       // Pause MAB timer alarm
-#if ESP_IDF_MAJOR_VERSION >= 5
-#error ESP-IDF v5 not supported yet!
-      // TODO
-#else
-      timer_group_set_counter_enable_in_isr(driver->timer_group,
-                                            driver->timer_idx, 0);
-#endif
+      dmx_timer_pause_in_isr(driver);
       // Enable DMX write interrupts
       dmx_uart_enable_interrupt(driver->uart, DMX_INTR_TX_ALL);
     }
   } else if (driver->task_waiting) {
-    // Notify the task
+    // Notify the task that the response timed out
+    DMX_TRACE(driver->dmx_num, DMX_TRACE_TIMER, 2);
+    driver->data.err = ESP_ERR_TIMEOUT;
     xTaskNotifyFromISR(driver->task_waiting, driver->data.head,
                        eSetValueWithOverwrite, &task_awoken);
+    DMX_TRACE(driver->dmx_num, DMX_TRACE_NOTIFY, driver->data.head);
 
     // Pause the receive timer alarm
-#if ESP_IDF_MAJOR_VERSION >= 5
-#error ESP-IDF v5 not supported yet!
-    // TODO
-#else
-    timer_group_set_counter_enable_in_isr(driver->timer_group,
-                                          driver->timer_idx, 0);
-#endif
+    dmx_timer_pause_in_isr(driver);
   }
 
   return task_awoken;
@@ -447,7 +872,7 @@ esp_err_t dmx_driver_install(dmx_port_t dmx_num, int intr_flags) {
   // Initialize driver state
   driver->dmx_num = dmx_num;
   driver->task_waiting = NULL;
-  driver->uart = UART_LL_GET_HW(dmx_num);
+  driver->uart = dmx_uart_get_dev(dmx_num);
 
   // Initialize driver flags
   driver->is_in_break = false;
@@ -457,6 +882,11 @@ esp_err_t dmx_driver_install(dmx_port_t dmx_num, int intr_flags) {
   driver->rdm.uid = 0;
   driver->rdm.discovery_is_muted = false;
   driver->rdm.tn = 0;
+  rdm_disc_fast_path[dmx_num].is_enabled = false;
+  rdm_disc_fast_path[dmx_num].is_responding = false;
+  rdm_disc_fast_path[dmx_num].receiver = NULL;
+  rdm_responder_isr[dmx_num].is_enabled = false;
+  rdm_responder_isr[dmx_num].num_dropped = 0;
 
   // Initialize the driver buffer
   bzero(driver->data.buffer, DMX_MAX_PACKET_SIZE);
@@ -470,23 +900,19 @@ esp_err_t dmx_driver_install(dmx_port_t dmx_num, int intr_flags) {
   driver->break_len = RDM_BREAK_LEN_US;
   driver->mab_len = RDM_MAB_LEN_US;
 
+  // Initialize the RDM timing
+  dmx_timing[dmx_num].tx_done_ts = 0;
+  dmx_timing[dmx_num].rx_first_slot_ts = 0;
+  dmx_timing[dmx_num].rdm_response_timeout =
+      RDM_CONTROLLER_RESPONSE_LOST_TIMEOUT;
+
   // Initialize sniffer in the disabled state
   driver->sniffer.queue = NULL;
 
   // Initialize the UART peripheral
   uart_dev_t *const restrict uart = driver->uart;
   taskENTER_CRITICAL(spinlock);
-  periph_module_enable(uart_periph_signal[dmx_num].module);
-  if (dmx_num != CONFIG_ESP_CONSOLE_UART_NUM) {
-#if SOC_UART_REQUIRE_CORE_RESET
-    // ESP32-C3 workaround to prevent UART outputting garbage data.
-    uart_ll_set_reset_core(uart, true);
-    periph_module_reset(uart_periph_signal[dmx_num].module);
-    uart_ll_set_reset_core(uart, false);
-#else
-    periph_module_reset(uart_periph_signal[dmx_num].module);
-#endif
-  }
+  dmx_uart_module_enable(dmx_num, uart);
   taskEXIT_CRITICAL(spinlock);
 
   // Initialize and flush the UART
@@ -499,27 +925,10 @@ esp_err_t dmx_driver_install(dmx_port_t dmx_num, int intr_flags) {
   dmx_uart_clear_interrupt(uart, DMX_ALL_INTR_MASK);
   dmx_uart_set_txfifo_empty(uart, DMX_UART_EMPTY_DEFAULT);
   dmx_uart_set_rxfifo_full(uart, DMX_UART_FULL_DEFAULT);
-  esp_intr_alloc(uart_periph_signal[dmx_num].irq, intr_flags, &dmx_uart_isr,
-                 driver, &driver->uart_isr_handle);
+  dmx_uart_isr_install(driver, intr_flags, &dmx_uart_isr);
 
   // Initialize hardware timer
-#if ESP_IDF_MAJOR_VERSION >= 5
-#error ESP-IDF v5 not supported yet!
-  // TODO
-#else
-  driver->timer_group = dmx_num / 2;
-  driver->timer_idx = dmx_num % 2;
-  const timer_config_t timer_config = {
-      .divider = 80,  // (80MHz / 80) == 1MHz resolution timer
-      .counter_dir = TIMER_COUNT_UP,
-      .counter_en = false,
-      .alarm_en = true,
-      .auto_reload = true,
-  };
-  timer_init(driver->timer_group, driver->timer_idx, &timer_config);
-  timer_isr_callback_add(driver->timer_group, driver->timer_idx, dmx_timer_isr,
-                         driver, intr_flags);
-#endif
+  dmx_timer_init(driver, dmx_timer_isr, intr_flags);
 
   // Enable UART read interrupt and set RTS low
   taskENTER_CRITICAL(spinlock);
@@ -550,28 +959,30 @@ esp_err_t dmx_driver_delete(dmx_port_t dmx_num) {
   vSemaphoreDelete(driver->mux);
 
   // Uninstall UART ISR
-  if (driver->uart_isr_handle != NULL) {
-    esp_intr_free(driver->uart_isr_handle);
-  }
+  dmx_uart_isr_uninstall(driver);
 
   // Uninstall sniffer ISR
   if (dmx_sniffer_is_enabled(dmx_num)) {
     dmx_sniffer_disable(dmx_num);
   }
 
+  // Stop the packet capture
+  if (dmx_capture_is_started(dmx_num)) {
+    dmx_capture_stop(dmx_num);
+  }
+
+  // Disable the timing analyzer
+  if (dmx_analyzer_is_enabled(dmx_num)) {
+    dmx_analyzer_disable(dmx_num);
+  }
+
   // Free driver data buffer
   if (driver->data.buffer != NULL) {
     heap_caps_free(driver->data.buffer);
   }
 
   // Free hardware timer ISR
-#if ESP_IDF_MAJOR_VERSION >= 5
-#error ESP-IDF v5 not supported yet!
-  // TODO
-#else
-  timer_isr_callback_remove(driver->timer_group, driver->timer_idx);
-  timer_deinit(driver->timer_group, driver->timer_idx);
-#endif
+  dmx_timer_deinit(driver);
 
   // Free driver
   heap_caps_free(driver);
@@ -579,9 +990,7 @@ esp_err_t dmx_driver_delete(dmx_port_t dmx_num) {
 
   // Disable UART module
   taskENTER_CRITICAL(spinlock);
-  if (dmx_num != CONFIG_ESP_CONSOLE_UART_NUM) {
-    periph_module_disable(uart_periph_signal[dmx_num].module);
-  }
+  dmx_uart_module_disable(dmx_num);
   taskEXIT_CRITICAL(spinlock);
 
   return ESP_OK;
@@ -601,7 +1010,7 @@ esp_err_t dmx_set_pin(dmx_port_t dmx_num, int tx_pin, int rx_pin, int rts_pin) {
   DMX_CHECK(rts_pin < 0 || GPIO_IS_VALID_OUTPUT_GPIO(rts_pin),
             ESP_ERR_INVALID_ARG, "rts_pin error");
 
-  return uart_set_pin(dmx_num, tx_pin, rx_pin, rts_pin, DMX_PIN_NO_CHANGE);
+  return dmx_uart_set_pin(dmx_num, tx_pin, rx_pin, rts_pin);
 }
 
 esp_err_t dmx_sniffer_enable(dmx_port_t dmx_num, int intr_pin) {
@@ -682,6 +1091,246 @@ bool dmx_sniffer_get_data(dmx_port_t dmx_num, dmx_metadata_t *metadata,
   return xQueueReceive(driver->sniffer.queue, metadata, wait_ticks);
 }
 
+// Writes all of the bytes to the sink of a packet capture. Returns false if
+// the sink stopped accepting bytes while the capture was stopping.
+static bool dmx_capture_write(dmx_capture_t *capture, const void *data,
+                              size_t size) {
+  const uint8_t *src = data;
+  while (size > 0) {
+    const size_t written =
+        capture->config.sink(src, size, capture->config.context);
+    if (written == 0) {
+      if (__atomic_load_n(&capture->is_stopping, __ATOMIC_ACQUIRE)) {
+        return false;
+      }
+      vTaskDelay(1);
+      continue;
+    }
+    src += written;
+    size -= written;
+  }
+  return true;
+}
+
+static void dmx_capture_task(void *arg) {
+  const dmx_port_t dmx_num = (intptr_t)arg;
+  dmx_capture_t *const capture = &dmx_capture[dmx_num];
+
+  const dmx_capture_stream_header_t stream_header = {
+      .magic = DMX_CAPTURE_MAGIC,
+      .version = DMX_CAPTURE_VERSION,
+      .dmx_num = dmx_num,
+      .header_size = sizeof(dmx_capture_header_t)};
+  bool is_writing = dmx_capture_write(capture, &stream_header,
+                                      sizeof(stream_header));
+
+  while (is_writing) {
+    // Check if stopping before draining so that the last frames are written
+    const bool is_stopping =
+        __atomic_load_n(&capture->is_stopping, __ATOMIC_ACQUIRE);
+    const uint32_t head = __atomic_load_n(&capture->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = capture->tail;
+    while (tail != head && is_writing) {
+      // Write the bytes up to the head or the end of the buffer
+      const uint32_t offset = tail & (capture->size - 1);
+      size_t size = head - tail;
+      if (size > capture->size - offset) {
+        size = capture->size - offset;
+      }
+      is_writing = dmx_capture_write(capture, capture->buffer + offset, size);
+      tail += size;
+      __atomic_store_n(&capture->tail, tail, __ATOMIC_RELEASE);
+    }
+    if (is_stopping) {
+      break;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+
+  xSemaphoreGive(capture->stopped);
+  vTaskDelete(NULL);
+}
+
+esp_err_t dmx_capture_start(dmx_port_t dmx_num,
+                            const dmx_capture_config_t *config) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG, "dmx_num error");
+  DMX_CHECK(config != NULL && config->sink != NULL, ESP_ERR_INVALID_ARG,
+            "config error");
+  DMX_CHECK(config->buffer_size >= 1024 &&
+                !(config->buffer_size & (config->buffer_size - 1)),
+            ESP_ERR_INVALID_ARG, "buffer_size error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), ESP_ERR_INVALID_STATE,
+            "driver is not installed");
+  DMX_CHECK(!dmx_capture_is_started(dmx_num), ESP_ERR_INVALID_STATE,
+            "capture is already started");
+
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  dmx_capture_t *const capture = &dmx_capture[dmx_num];
+
+  // The buffer is written by the interrupt handler so it must be internal
+  uint8_t *const buffer = heap_caps_malloc(
+      config->buffer_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  capture->stopped = xSemaphoreCreateBinary();
+  if (buffer == NULL || capture->stopped == NULL) {
+    ESP_LOGE(TAG, "DMX capture malloc error");
+    goto err;
+  }
+  capture->buffer = buffer;
+  capture->size = config->buffer_size;
+  capture->head = 0;
+  capture->tail = 0;
+  capture->num_dropped = 0;
+  capture->is_dropping = false;
+  capture->captured = DMX_MAX_PACKET_SIZE;  // Skip a frame in progress
+  capture->has_break = false;
+  capture->config = *config;
+  capture->is_stopping = false;
+  if (xTaskCreatePinnedToCore(dmx_capture_task, "dmx_capture",
+                              config->stack_size, (void *)(intptr_t)dmx_num,
+                              config->priority, &capture->task,
+                              config->core_id) != pdPASS) {
+    ESP_LOGE(TAG, "DMX capture task create error");
+    capture->buffer = NULL;
+    goto err;
+  }
+
+  // Start writing frames once the task can be notified
+  taskENTER_CRITICAL(spinlock);
+  capture->is_running = true;
+  taskEXIT_CRITICAL(spinlock);
+
+  return ESP_OK;
+
+err:
+  heap_caps_free(buffer);
+  if (capture->stopped != NULL) {
+    vSemaphoreDelete(capture->stopped);
+    capture->stopped = NULL;
+  }
+  return ESP_ERR_NO_MEM;
+}
+
+esp_err_t dmx_capture_stop(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG, "dmx_num error");
+  DMX_CHECK(dmx_capture_is_started(dmx_num), ESP_ERR_INVALID_STATE,
+            "capture is not started");
+
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  dmx_capture_t *const capture = &dmx_capture[dmx_num];
+
+  // Stop writing frames, then wait for the task to drain the buffer
+  taskENTER_CRITICAL(spinlock);
+  capture->is_running = false;
+  taskEXIT_CRITICAL(spinlock);
+  __atomic_store_n(&capture->is_stopping, true, __ATOMIC_RELEASE);
+  xTaskNotify(capture->task, 0, eIncrement);
+  xSemaphoreTake(capture->stopped, portMAX_DELAY);
+
+  vSemaphoreDelete(capture->stopped);
+  capture->stopped = NULL;
+  heap_caps_free(capture->buffer);
+  capture->buffer = NULL;
+
+  return ESP_OK;
+}
+
+bool dmx_capture_is_started(dmx_port_t dmx_num) {
+  return dmx_num < DMX_NUM_MAX && dmx_capture[dmx_num].buffer != NULL;
+}
+
+uint32_t dmx_capture_get_num_dropped(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  const uint32_t num_dropped = dmx_capture[dmx_num].num_dropped;
+  taskEXIT_CRITICAL(spinlock);
+
+  return num_dropped;
+}
+
+esp_err_t dmx_analyzer_enable(dmx_port_t dmx_num,
+                              const dmx_analyzer_config_t *config) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG, "dmx_num error");
+  DMX_CHECK(config != NULL, ESP_ERR_INVALID_ARG, "config is null");
+  DMX_CHECK(config->queue_size > 0, ESP_ERR_INVALID_ARG, "queue_size error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), ESP_ERR_INVALID_STATE,
+            "driver is not installed");
+  DMX_CHECK(!dmx_analyzer_is_enabled(dmx_num), ESP_ERR_INVALID_STATE,
+            "analyzer is already enabled");
+
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  dmx_analyzer_t *const analyzer = &dmx_analyzer[dmx_num];
+
+  const QueueHandle_t queue =
+      xQueueCreate(config->queue_size, sizeof(dmx_analyzer_event_t));
+  if (queue == NULL) {
+    ESP_LOGE(TAG, "DMX analyzer queue malloc error");
+    return ESP_ERR_NO_MEM;
+  }
+
+  // Reset the analyzer so that the first violation of each check is raised
+  const int64_t event_interval = config->event_interval_ms * 1000LL;
+  const int64_t now = esp_timer_get_time();
+  taskENTER_CRITICAL(spinlock);
+  memset(analyzer, 0, sizeof(*analyzer));
+  analyzer->event_interval = event_interval;
+  analyzer->last_break_ts = -1;
+  for (int i = 0; i < DMX_ANALYZER_CHECK_MAX; ++i) {
+    analyzer->pending[i].last_event_ts = now - event_interval;
+  }
+  analyzer->queue = queue;
+  taskEXIT_CRITICAL(spinlock);
+
+  return ESP_OK;
+}
+
+esp_err_t dmx_analyzer_disable(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG, "dmx_num error");
+  DMX_CHECK(dmx_analyzer_is_enabled(dmx_num), ESP_ERR_INVALID_STATE,
+            "analyzer is not enabled");
+
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  dmx_analyzer_t *const analyzer = &dmx_analyzer[dmx_num];
+
+  taskENTER_CRITICAL(spinlock);
+  const QueueHandle_t queue = analyzer->queue;
+  analyzer->queue = NULL;
+  analyzer->is_in_data = false;
+  taskEXIT_CRITICAL(spinlock);
+  vQueueDelete(queue);
+
+  return ESP_OK;
+}
+
+bool dmx_analyzer_is_enabled(dmx_port_t dmx_num) {
+  return dmx_num < DMX_NUM_MAX && dmx_analyzer[dmx_num].queue != NULL;
+}
+
+bool dmx_analyzer_get_stats(dmx_port_t dmx_num, dmx_analyzer_stats_t *stats) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(stats != NULL, false, "stats is null");
+  DMX_CHECK(dmx_analyzer_is_enabled(dmx_num), false,
+            "analyzer is not enabled");
+
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  *stats = dmx_analyzer[dmx_num].stats;
+  taskEXIT_CRITICAL(spinlock);
+
+  return true;
+}
+
+bool dmx_analyzer_get_event(dmx_port_t dmx_num, dmx_analyzer_event_t *event,
+                            TickType_t wait_ticks) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(event != NULL, false, "event is null");
+  DMX_CHECK(dmx_analyzer_is_enabled(dmx_num), false,
+            "analyzer is not enabled");
+
+  return xQueueReceive(dmx_analyzer[dmx_num].queue, event, wait_ticks);
+}
+
 uint32_t dmx_set_baud_rate(dmx_port_t dmx_num, uint32_t baud_rate) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
 
@@ -851,9 +1500,11 @@ size_t dmx_write(dmx_port_t dmx_num, const void *source, size_t size) {
     // Flip the bus to stop writes from being overwritten by incoming data
     dmx_uart_disable_interrupt(uart, DMX_INTR_RX_ALL);
     dmx_uart_set_rts(uart, 0);
+    DMX_TRACE(dmx_num, DMX_TRACE_RTS, 0);
   }
   driver->data.tx_size = size;  // Update driver transmit size
   taskEXIT_CRITICAL(spinlock);
+  DMX_TRACE(dmx_num, DMX_TRACE_WRITE, size);
 
   // Copy data from the source to the driver buffer asynchronously
   memcpy(driver->data.buffer, source, size);
@@ -888,6 +1539,7 @@ size_t dmx_write_offset(dmx_port_t dmx_num, size_t offset, const void *source,
     // Flip the bus to stop writes from being overwritten by incoming data
     dmx_uart_disable_interrupt(uart, DMX_INTR_RX_ALL);
     dmx_uart_set_rts(uart, 0);
+    DMX_TRACE(dmx_num, DMX_TRACE_RTS, 0);
   }
   driver->data.tx_size = offset + size;  // Update driver transmit size
   taskEXIT_CRITICAL(spinlock);
@@ -916,6 +1568,7 @@ int dmx_write_slot(dmx_port_t dmx_num, size_t slot_num, uint8_t value) {
     // Flip the bus to stop writes from being overwritten by incoming data
     dmx_uart_disable_interrupt(uart, DMX_INTR_RX_ALL);
     dmx_uart_set_rts(uart, 0);
+    DMX_TRACE(dmx_num, DMX_TRACE_RTS, 0);
   }
 
   // Ensure that the next packet to be sent includes this slot
@@ -966,12 +1619,14 @@ size_t dmx_receive(dmx_port_t dmx_num, dmx_packet_t *packet,
   }
 
   // Set the RTS pin to read from the DMX bus
+  DMX_TRACE(dmx_num, DMX_TRACE_RECEIVE, 0);
   uart_dev_t *const restrict uart = driver->uart;
   taskENTER_CRITICAL(spinlock);
   if (dmx_uart_get_rts(uart) == 0) {
     dmx_uart_disable_interrupt(uart, DMX_INTR_TX_ALL);
     xTaskNotifyStateClear(xTaskGetCurrentTaskHandle());
     dmx_uart_set_rts(uart, 1);
+    DMX_TRACE(dmx_num, DMX_TRACE_RTS, 1);
     dmx_uart_enable_interrupt(uart, DMX_INTR_RX_ALL);
     driver->data.head = -1;  // Wait for DMX break before reading data
   }
@@ -1003,26 +1658,18 @@ size_t dmx_receive(dmx_port_t dmx_num, dmx_packet_t *packet,
     // An RDM response is expected in <10ms so a hardware timer may be needed
     taskENTER_CRITICAL(spinlock);
     const int64_t elapsed = esp_timer_get_time() - driver->data.timestamp;
-    if (elapsed < RDM_CONTROLLER_RESPONSE_LOST_TIMEOUT) {
+    const uint32_t response_timeout = dmx_timing[dmx_num].rdm_response_timeout;
+    if (elapsed < response_timeout) {
       // Start a timer alarm that triggers when the RDM timeout occurs
-#if ESP_IDF_MAJOR_VERSION >= 5
-#error ESP-IDF v5 not supported yet!
-      // TODO
-#else
-      const timer_group_t timer_group = driver->timer_group;
-      const timer_idx_t timer_idx = driver->timer_idx;
-      timer_set_counter_value(timer_group, timer_idx, elapsed);
-      timer_set_alarm_value(timer_group, timer_idx,
-                            RDM_CONTROLLER_RESPONSE_LOST_TIMEOUT);
-      timer_start(timer_group, timer_idx);
-#endif
+      dmx_timer_start(driver, elapsed, response_timeout);
     }
     taskEXIT_CRITICAL(spinlock);
 
     // Check if the response has already timed out
-    if (elapsed >= RDM_CONTROLLER_RESPONSE_LOST_TIMEOUT) {
+    if (elapsed >= response_timeout) {
       driver->task_waiting = NULL;
       xTaskNotifyStateClear(xTaskGetCurrentTaskHandle());
+      DMX_TRACE(dmx_num, DMX_TRACE_RECEIVED, 0);
       xSemaphoreGiveRecursive(driver->mux);
       if (packet != NULL) {
         packet->err = ESP_ERR_TIMEOUT;
@@ -1040,6 +1687,16 @@ size_t dmx_receive(dmx_port_t dmx_num, dmx_packet_t *packet,
     if (packet_size == -1) {
       packet_size = 0;
     }
+#ifdef CONFIG_DMX_PROFILE
+    // Packets without a break, e.g. DISC_UNIQUE_BRANCH responses, are skipped
+    const dmx_timing_t *const timing = &dmx_timing[dmx_num];
+    if (packet_size > 0 && timing->rx_break_ts > timing->tx_done_ts) {
+      const int64_t wake_us = esp_timer_get_time() - timing->rx_break_ts;
+      taskENTER_CRITICAL(spinlock);
+      dmx_profile_add(&dmx_profile[dmx_num].rx_wake_us, wake_us);
+      taskEXIT_CRITICAL(spinlock);
+    }
+#endif
   } else {
     err = ESP_ERR_TIMEOUT;
   }
@@ -1068,6 +1725,7 @@ size_t dmx_receive(dmx_port_t dmx_num, dmx_packet_t *packet,
   }
 
   // Give the mutex back and return
+  DMX_TRACE(dmx_num, DMX_TRACE_RECEIVED, packet_size);
   xSemaphoreGiveRecursive(driver->mux);
   return packet_size;
 }
@@ -1078,6 +1736,9 @@ size_t dmx_send(dmx_port_t dmx_num, size_t size) {
 
   spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
   dmx_driver_t *const driver = dmx_driver[dmx_num];
+#ifdef CONFIG_DMX_PROFILE
+  const int64_t call_ts = esp_timer_get_time();
+#endif
 
   // Block until the mutex can be taken
   if (!xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY)) {
@@ -1122,35 +1783,21 @@ size_t dmx_send(dmx_port_t dmx_num, size_t size) {
   }
   elapsed = esp_timer_get_time() - driver->data.timestamp;
   if (elapsed < timeout) {
-#if ESP_IDF_MAJOR_VERSION >= 5
-#error ESP-IDF v5 not supported yet!
-    // TODO
-#else
-    timer_set_counter_value(driver->timer_group, driver->timer_idx, elapsed);
-    timer_set_alarm_value(driver->timer_group, driver->timer_idx, timeout);
-    timer_start(driver->timer_group, driver->timer_idx);
-#endif
+    dmx_timer_start(driver, elapsed, timeout);
     driver->task_waiting = xTaskGetCurrentTaskHandle();
   }
   taskEXIT_CRITICAL(spinlock);
 
-  // Block if an alarm was set
+  // Block if an alarm was set. Data received while blocked pauses the alarm,
+  // so the wait is bounded and the packet spacing has elapsed if it expires.
   if (elapsed < timeout) {
-    bool notified = xTaskNotifyWait(0, ULONG_MAX, NULL, portMAX_DELAY);
+    const TickType_t wait_ticks = pdMS_TO_TICKS((timeout + 999) / 1000) + 1;
+    bool notified = xTaskNotifyWait(0, UINT32_MAX, NULL, wait_ticks);
     if (!notified) {
-#if ESP_IDF_MAJOR_VERSION >= 5
-#error ESP-IDF v5 not supported yet!
-      // TODO
-#else
-      timer_pause(driver->timer_group, driver->timer_idx);
-#endif
+      dmx_timer_pause(driver);
       xTaskNotifyStateClear(driver->task_waiting);
     }
     driver->task_waiting = NULL;
-    if (!notified) {
-      xSemaphoreGiveRecursive(driver->mux);
-      return 0;
-    }
   }
 
   // Turn the DMX bus around and get the send size
@@ -1160,6 +1807,7 @@ size_t dmx_send(dmx_port_t dmx_num, size_t size) {
     dmx_uart_disable_interrupt(uart, DMX_INTR_RX_ALL);
     xTaskNotifyStateClear(xTaskGetCurrentTaskHandle());
     dmx_uart_set_rts(uart, 0);
+    DMX_TRACE(dmx_num, DMX_TRACE_RTS, 0);
   }
   taskEXIT_CRITICAL(spinlock);
 
@@ -1219,19 +1867,18 @@ size_t dmx_send(dmx_port_t dmx_num, size_t size) {
     driver->data.head = 0;
     driver->is_in_break = true;
     driver->is_sending = true;
-#if ESP_IDF_MAJOR_VERSION >= 5
-#error ESP-IDF v5 not supported yet!
-    // TODO
-#else
-    timer_set_counter_value(driver->timer_group, driver->timer_idx, 0);
-    timer_set_alarm_value(driver->timer_group, driver->timer_idx,
-                          driver->break_len);
-    timer_start(driver->timer_group, driver->timer_idx);
-#endif
+    dmx_timer_start(driver, 0, driver->break_len);
 
     dmx_uart_invert_tx(uart, 1);
     taskEXIT_CRITICAL(spinlock);
   }
+  DMX_TRACE(dmx_num, DMX_TRACE_SEND, size);
+#ifdef CONFIG_DMX_PROFILE
+  const int64_t break_us = esp_timer_get_time() - call_ts;
+  taskENTER_CRITICAL(spinlock);
+  dmx_profile_add(&dmx_profile[dmx_num].tx_break_us, break_us);
+  taskEXIT_CRITICAL(spinlock);
+#endif
 
   // Give the mutex back
   xSemaphoreGiveRecursive(driver->mux);
@@ -1281,3 +1928,93 @@ bool dmx_wait_sent(dmx_port_t dmx_num, TickType_t wait_ticks) {
   xSemaphoreGiveRecursive(driver->mux);
   return result;
 }
+
+bool dmx_get_profile(dmx_port_t dmx_num, dmx_profile_t *profile) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(profile != NULL, false, "profile is null");
+
+#ifdef CONFIG_DMX_PROFILE
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  *profile = dmx_profile[dmx_num];
+  taskEXIT_CRITICAL(spinlock);
+  return true;
+#else
+  return false;
+#endif
+}
+
+void dmx_reset_profile(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, , "dmx_num error");
+
+#ifdef CONFIG_DMX_PROFILE
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  memset(&dmx_profile[dmx_num], 0, sizeof(dmx_profile_t));
+  taskEXIT_CRITICAL(spinlock);
+#endif
+}
+
+esp_err_t dmx_set_isr_capture_cb(dmx_port_t dmx_num, dmx_isr_capture_cb_t cb,
+                                 void *context) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG, "dmx_num error");
+
+#ifdef CONFIG_DMX_ISR_CAPTURE
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  dmx_isr_capture[dmx_num].cb = cb;
+  dmx_isr_capture[dmx_num].context = context;
+  taskEXIT_CRITICAL(spinlock);
+  return ESP_OK;
+#else
+  return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+size_t dmx_trace_drain(dmx_port_t dmx_num, dmx_trace_record_t *records,
+                       size_t size, uint32_t *num_lost) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(records != NULL || size == 0, 0, "records is null");
+
+  uint32_t lost = 0;
+  size_t num_drained = 0;
+#ifdef CONFIG_DMX_TRACE
+  dmx_trace_t *const trace = &dmx_trace[dmx_num];
+  uint32_t tail = trace->tail;
+  while (num_drained < size) {
+    const uint32_t head = __atomic_load_n(&trace->head, __ATOMIC_ACQUIRE);
+    if (head - tail > CONFIG_DMX_TRACE_SIZE) {
+      // The oldest records have been overwritten
+      lost += head - tail - CONFIG_DMX_TRACE_SIZE;
+      tail = head - CONFIG_DMX_TRACE_SIZE;
+    } else if (head == tail) {
+      break;
+    }
+
+    // Copy the record and check that it was not written while it was copied
+    const dmx_trace_record_t *const record =
+        &trace->records[tail & (CONFIG_DMX_TRACE_SIZE - 1)];
+    const uint8_t seq = dmx_trace_seq(tail);
+    if (__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) != seq) {
+      if (__atomic_load_n(&trace->head, __ATOMIC_RELAXED) - tail >
+          CONFIG_DMX_TRACE_SIZE) {
+        continue;  // The record was overwritten
+      }
+      break;  // The record is still being written
+    }
+    records[num_drained] = *record;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&record->seq, __ATOMIC_RELAXED) != seq) {
+      continue;  // The record was overwritten while it was copied
+    }
+    ++num_drained;
+    ++tail;
+  }
+  trace->tail = tail;
+#endif
+
+  if (num_lost != NULL) {
+    *num_lost = lost;
+  }
+  return num_drained;
+}
@@ -138,6 +138,120 @@ bool dmx_sniffer_is_enabled(dmx_port_t dmx_num);
 bool dmx_sniffer_get_data(dmx_port_t dmx_num, dmx_metadata_t *metadata,
                           TickType_t wait_ticks);
 
+/**
+ * @brief Starts a packet capture on a DMX port. Every frame which the port
+ * receives or sends is written by the interrupt handler to a capture buffer,
+ * with its DMX break and mark-after-break, its flags, its RDM classification
+ * and its timestamp. A capture task drains the buffer to the sink. The stream
+ * starts with a dmx_capture_stream_header_t, and each frame is a
+ * dmx_capture_header_t followed by its slots. Frames are dropped, and the
+ * next frame is flagged with DMX_CAPTURE_FLAG_DROPPED, if the sink cannot keep
+ * up. The DMX break and mark-after-break of received frames are only measured
+ * while the DMX sniffer is enabled.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] config A pointer to the capture configuration.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there was an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the driver is not installed or the capture
+ * is already started.
+ * @retval ESP_ERR_NO_MEM if the capture buffer or task could not be created.
+ */
+esp_err_t dmx_capture_start(dmx_port_t dmx_num,
+                            const dmx_capture_config_t *config);
+
+/**
+ * @brief Stops the packet capture on a DMX port. Frames in the capture buffer
+ * are written to the sink before this function returns.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there was an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the capture is not started.
+ */
+esp_err_t dmx_capture_stop(dmx_port_t dmx_num);
+
+/**
+ * @brief Checks if a packet capture is started on a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the capture is started.
+ * @return false if it is not, or the DMX port does not exist.
+ */
+bool dmx_capture_is_started(dmx_port_t dmx_num);
+
+/**
+ * @brief Gets the number of frames which were dropped by the packet capture
+ * of a DMX port since it was started because the capture buffer was full.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The number of dropped frames.
+ */
+uint32_t dmx_capture_get_num_dropped(dmx_port_t dmx_num);
+
+/**
+ * @brief Enables the DMX timing analyzer on a DMX port. The interrupt handlers
+ * check every received packet against the receive timing limits of E1.11 in
+ * dmx_types.h and count the violations and the extremes of each check. A
+ * packet is checked when the DMX break of the next packet is received. The
+ * DMX break, mark-after-break and marks between slots are only checked while
+ * the DMX sniffer is enabled. Violations raise events, which are rate limited
+ * per check and are read with dmx_analyzer_get_event().
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] config A pointer to the analyzer configuration.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there was an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the driver is not installed or the analyzer
+ * is already enabled.
+ * @retval ESP_ERR_NO_MEM if the event queue could not be created.
+ */
+esp_err_t dmx_analyzer_enable(dmx_port_t dmx_num,
+                              const dmx_analyzer_config_t *config);
+
+/**
+ * @brief Disables the DMX timing analyzer on a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there was an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the analyzer is not enabled.
+ */
+esp_err_t dmx_analyzer_disable(dmx_port_t dmx_num);
+
+/**
+ * @brief Checks if the DMX timing analyzer is enabled on a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the analyzer is enabled.
+ * @return false if it is not, or the DMX port does not exist.
+ */
+bool dmx_analyzer_is_enabled(dmx_port_t dmx_num);
+
+/**
+ * @brief Copies the counters of the DMX timing analyzer of a DMX port, which
+ * are counted from when it was enabled.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] stats A pointer into which to copy the counters.
+ * @return true if the counters were copied.
+ * @return false if the analyzer is not enabled or there was an argument error.
+ */
+bool dmx_analyzer_get_stats(dmx_port_t dmx_num, dmx_analyzer_stats_t *stats);
+
+/**
+ * @brief Gets the next event of the DMX timing analyzer of a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] event A pointer into which to copy the event.
+ * @param wait_ticks The number of ticks to wait before this function times out.
+ * @return true if an event was copied.
+ * @return false if there was no event, the analyzer is not enabled, or there
+ * was an argument error.
+ */
+bool dmx_analyzer_get_event(dmx_port_t dmx_num, dmx_analyzer_event_t *event,
+                            TickType_t wait_ticks);
+
 /**
  * @brief Sets the DMX baud rate. The baud rate will be clamped to DMX
  * specification. If the input baud rate is lower than DMX_MIN_BAUD_RATE it will
@@ -333,6 +447,70 @@ size_t dmx_send(dmx_port_t dmx_num, size_t size);
  */
 bool dmx_wait_sent(dmx_port_t dmx_num, TickType_t wait_ticks);
 
+/**
+ * @brief Gets the profiling counters of a DMX port. The counters measure the
+ * time spent in each branch of the UART interrupt handler and the latencies of
+ * dmx_receive() and dmx_send(), and are only gathered when the driver is built
+ * with CONFIG_DMX_PROFILE.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] profile A pointer into which to copy the profiling counters.
+ * @retval true on success.
+ * @retval false if the driver was built without CONFIG_DMX_PROFILE or there
+ * was an argument error.
+ */
+bool dmx_get_profile(dmx_port_t dmx_num, dmx_profile_t *profile);
+
+/**
+ * @brief Resets the profiling counters of a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_reset_profile(dmx_port_t dmx_num);
+
+/**
+ * @brief Sets a callback which receives what the interrupt handlers of a DMX
+ * port read from the UART and timer: the interrupt flags, the length of the
+ * RX FIFO and the bytes read from it. Captures of a DMX port on hardware can
+ * be replayed into the unmodified interrupt handlers on the host with
+ * host/tools/dmx_replay.c, which documents the text format of a capture. The
+ * callback is called from the interrupt handlers, once per pass of the UART
+ * interrupt handler loop, so it must be quick and placed in IRAM. It is only
+ * called when the driver is built with CONFIG_DMX_ISR_CAPTURE.
+ *
+ * @param dmx_num The DMX port number.
+ * @param cb The callback, or NULL to stop capturing.
+ * @param context The context passed to the callback.
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_ARG if there was an argument error.
+ * @return ESP_ERR_NOT_SUPPORTED if the driver was built without
+ * CONFIG_DMX_ISR_CAPTURE.
+ */
+esp_err_t dmx_set_isr_capture_cb(dmx_port_t dmx_num, dmx_isr_capture_cb_t cb,
+                                 void *context);
+
+/**
+ * @brief Copies the oldest records from the trace of a DMX port and removes
+ * them from the trace. The trace is a ring of CONFIG_DMX_TRACE_SIZE records
+ * which are written by the interrupt handlers and the send and receive
+ * functions, and is only recorded when the driver is built with
+ * CONFIG_DMX_TRACE. When the trace is not drained quickly enough, the oldest
+ * records are overwritten and counted as lost. The records may be decoded
+ * into a timeline with host/tools/dmx_trace_decode.c.
+ *
+ * @note Only one task may drain the trace of a DMX port at a time.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] records A pointer into which to copy the trace records.
+ * @param size The maximum number of records to copy.
+ * @param[out] num_lost A pointer into which to write the number of records
+ * which were overwritten before they could be drained, or NULL.
+ * @return The number of records which were copied. Always 0 if the driver
+ * was built without CONFIG_DMX_TRACE.
+ */
+size_t dmx_trace_drain(dmx_port_t dmx_num, dmx_trace_record_t *records,
+                       size_t size, uint32_t *num_lost);
+
 #ifdef __cplusplus
 }
 #endif
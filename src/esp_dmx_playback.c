@@ -0,0 +1,339 @@
+#include "esp_dmx_playback.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+// Used for argument checking at the beginning of each function.
+#define DMX_PLAYBACK_CHECK(a, err_code, format, ...) \
+  ESP_RETURN_ON_FALSE(a, err_code, TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "dmx_playback";  // The log tagline for the file.
+
+typedef struct dmx_playback_t {
+  dmx_port_t dmx_num;             // The DMX port on which frames are sent.
+  dmx_playback_config_t config;   // The playback configuration.
+  esp_timer_handle_t timer;       // Wakes the task shortly before each frame.
+  SemaphoreHandle_t wake;         // Given by the timer, or to stop the task.
+  SemaphoreHandle_t done;         // Given when the task has ended.
+  SemaphoreHandle_t mux;          // Protects the counters.
+  TaskHandle_t task;              // The playback task.
+  volatile bool is_stopping;      // True when the task is asked to end.
+  dmx_playback_stats_t stats;     // The playback counters.
+  uint8_t slots[DMX_MAX_PACKET_SIZE];  // The slots of the frame to send.
+} dmx_playback_t;
+
+static dmx_playback_t *dmx_playback[DMX_NUM_MAX] = {0};
+
+size_t dmx_playback_memory_source(void *data, size_t size, void *context) {
+  dmx_playback_memory_t *const memory = context;
+  const size_t remaining = memory->size - memory->offset;
+  if (size > remaining) {
+    size = remaining;
+  }
+  memcpy(data, (const uint8_t *)memory->data + memory->offset, size);
+  memory->offset += size;
+  return size;
+}
+
+// Reads from the source until the buffer is full or the stream ends. Returns
+// the number of bytes which were read.
+static size_t dmx_playback_read(dmx_playback_t *playback, void *data,
+                                size_t size) {
+  size_t num_read = 0;
+  while (num_read < size) {
+    const size_t n = playback->config.source(
+        (uint8_t *)data + num_read, size - num_read, playback->config.context);
+    if (n == 0) {
+      break;
+    }
+    num_read += n;
+  }
+  return num_read;
+}
+
+static void dmx_playback_timer_cb(void *arg) {
+  dmx_playback_t *const playback = arg;
+  xSemaphoreGive(playback->wake);
+}
+
+// Sleeps until shortly before the target time and then spins until it. The
+// spin is needed because the scheduler can only wake the task to within a few
+// tens of microseconds.
+static void dmx_playback_sleep_until(dmx_playback_t *playback,
+                                     int64_t target) {
+  int64_t now = esp_timer_get_time();
+  const int64_t wake = target - playback->config.spin_us;
+  if (wake > now) {
+    esp_timer_start_once(playback->timer, wake - now);
+    xSemaphoreTake(playback->wake, portMAX_DELAY);
+    if (playback->is_stopping) {
+      esp_timer_stop(playback->timer);
+      return;
+    }
+    now = esp_timer_get_time();
+  }
+  if (target > now) {
+    esp_rom_delay_us(target - now);
+  }
+}
+
+// Returns true if a frame was sent by a responder rather than a controller.
+static bool dmx_playback_is_response(const dmx_capture_header_t *header) {
+  return header->type == DMX_CAPTURE_TYPE_RESPONSE ||
+         header->type == DMX_CAPTURE_TYPE_DISCOVERY_RESPONSE;
+}
+
+static void dmx_playback_count(dmx_playback_t *playback, size_t sent,
+                               int64_t late) {
+  xSemaphoreTake(playback->mux, portMAX_DELAY);
+  dmx_playback_stats_t *const stats = &playback->stats;
+  if (sent > 0) {
+    if (late < 0) {
+      late = 0;
+    }
+    ++stats->num_sent;
+    stats->total_late_us += late;
+    if (late > stats->max_late_us) {
+      stats->max_late_us = late;
+    }
+  } else {
+    ++stats->num_skipped;
+  }
+  xSemaphoreGive(playback->mux);
+}
+
+static esp_err_t dmx_playback_run(dmx_playback_t *playback) {
+  const dmx_port_t dmx_num = playback->dmx_num;
+  const dmx_playback_config_t *const config = &playback->config;
+
+  dmx_capture_stream_header_t stream_header;
+  if (dmx_playback_read(playback, &stream_header, sizeof(stream_header)) !=
+          sizeof(stream_header) ||
+      memcmp(stream_header.magic, DMX_CAPTURE_MAGIC,
+             sizeof(stream_header.magic)) != 0 ||
+      stream_header.version != DMX_CAPTURE_VERSION ||
+      stream_header.header_size < sizeof(dmx_capture_header_t)) {
+    return ESP_ERR_INVALID_VERSION;
+  }
+  const size_t header_size = stream_header.header_size;
+  const uint32_t baud_rate = dmx_get_baud_rate(dmx_num);
+
+  // Frames are scheduled at the time they started in the capture plus an
+  // offset, which is set by the first frame
+  int64_t offset = 0;
+  bool is_first = true;
+  while (!playback->is_stopping) {
+    dmx_capture_header_t header;
+    const size_t num_read = dmx_playback_read(playback, &header, sizeof(header));
+    if (num_read == 0) {
+      break;  // The end of the stream
+    } else if (num_read != sizeof(header)) {
+      return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Skip the fields which were added to the header after this version
+    for (size_t i = sizeof(header); i < header_size;) {
+      size_t n = header_size - i;
+      if (n > sizeof(playback->slots)) {
+        n = sizeof(playback->slots);
+      }
+      if (dmx_playback_read(playback, playback->slots, n) != n) {
+        return ESP_ERR_INVALID_SIZE;
+      }
+      i += n;
+    }
+
+    if (header.size < header_size ||
+        header.size - header_size > DMX_MAX_PACKET_SIZE) {
+      return ESP_ERR_INVALID_SIZE;
+    }
+    const size_t size = header.size - header_size;
+    if (dmx_playback_read(playback, playback->slots, size) != size) {
+      return ESP_ERR_INVALID_SIZE;
+    }
+
+    // The timestamp is the end of the frame, so its start is found from its
+    // length on the line. A break of 0 was not measured.
+    const bool has_break = !(header.flags & DMX_CAPTURE_FLAG_NO_BREAK);
+    const uint32_t break_len =
+        header.break_len > 0 ? header.break_len : config->break_len;
+    const uint32_t mab_len =
+        header.mab_len > 0 ? header.mab_len : config->mab_len;
+    int64_t duration = (int64_t)size * 11 * 1000000 / baud_rate;
+    if (has_break) {
+      duration += break_len + mab_len;
+    }
+    const int64_t start = header.timestamp - duration;
+    if (is_first) {
+      offset = esp_timer_get_time() + config->start_delay_us - start;
+      is_first = false;
+    }
+
+    // Responses are skipped, but still keep their place in the schedule
+    if (size == 0 ||
+        (!config->send_responses && dmx_playback_is_response(&header))) {
+      dmx_playback_count(playback, 0, 0);
+      continue;
+    }
+
+    const int64_t target = start + offset;
+    dmx_playback_sleep_until(playback, target);
+    if (playback->is_stopping) {
+      break;
+    }
+
+    // The driver buffer may only be written once the previous frame is sent
+    dmx_wait_sent(dmx_num, portMAX_DELAY);
+    if (has_break) {
+      dmx_set_break_len(dmx_num, break_len);
+      dmx_set_mab_len(dmx_num, mab_len);
+    }
+    dmx_write(dmx_num, playback->slots, size);
+    const int64_t late = esp_timer_get_time() - target;
+    const size_t sent = dmx_send(dmx_num, size);
+    dmx_playback_count(playback, sent, late);
+  }
+
+  return ESP_OK;
+}
+
+static void dmx_playback_task(void *arg) {
+  dmx_playback_t *const playback = arg;
+
+  const esp_err_t err = dmx_playback_run(playback);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "DMX playback stream is %s",
+             err == ESP_ERR_INVALID_VERSION ? "not supported" : "corrupt");
+  }
+  esp_timer_stop(playback->timer);
+  xSemaphoreTake(playback->mux, portMAX_DELAY);
+  playback->stats.err = err;
+  xSemaphoreGive(playback->mux);
+
+  xSemaphoreGive(playback->done);
+  vTaskDelete(NULL);
+}
+
+esp_err_t dmx_playback_start(dmx_port_t dmx_num,
+                             const dmx_playback_config_t *config) {
+  DMX_PLAYBACK_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                     "dmx_num error");
+  DMX_PLAYBACK_CHECK(config != NULL, ESP_ERR_INVALID_ARG, "config is null");
+  DMX_PLAYBACK_CHECK(config->source != NULL, ESP_ERR_INVALID_ARG,
+                     "source is null");
+  DMX_PLAYBACK_CHECK(dmx_driver_is_installed(dmx_num), ESP_ERR_INVALID_STATE,
+                     "driver is not installed");
+  DMX_PLAYBACK_CHECK(dmx_playback[dmx_num] == NULL, ESP_ERR_INVALID_STATE,
+                     "playback is already started");
+
+  dmx_playback_t *playback = calloc(1, sizeof(dmx_playback_t));
+  if (playback == NULL) {
+    ESP_LOGE(TAG, "DMX playback malloc error");
+    return ESP_ERR_NO_MEM;
+  }
+  playback->dmx_num = dmx_num;
+  playback->config = *config;
+  playback->wake = xSemaphoreCreateBinary();
+  playback->done = xSemaphoreCreateBinary();
+  playback->mux = xSemaphoreCreateMutex();
+  const esp_timer_create_args_t timer_args = {
+      .callback = dmx_playback_timer_cb,
+      .arg = playback,
+      .dispatch_method = ESP_TIMER_TASK,
+      .name = "dmx_playback",
+  };
+  if (playback->wake == NULL || playback->done == NULL ||
+      playback->mux == NULL ||
+      esp_timer_create(&timer_args, &playback->timer) != ESP_OK) {
+    ESP_LOGE(TAG, "DMX playback malloc error");
+    goto err;
+  }
+
+  dmx_playback[dmx_num] = playback;
+  if (xTaskCreatePinnedToCore(dmx_playback_task, "dmx_playback",
+                              config->stack_size, playback, config->priority,
+                              &playback->task, config->core_id) != pdPASS) {
+    ESP_LOGE(TAG, "DMX playback task create error");
+    dmx_playback[dmx_num] = NULL;
+    goto err;
+  }
+
+  return ESP_OK;
+
+err:
+  if (playback->timer != NULL) {
+    esp_timer_delete(playback->timer);
+  }
+  if (playback->mux != NULL) {
+    vSemaphoreDelete(playback->mux);
+  }
+  if (playback->done != NULL) {
+    vSemaphoreDelete(playback->done);
+  }
+  if (playback->wake != NULL) {
+    vSemaphoreDelete(playback->wake);
+  }
+  free(playback);
+  return ESP_ERR_NO_MEM;
+}
+
+esp_err_t dmx_playback_wait(dmx_port_t dmx_num, TickType_t wait_ticks) {
+  DMX_PLAYBACK_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                     "dmx_num error");
+  DMX_PLAYBACK_CHECK(dmx_playback[dmx_num] != NULL, ESP_ERR_INVALID_STATE,
+                     "playback is not started");
+
+  dmx_playback_t *const playback = dmx_playback[dmx_num];
+  if (!xSemaphoreTake(playback->done, wait_ticks)) {
+    return ESP_ERR_TIMEOUT;
+  }
+  xSemaphoreGive(playback->done);  // The playback stays done for other calls
+
+  xSemaphoreTake(playback->mux, portMAX_DELAY);
+  const esp_err_t err = playback->stats.err;
+  xSemaphoreGive(playback->mux);
+  return err;
+}
+
+esp_err_t dmx_playback_stop(dmx_port_t dmx_num) {
+  DMX_PLAYBACK_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                     "dmx_num error");
+  DMX_PLAYBACK_CHECK(dmx_playback[dmx_num] != NULL, ESP_ERR_INVALID_STATE,
+                     "playback is not started");
+
+  // Wake the task if it is sleeping and wait for it to end
+  dmx_playback_t *const playback = dmx_playback[dmx_num];
+  playback->is_stopping = true;
+  xSemaphoreGive(playback->wake);
+  xSemaphoreTake(playback->done, portMAX_DELAY);
+
+  dmx_playback[dmx_num] = NULL;
+  esp_timer_delete(playback->timer);
+  vSemaphoreDelete(playback->mux);
+  vSemaphoreDelete(playback->done);
+  vSemaphoreDelete(playback->wake);
+  free(playback);
+
+  return ESP_OK;
+}
+
+bool dmx_playback_get_stats(dmx_port_t dmx_num, dmx_playback_stats_t *stats) {
+  DMX_PLAYBACK_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_PLAYBACK_CHECK(stats != NULL, false, "stats is null");
+  DMX_PLAYBACK_CHECK(dmx_playback[dmx_num] != NULL, false,
+                     "playback is not started");
+
+  dmx_playback_t *const playback = dmx_playback[dmx_num];
+  xSemaphoreTake(playback->mux, portMAX_DELAY);
+  *stats = playback->stats;
+  xSemaphoreGive(playback->mux);
+  return true;
+}
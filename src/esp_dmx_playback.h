@@ -0,0 +1,155 @@
+/**
+ * @file esp_dmx_playback.h
+ * @brief This file declares functions for the DMX playback, which retransmits
+ * a packet capture stream, as written by dmx_capture_start(), on a DMX port
+ * with its original timing. Each frame is sent with its captured DMX break and
+ * mark-after-break, and is scheduled so that the gaps between frames match
+ * the capture. The stream is pulled from a source one frame at a time, so it
+ * may be read from PSRAM, a file, or a socket without loading it into RAM.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Reads bytes of a packet capture stream from a source. It is called
+ * from the playback task, so it may block, but time spent in it delays the
+ * frames which follow.
+ *
+ * @param[out] data The buffer into which to read.
+ * @param size The number of bytes to read.
+ * @param context The context which was passed in the playback configuration.
+ * @return The number of bytes which were read, or 0 at the end of the stream.
+ */
+typedef size_t (*dmx_playback_source_t)(void *data, size_t size,
+                                        void *context);
+
+/**
+ * @brief Configuration for the DMX playback.
+ */
+typedef struct dmx_playback_config_t {
+  dmx_playback_source_t source;  // The source from which the stream is read.
+  void *context;                 // The context passed to the source.
+  uint32_t start_delay_us;       // The time in microseconds from the start of the playback until the first frame is sent.
+  uint32_t spin_us;              // The time in microseconds before each frame for which the playback task busy-waits instead of sleeping, so that frames start on time.
+  uint32_t break_len;            // The DMX break length in microseconds of frames for which no break was measured.
+  uint32_t mab_len;              // The DMX mark-after-break length in microseconds of frames for which none was measured.
+  bool send_responses;           // True to send RDM responses and discovery responses. They were sent by responders, so they are skipped by default.
+  UBaseType_t priority;          // The priority of the playback task.
+  BaseType_t core_id;            // The core to which the playback task is pinned, or tskNO_AFFINITY.
+  uint32_t stack_size;           // The stack size of the playback task in bytes.
+} dmx_playback_config_t;
+
+/**
+ * @brief The default configuration for the DMX playback.
+ */
+#define DMX_PLAYBACK_DEFAULT_CONFIG(source_cb, source_context) \
+  {                                                            \
+    .source = source_cb,                                       \
+    .context = source_context,                                 \
+    .start_delay_us = 1000,                                    \
+    .spin_us = 200,                                            \
+    .break_len = DMX_BREAK_LEN_US,                             \
+    .mab_len = DMX_MAB_LEN_US,                                 \
+    .send_responses = false,                                   \
+    .priority = configMAX_PRIORITIES - 1,                      \
+    .core_id = tskNO_AFFINITY,                                 \
+    .stack_size = 3072,                                        \
+  }
+
+/**
+ * @brief Counters of the DMX playback.
+ */
+typedef struct dmx_playback_stats_t {
+  esp_err_t err;         // ESP_OK, or the error which ended the playback: ESP_ERR_INVALID_VERSION if the stream header was invalid, or ESP_ERR_INVALID_SIZE if a frame was truncated or corrupt.
+  uint32_t num_sent;     // The number of frames which were sent.
+  uint32_t num_skipped;  // The number of frames which were skipped, or which the driver did not send.
+  uint32_t max_late_us;  // The largest delay in microseconds from the scheduled start of a frame until it was started.
+  uint64_t total_late_us;  // The sum of the delays from the scheduled start of each sent frame until it was started.
+} dmx_playback_stats_t;
+
+/**
+ * @brief A packet capture stream in memory, such as PSRAM, for use with
+ * dmx_playback_memory_source().
+ */
+typedef struct dmx_playback_memory_t {
+  const void *data;  // The stream.
+  size_t size;       // The size of the stream in bytes.
+  size_t offset;     // The number of bytes which have been read.
+} dmx_playback_memory_t;
+
+/**
+ * @brief A playback source which reads a stream from memory. Its context must
+ * be a pointer to a dmx_playback_memory_t which outlives the playback.
+ */
+size_t dmx_playback_memory_source(void *data, size_t size, void *context);
+
+/**
+ * @brief Starts the DMX playback on a DMX port. A playback task reads the
+ * stream and sends its frames until the stream ends or the playback is
+ * stopped. The DMX break and mark-after-break of the port are changed for each
+ * frame, and are clamped by the driver to the DMX specification. The DMX
+ * driver must be installed.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] config A pointer to the playback configuration.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_NO_MEM if there is not enough memory.
+ * @retval ESP_ERR_INVALID_STATE if the playback is already started or the DMX
+ * driver is not installed.
+ */
+esp_err_t dmx_playback_start(dmx_port_t dmx_num,
+                             const dmx_playback_config_t *config);
+
+/**
+ * @brief Waits for the DMX playback on a DMX port to reach the end of its
+ * stream.
+ *
+ * @param dmx_num The DMX port number.
+ * @param wait_ticks The number of ticks to wait before this function times out.
+ * @retval ESP_OK if the whole stream was played.
+ * @retval ESP_ERR_TIMEOUT if the playback did not end in time.
+ * @retval ESP_ERR_INVALID_VERSION if the stream header was invalid.
+ * @retval ESP_ERR_INVALID_SIZE if a frame of the stream was truncated or
+ * corrupt.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the playback is not started.
+ */
+esp_err_t dmx_playback_wait(dmx_port_t dmx_num, TickType_t wait_ticks);
+
+/**
+ * @brief Stops the DMX playback on a DMX port, if it has not ended, and frees
+ * its resources. Must be called after the playback ends before it may be
+ * started again.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the playback is not started.
+ */
+esp_err_t dmx_playback_stop(dmx_port_t dmx_num);
+
+/**
+ * @brief Copies the counters of the DMX playback on a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] stats A pointer into which to copy the counters.
+ * @return true if the counters were copied.
+ * @return false if the playback is not started.
+ */
+bool dmx_playback_get_stats(dmx_port_t dmx_num, dmx_playback_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,6 +1,7 @@
 #include "esp_rdm.h"
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "dmx_types.h"
@@ -8,10 +9,15 @@
 #include "esp_check.h"
 #include "esp_dmx.h"
 #include "esp_log.h"
+#include "esp_rdm_codec.h"
+#include "esp_rdm_queue.h"
+#include "esp_rdm_virtual.h"
 #include "esp_system.h"
+#include "private/dmx_timing.h"
 #include "private/driver.h"
 #include "private/rdm_encode/functions.h"
 #include "private/rdm_encode/types.h"
+#include "private/rdm_responder.h"
 #include <string.h>
 
 // Used for argument checking at the beginning of each function.
@@ -20,6 +26,172 @@
 
 static const char *TAG = "rdm"; // The log tagline for the file.
 
+// External definitions of the inline functions of esp_rdm.h, for builds in
+// which they are not inlined.
+extern inline bool rdm_uid_is_broadcast(rdm_uid_t uid);
+extern inline bool rdm_uid_is_addressed_to(rdm_uid_t uid, rdm_uid_t addressee);
+
+enum rdm_packet_offset_t {
+  RDM_OFFSET_DESTINATION_UID = 3,  // The offset of the destination UID in an RDM packet.
+  RDM_OFFSET_TN = 15,              // The offset of the transaction number in an RDM packet.
+  RDM_OFFSET_MESSAGE_COUNT = 17,   // The offset of the message count in an RDM packet.
+};
+
+#ifndef CONFIG_RDM_LATENCY_TABLE_SIZE
+#define CONFIG_RDM_LATENCY_TABLE_SIZE 64
+#endif
+
+enum rdm_latency_constants_t {
+  RDM_LATENCY_MIN_SAMPLES = 4,   // Samples needed before the timeout adapts.
+  RDM_LATENCY_GUARD_US = 250,    // Margin added to the adaptive timeout.
+  RDM_DEFAULT_ATTEMPTS = 3,      // Attempts made when nothing is known.
+  RDM_LATENCY_LOSS_LOW = 8,      // Loss rate below which fewer attempts are made (~3%).
+  RDM_LATENCY_LOSS_HIGH = 64,    // Loss rate above which more attempts are made (25%).
+};
+
+/* Response latency statistics of a responder. The EWMA is stored with 4
+fractional bits and the loss rate is stored as a fraction of 256. */
+typedef struct rdm_latency_entry_t {
+  rdm_uid_t uid;
+  uint32_t ewma;
+  uint32_t max;
+  uint32_t num_responses;
+  uint32_t num_lost;
+  uint16_t loss;
+} rdm_latency_entry_t;
+
+static rdm_latency_entry_t *rdm_latency[DMX_NUM_MAX] = {0};
+
+// Returns the message count field of responses, which is limited to 255.
+static uint8_t rdm_get_message_count(dmx_port_t dmx_num) {
+  const size_t count = rdm_queue_count(dmx_num);
+  return count < 255 ? count : 255;
+}
+
+static rdm_latency_entry_t *rdm_latency_find(dmx_port_t dmx_num,
+                                             rdm_uid_t uid, bool create) {
+  rdm_latency_entry_t *const table = rdm_latency[dmx_num];
+  if (table == NULL || uid == 0) {
+    return NULL;
+  }
+
+  // Open addressing with linear probing
+  const size_t size = CONFIG_RDM_LATENCY_TABLE_SIZE;
+  const size_t start = (uid * 0x9e3779b97f4a7c15ULL) >> 32 & 0xffffffff;
+  for (size_t i = 0; i < size; ++i) {
+    rdm_latency_entry_t *entry = &table[(start + i) % size];
+    if (entry->uid == uid) {
+      return entry;
+    } else if (entry->uid == 0) {
+      if (!create) {
+        return NULL;
+      }
+      entry->uid = uid;
+      return entry;
+    }
+  }
+
+  // The table is full - evict the entry in the home slot
+  if (create) {
+    rdm_latency_entry_t *entry = &table[start % size];
+    memset(entry, 0, sizeof(*entry));
+    entry->uid = uid;
+    return entry;
+  }
+  return NULL;
+}
+
+static uint32_t rdm_latency_timeout(const rdm_latency_entry_t *entry) {
+  if (entry == NULL || entry->num_responses < RDM_LATENCY_MIN_SAMPLES) {
+    return RDM_CONTROLLER_RESPONSE_LOST_TIMEOUT;
+  }
+
+  uint32_t timeout = (entry->ewma >> 4) * 2;
+  if (timeout < entry->max) {
+    timeout = entry->max;
+  }
+  timeout += RDM_LATENCY_GUARD_US;
+  if (timeout > RDM_CONTROLLER_RESPONSE_LOST_TIMEOUT) {
+    timeout = RDM_CONTROLLER_RESPONSE_LOST_TIMEOUT;
+  }
+  return timeout;
+}
+
+static size_t rdm_latency_attempts(const rdm_latency_entry_t *entry) {
+  if (entry == NULL || entry->num_responses < RDM_LATENCY_MIN_SAMPLES) {
+    return RDM_DEFAULT_ATTEMPTS;
+  } else if (entry->loss < RDM_LATENCY_LOSS_LOW) {
+    return RDM_DEFAULT_ATTEMPTS - 1;
+  } else if (entry->loss > RDM_LATENCY_LOSS_HIGH) {
+    return RDM_DEFAULT_ATTEMPTS + 1;
+  }
+  return RDM_DEFAULT_ATTEMPTS;
+}
+
+static size_t rdm_get_attempts(dmx_port_t dmx_num, rdm_uid_t uid) {
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  const size_t attempts =
+      rdm_latency_attempts(rdm_latency_find(dmx_num, uid, false));
+  taskEXIT_CRITICAL(spinlock);
+  return attempts;
+}
+
+// Sets the response timeout of the DMX driver for a request to a UID.
+static void rdm_latency_begin(dmx_port_t dmx_num, rdm_uid_t uid) {
+  // Allocate the statistics table the first time it is needed
+  if (rdm_latency[dmx_num] == NULL) {
+    rdm_latency[dmx_num] =
+        calloc(CONFIG_RDM_LATENCY_TABLE_SIZE, sizeof(rdm_latency_entry_t));
+  }
+
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  dmx_timing[dmx_num].rdm_response_timeout =
+      rdm_latency_timeout(rdm_latency_find(dmx_num, uid, false));
+  taskEXIT_CRITICAL(spinlock);
+}
+
+// Records the outcome of a request and restores the default response timeout.
+static void rdm_latency_end(dmx_port_t dmx_num, rdm_uid_t uid,
+                            bool received) {
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  dmx_timing_t *const timing = &dmx_timing[dmx_num];
+  timing->rdm_response_timeout = RDM_CONTROLLER_RESPONSE_LOST_TIMEOUT;
+  rdm_latency_entry_t *const entry = rdm_latency_find(dmx_num, uid, true);
+  if (entry != NULL) {
+    if (received && timing->rx_first_slot_ts > timing->tx_done_ts) {
+      const uint32_t latency = timing->rx_first_slot_ts - timing->tx_done_ts;
+      if (entry->num_responses == 0) {
+        entry->ewma = latency << 4;
+      } else {
+        entry->ewma += ((int32_t)(latency << 4) - (int32_t)entry->ewma) / 8;
+      }
+      if (latency > entry->max) {
+        entry->max = latency;
+      }
+      ++entry->num_responses;
+      entry->loss -= entry->loss / 16;
+    } else if (!received) {
+      ++entry->num_lost;
+      entry->loss += (256 - entry->loss) / 16;
+    }
+  }
+  taskEXIT_CRITICAL(spinlock);
+}
+
+static void rdm_latency_to_stats(const rdm_latency_entry_t *entry,
+                                 rdm_latency_stats_t *stats) {
+  stats->uid = entry->uid;
+  stats->ewma_us = entry->ewma >> 4;
+  stats->max_us = entry->max;
+  stats->num_responses = entry->num_responses;
+  stats->num_lost = entry->num_lost;
+  stats->timeout_us = rdm_latency_timeout(entry);
+  stats->attempts = rdm_latency_attempts(entry);
+}
+
 rdm_uid_t rdm_get_uid(dmx_port_t dmx_num)
 {
   RDM_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
@@ -47,6 +219,22 @@ rdm_uid_t rdm_get_uid(dmx_port_t dmx_num)
   return uid;
 }
 
+// Encodes the DISC_UNIQUE_BRANCH response which is sent by the interrupt
+// handler. The response is encoded outside of the critical section and copied
+// in so that the interrupt handler never sees a partially encoded response.
+static void rdm_disc_fast_path_encode(dmx_port_t dmx_num) {
+  const rdm_uid_t uid = rdm_get_uid(dmx_num);
+  uint8_t response[RDM_DISC_RESPONSE_SIZE];
+  rdm_encode_disc_response(response, RDM_DISC_RESPONSE_PREAMBLE_LEN, uid);
+
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  rdm_disc_fast_path_t *const fast_path = &rdm_disc_fast_path[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  memcpy(fast_path->response, response, sizeof(response));
+  fast_path->uid = uid;
+  taskEXIT_CRITICAL(spinlock);
+}
+
 void rdm_set_uid(dmx_port_t dmx_num, rdm_uid_t uid)
 {
   RDM_CHECK(dmx_num < DMX_NUM_MAX, , "dmx_num error");
@@ -59,6 +247,11 @@ void rdm_set_uid(dmx_port_t dmx_num, rdm_uid_t uid)
   taskENTER_CRITICAL(spinlock);
   driver->rdm.uid = uid;
   taskEXIT_CRITICAL(spinlock);
+
+  // Re-encode the discovery response which is sent by the interrupt handler
+  if (rdm_disc_fast_path_is_enabled(dmx_num)) {
+    rdm_disc_fast_path_encode(dmx_num);
+  }
 }
 
 bool rdm_is_muted(dmx_port_t dmx_num)
@@ -94,23 +287,73 @@ bool rdm_set_muted(dmx_port_t dmx_num, bool muted)
 size_t rdm_send_disc_response(dmx_port_t dmx_num, size_t preamble_len,
                               rdm_uid_t uid)
 {
+  return rdm_send_disc_responses(dmx_num, preamble_len, &uid, 1);
+}
+
+size_t rdm_send_disc_responses(dmx_port_t dmx_num, size_t preamble_len,
+                               const rdm_uid_t *uids, size_t num_uids) {
   RDM_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
   RDM_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
   RDM_CHECK(preamble_len <= 7, 0, "preamble_len error");
+  RDM_CHECK(uids != NULL && num_uids > 0, 0, "uids error");
 
   dmx_driver_t *const driver = dmx_driver[dmx_num];
   xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
   dmx_wait_sent(dmx_num, portMAX_DELAY);
 
-  // Write and send the response
-  size_t written =
-      rdm_encode_disc_response(driver->data.buffer, preamble_len, uid);
+  // Write the first response and OR the others over it
+  uint8_t *const buf = driver->data.buffer;
+  const size_t written = rdm_encode_disc_response(buf, preamble_len, uids[0]);
+  for (size_t i = 1; i < num_uids; ++i) {
+    uint8_t collision[RDM_DISC_RESPONSE_SIZE];
+    rdm_encode_disc_response(collision, preamble_len, uids[i]);
+    for (size_t j = 0; j < written; ++j) {
+      buf[j] |= collision[j];
+    }
+  }
   dmx_send(dmx_num, written);
 
   xSemaphoreGiveRecursive(driver->mux);
   return written;
 }
 
+esp_err_t rdm_disc_fast_path_enable(dmx_port_t dmx_num) {
+  RDM_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG, "dmx_num error");
+  RDM_CHECK(dmx_driver_is_installed(dmx_num), ESP_ERR_INVALID_STATE,
+            "driver is not installed");
+
+  RDM_CHECK(!rdm_virtual_is_installed(dmx_num), ESP_ERR_INVALID_STATE,
+            "virtual responders are installed");
+
+  rdm_disc_fast_path_encode(dmx_num);
+
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  rdm_disc_fast_path[dmx_num].is_enabled = true;
+  taskEXIT_CRITICAL(spinlock);
+
+  return ESP_OK;
+}
+
+esp_err_t rdm_disc_fast_path_disable(dmx_port_t dmx_num) {
+  RDM_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG, "dmx_num error");
+  RDM_CHECK(dmx_driver_is_installed(dmx_num), ESP_ERR_INVALID_STATE,
+            "driver is not installed");
+
+  // A response which is already being sent is allowed to finish
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  rdm_disc_fast_path[dmx_num].is_enabled = false;
+  taskEXIT_CRITICAL(spinlock);
+
+  return ESP_OK;
+}
+
+bool rdm_disc_fast_path_is_enabled(dmx_port_t dmx_num) {
+  return dmx_num < DMX_NUM_MAX && dmx_driver_is_installed(dmx_num) &&
+         rdm_disc_fast_path[dmx_num].is_enabled;
+}
+
 rdm_uid_t rdm_send_disc_unique_branch(dmx_port_t dmx_num,
                                       rdm_disc_unique_branch_t *params,
                                       rdm_response_t *response) {
@@ -206,6 +449,9 @@ bool rdm_send_disc_mute(dmx_port_t dmx_num, rdm_uid_t uid, bool mute,
                                        .pid = pid,
                                        .pdl = 0};
   size_t written = rdm_encode_header(rdm, &req_header);
+  if (!rdm_uid_is_broadcast(uid)) {
+    rdm_latency_begin(dmx_num, uid);
+  }
   dmx_send(dmx_num, written);
 
   // Determine if a response is expected
@@ -214,6 +460,7 @@ bool rdm_send_disc_mute(dmx_port_t dmx_num, rdm_uid_t uid, bool mute,
     // Receive the response
     dmx_packet_t event;
     const size_t read = dmx_receive(dmx_num, &event, DMX_TIMEOUT_TICK);
+    rdm_latency_end(dmx_num, uid, read > 0);
     if (!read)
     {
       if (response != NULL)
@@ -324,9 +571,10 @@ size_t rdm_discover_with_callback(dmx_port_t dmx_num, rdm_discovery_cb_t cb,
     {
       // Can't branch further so attempt to mute the device
       uid = branch->lower_bound;
+      const size_t max_attempts = rdm_get_attempts(dmx_num, uid);
       do {
         dev_muted = rdm_send_disc_mute(dmx_num, uid, true, &response, &mute);
-      } while (!dev_muted && ++attempts < 3);
+      } while (!dev_muted && ++attempts < max_attempts);
 
       // Attempt to fix possible error where responder is flipping its own UID
       if (!dev_muted) {
@@ -342,11 +590,12 @@ size_t rdm_discover_with_callback(dmx_port_t dmx_num, rdm_discovery_cb_t cb,
     }
     else
     {
-      // Search the current branch in the RDM address space
+      // Search the current branch in the RDM address space. A response which
+      // cannot be decoded is a collision of responses which were not aligned.
       do {
         uid = rdm_send_disc_unique_branch(dmx_num, branch, &response);
-      } while (uid == 0 && ++attempts < 3);
-      if (uid != 0) {
+      } while (response.err == ESP_ERR_TIMEOUT && ++attempts < 3);
+      if (response.err != ESP_ERR_TIMEOUT) {
         bool devices_remaining = true;
 
 #ifndef CONFIG_RDM_DEBUG_DEVICE_DISCOVERY
@@ -362,32 +611,35 @@ size_t rdm_discover_with_callback(dmx_port_t dmx_num, rdm_discovery_cb_t cb,
           {
             // Attempt to mute the device
             attempts = 0;
+            const size_t max_attempts = rdm_get_attempts(dmx_num, uid);
             do {
               dev_muted = rdm_send_disc_mute(dmx_num, uid, true, NULL, &mute);
-            } while (!dev_muted && ++attempts < 3);
+            } while (!dev_muted && ++attempts < max_attempts);
 
             // Call the callback function and report a device has been found
             if (dev_muted) {
               cb(dmx_num, uid, num_found, &mute, context);
               ++num_found;
+            } else {
+              // The response was a collision with a valid checksum, which
+              // repeats for the same devices - branch further
+              break;
             }
 
             // Check if there are more devices in this branch
             attempts = 0;
             do {
               uid = rdm_send_disc_unique_branch(dmx_num, branch, &response);
-            } while (uid == 0 && ++attempts < 3);
-            if (uid != 0 && response.err) {
-              // There are more devices in this branch - branch further
-              devices_remaining = true;
-              break;
-            }
-            else
-            {
+            } while (response.err == ESP_ERR_TIMEOUT && ++attempts < 3);
+            if (response.err == ESP_ERR_TIMEOUT) {
               // There are no more devices in this branch
               devices_remaining = false;
               break;
+            } else if (response.err) {
+              // There are more devices in this branch - branch further
+              break;
             }
+            // A single device responded, so attempt to mute it next
           }
         }
 #endif
@@ -420,6 +672,82 @@ size_t rdm_discover_with_callback(dmx_port_t dmx_num, rdm_discovery_cb_t cb,
   return num_found;
 }
 
+bool rdm_get_latency_stats(dmx_port_t dmx_num, rdm_uid_t uid,
+                           rdm_latency_stats_t *stats) {
+  RDM_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  RDM_CHECK(stats != NULL, false, "stats is null");
+  RDM_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  const rdm_latency_entry_t *entry = rdm_latency_find(dmx_num, uid, false);
+  if (entry != NULL) {
+    rdm_latency_to_stats(entry, stats);
+  }
+  taskEXIT_CRITICAL(spinlock);
+
+  return entry != NULL;
+}
+
+size_t rdm_get_all_latency_stats(dmx_port_t dmx_num,
+                                 rdm_latency_stats_t *stats, size_t size) {
+  RDM_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  RDM_CHECK(stats != NULL || size == 0, 0, "stats is null");
+  RDM_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  if (rdm_latency[dmx_num] == NULL) {
+    return 0;
+  }
+
+  // Copy the entries, keeping the output sorted from slowest to fastest
+  size_t num_stats = 0;
+  size_t num_copied = 0;
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  for (int i = 0; i < CONFIG_RDM_LATENCY_TABLE_SIZE; ++i) {
+    rdm_latency_stats_t entry_stats;
+    taskENTER_CRITICAL(spinlock);
+    const rdm_latency_entry_t *entry = &rdm_latency[dmx_num][i];
+    const bool in_use = entry->uid != 0;
+    if (in_use) {
+      rdm_latency_to_stats(entry, &entry_stats);
+    }
+    taskEXIT_CRITICAL(spinlock);
+    if (!in_use) {
+      continue;
+    }
+    ++num_stats;
+
+    size_t j = num_copied;
+    while (j > 0 && stats[j - 1].ewma_us < entry_stats.ewma_us) {
+      if (j < size) {
+        stats[j] = stats[j - 1];
+      }
+      --j;
+    }
+    if (j < size) {
+      stats[j] = entry_stats;
+      if (num_copied < size) {
+        ++num_copied;
+      }
+    }
+  }
+
+  return num_stats;
+}
+
+void rdm_reset_latency_stats(dmx_port_t dmx_num) {
+  RDM_CHECK(dmx_num < DMX_NUM_MAX, , "dmx_num error");
+  RDM_CHECK(dmx_driver_is_installed(dmx_num), , "driver is not installed");
+
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  if (rdm_latency[dmx_num] != NULL) {
+    memset(rdm_latency[dmx_num], 0,
+           sizeof(rdm_latency_entry_t) * CONFIG_RDM_LATENCY_TABLE_SIZE);
+  }
+  taskEXIT_CRITICAL(spinlock);
+}
+
 struct rdm_disc_default_ctx
 {
   size_t size;
@@ -450,10 +778,9 @@ size_t rdm_discover_devices_simple(dmx_port_t dmx_num, rdm_uid_t *uids,
 
 static size_t rdm_send_generic_request(
     dmx_port_t dmx_num, rdm_uid_t uid, rdm_sub_device_t sub_device,
-    const rdm_cc_t cc, const rdm_pid_t pid,
-    size_t (*encode)(void *, const void *, size_t), void *encode_params,
-    size_t num_encode_params,
-    size_t (*decode)(const void *, void *, size_t, size_t), void *decode_params,
+    const rdm_cc_t cc, const rdm_pid_t pid, const rdm_format_t *encode_format,
+    const void *encode_params, size_t num_encode_params,
+    const rdm_format_t *decode_format, void *decode_params,
     size_t num_decode_params, rdm_response_t *response)
 {
   // Take mutex so driver values may be accessed
@@ -465,9 +792,10 @@ static size_t rdm_send_generic_request(
   const uint8_t tn = driver->rdm.tn;
   rdm_data_t *const rdm = (rdm_data_t *)driver->data.buffer;
   size_t written;
-  if (encode && encode_params && num_encode_params)
+  if (encode_format && encode_params && num_encode_params)
   {
-    written = encode(&rdm->pd, encode_params, num_encode_params);
+    written = rdm_codec_encode(encode_format, &rdm->pd, encode_params,
+                               num_encode_params);
   }
   else
   {
@@ -483,6 +811,9 @@ static size_t rdm_send_generic_request(
                              .pid = pid,
                              .pdl = written};
   written += rdm_encode_header(rdm, &req_header);
+  if (!rdm_uid_is_broadcast(uid)) {
+    rdm_latency_begin(dmx_num, uid);
+  }
   dmx_send(dmx_num, written);
 
   // Receive and decode the RDM response
@@ -490,6 +821,7 @@ static size_t rdm_send_generic_request(
   if (!rdm_uid_is_broadcast(uid)) {
     dmx_packet_t event;
     const size_t read = dmx_receive(dmx_num, &event, pdMS_TO_TICKS(20));
+    rdm_latency_end(dmx_num, uid, read > 0);
     if (!read)
     {
       if (response != NULL)
@@ -521,14 +853,15 @@ static size_t rdm_send_generic_request(
         err = ESP_OK;
 
         // Handle the parameter data
-        uint32_t response_val;
+        uint32_t response_val = 0;
         if (resp_header.response_type == RDM_RESPONSE_TYPE_ACK) {
           // Decode the parameter data
-          if (decode)
+          if (decode_format)
           {
             // Return the number of params available when response is received
-            return_val = decode(&rdm->pd, decode_params, num_decode_params,
-                                resp_header.pdl);
+            return_val = rdm_codec_decode(decode_format, &rdm->pd,
+                                          decode_params, num_decode_params,
+                                          resp_header.pdl);
             response_val = return_val;
           }
           else
@@ -539,11 +872,15 @@ static size_t rdm_send_generic_request(
           }
         } else if (resp_header.response_type == RDM_RESPONSE_TYPE_ACK_TIMER) {
           // Get the estimated response time and convert it to FreeRTOS ticks
-          rdm_decode_16bit(&rdm->pd, &response_val, 1, resp_header.pdl);
+          if (resp_header.pdl >= 2) {
+            rdm_decode_16bit(&rdm->pd, &response_val, 1, resp_header.pdl);
+          }
           response_val = pdMS_TO_TICKS(response_val * 10);
         } else if (resp_header.response_type == RDM_RESPONSE_TYPE_NACK_REASON) {
           // Report the NACK reason
-          rdm_decode_16bit(&rdm->pd, &response_val, 1, resp_header.pdl);
+          if (resp_header.pdl >= 2) {
+            rdm_decode_16bit(&rdm->pd, &response_val, 1, resp_header.pdl);
+          }
         } else if (resp_header.response_type ==
                    RDM_RESPONSE_TYPE_ACK_OVERFLOW) {
           // TODO: implement overflow support
@@ -578,6 +915,78 @@ static size_t rdm_send_generic_request(
   return return_val;
 }
 
+static size_t rdm_send_pid_request(dmx_port_t dmx_num, rdm_uid_t uid,
+                                   rdm_sub_device_t sub_device, rdm_cc_t cc,
+                                   rdm_pid_t pid, const void *param,
+                                   size_t num_params, void *data,
+                                   size_t num_data, rdm_response_t *response) {
+  // Look up the parameter data layout of the PID
+  const rdm_pid_desc_t *desc = rdm_pid_desc_find(pid);
+  if (desc == NULL) {
+    ESP_LOGE(TAG, "PID 0x%04x is not in the descriptor table", pid);
+    if (response != NULL) {
+      response->err = ESP_ERR_NOT_SUPPORTED;
+      response->type = RDM_RESPONSE_TYPE_NONE;
+      response->num_params = 0;
+    }
+    return 0;
+  }
+
+  if (cc == RDM_CC_GET_COMMAND) {
+    return rdm_send_generic_request(dmx_num, uid, sub_device, cc, pid,
+                                    desc->param, param, num_params, desc->data,
+                                    data, num_data, response);
+  } else {
+    return rdm_send_generic_request(dmx_num, uid, sub_device, cc, pid,
+                                    desc->data, data, num_data, NULL, NULL, 0,
+                                    response);
+  }
+}
+
+size_t rdm_get_parameter(dmx_port_t dmx_num, rdm_uid_t uid,
+                         rdm_sub_device_t sub_device, rdm_pid_t pid,
+                         const void *param, size_t num_params,
+                         rdm_response_t *response, void *data, size_t num) {
+  RDM_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  RDM_CHECK(uid <= RDM_MAX_UID, 0, "uid error");
+  RDM_CHECK(sub_device != RDM_ALL_SUB_DEVICES, 0, "sub_device error");
+  RDM_CHECK(param != NULL || num_params == 0, 0, "param is null");
+  RDM_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  return rdm_send_pid_request(dmx_num, uid, sub_device, RDM_CC_GET_COMMAND,
+                              pid, param, num_params, data, num, response);
+}
+
+bool rdm_set_parameter(dmx_port_t dmx_num, rdm_uid_t uid,
+                       rdm_sub_device_t sub_device, rdm_pid_t pid,
+                       const void *data, size_t num,
+                       rdm_response_t *response) {
+  RDM_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  RDM_CHECK(uid <= RDM_MAX_UID || uid == RDM_BROADCAST_ALL_UID, 0, "uid error");
+  RDM_CHECK(data != NULL || num == 0, 0, "data is null");
+  RDM_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  return rdm_send_pid_request(dmx_num, uid, sub_device, RDM_CC_SET_COMMAND,
+                              pid, NULL, 0, (void *)data, num, response);
+}
+
+size_t rdm_get_generic(dmx_port_t dmx_num, rdm_uid_t uid,
+                       rdm_sub_device_t sub_device, rdm_pid_t pid,
+                       const void *param, size_t param_len,
+                       rdm_response_t *response, void *pd, size_t size) {
+  RDM_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  RDM_CHECK(uid <= RDM_MAX_UID, 0, "uid error");
+  RDM_CHECK(sub_device != RDM_ALL_SUB_DEVICES, 0, "sub_device error");
+  RDM_CHECK(param_len <= RDM_MAX_PDL, 0, "param_len error");
+  RDM_CHECK(param != NULL || param_len == 0, 0, "param is null");
+  RDM_CHECK(pd != NULL || size == 0, 0, "pd is null");
+  RDM_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  return rdm_send_generic_request(dmx_num, uid, sub_device, RDM_CC_GET_COMMAND,
+                                  pid, &rdm_format_raw, param, param_len,
+                                  &rdm_format_raw, pd, size, response);
+}
+
 size_t rdm_get_supported_parameters(dmx_port_t dmx_num, rdm_uid_t uid,
                                     rdm_sub_device_t sub_device,
                                     rdm_response_t *response, rdm_pid_t *pids,
@@ -588,9 +997,9 @@ size_t rdm_get_supported_parameters(dmx_port_t dmx_num, rdm_uid_t uid,
   RDM_CHECK(sub_device != RDM_ALL_SUB_DEVICES, 0, "sub_device error");
   RDM_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
 
-  return rdm_send_generic_request(dmx_num, uid, sub_device, RDM_CC_GET_COMMAND,
-                                  RDM_PID_SUPPORTED_PARAMETERS, NULL, NULL, 0,
-                                  rdm_decode_16bit, pids, size, response);
+  return rdm_send_pid_request(dmx_num, uid, sub_device, RDM_CC_GET_COMMAND,
+                              RDM_PID_SUPPORTED_PARAMETERS, NULL, 0, pids,
+                              size, response);
 }
 
 size_t rdm_get_device_info(dmx_port_t dmx_num, rdm_uid_t uid,
@@ -603,9 +1012,9 @@ size_t rdm_get_device_info(dmx_port_t dmx_num, rdm_uid_t uid,
   RDM_CHECK(sub_device != RDM_ALL_SUB_DEVICES, 0, "sub_device error");
   RDM_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
 
-  return rdm_send_generic_request(
-      dmx_num, uid, sub_device, RDM_CC_GET_COMMAND, RDM_PID_DEVICE_INFO, NULL,
-      NULL, 0, rdm_decode_device_info, device_info, 1, response);
+  return rdm_send_pid_request(dmx_num, uid, sub_device, RDM_CC_GET_COMMAND,
+                              RDM_PID_DEVICE_INFO, NULL, 0, device_info, 1,
+                              response);
 }
 
 size_t rdm_get_software_version_label(dmx_port_t dmx_num, rdm_uid_t uid,
@@ -618,9 +1027,9 @@ size_t rdm_get_software_version_label(dmx_port_t dmx_num, rdm_uid_t uid,
   RDM_CHECK(sub_device != RDM_ALL_SUB_DEVICES, 0, "sub_device error");
   RDM_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
 
-  return rdm_send_generic_request(dmx_num, uid, sub_device, RDM_CC_GET_COMMAND,
-                                  RDM_PID_SOFTWARE_VERSION_LABEL, NULL, NULL, 0,
-                                  rdm_decode_string, label, size, response);
+  return rdm_send_pid_request(dmx_num, uid, sub_device, RDM_CC_GET_COMMAND,
+                              RDM_PID_SOFTWARE_VERSION_LABEL, NULL, 0, label,
+                              size, response);
 }
 
 size_t rdm_get_dmx_start_address(dmx_port_t dmx_num, rdm_uid_t uid,
@@ -632,9 +1041,9 @@ size_t rdm_get_dmx_start_address(dmx_port_t dmx_num, rdm_uid_t uid,
   RDM_CHECK(sub_device != RDM_ALL_SUB_DEVICES, 0, "sub_device error");
   RDM_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
 
-  return rdm_send_generic_request(dmx_num, uid, sub_device, RDM_CC_GET_COMMAND,
-                                  RDM_PID_DMX_START_ADDRESS, NULL, NULL, 0,
-                                  rdm_decode_16bit, start_address, 1, response);
+  return rdm_send_pid_request(dmx_num, uid, sub_device, RDM_CC_GET_COMMAND,
+                              RDM_PID_DMX_START_ADDRESS, NULL, 0, start_address,
+                              1, response);
 }
 
 bool rdm_set_dmx_start_address(dmx_port_t dmx_num, rdm_uid_t uid,
@@ -647,9 +1056,9 @@ bool rdm_set_dmx_start_address(dmx_port_t dmx_num, rdm_uid_t uid,
   RDM_CHECK(start_address > 0 && start_address < DMX_MAX_PACKET_SIZE, 0,
             "start_address must be >0 and <513");
 
-  return rdm_send_generic_request(dmx_num, uid, sub_device, RDM_CC_SET_COMMAND,
-                                  RDM_PID_DMX_START_ADDRESS, rdm_encode_16bit,
-                                  &start_address, 1, NULL, 0, 0, response);
+  return rdm_send_pid_request(dmx_num, uid, sub_device, RDM_CC_SET_COMMAND,
+                              RDM_PID_DMX_START_ADDRESS, NULL, 0,
+                              &start_address, 1, response);
 }
 
 size_t rdm_get_identify_device(dmx_port_t dmx_num, rdm_uid_t uid,
@@ -663,9 +1072,9 @@ size_t rdm_get_identify_device(dmx_port_t dmx_num, rdm_uid_t uid,
   RDM_CHECK(sub_device != RDM_ALL_SUB_DEVICES, 0,
             "cannot send to all sub-devices");
 
-  return rdm_send_generic_request(dmx_num, uid, sub_device, RDM_CC_GET_COMMAND,
-                                  RDM_PID_IDENTIFY_DEVICE, NULL, NULL, 0,
-                                  rdm_decode_8bit, identify, 1, response);
+  return rdm_send_pid_request(dmx_num, uid, sub_device, RDM_CC_GET_COMMAND,
+                              RDM_PID_IDENTIFY_DEVICE, NULL, 0, identify, 1,
+                              response);
 }
 
 bool rdm_set_identify_device(dmx_port_t dmx_num, rdm_uid_t uid,
@@ -676,9 +1085,9 @@ bool rdm_set_identify_device(dmx_port_t dmx_num, rdm_uid_t uid,
   RDM_CHECK(uid <= RDM_MAX_UID || uid == RDM_BROADCAST_ALL_UID, 0, "uid error");
   RDM_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
 
-  return rdm_send_generic_request(dmx_num, uid, sub_device, RDM_CC_SET_COMMAND,
-                                  RDM_PID_IDENTIFY_DEVICE, rdm_encode_8bit,
-                                  &identify, 1, NULL, NULL, 0, response);
+  return rdm_send_pid_request(dmx_num, uid, sub_device, RDM_CC_SET_COMMAND,
+                              RDM_PID_IDENTIFY_DEVICE, NULL, 0, &identify, 1,
+                              response);
 }
 
 bool rdm_get_header(rdm_header_t *header, const void *data)
@@ -714,7 +1123,7 @@ size_t rdm_send_set_param_response(dmx_port_t dmx_num, rdm_uid_t uid, uint8_t tn
       .source_uid = rdm_get_uid(dmx_num),
       .tn = tn,
       .port_id = RDM_RESPONSE_TYPE_ACK,
-      .message_count = 0,
+      .message_count = rdm_get_message_count(dmx_num),
       .sub_device = sub_device,
       .cc = RDM_CC_SET_COMMAND_RESPONSE,
       .pid = pid,
@@ -749,7 +1158,7 @@ size_t rdm_send_get_param_response(dmx_port_t dmx_num, rdm_uid_t uid, uint8_t tn
       .source_uid = rdm_get_uid(dmx_num),
       .tn = tn,
       .port_id = RDM_RESPONSE_TYPE_ACK,
-      .message_count = 0,
+      .message_count = rdm_get_message_count(dmx_num),
       .sub_device = sub_device,
       .cc = RDM_CC_GET_COMMAND_RESPONSE,
       .pid = pid,
@@ -762,6 +1171,140 @@ size_t rdm_send_get_param_response(dmx_port_t dmx_num, rdm_uid_t uid, uint8_t tn
   return sent;
 }
 
+// Sends a response with the given source UID and message count.
+static size_t rdm_send_response_from(dmx_port_t dmx_num, rdm_uid_t source_uid,
+                                     uint8_t message_count,
+                                     const rdm_header_t *request,
+                                     rdm_response_type_t response_type,
+                                     const void *pd, size_t pdl) {
+  RDM_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  RDM_CHECK(request != NULL, 0, "request is null");
+  RDM_CHECK(pd != NULL || pdl == 0, 0, "pd is null");
+  RDM_CHECK(pdl <= RDM_MAX_PDL, 0, "pdl error");
+  RDM_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
+  dmx_wait_sent(dmx_num, portMAX_DELAY);
+
+  // Write and send the response
+  rdm_data_t *rdm = (rdm_data_t *)driver->data.buffer;
+  if (pdl > 0) {
+    memcpy(&rdm->pd, pd, pdl);
+  }
+  rdm_header_t header = {
+      .destination_uid = request->source_uid,
+      .source_uid = source_uid,
+      .tn = request->tn,
+      .response_type = response_type,
+      .message_count = message_count,
+      .sub_device = request->sub_device,
+      .cc = request->cc + 1,
+      .pid = request->pid,
+      .pdl = pdl,
+  };
+  const size_t written = pdl + rdm_encode_header(rdm, &header);
+  const size_t sent = dmx_send(dmx_num, written);
+
+  xSemaphoreGiveRecursive(driver->mux);
+  return sent;
+}
+
+size_t rdm_send_response(dmx_port_t dmx_num, const rdm_header_t *request,
+                         rdm_response_type_t response_type, const void *pd,
+                         size_t pdl) {
+  RDM_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  RDM_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+  return rdm_send_response_from(dmx_num, rdm_get_uid(dmx_num),
+                                rdm_get_message_count(dmx_num), request,
+                                response_type, pd, pdl);
+}
+
+size_t rdm_send_response_as(dmx_port_t dmx_num, rdm_uid_t source_uid,
+                            const rdm_header_t *request,
+                            rdm_response_type_t response_type, const void *pd,
+                            size_t pdl) {
+  return rdm_send_response_from(dmx_num, source_uid, 0, request, response_type,
+                                pd, pdl);
+}
+
+size_t rdm_send_nack_response(dmx_port_t dmx_num, const rdm_header_t *request,
+                              rdm_nr_t nack_reason) {
+  const uint8_t pd[2] = {nack_reason >> 8, nack_reason};
+  return rdm_send_response(dmx_num, request, RDM_RESPONSE_TYPE_NACK_REASON, pd,
+                           sizeof(pd));
+}
+
+size_t rdm_encode_response(dmx_port_t dmx_num, void *packet,
+                           const rdm_header_t *request,
+                           rdm_response_type_t response_type, const void *pd,
+                           size_t pdl) {
+  RDM_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  RDM_CHECK(packet != NULL, 0, "packet is null");
+  RDM_CHECK(request != NULL, 0, "request is null");
+  RDM_CHECK(pd != NULL || pdl == 0, 0, "pd is null");
+  RDM_CHECK(pdl <= RDM_MAX_PDL, 0, "pdl error");
+  RDM_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  // The destination UID, TN and message count are zero so they are left out
+  // of the checksum
+  rdm_data_t *rdm = (rdm_data_t *)packet;
+  if (pdl > 0) {
+    memcpy(&rdm->pd, pd, pdl);
+  }
+  rdm_header_t header = {
+      .destination_uid = 0,
+      .source_uid = rdm_get_uid(dmx_num),
+      .tn = 0,
+      .response_type = response_type,
+      .message_count = 0,
+      .sub_device = request->sub_device,
+      .cc = request->cc + 1,
+      .pid = request->pid,
+      .pdl = pdl,
+  };
+  return pdl + rdm_encode_header(rdm, &header);
+}
+
+size_t rdm_send_encoded_response(dmx_port_t dmx_num,
+                                 const rdm_header_t *request,
+                                 const void *packet, size_t size) {
+  RDM_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  RDM_CHECK(request != NULL, 0, "request is null");
+  RDM_CHECK(packet != NULL, 0, "packet is null");
+  RDM_CHECK(size >= RDM_BASE_PACKET_SIZE &&
+                size <= RDM_BASE_PACKET_SIZE + RDM_MAX_PDL,
+            0, "size error");
+  RDM_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
+  dmx_wait_sent(dmx_num, portMAX_DELAY);
+
+  // Copy the packet and patch the fields which differ between replies
+  uint8_t *const buf = driver->data.buffer;
+  memcpy(buf, packet, size);
+  uid_to_buf(&buf[RDM_OFFSET_DESTINATION_UID], request->source_uid);
+  buf[RDM_OFFSET_TN] = request->tn;
+  buf[RDM_OFFSET_MESSAGE_COUNT] = rdm_get_message_count(dmx_num);
+
+  // Add the patched bytes to the checksum
+  uint16_t checksum = (buf[size - 2] << 8) | buf[size - 1];
+  for (int i = RDM_OFFSET_DESTINATION_UID; i < RDM_OFFSET_DESTINATION_UID + 6;
+       ++i) {
+    checksum += buf[i];
+  }
+  checksum += buf[RDM_OFFSET_TN];
+  checksum += buf[RDM_OFFSET_MESSAGE_COUNT];
+  buf[size - 2] = checksum >> 8;
+  buf[size - 1] = checksum;
+
+  const size_t sent = dmx_send(dmx_num, size);
+
+  xSemaphoreGiveRecursive(driver->mux);
+  return sent;
+}
+
 size_t rdm_send_mute_response(dmx_port_t dmx_num, rdm_uid_t uid, uint8_t tn, const rdm_disc_mute_t *mute_params)
 {
   RDM_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
@@ -786,7 +1329,7 @@ size_t rdm_send_mute_response(dmx_port_t dmx_num, rdm_uid_t uid, uint8_t tn, con
       // SET_COMMAND_RESPONSE, and DISCOVERY_COMMAND_RESPONSE), this field is used
       // as the Response Type field.
       .port_id = RDM_RESPONSE_TYPE_ACK,
-      .message_count = 0,
+      .message_count = rdm_get_message_count(dmx_num),
       .sub_device = 0,
       .cc = RDM_CC_DISC_COMMAND_RESPONSE,
       .pid = RDM_PID_DISC_MUTE,
@@ -825,7 +1368,7 @@ size_t rdm_send_idenfiy_device_response(dmx_port_t dmx_num, rdm_uid_t uid, uint8
       // SET_COMMAND_RESPONSE, and DISCOVERY_COMMAND_RESPONSE), this field is used
       // as the Response Type field.
       .port_id = RDM_RESPONSE_TYPE_ACK,
-      .message_count = 0,
+      .message_count = rdm_get_message_count(dmx_num),
       .sub_device = sub_device,
       .cc = RDM_CC_GET_COMMAND_RESPONSE,
       .pid = RDM_PID_IDENTIFY_DEVICE,
@@ -858,7 +1401,7 @@ size_t rdm_send_set_command_ack_response(dmx_port_t dmx_num, rdm_uid_t uid, uint
       // SET_COMMAND_RESPONSE, and DISCOVERY_COMMAND_RESPONSE), this field is used
       // as the Response Type field.
       .port_id = RDM_RESPONSE_TYPE_ACK,
-      .message_count = 0,
+      .message_count = rdm_get_message_count(dmx_num),
       .sub_device = sub_device,
       .cc = RDM_CC_SET_COMMAND_RESPONSE,
       .pid = pid,
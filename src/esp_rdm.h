@@ -177,6 +177,59 @@ bool rdm_set_muted(dmx_port_t dmx_num, bool muted);
 size_t rdm_send_disc_response(dmx_port_t dmx_num, size_t preamble_len,
                               rdm_uid_t uid);
 
+/**
+ * @brief Sends the DISC_UNIQUE_BRANCH responses of several UIDs at once, as
+ * they would appear on the bus if each UID responded at the same time. The
+ * encoded responses are combined with a bitwise OR, like the open-drain
+ * collision of real responders, so that a controller which receives the
+ * response of more than one UID sees a checksum error and branches further.
+ *
+ * @param dmx_num The DMX port number.
+ * @param preamble_len The length of the packet preamble (max: 7).
+ * @param[in] uids The UIDs to encode into the packet.
+ * @param num_uids The number of UIDs. Must be at least 1.
+ * @return The number of bytes sent.
+ */
+size_t rdm_send_disc_responses(dmx_port_t dmx_num, size_t preamble_len,
+                               const rdm_uid_t *uids, size_t num_uids);
+
+/**
+ * @brief Enables the DISC_UNIQUE_BRANCH fast path. When enabled, the DMX
+ * interrupt handler compares the bounds of each DISC_UNIQUE_BRANCH request
+ * against the UID and mute flag of the port and sends a pre-encoded response
+ * after the RDM turnaround time without waking a task. DISC_UNIQUE_BRANCH
+ * requests are then no longer received by dmx_receive().
+ *
+ * The fast path only answers for the UID of the port, so it cannot be enabled
+ * while virtual responders are installed with rdm_virtual_install().
+ *
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there was an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the driver is not installed or virtual
+ * responders are installed.
+ */
+esp_err_t rdm_disc_fast_path_enable(dmx_port_t dmx_num);
+
+/**
+ * @brief Disables the DISC_UNIQUE_BRANCH fast path.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there was an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the driver is not installed.
+ */
+esp_err_t rdm_disc_fast_path_disable(dmx_port_t dmx_num);
+
+/**
+ * @brief Checks if the DISC_UNIQUE_BRANCH fast path is enabled.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval true if the fast path is enabled.
+ * @retval false if the fast path is disabled or DMX port does not exist.
+ */
+bool rdm_disc_fast_path_is_enabled(dmx_port_t dmx_num);
+
 /**
  * @brief Sends an RDM discovery request and reads the response, if any.
  *
@@ -241,6 +294,112 @@ size_t rdm_discover_with_callback(dmx_port_t dmx_num, rdm_discovery_cb_t cb,
 size_t rdm_discover_devices_simple(dmx_port_t dmx_num, rdm_uid_t *uids,
                                    const size_t size);
 
+/**
+ * @brief Gets the response latency statistics of an RDM responder. Statistics
+ * are gathered whenever a request is sent to a responder. The controller uses
+ * these statistics to shorten the response timeout of fast responders and to
+ * adjust the number of discovery attempts made for unreliable responders.
+ *
+ * @param dmx_num The DMX port number.
+ * @param uid The UID of the responder.
+ * @param[out] stats A pointer into which to copy the latency statistics.
+ * @return true if statistics were found for the UID.
+ * @return false if no statistics are recorded for the UID.
+ */
+bool rdm_get_latency_stats(dmx_port_t dmx_num, rdm_uid_t uid,
+                           rdm_latency_stats_t *stats);
+
+/**
+ * @brief Gets the response latency statistics of every RDM responder that has
+ * been sent a request. The statistics are sorted from the slowest average
+ * response latency to the fastest so that slow responders can be found
+ * quickly.
+ *
+ * @note The number of responders that are tracked is set by
+ * CONFIG_RDM_LATENCY_TABLE_SIZE.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] stats An array into which to copy the latency statistics.
+ * @param size The size of the provided array.
+ * @return The number of responders for which statistics are recorded, which
+ * may be larger than the number of statistics copied.
+ */
+size_t rdm_get_all_latency_stats(dmx_port_t dmx_num,
+                                 rdm_latency_stats_t *stats, size_t size);
+
+/**
+ * @brief Clears the response latency statistics of every RDM responder.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void rdm_reset_latency_stats(dmx_port_t dmx_num);
+
+/**
+ * @brief Sends an RDM GET request for an arbitrary PID and copies the raw
+ * parameter data of the response, if any. The parameter data is copied as it
+ * appears on the bus (most-significant-byte first) so that the caller may
+ * decode it as needed.
+ *
+ * @param dmx_num The DMX port number.
+ * @param uid The UID to which to address the request.
+ * @param sub_device The sub-device to which to address the request.
+ * @param pid The parameter ID to request.
+ * @param[in] param Optional parameter data to send with the request, such as
+ * the personality number of a DMX_PERSONALITY_DESCRIPTION request.
+ * @param param_len The length of the request parameter data.
+ * @param[out] response A pointer into which to store the RDM response summary.
+ * @param[out] pd A buffer into which to copy the response parameter data.
+ * @param size The size of the provided buffer.
+ * @return The parameter data length of the response, which may be larger than
+ * the number of bytes copied into the provided buffer.
+ */
+size_t rdm_get_generic(dmx_port_t dmx_num, rdm_uid_t uid,
+                       rdm_sub_device_t sub_device, rdm_pid_t pid,
+                       const void *param, size_t param_len,
+                       rdm_response_t *response, void *pd, size_t size);
+
+/**
+ * @brief Sends an RDM GET request for a PID in the codec descriptor table and
+ * decodes the response into host data. The layout of the request and response
+ * parameter data is taken from the table in esp_rdm_codec.c.
+ *
+ * @param dmx_num The DMX port number.
+ * @param uid The UID to which to address the request.
+ * @param sub_device The sub-device to which to address the request.
+ * @param pid The parameter ID to request.
+ * @param[in] param Optional host data to encode as request parameter data.
+ * @param num_params The number of items of request parameter data.
+ * @param[out] response A pointer into which to store the RDM response summary.
+ * @param[out] data A buffer into which to decode the response.
+ * @param num The number of items that fit in the buffer, or the size of the
+ * buffer in bytes for string PIDs.
+ * @return The number of items in the response, which may be larger than the
+ * number of items decoded, or 0 if the PID is not in the descriptor table.
+ */
+size_t rdm_get_parameter(dmx_port_t dmx_num, rdm_uid_t uid,
+                         rdm_sub_device_t sub_device, rdm_pid_t pid,
+                         const void *param, size_t num_params,
+                         rdm_response_t *response, void *data, size_t num);
+
+/**
+ * @brief Sends an RDM SET request for a PID in the codec descriptor table,
+ * encoding the host data with the layout given in the table.
+ *
+ * @param dmx_num The DMX port number.
+ * @param uid The UID to which to address the request.
+ * @param sub_device The sub-device to which to address the request.
+ * @param pid The parameter ID to set.
+ * @param[in] data The host data to encode as parameter data.
+ * @param num The number of items of host data.
+ * @param[out] response A pointer into which to store the RDM response summary.
+ * @return true if the request was acknowledged.
+ * @return false if the request was not acknowledged or the PID is not in the
+ * descriptor table.
+ */
+bool rdm_set_parameter(dmx_port_t dmx_num, rdm_uid_t uid,
+                       rdm_sub_device_t sub_device, rdm_pid_t pid,
+                       const void *data, size_t num, rdm_response_t *response);
+
 /**
  * @brief Sends an RDM SUPPORTED_PARAMETERS request and reads the response, if
  * any.
@@ -355,6 +514,90 @@ bool rdm_set_identify_device(dmx_port_t dmx_num, rdm_uid_t uid,
                              rdm_sub_device_t sub_device,
                              rdm_response_t *response, bool identify);
 
+/**
+ * @brief Sends a response to an RDM request. The destination UID, transaction
+ * number, sub-device, PID, and command class of the response are derived from
+ * the request.
+ * The message count is the number of messages in the queued message ring.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] request The header of the request to which to respond.
+ * @param response_type The response type.
+ * @param[in] pd The parameter data of the response.
+ * @param pdl The parameter data length of the response.
+ * @return The number of bytes that were sent.
+ */
+size_t rdm_send_response(dmx_port_t dmx_num, const rdm_header_t *request,
+                         rdm_response_type_t response_type, const void *pd,
+                         size_t pdl);
+
+/**
+ * @brief Sends a response to an RDM request on behalf of another UID, such as
+ * a virtual responder. This is identical to rdm_send_response() except that
+ * the source UID is given and the message count is 0, because the queued
+ * message ring belongs to the UID of the port.
+ *
+ * @param dmx_num The DMX port number.
+ * @param source_uid The UID from which the response is sent.
+ * @param[in] request The header of the request to which to respond.
+ * @param response_type The response type.
+ * @param[in] pd The parameter data of the response.
+ * @param pdl The parameter data length of the response.
+ * @return The number of bytes that were sent.
+ */
+size_t rdm_send_response_as(dmx_port_t dmx_num, rdm_uid_t source_uid,
+                            const rdm_header_t *request,
+                            rdm_response_type_t response_type, const void *pd,
+                            size_t pdl);
+
+/**
+ * @brief Sends a NACK response to an RDM request.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] request The header of the request to which to respond.
+ * @param nack_reason The reason the request could not be fulfilled.
+ * @return The number of bytes that were sent.
+ */
+size_t rdm_send_nack_response(dmx_port_t dmx_num, const rdm_header_t *request,
+                              rdm_nr_t nack_reason);
+
+/**
+ * @brief Encodes a response to an RDM request into a buffer so that it may be
+ * sent many times with rdm_send_encoded_response(). The destination UID,
+ * transaction number and message count are left zero so that they may be
+ * patched for each reply without recalculating the checksum of the whole
+ * packet.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] packet The buffer into which to encode the response. Must be at
+ * least RDM_BASE_PACKET_SIZE + pdl bytes.
+ * @param[in] request The header of a request to which the response applies.
+ * @param response_type The response type.
+ * @param[in] pd The parameter data of the response.
+ * @param pdl The parameter data length of the response.
+ * @return The size of the encoded packet.
+ */
+size_t rdm_encode_response(dmx_port_t dmx_num, void *packet,
+                           const rdm_header_t *request,
+                           rdm_response_type_t response_type, const void *pd,
+                           size_t pdl);
+
+/**
+ * @brief Sends a response which was encoded with rdm_encode_response(). The
+ * destination UID and transaction number are taken from the request, the
+ * message count is taken from the queued message ring, and the checksum is
+ * updated incrementally.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] request The header of the request to which to respond.
+ * @param[in] packet The encoded response.
+ * @param size The size of the encoded response.
+ * @return The number of bytes that were sent.
+ */
+size_t rdm_send_encoded_response(dmx_port_t dmx_num,
+                                 const rdm_header_t *request,
+                                 const void *packet, size_t size);
+
 /**
  * @brief Sends response for the RDM_PID_DISC_MUTE request.
  * @param dmx_num The DMX port number.
@@ -0,0 +1,608 @@
+#include "esp_rdm_analyzer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+#include "freertos/semphr.h"
+#include "private/dmx_timing.h"
+#include "private/rdm_encode/functions.h"
+#include "private/rdm_encode/types.h"
+
+// Used for argument checking at the beginning of each function.
+#define RDM_ANALYZER_CHECK(a, err_code, format, ...) \
+  ESP_RETURN_ON_FALSE(a, err_code, TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "rdm_analyzer";  // The log tagline for the file.
+
+enum {
+  RDM_ANALYZER_SLOT_US = 44,                // The duration of a slot at the DMX baud rate.
+  RDM_ANALYZER_DISC_RESPONSE_MIN_SIZE = 17,  // The size of a DISC_UNIQUE_BRANCH response without a preamble.
+  RDM_ANALYZER_DISC_RESPONSE_MAX_SIZE = 24,  // The size of a DISC_UNIQUE_BRANCH response with the longest preamble.
+};
+
+// The part of the packet capture stream which is being read.
+typedef enum rdm_analyzer_part_t {
+  RDM_ANALYZER_PART_STREAM_HEADER,  // The header of the stream.
+  RDM_ANALYZER_PART_FRAME_HEADER,   // The header of a frame.
+  RDM_ANALYZER_PART_HEADER_EXTRA,   // Fields of a newer frame header, which are skipped.
+  RDM_ANALYZER_PART_SLOTS,          // The slots of a frame.
+  RDM_ANALYZER_PART_INVALID,        // The stream is corrupt, so the rest is skipped.
+} rdm_analyzer_part_t;
+
+// A request which awaits its response. The entry is free if the responder is
+// 0.
+typedef struct rdm_analyzer_transaction_t {
+  rdm_uid_t controller;  // The source UID of the request.
+  rdm_uid_t responder;   // The destination UID of the request.
+  int64_t end_ts;        // The time at which the request ended.
+  uint8_t tn;            // The transaction number of the request.
+} rdm_analyzer_transaction_t;
+
+typedef struct rdm_analyzer_t {
+  SemaphoreHandle_t mux;       // Protects the counters and tables.
+  rdm_analyzer_config_t config;  // The analyzer configuration.
+  rdm_analyzer_stats_t stats;  // The counters of all frames.
+  rdm_analyzer_device_stats_t *devices;  // The counters of each responder, indexed by a hash of the UID.
+  rdm_analyzer_transaction_t *transactions;  // The requests which await a response, indexed by a hash of their UIDs and transaction number.
+  bool disc_is_pending;        // True if a DISC_UNIQUE_BRANCH request awaits its response.
+  int64_t disc_end_ts;         // The time at which the DISC_UNIQUE_BRANCH request ended.
+
+  // The state of the stream reader
+  uint8_t part;                // The rdm_analyzer_part_t which is being read.
+  size_t part_size;            // The size of the part in bytes.
+  size_t num_read;             // The number of bytes of the part which have been read.
+  size_t header_size;          // The size of the frame headers of the stream.
+  dmx_capture_stream_header_t stream_header;  // The header of the stream.
+  dmx_capture_header_t header;               // The header of the frame.
+  uint8_t slots[DMX_MAX_PACKET_SIZE];        // The slots of the frame.
+} rdm_analyzer_t;
+
+static rdm_analyzer_t *rdm_analyzer[DMX_NUM_MAX] = {0};
+
+static size_t rdm_analyzer_hash(uint64_t key, size_t size) {
+  return ((key * 0x9e3779b97f4a7c15ULL) >> 32 & 0xffffffff) % size;
+}
+
+static size_t rdm_analyzer_transaction_home(
+    const rdm_analyzer_t *analyzer, const rdm_analyzer_transaction_t *entry) {
+  return rdm_analyzer_hash(entry->responder ^ (entry->controller << 16) ^
+                               entry->tn,
+                           analyzer->config.max_transactions);
+}
+
+static rdm_analyzer_device_stats_t *rdm_analyzer_find_device(
+    rdm_analyzer_t *analyzer, rdm_uid_t uid) {
+  // Open addressing with linear probing
+  const size_t size = analyzer->config.max_devices;
+  const size_t start = rdm_analyzer_hash(uid, size);
+  for (size_t i = 0; i < size; ++i) {
+    rdm_analyzer_device_stats_t *entry =
+        &analyzer->devices[(start + i) % size];
+    if (entry->uid == uid) {
+      return entry;
+    } else if (entry->uid == 0) {
+      entry->uid = uid;
+      ++analyzer->stats.num_devices;
+      return entry;
+    }
+  }
+
+  // The table is full - evict the entry in the home slot
+  rdm_analyzer_device_stats_t *entry = &analyzer->devices[start];
+  memset(entry, 0, sizeof(*entry));
+  entry->uid = uid;
+  return entry;
+}
+
+// Finds the request which a response answers. Returns its index, or -1 if no
+// request awaits the response.
+static int rdm_analyzer_find_transaction(const rdm_analyzer_t *analyzer,
+                                         rdm_uid_t controller,
+                                         rdm_uid_t responder, uint8_t tn) {
+  const size_t size = analyzer->config.max_transactions;
+  const rdm_analyzer_transaction_t key = {
+      .controller = controller, .responder = responder, .tn = tn};
+  const size_t start = rdm_analyzer_transaction_home(analyzer, &key);
+  for (size_t i = 0; i < size; ++i) {
+    const size_t index = (start + i) % size;
+    const rdm_analyzer_transaction_t *entry = &analyzer->transactions[index];
+    if (entry->responder == 0) {
+      break;
+    } else if (entry->responder == responder &&
+               entry->controller == controller && entry->tn == tn) {
+      return index;
+    }
+  }
+  return -1;
+}
+
+// Frees an entry of the transaction table. The entries which follow it are
+// shifted back so that no lookup stops early at the free entry.
+static void rdm_analyzer_remove_transaction(rdm_analyzer_t *analyzer,
+                                            size_t index) {
+  const size_t size = analyzer->config.max_transactions;
+  rdm_analyzer_transaction_t *const table = analyzer->transactions;
+  size_t next = index;
+  while (true) {
+    table[index].responder = 0;
+    size_t home;
+    do {
+      next = (next + 1) % size;
+      if (table[next].responder == 0) {
+        return;
+      }
+      home = rdm_analyzer_transaction_home(analyzer, &table[next]);
+    } while (index <= next ? (index < home && home <= next)
+                           : (index < home || home <= next));
+    table[index] = table[next];
+    index = next;
+  }
+}
+
+// Counts the requests which were not answered in time as lost.
+static void rdm_analyzer_expire(rdm_analyzer_t *analyzer, int64_t now) {
+  for (size_t i = 0; i < analyzer->config.max_transactions;) {
+    const rdm_analyzer_transaction_t *entry = &analyzer->transactions[i];
+    if (entry->responder != 0 &&
+        now - entry->end_ts > analyzer->config.response_timeout_us) {
+      ++analyzer->stats.num_lost;
+      ++rdm_analyzer_find_device(analyzer, entry->responder)->num_lost;
+      rdm_analyzer_remove_transaction(analyzer, i);
+      continue;  // Another entry may have been shifted into this one
+    }
+    ++i;
+  }
+}
+
+static void rdm_analyzer_add_transaction(rdm_analyzer_t *analyzer,
+                                         const rdm_header_t *request,
+                                         int64_t end_ts) {
+  const rdm_analyzer_transaction_t transaction = {
+      .controller = request->source_uid,
+      .responder = request->destination_uid,
+      .end_ts = end_ts,
+      .tn = request->tn};
+
+  // A repeated request replaces the one which was not answered
+  const int index = rdm_analyzer_find_transaction(
+      analyzer, transaction.controller, transaction.responder, transaction.tn);
+  if (index >= 0) {
+    analyzer->transactions[index] = transaction;
+    return;
+  }
+
+  const size_t size = analyzer->config.max_transactions;
+  const size_t start = rdm_analyzer_transaction_home(analyzer, &transaction);
+  for (size_t i = 0; i < size; ++i) {
+    rdm_analyzer_transaction_t *entry =
+        &analyzer->transactions[(start + i) % size];
+    if (entry->responder == 0) {
+      *entry = transaction;
+      return;
+    }
+  }
+
+  // The table is full - the request in the home slot is given up on
+  rdm_analyzer_transaction_t *entry = &analyzer->transactions[start];
+  ++analyzer->stats.num_lost;
+  ++rdm_analyzer_find_device(analyzer, entry->responder)->num_lost;
+  *entry = transaction;
+}
+
+static void rdm_analyzer_response(rdm_analyzer_t *analyzer,
+                                  const rdm_header_t *response, int64_t start,
+                                  int64_t end) {
+  const int index = rdm_analyzer_find_transaction(
+      analyzer, response->destination_uid, response->source_uid, response->tn);
+  if (index < 0) {
+    ++analyzer->stats.num_unmatched;
+    return;
+  }
+  const int64_t request_end_ts = analyzer->transactions[index].end_ts;
+  rdm_analyzer_remove_transaction(analyzer, index);
+
+  rdm_analyzer_device_stats_t *const device =
+      rdm_analyzer_find_device(analyzer, response->source_uid);
+  if (!response->checksum_is_valid) {
+    ++analyzer->stats.num_invalid;
+    ++device->num_invalid;
+    return;
+  }
+  ++analyzer->stats.num_responses;
+  ++device->num_responses;
+
+  // The start of the response is estimated, so it may precede the request
+  const uint32_t turnaround =
+      start > request_end_ts ? start - request_end_ts : 0;
+  const uint32_t latency = end - request_end_ts;
+  if (turnaround > RDM_RESPONDER_RESPONSE_LOST_TIMEOUT) {
+    ++device->num_late;
+  }
+  if (device->num_responses == 1 || turnaround < device->min_turnaround_us) {
+    device->min_turnaround_us = turnaround;
+  }
+  if (turnaround > device->max_turnaround_us) {
+    device->max_turnaround_us = turnaround;
+  }
+  device->total_turnaround_us += turnaround;
+  if (device->num_responses == 1 || latency < device->min_latency_us) {
+    device->min_latency_us = latency;
+  }
+  if (latency > device->max_latency_us) {
+    device->max_latency_us = latency;
+  }
+  device->total_latency_us += latency;
+
+  const rdm_data_t *const rdm = (const rdm_data_t *)analyzer->slots;
+  switch (response->response_type) {
+    case RDM_RESPONSE_TYPE_ACK:
+      ++device->num_acks;
+      break;
+    case RDM_RESPONSE_TYPE_ACK_TIMER:
+      ++device->num_ack_timers;
+      break;
+    case RDM_RESPONSE_TYPE_ACK_OVERFLOW:
+      ++device->num_ack_overflows;
+      break;
+    case RDM_RESPONSE_TYPE_NACK_REASON:
+      ++device->num_nacks;
+      if (response->pdl >= 2) {
+        const uint16_t nack_reason = rdm->pd[0] << 8 | rdm->pd[1];
+        if (nack_reason < RDM_ANALYZER_NUM_NACK_REASONS) {
+          ++device->nack_reasons[nack_reason];
+        }
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+// Decodes the frame which follows a DISC_UNIQUE_BRANCH request. Responses
+// which collide are received as a frame which cannot be decoded.
+static void rdm_analyzer_disc_response(rdm_analyzer_t *analyzer,
+                                       size_t num_slots) {
+  rdm_uid_t uid;
+  if (num_slots < RDM_ANALYZER_DISC_RESPONSE_MIN_SIZE ||
+      (analyzer->header.flags & DMX_CAPTURE_FLAG_RX_ERR)) {
+    ++analyzer->stats.num_disc_collisions;
+    return;
+  }
+  if (num_slots < RDM_ANALYZER_DISC_RESPONSE_MAX_SIZE) {
+    memset(analyzer->slots + num_slots, 0,
+           RDM_ANALYZER_DISC_RESPONSE_MAX_SIZE - num_slots);
+  }
+  if (!rdm_decode_disc_response(analyzer->slots, &uid)) {
+    ++analyzer->stats.num_disc_collisions;
+    return;
+  }
+  ++analyzer->stats.num_disc_responses;
+  ++rdm_analyzer_find_device(analyzer, uid)->num_disc_responses;
+}
+
+static void rdm_analyzer_frame(rdm_analyzer_t *analyzer) {
+  const dmx_capture_header_t *const header = &analyzer->header;
+  const size_t num_slots = header->size - analyzer->header_size;
+  ++analyzer->stats.num_frames;
+  if (header->flags & DMX_CAPTURE_FLAG_DROPPED) {
+    ++analyzer->stats.num_dropped;
+  }
+
+  // The timestamp is the end of the frame, so estimate its start
+  int64_t start = header->timestamp - (int64_t)num_slots * RDM_ANALYZER_SLOT_US;
+  if (!(header->flags & DMX_CAPTURE_FLAG_NO_BREAK)) {
+    start -= header->break_len > 0 ? header->break_len : DMX_BREAK_LEN_US;
+    start -= header->mab_len > 0 ? header->mab_len : DMX_MAB_LEN_US;
+  }
+  rdm_analyzer_expire(analyzer, start);
+
+  // Only the first frame without a DMX break after a DISC_UNIQUE_BRANCH
+  // request may be its response
+  if (analyzer->disc_is_pending) {
+    analyzer->disc_is_pending = false;
+    if ((header->flags & DMX_CAPTURE_FLAG_NO_BREAK) &&
+        start - analyzer->disc_end_ts <= analyzer->config.response_timeout_us) {
+      rdm_analyzer_disc_response(analyzer, num_slots);
+      return;
+    }
+    ++analyzer->stats.num_disc_silent;
+  }
+  if ((header->flags & DMX_CAPTURE_FLAG_NO_BREAK) || num_slots == 0 ||
+      analyzer->slots[0] != RDM_SC) {
+    return;  // Not an RDM packet
+  }
+
+  rdm_header_t rdm;
+  const rdm_data_t *const data = (const rdm_data_t *)analyzer->slots;
+  if ((header->flags & (DMX_CAPTURE_FLAG_RX_ERR | DMX_CAPTURE_FLAG_TRUNCATED)) ||
+      num_slots < RDM_BASE_PACKET_SIZE || data->sub_sc != RDM_SUB_SC ||
+      num_slots < (size_t)data->message_len + 2 ||
+      !rdm_get_header(&rdm, analyzer->slots)) {
+    ++analyzer->stats.num_invalid;
+    return;
+  }
+
+  if (rdm.cc == RDM_CC_DISC_COMMAND_RESPONSE ||
+      rdm.cc == RDM_CC_GET_COMMAND_RESPONSE ||
+      rdm.cc == RDM_CC_SET_COMMAND_RESPONSE) {
+    rdm_analyzer_response(analyzer, &rdm, start, header->timestamp);
+  } else if (!rdm.checksum_is_valid) {
+    ++analyzer->stats.num_invalid;
+  } else if (rdm.cc == RDM_CC_DISC_COMMAND &&
+             rdm.pid == RDM_PID_DISC_UNIQUE_BRANCH) {
+    ++analyzer->stats.num_discoveries;
+    analyzer->disc_is_pending = true;
+    analyzer->disc_end_ts = header->timestamp;
+  } else if (rdm_uid_is_broadcast(rdm.destination_uid)) {
+    ++analyzer->stats.num_broadcasts;
+  } else {
+    ++analyzer->stats.num_requests;
+    ++rdm_analyzer_find_device(analyzer, rdm.destination_uid)->num_requests;
+    rdm_analyzer_add_transaction(analyzer, &rdm, header->timestamp);
+  }
+}
+
+// Starts reading the next part of the stream after a part has been read.
+static void rdm_analyzer_next_part(rdm_analyzer_t *analyzer) {
+  do {
+    switch (analyzer->part) {
+      case RDM_ANALYZER_PART_STREAM_HEADER: {
+        const dmx_capture_stream_header_t *const stream_header =
+            &analyzer->stream_header;
+        if (memcmp(stream_header->magic, DMX_CAPTURE_MAGIC,
+                   sizeof(stream_header->magic)) != 0 ||
+            stream_header->version != DMX_CAPTURE_VERSION ||
+            stream_header->header_size < sizeof(dmx_capture_header_t)) {
+          ESP_LOGE(TAG, "Packet capture stream header error");
+          analyzer->part = RDM_ANALYZER_PART_INVALID;
+          return;
+        }
+        analyzer->header_size = stream_header->header_size;
+        analyzer->part = RDM_ANALYZER_PART_FRAME_HEADER;
+        analyzer->part_size = sizeof(dmx_capture_header_t);
+        break;
+      }
+      case RDM_ANALYZER_PART_FRAME_HEADER:
+        if (analyzer->header.size < analyzer->header_size ||
+            analyzer->header.size - analyzer->header_size >
+                DMX_MAX_PACKET_SIZE) {
+          ESP_LOGE(TAG, "Packet capture frame size error");
+          analyzer->part = RDM_ANALYZER_PART_INVALID;
+          return;
+        }
+        analyzer->part = RDM_ANALYZER_PART_HEADER_EXTRA;
+        analyzer->part_size =
+            analyzer->header_size - sizeof(dmx_capture_header_t);
+        break;
+      case RDM_ANALYZER_PART_HEADER_EXTRA:
+        analyzer->part = RDM_ANALYZER_PART_SLOTS;
+        analyzer->part_size = analyzer->header.size - analyzer->header_size;
+        break;
+      default:
+        rdm_analyzer_frame(analyzer);
+        analyzer->part = RDM_ANALYZER_PART_FRAME_HEADER;
+        analyzer->part_size = sizeof(dmx_capture_header_t);
+        break;
+    }
+    analyzer->num_read = 0;
+  } while (analyzer->part_size == 0);
+}
+
+// Reads bytes of the packet capture stream, which may end in any part.
+static void rdm_analyzer_read(rdm_analyzer_t *analyzer, const uint8_t *data,
+                              size_t size) {
+  while (size > 0 && analyzer->part != RDM_ANALYZER_PART_INVALID) {
+    uint8_t *dest;
+    switch (analyzer->part) {
+      case RDM_ANALYZER_PART_STREAM_HEADER:
+        dest = (uint8_t *)&analyzer->stream_header;
+        break;
+      case RDM_ANALYZER_PART_FRAME_HEADER:
+        dest = (uint8_t *)&analyzer->header;
+        break;
+      case RDM_ANALYZER_PART_SLOTS:
+        dest = analyzer->slots;
+        break;
+      default:
+        dest = NULL;  // Skipped
+        break;
+    }
+    size_t n = analyzer->part_size - analyzer->num_read;
+    if (n > size) {
+      n = size;
+    }
+    if (dest != NULL) {
+      memcpy(dest + analyzer->num_read, data, n);
+    }
+    analyzer->num_read += n;
+    data += n;
+    size -= n;
+    if (analyzer->num_read == analyzer->part_size) {
+      rdm_analyzer_next_part(analyzer);
+    }
+  }
+}
+
+// The sink of the packet capture. It is called from the capture task.
+static size_t rdm_analyzer_sink(const void *data, size_t size,
+                                void *context) {
+  rdm_analyzer_t *const analyzer = context;
+  if (analyzer->config.capture.sink != NULL) {
+    size = analyzer->config.capture.sink(data, size,
+                                         analyzer->config.capture.context);
+  }
+  xSemaphoreTake(analyzer->mux, portMAX_DELAY);
+  rdm_analyzer_read(analyzer, data, size);
+  xSemaphoreGive(analyzer->mux);
+  return size;
+}
+
+esp_err_t rdm_analyzer_start(dmx_port_t dmx_num,
+                             const rdm_analyzer_config_t *config) {
+  RDM_ANALYZER_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                     "dmx_num error");
+  RDM_ANALYZER_CHECK(config != NULL, ESP_ERR_INVALID_ARG, "config is null");
+  RDM_ANALYZER_CHECK(config->max_devices > 0, ESP_ERR_INVALID_ARG,
+                     "max_devices error");
+  RDM_ANALYZER_CHECK(config->max_transactions > 0, ESP_ERR_INVALID_ARG,
+                     "max_transactions error");
+  RDM_ANALYZER_CHECK(dmx_driver_is_installed(dmx_num), ESP_ERR_INVALID_STATE,
+                     "driver is not installed");
+  RDM_ANALYZER_CHECK(rdm_analyzer[dmx_num] == NULL, ESP_ERR_INVALID_STATE,
+                     "analyzer is already started");
+  RDM_ANALYZER_CHECK(!dmx_capture_is_started(dmx_num), ESP_ERR_INVALID_STATE,
+                     "capture is already started");
+
+  rdm_analyzer_t *analyzer = calloc(1, sizeof(rdm_analyzer_t));
+  if (analyzer == NULL) {
+    ESP_LOGE(TAG, "RDM analyzer malloc error");
+    return ESP_ERR_NO_MEM;
+  }
+  analyzer->config = *config;
+  analyzer->mux = xSemaphoreCreateMutex();
+  analyzer->devices =
+      calloc(config->max_devices, sizeof(rdm_analyzer_device_stats_t));
+  analyzer->transactions =
+      calloc(config->max_transactions, sizeof(rdm_analyzer_transaction_t));
+  if (analyzer->mux == NULL || analyzer->devices == NULL ||
+      analyzer->transactions == NULL) {
+    ESP_LOGE(TAG, "RDM analyzer malloc error");
+    if (analyzer->mux != NULL) {
+      vSemaphoreDelete(analyzer->mux);
+    }
+    free(analyzer->transactions);
+    free(analyzer->devices);
+    free(analyzer);
+    return ESP_ERR_NO_MEM;
+  }
+  analyzer->part = RDM_ANALYZER_PART_STREAM_HEADER;
+  analyzer->part_size = sizeof(dmx_capture_stream_header_t);
+
+  // The capture task decodes the frames as it writes them to the sink
+  dmx_capture_config_t capture = config->capture;
+  capture.sink = rdm_analyzer_sink;
+  capture.context = analyzer;
+  rdm_analyzer[dmx_num] = analyzer;
+  const esp_err_t err = dmx_capture_start(dmx_num, &capture);
+  if (err) {
+    rdm_analyzer[dmx_num] = NULL;
+    vSemaphoreDelete(analyzer->mux);
+    free(analyzer->transactions);
+    free(analyzer->devices);
+    free(analyzer);
+    return err;
+  }
+
+  return ESP_OK;
+}
+
+esp_err_t rdm_analyzer_stop(dmx_port_t dmx_num) {
+  RDM_ANALYZER_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                     "dmx_num error");
+  RDM_ANALYZER_CHECK(rdm_analyzer[dmx_num] != NULL, ESP_ERR_INVALID_STATE,
+                     "analyzer is not started");
+
+  // The capture may have been stopped when the driver was deleted
+  if (dmx_capture_is_started(dmx_num)) {
+    dmx_capture_stop(dmx_num);
+  }
+
+  rdm_analyzer_t *const analyzer = rdm_analyzer[dmx_num];
+  rdm_analyzer[dmx_num] = NULL;
+  vSemaphoreDelete(analyzer->mux);
+  free(analyzer->transactions);
+  free(analyzer->devices);
+  free(analyzer);
+
+  return ESP_OK;
+}
+
+bool rdm_analyzer_is_started(dmx_port_t dmx_num) {
+  return dmx_num < DMX_NUM_MAX && rdm_analyzer[dmx_num] != NULL;
+}
+
+bool rdm_analyzer_get_stats(dmx_port_t dmx_num, rdm_analyzer_stats_t *stats) {
+  RDM_ANALYZER_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  RDM_ANALYZER_CHECK(stats != NULL, false, "stats is null");
+  RDM_ANALYZER_CHECK(rdm_analyzer[dmx_num] != NULL, false,
+                     "analyzer is not started");
+
+  rdm_analyzer_t *const analyzer = rdm_analyzer[dmx_num];
+  xSemaphoreTake(analyzer->mux, portMAX_DELAY);
+  *stats = analyzer->stats;
+  xSemaphoreGive(analyzer->mux);
+  return true;
+}
+
+bool rdm_analyzer_get_device_stats(dmx_port_t dmx_num, rdm_uid_t uid,
+                                   rdm_analyzer_device_stats_t *stats) {
+  RDM_ANALYZER_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  RDM_ANALYZER_CHECK(stats != NULL, false, "stats is null");
+  RDM_ANALYZER_CHECK(rdm_analyzer[dmx_num] != NULL, false,
+                     "analyzer is not started");
+
+  rdm_analyzer_t *const analyzer = rdm_analyzer[dmx_num];
+  const size_t size = analyzer->config.max_devices;
+  const size_t start = rdm_analyzer_hash(uid, size);
+  bool found = false;
+  xSemaphoreTake(analyzer->mux, portMAX_DELAY);
+  for (size_t i = 0; i < size && uid != 0; ++i) {
+    const rdm_analyzer_device_stats_t *entry =
+        &analyzer->devices[(start + i) % size];
+    if (entry->uid == uid) {
+      *stats = *entry;
+      found = true;
+      break;
+    } else if (entry->uid == 0) {
+      break;
+    }
+  }
+  xSemaphoreGive(analyzer->mux);
+  return found;
+}
+
+size_t rdm_analyzer_get_all_device_stats(dmx_port_t dmx_num,
+                                         rdm_analyzer_device_stats_t *stats,
+                                         size_t size) {
+  RDM_ANALYZER_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  RDM_ANALYZER_CHECK(stats != NULL || size == 0, 0, "stats is null");
+  RDM_ANALYZER_CHECK(rdm_analyzer[dmx_num] != NULL, 0,
+                     "analyzer is not started");
+
+  rdm_analyzer_t *const analyzer = rdm_analyzer[dmx_num];
+  size_t num_devices = 0;
+  xSemaphoreTake(analyzer->mux, portMAX_DELAY);
+  for (size_t i = 0; i < analyzer->config.max_devices; ++i) {
+    const rdm_analyzer_device_stats_t *entry = &analyzer->devices[i];
+    if (entry->uid == 0) {
+      continue;
+    }
+    if (num_devices < size) {
+      stats[num_devices] = *entry;
+    }
+    ++num_devices;
+  }
+  xSemaphoreGive(analyzer->mux);
+  return num_devices;
+}
+
+void rdm_analyzer_reset(dmx_port_t dmx_num) {
+  if (!rdm_analyzer_is_started(dmx_num)) {
+    return;
+  }
+
+  rdm_analyzer_t *const analyzer = rdm_analyzer[dmx_num];
+  xSemaphoreTake(analyzer->mux, portMAX_DELAY);
+  memset(&analyzer->stats, 0, sizeof(analyzer->stats));
+  memset(analyzer->devices, 0,
+         analyzer->config.max_devices * sizeof(rdm_analyzer_device_stats_t));
+  memset(analyzer->transactions, 0,
+         analyzer->config.max_transactions *
+             sizeof(rdm_analyzer_transaction_t));
+  analyzer->disc_is_pending = false;
+  xSemaphoreGive(analyzer->mux);
+}
@@ -0,0 +1,197 @@
+/**
+ * @file esp_rdm_analyzer.h
+ * @brief This file declares functions for the RDM transaction analyzer. The
+ * analyzer reads the packet capture of a DMX port, as started by
+ * dmx_capture_start(), and decodes the RDM frames on the line the way a
+ * protocol analyzer would. Requests are paired with their responses by UID and
+ * transaction number, and the turnaround, latency, response types, and NACK
+ * reasons of each responder are counted, as are the outcomes of
+ * DISC_UNIQUE_BRANCH requests. The analyzer never sends, so it may be used on
+ * a port which only listens to the line, such as a port with the DMX sniffer
+ * enabled.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "rdm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The number of NACK reasons which are counted separately, from
+ * RDM_NR_UNKNOWN_PID to RDM_NR_PROXY_BUFFER_FULL.
+ */
+#define RDM_ANALYZER_NUM_NACK_REASONS (RDM_NR_PROXY_BUFFER_FULL + 1)
+
+/**
+ * @brief Configuration for the RDM transaction analyzer.
+ */
+typedef struct rdm_analyzer_config_t {
+  dmx_capture_config_t capture;  // The configuration of the packet capture which the analyzer reads. The sink may be NULL. Otherwise the stream is also written to it, and the analyzer reads only the bytes which the sink accepts.
+  size_t max_devices;            // The maximum number of responders for which statistics are kept. Once the table is full, the statistics of other responders replace existing entries.
+  size_t max_transactions;       // The maximum number of requests which may await a response at once, e.g. from several controllers on the line.
+  uint32_t response_timeout_us;  // The time in microseconds from the end of a request until its response must start before the request is counted as lost.
+} rdm_analyzer_config_t;
+
+/**
+ * @brief The default configuration for the RDM transaction analyzer. The
+ * capture task decodes the frames, so it is given a larger stack.
+ */
+#define RDM_ANALYZER_DEFAULT_CONFIG                  \
+  {                                                  \
+    .capture = {                                     \
+      .sink = NULL,                                  \
+      .context = NULL,                               \
+      .buffer_size = 8192,                           \
+      .priority = tskIDLE_PRIORITY + 2,              \
+      .core_id = tskNO_AFFINITY,                     \
+      .stack_size = 3072,                            \
+    },                                               \
+    .max_devices = 32,                               \
+    .max_transactions = 8,                           \
+    .response_timeout_us = 2800,                     \
+  }
+
+/**
+ * @brief The counters of the RDM transaction analyzer for all of the frames
+ * on a DMX port.
+ */
+typedef struct rdm_analyzer_stats_t {
+  uint32_t num_frames;           // The number of frames which were read from the capture.
+  uint32_t num_dropped;          // The number of frames which followed frames that the capture dropped. Responses after dropped frames may not be paired.
+  uint32_t num_invalid;          // The number of RDM frames with an invalid checksum, a receive error, or a truncated message.
+  uint32_t num_requests;         // The number of requests which were addressed to one responder.
+  uint32_t num_broadcasts;       // The number of broadcast requests, which are not answered.
+  uint32_t num_responses;        // The number of responses which were paired with a request.
+  uint32_t num_unmatched;        // The number of responses which did not answer an outstanding request.
+  uint32_t num_lost;             // The number of requests for which no response was seen.
+  uint32_t num_discoveries;      // The number of DISC_UNIQUE_BRANCH requests.
+  uint32_t num_disc_responses;   // The number of DISC_UNIQUE_BRANCH requests which were answered by one responder.
+  uint32_t num_disc_collisions;  // The number of DISC_UNIQUE_BRANCH requests which were answered by a response which could not be decoded, i.e. several responders collided.
+  uint32_t num_disc_silent;      // The number of DISC_UNIQUE_BRANCH requests which were not answered.
+  uint32_t num_devices;          // The number of responders for which statistics are kept.
+} rdm_analyzer_stats_t;
+
+/**
+ * @brief The counters of the RDM transaction analyzer for one responder. The
+ * turnaround is the time from the end of a request until the DMX break of its
+ * response starts. The latency is the time from the end of a request until
+ * the end of its response. When the DMX break and mark-after-break of a
+ * response are not measured, the typical lengths are assumed.
+ */
+typedef struct rdm_analyzer_device_stats_t {
+  rdm_uid_t uid;                 // The UID of the responder.
+  uint32_t num_requests;         // The number of requests which were addressed to the responder.
+  uint32_t num_responses;        // The number of responses which were paired with a request.
+  uint32_t num_lost;             // The number of requests for which no response was seen.
+  uint32_t num_late;             // The number of responses which started later than the responder turnaround of E1.20 allows.
+  uint32_t num_invalid;          // The number of responses with an invalid checksum.
+  uint32_t num_acks;             // The number of RDM_RESPONSE_TYPE_ACK responses.
+  uint32_t num_ack_timers;       // The number of RDM_RESPONSE_TYPE_ACK_TIMER responses.
+  uint32_t num_ack_overflows;    // The number of RDM_RESPONSE_TYPE_ACK_OVERFLOW responses.
+  uint32_t num_nacks;            // The number of RDM_RESPONSE_TYPE_NACK_REASON responses.
+  uint32_t nack_reasons[RDM_ANALYZER_NUM_NACK_REASONS];  // The number of NACK responses of each rdm_nr_t. Other reasons are only counted in num_nacks.
+  uint32_t num_disc_responses;   // The number of DISC_UNIQUE_BRANCH responses which were decoded with the UID.
+  uint32_t min_turnaround_us;    // The shortest turnaround in microseconds.
+  uint32_t max_turnaround_us;    // The longest turnaround in microseconds.
+  uint64_t total_turnaround_us;  // The sum of the turnarounds of all paired responses.
+  uint32_t min_latency_us;       // The shortest latency in microseconds.
+  uint32_t max_latency_us;       // The longest latency in microseconds.
+  uint64_t total_latency_us;     // The sum of the latencies of all paired responses.
+} rdm_analyzer_device_stats_t;
+
+/**
+ * @brief Starts the RDM transaction analyzer on a DMX port. A packet capture
+ * is started on the port, and its frames are decoded by the capture task. The
+ * DMX driver must be installed and the packet capture must not be started.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] config A pointer to the analyzer configuration.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_NO_MEM if there is not enough memory.
+ * @retval ESP_ERR_INVALID_STATE if the analyzer or the packet capture is
+ * already started or the DMX driver is not installed.
+ */
+esp_err_t rdm_analyzer_start(dmx_port_t dmx_num,
+                             const rdm_analyzer_config_t *config);
+
+/**
+ * @brief Stops the RDM transaction analyzer on a DMX port and its packet
+ * capture, and frees its resources. The frames which were captured before it
+ * was stopped are decoded first.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the analyzer is not started.
+ */
+esp_err_t rdm_analyzer_stop(dmx_port_t dmx_num);
+
+/**
+ * @brief Checks if the RDM transaction analyzer is started on a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the analyzer is started.
+ * @return false if it is not, or the DMX port does not exist.
+ */
+bool rdm_analyzer_is_started(dmx_port_t dmx_num);
+
+/**
+ * @brief Copies the counters of the RDM transaction analyzer for all of the
+ * frames on a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] stats A pointer into which to copy the counters.
+ * @return true if the counters were copied.
+ * @return false if the analyzer is not started or there is an argument error.
+ */
+bool rdm_analyzer_get_stats(dmx_port_t dmx_num, rdm_analyzer_stats_t *stats);
+
+/**
+ * @brief Copies the counters of the RDM transaction analyzer for one
+ * responder.
+ *
+ * @param dmx_num The DMX port number.
+ * @param uid The UID of the responder.
+ * @param[out] stats A pointer into which to copy the counters.
+ * @return true if counters are kept for the UID.
+ * @return false if they are not, the analyzer is not started, or there is an
+ * argument error.
+ */
+bool rdm_analyzer_get_device_stats(dmx_port_t dmx_num, rdm_uid_t uid,
+                                   rdm_analyzer_device_stats_t *stats);
+
+/**
+ * @brief Copies the counters of the RDM transaction analyzer for every
+ * responder for which they are kept, in no particular order.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] stats An array into which to copy the counters.
+ * @param size The size of the array.
+ * @return The number of responders for which counters are kept, which may be
+ * larger than the number which were copied.
+ */
+size_t rdm_analyzer_get_all_device_stats(dmx_port_t dmx_num,
+                                         rdm_analyzer_device_stats_t *stats,
+                                         size_t size);
+
+/**
+ * @brief Clears the counters of the RDM transaction analyzer of a DMX port and
+ * forgets the requests which await a response.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void rdm_analyzer_reset(dmx_port_t dmx_num);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,19 +4,106 @@
 #include "esp_log.h"
 #include "esp_check.h"
 #include "esp_dmx.h"
+#include "esp_rdm_codec.h"
+#include "esp_rdm_persist.h"
+#include "esp_rdm_queue.h"
+#include "esp_rdm_virtual.h"
+#include "esp_timer.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "private/dmx_timing.h"
+#include "private/driver.h"
 #include "private/rdm_encode/functions.h"
+#include "private/rdm_responder.h"
+#include <stdlib.h>
 #include <string.h>
 #include "rdmsensors.h"
 
-#define MAX_NUM_PERSONALITIES 100
+#define MAX_NUM_PERSONALITIES 255 // The personality count is a single byte in DEVICE_INFO
+#define MAX_PERSONALITY_DESCRIPTION_LEN 32
 
+#ifndef CONFIG_RDM_CLIENT_MAX_PIDS
+#define CONFIG_RDM_CLIENT_MAX_PIDS 32
+#endif
 
-typedef struct rdm_client_personality_t
+// More colliding DISC_UNIQUE_BRANCH responses do not change what a controller receives
+#define RDM_CLIENT_MAX_DISC_COLLISION 8
+
+#ifndef CONFIG_RDM_CLIENT_QUEUE_SIZE
+#define CONFIG_RDM_CLIENT_QUEUE_SIZE 16
+#endif
+
+#ifndef CONFIG_RDM_CLIENT_RESPONSE_CACHE_SIZE
+#define CONFIG_RDM_CLIENT_RESPONSE_CACHE_SIZE 8
+#endif
+
+enum
+{
+    RDM_CLIENT_HANDLER_DISC, // The handler slot of DISC_COMMAND requests.
+    RDM_CLIENT_HANDLER_GET,  // The handler slot of GET_COMMAND requests.
+    RDM_CLIENT_HANDLER_SET,  // The handler slot of SET_COMMAND requests.
+    RDM_CLIENT_HANDLER_MAX
+};
+
+/**
+ * A row of the PID handler table
+ */
+typedef struct rdm_client_pid_entry_t
+{
+    rdm_pid_t pid;
+    rdm_pid_handler_t handlers[RDM_CLIENT_HANDLER_MAX];
+    void *context;
+    bool is_cacheable; // True if GET responses only change when a setter is called
+    bool supports_sub_devices; // True if the handlers accept requests to sub-devices
+} rdm_client_pid_entry_t;
+
+/**
+ * A pre-encoded GET response. Only the destination UID, transaction number and
+ * checksum are patched when it is sent.
+ */
+typedef struct rdm_client_cached_response_t
+{
+    bool is_valid;
+    rdm_pid_t pid;
+    uint8_t param_len;
+    uint8_t param[4];     // The parameter data of the request, e.g. the personality number
+    rdm_uid_t source_uid; // The UID of the responder when the response was encoded
+    size_t size;
+    uint8_t packet[RDM_BASE_PACKET_SIZE + RDM_MAX_PDL];
+} rdm_client_cached_response_t;
+
+// PIDs whose GET responses are cached by the built-in handlers
+static const rdm_pid_t rdm_client_cacheable_pids[] = {
+    RDM_PID_SUPPORTED_PARAMETERS,
+    RDM_PID_DEVICE_INFO,
+    RDM_PID_DEVICE_MODEL_DESCRIPTION,
+    RDM_PID_MANUFACTURER_LABEL,
+    RDM_PID_SOFTWARE_VERSION_LABEL,
+    RDM_PID_DMX_PERSONALITY_DESCRIPTION,
+};
+
+// PIDs whose built-in handlers accept requests to sub-devices
+static const rdm_pid_t rdm_client_sub_device_pids[] = {
+    RDM_PID_SUPPORTED_PARAMETERS,
+    RDM_PID_DEVICE_INFO,
+    RDM_PID_DEVICE_LABEL,
+    RDM_PID_DMX_START_ADDRESS,
+    RDM_PID_IDENTIFY_DEVICE,
+};
+
+/**
+ * The parameters of a sub-device. The label is only allocated once it is set.
+ */
+typedef struct rdm_client_sub_device_t
 {
+    rdm_sub_device_t number;
+    uint16_t model_id;
     uint16_t footprint;
-    char description[32];
-    uint8_t description_len;
-} rdm_client_personality_t;
+    uint16_t start_address;
+    bool identify;
+    uint8_t label_len;
+    char *label;
+} rdm_client_sub_device_t;
 
 /**
  * All parameters of a rdm client device
@@ -26,13 +113,92 @@ typedef struct rdm_client_parameters_t
     start_address_changed_cb_t address_cb;
     identify_cb_t identify_cb;
     label_changed_cb_t label_cb;
-    rdm_client_personality_t personalities[MAX_NUM_PERSONALITIES];
+    const rdm_client_personality_t *personalities; // Either a table of the application or personality_pool
+    rdm_client_personality_t *personality_pool;    // Exactly sized copy of the personalities which were added at runtime
     personality_changed_cb_t personality_cb;
+    rdm_client_pid_entry_t pids[CONFIG_RDM_CLIENT_MAX_PIDS]; // Sorted by PID
+    size_t num_pids;
+    rdm_client_cached_response_t *responses; // CONFIG_RDM_CLIENT_RESPONSE_CACHE_SIZE slots, allocated by rdm_client_init()
+    size_t next_response; // The cache slot which is replaced next
+    uint32_t response_generation; // Incremented by each invalidation, under the spinlock of the port
+    rdm_queued_message_t last_message; // The last message returned by QUEUED_MESSAGE
+    uint8_t *last_status_pd; // The last STATUS_MESSAGES response, allocated by rdm_client_init()
+    size_t last_status_pdl;
+    rdm_client_sub_device_t *sub_devices; // Sorted by number and sized to num_sub_devices
+    size_t num_sub_devices;
+    sub_device_changed_cb_t sub_device_cb;
+    bool is_all_call; // True while a SET to all sub-devices is applied
 } rdm_client_parameters_t;
 
+static void rdm_client_register_default_pids(dmx_port_t dmx_num);
+static void rdm_client_invalidate_responses(dmx_port_t dmx_num);
+static void rdm_client_free_personalities(dmx_port_t dmx_num);
+static int rdm_client_find_pid(const rdm_client_parameters_t *client_params, rdm_pid_t pid, size_t *insert_at);
+static size_t rdm_client_list_supported_parameters(dmx_port_t dmx_num, rdm_pid_t *pids, size_t size,
+                                                   bool is_sub_device);
+
+
+/**
+ * State of the RDM responder task of a port
+ */
+typedef struct rdm_client_responder_t
+{
+    volatile bool is_running;
+    TaskHandle_t task;
+    QueueHandle_t dmx_queue;     // Holds the latest DMX packet
+    SemaphoreHandle_t stopped;   // Given by the task when it exits
+    rdm_responder_config_t config;
+    rdm_responder_stats_t stats;
+} rdm_client_responder_t;
 
 rdm_parameters_t rdm_parameters[DMX_NUM_MAX] = {0};
 rdm_client_parameters_t rdm_client_parameters[DMX_NUM_MAX] = {0};
+static rdm_client_responder_t rdm_client_responder[DMX_NUM_MAX] = {0};
+
+static int rdm_client_find_sub_device_index(dmx_port_t dmx_num, rdm_sub_device_t sub_device, size_t *insert_at)
+{
+    // Binary search the sorted sub-device table
+    const rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    size_t lo = 0;
+    size_t hi = client_params->num_sub_devices;
+    while (lo < hi)
+    {
+        const size_t mid = (lo + hi) / 2;
+        const rdm_sub_device_t mid_number = client_params->sub_devices[mid].number;
+        if (mid_number == sub_device)
+        {
+            return mid;
+        }
+        else if (mid_number < sub_device)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    if (insert_at != NULL)
+    {
+        *insert_at = lo;
+    }
+    return -1;
+}
+
+static rdm_client_sub_device_t *rdm_client_find_sub_device(dmx_port_t dmx_num, rdm_sub_device_t sub_device)
+{
+    const int index = rdm_client_find_sub_device_index(dmx_num, sub_device, NULL);
+    return index >= 0 ? &rdm_client_parameters[dmx_num].sub_devices[index] : NULL;
+}
+
+static void rdm_client_notify_sub_device(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid)
+{
+    const rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    if (client_params->sub_device_cb != NULL && !client_params->is_all_call)
+    {
+        client_params->sub_device_cb(sub_device, pid);
+    }
+}
 
 void rdm_client_set_start_address_changed_cb(dmx_port_t dmx_num, start_address_changed_cb_t cb)
 {
@@ -54,6 +220,20 @@ void rdm_client_set_start_address(dmx_port_t dmx_num, uint16_t start_address)
     }
     rdm_parameters_t *params = &rdm_parameters[dmx_num];
     params->device_info.start_address = start_address;
+    rdm_client_invalidate_responses(dmx_num);
+    rdm_persist_mark_dirty(dmx_num, RDM_PERSIST_START_ADDRESS);
+    rdm_queue_post(dmx_num, RDM_ROOT_DEVICE, RDM_PID_DMX_START_ADDRESS);
+}
+
+void rdm_client_set_sensor_count(dmx_port_t dmx_num, size_t sensor_count)
+{
+    if (dmx_num >= DMX_NUM_MAX)
+    {
+        ESP_LOGE("rdm_client", "dmx_num too large");
+        return;
+    }
+    rdm_parameters[dmx_num].device_info.sensor_count = sensor_count;
+    rdm_client_invalidate_responses(dmx_num);
 }
 
 void rdm_client_set_notify_cb(dmx_port_t dmx_num, identify_cb_t cb)
@@ -110,6 +290,7 @@ bool rdm_client_init(dmx_port_t dmx_num, uint16_t start_address, uint16_t footpr
     }
 
     rdm_parameters_t *params = &rdm_parameters[dmx_num];
+    rdm_client_free_personalities(dmx_num);
 
     params->device_info.major_rdm_version = 1;
     params->device_info.minor_rdm_version = 0;
@@ -119,34 +300,88 @@ bool rdm_client_init(dmx_port_t dmx_num, uint16_t start_address, uint16_t footpr
     params->device_info.software_version_id = 0x42;
     params->device_info.footprint = footprint;
     params->device_info.current_personality = 1;
-    params->device_info.personality_count = 1;
+    params->device_info.personality_count = 0;
     params->device_info.start_address = start_address;
-    params->device_info.sub_device_count = 0;
-    params->device_info.sensor_count = 1;
+    params->device_info.sub_device_count = rdm_client_parameters[dmx_num].num_sub_devices;
+    params->device_info.sensor_count = rdm_sensor_count(dmx_num);
     params->identify_device = false;
 
     strcpy(params->device_label, device_label);
     params->device_label_len = strlen(device_label);
 
     rdm_client_parameters_t* client_params = &rdm_client_parameters[dmx_num];
+    client_params->personality_cb = NULL;
+
+    if (rdm_client_add_personality(dmx_num, footprint, personality_description) < 0)
+    {
+        return false;
+    }
+
+    if (!rdm_queue_is_installed(dmx_num) && rdm_queue_install(dmx_num, CONFIG_RDM_CLIENT_QUEUE_SIZE) != ESP_OK)
+    {
+        return false;
+    }
+    client_params->last_message.pid = 0;
+    client_params->last_status_pdl = 0;
+
+    // Allocate the response cache and the last status messages on the heap so
+    // that ports which are not RDM responders do not use the memory
+    if (client_params->responses == NULL)
+    {
+        client_params->responses = calloc(CONFIG_RDM_CLIENT_RESPONSE_CACHE_SIZE, sizeof(rdm_client_cached_response_t));
+        client_params->next_response = 0;
+    }
+    if (client_params->last_status_pd == NULL)
+    {
+        client_params->last_status_pd = malloc(RDM_QUEUE_MAX_STATUS_MESSAGES * 9);
+    }
+    if (client_params->responses == NULL || client_params->last_status_pd == NULL)
+    {
+        ESP_LOGE("rdm_client", "response cache malloc error");
+        return false;
+    }
+    rdm_client_invalidate_responses(dmx_num);
 
-    client_params->personalities[0].footprint = footprint;
-    client_params->personalities[0].description_len = strlen(personality_description);
-     client_params->personality_cb = NULL;
-    strcpy(client_params->personalities[0].description, personality_description);
+    rdm_client_register_default_pids(dmx_num);
 
     return true;
 }
 
-bool rdm_client_set_personality(dmx_port_t dmx_num, uint8_t personality)
+bool rdm_client_deinit(dmx_port_t dmx_num)
 {
     if (dmx_num >= DMX_NUM_MAX)
     {
         ESP_LOGE("rdm_client", "dmx_num too large");
-        return -1;
-    }   
+        return false;
+    }
+    if (rdm_client_responder_is_running(dmx_num))
+    {
+        ESP_LOGE("rdm_client", "responder is running");
+        return false;
+    }
+
+    rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    rdm_client_free_personalities(dmx_num);
+    rdm_parameters[dmx_num].device_info.personality_count = 0;
+    free(client_params->responses);
+    client_params->responses = NULL;
+    client_params->next_response = 0;
+    free(client_params->last_status_pd);
+    client_params->last_status_pd = NULL;
+    client_params->last_status_pdl = 0;
+    client_params->num_pids = 0;
+    if (rdm_queue_is_installed(dmx_num))
+    {
+        rdm_queue_delete(dmx_num);
+    }
+
+    return true;
+}
+
+static bool rdm_client_select_personality(dmx_port_t dmx_num, uint8_t personality)
+{
     rdm_parameters_t *params = &rdm_parameters[dmx_num];
-    if(personality > params->device_info.personality_count)
+    if(personality == 0 || personality > params->device_info.personality_count)
     {
         ESP_LOGE("rdm_client", "personality too large");
         return false;
@@ -154,6 +389,23 @@ bool rdm_client_set_personality(dmx_port_t dmx_num, uint8_t personality)
     params->device_info.current_personality = personality;
     rdm_client_parameters_t* client_params = &rdm_client_parameters[dmx_num];
     params->device_info.footprint = client_params->personalities[personality - 1].footprint;
+    rdm_client_invalidate_responses(dmx_num);
+    rdm_persist_mark_dirty(dmx_num, RDM_PERSIST_PERSONALITY);
+    return true;
+}
+
+bool rdm_client_set_personality(dmx_port_t dmx_num, uint8_t personality)
+{
+    if (dmx_num >= DMX_NUM_MAX)
+    {
+        ESP_LOGE("rdm_client", "dmx_num too large");
+        return -1;
+    }   
+    if (!rdm_client_select_personality(dmx_num, personality))
+    {
+        return false;
+    }
+    rdm_queue_post(dmx_num, RDM_ROOT_DEVICE, RDM_PID_DMX_PERSONALITY);
     return true;
 }
 
@@ -164,6 +416,11 @@ int rdm_client_add_personality(dmx_port_t dmx_num, uint16_t footprint, const cha
         ESP_LOGE("rdm_client", "dmx_num too large");
         return -1;
     }
+    if (rdm_client_responder_is_running(dmx_num))
+    {
+        ESP_LOGE("rdm_client", "responder is running");
+        return -1;
+    }
     if(strlen(description) > 31)
     {
         ESP_LOGE("rdm_client", "description too long. Max size is 31");
@@ -172,35 +429,293 @@ int rdm_client_add_personality(dmx_port_t dmx_num, uint16_t footprint, const cha
 
     rdm_client_parameters_t* client_params = &rdm_client_parameters[dmx_num];
     rdm_parameters_t *params = &rdm_parameters[dmx_num];
-    if(params->device_info.personality_count >= MAX_NUM_PERSONALITIES)
+    const size_t count = params->device_info.personality_count;
+    if(count >= MAX_NUM_PERSONALITIES)
     {
         ESP_LOGE("rdm_client", "max num personalities reached");
         return -1;
     }
 
-    client_params->personalities[params->device_info.personality_count].footprint = footprint;
-    client_params->personalities[params->device_info.personality_count].description_len = strlen(description);
-    strcpy(client_params->personalities[params->device_info.personality_count].description, description);    
+    // Grow the pool by exactly one personality
+    char *copy = strdup(description);
+    rdm_client_personality_t *pool =
+        copy != NULL ? realloc(client_params->personality_pool, (count + 1) * sizeof(*pool)) : NULL;
+    if (pool == NULL)
+    {
+        ESP_LOGE("rdm_client", "out of memory");
+        free(copy);
+        return -1;
+    }
+
+    // Personalities of an application table are copied into the pool first
+    if (client_params->personality_pool == NULL)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            pool[i].footprint = client_params->personalities[i].footprint;
+            pool[i].description = strndup(client_params->personalities[i].description,
+                                          MAX_PERSONALITY_DESCRIPTION_LEN);
+            if (pool[i].description == NULL)
+            {
+                ESP_LOGE("rdm_client", "out of memory");
+                for (size_t j = 0; j < i; ++j)
+                {
+                    free((char *)pool[j].description);
+                }
+                free(pool);
+                free(copy);
+                return -1;
+            }
+        }
+    }
+
+    pool[count].footprint = footprint;
+    pool[count].description = copy;
+    client_params->personality_pool = pool;
+    client_params->personalities = pool;
     params->device_info.personality_count++;
+    rdm_client_invalidate_responses(dmx_num);
     return params->device_info.personality_count;
 }
 
+bool rdm_client_set_personalities(dmx_port_t dmx_num, const rdm_client_personality_t *personalities, size_t count)
+{
+    if (dmx_num >= DMX_NUM_MAX)
+    {
+        ESP_LOGE("rdm_client", "dmx_num too large");
+        return false;
+    }
+    if (rdm_client_responder_is_running(dmx_num))
+    {
+        ESP_LOGE("rdm_client", "responder is running");
+        return false;
+    }
+    if (personalities == NULL || count == 0 || count > MAX_NUM_PERSONALITIES)
+    {
+        ESP_LOGE("rdm_client", "personality count must be between 1 and %d", MAX_NUM_PERSONALITIES);
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (personalities[i].description == NULL)
+        {
+            ESP_LOGE("rdm_client", "personality %d has no description", (int)i + 1);
+            return false;
+        }
+    }
+
+    rdm_client_free_personalities(dmx_num);
+    rdm_client_parameters[dmx_num].personalities = personalities;
+    rdm_parameters_t *params = &rdm_parameters[dmx_num];
+    params->device_info.personality_count = count;
+    params->device_info.current_personality = 1;
+    params->device_info.footprint = personalities[0].footprint;
+    rdm_client_invalidate_responses(dmx_num);
+    rdm_persist_mark_dirty(dmx_num, RDM_PERSIST_PERSONALITY);
+    return true;
+}
+
+void rdm_client_set_sub_device_changed_cb(dmx_port_t dmx_num, sub_device_changed_cb_t cb)
+{
+    if (dmx_num >= DMX_NUM_MAX)
+    {
+        ESP_LOGE("rdm_client", "dmx_num too large");
+        return;
+    }
+    rdm_client_parameters[dmx_num].sub_device_cb = cb;
+}
+
+bool rdm_client_add_sub_device(dmx_port_t dmx_num, rdm_sub_device_t sub_device, uint16_t model_id,
+                               uint16_t footprint, uint16_t start_address)
+{
+    if (dmx_num >= DMX_NUM_MAX)
+    {
+        ESP_LOGE("rdm_client", "dmx_num too large");
+        return false;
+    }
+    if (rdm_client_responder_is_running(dmx_num))
+    {
+        ESP_LOGE("rdm_client", "responder is running");
+        return false;
+    }
+    if (sub_device == RDM_ROOT_DEVICE || sub_device > RDM_MAX_SUB_DEVICE)
+    {
+        ESP_LOGE("rdm_client", "sub_device must be between 1 and %d", RDM_MAX_SUB_DEVICE);
+        return false;
+    }
+    if (footprint > 0 && (start_address < 1 || start_address > 512))
+    {
+        ESP_LOGE("rdm_client", "start_address must be between 1 and 512");
+        return false;
+    }
+
+    rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    size_t insert_at;
+    if (rdm_client_find_sub_device_index(dmx_num, sub_device, &insert_at) >= 0)
+    {
+        ESP_LOGE("rdm_client", "sub_device %d already exists", sub_device);
+        return false;
+    }
+
+    // Grow the table by exactly one sub-device
+    rdm_client_sub_device_t *sub_devices =
+        realloc(client_params->sub_devices, (client_params->num_sub_devices + 1) * sizeof(*sub_devices));
+    if (sub_devices == NULL)
+    {
+        ESP_LOGE("rdm_client", "out of memory");
+        return false;
+    }
+    memmove(&sub_devices[insert_at + 1], &sub_devices[insert_at],
+            (client_params->num_sub_devices - insert_at) * sizeof(*sub_devices));
+    rdm_client_sub_device_t *entry = &sub_devices[insert_at];
+    entry->number = sub_device;
+    entry->model_id = model_id;
+    entry->footprint = footprint;
+    entry->start_address = footprint > 0 ? start_address : 0xffff;
+    entry->identify = false;
+    entry->label_len = 0;
+    entry->label = NULL;
+    client_params->sub_devices = sub_devices;
+    ++client_params->num_sub_devices;
+
+    rdm_parameters[dmx_num].device_info.sub_device_count = client_params->num_sub_devices;
+    rdm_client_invalidate_responses(dmx_num);
+    return true;
+}
+
+bool rdm_client_remove_sub_device(dmx_port_t dmx_num, rdm_sub_device_t sub_device)
+{
+    if (dmx_num >= DMX_NUM_MAX)
+    {
+        ESP_LOGE("rdm_client", "dmx_num too large");
+        return false;
+    }
+    if (rdm_client_responder_is_running(dmx_num))
+    {
+        ESP_LOGE("rdm_client", "responder is running");
+        return false;
+    }
+    rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    const int index = rdm_client_find_sub_device_index(dmx_num, sub_device, NULL);
+    if (index < 0)
+    {
+        return false;
+    }
+
+    free(client_params->sub_devices[index].label);
+    memmove(&client_params->sub_devices[index], &client_params->sub_devices[index + 1],
+            (client_params->num_sub_devices - index - 1) * sizeof(client_params->sub_devices[0]));
+    --client_params->num_sub_devices;
+    if (client_params->num_sub_devices == 0)
+    {
+        free(client_params->sub_devices);
+        client_params->sub_devices = NULL;
+    }
+    else
+    {
+        rdm_client_sub_device_t *sub_devices = realloc(
+            client_params->sub_devices, client_params->num_sub_devices * sizeof(client_params->sub_devices[0]));
+        if (sub_devices != NULL)
+        {
+            client_params->sub_devices = sub_devices;
+        }
+    }
+
+    rdm_parameters[dmx_num].device_info.sub_device_count = client_params->num_sub_devices;
+    rdm_client_invalidate_responses(dmx_num);
+    return true;
+}
+
+bool rdm_client_get_sub_device(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_client_sub_device_info_t *info)
+{
+    if (dmx_num >= DMX_NUM_MAX || info == NULL)
+    {
+        ESP_LOGE("rdm_client", "invalid argument");
+        return false;
+    }
+    const rdm_client_sub_device_t *entry = rdm_client_find_sub_device(dmx_num, sub_device);
+    if (entry == NULL)
+    {
+        return false;
+    }
+    info->model_id = entry->model_id;
+    info->footprint = entry->footprint;
+    info->start_address = entry->start_address;
+    info->identify = entry->identify;
+    // The label is only allocated once it is set
+    if (entry->label_len > 0)
+    {
+        memcpy(info->label, entry->label, entry->label_len);
+    }
+    info->label[entry->label_len] = '\0';
+    return true;
+}
+
+bool rdm_client_set_sub_device_start_address(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
+                                             uint16_t start_address)
+{
+    if (dmx_num >= DMX_NUM_MAX)
+    {
+        ESP_LOGE("rdm_client", "dmx_num too large");
+        return false;
+    }
+    rdm_client_sub_device_t *entry = rdm_client_find_sub_device(dmx_num, sub_device);
+    if (entry == NULL || entry->footprint == 0 || start_address < 1 || start_address > 512)
+    {
+        ESP_LOGE("rdm_client", "invalid sub_device or start_address");
+        return false;
+    }
+    entry->start_address = start_address;
+    rdm_queue_post(dmx_num, sub_device, RDM_PID_DMX_START_ADDRESS);
+    return true;
+}
+
+bool rdm_client_set_pid_sub_device_support(dmx_port_t dmx_num, rdm_pid_t pid, bool supported)
+{
+    if (dmx_num >= DMX_NUM_MAX)
+    {
+        ESP_LOGE("rdm_client", "dmx_num too large");
+        return false;
+    }
+    rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    const int index = rdm_client_find_pid(client_params, pid, NULL);
+    if (index < 0)
+    {
+        ESP_LOGE("rdm_client", "PID 0x%04x is not registered", pid);
+        return false;
+    }
+    client_params->pids[index].supports_sub_devices = supported;
+    return true;
+}
+
 char RDM_manufacturerlabel[32];
 
 void RDM_setManufacturerLabel(char *manlabel){
     strcpy(RDM_manufacturerlabel,manlabel);
+    for (int i = 0; i < DMX_NUM_MAX; ++i)
+    {
+        rdm_client_invalidate_responses(i);
+    }
 }
 
 char RDM_swversion[32];
 
 void RDM_setSWVersion(char *ver){
     strcpy(RDM_swversion,ver);
+    for (int i = 0; i < DMX_NUM_MAX; ++i)
+    {
+        rdm_client_invalidate_responses(i);
+    }
 }
 
 char RDM_devicemodedesc[32];
 
 void RDM_setDeviceModelDesc(char *desc){
     strcpy(RDM_devicemodedesc,desc);
+    for (int i = 0; i < DMX_NUM_MAX; ++i)
+    {
+        rdm_client_invalidate_responses(i);
+    }
 }
 
 uint16_t RDM_ManUUID;
@@ -210,357 +725,1189 @@ void RDM_setManUUID(uint16_t manUUID){
 }
 
 
-void rdm_client_handle_discovery_command(dmx_port_t dmx_num, const rdm_header_t *header, const void *data, const uint16_t data_size)
+static bool rdm_client_uid_is_broadcast(rdm_uid_t uid)
+{
+    return (uint32_t)uid == 0xffffffff;
+}
+
+static void rdm_client_get_device_info(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                       rdm_client_response_t *response, void *context)
 {
-    if (header->pid == RDM_PID_DISC_UNIQUE_BRANCH)
+    if (header->sub_device != RDM_ROOT_DEVICE)
     {
-        // TODO ensure that data_size is large enough
-        const rdm_uid_t lowUid = buf_to_uid(data + 24);
-        const rdm_uid_t highUid = buf_to_uid(data + 30);
-        const rdm_uid_t ourUid = rdm_get_uid(dmx_num);
+        // Sub-devices share the root's versions and sub-device count
+        const rdm_client_sub_device_t *sub = rdm_client_find_sub_device(dmx_num, header->sub_device);
+        rdm_device_info_t device_info = rdm_parameters[dmx_num].device_info;
+        device_info.model_id = sub->model_id;
+        device_info.footprint = sub->footprint;
+        device_info.current_personality = 1;
+        device_info.personality_count = 1;
+        device_info.start_address = sub->footprint > 0 ? sub->start_address : -1;
+        device_info.sensor_count = 0;
+        response->pdl = rdm_codec_encode(rdm_pid_desc_find(RDM_PID_DEVICE_INFO)->data, response->pd,
+                                         &device_info, 1);
+        return;
+    }
+    response->pdl = rdm_codec_encode(rdm_pid_desc_find(RDM_PID_DEVICE_INFO)->data, response->pd,
+                                     &rdm_parameters[dmx_num].device_info, 1);
+}
 
-        if (!rdm_is_muted(dmx_num) && lowUid <= ourUid && ourUid <= highUid)
-        {
-            const size_t respSize = rdm_send_disc_response(dmx_num, 7, ourUid);
-            ESP_LOGI("RDM", "Sent discovery response. %d bytes", respSize);
-        }
+static void rdm_client_get_identify_device(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                           rdm_client_response_t *response, void *context)
+{
+    if (header->sub_device != RDM_ROOT_DEVICE)
+    {
+        response->pd[0] = rdm_client_find_sub_device(dmx_num, header->sub_device)->identify;
+    }
+    else
+    {
+        response->pd[0] = rdm_parameters[dmx_num].identify_device;
+    }
+    response->pdl = 1;
+}
+
+static void rdm_client_set_identify_device(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                           rdm_client_response_t *response, void *context)
+{
+    if (header->pdl != 1 || pd[0] > 1)
+    {
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = header->pdl != 1 ? RDM_NR_FORMAT_ERROR : RDM_NR_DATA_OUT_OF_RANGE;
+        return;
     }
-    else if (header->pid == RDM_PID_DISC_UN_MUTE)
+    if (header->sub_device != RDM_ROOT_DEVICE)
     {
-        ESP_LOGI("RDM", "Received UNMUTE");
-        rdm_set_muted(dmx_num, false);
-        // TODO add response for unmute
+        rdm_client_find_sub_device(dmx_num, header->sub_device)->identify = pd[0];
+        rdm_client_notify_sub_device(dmx_num, header->sub_device, RDM_PID_IDENTIFY_DEVICE);
+        return;
     }
-    else if (header->pid == RDM_PID_DISC_MUTE)
+    rdm_parameters[dmx_num].identify_device = pd[0];
+    ESP_LOGD("rdm_client", "Set identify: %d", rdm_parameters[dmx_num].identify_device);
+    if (rdm_client_parameters[dmx_num].identify_cb)
     {
-        ESP_LOGI("RDM", "Received MUTE");
-        rdm_set_muted(dmx_num, true);
+        rdm_client_parameters[dmx_num].identify_cb(rdm_parameters[dmx_num].identify_device);
+    }
+}
 
-        // TODO store muteParams in rdm_client_params
-        rdm_disc_mute_t muteParams;
-        muteParams.managed_proxy = false;
-        muteParams.sub_device = false;
-        muteParams.boot_loader = false;
-        muteParams.proxied_device = false;
-        muteParams.binding_uid = 0;
-        const size_t bytesSent = rdm_send_mute_response(dmx_num, header->source_uid, header->tn, &muteParams);
-        if (bytesSent == 0)
+static void rdm_client_get_device_label(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                        rdm_client_response_t *response, void *context)
+{
+    if (header->sub_device != RDM_ROOT_DEVICE)
+    {
+        const rdm_client_sub_device_t *sub = rdm_client_find_sub_device(dmx_num, header->sub_device);
+        if (sub->label != NULL)
         {
-            // TODO print error or something
+            memcpy(response->pd, sub->label, sub->label_len);
         }
+        response->pdl = sub->label_len;
+        return;
     }
+    const rdm_parameters_t *params = &rdm_parameters[dmx_num];
+    memcpy(response->pd, params->device_label, params->device_label_len);
+    response->pdl = params->device_label_len;
 }
 
-void rdm_client_handle_rdm_message(dmx_port_t dmx_num, const dmx_packet_t *dmxPacket, const void *data, const uint16_t size)
+static void rdm_client_set_device_label(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                        rdm_client_response_t *response, void *context)
 {
+    if (header->pdl > 32)
+    {
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = RDM_NR_FORMAT_ERROR;
+        return;
+    }
+    if (header->sub_device != RDM_ROOT_DEVICE)
+    {
+        // Sub-device labels are sized to their length
+        rdm_client_sub_device_t *sub = rdm_client_find_sub_device(dmx_num, header->sub_device);
+        char *label = header->pdl > 0 ? realloc(sub->label, header->pdl) : NULL;
+        if (header->pdl > 0 && label == NULL)
+        {
+            response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+            response->nack_reason = RDM_NR_HARDWARE_FAULT;
+            return;
+        }
+        if (label == NULL)
+        {
+            free(sub->label);
+        }
+        else
+        {
+            memcpy(label, pd, header->pdl);
+        }
+        sub->label = label;
+        sub->label_len = header->pdl;
+        rdm_client_notify_sub_device(dmx_num, header->sub_device, RDM_PID_DEVICE_LABEL);
+        return;
+    }
+    rdm_parameters_t *params = &rdm_parameters[dmx_num];
+    memset(params->device_label, 0, sizeof(params->device_label));
+    memcpy(params->device_label, pd, header->pdl);
+    params->device_label_len = header->pdl;
+    rdm_persist_mark_dirty(dmx_num, RDM_PERSIST_DEVICE_LABEL);
+    ESP_LOGD("rdm_client", "Set device label: %.*s", (int)params->device_label_len, params->device_label);
+    if (rdm_client_parameters[dmx_num].label_cb)
+    {
+        rdm_client_parameters[dmx_num].label_cb(params->device_label, params->device_label_len);
+    }
+}
+
+static void rdm_client_get_supported_parameter_list(dmx_port_t dmx_num, const rdm_header_t *header,
+                                                    const uint8_t *pd, rdm_client_response_t *response,
+                                                    void *context)
+{
+    rdm_pid_t pids[CONFIG_RDM_CLIENT_MAX_PIDS];
+    const size_t num_pids = rdm_client_list_supported_parameters(
+        dmx_num, pids, CONFIG_RDM_CLIENT_MAX_PIDS, header->sub_device != RDM_ROOT_DEVICE);
+    response->pdl = rdm_codec_encode(rdm_pid_desc_find(RDM_PID_SUPPORTED_PARAMETERS)->data, response->pd, pids,
+                                     num_pids);
+}
+
+static void rdm_client_get_dmx_start_address(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                             rdm_client_response_t *response, void *context)
+{
+    int start_address = rdm_parameters[dmx_num].device_info.start_address;
+    if (header->sub_device != RDM_ROOT_DEVICE)
+    {
+        start_address = rdm_client_find_sub_device(dmx_num, header->sub_device)->start_address;
+    }
+    response->pdl = rdm_codec_encode(rdm_pid_desc_find(RDM_PID_DMX_START_ADDRESS)->data, response->pd,
+                                     &start_address, 1);
+}
+
+static void rdm_client_set_dmx_start_address(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                             rdm_client_response_t *response, void *context)
+{
+    int start_address;
+    if (header->pdl != 2)
+    {
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = RDM_NR_FORMAT_ERROR;
+        return;
+    }
+    rdm_codec_decode(rdm_pid_desc_find(RDM_PID_DMX_START_ADDRESS)->data, pd, &start_address, 1, header->pdl);
+    if (start_address < 1 || start_address > 512)
+    {
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = RDM_NR_DATA_OUT_OF_RANGE;
+        return;
+    }
+    if (header->sub_device != RDM_ROOT_DEVICE)
+    {
+        rdm_client_sub_device_t *sub = rdm_client_find_sub_device(dmx_num, header->sub_device);
+        if (sub->footprint == 0)
+        {
+            response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+            response->nack_reason = RDM_NR_DATA_OUT_OF_RANGE;
+            return;
+        }
+        sub->start_address = start_address;
+        rdm_client_notify_sub_device(dmx_num, header->sub_device, RDM_PID_DMX_START_ADDRESS);
+        return;
+    }
+    rdm_parameters_t *params = &rdm_parameters[dmx_num];
+    params->device_info.start_address = start_address;
+    rdm_client_invalidate_responses(dmx_num);
+    rdm_persist_mark_dirty(dmx_num, RDM_PERSIST_START_ADDRESS);
+    ESP_LOGD("rdm_client", "Set start address: %d", params->device_info.start_address);
+    if (rdm_client_parameters[dmx_num].address_cb)
+    {
+        rdm_client_parameters[dmx_num].address_cb(params->device_info.start_address);
+    }
+}
+
+static void rdm_client_get_dmx_personality(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                           rdm_client_response_t *response, void *context)
+{
+    const rdm_parameters_t *params = &rdm_parameters[dmx_num];
+    response->pd[0] = params->device_info.current_personality;
+    response->pd[1] = params->device_info.personality_count;
+    response->pdl = 2;
+}
+
+static void rdm_client_set_dmx_personality(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                           rdm_client_response_t *response, void *context)
+{
+    if (header->pdl != 1)
+    {
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = RDM_NR_FORMAT_ERROR;
+        return;
+    }
+    if (pd[0] == 0 || !rdm_client_select_personality(dmx_num, pd[0]))
+    {
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = RDM_NR_DATA_OUT_OF_RANGE;
+        return;
+    }
+    const rdm_parameters_t *params = &rdm_parameters[dmx_num];
+    if (rdm_client_parameters[dmx_num].personality_cb != NULL)
+    {
+        rdm_client_parameters[dmx_num].personality_cb(params->device_info.current_personality);
+    }
+    ESP_LOGD("rdm_client", "Set personality: %d", (int)params->device_info.current_personality);
+}
+
+static void rdm_client_get_dmx_personality_description(dmx_port_t dmx_num, const rdm_header_t *header,
+                                                       const uint8_t *pd, rdm_client_response_t *response,
+                                                       void *context)
+{
+    if (header->pdl != 1)
+    {
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = RDM_NR_FORMAT_ERROR;
+        return;
+    }
+    const uint8_t requestedPersonality = pd[0];
+    const rdm_parameters_t *params = &rdm_parameters[dmx_num];
+    if (requestedPersonality == 0 || requestedPersonality > params->device_info.personality_count)
+    {
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = RDM_NR_DATA_OUT_OF_RANGE;
+        return;
+    }
+
+    const rdm_client_personality_t *personality =
+        &rdm_client_parameters[dmx_num].personalities[requestedPersonality - 1];
+    const size_t description_len = strnlen(personality->description, MAX_PERSONALITY_DESCRIPTION_LEN);
+    response->pd[0] = requestedPersonality;
+    response->pd[1] = personality->footprint >> 8;
+    response->pd[2] = personality->footprint;
+    memcpy(&response->pd[3], personality->description, description_len);
+    response->pdl = 3 + description_len;
+}
+
+static void rdm_client_get_label(const char *label, rdm_client_response_t *response)
+{
+    response->pdl = strnlen(label, 32);
+    memcpy(response->pd, label, response->pdl);
+}
+
+static void rdm_client_get_manufacturer_label(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                              rdm_client_response_t *response, void *context)
+{
+    rdm_client_get_label(RDM_manufacturerlabel, response);
+}
+
+static void rdm_client_get_software_version_label(dmx_port_t dmx_num, const rdm_header_t *header,
+                                                  const uint8_t *pd, rdm_client_response_t *response,
+                                                  void *context)
+{
+    rdm_client_get_label(RDM_swversion, response);
+}
+
+static void rdm_client_get_device_model_description(dmx_port_t dmx_num, const rdm_header_t *header,
+                                                    const uint8_t *pd, rdm_client_response_t *response,
+                                                    void *context)
+{
+    rdm_client_get_label(RDM_devicemodedesc, response);
+}
+
+static bool rdm_client_check_sensor_request(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                            rdm_client_response_t *response, bool allow_all)
+{
+    if (header->pdl != 1)
+    {
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = RDM_NR_FORMAT_ERROR;
+        return false;
+    }
+    if (pd[0] >= rdm_sensor_count(dmx_num) && !(allow_all && pd[0] == RDM_SENSOR_ALL))
+    {
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = RDM_NR_DATA_OUT_OF_RANGE;
+        return false;
+    }
+    return true;
+}
+
+static void rdm_client_get_sensor_definition(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                             rdm_client_response_t *response, void *context)
+{
+    if (rdm_client_check_sensor_request(dmx_num, header, pd, response, false))
+    {
+        response->pdl = rdm_codec_encode(rdm_pid_desc_find(RDM_PID_SENSOR_DEFINITION)->data, response->pd,
+                                         rdm_sensor_get_definition(dmx_num, pd[0]), 1);
+    }
+}
+
+static void rdm_client_get_sensor_value(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                        rdm_client_response_t *response, void *context)
+{
+    // The parameter data is stored in wire format so it is copied directly
+    if (rdm_client_check_sensor_request(dmx_num, header, pd, response, false))
+    {
+        response->pdl = rdm_sensor_read_pd(dmx_num, pd[0], response->pd);
+    }
+}
+
+static void rdm_client_set_sensor_value(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                        rdm_client_response_t *response, void *context)
+{
+    if (!rdm_client_check_sensor_request(dmx_num, header, pd, response, true))
+    {
+        return;
+    }
+    rdm_sensor_reset(dmx_num, pd[0]);
+    if (pd[0] == RDM_SENSOR_ALL)
+    {
+        // Resetting all sensors is acknowledged with zeroed values
+        memset(response->pd, 0, RDM_SENSOR_VALUE_PDL);
+        response->pd[0] = RDM_SENSOR_ALL;
+        response->pdl = RDM_SENSOR_VALUE_PDL;
+    }
+    else
+    {
+        response->pdl = rdm_sensor_read_pd(dmx_num, pd[0], response->pd);
+    }
+}
+
+static void rdm_client_set_record_sensors(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                          rdm_client_response_t *response, void *context)
+{
+    if (rdm_client_check_sensor_request(dmx_num, header, pd, response, true) && !rdm_sensor_record(dmx_num, pd[0]))
+    {
+        // The sensor does not support recorded values
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = RDM_NR_DATA_OUT_OF_RANGE;
+    }
+}
+
+static void rdm_client_disc_unique_branch(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                          rdm_client_response_t *response, void *context)
+{
+    // Discovery responses are sent without an RDM header
+    response->type = RDM_RESPONSE_TYPE_NONE;
+    if (header->pdl != 12 || rdm_disc_fast_path_is_enabled(dmx_num))
+    {
+        return;
+    }
+    const rdm_uid_t lowUid = buf_to_uid(pd);
+    const rdm_uid_t highUid = buf_to_uid(pd + 6);
+    const rdm_uid_t ourUid = rdm_get_uid(dmx_num);
+
+    // Virtual responders in range respond at the same time as the port
+    rdm_uid_t uids[RDM_CLIENT_MAX_DISC_COLLISION];
+    size_t num_uids = 0;
+    if (!rdm_is_muted(dmx_num) && lowUid <= ourUid && ourUid <= highUid)
+    {
+        uids[num_uids++] = ourUid;
+    }
+    num_uids += rdm_virtual_find_disc_matches(dmx_num, lowUid, highUid, &uids[num_uids],
+                                              RDM_CLIENT_MAX_DISC_COLLISION - num_uids);
+    if (num_uids > RDM_CLIENT_MAX_DISC_COLLISION)
+    {
+        num_uids = RDM_CLIENT_MAX_DISC_COLLISION;
+    }
+    if (num_uids > 0)
+    {
+        const size_t respSize = rdm_send_disc_responses(dmx_num, 7, uids, num_uids);
+        ESP_LOGV("rdm_client", "Sent discovery response for %d UIDs. %u bytes", (int)num_uids, (unsigned)respSize);
+    }
+}
+
+static void rdm_client_disc_mute(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                 rdm_client_response_t *response, void *context)
+{
+    const bool mute = header->pid == RDM_PID_DISC_MUTE;
+    ESP_LOGV("rdm_client", "Received %s", mute ? "MUTE" : "UNMUTE");
+    rdm_set_muted(dmx_num, mute);
+
+    // TODO store muteParams in rdm_client_params
+    rdm_disc_mute_t muteParams;
+    muteParams.managed_proxy = false;
+    muteParams.sub_device = false;
+    muteParams.boot_loader = false;
+    muteParams.proxied_device = false;
+    muteParams.binding_uid = 0;
+    response->pdl = rdm_encode_mute(response->pd, &muteParams);
+}
+
+static int rdm_client_find_pid(const rdm_client_parameters_t *client_params, rdm_pid_t pid, size_t *insert_at)
+{
+    // Binary search the sorted handler table
+    size_t lo = 0;
+    size_t hi = client_params->num_pids;
+    while (lo < hi)
+    {
+        const size_t mid = (lo + hi) / 2;
+        const rdm_pid_t mid_pid = client_params->pids[mid].pid;
+        if (mid_pid == pid)
+        {
+            return mid;
+        }
+        else if (mid_pid < pid)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    if (insert_at != NULL)
+    {
+        *insert_at = lo;
+    }
+    return -1;
+}
+
+static bool rdm_client_register_handlers(dmx_port_t dmx_num, rdm_pid_t pid, rdm_pid_handler_t disc_handler,
+                                         rdm_pid_handler_t get_handler, rdm_pid_handler_t set_handler, void *context)
+{
+    rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    size_t insert_at;
+    int index = rdm_client_find_pid(client_params, pid, &insert_at);
+    if (index < 0)
+    {
+        if (client_params->num_pids >= CONFIG_RDM_CLIENT_MAX_PIDS)
+        {
+            ESP_LOGE("rdm_client", "max num PIDs reached");
+            return false;
+        }
+        memmove(&client_params->pids[insert_at + 1], &client_params->pids[insert_at],
+                (client_params->num_pids - insert_at) * sizeof(client_params->pids[0]));
+        ++client_params->num_pids;
+        index = insert_at;
+    }
+
+    rdm_client_pid_entry_t *entry = &client_params->pids[index];
+    entry->pid = pid;
+    entry->handlers[RDM_CLIENT_HANDLER_DISC] = disc_handler;
+    entry->handlers[RDM_CLIENT_HANDLER_GET] = get_handler;
+    entry->handlers[RDM_CLIENT_HANDLER_SET] = set_handler;
+    entry->context = context;
+    entry->is_cacheable = false;
+    entry->supports_sub_devices = false;
+    rdm_client_invalidate_responses(dmx_num);
+    return true;
+}
+
+bool rdm_client_register_pid(dmx_port_t dmx_num, rdm_pid_t pid, rdm_pid_handler_t get_handler,
+                             rdm_pid_handler_t set_handler, void *context)
+{
+    if (dmx_num >= DMX_NUM_MAX)
+    {
+        ESP_LOGE("rdm_client", "dmx_num too large");
+        return false;
+    }
+    if (pid >= RDM_PID_DISC_UNIQUE_BRANCH && pid <= RDM_PID_DISC_UN_MUTE)
+    {
+        ESP_LOGE("rdm_client", "discovery PIDs cannot be registered");
+        return false;
+    }
+
+    rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    if (get_handler == NULL && set_handler == NULL)
+    {
+        // Remove the PID from the table
+        const int index = rdm_client_find_pid(client_params, pid, NULL);
+        if (index >= 0)
+        {
+            memmove(&client_params->pids[index], &client_params->pids[index + 1],
+                    (client_params->num_pids - index - 1) * sizeof(client_params->pids[0]));
+            --client_params->num_pids;
+            rdm_client_invalidate_responses(dmx_num);
+        }
+        return true;
+    }
+
+    return rdm_client_register_handlers(dmx_num, pid, NULL, get_handler, set_handler, context);
+}
+
+size_t rdm_client_get_supported_parameters(dmx_port_t dmx_num, rdm_pid_t *pids, size_t size)
+{
+    if (dmx_num >= DMX_NUM_MAX)
+    {
+        ESP_LOGE("rdm_client", "dmx_num too large");
+        return 0;
+    }
+    return rdm_client_list_supported_parameters(dmx_num, pids, size, false);
+}
+
+// Lists the supported PIDs of the root device, or of sub-devices if is_sub_device is true.
+static size_t rdm_client_list_supported_parameters(dmx_port_t dmx_num, rdm_pid_t *pids, size_t size,
+                                                   bool is_sub_device)
+{
+    // PIDs which every responder must support are not reported
+    const rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    size_t num_pids = 0;
+    for (size_t i = 0; i < client_params->num_pids; ++i)
+    {
+        const rdm_client_pid_entry_t *entry = &client_params->pids[i];
+        if (is_sub_device && !entry->supports_sub_devices)
+        {
+            continue;
+        }
+        switch (entry->pid)
+        {
+        case RDM_PID_SUPPORTED_PARAMETERS:
+        case RDM_PID_DEVICE_INFO:
+        case RDM_PID_SOFTWARE_VERSION_LABEL:
+        case RDM_PID_DMX_START_ADDRESS:
+        case RDM_PID_IDENTIFY_DEVICE:
+            continue;
+        default:
+            break;
+        }
+        if (entry->handlers[RDM_CLIENT_HANDLER_GET] == NULL && entry->handlers[RDM_CLIENT_HANDLER_SET] == NULL)
+        {
+            continue;
+        }
+        if (num_pids < size)
+        {
+            pids[num_pids] = entry->pid;
+        }
+        ++num_pids;
+    }
+    return num_pids;
+}
+
+// Returns the status messages of a status type and remembers them for RDM_STATUS_GET_LAST_MESSAGE.
+static void rdm_client_collect_status_messages(dmx_port_t dmx_num, rdm_status_t status_type,
+                                               rdm_client_response_t *response)
+{
+    rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    if (status_type != RDM_STATUS_GET_LAST_MESSAGE)
+    {
+        rdm_status_message_t messages[RDM_QUEUE_MAX_STATUS_MESSAGES];
+        const size_t num_messages = status_type == RDM_STATUS_NONE
+                                        ? 0
+                                        : rdm_queue_pop_status(dmx_num, status_type, messages,
+                                                               RDM_QUEUE_MAX_STATUS_MESSAGES);
+        uint8_t *data = client_params->last_status_pd;
+        for (size_t i = 0; i < num_messages; ++i)
+        {
+            const rdm_status_message_t *message = &messages[i];
+            data[0] = message->sub_device >> 8;
+            data[1] = message->sub_device;
+            data[2] = message->status_type;
+            data[3] = message->message_id >> 8;
+            data[4] = message->message_id;
+            data[5] = (uint16_t)message->data1 >> 8;
+            data[6] = message->data1;
+            data[7] = (uint16_t)message->data2 >> 8;
+            data[8] = message->data2;
+            data += 9;
+        }
+        client_params->last_status_pdl = num_messages * 9;
+    }
+    memcpy(response->pd, client_params->last_status_pd, client_params->last_status_pdl);
+    response->pdl = client_params->last_status_pdl;
+}
+
+static bool rdm_client_check_status_request(const rdm_header_t *header, const uint8_t *pd,
+                                            rdm_client_response_t *response)
+{
+    if (header->pdl != 1)
+    {
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = RDM_NR_FORMAT_ERROR;
+        return false;
+    }
+    if (pd[0] > RDM_STATUS_ERROR)
+    {
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = RDM_NR_DATA_OUT_OF_RANGE;
+        return false;
+    }
+    return true;
+}
+
+static void rdm_client_get_status_messages(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                           rdm_client_response_t *response, void *context)
+{
+    if (rdm_client_check_status_request(header, pd, response))
+    {
+        rdm_client_collect_status_messages(dmx_num, pd[0], response);
+    }
+}
+
+static void rdm_client_get_queued_message(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                          rdm_client_response_t *response, void *context)
+{
+    if (!rdm_client_check_status_request(header, pd, response))
+    {
+        return;
+    }
+
+    // Take the next queued message, or fall back to the status messages
+    rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    const rdm_status_t status_type = pd[0];
+    rdm_queued_message_t message;
+    if (status_type == RDM_STATUS_GET_LAST_MESSAGE)
+    {
+        message = client_params->last_message;
+    }
+    else if (!rdm_queue_pop(dmx_num, &message))
+    {
+        message.sub_device = RDM_ROOT_DEVICE;
+        message.pid = RDM_PID_STATUS_MESSAGE;
+    }
+    client_params->last_message = message;
+
+    if (message.pid == RDM_PID_STATUS_MESSAGE || message.pid == 0)
+    {
+        response->pid = RDM_PID_STATUS_MESSAGE;
+        response->sub_device = RDM_ROOT_DEVICE;
+        rdm_client_collect_status_messages(dmx_num, status_type, response);
+        return;
+    }
+
+    // Reply with the GET response of the queued PID
+    response->pid = message.pid;
+    response->sub_device = message.sub_device;
+    const int index = rdm_client_find_pid(client_params, message.pid, NULL);
+    if (index < 0 || client_params->pids[index].handlers[RDM_CLIENT_HANDLER_GET] == NULL)
+    {
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = RDM_NR_UNKNOWN_PID;
+        return;
+    }
+    if (message.sub_device != RDM_ROOT_DEVICE && (rdm_client_find_sub_device(dmx_num, message.sub_device) == NULL ||
+                                                  !client_params->pids[index].supports_sub_devices))
+    {
+        // The sub-device was removed after the message was posted
+        response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response->nack_reason = RDM_NR_SUB_DEVICE_OUT_OF_RANGE;
+        return;
+    }
+    rdm_header_t queued = *header;
+    queued.pid = message.pid;
+    queued.sub_device = message.sub_device;
+    queued.pdl = 0;
+    const rdm_client_pid_entry_t *entry = &client_params->pids[index];
+    entry->handlers[RDM_CLIENT_HANDLER_GET](dmx_num, &queued, pd, response, entry->context);
+}
+
+static void rdm_client_register_default_pids(dmx_port_t dmx_num)
+{
+    rdm_client_parameters[dmx_num].num_pids = 0;
+    rdm_client_register_handlers(dmx_num, RDM_PID_DISC_UNIQUE_BRANCH, rdm_client_disc_unique_branch, NULL, NULL,
+                                 NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_DISC_MUTE, rdm_client_disc_mute, NULL, NULL, NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_DISC_UN_MUTE, rdm_client_disc_mute, NULL, NULL, NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_QUEUED_MESSAGE, NULL, rdm_client_get_queued_message, NULL, NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_STATUS_MESSAGE, NULL, rdm_client_get_status_messages, NULL,
+                                 NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_SUPPORTED_PARAMETERS, NULL,
+                                 rdm_client_get_supported_parameter_list, NULL, NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_DEVICE_INFO, NULL, rdm_client_get_device_info, NULL, NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_DEVICE_MODEL_DESCRIPTION, NULL,
+                                 rdm_client_get_device_model_description, NULL, NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_MANUFACTURER_LABEL, NULL, rdm_client_get_manufacturer_label,
+                                 NULL, NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_DEVICE_LABEL, NULL, rdm_client_get_device_label,
+                                 rdm_client_set_device_label, NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_SOFTWARE_VERSION_LABEL, NULL,
+                                 rdm_client_get_software_version_label, NULL, NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_DMX_PERSONALITY, NULL, rdm_client_get_dmx_personality,
+                                 rdm_client_set_dmx_personality, NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_DMX_PERSONALITY_DESCRIPTION, NULL,
+                                 rdm_client_get_dmx_personality_description, NULL, NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_DMX_START_ADDRESS, NULL, rdm_client_get_dmx_start_address,
+                                 rdm_client_set_dmx_start_address, NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_SENSOR_DEFINITION, NULL, rdm_client_get_sensor_definition, NULL,
+                                 NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_SENSOR_VALUE, NULL, rdm_client_get_sensor_value,
+                                 rdm_client_set_sensor_value, NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_RECORD_SENSORS, NULL, NULL, rdm_client_set_record_sensors, NULL);
+    rdm_client_register_handlers(dmx_num, RDM_PID_IDENTIFY_DEVICE, NULL, rdm_client_get_identify_device,
+                                 rdm_client_set_identify_device, NULL);
+
+    rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    for (size_t i = 0; i < sizeof(rdm_client_cacheable_pids) / sizeof(rdm_client_cacheable_pids[0]); ++i)
+    {
+        const int index = rdm_client_find_pid(client_params, rdm_client_cacheable_pids[i], NULL);
+        if (index >= 0)
+        {
+            client_params->pids[index].is_cacheable = true;
+        }
+    }
+    for (size_t i = 0; i < sizeof(rdm_client_sub_device_pids) / sizeof(rdm_client_sub_device_pids[0]); ++i)
+    {
+        const int index = rdm_client_find_pid(client_params, rdm_client_sub_device_pids[i], NULL);
+        if (index >= 0)
+        {
+            client_params->pids[index].supports_sub_devices = true;
+        }
+    }
+}
+
+static void rdm_client_free_personalities(dmx_port_t dmx_num)
+{
+    rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    if (client_params->personality_pool != NULL)
+    {
+        for (size_t i = 0; i < rdm_parameters[dmx_num].device_info.personality_count; ++i)
+        {
+            free((char *)client_params->personality_pool[i].description);
+        }
+        free(client_params->personality_pool);
+        client_params->personality_pool = NULL;
+    }
+    client_params->personalities = NULL;
+}
+
+// Invalidates the cached responses. Setters call this from application tasks
+// while the responder task may be encoding a response from the old state, so
+// the generation is bumped under the spinlock and a response is only stored
+// if the generation did not change while it was encoded.
+static void rdm_client_invalidate_responses(dmx_port_t dmx_num)
+{
+    rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    taskENTER_CRITICAL(&dmx_spinlock[dmx_num]);
+    ++client_params->response_generation;
+    if (client_params->responses != NULL)
+    {
+        for (int i = 0; i < CONFIG_RDM_CLIENT_RESPONSE_CACHE_SIZE; ++i)
+        {
+            client_params->responses[i].is_valid = false;
+        }
+    }
+    taskEXIT_CRITICAL(&dmx_spinlock[dmx_num]);
+}
+
+// Returns the generation of the cached responses, which must be read before a
+// response is encoded for rdm_client_store_response().
+static uint32_t rdm_client_get_response_generation(dmx_port_t dmx_num)
+{
+    taskENTER_CRITICAL(&dmx_spinlock[dmx_num]);
+    const uint32_t generation = rdm_client_parameters[dmx_num].response_generation;
+    taskEXIT_CRITICAL(&dmx_spinlock[dmx_num]);
+    return generation;
+}
+
+static const rdm_client_cached_response_t *rdm_client_find_response(dmx_port_t dmx_num, const rdm_header_t *header,
+                                                                    const uint8_t *pd)
+{
+    const rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    if (client_params->responses == NULL)
+    {
+        return NULL;
+    }
+    const rdm_uid_t uid = rdm_get_uid(dmx_num);
+    for (int i = 0; i < CONFIG_RDM_CLIENT_RESPONSE_CACHE_SIZE; ++i)
+    {
+        const rdm_client_cached_response_t *cached = &client_params->responses[i];
+        if (cached->is_valid && cached->pid == header->pid && cached->param_len == header->pdl &&
+            cached->source_uid == uid && memcmp(cached->param, pd, header->pdl) == 0)
+        {
+            return cached;
+        }
+    }
+    return NULL;
+}
+
+// Stores an encoded response. The response is not cached if the cache was
+// invalidated since generation was read, because it may encode the old state.
+static const rdm_client_cached_response_t *rdm_client_store_response(dmx_port_t dmx_num, const rdm_header_t *header,
+                                                                     const uint8_t *pd,
+                                                                     const rdm_client_response_t *response,
+                                                                     uint32_t generation)
+{
+    rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    if (client_params->responses == NULL)
+    {
+        return NULL;
+    }
+    rdm_client_cached_response_t *cached = &client_params->responses[client_params->next_response];
+    client_params->next_response = (client_params->next_response + 1) % CONFIG_RDM_CLIENT_RESPONSE_CACHE_SIZE;
+
+    cached->size = rdm_encode_response(dmx_num, cached->packet, header, response->type, response->pd,
+                                       response->pdl);
+    if (cached->size == 0)
+    {
+        cached->is_valid = false;
+        return NULL;
+    }
+    cached->pid = header->pid;
+    cached->param_len = header->pdl;
+    memcpy(cached->param, pd, header->pdl);
+    cached->source_uid = rdm_get_uid(dmx_num);
+    taskENTER_CRITICAL(&dmx_spinlock[dmx_num]);
+    cached->is_valid = generation == client_params->response_generation;
+    taskEXIT_CRITICAL(&dmx_spinlock[dmx_num]);
+    return cached;
+}
+
+// Applies a SET request to every sub-device in a single pass. The response is
+// the first NACK of any sub-device, and the sub-device callback is invoked once.
+static void rdm_client_set_all_sub_devices(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                           rdm_client_response_t *response, const rdm_client_pid_entry_t *entry)
+{
+    rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    rdm_header_t sub_header = *header;
+    client_params->is_all_call = true;
+    for (size_t i = 0; i < client_params->num_sub_devices; ++i)
+    {
+        rdm_client_response_t sub_response = {.type = RDM_RESPONSE_TYPE_ACK, .pid = header->pid, .pdl = 0};
+        sub_header.sub_device = client_params->sub_devices[i].number;
+        sub_response.sub_device = sub_header.sub_device;
+        entry->handlers[RDM_CLIENT_HANDLER_SET](dmx_num, &sub_header, pd, &sub_response, entry->context);
+        if (sub_response.type == RDM_RESPONSE_TYPE_NACK_REASON && response->type != RDM_RESPONSE_TYPE_NACK_REASON)
+        {
+            response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+            response->nack_reason = sub_response.nack_reason;
+        }
+    }
+    client_params->is_all_call = false;
+    if (client_params->sub_device_cb != NULL)
+    {
+        client_params->sub_device_cb(RDM_ALL_SUB_DEVICES, header->pid);
+    }
+}
+
+// Handles a request to a virtual responder and sends the response from its UID.
+static int rdm_client_dispatch_virtual(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd)
+{
+    rdm_client_response_t response = {
+        .type = RDM_RESPONSE_TYPE_ACK, .pid = header->pid, .sub_device = header->sub_device, .pdl = 0};
+    if (!rdm_virtual_handle_request(dmx_num, header, pd, &response) || response.type == RDM_RESPONSE_TYPE_NONE)
+    {
+        return -1;
+    }
+    if (response.type == RDM_RESPONSE_TYPE_NACK_REASON)
+    {
+        if (header->cc == RDM_CC_DISC_COMMAND)
+        {
+            return -1; // Discovery commands are never NACKed
+        }
+        const uint8_t nack_pd[2] = {response.nack_reason >> 8, response.nack_reason};
+        return rdm_send_response_as(dmx_num, header->destination_uid, header, RDM_RESPONSE_TYPE_NACK_REASON,
+                                    nack_pd, sizeof(nack_pd));
+    }
+    return rdm_send_response_as(dmx_num, header->destination_uid, header, response.type, response.pd,
+                                response.pdl);
+}
+
+// Handles an RDM request and sends the response. Returns the number of bytes
+// sent, which is 0 if the response could not be sent in time, or -1 if no
+// response was due.
+static int rdm_client_dispatch(dmx_port_t dmx_num, const void *data, const uint16_t size)
+{
+    // The checksum is read from after the message length in the third slot
+    const uint8_t *const slots = data;
     rdm_header_t header;
-    if (rdm_get_header(&header, data))
+    if (size < RDM_BASE_PACKET_SIZE || size < slots[2] + 2 || !rdm_get_header(&header, data))
     {
-        if (rdm_is_directed_at_us(dmx_num, &header))
+        return -1;
+    }
+    if (size < RDM_BASE_PACKET_SIZE + header.pdl || header.pdl > RDM_MAX_PDL)
+    {
+        ESP_LOGE("RDM", "header.pdl too large: %d", (int)header.pdl);
+        return -1;
+    }
+    if (!header.checksum_is_valid)
+    {
+        return -1; // Corrupted requests are ignored
+    }
+    const uint8_t *pd = (const uint8_t *)data + RDM_BASE_PACKET_SIZE - 2;
+
+    // Route requests to virtual responders, which also apply broadcasts
+    if (rdm_client_uid_is_broadcast(header.destination_uid))
+    {
+        rdm_virtual_handle_broadcast(dmx_num, &header, pd);
+    }
+    else if (header.destination_uid != rdm_get_uid(dmx_num))
+    {
+        return rdm_client_dispatch_virtual(dmx_num, &header, pd);
+    }
+    if (!rdm_is_directed_at_us(dmx_num, &header))
+    {
+        return -1;
+    }
+
+    // Map the command class to a handler slot
+    int slot;
+    if (header.cc == RDM_CC_DISC_COMMAND)
+    {
+        slot = RDM_CLIENT_HANDLER_DISC;
+    }
+    else if (header.cc == RDM_CC_GET_COMMAND)
+    {
+        slot = RDM_CLIENT_HANDLER_GET;
+    }
+    else if (header.cc == RDM_CC_SET_COMMAND)
+    {
+        slot = RDM_CLIENT_HANDLER_SET;
+    }
+    else
+    {
+        return -1;
+    }
+
+    // Look up and run the handler
+    const rdm_client_parameters_t *client_params = &rdm_client_parameters[dmx_num];
+    const int index = rdm_client_find_pid(client_params, header.pid, NULL);
+
+    // Reply to GET requests of static PIDs with a pre-encoded response
+    const bool is_cacheable = slot == RDM_CLIENT_HANDLER_GET && index >= 0 &&
+                              client_params->pids[index].is_cacheable && header.sub_device == RDM_ROOT_DEVICE &&
+                              header.pdl <= sizeof(((rdm_client_cached_response_t *)0)->param) &&
+                              !rdm_client_uid_is_broadcast(header.destination_uid);
+    const uint32_t generation = is_cacheable ? rdm_client_get_response_generation(dmx_num) : 0;
+    if (is_cacheable)
+    {
+        const rdm_client_cached_response_t *cached = rdm_client_find_response(dmx_num, &header, pd);
+        if (cached != NULL)
         {
-            if (header.cc == RDM_CC_DISC_COMMAND)
-            {
-                rdm_client_handle_discovery_command(dmx_num, &header, data, size);
-            }
-            else if (header.cc == RDM_CC_GET_COMMAND)
-            {
-                switch (header.pid)
-                {
-                case RDM_PID_DEVICE_INFO:
-                {
-                    uint8_t buffer[0x13]; // FIXME this is not good style
-                    const size_t pdl = rdm_encode_device_info_(&buffer, &rdm_parameters[dmx_num].device_info);
-                    if (pdl != 0x13)
-                    {
-                        ESP_LOGE("RDM DBG", "buffer overflow in rdm_encode_device_info_");
-                        return;
-                    }
-                    const size_t bytesSent = rdm_send_get_param_response(dmx_num, header.source_uid, header.tn,
-                                                                         RDM_PID_DEVICE_INFO, header.sub_device, buffer, pdl);
-                    ESP_LOGI("RDM DBG", "Sent DEVICE_INFO response. %d bytes", bytesSent);
-                }
-                break;
-                case RDM_PID_IDENTIFY_DEVICE:
-                {
-                    const rdm_parameters_t *params = &rdm_parameters[dmx_num];
-                    const size_t bytesSent = rdm_send_get_param_response(dmx_num, header.source_uid, header.tn,
-                                                                         RDM_PID_IDENTIFY_DEVICE, header.sub_device, &params->identify_device, 1);
+            return rdm_send_encoded_response(dmx_num, &header, cached->packet, cached->size);
+        }
+    }
 
-                    ESP_LOGI("RDM DBG", "Sent IDENTIFY_DEVICE response. %d bytes", bytesSent);
-                }
-                break;
-                case RDM_PID_DEVICE_LABEL:
-                {
-                    const rdm_parameters_t *params = &rdm_parameters[dmx_num];
-                    const size_t bytesSent = rdm_send_get_param_response(dmx_num, header.source_uid, header.tn,
-                                                                         RDM_PID_DEVICE_LABEL, header.sub_device, params->device_label, params->device_label_len);
-                    ESP_LOGI("RDM DBG", "Sent GET DEVICE_LABEL response. label: %s, %d bytes", params->device_label, bytesSent);
-                }
-                break;
-                case RDM_PID_SUPPORTED_PARAMETERS:
-                {
-                    const uint16_t supported_params[] = {bswap16(RDM_PID_DEVICE_LABEL), bswap16(RDM_PID_DMX_PERSONALITY), bswap16(RDM_PID_MANUFACTURER_LABEL),\
-                     bswap16(RDM_PID_SOFTWARE_VERSION_LABEL), bswap16(RDM_PID_DEVICE_MODEL_DESCRIPTION), bswap16(RDM_PID_SENSOR_VALUE),bswap16(RDM_PID_SENSOR_DEFINITION),\
-                     bswap16(RDM_PID_DMX_START_ADDRESS),bswap16(RDM_PID_DMX_PERSONALITY_DESCRIPTION)};
-                    const size_t bytesSent = rdm_send_get_param_response(dmx_num, header.source_uid, header.tn,
-                                                                         RDM_PID_SUPPORTED_PARAMETERS, header.sub_device, supported_params, sizeof(supported_params));
-                    ESP_LOGI("RDM DBG", "Sent GET RDM_PID_SUPPORTED_PARAMETERS response. %d bytes", bytesSent);
-                }
-                break;
-                case RDM_PID_DMX_START_ADDRESS:
-                {
-                    rdm_parameters_t *params = &rdm_parameters[dmx_num];
-                    const uint16_t addr = bswap16(params->device_info.start_address);
-                    const size_t bytesSent = rdm_send_get_param_response(dmx_num, header.source_uid, header.tn,
-                                                                         RDM_PID_DMX_START_ADDRESS, header.sub_device, &addr, sizeof(addr));
-                    ESP_LOGI("RDM DBG", "Sent GET RDM_PID_DMX_START_ADDRESS response. %d bytes", bytesSent);
-                }
-                break;
-                case RDM_PID_DMX_PERSONALITY:
-                {
-                    rdm_parameters_t *params = &rdm_parameters[dmx_num];
-                    const uint8_t data[] = {params->device_info.current_personality, params->device_info.personality_count};
-                    const size_t bytesSent = rdm_send_get_param_response(dmx_num, header.source_uid, header.tn,
-                                                                         RDM_PID_DMX_PERSONALITY, header.sub_device, data, sizeof(data));
-                    ESP_LOGI("RDM DBG", "Sent GET RDM_PID_DMX_PERSONALITY response. %d bytes", bytesSent);
-                }
-                break;
-                case RDM_PID_DMX_PERSONALITY_DESCRIPTION:
-                {
-                    const uint8_t requestedPersonality = ((uint8_t *)data)[24]; // FIXME find better way to get the address
-                    const uint8_t personalityIdx = requestedPersonality - 1;
-                    rdm_parameters_t *params = &rdm_parameters[dmx_num];
-                    if(personalityIdx >= params->device_info.personality_count)
-                    {
-                        ESP_LOGE("rdm_client", "illegal personality");
-                    }
-
-                    rdm_client_parameters_t* client_params = &rdm_client_parameters[dmx_num];
-                    const uint16_t footprint = client_params->personalities[personalityIdx].footprint;
-                    const uint16_t footprintSwapped = bswap16(footprint);
-                    const char* description = client_params->personalities[personalityIdx].description;
-                    const size_t descriptionLen = client_params->personalities[personalityIdx].description_len;
-
-                    uint8_t data[35];
-                    data[0] = requestedPersonality;
-                    memcpy(&data[1], &footprintSwapped, 2);
-                    memcpy(&data[3], description, descriptionLen);
-
-                    rdm_send_get_param_response(dmx_num, header.source_uid, header.tn,
-                                                                         RDM_PID_DMX_PERSONALITY_DESCRIPTION, header.sub_device, data, 3 + descriptionLen);
-
-                    ESP_LOGI("RDM DBG", "Sent Get RDM_PID_DMX_PERSONALITY_DESCRIPTION response. personality: %d, footprint: %d, description: %s ", requestedPersonality, footprint, description);
-                }
-                break;
-                case RDM_PID_MANUFACTURER_LABEL:
-                {
-                     const rdm_parameters_t *params = &rdm_parameters[dmx_num];
-                    const size_t bytesSent = rdm_send_get_param_response(dmx_num, header.source_uid, header.tn,
-                                                                         RDM_PID_MANUFACTURER_LABEL, header.sub_device, RDM_manufacturerlabel, strlen(RDM_manufacturerlabel));
-                    ESP_LOGI("RDM DBG", "Sent GET DEVICE_LABEL response. label: %s, %d bytes", params->device_label, bytesSent);
-                }
-                break;
-                case RDM_PID_SOFTWARE_VERSION_LABEL:
-                {
-                     const rdm_parameters_t *params = &rdm_parameters[dmx_num];
-                    const size_t bytesSent = rdm_send_get_param_response(dmx_num, header.source_uid, header.tn,
-                                                                         RDM_PID_SOFTWARE_VERSION_LABEL, header.sub_device, RDM_swversion, strlen(RDM_swversion));
-                    ESP_LOGI("RDM DBG", "Sent GET DEVICE_LABEL response. label: %s, %d bytes", params->device_label, bytesSent);
-                }
-                break;
-                case RDM_PID_DEVICE_MODEL_DESCRIPTION:
-                {
-                    const rdm_parameters_t *params = &rdm_parameters[dmx_num];
-                    const size_t bytesSent = rdm_send_get_param_response(dmx_num, header.source_uid, header.tn,
-                                                                         RDM_PID_DEVICE_MODEL_DESCRIPTION, header.sub_device, RDM_devicemodedesc,strlen(RDM_devicemodedesc));
-                    ESP_LOGI("RDM DBG", "Sent GET DEVICE_LABEL response. label: %s, %d bytes", params->device_label, bytesSent);
-                }
-                break;
-
-                case RDM_PID_SENSOR_DEFINITION:{
-                    const rdm_parameters_t *params = &rdm_parameters[dmx_num];
-
-
-                   /* typedef struct __attribute__ ((packed)) sensorDef_t {
-                        uint8_t sensorNum;
-                        uint8_t sensorType;
-                        uint8_t sensorUnit;
-                        uint8_t sensorPrefix;
-                        int16_t range_min;
-                        int16_t range_max;
-                        int16_t normal_min;
-                        int16_t normal_max;
-                        uint8_t sensorHistory;
-                        char sensorDesc[32];
-                    } sensorDef_t;*/
-
-                    rdm_header_t header2;
-                    uint8_t *pd;
-                    rdm_get_pd(data,&header2,&pd);
-
-                    /*
-                    sensorDef_t tempSensor = {.sensorNum=0,
-                                              .sensorType=SENS_TEMPERATURE,
-                                              .sensorUnit=UNITS_CENTIGRADE,
-                                              .range_min=bswap16(-40),
-                                              .range_max=bswap16(125),
-                                              .normal_min=bswap16(-20),
-                                              .normal_max=bswap16(100),
-                                              .sensorHistory=NOHISTORY,
-                                              .sensorDesc="Temp"};
-                    */
-                    
-                    sensorDef_t tempSensorDef;
-                    memcpy(&tempSensorDef,getSensorDef(*pd),sizeof(sensorDef_t));
-                    tempSensorDef.range_min = bswap16(tempSensorDef.range_min);
-                    tempSensorDef.range_max = bswap16(tempSensorDef.range_max);
-                    tempSensorDef.normal_min = bswap16(tempSensorDef.normal_min);
-                    tempSensorDef.normal_max = bswap16(tempSensorDef.normal_max);
-
-                    const size_t bytesSent = rdm_send_get_param_response(dmx_num, header.source_uid, header.tn,
-                                                                         RDM_PID_SENSOR_DEFINITION, header.sub_device, &tempSensorDef, sizeof(tempSensorDef));
-                    ESP_LOGI("RDM DBG", "Sent GET DEVICE_LABEL response. label: %s, %d bytes", params->device_label, bytesSent);
-                }
-                break;
+    rdm_client_response_t response = {
+        .type = RDM_RESPONSE_TYPE_ACK, .pid = header.pid, .sub_device = header.sub_device, .pdl = 0};
+    if (header.sub_device != RDM_ROOT_DEVICE && slot == RDM_CLIENT_HANDLER_DISC)
+    {
+        return -1; // Discovery is only addressed to the root device
+    }
+    else if (header.sub_device != RDM_ROOT_DEVICE &&
+             (header.sub_device == RDM_ALL_SUB_DEVICES
+                  ? slot != RDM_CLIENT_HANDLER_SET || client_params->num_sub_devices == 0
+                  : rdm_client_find_sub_device(dmx_num, header.sub_device) == NULL))
+    {
+        response.type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response.nack_reason = RDM_NR_SUB_DEVICE_OUT_OF_RANGE;
+    }
+    else if (header.sub_device != RDM_ROOT_DEVICE && (index < 0 || !client_params->pids[index].supports_sub_devices))
+    {
+        response.type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response.nack_reason = RDM_NR_UNKNOWN_PID;
+    }
+    else if (index < 0)
+    {
+        ESP_LOGD("rdm_client", "unknown pid: %04x", header.pid);
+        response.type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response.nack_reason = RDM_NR_UNKNOWN_PID;
+    }
+    else if (client_params->pids[index].handlers[slot] == NULL)
+    {
+        response.type = RDM_RESPONSE_TYPE_NACK_REASON;
+        response.nack_reason = RDM_NR_UNSUPPORTED_COMMAND_CLASS;
+    }
+    else if (header.sub_device == RDM_ALL_SUB_DEVICES)
+    {
+        rdm_client_set_all_sub_devices(dmx_num, &header, pd, &response, &client_params->pids[index]);
+    }
+    else
+    {
+        const rdm_client_pid_entry_t *entry = &client_params->pids[index];
+        entry->handlers[slot](dmx_num, &header, pd, &response, entry->context);
+    }
 
-                case RDM_PID_SENSOR_VALUE:
-                {
-                    const rdm_parameters_t *params = &rdm_parameters[dmx_num];
-                  /*  typedef struct __attribute__ ((packed)) sensorData_t {
-                        uint8_t sensorNum;
-                        int16_t sensorVal;
-                        int16_t minVal;
-                        int16_t maxVal;
-                        int16_t recVal;
-                    } sensorData_t;*/
-                    rdm_header_t header2;
-                    uint8_t *pd;
-                    rdm_get_pd(data,&header2,&pd);
-
-                    sensorData_t tempSensorData;
-                    memcpy(&tempSensorData,getSensorData(*pd),sizeof(sensorData_t));
-                    tempSensorData.sensorVal = bswap16(tempSensorData.sensorVal);
-                    tempSensorData.minVal = bswap16(tempSensorData.minVal);
-                    tempSensorData.maxVal = bswap16(tempSensorData.maxVal);
-                    tempSensorData.recVal = bswap16(tempSensorData.recVal);
-
-                    
-
-                    
-                    const size_t bytesSent = rdm_send_get_param_response(dmx_num, header.source_uid, header.tn,
-                                                                         RDM_PID_SENSOR_VALUE, header.sub_device, &tempSensorData, 9);
-                    ESP_LOGI("RDM DBG", "Sent GET RDM_PID_SENSOR_VALUE response. label: %s, %d bytes", params->device_label, bytesSent);
-                }
-                break;
+    // Responders never respond to broadcast requests
+    if (rdm_client_uid_is_broadcast(header.destination_uid) || response.type == RDM_RESPONSE_TYPE_NONE)
+    {
+        return -1;
+    }
 
-                default:
-                    ESP_LOGI("RDM DBG", "RDM_CC_GET_COMMAND unknown get pid: %04x", header.pid);
-                    ESP_LOG_BUFFER_HEX("RDM", data, size);
-                }
-            }
-            else if (header.cc == RDM_CC_SET_COMMAND)
-            {
-                switch (header.pid)
-                {
-                case RDM_PID_IDENTIFY_DEVICE:
-                {
-                    rdm_parameters[dmx_num].identify_device = ((uint8_t *)data)[24]; // FIXME find better way to get the address
-                    rdm_send_set_command_ack_response(dmx_num, header.source_uid, header.tn, header.sub_device, RDM_PID_IDENTIFY_DEVICE);
-                    ESP_LOGI("RDM DBG", "Set identify: %d", rdm_parameters[dmx_num].identify_device);
-                    if (rdm_client_parameters[dmx_num].identify_cb)
-                    {
-                        rdm_client_parameters[dmx_num].identify_cb(rdm_parameters[dmx_num].identify_device);
-                    }
-                }
-                break;
-                case RDM_PID_DMX_START_ADDRESS:
-                {
-                    rdm_parameters_t *params = &rdm_parameters[dmx_num];
-                    uint16_t addr;
-                    memcpy(&addr, data + 24, 2); // FIXME find better way to get the address
-                    params->device_info.start_address = bswap16(addr);
-                    rdm_send_set_command_ack_response(dmx_num, header.source_uid, header.tn, header.sub_device, RDM_PID_DMX_START_ADDRESS);
-                    ESP_LOGI("RDM DBG", "Set start address: %d", params->device_info.start_address);
-                    if (rdm_client_parameters[dmx_num].address_cb)
-                    {
-                        rdm_client_parameters[dmx_num].address_cb(params->device_info.start_address);
-                    }
-                }
-                break;
-                case RDM_PID_DEVICE_LABEL:
-                {
-                    if (header.pdl > 32)
-                    {
-                        ESP_LOGE("RDM", "header.pdl too large: %d", header.pdl);
-                        return;
-                    }
-                    rdm_parameters_t *params = &rdm_parameters[dmx_num];
-                    memset(params->device_label, 0, sizeof(params->device_label));
-                    memcpy(params->device_label, data + 24, header.pdl); // FIXME find better way to get the address
-                    params->device_label_len = header.pdl;
-                    rdm_send_set_command_ack_response(dmx_num, header.source_uid, header.tn, header.sub_device, RDM_PID_DEVICE_LABEL);
-                    ESP_LOGI("RDM DBG", "Set device label: %s", params->device_label);
-                    if (rdm_client_parameters[dmx_num].label_cb)
-                    {
-                        rdm_client_parameters[dmx_num].label_cb(params->device_label, params->device_label_len);
-                    }
-                }
-                break;
-                case RDM_PID_DMX_PERSONALITY:
-                {
-                    if(header.pdl != 1)
-                    {
-                        ESP_LOGE("RDM", "header.pdl invalid: %d", header.pdl);
-                        return;
-                    }
-                    rdm_parameters_t *params = &rdm_parameters[dmx_num];
-                    uint8_t personality = -1;
-                    memcpy(&personality, data + 24, header.pdl);
-                    rdm_send_set_command_ack_response(dmx_num, header.source_uid, header.tn, header.sub_device, RDM_PID_DMX_PERSONALITY);
-
-                    rdm_client_set_personality(dmx_num, personality);
-
-                    if(rdm_client_parameters[dmx_num].personality_cb != NULL)
-                    {
-                        rdm_client_parameters[dmx_num].personality_cb(params->device_info.current_personality);
-                    }
-
-                    ESP_LOGI("RDM DBG", "Set personality: %d", params->device_info.current_personality);
-                }
-                break;
+    // QUEUED_MESSAGE responses use the PID and sub-device of the queued message
+    rdm_header_t reply = header;
+    reply.pid = response.pid;
+    reply.sub_device = response.sub_device;
+    if (response.type == RDM_RESPONSE_TYPE_NACK_REASON)
+    {
+        if (slot == RDM_CLIENT_HANDLER_DISC)
+        {
+            return -1; // Discovery commands are never NACKed
+        }
+        return rdm_send_nack_response(dmx_num, &reply, response.nack_reason);
+    }
+    else if (is_cacheable && response.type == RDM_RESPONSE_TYPE_ACK)
+    {
+        const rdm_client_cached_response_t *cached = rdm_client_store_response(dmx_num, &header, pd, &response, generation);
+        if (cached != NULL)
+        {
+            return rdm_send_encoded_response(dmx_num, &header, cached->packet, cached->size);
+        }
+    }
+    return rdm_send_response(dmx_num, &reply, response.type, response.pd, response.pdl);
+}
 
-                case RDM_PID_SENSOR_VALUE:
-                {
-                    const rdm_parameters_t *params = &rdm_parameters[dmx_num];
+void rdm_client_handle_rdm_message(dmx_port_t dmx_num, const dmx_packet_t *dmxPacket, const void *data, const uint16_t size)
+{
+    rdm_client_dispatch(dmx_num, data, size);
+}
 
-                    rdm_header_t header2;
-                    uint8_t *pd;
-                    rdm_get_pd(data,&header2,&pd);
 
-                    sensorData_t tempSensorData;
-                    memcpy(&tempSensorData,getSensorData(*pd),sizeof(sensorData_t));
-                    tempSensorData.sensorVal = bswap16(tempSensorData.sensorVal);
-                    tempSensorData.minVal = bswap16(tempSensorData.minVal);
-                    tempSensorData.maxVal = bswap16(tempSensorData.maxVal);
-                    tempSensorData.recVal = bswap16(tempSensorData.recVal);
+static void rdm_client_responder_task(void *arg)
+{
+    const dmx_port_t dmx_num = (dmx_port_t)(intptr_t)arg;
+    rdm_client_responder_t *responder = &rdm_client_responder[dmx_num];
+    uint8_t data[RDM_BASE_PACKET_SIZE + RDM_MAX_PDL];
 
+    while (responder->is_running)
+    {
+        dmx_packet_t packet;
+        const size_t size = dmx_receive(dmx_num, &packet, DMX_TIMEOUT_TICK);
+        if (size == 0)
+        {
+            continue;
+        }
+        if (!packet.is_rdm)
+        {
+            xQueueOverwrite(responder->dmx_queue, &packet);
+            continue;
+        }
 
-                   // sensorData_t tempSensorData = {.sensorNum = 0, .sensorVal=bswap16(24), .minVal=bswap16(0),.maxVal=bswap16(0), .recVal=bswap16(0)};
-                    const size_t bytesSent = rdm_send_set_param_response(dmx_num, header.source_uid, header.tn,
-                                                                         RDM_PID_SENSOR_VALUE, header.sub_device, &tempSensorData, 9);
-                    ESP_LOGI("RDM DBG", "Sent GET RDM_PID_SENSOR_VALUE response. label: %s, %d bytes", params->device_label, bytesSent);
-                }
-                break;
+        // Respond and measure the time from the end of the request to the response
+        const int64_t rx_done_ts = dmx_timing[dmx_num].rx_done_ts;
+        const size_t read = dmx_read(dmx_num, data, size < sizeof(data) ? size : sizeof(data));
+        const int sent = rdm_client_dispatch(dmx_num, data, read);
+        const uint32_t turnaround = esp_timer_get_time() - rx_done_ts;
 
-                default:
-                    ESP_LOGI("RDM DBG", " RDM_CC_SET_COMMAND unknown set pid: %04x", header.pid);
-                    ESP_LOG_BUFFER_HEX("RDM", data, size);
-                }
+        rdm_responder_stats_t *stats = &responder->stats;
+        ++stats->num_handled;
+        if (sent == 0)
+        {
+            ++stats->num_missed;
+        }
+        else if (sent > 0)
+        {
+            ++stats->num_responses;
+            if (turnaround > responder->config.late_threshold_us)
+            {
+                ++stats->num_late;
             }
-            else
+            if (turnaround > stats->max_turnaround_us)
             {
-                // debugPrintRdm(header);
+                stats->max_turnaround_us = turnaround;
             }
         }
     }
+
+    xSemaphoreGive(responder->stopped);
+    vTaskDelete(NULL);
+}
+
+bool rdm_client_responder_start(dmx_port_t dmx_num, const rdm_responder_config_t *config)
+{
+    if (dmx_num >= DMX_NUM_MAX)
+    {
+        ESP_LOGE("rdm_client", "dmx_num too large");
+        return false;
+    }
+    if (!dmx_driver_is_installed(dmx_num))
+    {
+        ESP_LOGE("rdm_client", "driver is not installed");
+        return false;
+    }
+    rdm_client_responder_t *responder = &rdm_client_responder[dmx_num];
+    if (responder->is_running)
+    {
+        ESP_LOGE("rdm_client", "responder is already running");
+        return false;
+    }
+
+    const rdm_responder_config_t default_config = RDM_RESPONDER_DEFAULT_CONFIG;
+    responder->config = config != NULL ? *config : default_config;
+    memset(&responder->stats, 0, sizeof(responder->stats));
+    responder->dmx_queue = xQueueCreate(1, sizeof(dmx_packet_t));
+    responder->stopped = xSemaphoreCreateBinary();
+    if (responder->dmx_queue == NULL || responder->stopped == NULL)
+    {
+        ESP_LOGE("rdm_client", "responder malloc error");
+        goto err;
+    }
+
+    // The UID must be initialized before the interrupt handler filters on it
+    rdm_get_uid(dmx_num);
+
+    responder->is_running = true;
+    if (xTaskCreatePinnedToCore(rdm_client_responder_task, "rdm_responder", responder->config.stack_size,
+                                (void *)(intptr_t)dmx_num, responder->config.priority, &responder->task,
+                                responder->config.core_id) != pdPASS)
+    {
+        ESP_LOGE("rdm_client", "responder task create error");
+        responder->is_running = false;
+        goto err;
+    }
+
+    taskENTER_CRITICAL(&dmx_spinlock[dmx_num]);
+    rdm_responder_isr[dmx_num].num_dropped = 0;
+    rdm_responder_isr[dmx_num].is_enabled = true;
+    taskEXIT_CRITICAL(&dmx_spinlock[dmx_num]);
+
+    return true;
+
+err:
+    if (responder->dmx_queue != NULL)
+    {
+        vQueueDelete(responder->dmx_queue);
+        responder->dmx_queue = NULL;
+    }
+    if (responder->stopped != NULL)
+    {
+        vSemaphoreDelete(responder->stopped);
+        responder->stopped = NULL;
+    }
+    return false;
+}
+
+bool rdm_client_responder_stop(dmx_port_t dmx_num)
+{
+    if (dmx_num >= DMX_NUM_MAX)
+    {
+        ESP_LOGE("rdm_client", "dmx_num too large");
+        return false;
+    }
+    rdm_client_responder_t *responder = &rdm_client_responder[dmx_num];
+    if (!responder->is_running)
+    {
+        return false;
+    }
+
+    taskENTER_CRITICAL(&dmx_spinlock[dmx_num]);
+    rdm_responder_isr[dmx_num].is_enabled = false;
+    taskEXIT_CRITICAL(&dmx_spinlock[dmx_num]);
+
+    // The task exits once its current call to dmx_receive() returns
+    responder->is_running = false;
+    xSemaphoreTake(responder->stopped, portMAX_DELAY);
+    responder->task = NULL;
+    vQueueDelete(responder->dmx_queue);
+    responder->dmx_queue = NULL;
+    vSemaphoreDelete(responder->stopped);
+    responder->stopped = NULL;
+
+    return true;
+}
+
+bool rdm_client_responder_is_running(dmx_port_t dmx_num)
+{
+    return dmx_num < DMX_NUM_MAX && rdm_client_responder[dmx_num].is_running;
+}
+
+bool rdm_client_receive_dmx(dmx_port_t dmx_num, dmx_packet_t *packet, TickType_t wait_ticks)
+{
+    if (dmx_num >= DMX_NUM_MAX || packet == NULL)
+    {
+        ESP_LOGE("rdm_client", "argument error");
+        return false;
+    }
+    rdm_client_responder_t *responder = &rdm_client_responder[dmx_num];
+    if (!responder->is_running)
+    {
+        ESP_LOGE("rdm_client", "responder is not running");
+        return false;
+    }
+
+    return xQueueReceive(responder->dmx_queue, packet, wait_ticks);
+}
+
+bool rdm_client_get_responder_stats(dmx_port_t dmx_num, rdm_responder_stats_t *stats)
+{
+    if (dmx_num >= DMX_NUM_MAX || stats == NULL)
+    {
+        ESP_LOGE("rdm_client", "argument error");
+        return false;
+    }
+
+    *stats = rdm_client_responder[dmx_num].stats;
+    taskENTER_CRITICAL(&dmx_spinlock[dmx_num]);
+    stats->num_missed += rdm_responder_isr[dmx_num].num_dropped;
+    taskEXIT_CRITICAL(&dmx_spinlock[dmx_num]);
+
+    return true;
 }
@@ -2,6 +2,8 @@
 #include <stdbool.h>
 #include "rdm_types.h"
 #include "dmx_types.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -11,22 +13,90 @@ typedef void (*start_address_changed_cb_t)(uint16_t);
 typedef void (*identify_cb_t)(bool);
 typedef void (*label_changed_cb_t)(const char*, size_t);
 typedef void (*personality_changed_cb_t)(uint8_t personality);
+/// Invoked when a controller changes a parameter of a sub-device. The sub-device
+/// is RDM_ALL_SUB_DEVICES if the change was sent to all sub-devices.
+typedef void (*sub_device_changed_cb_t)(rdm_sub_device_t sub_device, rdm_pid_t pid);
+
+/**
+ * The response to a request which is filled in by a PID handler. The response
+ * type defaults to RDM_RESPONSE_TYPE_ACK with no parameter data. The PID and
+ * sub-device only differ from the request in replies to QUEUED_MESSAGE.
+ */
+typedef struct rdm_client_response_t
+{
+    rdm_response_type_t type; // The response type. Set to RDM_RESPONSE_TYPE_NONE to send no response.
+    rdm_nr_t nack_reason;     // The NACK reason when the type is RDM_RESPONSE_TYPE_NACK_REASON.
+    rdm_pid_t pid;            // The PID of the response. Defaults to the PID of the request.
+    int sub_device;           // The sub-device of the response. Defaults to the sub-device of the request.
+    size_t pdl;               // The length of the response parameter data.
+    uint8_t pd[RDM_MAX_PDL];  // The response parameter data, in wire format.
+} rdm_client_response_t;
+
+/**
+ * A DMX personality of the device. Tables of personalities may be declared
+ * static const so that they are kept in flash, see rdm_client_set_personalities().
+ */
+typedef struct rdm_client_personality_t
+{
+    uint16_t footprint;      // The number of DMX slots which are used by the personality.
+    const char *description; // The description of the personality. At most 32 characters are sent.
+} rdm_client_personality_t;
+
+/**
+ * Handles a GET or SET request for a single PID.
+ * @param header The header of the request.
+ * @param pd The request parameter data. header->pdl bytes are valid.
+ * @param response The response to fill in.
+ * @param context The context pointer which was passed to rdm_client_register_pid().
+ */
+typedef void (*rdm_pid_handler_t)(dmx_port_t dmx_num, const rdm_header_t *header, const uint8_t *pd,
+                                  rdm_client_response_t *response, void *context);
 
 
 //TODO comment
 bool rdm_client_init(dmx_port_t dmx_num, uint16_t start_address, uint16_t footprint, const char* device_label,
                      const char *personality_description);
 
+/**
+ * Frees the memory which was allocated by rdm_client_init(), i.e. the response
+ * cache, the personalities, and the queued message ring, and unregisters all
+ * PIDs. Sub-devices are kept.
+ * Must not be called while the responder task is running.
+ * @return false if dmx_num is invalid or the responder task is running.
+ */
+bool rdm_client_deinit(dmx_port_t dmx_num);
+
 /// returns the id of the personality, or -1 in case of error
+/// The personality is copied into a heap pool which is sized to the personality count.
+/// If a table was set with rdm_client_set_personalities() it is copied into the pool first.
+/// Must not be called while the responder task is running, and returns -1 if it is.
 int rdm_client_add_personality(dmx_port_t dmx_num, uint16_t footprint, const char* description);
 
+/**
+ * Replaces all personalities of the device with a table and selects personality 1.
+ * The table is not copied and must remain valid while the client is in use, e.g.
+ * a static const table which is kept in flash.
+ * Must not be called while the responder task is running.
+ * @param personalities The personalities. Personality n is personalities[n - 1].
+ * @param count The number of personalities, from 1 to 255.
+ * @return false if an argument is invalid or the responder task is running.
+ */
+bool rdm_client_set_personalities(dmx_port_t dmx_num, const rdm_client_personality_t *personalities, size_t count);
+
+/// Selects a personality and posts a DMX_PERSONALITY queued message so that controllers learn of the change.
 bool rdm_client_set_personality(dmx_port_t dmx_num, uint8_t personality);
 
 void rdm_client_set_personality_changed_cb(dmx_port_t dmx_num, personality_changed_cb_t cb);
 
-
+/// Sets the start address and posts a DMX_START_ADDRESS queued message so that controllers learn of the change.
 void rdm_client_set_start_address(dmx_port_t dmx_num, uint16_t start_address);
 
+/**
+ * Sets the sensor count which is reported in DEVICE_INFO. Called by the sensor
+ * registry whenever a sensor is added.
+ */
+void rdm_client_set_sensor_count(dmx_port_t dmx_num, size_t sensor_count);
+
 /** 
  * @param cb Will be invoked every time the dmx start address is changed. */
 void rdm_client_set_start_address_changed_cb(dmx_port_t dmx_num, start_address_changed_cb_t cb);
@@ -43,6 +113,160 @@ void rdm_client_set_notify_cb(dmx_port_t dmx_num, identify_cb_t cb);
 */
 void rdm_client_set_label_changed_cb(dmx_port_t dmx_num, label_changed_cb_t cb);
 
+/**
+ * Registers the handlers of a PID. Registering a PID which is already registered
+ * replaces its handlers, which may be used to override the built-in PIDs.
+ * Registering a PID with both handlers NULL removes it.
+ * Must be called after rdm_client_init().
+ * @param get_handler Invoked on GET requests, or NULL if GET is not supported.
+ * @param set_handler Invoked on SET requests, or NULL if SET is not supported.
+ * @param context Passed to the handlers.
+ * @return false if the table is full (see CONFIG_RDM_CLIENT_MAX_PIDS) or an
+ *         argument is invalid.
+ */
+bool rdm_client_register_pid(dmx_port_t dmx_num, rdm_pid_t pid, rdm_pid_handler_t get_handler,
+                             rdm_pid_handler_t set_handler, void *context);
+
+/**
+ * Gets the PIDs which are reported in SUPPORTED_PARAMETERS. These are all
+ * registered PIDs except those which E1.20 requires every responder to support.
+ * @param pids A buffer into which to write the PIDs.
+ * @param size The number of PIDs that fit in the buffer.
+ * @return The number of supported PIDs, which may be larger than size.
+ */
+size_t rdm_client_get_supported_parameters(dmx_port_t dmx_num, rdm_pid_t *pids, size_t size);
+
+/**
+ * The parameters of a sub-device, see rdm_client_get_sub_device().
+ */
+typedef struct rdm_client_sub_device_info_t
+{
+    uint16_t model_id;      // The model ID which is reported in the DEVICE_INFO of the sub-device.
+    uint16_t footprint;     // The number of DMX slots which are used by the sub-device.
+    uint16_t start_address; // The DMX start address, or 0xffff if the footprint is 0.
+    bool identify;          // True if the sub-device should identify itself.
+    char label[33];         // The null-terminated device label of the sub-device.
+} rdm_client_sub_device_info_t;
+
+/**
+ * Adds a sub-device. Sub-devices answer DEVICE_INFO, SUPPORTED_PARAMETERS,
+ * DEVICE_LABEL, DMX_START_ADDRESS and IDENTIFY_DEVICE, see
+ * rdm_client_set_pid_sub_device_support() for other PIDs. Storage is only
+ * allocated for sub-devices which exist, so sub-device numbers may be sparse.
+ * The sub-device count of DEVICE_INFO is updated.
+ * Must not be called while the responder task is running.
+ * @param sub_device The sub-device number, from 1 to 512.
+ * @param footprint The DMX footprint of the sub-device, which may be 0.
+ * @param start_address The DMX start address, from 1 to 512. Ignored if the footprint is 0.
+ * @return false if the sub-device already exists, an argument is invalid, there is not enough memory or the
+ * responder task is running.
+ */
+bool rdm_client_add_sub_device(dmx_port_t dmx_num, rdm_sub_device_t sub_device, uint16_t model_id,
+                               uint16_t footprint, uint16_t start_address);
+
+/**
+ * Removes a sub-device and frees its storage.
+ * Must not be called while the responder task is running.
+ * @return false if the sub-device does not exist or the responder task is running.
+ */
+bool rdm_client_remove_sub_device(dmx_port_t dmx_num, rdm_sub_device_t sub_device);
+
+/**
+ * Gets the parameters of a sub-device.
+ * @return false if the sub-device does not exist.
+ */
+bool rdm_client_get_sub_device(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_client_sub_device_info_t *info);
+
+/// Sets the start address of a sub-device and posts a DMX_START_ADDRESS queued message.
+bool rdm_client_set_sub_device_start_address(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
+                                             uint16_t start_address);
+
+/**
+ * @param cb Will be invoked every time a controller changes a parameter of a sub-device.
+ *           A SET to all sub-devices invokes it once with RDM_ALL_SUB_DEVICES.
+ */
+void rdm_client_set_sub_device_changed_cb(dmx_port_t dmx_num, sub_device_changed_cb_t cb);
+
+/**
+ * Selects whether the handlers of a registered PID accept requests to
+ * sub-devices. Requests to sub-devices for other PIDs are NACKed with
+ * RDM_NR_UNKNOWN_PID. Registering a PID resets this to false.
+ * Handlers of sub-device PIDs must check header->sub_device. SET requests to
+ * RDM_ALL_SUB_DEVICES are passed to the handler once per sub-device.
+ * @return false if the PID is not registered.
+ */
+bool rdm_client_set_pid_sub_device_support(dmx_port_t dmx_num, rdm_pid_t pid, bool supported);
+
+/**
+ * Configuration of the RDM responder task
+ */
+typedef struct rdm_responder_config_t
+{
+    UBaseType_t priority;       // The priority of the responder task.
+    BaseType_t core_id;         // The core to which the responder task is pinned, or tskNO_AFFINITY.
+    uint32_t stack_size;        // The stack size of the responder task in bytes.
+    uint32_t late_threshold_us; // Responses which start later than this after the end of the request are counted as late.
+} rdm_responder_config_t;
+
+#define RDM_RESPONDER_DEFAULT_CONFIG          \
+    {                                         \
+        .priority = configMAX_PRIORITIES - 1, \
+        .core_id = tskNO_AFFINITY,            \
+        .stack_size = 4096,                   \
+        .late_threshold_us = 1000,            \
+    }
+
+/**
+ * Statistics of the RDM responder task
+ */
+typedef struct rdm_responder_stats_t
+{
+    uint32_t num_handled;       // The number of RDM requests which were handled.
+    uint32_t num_responses;     // The number of responses which were sent.
+    uint32_t num_late;          // The number of responses which started later than late_threshold_us.
+    uint32_t num_missed;        // The number of requests which were dropped while the task was busy or whose response was too late to send.
+    uint32_t max_turnaround_us; // The longest time from the end of a request to the start of its response.
+} rdm_responder_stats_t;
+
+/**
+ * Starts a task which receives from the DMX port and responds to RDM requests
+ * without involving the application. While the task is running the DMX
+ * interrupt handler only wakes it for DMX packets and RDM packets which are
+ * addressed to this device. DMX packets are forwarded to the application
+ * through rdm_client_receive_dmx(), which replaces dmx_receive().
+ * @param config The task configuration, or NULL for RDM_RESPONDER_DEFAULT_CONFIG.
+ * @return false if the task is already running or could not be created.
+ */
+bool rdm_client_responder_start(dmx_port_t dmx_num, const rdm_responder_config_t *config);
+
+/**
+ * Stops the RDM responder task. Blocks until the task has exited. Must be
+ * called before the DMX driver is deleted.
+ * @return false if the task is not running.
+ */
+bool rdm_client_responder_stop(dmx_port_t dmx_num);
+
+/**
+ * @return true if the RDM responder task is running.
+ */
+bool rdm_client_responder_is_running(dmx_port_t dmx_num);
+
+/**
+ * Waits for a DMX packet while the RDM responder task is running. Only the
+ * latest packet is kept. The packet data can be read with dmx_read().
+ * @param packet The packet metadata.
+ * @param wait_ticks The number of ticks to wait for a packet.
+ * @return true if a packet was received.
+ */
+bool rdm_client_receive_dmx(dmx_port_t dmx_num, dmx_packet_t *packet, TickType_t wait_ticks);
+
+/**
+ * Gets the statistics of the RDM responder task. The statistics are reset
+ * when the task is started.
+ * @return false if an argument is invalid.
+ */
+bool rdm_client_get_responder_stats(dmx_port_t dmx_num, rdm_responder_stats_t *stats);
+
 /**
  * This method should be called anytime a dmx-rdm message is received.
 */
@@ -0,0 +1,332 @@
+#include "esp_rdm_codec.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "dmx_types.h"
+#include "rdmsensors.h"
+
+/* Formats are declared once and shared by every PID that uses them. Fields
+must be listed in the order they appear in the parameter data. */
+
+static const rdm_field_t rdm_fields_u8[] = {
+    RDM_SCALAR(RDM_FIELD_TYPE_UINT, 1, uint8_t)};
+static const rdm_field_t rdm_fields_u32[] = {
+    RDM_SCALAR(RDM_FIELD_TYPE_UINT, 4, uint32_t)};
+static const rdm_field_t rdm_fields_pid[] = {
+    RDM_SCALAR(RDM_FIELD_TYPE_UINT, 2, rdm_pid_t)};
+static const rdm_field_t rdm_fields_product_detail[] = {
+    RDM_SCALAR(RDM_FIELD_TYPE_UINT, 2, uint16_t)};
+static const rdm_field_t rdm_fields_bool[] = {
+    RDM_SCALAR(RDM_FIELD_TYPE_UINT, 1, bool)};
+static const rdm_field_t rdm_fields_address[] = {
+    RDM_SCALAR(RDM_FIELD_TYPE_INT, 2, int)};
+static const rdm_field_t rdm_fields_label[] = {
+    RDM_SCALAR(RDM_FIELD_TYPE_STRING, 32, char)};
+
+static const rdm_field_t rdm_fields_device_info[] = {
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 1, rdm_device_info_t, major_rdm_version),
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 1, rdm_device_info_t, minor_rdm_version),
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 2, rdm_device_info_t, model_id),
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 1, rdm_device_info_t,
+              coarse_product_category),
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 1, rdm_device_info_t,
+              fine_product_category),
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 4, rdm_device_info_t, software_version_id),
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 2, rdm_device_info_t, footprint),
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 1, rdm_device_info_t, current_personality),
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 1, rdm_device_info_t, personality_count),
+    RDM_FIELD(RDM_FIELD_TYPE_INT, 2, rdm_device_info_t, start_address),
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 2, rdm_device_info_t, sub_device_count),
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 1, rdm_device_info_t, sensor_count)};
+
+static const rdm_field_t rdm_fields_sensor_def[] = {
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 1, sensorDef_t, sensorNum),
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 1, sensorDef_t, sensorType),
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 1, sensorDef_t, sensorUnit),
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 1, sensorDef_t, sensorPrefix),
+    RDM_FIELD(RDM_FIELD_TYPE_INT, 2, sensorDef_t, range_min),
+    RDM_FIELD(RDM_FIELD_TYPE_INT, 2, sensorDef_t, range_max),
+    RDM_FIELD(RDM_FIELD_TYPE_INT, 2, sensorDef_t, normal_min),
+    RDM_FIELD(RDM_FIELD_TYPE_INT, 2, sensorDef_t, normal_max),
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 1, sensorDef_t, sensorHistory),
+    RDM_FIELD(RDM_FIELD_TYPE_STRING, 32, sensorDef_t, sensorDesc)};
+
+static const rdm_field_t rdm_fields_sensor_value[] = {
+    RDM_FIELD(RDM_FIELD_TYPE_UINT, 1, sensorData_t, sensorNum),
+    RDM_FIELD(RDM_FIELD_TYPE_INT, 2, sensorData_t, sensorVal),
+    RDM_FIELD(RDM_FIELD_TYPE_INT, 2, sensorData_t, minVal),
+    RDM_FIELD(RDM_FIELD_TYPE_INT, 2, sensorData_t, maxVal),
+    RDM_FIELD(RDM_FIELD_TYPE_INT, 2, sensorData_t, recVal)};
+
+#define RDM_FORMAT(field_array, items, host) \
+  { .fields = (field_array),                 \
+    .num_fields = sizeof(field_array) / sizeof(rdm_field_t), \
+    .max_items = (items), .host_size = (host) }
+
+const rdm_format_t rdm_format_raw = RDM_FORMAT(rdm_fields_u8, 0, 1);
+
+static const rdm_format_t rdm_format_u8 =
+    RDM_FORMAT(rdm_fields_u8, 1, sizeof(uint8_t));
+static const rdm_format_t rdm_format_u32 =
+    RDM_FORMAT(rdm_fields_u32, 1, sizeof(uint32_t));
+static const rdm_format_t rdm_format_pid_list =
+    RDM_FORMAT(rdm_fields_pid, 0, sizeof(rdm_pid_t));
+static const rdm_format_t rdm_format_product_detail_list =
+    RDM_FORMAT(rdm_fields_product_detail, 6, sizeof(uint16_t));
+static const rdm_format_t rdm_format_bool =
+    RDM_FORMAT(rdm_fields_bool, 1, sizeof(bool));
+static const rdm_format_t rdm_format_address =
+    RDM_FORMAT(rdm_fields_address, 1, sizeof(int));
+static const rdm_format_t rdm_format_label =
+    RDM_FORMAT(rdm_fields_label, 1, 0);
+static const rdm_format_t rdm_format_device_info =
+    RDM_FORMAT(rdm_fields_device_info, 1, sizeof(rdm_device_info_t));
+static const rdm_format_t rdm_format_sensor_def =
+    RDM_FORMAT(rdm_fields_sensor_def, 1, sizeof(sensorDef_t));
+static const rdm_format_t rdm_format_sensor_value =
+    RDM_FORMAT(rdm_fields_sensor_value, 1, sizeof(sensorData_t));
+
+// The PID descriptor table. Must be sorted by PID.
+static const rdm_pid_desc_t rdm_pid_descs[] = {
+    {RDM_PID_SUPPORTED_PARAMETERS, NULL, &rdm_format_pid_list},
+    {RDM_PID_DEVICE_INFO, NULL, &rdm_format_device_info},
+    {RDM_PID_PRODUCT_DETAIL_ID_LIST, NULL, &rdm_format_product_detail_list},
+    {RDM_PID_DEVICE_MODEL_DESCRIPTION, NULL, &rdm_format_label},
+    {RDM_PID_MANUFACTURER_LABEL, NULL, &rdm_format_label},
+    {RDM_PID_DEVICE_LABEL, NULL, &rdm_format_label},
+    {RDM_PID_SOFTWARE_VERSION_LABEL, NULL, &rdm_format_label},
+    {RDM_PID_BOOT_SOFTWARE_VERSION_ID, NULL, &rdm_format_u32},
+    {RDM_PID_BOOT_SOFTWARE_VERSION_LABEL, NULL, &rdm_format_label},
+    {RDM_PID_DMX_START_ADDRESS, NULL, &rdm_format_address},
+    {RDM_PID_SENSOR_DEFINITION, &rdm_format_u8, &rdm_format_sensor_def},
+    {RDM_PID_SENSOR_VALUE, &rdm_format_u8, &rdm_format_sensor_value},
+    {RDM_PID_DEVICE_HOURS, NULL, &rdm_format_u32},
+    {RDM_PID_LAMP_HOURS, NULL, &rdm_format_u32},
+    {RDM_PID_LAMP_STRIKES, NULL, &rdm_format_u32},
+    {RDM_PID_DEVICE_POWER_CYCLES, NULL, &rdm_format_u32},
+    {RDM_PID_DISPLAY_INVERT, NULL, &rdm_format_u8},
+    {RDM_PID_DISPLAY_LEVEL, NULL, &rdm_format_u8},
+    {RDM_PID_PAN_INVERT, NULL, &rdm_format_bool},
+    {RDM_PID_TILT_INVERT, NULL, &rdm_format_bool},
+    {RDM_PID_PAN_TILT_SWAP, NULL, &rdm_format_bool},
+    {RDM_PID_IDENTIFY_DEVICE, NULL, &rdm_format_bool},
+};
+
+const rdm_pid_desc_t *rdm_pid_desc_find(rdm_pid_t pid) {
+  // Binary search the descriptor table
+  size_t lo = 0;
+  size_t hi = sizeof(rdm_pid_descs) / sizeof(rdm_pid_descs[0]);
+  while (lo < hi) {
+    const size_t mid = (lo + hi) / 2;
+    if (rdm_pid_descs[mid].pid == pid) {
+      return &rdm_pid_descs[mid];
+    } else if (rdm_pid_descs[mid].pid < pid) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return NULL;
+}
+
+static inline uint64_t rdm_host_read(const void *src, size_t host_size) {
+  switch (host_size) {
+    case 1: {
+      uint8_t v;
+      memcpy(&v, src, sizeof(v));
+      return v;
+    }
+    case 2: {
+      uint16_t v;
+      memcpy(&v, src, sizeof(v));
+      return v;
+    }
+    case 4: {
+      uint32_t v;
+      memcpy(&v, src, sizeof(v));
+      return v;
+    }
+    default: {
+      uint64_t v;
+      memcpy(&v, src, sizeof(v));
+      return v;
+    }
+  }
+}
+
+static inline void rdm_host_write(void *dest, size_t host_size, uint64_t val) {
+  switch (host_size) {
+    case 1: {
+      const uint8_t v = val;
+      memcpy(dest, &v, sizeof(v));
+      break;
+    }
+    case 2: {
+      const uint16_t v = val;
+      memcpy(dest, &v, sizeof(v));
+      break;
+    }
+    case 4: {
+      const uint32_t v = val;
+      memcpy(dest, &v, sizeof(v));
+      break;
+    }
+    default: {
+      memcpy(dest, &val, sizeof(val));
+      break;
+    }
+  }
+}
+
+// Returns the wire size of an item, excluding a trailing string.
+static size_t rdm_format_fixed_size(const rdm_format_t *format,
+                                    bool *has_string) {
+  size_t size = 0;
+  *has_string = false;
+  for (int i = 0; i < format->num_fields; ++i) {
+    if (format->fields[i].type == RDM_FIELD_TYPE_STRING) {
+      *has_string = true;
+    } else {
+      size += format->fields[i].wire_size;
+    }
+  }
+  return size;
+}
+
+size_t rdm_codec_encode(const rdm_format_t *format, void *pd, const void *src,
+                        size_t num) {
+  if (format == NULL || pd == NULL || src == NULL || num == 0) {
+    return 0;
+  }
+
+  // Strings are copied without a null terminator
+  uint8_t *wire = pd;
+  if (format->host_size == 0) {
+    const size_t len = strnlen(src, format->fields[0].wire_size);
+    memcpy(wire, src, len);
+    return len;
+  }
+
+  bool has_string;
+  const size_t item_size = rdm_format_fixed_size(format, &has_string);
+  if (format->max_items > 0 && num > format->max_items) {
+    num = format->max_items;
+  }
+  if (has_string) {
+    num = 1;
+  } else if (item_size > 0 && num > RDM_MAX_PDL / item_size) {
+    num = RDM_MAX_PDL / item_size;
+  }
+
+  size_t written = 0;
+  const uint8_t *host = src;
+  for (size_t n = 0; n < num; ++n, host += format->host_size) {
+    for (int i = 0; i < format->num_fields; ++i) {
+      const rdm_field_t *field = &format->fields[i];
+      if (field->type == RDM_FIELD_TYPE_STRING) {
+        size_t max_len = field->wire_size < field->host_size
+                             ? field->wire_size
+                             : field->host_size;
+        if (max_len > RDM_MAX_PDL - written) {
+          max_len = RDM_MAX_PDL - written;
+        }
+        const size_t len = strnlen((const char *)host + field->offset,
+                                   max_len);
+        memcpy(&wire[written], host + field->offset, len);
+        written += len;
+        continue;
+      }
+
+      uint64_t val;
+      if (field->type == RDM_FIELD_TYPE_UID) {
+        val = rdm_host_read(host + field->offset, sizeof(rdm_uid_t));
+      } else {
+        val = rdm_host_read(host + field->offset, field->host_size);
+      }
+      for (int b = field->wire_size - 1; b >= 0; --b) {
+        wire[written + b] = val;
+        val >>= 8;
+      }
+      written += field->wire_size;
+    }
+  }
+
+  return written;
+}
+
+size_t rdm_codec_decode(const rdm_format_t *format, const void *pd, void *dest,
+                        size_t num, size_t pdl) {
+  if (format == NULL || pd == NULL) {
+    return 0;
+  }
+
+  // Strings are null-terminated in the host buffer
+  const uint8_t *wire = pd;
+  if (format->host_size == 0) {
+    const size_t len =
+        pdl < format->fields[0].wire_size ? pdl : format->fields[0].wire_size;
+    if (dest != NULL && num > 0) {
+      const size_t copied = len < num - 1 ? len : num - 1;
+      memcpy(dest, wire, copied);
+      ((char *)dest)[copied] = '\0';
+    }
+    return len;
+  }
+
+  // Determine the number of items available in the parameter data
+  bool has_string;
+  const size_t item_size = rdm_format_fixed_size(format, &has_string);
+  size_t available;
+  if (has_string || item_size == 0) {
+    available = pdl >= item_size ? 1 : 0;
+  } else {
+    available = pdl / item_size;
+  }
+  if (format->max_items > 0 && available > format->max_items) {
+    available = format->max_items;
+  }
+  if (dest == NULL) {
+    return available;
+  }
+
+  const size_t num_decode = available < num ? available : num;
+  size_t read = 0;
+  uint8_t *host = dest;
+  for (size_t n = 0; n < num_decode; ++n, host += format->host_size) {
+    for (int i = 0; i < format->num_fields; ++i) {
+      const rdm_field_t *field = &format->fields[i];
+      if (field->type == RDM_FIELD_TYPE_STRING) {
+        size_t len = pdl - read;
+        if (len > field->wire_size) {
+          len = field->wire_size;
+        }
+        if (field->host_size > 0) {
+          const size_t max_len = field->host_size - 1U;
+          const size_t copied = len < max_len ? len : max_len;
+          memcpy(host + field->offset, &wire[read], copied);
+          host[field->offset + copied] = '\0';
+        }
+        read += len;
+        continue;
+      }
+
+      uint64_t val = 0;
+      for (int b = 0; b < field->wire_size; ++b) {
+        val = (val << 8) | wire[read + b];
+      }
+      read += field->wire_size;
+      if (field->type == RDM_FIELD_TYPE_INT && field->wire_size < 8) {
+        const uint64_t sign = 1ULL << (field->wire_size * 8 - 1);
+        val = (val ^ sign) - sign;
+      }
+      if (field->type == RDM_FIELD_TYPE_UID) {
+        rdm_host_write(host + field->offset, sizeof(rdm_uid_t), val);
+      } else {
+        rdm_host_write(host + field->offset, field->host_size, val);
+      }
+    }
+  }
+
+  return available;
+}
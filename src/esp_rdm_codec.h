@@ -0,0 +1,125 @@
+/**
+ * @file esp_rdm_codec.h
+ * @brief This file declares the table-driven RDM parameter data codec. Each
+ * supported PID is described by a row in a compile-time descriptor table which
+ * gives the field layout, wire size, and repeat count of its parameter data.
+ * Generic encode and decode functions walk these descriptors to convert
+ * between host structs and big-endian RDM parameter data in a single pass
+ * without allocating memory.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rdm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The type of a parameter data field.
+ */
+typedef enum rdm_field_type_t {
+  RDM_FIELD_TYPE_UINT,    // An unsigned big-endian integer.
+  RDM_FIELD_TYPE_INT,     // A signed big-endian integer which is sign-extended on decode.
+  RDM_FIELD_TYPE_UID,     // A 48-bit RDM UID stored in an rdm_uid_t.
+  RDM_FIELD_TYPE_STRING,  // An ASCII string of up to wire_size characters. Must be the last field. The host string is null-terminated.
+} rdm_field_type_t;
+
+/**
+ * @brief Describes a single parameter data field and where it is stored in the
+ * host struct.
+ */
+typedef struct rdm_field_t {
+  uint8_t type;       // The rdm_field_type_t of the field.
+  uint8_t wire_size;  // The size of the field in the parameter data, or the maximum string length.
+  uint8_t host_size;  // The size of the field in the host struct.
+  uint16_t offset;    // The offset of the field in the host struct.
+} rdm_field_t;
+
+/**
+ * @brief Describes the layout of a parameter data message. A message is made
+ * up of one or more items. Each item is a sequence of fields which is decoded
+ * into one host struct.
+ */
+typedef struct rdm_format_t {
+  const rdm_field_t *fields;  // The fields of each item.
+  uint8_t num_fields;         // The number of fields in each item.
+  uint8_t max_items;          // The maximum number of items, or 0 to repeat items until the parameter data is consumed.
+  uint16_t host_size;         // The size of each host struct, or 0 if the host size is given by the caller (used for strings).
+} rdm_format_t;
+
+/**
+ * @brief A row of the PID descriptor table.
+ */
+typedef struct rdm_pid_desc_t {
+  rdm_pid_t pid;              // The parameter ID.
+  const rdm_format_t *param;  // The format of GET request parameter data, or NULL if none is sent.
+  const rdm_format_t *data;   // The format of GET response and SET request parameter data, or NULL if none is sent.
+} rdm_pid_desc_t;
+
+/**
+ * @brief Declares a field which is stored in a member of a host struct.
+ */
+#define RDM_FIELD(field_type, wire, host_type, member)                   \
+  {                                                                      \
+    .type = (field_type), .wire_size = (wire),                           \
+    .host_size = sizeof(((host_type *)0)->member),                       \
+    .offset = offsetof(host_type, member)                                \
+  }
+
+/**
+ * @brief Declares a field which is stored directly in a host scalar.
+ */
+#define RDM_SCALAR(field_type, wire, host_type) \
+  { .type = (field_type), .wire_size = (wire), .host_size = sizeof(host_type), .offset = 0 }
+
+/**
+ * @brief The format of opaque parameter data. Each item is a single byte.
+ */
+extern const rdm_format_t rdm_format_raw;
+
+/**
+ * @brief Finds the descriptor of a PID in the descriptor table.
+ *
+ * @param pid The parameter ID.
+ * @return A pointer to the descriptor or NULL if the PID is not in the table.
+ */
+const rdm_pid_desc_t *rdm_pid_desc_find(rdm_pid_t pid);
+
+/**
+ * @brief Encodes host data into RDM parameter data.
+ *
+ * @param[in] format The format of the parameter data.
+ * @param[out] pd A buffer into which to encode the parameter data. Must be at
+ * least RDM_MAX_PDL bytes.
+ * @param[in] src The host data to encode. For string formats, a
+ * null-terminated string.
+ * @param num The number of items to encode.
+ * @return The number of bytes of parameter data that were written.
+ */
+size_t rdm_codec_encode(const rdm_format_t *format, void *pd, const void *src,
+                        size_t num);
+
+/**
+ * @brief Decodes RDM parameter data into host data.
+ *
+ * @param[in] format The format of the parameter data.
+ * @param[in] pd The parameter data to decode.
+ * @param[out] dest A buffer into which to decode the host data.
+ * @param num The number of items that fit in the buffer. For string formats,
+ * the size of the buffer in bytes.
+ * @param pdl The parameter data length.
+ * @return The number of items available in the parameter data, which may be
+ * larger than the number of items decoded. For string formats, the length of
+ * the string.
+ */
+size_t rdm_codec_decode(const rdm_format_t *format, const void *pd, void *dest,
+                        size_t num, size_t pdl);
+
+#ifdef __cplusplus
+}
+#endif
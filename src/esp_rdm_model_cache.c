@@ -0,0 +1,499 @@
+#include "esp_rdm_model_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// Used for argument checking at the beginning of each function.
+#define RDM_MODEL_CACHE_CHECK(a, err_code, format, ...) \
+  ESP_RETURN_ON_FALSE(a, err_code, TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "rdm_model_cache";  // The log tagline for the file.
+
+enum {
+  RDM_MODEL_CACHE_MAX_PARAM_LEN = 4,       // The longest request parameter data that is cached.
+  RDM_MODEL_CACHE_MAGIC = 0x434d4452,      // "RDMC" - identifies a serialized cache.
+  RDM_MODEL_CACHE_VERSION = 1,             // The version of the serialized cache format.
+};
+
+// The model of a single device.
+typedef struct rdm_model_cache_device_t {
+  rdm_uid_t uid;   // The UID of the device.
+  uint16_t model;  // The index of the device's model key.
+} rdm_model_cache_device_t;
+
+// A single cached response. Entries are sorted by model, PID, and parameter.
+typedef struct rdm_model_cache_entry_t {
+  uint16_t model;                                // The index of the model key.
+  uint16_t pid;                                  // The parameter ID.
+  uint8_t param_len;                             // The request parameter data length.
+  uint8_t param[RDM_MODEL_CACHE_MAX_PARAM_LEN];  // The request parameter data.
+  uint8_t pdl;                                   // The response parameter data length.
+  uint16_t offset;                               // The offset of the response in the data pool.
+} rdm_model_cache_entry_t;
+
+// The header of a serialized cache.
+typedef struct rdm_model_cache_blob_t {
+  uint32_t magic;        // Must be RDM_MODEL_CACHE_MAGIC.
+  uint16_t version;      // Must be RDM_MODEL_CACHE_VERSION.
+  uint16_t num_models;   // The number of model keys that follow the header.
+  uint16_t num_entries;  // The number of entries that follow the model keys.
+  uint16_t data_len;     // The number of data bytes that follow the entries.
+} rdm_model_cache_blob_t;
+
+typedef struct rdm_model_cache_t {
+  SemaphoreHandle_t mux;              // Protects the tables from concurrent access.
+  rdm_model_cache_config_t config;    // The model cache configuration.
+  size_t num_models;                  // The number of known models.
+  rdm_model_key_t *models;            // The known models.
+  size_t num_devices;                 // The number of known devices.
+  rdm_model_cache_device_t *devices;  // Known devices sorted by UID.
+  size_t num_entries;                 // The number of cached responses.
+  rdm_model_cache_entry_t *entries;   // Cached responses sorted by key.
+  size_t data_len;                    // The number of bytes used in the pool.
+  uint8_t *data;                      // The parameter data pool.
+} rdm_model_cache_t;
+
+static rdm_model_cache_t *rdm_model_cache[DMX_NUM_MAX] = {0};
+
+bool rdm_pid_is_model_static(rdm_pid_t pid) {
+  switch (pid) {
+    case RDM_PID_SUPPORTED_PARAMETERS:
+    case RDM_PID_PARAMETER_DESCRIPTION:
+    case RDM_PID_PRODUCT_DETAIL_ID_LIST:
+    case RDM_PID_DEVICE_MODEL_DESCRIPTION:
+    case RDM_PID_MANUFACTURER_LABEL:
+    case RDM_PID_DMX_PERSONALITY_DESCRIPTION:
+    case RDM_PID_SLOT_INFO:
+    case RDM_PID_SLOT_DESCRIPTION:
+    case RDM_PID_DEFAULT_SLOT_VALUE:
+    case RDM_PID_SENSOR_DEFINITION:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static int rdm_model_cache_find_device(const rdm_model_cache_t *cache,
+                                       rdm_uid_t uid, size_t *insert_at) {
+  // Binary search the sorted device table
+  size_t lo = 0;
+  size_t hi = cache->num_devices;
+  while (lo < hi) {
+    const size_t mid = (lo + hi) / 2;
+    const rdm_uid_t mid_uid = cache->devices[mid].uid;
+    if (mid_uid == uid) {
+      return mid;
+    } else if (mid_uid < uid) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (insert_at != NULL) {
+    *insert_at = lo;
+  }
+  return -1;
+}
+
+static int rdm_model_cache_find_model(const rdm_model_cache_t *cache,
+                                      const rdm_model_key_t *key) {
+  for (size_t i = 0; i < cache->num_models; ++i) {
+    const rdm_model_key_t *model = &cache->models[i];
+    if (model->manufacturer_id == key->manufacturer_id &&
+        model->model_id == key->model_id &&
+        model->software_version_id == key->software_version_id) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static int rdm_model_cache_compare(const rdm_model_cache_entry_t *entry,
+                                   int model, rdm_pid_t pid, const void *param,
+                                   size_t param_len) {
+  if (entry->model != model) {
+    return entry->model < model ? -1 : 1;
+  } else if (entry->pid != pid) {
+    return entry->pid < pid ? -1 : 1;
+  } else if (entry->param_len != param_len) {
+    return entry->param_len < param_len ? -1 : 1;
+  }
+  return param_len > 0 ? memcmp(entry->param, param, param_len) : 0;
+}
+
+static int rdm_model_cache_find_entry(const rdm_model_cache_t *cache,
+                                      int model, rdm_pid_t pid,
+                                      const void *param, size_t param_len,
+                                      size_t *insert_at) {
+  // Binary search the sorted entry table
+  size_t lo = 0;
+  size_t hi = cache->num_entries;
+  while (lo < hi) {
+    const size_t mid = (lo + hi) / 2;
+    const int cmp = rdm_model_cache_compare(&cache->entries[mid], model, pid,
+                                            param, param_len);
+    if (cmp == 0) {
+      return mid;
+    } else if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (insert_at != NULL) {
+    *insert_at = lo;
+  }
+  return -1;
+}
+
+static void rdm_model_cache_reset(rdm_model_cache_t *cache) {
+  cache->num_models = 0;
+  cache->num_devices = 0;
+  cache->num_entries = 0;
+  cache->data_len = 0;
+}
+
+esp_err_t rdm_model_cache_install(dmx_port_t dmx_num,
+                                  const rdm_model_cache_config_t *config) {
+  RDM_MODEL_CACHE_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                        "dmx_num error");
+  RDM_MODEL_CACHE_CHECK(config != NULL, ESP_ERR_INVALID_ARG,
+                        "config is null");
+  RDM_MODEL_CACHE_CHECK(config->max_models > 0 &&
+                            config->max_models <= UINT16_MAX,
+                        ESP_ERR_INVALID_ARG, "max_models error");
+  RDM_MODEL_CACHE_CHECK(config->max_entries <= UINT16_MAX,
+                        ESP_ERR_INVALID_ARG, "max_entries error");
+  RDM_MODEL_CACHE_CHECK(config->max_data <= UINT16_MAX, ESP_ERR_INVALID_ARG,
+                        "max_data error");
+  RDM_MODEL_CACHE_CHECK(dmx_driver_is_installed(dmx_num),
+                        ESP_ERR_INVALID_STATE, "driver is not installed");
+  RDM_MODEL_CACHE_CHECK(rdm_model_cache[dmx_num] == NULL,
+                        ESP_ERR_INVALID_STATE,
+                        "model cache is already installed");
+
+  rdm_model_cache_t *cache = calloc(1, sizeof(rdm_model_cache_t));
+  if (cache == NULL) {
+    ESP_LOGE(TAG, "RDM model cache malloc error");
+    return ESP_ERR_NO_MEM;
+  }
+  cache->models = calloc(config->max_models, sizeof(*cache->models));
+  cache->devices = calloc(config->max_devices, sizeof(*cache->devices));
+  cache->entries = calloc(config->max_entries, sizeof(*cache->entries));
+  cache->data = malloc(config->max_data);
+  cache->mux = xSemaphoreCreateMutex();
+  if (cache->models == NULL ||
+      (config->max_devices > 0 && cache->devices == NULL) ||
+      (config->max_entries > 0 && cache->entries == NULL) ||
+      (config->max_data > 0 && cache->data == NULL) || cache->mux == NULL) {
+    ESP_LOGE(TAG, "RDM model cache table malloc error");
+    if (cache->mux != NULL) {
+      vSemaphoreDelete(cache->mux);
+    }
+    free(cache->data);
+    free(cache->entries);
+    free(cache->devices);
+    free(cache->models);
+    free(cache);
+    return ESP_ERR_NO_MEM;
+  }
+  cache->config = *config;
+
+  rdm_model_cache[dmx_num] = cache;
+  return ESP_OK;
+}
+
+esp_err_t rdm_model_cache_delete(dmx_port_t dmx_num) {
+  RDM_MODEL_CACHE_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                        "dmx_num error");
+  RDM_MODEL_CACHE_CHECK(rdm_model_cache[dmx_num] != NULL,
+                        ESP_ERR_INVALID_STATE, "model cache is not installed");
+
+  rdm_model_cache_t *cache = rdm_model_cache[dmx_num];
+  xSemaphoreTake(cache->mux, portMAX_DELAY);
+  rdm_model_cache[dmx_num] = NULL;
+  free(cache->data);
+  free(cache->entries);
+  free(cache->devices);
+  free(cache->models);
+  xSemaphoreGive(cache->mux);
+  vSemaphoreDelete(cache->mux);
+  free(cache);
+
+  return ESP_OK;
+}
+
+void rdm_model_cache_clear(dmx_port_t dmx_num) {
+  RDM_MODEL_CACHE_CHECK(dmx_num < DMX_NUM_MAX, , "dmx_num error");
+  RDM_MODEL_CACHE_CHECK(rdm_model_cache[dmx_num] != NULL, ,
+                        "model cache is not installed");
+
+  rdm_model_cache_t *const cache = rdm_model_cache[dmx_num];
+  xSemaphoreTake(cache->mux, portMAX_DELAY);
+  rdm_model_cache_reset(cache);
+  xSemaphoreGive(cache->mux);
+}
+
+// Returns the model index of a device, or -1 if the device is not known.
+static int rdm_model_cache_lookup(rdm_model_cache_t *cache, rdm_uid_t uid) {
+  xSemaphoreTake(cache->mux, portMAX_DELAY);
+  const int device_num = rdm_model_cache_find_device(cache, uid, NULL);
+  const int model = device_num < 0 ? -1 : cache->devices[device_num].model;
+  xSemaphoreGive(cache->mux);
+  return model;
+}
+
+// Sends GET DEVICE_INFO and remembers the model of the device.
+static int rdm_model_cache_interrogate(dmx_port_t dmx_num,
+                                       rdm_model_cache_t *cache,
+                                       rdm_uid_t uid) {
+  rdm_response_t response;
+  rdm_device_info_t device_info;
+  rdm_get_device_info(dmx_num, uid, RDM_ROOT_DEVICE, &response, &device_info);
+  if (response.err || response.type != RDM_RESPONSE_TYPE_ACK) {
+    return -1;
+  }
+  const rdm_model_key_t key = {
+      .manufacturer_id = uid >> 32,
+      .model_id = device_info.model_id,
+      .software_version_id = device_info.software_version_id};
+
+  xSemaphoreTake(cache->mux, portMAX_DELAY);
+  int model = rdm_model_cache_find_model(cache, &key);
+  if (model < 0) {
+    if (cache->num_models >= cache->config.max_models) {
+      xSemaphoreGive(cache->mux);
+      ESP_LOGW(TAG, "max number of models reached");
+      return -1;
+    }
+    model = cache->num_models;
+    cache->models[model] = key;
+    ++cache->num_models;
+  }
+
+  // Remember the device if there is room
+  size_t insert_at;
+  if (rdm_model_cache_find_device(cache, uid, &insert_at) < 0 &&
+      cache->num_devices < cache->config.max_devices) {
+    memmove(&cache->devices[insert_at + 1], &cache->devices[insert_at],
+            (cache->num_devices - insert_at) * sizeof(*cache->devices));
+    cache->devices[insert_at].uid = uid;
+    cache->devices[insert_at].model = model;
+    ++cache->num_devices;
+  }
+  xSemaphoreGive(cache->mux);
+
+  return model;
+}
+
+bool rdm_model_cache_get_key(dmx_port_t dmx_num, rdm_uid_t uid,
+                             rdm_model_key_t *key) {
+  RDM_MODEL_CACHE_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  RDM_MODEL_CACHE_CHECK(key != NULL, false, "key is null");
+  RDM_MODEL_CACHE_CHECK(rdm_model_cache[dmx_num] != NULL, false,
+                        "model cache is not installed");
+
+  rdm_model_cache_t *const cache = rdm_model_cache[dmx_num];
+  int model = rdm_model_cache_lookup(cache, uid);
+  if (model < 0) {
+    model = rdm_model_cache_interrogate(dmx_num, cache, uid);
+    if (model < 0) {
+      return false;
+    }
+  }
+
+  xSemaphoreTake(cache->mux, portMAX_DELAY);
+  *key = cache->models[model];
+  xSemaphoreGive(cache->mux);
+
+  return true;
+}
+
+size_t rdm_get_cached(dmx_port_t dmx_num, rdm_uid_t uid,
+                      rdm_sub_device_t sub_device, rdm_pid_t pid,
+                      const void *param, size_t param_len,
+                      rdm_response_t *response, void *pd, size_t size) {
+  RDM_MODEL_CACHE_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  RDM_MODEL_CACHE_CHECK(response != NULL, 0, "response is null");
+  RDM_MODEL_CACHE_CHECK(param != NULL || param_len == 0, 0, "param is null");
+  RDM_MODEL_CACHE_CHECK(pd != NULL || size == 0, 0, "pd is null");
+  RDM_MODEL_CACHE_CHECK(rdm_model_cache[dmx_num] != NULL, 0,
+                        "model cache is not installed");
+
+  // Only model-static requests to the root device are cached
+  rdm_model_cache_t *const cache = rdm_model_cache[dmx_num];
+  if (sub_device != RDM_ROOT_DEVICE || rdm_uid_is_broadcast(uid) ||
+      param_len > RDM_MODEL_CACHE_MAX_PARAM_LEN ||
+      !rdm_pid_is_model_static(pid)) {
+    return rdm_get_generic(dmx_num, uid, sub_device, pid, param, param_len,
+                           response, pd, size);
+  }
+
+  int model = rdm_model_cache_lookup(cache, uid);
+  if (model < 0) {
+    model = rdm_model_cache_interrogate(dmx_num, cache, uid);
+    if (model < 0) {
+      return rdm_get_generic(dmx_num, uid, sub_device, pid, param, param_len,
+                             response, pd, size);
+    }
+  }
+
+  // Answer the request from the cache if possible
+  xSemaphoreTake(cache->mux, portMAX_DELAY);
+  const int entry_num =
+      rdm_model_cache_find_entry(cache, model, pid, param, param_len, NULL);
+  if (entry_num >= 0) {
+    const rdm_model_cache_entry_t *entry = &cache->entries[entry_num];
+    const size_t pdl = entry->pdl;
+    memcpy(pd, &cache->data[entry->offset], pdl < size ? pdl : size);
+    xSemaphoreGive(cache->mux);
+    response->err = ESP_OK;
+    response->type = RDM_RESPONSE_TYPE_ACK;
+    response->num_params = pdl;
+    return pdl;
+  }
+  xSemaphoreGive(cache->mux);
+
+  // Send the request without holding the table lock
+  uint8_t data[RDM_MAX_PDL];
+  const size_t pdl = rdm_get_generic(dmx_num, uid, sub_device, pid, param,
+                                     param_len, response, data, sizeof(data));
+  if (pdl <= sizeof(data)) {
+    memcpy(pd, data, pdl < size ? pdl : size);
+  }
+  if (response->err || response->type != RDM_RESPONSE_TYPE_ACK ||
+      pdl > sizeof(data)) {
+    return pdl;
+  }
+
+  // Store the response
+  xSemaphoreTake(cache->mux, portMAX_DELAY);
+  size_t insert_at;
+  if (rdm_model_cache_find_entry(cache, model, pid, param, param_len,
+                                 &insert_at) < 0) {
+    if (cache->num_entries >= cache->config.max_entries ||
+        cache->data_len + pdl > cache->config.max_data) {
+      ESP_LOGD(TAG, "model cache is full");
+    } else {
+      memmove(&cache->entries[insert_at + 1], &cache->entries[insert_at],
+              (cache->num_entries - insert_at) * sizeof(*cache->entries));
+      rdm_model_cache_entry_t *entry = &cache->entries[insert_at];
+      memset(entry, 0, sizeof(*entry));
+      entry->model = model;
+      entry->pid = pid;
+      entry->param_len = param_len;
+      if (param_len > 0) {
+        memcpy(entry->param, param, param_len);
+      }
+      entry->pdl = pdl;
+      entry->offset = cache->data_len;
+      memcpy(&cache->data[cache->data_len], data, pdl);
+      cache->data_len += pdl;
+      ++cache->num_entries;
+    }
+  }
+  xSemaphoreGive(cache->mux);
+
+  return pdl;
+}
+
+size_t rdm_model_cache_save(dmx_port_t dmx_num, void *blob, size_t size) {
+  RDM_MODEL_CACHE_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  RDM_MODEL_CACHE_CHECK(rdm_model_cache[dmx_num] != NULL, 0,
+                        "model cache is not installed");
+
+  rdm_model_cache_t *const cache = rdm_model_cache[dmx_num];
+  xSemaphoreTake(cache->mux, portMAX_DELAY);
+  const size_t models_size = cache->num_models * sizeof(*cache->models);
+  const size_t entries_size = cache->num_entries * sizeof(*cache->entries);
+  const size_t blob_size = sizeof(rdm_model_cache_blob_t) + models_size +
+                           entries_size + cache->data_len;
+  if (blob == NULL) {
+    xSemaphoreGive(cache->mux);
+    return blob_size;
+  } else if (size < blob_size) {
+    xSemaphoreGive(cache->mux);
+    return 0;
+  }
+
+  const rdm_model_cache_blob_t header = {.magic = RDM_MODEL_CACHE_MAGIC,
+                                         .version = RDM_MODEL_CACHE_VERSION,
+                                         .num_models = cache->num_models,
+                                         .num_entries = cache->num_entries,
+                                         .data_len = cache->data_len};
+  uint8_t *ptr = blob;
+  memcpy(ptr, &header, sizeof(header));
+  ptr += sizeof(header);
+  memcpy(ptr, cache->models, models_size);
+  ptr += models_size;
+  memcpy(ptr, cache->entries, entries_size);
+  ptr += entries_size;
+  memcpy(ptr, cache->data, cache->data_len);
+  xSemaphoreGive(cache->mux);
+
+  return blob_size;
+}
+
+esp_err_t rdm_model_cache_load(dmx_port_t dmx_num, const void *blob,
+                               size_t size) {
+  RDM_MODEL_CACHE_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                        "dmx_num error");
+  RDM_MODEL_CACHE_CHECK(blob != NULL, ESP_ERR_INVALID_ARG, "blob is null");
+  RDM_MODEL_CACHE_CHECK(rdm_model_cache[dmx_num] != NULL,
+                        ESP_ERR_INVALID_STATE, "model cache is not installed");
+
+  // Validate the blob before modifying the cache
+  rdm_model_cache_blob_t header;
+  if (size < sizeof(header)) {
+    return ESP_ERR_INVALID_VERSION;
+  }
+  memcpy(&header, blob, sizeof(header));
+  const size_t models_size = header.num_models * sizeof(rdm_model_key_t);
+  const size_t entries_size =
+      header.num_entries * sizeof(rdm_model_cache_entry_t);
+  if (header.magic != RDM_MODEL_CACHE_MAGIC ||
+      header.version != RDM_MODEL_CACHE_VERSION ||
+      size != sizeof(header) + models_size + entries_size + header.data_len) {
+    return ESP_ERR_INVALID_VERSION;
+  }
+  const uint8_t *ptr = (const uint8_t *)blob + sizeof(header);
+  const rdm_model_cache_entry_t *entries =
+      (const void *)(ptr + models_size);
+  for (int i = 0; i < header.num_entries; ++i) {
+    rdm_model_cache_entry_t entry;
+    memcpy(&entry, &entries[i], sizeof(entry));
+    if (entry.model >= header.num_models ||
+        entry.param_len > RDM_MODEL_CACHE_MAX_PARAM_LEN ||
+        entry.offset + entry.pdl > header.data_len) {
+      return ESP_ERR_INVALID_VERSION;
+    }
+  }
+
+  rdm_model_cache_t *const cache = rdm_model_cache[dmx_num];
+  xSemaphoreTake(cache->mux, portMAX_DELAY);
+  if (header.num_models > cache->config.max_models ||
+      header.num_entries > cache->config.max_entries ||
+      header.data_len > cache->config.max_data) {
+    xSemaphoreGive(cache->mux);
+    return ESP_ERR_INVALID_SIZE;
+  }
+  rdm_model_cache_reset(cache);
+  memcpy(cache->models, ptr, models_size);
+  ptr += models_size;
+  memcpy(cache->entries, ptr, entries_size);
+  ptr += entries_size;
+  memcpy(cache->data, ptr, header.data_len);
+  cache->num_models = header.num_models;
+  cache->num_entries = header.num_entries;
+  cache->data_len = header.data_len;
+  xSemaphoreGive(cache->mux);
+
+  return ESP_OK;
+}
@@ -0,0 +1,169 @@
+/**
+ * @file esp_rdm_model_cache.h
+ * @brief This file declares functions for the RDM device model cache. Many
+ * RDM parameters, such as SUPPORTED_PARAMETERS or DEVICE_MODEL_DESCRIPTION,
+ * are identical for every device of the same model and software version. The
+ * model cache stores the responses to these requests so that, once the first
+ * device of a model has been interrogated, requests to every other device of
+ * that model can be answered without using the RDM bus.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "esp_err.h"
+#include "rdm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Identifies a device model. Devices with the same model key are
+ * expected to respond identically to requests for model-static parameters.
+ */
+typedef struct rdm_model_key_t {
+  uint16_t manufacturer_id;      // The ESTA manufacturer ID from the device UID.
+  uint16_t model_id;             // The model ID reported in DEVICE_INFO.
+  uint32_t software_version_id;  // The software version ID reported in DEVICE_INFO.
+} rdm_model_key_t;
+
+/**
+ * @brief Configuration for the RDM device model cache.
+ */
+typedef struct rdm_model_cache_config_t {
+  size_t max_models;   // The maximum number of unique device models that may be cached.
+  size_t max_devices;  // The maximum number of device UIDs whose model is remembered.
+  size_t max_entries;  // The maximum number of cached responses across all models.
+  size_t max_data;     // The size in bytes of the pool used to store cached parameter data.
+} rdm_model_cache_config_t;
+
+/**
+ * @brief The default configuration for the RDM device model cache.
+ */
+#define RDM_MODEL_CACHE_DEFAULT_CONFIG \
+  {                                    \
+    .max_models = 8,                   \
+    .max_devices = 256,                \
+    .max_entries = 256,                \
+    .max_data = 8192,                  \
+  }
+
+/**
+ * @brief Installs the RDM device model cache on a DMX port. The DMX driver
+ * must be installed.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] config A pointer to the model cache configuration.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_NO_MEM if there is not enough memory.
+ * @retval ESP_ERR_INVALID_STATE if the model cache is already installed or the
+ * DMX driver is not installed.
+ */
+esp_err_t rdm_model_cache_install(dmx_port_t dmx_num,
+                                  const rdm_model_cache_config_t *config);
+
+/**
+ * @brief Uninstalls the RDM device model cache and frees its memory.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the model cache is not installed.
+ */
+esp_err_t rdm_model_cache_delete(dmx_port_t dmx_num);
+
+/**
+ * @brief Removes every cached model, device, and response.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void rdm_model_cache_clear(dmx_port_t dmx_num);
+
+/**
+ * @brief Returns true if the response to a GET request for the PID is
+ * identical for every device of the same model and software version.
+ *
+ * @param pid The parameter ID.
+ * @return true if responses to the PID may be cached.
+ * @return false if responses to the PID are specific to each device.
+ */
+bool rdm_pid_is_model_static(rdm_pid_t pid);
+
+/**
+ * @brief Gets the model key of a device. If the model of the device is not
+ * yet known, an RDM GET DEVICE_INFO request is sent to the device and the
+ * result is remembered.
+ *
+ * @param dmx_num The DMX port number.
+ * @param uid The UID of the device.
+ * @param[out] key A pointer into which to copy the model key.
+ * @return true if the model key was found.
+ * @return false if the device did not respond or on error.
+ */
+bool rdm_model_cache_get_key(dmx_port_t dmx_num, rdm_uid_t uid,
+                             rdm_model_key_t *key);
+
+/**
+ * @brief Sends an RDM GET request for an arbitrary PID, answering it from the
+ * model cache when possible. Acknowledged responses to model-static PIDs sent
+ * to the root device are added to the cache. Requests for other PIDs or
+ * sub-devices are always sent on the RDM bus.
+ *
+ * @param dmx_num The DMX port number.
+ * @param uid The UID of the device.
+ * @param sub_device The sub-device number.
+ * @param pid The parameter ID.
+ * @param[in] param Optional parameter data to send with the request.
+ * @param param_len The length of the parameter data to send.
+ * @param[out] response A pointer into which to store the RDM response summary.
+ * @param[out] pd A buffer into which to copy the response parameter data.
+ * @param size The size of the provided buffer.
+ * @return The parameter data length of the response, which may be larger than
+ * the number of bytes copied.
+ */
+size_t rdm_get_cached(dmx_port_t dmx_num, rdm_uid_t uid,
+                      rdm_sub_device_t sub_device, rdm_pid_t pid,
+                      const void *param, size_t param_len,
+                      rdm_response_t *response, void *pd, size_t size);
+
+/**
+ * @brief Serializes the cached models and responses into a blob so that they
+ * may be stored, for example in NVS, and restored after a reboot using
+ * rdm_model_cache_load(). Remembered device UIDs are not serialized.
+ *
+ * @note The blob is stored in native byte order and is intended to be loaded
+ * by the same firmware that created it.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] blob A buffer into which to serialize the cache, or NULL to
+ * query the required size.
+ * @param size The size of the provided buffer.
+ * @return The size of the serialized cache in bytes, or 0 if the buffer is too
+ * small or on error.
+ */
+size_t rdm_model_cache_save(dmx_port_t dmx_num, void *blob, size_t size);
+
+/**
+ * @brief Loads a blob created by rdm_model_cache_save() into the model cache,
+ * replacing its current contents.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] blob The serialized cache.
+ * @param size The size of the serialized cache.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_VERSION if the blob is not a valid model cache.
+ * @retval ESP_ERR_INVALID_SIZE if the blob does not fit in the model cache.
+ * @retval ESP_ERR_INVALID_STATE if the model cache is not installed.
+ */
+esp_err_t rdm_model_cache_load(dmx_port_t dmx_num, const void *blob,
+                               size_t size);
+
+#ifdef __cplusplus
+}
+#endif
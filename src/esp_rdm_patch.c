@@ -0,0 +1,291 @@
+#include "esp_rdm_patch.h"
+
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+
+// Used for argument checking at the beginning of each function.
+#define RDM_PATCH_CHECK(a, err_code, format, ...) \
+  ESP_RETURN_ON_FALSE(a, err_code, TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "rdm_patch";  // The log tagline for the file.
+
+enum {
+  RDM_PATCH_NUM_WORDS = (DMX_MAX_PACKET_SIZE + 31) / 32,  // The size of the occupancy bitmap.
+};
+
+static bool rdm_patch_config_is_valid(const rdm_patch_config_t *config) {
+  return config->first_address >= 1 &&
+         config->last_address < DMX_MAX_PACKET_SIZE &&
+         config->first_address <= config->last_address &&
+         config->attempts > 0;
+}
+
+// Returns true if every address in the span is free.
+static bool rdm_patch_span_is_free(const uint32_t *used, int start,
+                                   size_t len) {
+  for (size_t a = start; a < start + len; ++a) {
+    if (used[a / 32] & (1U << (a % 32))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void rdm_patch_span_reserve(uint32_t *used, int start, size_t len) {
+  for (size_t a = start; a < start + len; ++a) {
+    used[a / 32] |= 1U << (a % 32);
+  }
+}
+
+// Returns the lowest start address with room for the span, or -1.
+static int rdm_patch_find_span(const uint32_t *used, size_t len,
+                               const rdm_patch_config_t *config) {
+  for (int start = config->first_address;
+       start + (int)len - 1 <= config->last_address; ++start) {
+    if (rdm_patch_span_is_free(used, start, len)) {
+      return start;
+    }
+  }
+  return -1;
+}
+
+size_t rdm_patch_gather(dmx_port_t dmx_num, rdm_patch_device_t *devices,
+                        size_t num_devices, const rdm_patch_config_t *config) {
+  RDM_PATCH_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  RDM_PATCH_CHECK(devices != NULL || num_devices == 0, 0, "devices is null");
+  RDM_PATCH_CHECK(config != NULL, 0, "config is null");
+  RDM_PATCH_CHECK(dmx_driver_is_installed(dmx_num), 0,
+                  "driver is not installed");
+
+  for (size_t i = 0; i < num_devices; ++i) {
+    devices[i].footprint = 0;
+    devices[i].current_address = -1;
+    devices[i].start_address = -1;
+    devices[i].status = RDM_PATCH_NO_RESPONSE;
+  }
+
+  // Query every device once before retrying devices that did not respond
+  size_t num_gathered = 0;
+  for (int attempt = 0; attempt < config->attempts; ++attempt) {
+    bool retry_needed = false;
+    for (size_t i = 0; i < num_devices; ++i) {
+      rdm_patch_device_t *device = &devices[i];
+      if (device->status != RDM_PATCH_NO_RESPONSE) {
+        continue;
+      }
+
+      rdm_response_t response;
+      rdm_device_info_t device_info;
+      rdm_get_device_info(dmx_num, device->uid, RDM_ROOT_DEVICE, &response,
+                          &device_info);
+      if (!response.err && response.type == RDM_RESPONSE_TYPE_ACK) {
+        device->footprint = device_info.footprint;
+        device->current_address = device_info.start_address;
+        device->status = device->footprint > 0 ? RDM_PATCH_PENDING
+                                               : RDM_PATCH_NO_FOOTPRINT;
+        ++num_gathered;
+      } else if (response.type == RDM_RESPONSE_TYPE_NACK_REASON) {
+        device->status = RDM_PATCH_NACK;
+        device->nack_reason = response.nack_reason;
+      } else {
+        retry_needed = true;
+      }
+    }
+    if (!retry_needed) {
+      break;
+    }
+  }
+
+  return num_gathered;
+}
+
+size_t rdm_patch_plan(rdm_patch_device_t *devices, size_t num_devices,
+                      const rdm_patch_config_t *config) {
+  RDM_PATCH_CHECK(devices != NULL || num_devices == 0, 0, "devices is null");
+  RDM_PATCH_CHECK(config != NULL, 0, "config is null");
+  RDM_PATCH_CHECK(rdm_patch_config_is_valid(config), 0, "config error");
+
+  uint32_t used[RDM_PATCH_NUM_WORDS];
+  memset(used, 0, sizeof(used));
+  for (size_t i = 0; i < num_devices; ++i) {
+    if (devices[i].status == RDM_PATCH_PENDING) {
+      devices[i].start_address = -1;
+    }
+  }
+
+  // Reserve fixed addresses first
+  size_t num_planned = 0;
+  for (size_t i = 0; i < num_devices; ++i) {
+    rdm_patch_device_t *device = &devices[i];
+    if (device->status != RDM_PATCH_PENDING || device->fixed_address <= 0) {
+      continue;
+    }
+    const int start = device->fixed_address;
+    if (start < config->first_address ||
+        start + (int)device->footprint - 1 > config->last_address) {
+      device->status = RDM_PATCH_NO_SPACE;
+    } else if (!rdm_patch_span_is_free(used, start, device->footprint)) {
+      device->status = RDM_PATCH_CONFLICT;
+    } else {
+      rdm_patch_span_reserve(used, start, device->footprint);
+      device->start_address = start;
+      ++num_planned;
+    }
+  }
+
+  // Place groups and ungrouped devices in the order in which they are listed
+  for (size_t i = 0; i < num_devices; ++i) {
+    rdm_patch_device_t *device = &devices[i];
+    if (device->status != RDM_PATCH_PENDING || device->start_address > 0) {
+      continue;
+    }
+
+    // Sum the footprint of the device's group
+    size_t span = 0;
+    for (size_t j = i; j < num_devices; ++j) {
+      const rdm_patch_device_t *member = &devices[j];
+      if ((j == i || (device->group != 0 && member->group == device->group)) &&
+          member->status == RDM_PATCH_PENDING && member->fixed_address <= 0) {
+        span += member->footprint;
+      }
+    }
+
+    // Assign consecutive addresses to each member of the group
+    int start = rdm_patch_find_span(used, span, config);
+    if (start > 0) {
+      rdm_patch_span_reserve(used, start, span);
+    }
+    for (size_t j = i; j < num_devices; ++j) {
+      rdm_patch_device_t *member = &devices[j];
+      if ((j == i || (device->group != 0 && member->group == device->group)) &&
+          member->status == RDM_PATCH_PENDING && member->fixed_address <= 0) {
+        if (start > 0) {
+          member->start_address = start;
+          start += member->footprint;
+          ++num_planned;
+        } else {
+          member->status = RDM_PATCH_NO_SPACE;
+        }
+      }
+    }
+  }
+
+  return num_planned;
+}
+
+size_t rdm_patch_apply(dmx_port_t dmx_num, rdm_patch_device_t *devices,
+                       size_t num_devices, const rdm_patch_config_t *config) {
+  RDM_PATCH_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  RDM_PATCH_CHECK(devices != NULL || num_devices == 0, 0, "devices is null");
+  RDM_PATCH_CHECK(config != NULL, 0, "config is null");
+  RDM_PATCH_CHECK(dmx_driver_is_installed(dmx_num), 0,
+                  "driver is not installed");
+
+  /* RDM is half-duplex so requests cannot overlap on the bus. Instead, each
+  pass sends requests back-to-back and only devices that failed are retried in
+  the next pass. Devices which are already at their planned address are not
+  sent a SET request. */
+  for (int attempt = 0; attempt < config->attempts; ++attempt) {
+    bool retry_needed = false;
+
+    // Send SET requests to devices that need a new start address
+    for (size_t i = 0; i < num_devices; ++i) {
+      rdm_patch_device_t *device = &devices[i];
+      if (device->status != RDM_PATCH_PENDING || device->start_address <= 0 ||
+          device->current_address == device->start_address) {
+        continue;
+      }
+
+      rdm_response_t response;
+      rdm_set_dmx_start_address(dmx_num, device->uid, RDM_ROOT_DEVICE,
+                                &response, device->start_address);
+      if (!response.err && response.type == RDM_RESPONSE_TYPE_ACK) {
+        device->current_address = device->start_address;
+      } else if (response.type == RDM_RESPONSE_TYPE_NACK_REASON) {
+        device->status = RDM_PATCH_NACK;
+        device->nack_reason = response.nack_reason;
+      } else {
+        retry_needed = true;
+      }
+    }
+
+    // Verify the start address of each device that was set
+    for (size_t i = 0; i < num_devices; ++i) {
+      rdm_patch_device_t *device = &devices[i];
+      if (device->status != RDM_PATCH_PENDING || device->start_address <= 0 ||
+          device->current_address != device->start_address) {
+        continue;
+      } else if (!config->verify) {
+        device->status = RDM_PATCH_OK;
+        continue;
+      }
+
+      rdm_response_t response;
+      int start_address;
+      rdm_get_dmx_start_address(dmx_num, device->uid, RDM_ROOT_DEVICE,
+                                &response, &start_address);
+      if (!response.err && response.type == RDM_RESPONSE_TYPE_ACK) {
+        device->status = start_address == device->start_address
+                             ? RDM_PATCH_OK
+                             : RDM_PATCH_VERIFY_FAILED;
+        device->current_address = start_address;
+      } else if (response.type == RDM_RESPONSE_TYPE_NACK_REASON) {
+        device->status = RDM_PATCH_NACK;
+        device->nack_reason = response.nack_reason;
+      } else {
+        retry_needed = true;
+      }
+    }
+
+    if (!retry_needed) {
+      break;
+    }
+  }
+
+  // Report devices which ran out of attempts
+  size_t num_patched = 0;
+  for (size_t i = 0; i < num_devices; ++i) {
+    rdm_patch_device_t *device = &devices[i];
+    if (device->status == RDM_PATCH_PENDING && device->start_address > 0) {
+      device->status = RDM_PATCH_NO_RESPONSE;
+    } else if (device->status == RDM_PATCH_OK) {
+      ++num_patched;
+    }
+    if (device->status != RDM_PATCH_OK &&
+        device->status != RDM_PATCH_NO_FOOTPRINT) {
+      ESP_LOGW(TAG, "unable to patch " UIDSTR ": status %i",
+               UID2STR(device->uid), device->status);
+    }
+  }
+
+  return num_patched;
+}
+
+esp_err_t rdm_patch_fleet(dmx_port_t dmx_num, rdm_patch_device_t *devices,
+                          size_t num_devices,
+                          const rdm_patch_config_t *config) {
+  RDM_PATCH_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG, "dmx_num error");
+  RDM_PATCH_CHECK(devices != NULL || num_devices == 0, ESP_ERR_INVALID_ARG,
+                  "devices is null");
+  RDM_PATCH_CHECK(config != NULL, ESP_ERR_INVALID_ARG, "config is null");
+  RDM_PATCH_CHECK(rdm_patch_config_is_valid(config), ESP_ERR_INVALID_ARG,
+                  "config error");
+  RDM_PATCH_CHECK(dmx_driver_is_installed(dmx_num), ESP_ERR_INVALID_ARG,
+                  "driver is not installed");
+
+  rdm_patch_gather(dmx_num, devices, num_devices, config);
+  rdm_patch_plan(devices, num_devices, config);
+  rdm_patch_apply(dmx_num, devices, num_devices, config);
+
+  for (size_t i = 0; i < num_devices; ++i) {
+    if (devices[i].status != RDM_PATCH_OK &&
+        devices[i].status != RDM_PATCH_NO_FOOTPRINT) {
+      return ESP_FAIL;
+    }
+  }
+  return ESP_OK;
+}
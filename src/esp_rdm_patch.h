@@ -0,0 +1,135 @@
+/**
+ * @file esp_rdm_patch.h
+ * @brief This file declares functions for the RDM patch planner. The patch
+ * planner gathers the DMX footprint of each device in a discovered fleet,
+ * computes a packed layout of non-overlapping DMX start addresses, sends the
+ * resulting DMX_START_ADDRESS SET requests, and verifies that each device
+ * accepted its new address.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "esp_err.h"
+#include "rdm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The patch result of a single device.
+ */
+typedef enum rdm_patch_status_t {
+  RDM_PATCH_PENDING,          // The device has not been patched yet.
+  RDM_PATCH_OK,               // The device is patched at its planned start address.
+  RDM_PATCH_NO_FOOTPRINT,     // The device has a footprint of 0 and does not need a start address.
+  RDM_PATCH_NO_RESPONSE,      // The device did not respond.
+  RDM_PATCH_NACK,             // The device responded with a NACK.
+  RDM_PATCH_NO_SPACE,         // There was not enough room in the universe for the device.
+  RDM_PATCH_CONFLICT,         // The device's fixed address overlaps another fixed address.
+  RDM_PATCH_VERIFY_FAILED,    // The device acknowledged the SET but reported a different start address.
+} rdm_patch_status_t;
+
+/**
+ * @brief A device to be patched. The application fills in the UID and
+ * constraints; the patch planner fills in the remaining fields.
+ */
+typedef struct rdm_patch_device_t {
+  rdm_uid_t uid;              // The UID of the device.
+  int fixed_address;          // The start address at which the device must be patched, or 0 to let the planner choose.
+  uint16_t group;             // Devices with the same non-zero group are patched contiguously, in the order they are listed.
+  size_t footprint;           // The DMX footprint of the device. Filled in by rdm_patch_gather().
+  int current_address;        // The start address of the device when its footprint was gathered.
+  int start_address;          // The planned start address of the device. Filled in by rdm_patch_plan().
+  rdm_patch_status_t status;  // The patch result of the device.
+  rdm_nr_t nack_reason;       // The NACK reason when the status is RDM_PATCH_NACK.
+} rdm_patch_device_t;
+
+/**
+ * @brief Configuration for the RDM patch planner.
+ */
+typedef struct rdm_patch_config_t {
+  int first_address;  // The lowest start address that may be assigned.
+  int last_address;   // The highest DMX address that may be occupied.
+  uint8_t attempts;   // The number of times a request is attempted before the device is marked as failed.
+  bool verify;        // Set to true to read back the start address of each device after it is set.
+} rdm_patch_config_t;
+
+/**
+ * @brief The default configuration for the RDM patch planner, which patches
+ * the whole universe.
+ */
+#define RDM_PATCH_DEFAULT_CONFIG \
+  {                              \
+    .first_address = 1,          \
+    .last_address = 512,         \
+    .attempts = 3,               \
+    .verify = true,              \
+  }
+
+/**
+ * @brief Gathers the DMX footprint and current start address of each device
+ * with back-to-back GET DEVICE_INFO requests. Devices that do not respond are
+ * retried after every other device has been queried.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[inout] devices The devices to query.
+ * @param num_devices The number of devices.
+ * @param[in] config A pointer to the patch configuration.
+ * @return The number of devices whose footprint was gathered.
+ */
+size_t rdm_patch_gather(dmx_port_t dmx_num, rdm_patch_device_t *devices,
+                        size_t num_devices, const rdm_patch_config_t *config);
+
+/**
+ * @brief Computes a packed, non-overlapping layout of start addresses. Fixed
+ * addresses are reserved first. Groups and ungrouped devices are then placed
+ * in the order in which they are listed at the lowest address with enough
+ * room. This function does not send any RDM requests.
+ *
+ * @param[inout] devices The devices to plan. Devices that failed to gather
+ * their footprint are skipped.
+ * @param num_devices The number of devices.
+ * @param[in] config A pointer to the patch configuration.
+ * @return The number of devices that were assigned a start address.
+ */
+size_t rdm_patch_plan(rdm_patch_device_t *devices, size_t num_devices,
+                      const rdm_patch_config_t *config);
+
+/**
+ * @brief Sends a DMX_START_ADDRESS SET request to each planned device whose
+ * current start address differs from its planned start address, then
+ * optionally verifies each address with a GET request. Failed requests are
+ * retried after every other device has been sent its request.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[inout] devices The planned devices.
+ * @param num_devices The number of devices.
+ * @param[in] config A pointer to the patch configuration.
+ * @return The number of devices that were successfully patched.
+ */
+size_t rdm_patch_apply(dmx_port_t dmx_num, rdm_patch_device_t *devices,
+                       size_t num_devices, const rdm_patch_config_t *config);
+
+/**
+ * @brief Gathers, plans, and applies a patch in a single call.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[inout] devices The devices to patch.
+ * @param num_devices The number of devices.
+ * @param[in] config A pointer to the patch configuration.
+ * @retval ESP_OK if every device with a footprint was patched.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_FAIL if one or more devices could not be patched. The status of
+ * each device reports the reason.
+ */
+esp_err_t rdm_patch_fleet(dmx_port_t dmx_num, rdm_patch_device_t *devices,
+                          size_t num_devices, const rdm_patch_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
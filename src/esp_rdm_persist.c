@@ -0,0 +1,370 @@
+#include "esp_rdm_persist.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_rdm_client.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "nvs.h"
+#include "rdm_types.h"
+
+// Used for argument checking at the beginning of each function.
+#define RDM_PERSIST_CHECK(a, err_code, format, ...) \
+  ESP_RETURN_ON_FALSE(a, err_code, TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "rdm_persist";  // The log tagline for the file.
+
+enum {
+  RDM_PERSIST_VERSION = 1,          // The version of the stored record format.
+  RDM_PERSIST_MAX_LABEL_LEN = 32,   // The maximum length of the device label.
+  RDM_PERSIST_KEY_SIZE = 16,        // The maximum size of an NVS key, including the null terminator.
+};
+
+/* The stored record of a port. Only device_label_len bytes of the device label
+are stored, so a record is between 6 and 38 bytes and fits in a single NVS
+entry. Fields which are not set in the fields mask are ignored when loaded. */
+typedef struct __attribute__((packed)) rdm_persist_record_t {
+  uint8_t version;           // Must be RDM_PERSIST_VERSION.
+  uint8_t fields;            // A mask of rdm_persist_field_t of the stored parameters.
+  uint16_t start_address;    // The DMX start address.
+  uint8_t personality;       // The current DMX personality.
+  uint8_t device_label_len;  // The length of the device label.
+  char device_label[RDM_PERSIST_MAX_LABEL_LEN];  // The device label, which is not null-terminated.
+} rdm_persist_record_t;
+
+#define RDM_PERSIST_HEADER_SIZE offsetof(rdm_persist_record_t, device_label)
+
+typedef struct rdm_persist_t {
+  nvs_handle_t nvs;               // The handle of the NVS namespace.
+  char key[RDM_PERSIST_KEY_SIZE];  // The NVS key of the record of the port.
+  esp_timer_handle_t timer;       // The one-shot timer of the commit window.
+  TaskHandle_t task;              // The task which writes the record to flash.
+  SemaphoreHandle_t stopped;      // Given by the task when it exits.
+  bool is_stopping;               // True when the task should exit.
+  uint64_t commit_delay_us;       // The length of the commit window.
+  uint32_t fields;                // A mask of rdm_persist_field_t of the persisted parameters.
+  SemaphoreHandle_t mux;          // Serializes flash writes.
+  spinlock_t spinlock;            // Protects the pending record and the dirty mask.
+  uint32_t dirty;                 // The fields which changed since the last commit.
+  rdm_persist_record_t pending;   // The latest parameters of the RDM client.
+  rdm_persist_record_t stored;    // The record which is stored in flash.
+  size_t stored_size;             // The size of the stored record, or 0 if there is none.
+} rdm_persist_t;
+
+static rdm_persist_t *rdm_persist[DMX_NUM_MAX] = {0};
+
+static size_t rdm_persist_record_size(const rdm_persist_record_t *record) {
+  return RDM_PERSIST_HEADER_SIZE + record->device_label_len;
+}
+
+static bool rdm_persist_record_is_valid(const rdm_persist_record_t *record,
+                                        size_t size) {
+  return size >= RDM_PERSIST_HEADER_SIZE &&
+         record->version == RDM_PERSIST_VERSION &&
+         record->device_label_len <= RDM_PERSIST_MAX_LABEL_LEN &&
+         size == rdm_persist_record_size(record);
+}
+
+// Copies parameters of the RDM client into a record.
+static void rdm_persist_copy_fields(dmx_port_t dmx_num,
+                                    rdm_persist_record_t *record,
+                                    uint32_t fields) {
+  const rdm_parameters_t *params = &rdm_parameters[dmx_num];
+  if (fields & RDM_PERSIST_START_ADDRESS) {
+    record->start_address = params->device_info.start_address;
+  }
+  if (fields & RDM_PERSIST_PERSONALITY) {
+    record->personality = params->device_info.current_personality;
+  }
+  if (fields & RDM_PERSIST_DEVICE_LABEL) {
+    size_t len = params->device_label_len;
+    if (len > RDM_PERSIST_MAX_LABEL_LEN) {
+      len = RDM_PERSIST_MAX_LABEL_LEN;
+    }
+    memset(record->device_label, 0, sizeof(record->device_label));
+    memcpy(record->device_label, params->device_label, len);
+    record->device_label_len = len;
+  }
+}
+
+// Applies the parameters of a stored record to the RDM client.
+static void rdm_persist_apply(dmx_port_t dmx_num,
+                              const rdm_persist_record_t *record,
+                              uint32_t fields) {
+  if (fields & RDM_PERSIST_START_ADDRESS) {
+    if (record->start_address >= 1 &&
+        record->start_address < DMX_MAX_PACKET_SIZE) {
+      rdm_client_set_start_address(dmx_num, record->start_address);
+    } else {
+      ESP_LOGW(TAG, "ignoring stored start address %i",
+               record->start_address);
+    }
+  }
+  if (fields & RDM_PERSIST_PERSONALITY) {
+    if (!rdm_client_set_personality(dmx_num, record->personality)) {
+      ESP_LOGW(TAG, "ignoring stored personality %i", record->personality);
+    }
+  }
+  if (fields & RDM_PERSIST_DEVICE_LABEL) {
+    rdm_parameters_t *params = &rdm_parameters[dmx_num];
+    memset(params->device_label, 0, sizeof(params->device_label));
+    memcpy(params->device_label, record->device_label,
+           record->device_label_len);
+    params->device_label_len = record->device_label_len;
+  }
+}
+
+// Writes the pending record to flash if it differs from the stored record.
+static esp_err_t rdm_persist_commit(rdm_persist_t *persist) {
+  xSemaphoreTake(persist->mux, portMAX_DELAY);
+  esp_timer_stop(persist->timer);
+
+  rdm_persist_record_t record;
+  taskENTER_CRITICAL(&persist->spinlock);
+  record = persist->pending;
+  const uint32_t dirty = persist->dirty;
+  persist->dirty = 0;
+  taskEXIT_CRITICAL(&persist->spinlock);
+
+  // Parameters which were changed and then changed back are not written
+  esp_err_t err = ESP_OK;
+  const size_t size = rdm_persist_record_size(&record);
+  if (dirty != 0 && (size != persist->stored_size ||
+                     memcmp(&record, &persist->stored, size) != 0)) {
+    err = nvs_set_blob(persist->nvs, persist->key, &record, size);
+    if (err == ESP_OK) {
+      err = nvs_commit(persist->nvs);
+    }
+    if (err == ESP_OK) {
+      persist->stored = record;
+      persist->stored_size = size;
+    } else {
+      ESP_LOGE(TAG, "unable to store parameters: %s", esp_err_to_name(err));
+      taskENTER_CRITICAL(&persist->spinlock);
+      persist->dirty |= dirty;
+      taskEXIT_CRITICAL(&persist->spinlock);
+      if (!__atomic_load_n(&persist->is_stopping, __ATOMIC_ACQUIRE)) {
+        esp_timer_start_once(persist->timer, persist->commit_delay_us);
+      }
+    }
+  }
+
+  xSemaphoreGive(persist->mux);
+  return err;
+}
+
+/* Flash writes can block for tens of milliseconds while a sector is erased,
+so they are made in a task of their own instead of in the esp_timer task,
+which would delay the callbacks of every other timer. */
+static void rdm_persist_task(void *arg) {
+  rdm_persist_t *const persist = arg;
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (__atomic_load_n(&persist->is_stopping, __ATOMIC_ACQUIRE)) {
+      break;
+    }
+    rdm_persist_commit(persist);
+  }
+
+  xSemaphoreGive(persist->stopped);
+  vTaskDelete(NULL);
+}
+
+static void rdm_persist_timer_cb(void *arg) {
+  rdm_persist_t *const persist = arg;
+  xTaskNotify(persist->task, 0, eIncrement);
+}
+
+esp_err_t rdm_persist_install(dmx_port_t dmx_num,
+                              const rdm_persist_config_t *config) {
+  RDM_PERSIST_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                    "dmx_num error");
+  RDM_PERSIST_CHECK(config != NULL, ESP_ERR_INVALID_ARG, "config is null");
+  RDM_PERSIST_CHECK(config->nvs_namespace != NULL, ESP_ERR_INVALID_ARG,
+                    "nvs_namespace is null");
+  RDM_PERSIST_CHECK(config->commit_delay_ms > 0, ESP_ERR_INVALID_ARG,
+                    "commit_delay_ms error");
+  RDM_PERSIST_CHECK((config->fields & ~RDM_PERSIST_ALL) == 0,
+                    ESP_ERR_INVALID_ARG, "fields error");
+  RDM_PERSIST_CHECK(rdm_persist[dmx_num] == NULL, ESP_ERR_INVALID_STATE,
+                    "persistence is already installed");
+
+  rdm_persist_t *persist = calloc(1, sizeof(rdm_persist_t));
+  if (persist == NULL) {
+    ESP_LOGE(TAG, "persistence malloc error");
+    return ESP_ERR_NO_MEM;
+  }
+  esp_err_t err = ESP_ERR_NO_MEM;
+  persist->mux = xSemaphoreCreateMutex();
+  persist->stopped = xSemaphoreCreateBinary();
+  if (persist->mux == NULL || persist->stopped == NULL) {
+    ESP_LOGE(TAG, "persistence mutex malloc error");
+    goto err;
+  }
+  portMUX_INITIALIZE(&persist->spinlock);
+  persist->commit_delay_us = (uint64_t)config->commit_delay_ms * 1000;
+  persist->fields = config->fields;
+  snprintf(persist->key, sizeof(persist->key), "rdm_port%i", dmx_num);
+
+  err = nvs_open(config->nvs_namespace, NVS_READWRITE, &persist->nvs);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "unable to open NVS namespace '%s': %s",
+             config->nvs_namespace, esp_err_to_name(err));
+    goto err;
+  }
+
+  if (xTaskCreatePinnedToCore(rdm_persist_task, "rdm_persist",
+                              config->stack_size, persist, config->priority,
+                              &persist->task, config->core_id) != pdPASS) {
+    ESP_LOGE(TAG, "persistence task create error");
+    err = ESP_ERR_NO_MEM;
+    goto err_task;
+  }
+
+  const esp_timer_create_args_t timer_args = {
+      .callback = rdm_persist_timer_cb,
+      .arg = persist,
+      .dispatch_method = ESP_TIMER_TASK,
+      .name = "rdm_persist",
+  };
+  err = esp_timer_create(&timer_args, &persist->timer);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "persistence timer error");
+    err = ESP_ERR_NO_MEM;
+    goto err_timer;
+  }
+
+  // Load the stored record with a single read
+  size_t size = sizeof(persist->stored);
+  err = nvs_get_blob(persist->nvs, persist->key, &persist->stored, &size);
+  if (err == ESP_OK && rdm_persist_record_is_valid(&persist->stored, size)) {
+    rdm_persist_apply(dmx_num, &persist->stored,
+                      persist->stored.fields & persist->fields);
+    persist->stored_size = size;
+  } else if (err == ESP_OK || err == ESP_ERR_NVS_INVALID_LENGTH) {
+    ESP_LOGW(TAG, "ignoring stored parameters of an unknown format");
+  } else if (err != ESP_ERR_NVS_NOT_FOUND) {
+    ESP_LOGW(TAG, "unable to load stored parameters: %s",
+             esp_err_to_name(err));
+  }
+
+  // Nothing is written until a parameter changes
+  persist->pending.version = RDM_PERSIST_VERSION;
+  persist->pending.fields = persist->fields;
+  rdm_persist_copy_fields(dmx_num, &persist->pending, persist->fields);
+
+  rdm_persist[dmx_num] = persist;
+
+  return ESP_OK;
+
+err_timer:
+  __atomic_store_n(&persist->is_stopping, true, __ATOMIC_RELEASE);
+  xTaskNotify(persist->task, 0, eIncrement);
+  xSemaphoreTake(persist->stopped, portMAX_DELAY);
+err_task:
+  nvs_close(persist->nvs);
+err:
+  if (persist->mux != NULL) {
+    vSemaphoreDelete(persist->mux);
+  }
+  if (persist->stopped != NULL) {
+    vSemaphoreDelete(persist->stopped);
+  }
+  free(persist);
+  return err;
+}
+
+esp_err_t rdm_persist_delete(dmx_port_t dmx_num) {
+  RDM_PERSIST_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                    "dmx_num error");
+  RDM_PERSIST_CHECK(rdm_persist[dmx_num] != NULL, ESP_ERR_INVALID_STATE,
+                    "persistence is not installed");
+
+  rdm_persist_flush(dmx_num);
+
+  rdm_persist_t *persist = rdm_persist[dmx_num];
+  rdm_persist[dmx_num] = NULL;
+
+  /* Once stopping, a failed commit does not restart the timer. Stopping the
+  timer under the mutex waits for a commit in the persistence task to finish,
+  so the timer cannot be restarted afterwards. */
+  __atomic_store_n(&persist->is_stopping, true, __ATOMIC_RELEASE);
+  xSemaphoreTake(persist->mux, portMAX_DELAY);
+  esp_timer_stop(persist->timer);
+  xSemaphoreGive(persist->mux);
+  xTaskNotify(persist->task, 0, eIncrement);
+  xSemaphoreTake(persist->stopped, portMAX_DELAY);
+  esp_timer_delete(persist->timer);
+
+  nvs_close(persist->nvs);
+  vSemaphoreDelete(persist->stopped);
+  vSemaphoreDelete(persist->mux);
+  free(persist);
+
+  return ESP_OK;
+}
+
+void rdm_persist_mark_dirty(dmx_port_t dmx_num, uint32_t fields) {
+  if (dmx_num >= DMX_NUM_MAX || rdm_persist[dmx_num] == NULL) {
+    return;
+  }
+  rdm_persist_t *const persist = rdm_persist[dmx_num];
+  fields &= persist->fields;
+  if (fields == 0) {
+    return;
+  }
+
+  taskENTER_CRITICAL(&persist->spinlock);
+  rdm_persist_copy_fields(dmx_num, &persist->pending, fields);
+  persist->dirty |= fields;
+  taskEXIT_CRITICAL(&persist->spinlock);
+
+  /* The commit window starts with the first change. Later changes within the
+  window are written with it, so the timer is not restarted. Starting a timer
+  which is already running fails with ESP_ERR_INVALID_STATE. */
+  esp_timer_start_once(persist->timer, persist->commit_delay_us);
+}
+
+esp_err_t rdm_persist_flush(dmx_port_t dmx_num) {
+  RDM_PERSIST_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                    "dmx_num error");
+  RDM_PERSIST_CHECK(rdm_persist[dmx_num] != NULL, ESP_ERR_INVALID_STATE,
+                    "persistence is not installed");
+
+  return rdm_persist_commit(rdm_persist[dmx_num]);
+}
+
+esp_err_t rdm_persist_erase(dmx_port_t dmx_num) {
+  RDM_PERSIST_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                    "dmx_num error");
+  RDM_PERSIST_CHECK(rdm_persist[dmx_num] != NULL, ESP_ERR_INVALID_STATE,
+                    "persistence is not installed");
+
+  rdm_persist_t *const persist = rdm_persist[dmx_num];
+  xSemaphoreTake(persist->mux, portMAX_DELAY);
+  esp_timer_stop(persist->timer);
+  taskENTER_CRITICAL(&persist->spinlock);
+  persist->dirty = 0;
+  taskEXIT_CRITICAL(&persist->spinlock);
+
+  esp_err_t err = nvs_erase_key(persist->nvs, persist->key);
+  if (err == ESP_ERR_NVS_NOT_FOUND) {
+    err = ESP_OK;
+  }
+  if (err == ESP_OK) {
+    err = nvs_commit(persist->nvs);
+  }
+  if (err == ESP_OK) {
+    persist->stored_size = 0;
+  }
+
+  xSemaphoreGive(persist->mux);
+  return err;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file esp_rdm_persist.h
+ * @brief This file declares functions for persisting the parameters of the
+ * RDM client in NVS. Parameters which are changed by SET requests are copied
+ * into a compact record in RAM and marked dirty. The record is written to
+ * flash once per commit window by a task of its own, so a controller which sweeps a parameter
+ * causes a single flash write instead of one per request, and SET responses
+ * are never delayed by flash writes.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The parameters which are persisted. Used as a bitmask.
+ */
+typedef enum rdm_persist_field_t {
+  RDM_PERSIST_START_ADDRESS = 1 << 0,  // The DMX start address.
+  RDM_PERSIST_PERSONALITY = 1 << 1,    // The current DMX personality.
+  RDM_PERSIST_DEVICE_LABEL = 1 << 2,   // The device label.
+  RDM_PERSIST_ALL = RDM_PERSIST_START_ADDRESS | RDM_PERSIST_PERSONALITY |
+                    RDM_PERSIST_DEVICE_LABEL,
+} rdm_persist_field_t;
+
+/**
+ * @brief Configuration for RDM parameter persistence.
+ */
+typedef struct rdm_persist_config_t {
+  const char *nvs_namespace;  // The NVS namespace in which the parameters are stored. At most 15 characters.
+  uint32_t commit_delay_ms;   // The time from the first change until the parameters are written to flash.
+  uint32_t fields;            // A mask of rdm_persist_field_t which selects the parameters that are persisted.
+  UBaseType_t priority;       // The priority of the task which writes the parameters to flash.
+  BaseType_t core_id;         // The core to which the task is pinned, or tskNO_AFFINITY.
+  uint32_t stack_size;        // The stack size of the task in bytes.
+} rdm_persist_config_t;
+
+/**
+ * @brief The default configuration for RDM parameter persistence.
+ */
+#define RDM_PERSIST_DEFAULT_CONFIG    \
+  {                                   \
+    .nvs_namespace = "esp_dmx",       \
+    .commit_delay_ms = 2000,          \
+    .fields = RDM_PERSIST_ALL,        \
+    .priority = tskIDLE_PRIORITY + 1, \
+    .core_id = tskNO_AFFINITY,        \
+    .stack_size = 3072,               \
+  }
+
+/**
+ * @brief Installs parameter persistence on a DMX port, then loads the stored
+ * parameters and applies them to the RDM client. Must be called after
+ * rdm_client_init() and after the personalities of the device have been
+ * added. NVS must have been initialized with nvs_flash_init(). Stored values
+ * which are no longer valid, such as a personality which no longer exists,
+ * are ignored. The callbacks of the RDM client are not invoked, so the
+ * application should read the loaded parameters from rdm_parameters.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] config A pointer to the persistence configuration.
+ * @retval ESP_OK on success, or if no parameters were stored yet.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if persistence is already installed.
+ * @retval ESP_ERR_NO_MEM if there is not enough memory.
+ * @retval Other errors from nvs_open() if the NVS namespace cannot be opened.
+ */
+esp_err_t rdm_persist_install(dmx_port_t dmx_num,
+                              const rdm_persist_config_t *config);
+
+/**
+ * @brief Writes any pending changes to flash and uninstalls parameter
+ * persistence. Must not be called while the RDM responder task is running.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if persistence is not installed.
+ */
+esp_err_t rdm_persist_delete(dmx_port_t dmx_num);
+
+/**
+ * @brief Copies parameters of the RDM client into the pending record and
+ * starts the commit window if it is not already running. This is called by
+ * the RDM client whenever a persisted parameter changes and does nothing if
+ * persistence is not installed. It does not access flash.
+ *
+ * @param dmx_num The DMX port number.
+ * @param fields A mask of rdm_persist_field_t of the parameters that changed.
+ */
+void rdm_persist_mark_dirty(dmx_port_t dmx_num, uint32_t fields);
+
+/**
+ * @brief Writes pending changes to flash immediately, e.g. before a restart.
+ * Nothing is written if the pending record is identical to the stored record.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if persistence is not installed.
+ * @retval Other errors from nvs_set_blob() or nvs_commit().
+ */
+esp_err_t rdm_persist_flush(dmx_port_t dmx_num);
+
+/**
+ * @brief Erases the stored parameters of a DMX port. The parameters of the
+ * RDM client in RAM are not changed.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if persistence is not installed.
+ * @retval Other errors from nvs_erase_key() or nvs_commit().
+ */
+esp_err_t rdm_persist_erase(dmx_port_t dmx_num);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,434 @@
+#include "esp_rdm_poller.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// Used for argument checking at the beginning of each function.
+#define RDM_POLLER_CHECK(a, err_code, format, ...) \
+  ESP_RETURN_ON_FALSE(a, err_code, TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "rdm_poller";  // The log tagline for the file.
+
+enum {
+  RDM_POLLER_NOT_A_MEMBER = -1,  // Entry next_due value for non-member devices.
+};
+
+// The polling state of a single device.
+typedef struct rdm_poller_device_t {
+  rdm_uid_t uid;          // The UID of the device.
+  int64_t next_allowed;   // The earliest time the device may be sent a request.
+  int64_t backoff_until;  // The time until which the device is skipped.
+  uint8_t failures;       // The number of consecutive lost responses.
+} rdm_poller_device_t;
+
+// A single cell in the result table.
+typedef struct rdm_poller_entry_t {
+  int64_t next_due;   // The time the entry is next due, or -1 if not a member.
+  int64_t timestamp;  // The time of the last acknowledged response.
+  esp_err_t err;      // The error of the last request.
+  int16_t type;       // The rdm_response_type_t of the last response.
+  uint16_t nack;      // The NACK reason of the last response.
+  uint8_t pdl;        // The parameter data length of the last response.
+} rdm_poller_entry_t;
+
+// A polling job. Its entries and data are indexed by device number.
+typedef struct rdm_poller_job_t {
+  rdm_pid_t pid;              // The PID to request.
+  uint32_t interval;          // The polling interval in microseconds.
+  size_t max_pdl;             // The stride of the job's data table.
+  rdm_poller_entry_t *entry;  // One entry per device.
+  uint8_t *data;              // Parameter data, max_pdl bytes per device.
+} rdm_poller_job_t;
+
+typedef struct rdm_poller_t {
+  SemaphoreHandle_t mux;         // Protects the tables from concurrent access.
+  rdm_poller_config_t config;    // The poller configuration.
+  size_t num_devices;            // The number of unique devices.
+  rdm_poller_device_t *devices;  // Devices in the order they were added.
+  uint16_t *sorted;              // Device numbers sorted by UID.
+  size_t num_jobs;               // The number of registered jobs.
+  rdm_poller_job_t *jobs;        // The registered jobs.
+  size_t cursor;                 // The device to consider first.
+  int64_t last_dmx_ts;           // The time the last DMX packet was sent.
+  uint32_t num_users;            // The number of calls which are using the poller.
+} rdm_poller_t;
+
+static rdm_poller_t *rdm_poller[DMX_NUM_MAX] = {0};
+static spinlock_t rdm_poller_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Returns the poller of a port and marks it in use, or returns NULL if it is
+not installed. rdm_poller_delete() refuses to free a poller which is in use, so
+it stays valid until rdm_poller_release() is called. */
+static rdm_poller_t *rdm_poller_acquire(dmx_port_t dmx_num) {
+  taskENTER_CRITICAL(&rdm_poller_spinlock);
+  rdm_poller_t *const poller = rdm_poller[dmx_num];
+  if (poller != NULL) {
+    ++poller->num_users;
+  }
+  taskEXIT_CRITICAL(&rdm_poller_spinlock);
+  return poller;
+}
+
+static void rdm_poller_release(rdm_poller_t *poller) {
+  taskENTER_CRITICAL(&rdm_poller_spinlock);
+  --poller->num_users;
+  taskEXIT_CRITICAL(&rdm_poller_spinlock);
+}
+
+static int rdm_poller_find_device(const rdm_poller_t *poller, rdm_uid_t uid,
+                                  size_t *insert_at) {
+  // Binary search the sorted device index
+  size_t lo = 0;
+  size_t hi = poller->num_devices;
+  while (lo < hi) {
+    const size_t mid = (lo + hi) / 2;
+    const rdm_uid_t mid_uid = poller->devices[poller->sorted[mid]].uid;
+    if (mid_uid == uid) {
+      return poller->sorted[mid];
+    } else if (mid_uid < uid) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (insert_at != NULL) {
+    *insert_at = lo;
+  }
+  return -1;
+}
+
+static int rdm_poller_add_device(rdm_poller_t *poller, rdm_uid_t uid) {
+  size_t insert_at;
+  int device_num = rdm_poller_find_device(poller, uid, &insert_at);
+  if (device_num >= 0) {
+    return device_num;
+  } else if (poller->num_devices >= poller->config.max_devices) {
+    return -1;
+  }
+
+  // Append the device and insert it into the sorted index
+  device_num = poller->num_devices;
+  rdm_poller_device_t *device = &poller->devices[device_num];
+  device->uid = uid;
+  device->next_allowed = 0;
+  device->backoff_until = 0;
+  device->failures = 0;
+  memmove(&poller->sorted[insert_at + 1], &poller->sorted[insert_at],
+          (poller->num_devices - insert_at) * sizeof(*poller->sorted));
+  poller->sorted[insert_at] = device_num;
+  ++poller->num_devices;
+
+  // Existing jobs do not poll the new device
+  for (size_t j = 0; j < poller->num_jobs; ++j) {
+    poller->jobs[j].entry[device_num].next_due = RDM_POLLER_NOT_A_MEMBER;
+  }
+
+  return device_num;
+}
+
+esp_err_t rdm_poller_install(dmx_port_t dmx_num,
+                             const rdm_poller_config_t *config) {
+  RDM_POLLER_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG, "dmx_num error");
+  RDM_POLLER_CHECK(config != NULL, ESP_ERR_INVALID_ARG, "config is null");
+  RDM_POLLER_CHECK(config->max_devices > 0 && config->max_devices <= UINT16_MAX,
+                   ESP_ERR_INVALID_ARG, "max_devices error");
+  RDM_POLLER_CHECK(config->max_jobs > 0, ESP_ERR_INVALID_ARG,
+                   "max_jobs error");
+  RDM_POLLER_CHECK(config->dmx_refresh_us == 0 || config->dmx_data != NULL,
+                   ESP_ERR_INVALID_ARG, "dmx_data is null");
+  RDM_POLLER_CHECK(config->dmx_size <= DMX_MAX_PACKET_SIZE,
+                   ESP_ERR_INVALID_ARG, "dmx_size error");
+  RDM_POLLER_CHECK(dmx_driver_is_installed(dmx_num), ESP_ERR_INVALID_STATE,
+                   "driver is not installed");
+  RDM_POLLER_CHECK(rdm_poller[dmx_num] == NULL, ESP_ERR_INVALID_STATE,
+                   "poller is already installed");
+
+  rdm_poller_t *poller = calloc(1, sizeof(rdm_poller_t));
+  if (poller == NULL) {
+    ESP_LOGE(TAG, "RDM poller malloc error");
+    return ESP_ERR_NO_MEM;
+  }
+  poller->devices = calloc(config->max_devices, sizeof(*poller->devices));
+  poller->sorted = calloc(config->max_devices, sizeof(*poller->sorted));
+  poller->jobs = calloc(config->max_jobs, sizeof(*poller->jobs));
+  poller->mux = xSemaphoreCreateMutex();
+  if (poller->devices == NULL || poller->sorted == NULL ||
+      poller->jobs == NULL || poller->mux == NULL) {
+    ESP_LOGE(TAG, "RDM poller table malloc error");
+    if (poller->mux != NULL) {
+      vSemaphoreDelete(poller->mux);
+    }
+    free(poller->jobs);
+    free(poller->sorted);
+    free(poller->devices);
+    free(poller);
+    return ESP_ERR_NO_MEM;
+  }
+  poller->config = *config;
+  poller->last_dmx_ts = 0;
+
+  taskENTER_CRITICAL(&rdm_poller_spinlock);
+  rdm_poller[dmx_num] = poller;
+  taskEXIT_CRITICAL(&rdm_poller_spinlock);
+  return ESP_OK;
+}
+
+esp_err_t rdm_poller_delete(dmx_port_t dmx_num) {
+  RDM_POLLER_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG, "dmx_num error");
+
+  // Uninstall the poller unless another task is running it or reading from it
+  taskENTER_CRITICAL(&rdm_poller_spinlock);
+  rdm_poller_t *const poller = rdm_poller[dmx_num];
+  const bool is_in_use = poller != NULL && poller->num_users > 0;
+  if (poller != NULL && !is_in_use) {
+    rdm_poller[dmx_num] = NULL;
+  }
+  taskEXIT_CRITICAL(&rdm_poller_spinlock);
+  RDM_POLLER_CHECK(poller != NULL, ESP_ERR_INVALID_STATE,
+                   "poller is not installed");
+  RDM_POLLER_CHECK(!is_in_use, ESP_ERR_INVALID_STATE, "poller is in use");
+
+  for (size_t j = 0; j < poller->num_jobs; ++j) {
+    free(poller->jobs[j].entry);
+    free(poller->jobs[j].data);
+  }
+  free(poller->jobs);
+  free(poller->sorted);
+  free(poller->devices);
+  vSemaphoreDelete(poller->mux);
+  free(poller);
+
+  return ESP_OK;
+}
+
+int rdm_poller_add(dmx_port_t dmx_num, const rdm_uid_t *uids, size_t num_uids,
+                   rdm_pid_t pid, uint32_t interval_ms, size_t max_pdl) {
+  RDM_POLLER_CHECK(dmx_num < DMX_NUM_MAX, -1, "dmx_num error");
+  RDM_POLLER_CHECK(uids != NULL, -1, "uids is null");
+  RDM_POLLER_CHECK(max_pdl <= RDM_MAX_PDL, -1, "max_pdl error");
+  rdm_poller_t *const poller = rdm_poller_acquire(dmx_num);
+  RDM_POLLER_CHECK(poller != NULL, -1, "poller is not installed");
+
+  xSemaphoreTake(poller->mux, portMAX_DELAY);
+  if (poller->num_jobs >= poller->config.max_jobs) {
+    xSemaphoreGive(poller->mux);
+    rdm_poller_release(poller);
+    ESP_LOGE(TAG, "max number of jobs reached");
+    return -1;
+  }
+
+  // Allocate the job's slice of the result table
+  const size_t max_devices = poller->config.max_devices;
+  rdm_poller_job_t *job = &poller->jobs[poller->num_jobs];
+  job->entry = malloc(max_devices * sizeof(*job->entry));
+  job->data = max_pdl > 0 ? malloc(max_devices * max_pdl) : NULL;
+  if (job->entry == NULL || (max_pdl > 0 && job->data == NULL)) {
+    free(job->entry);
+    free(job->data);
+    xSemaphoreGive(poller->mux);
+    rdm_poller_release(poller);
+    ESP_LOGE(TAG, "RDM poller job malloc error");
+    return -1;
+  }
+  job->pid = pid;
+  job->interval = interval_ms * 1000;
+  job->max_pdl = max_pdl;
+  for (size_t i = 0; i < max_devices; ++i) {
+    job->entry[i].next_due = RDM_POLLER_NOT_A_MEMBER;
+    job->entry[i].timestamp = -1;
+    job->entry[i].err = ESP_OK;
+    job->entry[i].type = RDM_RESPONSE_TYPE_NONE;
+    job->entry[i].nack = 0;
+    job->entry[i].pdl = 0;
+  }
+  const int job_num = poller->num_jobs;
+  ++poller->num_jobs;
+
+  // Add each device to the job, spreading initial requests over the interval
+  const int64_t now = esp_timer_get_time();
+  for (size_t i = 0; i < num_uids; ++i) {
+    const int device_num = rdm_poller_add_device(poller, uids[i]);
+    if (device_num < 0) {
+      ESP_LOGW(TAG, "max number of devices reached");
+      break;
+    }
+    job->entry[device_num].next_due =
+        now + ((int64_t)job->interval * i) / num_uids;
+  }
+  xSemaphoreGive(poller->mux);
+  rdm_poller_release(poller);
+
+  return job_num;
+}
+
+static void rdm_poller_refresh_dmx(dmx_port_t dmx_num, rdm_poller_t *poller) {
+  const rdm_poller_config_t *const config = &poller->config;
+  if (config->dmx_refresh_us == 0) {
+    return;
+  }
+
+  const int64_t now = esp_timer_get_time();
+  if (now - poller->last_dmx_ts >= config->dmx_refresh_us) {
+    dmx_write(dmx_num, config->dmx_data, config->dmx_size);
+    dmx_send(dmx_num, config->dmx_size);
+    poller->last_dmx_ts = now;
+  }
+}
+
+static bool rdm_poller_step(dmx_port_t dmx_num, rdm_poller_t *poller) {
+  // Find the next eligible device, starting at the round-robin cursor
+  xSemaphoreTake(poller->mux, portMAX_DELAY);
+  const int64_t now = esp_timer_get_time();
+  int device_num = -1;
+  int job_num = -1;
+  for (size_t i = 0; i < poller->num_devices && job_num < 0; ++i) {
+    const int d = (poller->cursor + i) % poller->num_devices;
+    const rdm_poller_device_t *device = &poller->devices[d];
+    if (device->next_allowed > now || device->backoff_until > now) {
+      continue;  // The device is rate limited or backing off
+    }
+
+    // Pick the most overdue job for this device
+    int64_t earliest = now;
+    for (size_t j = 0; j < poller->num_jobs; ++j) {
+      const int64_t next_due = poller->jobs[j].entry[d].next_due;
+      if (next_due != RDM_POLLER_NOT_A_MEMBER && next_due <= earliest) {
+        earliest = next_due;
+        job_num = j;
+      }
+    }
+    device_num = d;
+  }
+  if (job_num < 0) {
+    xSemaphoreGive(poller->mux);
+    return false;
+  }
+  poller->cursor = device_num + 1;
+  const rdm_uid_t uid = poller->devices[device_num].uid;
+  const rdm_pid_t pid = poller->jobs[job_num].pid;
+  xSemaphoreGive(poller->mux);
+
+  // Send the request without holding the table lock
+  uint8_t pd[RDM_MAX_PDL];
+  rdm_response_t response;
+  const size_t pdl = rdm_get_generic(dmx_num, uid, RDM_ROOT_DEVICE, pid, NULL,
+                                     0, &response, pd, sizeof(pd));
+
+  // Record the result
+  xSemaphoreTake(poller->mux, portMAX_DELAY);
+  const int64_t done = esp_timer_get_time();
+  rdm_poller_device_t *device = &poller->devices[device_num];
+  rdm_poller_job_t *job = &poller->jobs[job_num];
+  rdm_poller_entry_t *entry = &job->entry[device_num];
+  device->next_allowed = done + poller->config.device_interval_us;
+  entry->err = response.err;
+  entry->type = response.type;
+  if (response.type == RDM_RESPONSE_TYPE_NONE) {
+    // The response was lost - back off exponentially
+    if (device->failures < 31) {
+      ++device->failures;
+    }
+    uint64_t backoff = (uint64_t)poller->config.backoff_base_us
+                       << (device->failures - 1);
+    if (backoff > poller->config.backoff_max_us) {
+      backoff = poller->config.backoff_max_us;
+    }
+    device->backoff_until = done + backoff;
+  } else {
+    device->failures = 0;
+    device->backoff_until = 0;
+    if (response.type == RDM_RESPONSE_TYPE_ACK && !response.err) {
+      const size_t copied = pdl < job->max_pdl ? pdl : job->max_pdl;
+      memcpy(&job->data[device_num * job->max_pdl], pd, copied);
+      entry->pdl = pdl;
+      entry->timestamp = done;
+      entry->next_due = done + job->interval;
+    } else if (response.type == RDM_RESPONSE_TYPE_ACK_TIMER) {
+      // Retry the request when the responder says it will be ready
+      entry->next_due = done + (int64_t)response.timer * portTICK_PERIOD_MS *
+                                   1000;
+    } else {
+      if (response.type == RDM_RESPONSE_TYPE_NACK_REASON) {
+        entry->nack = response.nack_reason;
+      }
+      entry->next_due = done + job->interval;
+    }
+  }
+  xSemaphoreGive(poller->mux);
+
+  return true;
+}
+
+size_t rdm_poller_run(dmx_port_t dmx_num, TickType_t wait_ticks) {
+  RDM_POLLER_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  rdm_poller_t *const poller = rdm_poller_acquire(dmx_num);
+  RDM_POLLER_CHECK(poller != NULL, 0, "poller is not installed");
+
+  size_t num_sent = 0;
+  TimeOut_t timeout;
+  vTaskSetTimeOutState(&timeout);
+  do {
+    rdm_poller_refresh_dmx(dmx_num, poller);
+    if (rdm_poller_step(dmx_num, poller)) {
+      ++num_sent;
+    } else {
+      // Nothing is due - keep DMX alive while waiting for the next entry
+      rdm_poller_refresh_dmx(dmx_num, poller);
+      vTaskDelay(1);
+    }
+  } while (!xTaskCheckForTimeOut(&timeout, &wait_ticks));
+  rdm_poller_release(poller);
+
+  return num_sent;
+}
+
+bool rdm_poller_get_result(dmx_port_t dmx_num, int job, rdm_uid_t uid,
+                           rdm_poller_result_t *result, void *pd,
+                           size_t size) {
+  RDM_POLLER_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  RDM_POLLER_CHECK(result != NULL, false, "result is null");
+  RDM_POLLER_CHECK(pd != NULL || size == 0, false, "pd is null");
+  rdm_poller_t *const poller = rdm_poller_acquire(dmx_num);
+  RDM_POLLER_CHECK(poller != NULL, false, "poller is not installed");
+
+  xSemaphoreTake(poller->mux, portMAX_DELAY);
+  if (job < 0 || (size_t)job >= poller->num_jobs) {
+    xSemaphoreGive(poller->mux);
+    rdm_poller_release(poller);
+    return false;
+  }
+  const int device_num = rdm_poller_find_device(poller, uid, NULL);
+  if (device_num < 0 ||
+      poller->jobs[job].entry[device_num].next_due == RDM_POLLER_NOT_A_MEMBER) {
+    xSemaphoreGive(poller->mux);
+    rdm_poller_release(poller);
+    return false;
+  }
+
+  const rdm_poller_job_t *const j = &poller->jobs[job];
+  const rdm_poller_entry_t *const entry = &j->entry[device_num];
+  result->err = entry->err;
+  result->type = entry->type;
+  result->nack_reason = entry->nack;
+  result->timestamp = entry->timestamp;
+  result->pdl = entry->pdl;
+  if (size > 0 && entry->timestamp >= 0) {
+    size_t copied = entry->pdl < j->max_pdl ? entry->pdl : j->max_pdl;
+    if (copied > size) {
+      copied = size;
+    }
+    memcpy(pd, &j->data[device_num * j->max_pdl], copied);
+  }
+  xSemaphoreGive(poller->mux);
+  rdm_poller_release(poller);
+
+  return true;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file esp_rdm_poller.h
+ * @brief This file declares functions for the RDM fleet poller. The poller
+ * periodically sends RDM GET requests to a set of devices and stores the most
+ * recent response of each device in a result table. Requests are scheduled
+ * fairly across devices so that a single slow or absent device cannot starve
+ * the rest of the fleet.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "rdm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Configuration for the RDM fleet poller.
+ */
+typedef struct rdm_poller_config_t {
+  size_t max_devices;           // The maximum number of unique devices that may be polled.
+  size_t max_jobs;              // The maximum number of jobs that may be registered.
+  uint32_t device_interval_us;  // The minimum time in microseconds between two requests sent to the same device.
+  uint32_t backoff_base_us;     // The time in microseconds a device is skipped after its first lost response. Doubles after each consecutive lost response.
+  uint32_t backoff_max_us;      // The maximum time in microseconds a device is skipped after consecutive lost responses.
+  const void *dmx_data;         // Optional pointer to DMX data which is sent between RDM requests to keep DMX refresh alive. Must remain valid while the poller is installed.
+  size_t dmx_size;              // The size of the DMX data to send between RDM requests.
+  uint32_t dmx_refresh_us;      // The maximum time in microseconds between DMX packets. Set to 0 to disable DMX refresh.
+} rdm_poller_config_t;
+
+/**
+ * @brief The default configuration for the RDM fleet poller. DMX refresh is
+ * disabled by default.
+ */
+#define RDM_POLLER_DEFAULT_CONFIG \
+  {                               \
+    .max_devices = 64,            \
+    .max_jobs = 8,                \
+    .device_interval_us = 20000,  \
+    .backoff_base_us = 250000,    \
+    .backoff_max_us = 30000000,   \
+    .dmx_data = NULL,             \
+    .dmx_size = 0,                \
+    .dmx_refresh_us = 0,          \
+  }
+
+/**
+ * @brief The most recent result of a polled PID on a single device.
+ */
+typedef struct rdm_poller_result_t {
+  esp_err_t err;             // Evaluates to true if an error occurred in the last request.
+  rdm_response_type_t type;  // The type of the last RDM response received.
+  rdm_nr_t nack_reason;      // The NACK reason of the last response. Only valid when type is RDM_RESPONSE_TYPE_NACK_REASON.
+  int64_t timestamp;         // The timestamp in microseconds of the last acknowledged response, or -1 if none has been received.
+  size_t pdl;                // The parameter data length of the last acknowledged response.
+} rdm_poller_result_t;
+
+/**
+ * @brief Installs the RDM fleet poller on a DMX port. The DMX driver must be
+ * installed and the port should be in controller mode.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] config A pointer to the poller configuration.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_NO_MEM if there is not enough memory.
+ * @retval ESP_ERR_INVALID_STATE if the poller is already installed or the DMX
+ * driver is not installed.
+ */
+esp_err_t rdm_poller_install(dmx_port_t dmx_num,
+                             const rdm_poller_config_t *config);
+
+/**
+ * @brief Uninstalls the RDM fleet poller and frees its result table. The
+ * poller is not uninstalled while another task is in rdm_poller_add(),
+ * rdm_poller_run(), or rdm_poller_get_result().
+ *
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the poller is not installed or is in use.
+ */
+esp_err_t rdm_poller_delete(dmx_port_t dmx_num);
+
+/**
+ * @brief Registers a polling job. A job requests the same PID from every
+ * device in a set of UIDs at a fixed interval.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] uids An array of device UIDs to poll.
+ * @param num_uids The number of UIDs in the array.
+ * @param pid The parameter ID to request with GET_COMMAND.
+ * @param interval_ms The polling interval for each device in milliseconds.
+ * @param max_pdl The maximum parameter data length to store for each device.
+ * Response data longer than this is truncated.
+ * @return The job number or -1 on error.
+ */
+int rdm_poller_add(dmx_port_t dmx_num, const rdm_uid_t *uids, size_t num_uids,
+                   rdm_pid_t pid, uint32_t interval_ms, size_t max_pdl);
+
+/**
+ * @brief Runs the poller scheduler. Sends requests that are due until the
+ * specified amount of time has elapsed. If DMX refresh is enabled, DMX packets
+ * are sent in between RDM requests.
+ *
+ * @note This function must be called from the task that owns the RDM
+ * controller port.
+ *
+ * @param dmx_num The DMX port number.
+ * @param wait_ticks The number of ticks for which to run the scheduler.
+ * @return The number of RDM requests that were sent.
+ */
+size_t rdm_poller_run(dmx_port_t dmx_num, TickType_t wait_ticks);
+
+/**
+ * @brief Gets the most recent result of a job for a single device. May be
+ * called from any task.
+ *
+ * @param dmx_num The DMX port number.
+ * @param job The job number returned by rdm_poller_add().
+ * @param uid The UID of the device.
+ * @param[out] result A pointer into which to copy the result summary.
+ * @param[out] pd An optional buffer into which to copy the raw parameter data
+ * of the last acknowledged response.
+ * @param size The size of the provided buffer.
+ * @return true if the device is part of the job and the result was copied.
+ * @return false if the device is not part of the job or on error.
+ */
+bool rdm_poller_get_result(dmx_port_t dmx_num, int job, rdm_uid_t uid,
+                           rdm_poller_result_t *result, void *pd, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
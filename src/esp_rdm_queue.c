@@ -0,0 +1,250 @@
+#include "esp_rdm_queue.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+
+// Used for argument checking at the beginning of each function.
+#define RDM_QUEUE_CHECK(a, err_code, format, ...) \
+  ESP_RETURN_ON_FALSE(a, err_code, TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "rdm_queue";  // The log tagline for the file.
+
+// A message in either ring.
+typedef union rdm_queue_entry_t {
+  rdm_queued_message_t message;
+  rdm_status_message_t status;
+} rdm_queue_entry_t;
+
+/* A cell of a bounded multi-producer, multi-consumer ring. The sequence of a
+cell equals the position of the next write when the cell is free, and the
+position of the write plus one when the cell holds an entry. */
+typedef struct rdm_queue_cell_t {
+  atomic_size_t sequence;   // The sequence number of the cell.
+  rdm_queue_entry_t entry;  // The entry of the cell.
+} rdm_queue_cell_t;
+
+typedef struct rdm_queue_ring_t {
+  rdm_queue_cell_t *cells;   // The cells of the ring.
+  size_t mask;               // The number of cells minus one.
+  atomic_size_t write_pos;   // The position of the next write.
+  atomic_size_t read_pos;    // The position of the next read.
+} rdm_queue_ring_t;
+
+// The number of severities of status messages, from RDM_STATUS_ADVISORY to
+// RDM_STATUS_ERROR.
+#define RDM_QUEUE_NUM_SEVERITIES (RDM_STATUS_ERROR - RDM_STATUS_ADVISORY + 1)
+
+typedef struct rdm_queue_t {
+  rdm_queue_ring_t messages;  // Queued messages.
+  rdm_queue_ring_t statuses[RDM_QUEUE_NUM_SEVERITIES];  // Status messages, in a ring per severity so that messages below a requested severity stay pending.
+} rdm_queue_t;
+
+static rdm_queue_t *rdm_queue[DMX_NUM_MAX] = {0};
+
+static bool rdm_queue_ring_init(rdm_queue_ring_t *ring, size_t size) {
+  ring->cells = malloc(size * sizeof(rdm_queue_cell_t));
+  if (ring->cells == NULL) {
+    return false;
+  }
+  for (size_t i = 0; i < size; ++i) {
+    atomic_init(&ring->cells[i].sequence, i);
+  }
+  ring->mask = size - 1;
+  atomic_init(&ring->write_pos, 0);
+  atomic_init(&ring->read_pos, 0);
+  return true;
+}
+
+static bool rdm_queue_ring_push(rdm_queue_ring_t *ring,
+                                const rdm_queue_entry_t *entry) {
+  rdm_queue_cell_t *cell;
+  size_t pos = atomic_load_explicit(&ring->write_pos, memory_order_relaxed);
+  for (;;) {
+    cell = &ring->cells[pos & ring->mask];
+    const size_t seq =
+        atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      // The cell is free so try to claim it
+      if (atomic_compare_exchange_weak_explicit(&ring->write_pos, &pos,
+                                                pos + 1, memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;  // The ring is full
+    } else {
+      pos = atomic_load_explicit(&ring->write_pos, memory_order_relaxed);
+    }
+  }
+  cell->entry = *entry;
+  atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+  return true;
+}
+
+static bool rdm_queue_ring_pop(rdm_queue_ring_t *ring,
+                               rdm_queue_entry_t *entry) {
+  rdm_queue_cell_t *cell;
+  size_t pos = atomic_load_explicit(&ring->read_pos, memory_order_relaxed);
+  for (;;) {
+    cell = &ring->cells[pos & ring->mask];
+    const size_t seq =
+        atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+    if (diff == 0) {
+      // The cell holds an entry so try to claim it
+      if (atomic_compare_exchange_weak_explicit(&ring->read_pos, &pos,
+                                                pos + 1, memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;  // The ring is empty
+    } else {
+      pos = atomic_load_explicit(&ring->read_pos, memory_order_relaxed);
+    }
+  }
+  *entry = cell->entry;
+  atomic_store_explicit(&cell->sequence, pos + ring->mask + 1,
+                        memory_order_release);
+  return true;
+}
+
+static size_t rdm_queue_ring_count(rdm_queue_ring_t *ring) {
+  const size_t read_pos =
+      atomic_load_explicit(&ring->read_pos, memory_order_relaxed);
+  const size_t write_pos =
+      atomic_load_explicit(&ring->write_pos, memory_order_relaxed);
+  // Pops between the two loads may make the difference exceed the capacity
+  const size_t count = write_pos - read_pos;
+  return count <= ring->mask + 1 ? count : ring->mask + 1;
+}
+
+esp_err_t rdm_queue_install(dmx_port_t dmx_num, size_t capacity) {
+  RDM_QUEUE_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG, "dmx_num error");
+  RDM_QUEUE_CHECK(capacity > 0 && capacity <= 1024, ESP_ERR_INVALID_ARG,
+                  "capacity error");
+  RDM_QUEUE_CHECK(rdm_queue[dmx_num] == NULL, ESP_ERR_INVALID_STATE,
+                  "queue is already installed");
+
+  size_t size = 1;
+  while (size < capacity) {
+    size <<= 1;
+  }
+
+  rdm_queue_t *queue = calloc(1, sizeof(rdm_queue_t));
+  bool initialized = queue != NULL &&
+                     rdm_queue_ring_init(&queue->messages, size);
+  for (int i = 0; initialized && i < RDM_QUEUE_NUM_SEVERITIES; ++i) {
+    initialized = rdm_queue_ring_init(&queue->statuses[i], size);
+  }
+  if (!initialized) {
+    ESP_LOGE(TAG, "queue malloc error");
+    if (queue != NULL) {
+      free(queue->messages.cells);
+      for (int i = 0; i < RDM_QUEUE_NUM_SEVERITIES; ++i) {
+        free(queue->statuses[i].cells);
+      }
+      free(queue);
+    }
+    return ESP_ERR_NO_MEM;
+  }
+  rdm_queue[dmx_num] = queue;
+
+  return ESP_OK;
+}
+
+esp_err_t rdm_queue_delete(dmx_port_t dmx_num) {
+  RDM_QUEUE_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG, "dmx_num error");
+  RDM_QUEUE_CHECK(rdm_queue[dmx_num] != NULL, ESP_ERR_INVALID_STATE,
+                  "queue is not installed");
+
+  rdm_queue_t *queue = rdm_queue[dmx_num];
+  rdm_queue[dmx_num] = NULL;
+  free(queue->messages.cells);
+  for (int i = 0; i < RDM_QUEUE_NUM_SEVERITIES; ++i) {
+    free(queue->statuses[i].cells);
+  }
+  free(queue);
+
+  return ESP_OK;
+}
+
+bool rdm_queue_is_installed(dmx_port_t dmx_num) {
+  return dmx_num < DMX_NUM_MAX && rdm_queue[dmx_num] != NULL;
+}
+
+bool rdm_queue_post(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
+                    rdm_pid_t pid) {
+  if (!rdm_queue_is_installed(dmx_num)) {
+    return false;
+  }
+  const rdm_queue_entry_t entry = {
+      .message = {.sub_device = sub_device, .pid = pid}};
+  return rdm_queue_ring_push(&rdm_queue[dmx_num]->messages, &entry);
+}
+
+bool rdm_queue_post_status(dmx_port_t dmx_num,
+                           const rdm_status_message_t *message) {
+  if (!rdm_queue_is_installed(dmx_num) || message == NULL) {
+    return false;
+  }
+  // Cleared status messages have the severity of the status which was cleared
+  const int severity = message->status_type & 0x0f;
+  if (severity < RDM_STATUS_ADVISORY || severity > RDM_STATUS_ERROR) {
+    return false;
+  }
+  const rdm_queue_entry_t entry = {.status = *message};
+  return rdm_queue_ring_push(
+      &rdm_queue[dmx_num]->statuses[severity - RDM_STATUS_ADVISORY], &entry);
+}
+
+size_t rdm_queue_count(dmx_port_t dmx_num) {
+  if (!rdm_queue_is_installed(dmx_num)) {
+    return 0;
+  }
+  rdm_queue_t *const queue = rdm_queue[dmx_num];
+  size_t count = rdm_queue_ring_count(&queue->messages);
+  for (int i = 0; i < RDM_QUEUE_NUM_SEVERITIES; ++i) {
+    count += rdm_queue_ring_count(&queue->statuses[i]);
+  }
+  return count;
+}
+
+bool rdm_queue_pop(dmx_port_t dmx_num, rdm_queued_message_t *message) {
+  if (!rdm_queue_is_installed(dmx_num) || message == NULL) {
+    return false;
+  }
+  rdm_queue_entry_t entry;
+  if (!rdm_queue_ring_pop(&rdm_queue[dmx_num]->messages, &entry)) {
+    return false;
+  }
+  *message = entry.message;
+  return true;
+}
+
+size_t rdm_queue_pop_status(dmx_port_t dmx_num, rdm_status_t status_type,
+                            rdm_status_message_t *messages, size_t size) {
+  if (!rdm_queue_is_installed(dmx_num) || messages == NULL ||
+      status_type < RDM_STATUS_ADVISORY || status_type > RDM_STATUS_ERROR) {
+    return 0;
+  }
+  // Only the rings of the requested severity and above are read, so that
+  // messages of a lower severity are returned by a later request
+  size_t num_messages = 0;
+  rdm_queue_entry_t entry;
+  for (int severity = RDM_STATUS_ERROR; severity >= (int)status_type;
+       --severity) {
+    rdm_queue_ring_t *const ring =
+        &rdm_queue[dmx_num]->statuses[severity - RDM_STATUS_ADVISORY];
+    while (num_messages < size && rdm_queue_ring_pop(ring, &entry)) {
+      messages[num_messages] = entry.status;
+      ++num_messages;
+    }
+  }
+  return num_messages;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file esp_rdm_queue.h
+ * @brief This file declares functions for the queued message ring of the RDM
+ * responder. Application code posts queued messages, such as a DMX start
+ * address which was changed from the front panel, and status messages, such
+ * as sensor alarms. The RDM responder reports the number of pending messages
+ * in the message count field of every response and serves them with
+ * QUEUED_MESSAGE and STATUS_MESSAGES requests, so that controllers only need
+ * to poll a single PID.
+ *
+ * Messages may be posted from any task or interrupt handler without locks.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "esp_err.h"
+#include "rdm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The maximum number of status messages which fit in a single
+ * STATUS_MESSAGES response.
+ */
+#define RDM_QUEUE_MAX_STATUS_MESSAGES 25
+
+/**
+ * @brief A queued message. When it is collected, the RDM responder replies
+ * with the GET response of the PID, as if the PID had been requested.
+ */
+typedef struct rdm_queued_message_t {
+  rdm_sub_device_t sub_device;  // The sub-device whose parameter changed.
+  rdm_pid_t pid;                // The parameter which changed.
+} rdm_queued_message_t;
+
+/**
+ * @brief Installs the queued message ring on a DMX port. This is called with
+ * a default capacity by rdm_client_init().
+ *
+ * @param dmx_num The DMX port number.
+ * @param capacity The number of queued messages and the number of status
+ * messages of each severity which may be pending. It is rounded up to a power
+ * of two.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the ring is already installed.
+ * @retval ESP_ERR_NO_MEM if there is not enough memory.
+ */
+esp_err_t rdm_queue_install(dmx_port_t dmx_num, size_t capacity);
+
+/**
+ * @brief Uninstalls the queued message ring and frees its memory. Messages
+ * must not be posted while the ring is uninstalled.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the ring is not installed.
+ */
+esp_err_t rdm_queue_delete(dmx_port_t dmx_num);
+
+/**
+ * @brief Returns true if the queued message ring is installed.
+ */
+bool rdm_queue_is_installed(dmx_port_t dmx_num);
+
+/**
+ * @brief Posts a queued message which reports that a parameter has changed.
+ * The value of the parameter is read when the message is collected.
+ *
+ * @param dmx_num The DMX port number.
+ * @param sub_device The sub-device whose parameter changed.
+ * @param pid The parameter which changed.
+ * @return true if the message was posted or false if the ring is full or not
+ * installed.
+ */
+bool rdm_queue_post(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
+                    rdm_pid_t pid);
+
+/**
+ * @brief Posts a status message.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] message A pointer to the status message. Its status type must be
+ * an advisory, warning, or error status, or one of their cleared statuses.
+ * @return true if the message was posted or false if the ring is full or not
+ * installed, or the status type is not allowed.
+ */
+bool rdm_queue_post_status(dmx_port_t dmx_num,
+                           const rdm_status_message_t *message);
+
+/**
+ * @brief Gets the number of pending queued messages and status messages. This
+ * is the value of the message count field of responses, before it is limited
+ * to 255.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The number of pending messages, or 0 if the ring is not installed.
+ */
+size_t rdm_queue_count(dmx_port_t dmx_num);
+
+/**
+ * @brief Removes the oldest queued message. Used by the RDM responder.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] message A pointer to store the message.
+ * @return true if a message was removed or false if there was none.
+ */
+bool rdm_queue_pop(dmx_port_t dmx_num, rdm_queued_message_t *message);
+
+/**
+ * @brief Removes the oldest status messages of the requested severity and
+ * above, the most severe first. Used by the RDM responder. Status messages
+ * below the requested severity stay pending.
+ *
+ * @param dmx_num The DMX port number.
+ * @param status_type The lowest severity of the status messages to return.
+ * Must be RDM_STATUS_ADVISORY, RDM_STATUS_WARNING, or RDM_STATUS_ERROR.
+ * Cleared status messages have the severity of the status which was cleared.
+ * @param[out] messages An array to store the messages.
+ * @param size The size of the array.
+ * @return The number of messages which were stored.
+ */
+size_t rdm_queue_pop_status(dmx_port_t dmx_num, rdm_status_t status_type,
+                            rdm_status_message_t *messages, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
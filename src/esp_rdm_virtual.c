@@ -0,0 +1,574 @@
+#include "esp_rdm_virtual.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_rdm.h"
+#include "esp_rdm_codec.h"
+#include "freertos/FreeRTOS.h"
+#include "private/driver.h"
+#include "private/rdm_encode/functions.h"
+#include "private/rdm_responder.h"
+
+// Used for argument checking at the beginning of each function.
+#define RDM_VIRTUAL_CHECK(a, err_code, format, ...) \
+  ESP_RETURN_ON_FALSE(a, err_code, TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "rdm_virtual";  // The log tagline for the file.
+
+enum {
+  RDM_VIRTUAL_MAX_LABEL_LEN = 32,  // The maximum length of a label.
+};
+
+typedef struct rdm_virtual_responder_t {
+  rdm_uid_t uid;                // The UID of the virtual responder.
+  bool is_muted;                // True if the responder does not answer DISC_UNIQUE_BRANCH.
+  rdm_parameters_t params;      // The parameters of the responder.
+  rdm_virtual_config_t config;  // The configuration, which holds the personalities and labels.
+} rdm_virtual_responder_t;
+
+/* The virtual responders of a port. The pool is kept dense so that discovery
+only scans existing responders; removing a responder moves the last responder
+into its place. The hash table maps each UID to its index in the pool. */
+typedef struct rdm_virtual_port_t {
+  rdm_virtual_responder_t *responders;  // The pool of virtual responders.
+  size_t num_responders;                // The number of virtual responders.
+  size_t max_responders;                // The size of the pool.
+  rdm_virtual_changed_cb_t changed_cb;  // Invoked when a controller changes a parameter.
+} rdm_virtual_port_t;
+
+static rdm_virtual_port_t *rdm_virtual[DMX_NUM_MAX] = {0};
+
+// Finds the slot which holds a UID, or the free slot where it would be stored.
+static size_t rdm_virtual_find_slot(const rdm_virtual_table_t *table,
+                                    rdm_uid_t uid) {
+  size_t i = rdm_virtual_hash(table, uid);
+  while (table->slots[i].uid != 0 && table->slots[i].uid != uid) {
+    i = (i + 1) & table->mask;
+  }
+  return i;
+}
+
+// Removes a UID from the hash table by shifting the following entries of its
+// probe sequence back, so that no tombstones are needed.
+static void rdm_virtual_erase_slot(rdm_virtual_table_t *table, size_t i) {
+  for (size_t j = (i + 1) & table->mask; table->slots[j].uid != 0;
+       j = (j + 1) & table->mask) {
+    const size_t home = rdm_virtual_hash(table, table->slots[j].uid);
+    if (((j - home) & table->mask) >= ((j - i) & table->mask)) {
+      table->slots[i] = table->slots[j];
+      i = j;
+    }
+  }
+  table->slots[i].uid = 0;
+}
+
+static rdm_virtual_responder_t *rdm_virtual_find(dmx_port_t dmx_num,
+                                                 rdm_uid_t uid) {
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  const int index = rdm_virtual_lookup(&rdm_virtual_table[dmx_num], uid);
+  taskEXIT_CRITICAL(spinlock);
+  return index >= 0 ? &rdm_virtual[dmx_num]->responders[index] : NULL;
+}
+
+static bool rdm_virtual_is_addressed(const rdm_virtual_responder_t *responder,
+                                     rdm_uid_t destination_uid) {
+  return destination_uid == RDM_BROADCAST_ALL_UID ||
+         destination_uid == responder->uid ||
+         destination_uid == (responder->uid | 0xffffffff);
+}
+
+static void rdm_virtual_nack(rdm_client_response_t *response, rdm_nr_t reason) {
+  response->type = RDM_RESPONSE_TYPE_NACK_REASON;
+  response->nack_reason = reason;
+}
+
+static void rdm_virtual_get_label(const char *label,
+                                  rdm_client_response_t *response) {
+  response->pdl = strnlen(label, RDM_VIRTUAL_MAX_LABEL_LEN);
+  memcpy(response->pd, label, response->pdl);
+}
+
+static bool rdm_virtual_select_personality(rdm_virtual_responder_t *responder,
+                                           uint8_t personality) {
+  rdm_device_info_t *const device_info = &responder->params.device_info;
+  if (personality == 0 || personality > device_info->personality_count) {
+    return false;
+  }
+  device_info->current_personality = personality;
+  device_info->footprint =
+      responder->config.personalities[personality - 1].footprint;
+  return true;
+}
+
+// Handles a GET or SET request of a virtual responder. Returns the PID of the
+// parameter which changed, or 0 if no parameter changed.
+static rdm_pid_t rdm_virtual_handle(dmx_port_t dmx_num,
+                                    rdm_virtual_responder_t *responder,
+                                    const rdm_header_t *header,
+                                    const uint8_t *pd,
+                                    rdm_client_response_t *response) {
+  const rdm_virtual_config_t *const config = &responder->config;
+  rdm_parameters_t *const params = &responder->params;
+  const bool is_get = header->cc == RDM_CC_GET_COMMAND;
+
+  // Virtual responders have no sub-devices
+  if (header->sub_device != RDM_ROOT_DEVICE) {
+    rdm_virtual_nack(response, RDM_NR_SUB_DEVICE_OUT_OF_RANGE);
+    return 0;
+  }
+
+  switch (header->pid) {
+    case RDM_PID_SUPPORTED_PARAMETERS: {
+      if (!is_get) break;
+      rdm_pid_t pids[RDM_MAX_PDL / 2];
+      size_t num_pids = 0;
+      pids[num_pids++] = RDM_PID_DEVICE_LABEL;
+      pids[num_pids++] = RDM_PID_DMX_PERSONALITY;
+      pids[num_pids++] = RDM_PID_DMX_PERSONALITY_DESCRIPTION;
+      if (config->model_description != NULL) {
+        pids[num_pids++] = RDM_PID_DEVICE_MODEL_DESCRIPTION;
+      }
+      for (size_t i = 0; i < config->num_pids && num_pids < RDM_MAX_PDL / 2;
+           ++i) {
+        pids[num_pids++] = config->pids[i];
+      }
+      response->pdl =
+          rdm_codec_encode(rdm_pid_desc_find(RDM_PID_SUPPORTED_PARAMETERS)->data,
+                           response->pd, pids, num_pids);
+      return 0;
+    }
+
+    case RDM_PID_DEVICE_INFO: {
+      if (!is_get) break;
+      rdm_device_info_t device_info = params->device_info;
+      if (device_info.footprint == 0) {
+        device_info.start_address = -1;
+      }
+      response->pdl = rdm_codec_encode(
+          rdm_pid_desc_find(RDM_PID_DEVICE_INFO)->data, response->pd,
+          &device_info, 1);
+      return 0;
+    }
+
+    case RDM_PID_SOFTWARE_VERSION_LABEL:
+      if (!is_get) break;
+      rdm_virtual_get_label(config->software_version_label, response);
+      return 0;
+
+    case RDM_PID_DEVICE_MODEL_DESCRIPTION:
+      if (config->model_description == NULL) {
+        rdm_virtual_nack(response, RDM_NR_UNKNOWN_PID);
+        return 0;
+      }
+      if (!is_get) break;
+      rdm_virtual_get_label(config->model_description, response);
+      return 0;
+
+    case RDM_PID_DEVICE_LABEL:
+      if (is_get) {
+        memcpy(response->pd, params->device_label, params->device_label_len);
+        response->pdl = params->device_label_len;
+        return 0;
+      }
+      if (header->pdl > RDM_VIRTUAL_MAX_LABEL_LEN) {
+        rdm_virtual_nack(response, RDM_NR_FORMAT_ERROR);
+        return 0;
+      }
+      memcpy(params->device_label, pd, header->pdl);
+      params->device_label_len = header->pdl;
+      return RDM_PID_DEVICE_LABEL;
+
+    case RDM_PID_DMX_PERSONALITY:
+      if (is_get) {
+        response->pd[0] = params->device_info.current_personality;
+        response->pd[1] = params->device_info.personality_count;
+        response->pdl = 2;
+        return 0;
+      }
+      if (header->pdl != 1) {
+        rdm_virtual_nack(response, RDM_NR_FORMAT_ERROR);
+        return 0;
+      }
+      if (!rdm_virtual_select_personality(responder, pd[0])) {
+        rdm_virtual_nack(response, RDM_NR_DATA_OUT_OF_RANGE);
+        return 0;
+      }
+      return RDM_PID_DMX_PERSONALITY;
+
+    case RDM_PID_DMX_PERSONALITY_DESCRIPTION: {
+      if (!is_get) break;
+      if (header->pdl != 1) {
+        rdm_virtual_nack(response, RDM_NR_FORMAT_ERROR);
+        return 0;
+      }
+      if (pd[0] == 0 || pd[0] > params->device_info.personality_count) {
+        rdm_virtual_nack(response, RDM_NR_DATA_OUT_OF_RANGE);
+        return 0;
+      }
+      const rdm_client_personality_t *personality =
+          &config->personalities[pd[0] - 1];
+      const size_t description_len =
+          strnlen(personality->description, RDM_VIRTUAL_MAX_LABEL_LEN);
+      response->pd[0] = pd[0];
+      response->pd[1] = personality->footprint >> 8;
+      response->pd[2] = personality->footprint;
+      memcpy(&response->pd[3], personality->description, description_len);
+      response->pdl = 3 + description_len;
+      return 0;
+    }
+
+    case RDM_PID_DMX_START_ADDRESS: {
+      if (is_get) {
+        const int start_address = params->device_info.footprint > 0
+                                      ? params->device_info.start_address
+                                      : 0xffff;
+        response->pdl = rdm_codec_encode(
+            rdm_pid_desc_find(RDM_PID_DMX_START_ADDRESS)->data, response->pd,
+            &start_address, 1);
+        return 0;
+      }
+      if (header->pdl != 2) {
+        rdm_virtual_nack(response, RDM_NR_FORMAT_ERROR);
+        return 0;
+      }
+      const int start_address = (pd[0] << 8) | pd[1];
+      if (start_address < 1 || start_address > 512 ||
+          params->device_info.footprint == 0) {
+        rdm_virtual_nack(response, RDM_NR_DATA_OUT_OF_RANGE);
+        return 0;
+      }
+      params->device_info.start_address = start_address;
+      return RDM_PID_DMX_START_ADDRESS;
+    }
+
+    case RDM_PID_IDENTIFY_DEVICE:
+      if (is_get) {
+        response->pd[0] = params->identify_device;
+        response->pdl = 1;
+        return 0;
+      }
+      if (header->pdl != 1 || pd[0] > 1) {
+        rdm_virtual_nack(response, header->pdl != 1 ? RDM_NR_FORMAT_ERROR
+                                                    : RDM_NR_DATA_OUT_OF_RANGE);
+        return 0;
+      }
+      params->identify_device = pd[0];
+      return RDM_PID_IDENTIFY_DEVICE;
+
+    default: {
+      // Other PIDs are passed to the handlers of the application
+      bool is_supported = false;
+      for (size_t i = 0; i < config->num_pids && !is_supported; ++i) {
+        is_supported = config->pids[i] == header->pid;
+      }
+      const rdm_pid_handler_t handler =
+          is_get ? config->get_handler : config->set_handler;
+      if (!is_supported) {
+        rdm_virtual_nack(response, RDM_NR_UNKNOWN_PID);
+      } else if (handler == NULL) {
+        rdm_virtual_nack(response, RDM_NR_UNSUPPORTED_COMMAND_CLASS);
+      } else {
+        handler(dmx_num, header, pd, response, config->context);
+      }
+      return 0;
+    }
+  }
+
+  rdm_virtual_nack(response, RDM_NR_UNSUPPORTED_COMMAND_CLASS);
+  return 0;
+}
+
+// Handles a request to a virtual responder, including discovery commands.
+static void rdm_virtual_dispatch(dmx_port_t dmx_num,
+                                 rdm_virtual_responder_t *responder,
+                                 const rdm_header_t *header, const uint8_t *pd,
+                                 rdm_client_response_t *response) {
+  if (header->cc == RDM_CC_DISC_COMMAND) {
+    if (header->pid == RDM_PID_DISC_MUTE ||
+        header->pid == RDM_PID_DISC_UN_MUTE) {
+      responder->is_muted = header->pid == RDM_PID_DISC_MUTE;
+      const rdm_disc_mute_t mute_params = {0};
+      response->pdl = rdm_encode_mute(response->pd, &mute_params);
+    } else {
+      // DISC_UNIQUE_BRANCH is answered by the RDM client for all UIDs at once
+      response->type = RDM_RESPONSE_TYPE_NONE;
+    }
+    return;
+  }
+  if (header->cc != RDM_CC_GET_COMMAND && header->cc != RDM_CC_SET_COMMAND) {
+    response->type = RDM_RESPONSE_TYPE_NONE;
+    return;
+  }
+
+  const rdm_pid_t changed =
+      rdm_virtual_handle(dmx_num, responder, header, pd, response);
+  const rdm_virtual_changed_cb_t cb = rdm_virtual[dmx_num]->changed_cb;
+  if (changed != 0 && cb != NULL) {
+    cb(dmx_num, responder->uid, changed, responder->config.context);
+  }
+}
+
+esp_err_t rdm_virtual_install(dmx_port_t dmx_num, size_t max_responders) {
+  RDM_VIRTUAL_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                    "dmx_num error");
+  RDM_VIRTUAL_CHECK(
+      max_responders > 0 && max_responders <= RDM_VIRTUAL_MAX_RESPONDERS,
+      ESP_ERR_INVALID_ARG, "max_responders error");
+  RDM_VIRTUAL_CHECK(rdm_virtual[dmx_num] == NULL, ESP_ERR_INVALID_STATE,
+                    "virtual responders are already installed");
+  RDM_VIRTUAL_CHECK(!rdm_disc_fast_path_is_enabled(dmx_num),
+                    ESP_ERR_INVALID_STATE,
+                    "DISC_UNIQUE_BRANCH fast path is enabled");
+
+  // The hash table is kept at most half full so that probe sequences are short
+  size_t num_slots = 1;
+  while (num_slots < max_responders * 2) {
+    num_slots <<= 1;
+  }
+
+  rdm_virtual_port_t *port = calloc(1, sizeof(rdm_virtual_port_t));
+  rdm_virtual_slot_t *slots = heap_caps_calloc(
+      num_slots, sizeof(rdm_virtual_slot_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (port != NULL) {
+    port->responders = malloc(max_responders * sizeof(rdm_virtual_responder_t));
+  }
+  if (port == NULL || port->responders == NULL || slots == NULL) {
+    ESP_LOGE(TAG, "virtual responder malloc error");
+    if (port != NULL) {
+      free(port->responders);
+      free(port);
+    }
+    heap_caps_free(slots);
+    return ESP_ERR_NO_MEM;
+  }
+  port->max_responders = max_responders;
+  rdm_virtual[dmx_num] = port;
+
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  rdm_virtual_table[dmx_num].mask = num_slots - 1;
+  rdm_virtual_table[dmx_num].slots = slots;
+  taskEXIT_CRITICAL(spinlock);
+
+  return ESP_OK;
+}
+
+esp_err_t rdm_virtual_delete(dmx_port_t dmx_num) {
+  RDM_VIRTUAL_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                    "dmx_num error");
+  RDM_VIRTUAL_CHECK(rdm_virtual[dmx_num] != NULL, ESP_ERR_INVALID_STATE,
+                    "virtual responders are not installed");
+  RDM_VIRTUAL_CHECK(!rdm_client_responder_is_running(dmx_num),
+                    ESP_ERR_INVALID_STATE, "responder task is running");
+
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  rdm_virtual_slot_t *slots = rdm_virtual_table[dmx_num].slots;
+  rdm_virtual_table[dmx_num].slots = NULL;
+  rdm_virtual_table[dmx_num].mask = 0;
+  taskEXIT_CRITICAL(spinlock);
+
+  rdm_virtual_port_t *port = rdm_virtual[dmx_num];
+  rdm_virtual[dmx_num] = NULL;
+  heap_caps_free(slots);
+  free(port->responders);
+  free(port);
+
+  return ESP_OK;
+}
+
+bool rdm_virtual_is_installed(dmx_port_t dmx_num) {
+  return dmx_num < DMX_NUM_MAX && rdm_virtual[dmx_num] != NULL;
+}
+
+esp_err_t rdm_virtual_add(dmx_port_t dmx_num, rdm_uid_t uid,
+                          const rdm_virtual_config_t *config) {
+  RDM_VIRTUAL_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                    "dmx_num error");
+  RDM_VIRTUAL_CHECK(uid > 0 && uid < RDM_MAX_UID && (uid & 0xffffffff) != 0xffffffff,
+                    ESP_ERR_INVALID_ARG, "uid error");
+  RDM_VIRTUAL_CHECK(config != NULL, ESP_ERR_INVALID_ARG, "config is null");
+  RDM_VIRTUAL_CHECK(config->personalities != NULL &&
+                        config->personality_count > 0,
+                    ESP_ERR_INVALID_ARG, "personalities error");
+  RDM_VIRTUAL_CHECK(config->software_version_label != NULL,
+                    ESP_ERR_INVALID_ARG, "software_version_label is null");
+  RDM_VIRTUAL_CHECK(config->pids != NULL || config->num_pids == 0,
+                    ESP_ERR_INVALID_ARG, "pids is null");
+  RDM_VIRTUAL_CHECK(rdm_virtual[dmx_num] != NULL, ESP_ERR_INVALID_STATE,
+                    "virtual responders are not installed");
+  RDM_VIRTUAL_CHECK(!rdm_client_responder_is_running(dmx_num),
+                    ESP_ERR_INVALID_STATE, "responder task is running");
+  RDM_VIRTUAL_CHECK(uid != rdm_get_uid(dmx_num), ESP_ERR_INVALID_ARG,
+                    "uid is the UID of the port");
+  RDM_VIRTUAL_CHECK(rdm_virtual_find(dmx_num, uid) == NULL,
+                    ESP_ERR_INVALID_ARG, "uid is already in use");
+
+  rdm_virtual_port_t *const port = rdm_virtual[dmx_num];
+  RDM_VIRTUAL_CHECK(port->num_responders < port->max_responders,
+                    ESP_ERR_NO_MEM, "virtual responder table is full");
+  const uint16_t footprint = config->personalities[0].footprint;
+  RDM_VIRTUAL_CHECK(footprint == 0 || (config->start_address >= 1 &&
+                                       config->start_address <= 512),
+                    ESP_ERR_INVALID_ARG, "start_address error");
+
+  // Initialize the responder like the RDM client initializes the port
+  rdm_virtual_responder_t *const responder =
+      &port->responders[port->num_responders];
+  memset(responder, 0, sizeof(*responder));
+  responder->uid = uid;
+  responder->config = *config;
+  rdm_device_info_t *const device_info = &responder->params.device_info;
+  device_info->major_rdm_version = 1;
+  device_info->minor_rdm_version = 0;
+  device_info->model_id = config->model_id;
+  device_info->coarse_product_category = config->product_category >> 8;
+  device_info->fine_product_category = config->product_category & 0xff;
+  device_info->software_version_id = config->software_version_id;
+  device_info->personality_count = config->personality_count;
+  device_info->start_address = footprint > 0 ? config->start_address : 0xffff;
+  rdm_virtual_select_personality(responder, 1);
+  if (config->device_label != NULL) {
+    rdm_parameters_t *const params = &responder->params;
+    params->device_label_len =
+        strnlen(config->device_label, RDM_VIRTUAL_MAX_LABEL_LEN);
+    memcpy(params->device_label, config->device_label,
+           params->device_label_len);
+  }
+
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  rdm_virtual_table_t *const table = &rdm_virtual_table[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  const size_t i = rdm_virtual_find_slot(table, uid);
+  table->slots[i].index = port->num_responders;
+  table->slots[i].uid = uid;
+  taskEXIT_CRITICAL(spinlock);
+  ++port->num_responders;
+
+  return ESP_OK;
+}
+
+esp_err_t rdm_virtual_remove(dmx_port_t dmx_num, rdm_uid_t uid) {
+  RDM_VIRTUAL_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                    "dmx_num error");
+  RDM_VIRTUAL_CHECK(rdm_virtual[dmx_num] != NULL, ESP_ERR_INVALID_STATE,
+                    "virtual responders are not installed");
+  RDM_VIRTUAL_CHECK(!rdm_client_responder_is_running(dmx_num),
+                    ESP_ERR_INVALID_STATE, "responder task is running");
+
+  rdm_virtual_port_t *const port = rdm_virtual[dmx_num];
+  rdm_virtual_table_t *const table = &rdm_virtual_table[dmx_num];
+  spinlock_t *const restrict spinlock = &dmx_spinlock[dmx_num];
+  taskENTER_CRITICAL(spinlock);
+  const int index = rdm_virtual_lookup(table, uid);
+  if (index >= 0) {
+    rdm_virtual_erase_slot(table, rdm_virtual_find_slot(table, uid));
+
+    // Move the last responder into the hole to keep the pool dense
+    const size_t last = port->num_responders - 1;
+    if ((size_t)index != last) {
+      const rdm_uid_t moved_uid = port->responders[last].uid;
+      table->slots[rdm_virtual_find_slot(table, moved_uid)].index = index;
+    }
+  }
+  taskEXIT_CRITICAL(spinlock);
+  if (index < 0) {
+    return ESP_ERR_NOT_FOUND;
+  }
+
+  --port->num_responders;
+  if ((size_t)index != port->num_responders) {
+    port->responders[index] = port->responders[port->num_responders];
+  }
+
+  return ESP_OK;
+}
+
+size_t rdm_virtual_count(dmx_port_t dmx_num) {
+  return rdm_virtual_is_installed(dmx_num)
+             ? rdm_virtual[dmx_num]->num_responders
+             : 0;
+}
+
+bool rdm_virtual_get_parameters(dmx_port_t dmx_num, rdm_uid_t uid,
+                                rdm_parameters_t *params) {
+  if (!rdm_virtual_is_installed(dmx_num) || params == NULL) {
+    return false;
+  }
+  const rdm_virtual_responder_t *responder = rdm_virtual_find(dmx_num, uid);
+  if (responder == NULL) {
+    return false;
+  }
+  *params = responder->params;
+  return true;
+}
+
+void rdm_virtual_set_changed_cb(dmx_port_t dmx_num,
+                                rdm_virtual_changed_cb_t cb) {
+  if (!rdm_virtual_is_installed(dmx_num)) {
+    ESP_LOGE(TAG, "virtual responders are not installed");
+    return;
+  }
+  rdm_virtual[dmx_num]->changed_cb = cb;
+}
+
+size_t rdm_virtual_find_disc_matches(dmx_port_t dmx_num, rdm_uid_t lower_bound,
+                                     rdm_uid_t upper_bound, rdm_uid_t *uids,
+                                     size_t size) {
+  if (!rdm_virtual_is_installed(dmx_num)) {
+    return 0;
+  }
+  const rdm_virtual_port_t *const port = rdm_virtual[dmx_num];
+  size_t num_matches = 0;
+  for (size_t i = 0; i < port->num_responders; ++i) {
+    const rdm_virtual_responder_t *const responder = &port->responders[i];
+    if (!responder->is_muted && responder->uid >= lower_bound &&
+        responder->uid <= upper_bound) {
+      if (num_matches < size) {
+        uids[num_matches] = responder->uid;
+      }
+      ++num_matches;
+    }
+  }
+  return num_matches;
+}
+
+bool rdm_virtual_handle_request(dmx_port_t dmx_num, const rdm_header_t *header,
+                                const uint8_t *pd,
+                                rdm_client_response_t *response) {
+  if (!rdm_virtual_is_installed(dmx_num)) {
+    return false;
+  }
+  rdm_virtual_responder_t *responder =
+      rdm_virtual_find(dmx_num, header->destination_uid);
+  if (responder == NULL) {
+    return false;
+  }
+  rdm_virtual_dispatch(dmx_num, responder, header, pd, response);
+  return true;
+}
+
+void rdm_virtual_handle_broadcast(dmx_port_t dmx_num,
+                                  const rdm_header_t *header,
+                                  const uint8_t *pd) {
+  // DISC_UNIQUE_BRANCH is answered by the RDM client for all UIDs at once
+  if (!rdm_virtual_is_installed(dmx_num) || header->cc == RDM_CC_GET_COMMAND ||
+      header->pid == RDM_PID_DISC_UNIQUE_BRANCH) {
+    return;
+  }
+  rdm_virtual_port_t *const port = rdm_virtual[dmx_num];
+  for (size_t i = 0; i < port->num_responders; ++i) {
+    rdm_virtual_responder_t *const responder = &port->responders[i];
+    if (rdm_virtual_is_addressed(responder, header->destination_uid)) {
+      rdm_client_response_t response = {.type = RDM_RESPONSE_TYPE_ACK,
+                                        .pid = header->pid,
+                                        .sub_device = header->sub_device};
+      rdm_virtual_dispatch(dmx_num, responder, header, pd, &response);
+    }
+  }
+}
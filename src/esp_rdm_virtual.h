@@ -0,0 +1,196 @@
+/**
+ * @file esp_rdm_virtual.h
+ * @brief This file declares functions for virtual RDM responders. A DMX port
+ * may answer as many UIDs in addition to its own, e.g. to scale-test a
+ * controller against hundreds of devices from one board, or to give
+ * non-RDM fixtures behind a gateway an RDM identity. Each virtual responder
+ * has its own parameters, personalities, and discovery mute flag.
+ *
+ * Requests are routed to virtual responders by the RDM client with a hash
+ * table lookup of the destination UID, which is also used by the DMX interrupt
+ * handler to filter requests while the responder task is running. When
+ * several UIDs match a DISC_UNIQUE_BRANCH request, their responses are sent
+ * as a single collision, as they would appear on a bus with real responders.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "esp_err.h"
+#include "esp_rdm_client.h"
+#include "rdm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The maximum number of virtual responders on a single DMX port.
+ */
+#define RDM_VIRTUAL_MAX_RESPONDERS 1024
+
+/**
+ * @brief Invoked when a controller changes a parameter of a virtual
+ * responder, e.g. its DMX start address or personality.
+ */
+typedef void (*rdm_virtual_changed_cb_t)(dmx_port_t dmx_num, rdm_uid_t uid,
+                                         rdm_pid_t pid, void *context);
+
+/**
+ * @brief Configuration of a virtual responder. Strings and the personality
+ * table are not copied and must remain valid while the responder exists,
+ * e.g. static const data which is kept in flash.
+ */
+typedef struct rdm_virtual_config_t {
+  uint16_t model_id;                  // The device model ID.
+  uint16_t product_category;          // The product category.
+  uint32_t software_version_id;       // The software version ID.
+  uint16_t start_address;             // The DMX start address, from 1 to 512. Ignored if the footprint of the personality is 0.
+  const rdm_client_personality_t *personalities;  // The personalities. Personality n is personalities[n - 1].
+  uint8_t personality_count;          // The number of personalities, at least 1.
+  const char *device_label;           // The initial device label, or NULL. At most 32 characters are used.
+  const char *model_description;      // The DEVICE_MODEL_DESCRIPTION, or NULL if it is not supported.
+  const char *software_version_label; // The SOFTWARE_VERSION_LABEL.
+  const rdm_pid_t *pids;              // Other PIDs which are handled by the application and reported in SUPPORTED_PARAMETERS.
+  size_t num_pids;                    // The number of other PIDs.
+  rdm_pid_handler_t get_handler;      // Invoked for GET requests of the other PIDs, or NULL.
+  rdm_pid_handler_t set_handler;      // Invoked for SET requests of the other PIDs, or NULL.
+  void *context;                      // Passed to the handlers and the change callback.
+} rdm_virtual_config_t;
+
+/**
+ * @brief Installs the virtual responder table on a DMX port. The
+ * DISC_UNIQUE_BRANCH fast path must be disabled, because it only answers for
+ * the UID of the port.
+ *
+ * @param dmx_num The DMX port number.
+ * @param max_responders The maximum number of virtual responders, at most
+ * RDM_VIRTUAL_MAX_RESPONDERS.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the table is already installed or the
+ * DISC_UNIQUE_BRANCH fast path is enabled.
+ * @retval ESP_ERR_NO_MEM if there is not enough memory.
+ */
+esp_err_t rdm_virtual_install(dmx_port_t dmx_num, size_t max_responders);
+
+/**
+ * @brief Removes all virtual responders and uninstalls the table. Must not be
+ * called while the RDM responder task is running.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the table is not installed or the RDM
+ * responder task is running.
+ */
+esp_err_t rdm_virtual_delete(dmx_port_t dmx_num);
+
+/**
+ * @brief Returns true if the virtual responder table is installed.
+ */
+bool rdm_virtual_is_installed(dmx_port_t dmx_num);
+
+/**
+ * @brief Adds a virtual responder. It is unmuted and selects personality 1.
+ * Must not be called while the RDM responder task is running.
+ *
+ * @param dmx_num The DMX port number.
+ * @param uid The UID of the virtual responder. Must not be the UID of the port
+ * or a broadcast UID.
+ * @param[in] config A pointer to the configuration of the virtual responder.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error or the UID is
+ * already in use.
+ * @retval ESP_ERR_INVALID_STATE if the table is not installed or the RDM
+ * responder task is running.
+ * @retval ESP_ERR_NO_MEM if the table is full.
+ */
+esp_err_t rdm_virtual_add(dmx_port_t dmx_num, rdm_uid_t uid,
+                          const rdm_virtual_config_t *config);
+
+/**
+ * @brief Removes a virtual responder. Must not be called while the RDM
+ * responder task is running.
+ *
+ * @param dmx_num The DMX port number.
+ * @param uid The UID of the virtual responder.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the table is not installed or the RDM
+ * responder task is running.
+ * @retval ESP_ERR_NOT_FOUND if the UID is not a virtual responder.
+ */
+esp_err_t rdm_virtual_remove(dmx_port_t dmx_num, rdm_uid_t uid);
+
+/**
+ * @brief Gets the number of virtual responders on a DMX port.
+ */
+size_t rdm_virtual_count(dmx_port_t dmx_num);
+
+/**
+ * @brief Copies the parameters of a virtual responder.
+ *
+ * @param dmx_num The DMX port number.
+ * @param uid The UID of the virtual responder.
+ * @param[out] params A pointer into which to copy the parameters.
+ * @return true if the UID is a virtual responder.
+ */
+bool rdm_virtual_get_parameters(dmx_port_t dmx_num, rdm_uid_t uid,
+                                rdm_parameters_t *params);
+
+/**
+ * @brief Sets the callback which is invoked when a controller changes a
+ * parameter of any virtual responder of the DMX port.
+ */
+void rdm_virtual_set_changed_cb(dmx_port_t dmx_num,
+                                rdm_virtual_changed_cb_t cb);
+
+/**
+ * @brief Collects the unmuted virtual responders whose UIDs are within the
+ * bounds of a DISC_UNIQUE_BRANCH request. Used by the RDM client.
+ *
+ * @param dmx_num The DMX port number.
+ * @param lower_bound The lower bound of the request.
+ * @param upper_bound The upper bound of the request.
+ * @param[out] uids An array to store the matching UIDs.
+ * @param size The size of the array.
+ * @return The number of matching UIDs, which may be larger than size.
+ */
+size_t rdm_virtual_find_disc_matches(dmx_port_t dmx_num, rdm_uid_t lower_bound,
+                                     rdm_uid_t upper_bound, rdm_uid_t *uids,
+                                     size_t size);
+
+/**
+ * @brief Handles a request to a virtual responder and fills in the response.
+ * Used by the RDM client for requests whose destination is not the UID of
+ * the port.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] header The header of the request.
+ * @param[in] pd The parameter data of the request.
+ * @param[out] response The response to fill in.
+ * @return true if the destination is a virtual responder.
+ */
+bool rdm_virtual_handle_request(dmx_port_t dmx_num, const rdm_header_t *header,
+                                const uint8_t *pd,
+                                rdm_client_response_t *response);
+
+/**
+ * @brief Applies a broadcast request to every virtual responder to which it
+ * is addressed. Broadcast requests are never answered. Used by the RDM client.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] header The header of the request.
+ * @param[in] pd The parameter data of the request.
+ */
+void rdm_virtual_handle_broadcast(dmx_port_t dmx_num,
+                                  const rdm_header_t *header,
+                                  const uint8_t *pd);
+
+#ifdef __cplusplus
+}
+#endif
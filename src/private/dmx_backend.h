@@ -0,0 +1,260 @@
+/**
+ * @file dmx_backend.h
+ * @brief This file defines the hardware backend of the DMX driver. The
+ * interrupt handlers and the send and receive functions only touch hardware
+ * through the functions in this file and the dmx_uart_* functions of the HAL:
+ *
+ *   - UART FIFO reads and writes, interrupt status, enable and clear, RTS, TX
+ *     inversion, baud rate, and RX line level (dmx_uart_*).
+ *   - The UART peripheral clock, reset, interrupt allocation, and pins
+ *     (dmx_uart_module_*, dmx_uart_isr_*, dmx_uart_set_pin).
+ *   - The hardware timer which times DMX breaks, marks-after-break, and RDM
+ *     turnarounds (dmx_timer_*).
+ *   - Timestamps, which are taken with esp_timer_get_time().
+ *   - The CPU cycle counter, which is read when profiling the interrupt
+ *     handlers and when timestamping the trace (dmx_cpu_get_*cycle_count).
+ *
+ * On the target these map onto the UART HAL and the timer group driver of
+ * ESP-IDF. When CONFIG_DMX_BACKEND_SIM is defined, the simulated UART and timer
+ * in host/sim are used instead, which run the driver on Linux against a
+ * virtual clock.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_intr_alloc.h"
+#include "private/driver.h"
+
+#ifdef CONFIG_DMX_BACKEND_SIM
+#include "dmx_sim_backend.h"
+#else
+#include "driver/periph_ctrl.h"
+#include "driver/timer.h"
+#include "driver/uart.h"
+#include "hal/cpu_hal.h"
+#include "private/dmx_hal.h"
+
+#if ESP_IDF_MAJOR_VERSION >= 5
+#error ESP-IDF v5 not supported yet!
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Gets the UART registers of a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @return A pointer to the UART registers.
+ */
+static inline uart_dev_t *dmx_uart_get_dev(dmx_port_t dmx_num) {
+  return UART_LL_GET_HW(dmx_num);
+}
+
+/**
+ * @brief Enables the clock of the UART peripheral and resets it. The UART of
+ * the console is not reset. Must be called with the spinlock held.
+ *
+ * @param dmx_num The DMX port number.
+ * @param uart A pointer to the UART registers.
+ */
+static inline void dmx_uart_module_enable(dmx_port_t dmx_num,
+                                          uart_dev_t *uart) {
+  periph_module_enable(uart_periph_signal[dmx_num].module);
+  if (dmx_num != CONFIG_ESP_CONSOLE_UART_NUM) {
+#if SOC_UART_REQUIRE_CORE_RESET
+    // ESP32-C3 workaround to prevent UART outputting garbage data.
+    uart_ll_set_reset_core(uart, true);
+    periph_module_reset(uart_periph_signal[dmx_num].module);
+    uart_ll_set_reset_core(uart, false);
+#else
+    periph_module_reset(uart_periph_signal[dmx_num].module);
+#endif
+  }
+}
+
+/**
+ * @brief Disables the clock of the UART peripheral, unless it is the UART of
+ * the console. Must be called with the spinlock held.
+ *
+ * @param dmx_num The DMX port number.
+ */
+static inline void dmx_uart_module_disable(dmx_port_t dmx_num) {
+  if (dmx_num != CONFIG_ESP_CONSOLE_UART_NUM) {
+    periph_module_disable(uart_periph_signal[dmx_num].module);
+  }
+}
+
+/**
+ * @brief Allocates the UART interrupt and stores its handle in the driver.
+ *
+ * @param driver A pointer to the DMX driver.
+ * @param intr_flags The interrupt allocation flags.
+ * @param isr The UART interrupt handler, which is passed the driver.
+ * @return ESP_OK on success or an error from esp_intr_alloc().
+ */
+static inline esp_err_t dmx_uart_isr_install(dmx_driver_t *driver,
+                                             int intr_flags,
+                                             intr_handler_t isr) {
+  return esp_intr_alloc(uart_periph_signal[driver->dmx_num].irq, intr_flags,
+                        isr, driver, &driver->uart_isr_handle);
+}
+
+/**
+ * @brief Frees the UART interrupt if it was allocated.
+ *
+ * @param driver A pointer to the DMX driver.
+ */
+static inline void dmx_uart_isr_uninstall(dmx_driver_t *driver) {
+  if (driver->uart_isr_handle != NULL) {
+    esp_intr_free(driver->uart_isr_handle);
+  }
+}
+
+/**
+ * @brief Routes the UART signals of a DMX port to GPIOs.
+ *
+ * @param dmx_num The DMX port number.
+ * @param tx_pin The TX GPIO, or DMX_PIN_NO_CHANGE.
+ * @param rx_pin The RX GPIO, or DMX_PIN_NO_CHANGE.
+ * @param rts_pin The RTS GPIO, or DMX_PIN_NO_CHANGE.
+ * @return ESP_OK on success or an error from uart_set_pin().
+ */
+static inline esp_err_t dmx_uart_set_pin(dmx_port_t dmx_num, int tx_pin,
+                                         int rx_pin, int rts_pin) {
+  return uart_set_pin(dmx_num, tx_pin, rx_pin, rts_pin, DMX_PIN_NO_CHANGE);
+}
+
+/**
+ * @brief Initializes the hardware timer of a DMX port as a 1MHz up-counter
+ * which reloads on alarm, and adds its interrupt handler. The timer is
+ * initialized paused.
+ *
+ * @param driver A pointer to the DMX driver.
+ * @param isr The timer interrupt handler, which is passed the driver.
+ * @param intr_flags The interrupt allocation flags.
+ */
+static inline void dmx_timer_init(dmx_driver_t *driver, timer_isr_t isr,
+                                  int intr_flags) {
+  driver->timer_group = driver->dmx_num / 2;
+  driver->timer_idx = driver->dmx_num % 2;
+  const timer_config_t timer_config = {
+      .divider = 80,  // (80MHz / 80) == 1MHz resolution timer
+      .counter_dir = TIMER_COUNT_UP,
+      .counter_en = false,
+      .alarm_en = true,
+      .auto_reload = true,
+  };
+  timer_init(driver->timer_group, driver->timer_idx, &timer_config);
+  timer_isr_callback_add(driver->timer_group, driver->timer_idx, isr, driver,
+                         intr_flags);
+}
+
+/**
+ * @brief Removes the timer interrupt handler and deinitializes the timer.
+ *
+ * @param driver A pointer to the DMX driver.
+ */
+static inline void dmx_timer_deinit(dmx_driver_t *driver) {
+  timer_isr_callback_remove(driver->timer_group, driver->timer_idx);
+  timer_deinit(driver->timer_group, driver->timer_idx);
+}
+
+/**
+ * @brief Sets the counter and the alarm of the timer and starts it. Must not
+ * be called from an interrupt handler.
+ *
+ * @param driver A pointer to the DMX driver.
+ * @param counter The counter value in microseconds.
+ * @param alarm The alarm value in microseconds.
+ */
+static inline void dmx_timer_start(dmx_driver_t *driver, uint64_t counter,
+                                   uint64_t alarm) {
+  timer_set_counter_value(driver->timer_group, driver->timer_idx, counter);
+  timer_set_alarm_value(driver->timer_group, driver->timer_idx, alarm);
+  timer_start(driver->timer_group, driver->timer_idx);
+}
+
+/**
+ * @brief Pauses the timer. Must not be called from an interrupt handler.
+ *
+ * @param driver A pointer to the DMX driver.
+ */
+static inline void dmx_timer_pause(dmx_driver_t *driver) {
+  timer_pause(driver->timer_group, driver->timer_idx);
+}
+
+/**
+ * @brief Pauses the timer from an interrupt handler.
+ *
+ * @param driver A pointer to the DMX driver.
+ */
+FORCE_INLINE_ATTR void dmx_timer_pause_in_isr(dmx_driver_t *driver) {
+  timer_group_set_counter_enable_in_isr(driver->timer_group,
+                                        driver->timer_idx, 0);
+}
+
+/**
+ * @brief Sets the alarm of the timer from an interrupt handler.
+ *
+ * @param driver A pointer to the DMX driver.
+ * @param alarm The alarm value in microseconds.
+ */
+FORCE_INLINE_ATTR void dmx_timer_set_alarm_in_isr(dmx_driver_t *driver,
+                                                  uint64_t alarm) {
+  timer_group_set_alarm_value_in_isr(driver->timer_group, driver->timer_idx,
+                                     alarm);
+}
+
+/**
+ * @brief Gets the counter of the timer from an interrupt handler.
+ *
+ * @param driver A pointer to the DMX driver.
+ * @return The counter value in microseconds.
+ */
+FORCE_INLINE_ATTR uint64_t dmx_timer_get_counter_in_isr(dmx_driver_t *driver) {
+  return timer_group_get_counter_value_in_isr(driver->timer_group,
+                                              driver->timer_idx);
+}
+
+/**
+ * @brief Re-arms the alarm and resumes the timer from an interrupt handler.
+ *
+ * @param driver A pointer to the DMX driver.
+ */
+FORCE_INLINE_ATTR void dmx_timer_resume_in_isr(dmx_driver_t *driver) {
+  timer_group_enable_alarm_in_isr(driver->timer_group, driver->timer_idx);
+  timer_group_set_counter_enable_in_isr(driver->timer_group,
+                                        driver->timer_idx, 1);
+}
+
+/**
+ * @brief Reads the cycle counter of the current CPU core.
+ *
+ * @return The number of CPU cycles, which wraps around.
+ */
+FORCE_INLINE_ATTR uint32_t dmx_cpu_get_cycle_count(void) {
+  return cpu_hal_get_cycle_count();
+}
+
+/**
+ * @brief Reads the cycle counter which timestamps the records of the trace.
+ * On the target this is the cycle counter of the current CPU core.
+ *
+ * @return The number of CPU cycles, which wraps around.
+ */
+FORCE_INLINE_ATTR uint32_t dmx_cpu_get_trace_cycle_count(void) {
+  return cpu_hal_get_cycle_count();
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * @file dmx_classify.h
+ * @brief This file contains the classifier which the DMX interrupt handler
+ * uses to decide when a received packet is complete and what type of packet
+ * it is. It is kept free of driver state so that it can be fuzzed on the
+ * host, see host/fuzz.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "endian.h"
+#include "esp_attr.h"
+#include "esp_rdm.h"
+#include "private/rdm_encode/types.h"
+#include "rdm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum rdm_packet_type_t {
+  RDM_PACKET_TYPE_NON_RDM,
+  RDM_PACKET_TYPE_DISCOVERY,
+  RDM_PACKET_TYPE_DISCOVERY_RESPONSE,
+  RDM_PACKET_TYPE_REQUEST,
+  RDM_PACKET_TYPE_RESPONSE,
+  RDM_PACKET_TYPE_BROADCAST
+};
+
+/**
+ * @brief Determines if the packet which is being received is complete, and
+ * its type. Only the first slots of the buffer are read, so the buffer must
+ * be at least RDM_BASE_PACKET_SIZE bytes long regardless of the head.
+ *
+ * @param[in] buffer The driver buffer.
+ * @param head The number of slots which have been received. May exceed the
+ * size of the buffer if slots were discarded.
+ * @param rx_size The expected size of DMX packets.
+ * @param[out] type The rdm_packet_type_t of the packet. Only written if the
+ * packet is complete.
+ * @return true if the packet is complete.
+ */
+FORCE_INLINE_ATTR bool dmx_classify_packet(const uint8_t *buffer, int head,
+                                           int rx_size, int *type) {
+  const rdm_data_t *const rdm = (const rdm_data_t *)buffer;
+  if (rdm->sc == RDM_SC && rdm->sub_sc == RDM_SUB_SC) {
+    // The packet is a standard RDM packet
+    if (head < RDM_BASE_PACKET_SIZE || head < rdm->message_len + 2) {
+      return false;
+    }
+    if (rdm->cc == RDM_CC_DISC_COMMAND &&
+        rdm->pid == bswap16(RDM_PID_DISC_UNIQUE_BRANCH)) {
+      *type = RDM_PACKET_TYPE_DISCOVERY;
+    } else if (rdm_uid_is_broadcast(buf_to_uid(rdm->destination_uid))) {
+      *type = RDM_PACKET_TYPE_BROADCAST;
+    } else if (rdm->cc == RDM_CC_GET_COMMAND || rdm->cc == RDM_CC_SET_COMMAND ||
+               rdm->cc == RDM_CC_DISC_COMMAND) {
+      *type = RDM_PACKET_TYPE_REQUEST;
+    } else {
+      *type = RDM_PACKET_TYPE_RESPONSE;
+    }
+    return true;
+  } else if (rdm->sc == RDM_PREAMBLE || rdm->sc == RDM_DELIMITER) {
+    // The packet is a DISC_UNIQUE_BRANCH response
+    if (head < 17) {
+      return false;
+    }
+
+    // Find the length of the preamble (0 to 7 bytes)
+    int preamble_len = 0;
+    for (; preamble_len < 7; ++preamble_len) {
+      if (buffer[preamble_len] == RDM_DELIMITER) {
+        break;
+      }
+    }
+
+    // DISC_UNIQUE_BRANCH responses should be 17 bytes after preamble
+    if (head < preamble_len + 17) {
+      return false;
+    }
+    *type = RDM_PACKET_TYPE_DISCOVERY_RESPONSE;
+    return true;
+  } else {
+    // The packet is a DMX packet
+    if (head < rx_size) {
+      return false;
+    }
+    *type = RDM_PACKET_TYPE_NON_RDM;
+    return true;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,42 @@
+/**
+ * @file dmx_timing.h
+ * @brief This file contains RDM packet timing constants and the timestamps
+ * that the DMX driver records in its interrupt handlers so that they may be
+ * used outside of esp_dmx.c.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "dmx_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum rdm_packet_timing_t {
+  RDM_DISCOVERY_NO_RESPONSE_PACKET_SPACING = 5800,
+  RDM_REQUEST_NO_RESPONSE_PACKET_SPACING = 3000,
+  RDM_BROADCAST_PACKET_SPACING = 176,
+  RDM_RESPOND_TO_REQUEST_PACKET_SPACING = 176,
+
+  RDM_CONTROLLER_RESPONSE_LOST_TIMEOUT = 2800,
+  RDM_RESPONDER_RESPONSE_LOST_TIMEOUT = 2000
+};
+
+/* Timestamps and timing settings of each DMX port. The timestamps are written
+in the DMX interrupt handlers and are only valid while the driver mutex is
+held. */
+typedef struct dmx_timing_t {
+  int64_t tx_done_ts;             // Timestamp of the last time the driver finished sending a packet.
+  int64_t rx_break_ts;            // Timestamp of the last received DMX break.
+  int64_t rx_first_slot_ts;       // Timestamp of the first slot of the last received packet.
+  int64_t rx_done_ts;             // Timestamp of when the last received packet was complete.
+  uint32_t rdm_response_timeout;  // Time in microseconds to wait for an RDM response after a request is sent.
+} dmx_timing_t;
+
+extern dmx_timing_t dmx_timing[DMX_NUM_MAX];
+
+#ifdef __cplusplus
+}
+#endif
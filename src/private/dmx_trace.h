@@ -0,0 +1,75 @@
+/**
+ * @file dmx_trace.h
+ * @brief This file contains the trace of each DMX port, which is a fixed-size
+ * ring of dmx_trace_record_t that is written by the interrupt handlers and the
+ * send and receive functions when the driver is built with CONFIG_DMX_TRACE.
+ * Without CONFIG_DMX_TRACE, DMX_TRACE() compiles to nothing.
+ *
+ * Records are claimed by atomically incrementing the head of the ring, so the
+ * trace may be written from any core and from interrupts without a lock. The
+ * seq field of a record is cleared while it is written and then set to an
+ * odd value which identifies the lap of the ring, so that dmx_trace_drain()
+ * can tell when a record is incomplete or was overwritten while it was read.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "esp_attr.h"
+#include "private/dmx_backend.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef CONFIG_DMX_TRACE
+
+#ifndef CONFIG_DMX_TRACE_SIZE
+/**
+ * @brief The number of records in the trace of each DMX port. Must be a
+ * power of two.
+ */
+#define CONFIG_DMX_TRACE_SIZE 256
+#endif
+
+#if CONFIG_DMX_TRACE_SIZE & (CONFIG_DMX_TRACE_SIZE - 1)
+#error CONFIG_DMX_TRACE_SIZE must be a power of two!
+#endif
+
+typedef struct dmx_trace_t {
+  uint32_t head;  // The number of records which have been claimed by writers.
+  uint32_t tail;  // The number of records which have been drained.
+  dmx_trace_record_t records[CONFIG_DMX_TRACE_SIZE];
+} dmx_trace_t;
+
+extern dmx_trace_t dmx_trace[DMX_NUM_MAX];
+
+// Returns the seq of a complete record at an index of the trace.
+FORCE_INLINE_ATTR uint8_t dmx_trace_seq(uint32_t index) {
+  return (uint8_t)((index / CONFIG_DMX_TRACE_SIZE) << 1) | 1;
+}
+
+// Adds a record to the trace of a DMX port.
+FORCE_INLINE_ATTR void dmx_trace_add(dmx_port_t dmx_num, uint8_t event,
+                                     uint16_t arg) {
+  dmx_trace_t *const trace = &dmx_trace[dmx_num];
+  const uint32_t index = __atomic_fetch_add(&trace->head, 1, __ATOMIC_RELAXED);
+  dmx_trace_record_t *const record =
+      &trace->records[index & (CONFIG_DMX_TRACE_SIZE - 1)];
+  __atomic_store_n(&record->seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  record->cycles = dmx_cpu_get_trace_cycle_count();
+  record->arg = arg;
+  record->event = event;
+  __atomic_store_n(&record->seq, dmx_trace_seq(index), __ATOMIC_RELEASE);
+}
+
+#define DMX_TRACE(dmx_num, event, arg) dmx_trace_add(dmx_num, event, arg)
+#else
+#define DMX_TRACE(dmx_num, event, arg)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,81 @@
+/**
+ * @file driver.h
+ * @brief This file contains the DMX driver object, which holds the state of a
+ * DMX port that is shared by the interrupt handlers and the DMX and RDM
+ * functions.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "driver/timer.h"
+#include "esp_heap_caps.h"
+#include "esp_intr_alloc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "hal/uart_hal.h"
+#include "rdm_types.h"
+#include "soc/uart_struct.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The DMX driver object used to handle sending and receiving DMX and RDM data
+on the UART port. The data buffer is shared by the interrupt handlers and the
+DMX functions, so it may only be accessed while the spinlock of the port is
+held or the driver mutex is held and the port is idle. */
+typedef struct dmx_driver_t {
+  dmx_port_t dmx_num;              // The driver's DMX port number.
+  uart_dev_t *uart;                // A pointer to the UART registers of the port.
+  intr_handle_t uart_isr_handle;   // The handle of the UART interrupt handler.
+  timer_group_t timer_group;       // The hardware timer group of the port.
+  timer_idx_t timer_idx;           // The hardware timer of the port.
+
+  SemaphoreHandle_t mux;           // The recursive mutex which serializes the DMX functions of the port.
+  TaskHandle_t task_waiting;       // The task which is waiting for a packet to be sent or received, or NULL.
+
+  uint32_t break_len;              // The length of the DMX break which is sent, in microseconds.
+  uint32_t mab_len;                // The length of the mark-after-break which is sent, in microseconds.
+
+  bool is_in_break;                // True while the DMX break of a packet is sent or received.
+  bool is_sending;                 // True while a packet is sent.
+  bool received_a_packet;          // True if a packet was received which has not been read.
+
+  struct dmx_driver_data_t {
+    uint8_t *buffer;               // The buffer of the packet which is sent or received.
+    esp_err_t err;                 // The error of the last received packet.
+    int head;                      // The index of the next slot which is sent or received, or -1 while waiting for a DMX break.
+    int rx_size;                   // The size of the last received packet.
+    int tx_size;                   // The size of the packet which is sent.
+    bool sent_last;                // True if the last packet was sent by this port.
+    int64_t timestamp;             // The time of the last event of the packet which is sent or received.
+    int type;                      // The enum rdm_packet_type_t of the last packet.
+  } data;
+
+  struct dmx_driver_rdm_t {
+    bool discovery_is_muted;       // True if the port does not answer DISC_UNIQUE_BRANCH requests.
+    uint8_t tn;                    // The transaction number of the next RDM request.
+    rdm_uid_t uid;                 // The UID of the port, or 0 until it is first read.
+  } rdm;
+
+  struct dmx_driver_sniffer_t {
+    dmx_metadata_t data;           // The DMX break and mark-after-break lengths of the last packet.
+    int intr_pin;                  // The GPIO of the sniffer.
+    bool is_in_mab;                // True while the sniffer measures a mark-after-break.
+    int64_t last_neg_edge_ts;      // The time of the last falling edge on the sniffer pin.
+    int64_t last_pos_edge_ts;      // The time of the last rising edge on the sniffer pin.
+    QueueHandle_t queue;           // The queue to which the metadata of each packet is sent.
+  } sniffer;
+} dmx_driver_t;
+
+extern dmx_driver_t *restrict dmx_driver[DMX_NUM_MAX];
+extern spinlock_t dmx_spinlock[DMX_NUM_MAX];
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,261 @@
+#include "private/rdm_encode/functions.h"
+
+#include <string.h>
+
+#include "dmx_types.h"
+
+enum {
+  RDM_HEADER_SIZE = 24,                // The size of an RDM header, which is the offset of the parameter data.
+  RDM_DISC_RESPONSE_PREAMBLE = 0xfe,   // The preamble byte of a DISC_UNIQUE_BRANCH response.
+  RDM_DISC_RESPONSE_DELIMITER = 0xaa,  // The byte which ends the preamble of a DISC_UNIQUE_BRANCH response.
+  RDM_DISC_RESPONSE_MAX_PREAMBLE = 7,  // The maximum number of preamble bytes.
+  RDM_DEVICE_INFO_PDL = 19,            // The parameter data length of DEVICE_INFO.
+  RDM_MAX_STRING_LEN = 32,             // The maximum length of a string on the line.
+};
+
+static void rdm_put_uid(uint8_t *data, rdm_uid_t uid) {
+  for (int i = 5; i >= 0; --i) {
+    data[i] = uid;
+    uid >>= 8;
+  }
+}
+
+static rdm_uid_t rdm_get_uid_from(const uint8_t *data) {
+  rdm_uid_t uid = 0;
+  for (int i = 0; i < 6; ++i) {
+    uid = (uid << 8) | data[i];
+  }
+  return uid;
+}
+
+static uint16_t rdm_sum(const uint8_t *data, size_t size) {
+  uint16_t sum = 0;
+  for (size_t i = 0; i < size; ++i) {
+    sum += data[i];
+  }
+  return sum;
+}
+
+size_t rdm_encode_header(void *data, const rdm_header_t *header) {
+  uint8_t *const buf = data;
+  const size_t message_len = RDM_HEADER_SIZE + header->pdl;
+  buf[0] = RDM_SC;
+  buf[1] = RDM_SUB_SC;
+  buf[2] = message_len;
+  rdm_put_uid(&buf[3], header->destination_uid);
+  rdm_put_uid(&buf[9], header->source_uid);
+  buf[15] = header->tn;
+  buf[16] = header->port_id;
+  buf[17] = header->message_count;
+  buf[18] = header->sub_device >> 8;
+  buf[19] = header->sub_device;
+  buf[20] = header->cc;
+  buf[21] = header->pid >> 8;
+  buf[22] = header->pid;
+  buf[23] = header->pdl;
+
+  // The checksum includes the parameter data which follows the header
+  const uint16_t checksum = rdm_sum(buf, message_len);
+  buf[message_len] = checksum >> 8;
+  buf[message_len + 1] = checksum;
+  return RDM_HEADER_SIZE + 2;
+}
+
+bool rdm_decode_header(const void *data, rdm_header_t *header) {
+  const uint8_t *const buf = data;
+  const size_t message_len = buf[2];
+  if (buf[0] != RDM_SC || buf[1] != RDM_SUB_SC ||
+      message_len < RDM_HEADER_SIZE) {
+    return false;
+  }
+  header->destination_uid = rdm_get_uid_from(&buf[3]);
+  header->source_uid = rdm_get_uid_from(&buf[9]);
+  header->tn = buf[15];
+  header->port_id = buf[16];
+  header->message_count = buf[17];
+  header->sub_device = buf[18] << 8 | buf[19];
+  header->cc = buf[20];
+  header->pid = buf[21] << 8 | buf[22];
+  header->pdl = buf[23];
+  header->checksum_is_valid =
+      rdm_sum(buf, message_len) ==
+      (buf[message_len] << 8 | buf[message_len + 1]);
+  return true;
+}
+
+size_t rdm_encode_disc_response(void *data, size_t preamble_len,
+                                rdm_uid_t uid) {
+  if (preamble_len > RDM_DISC_RESPONSE_MAX_PREAMBLE) {
+    preamble_len = RDM_DISC_RESPONSE_MAX_PREAMBLE;
+  }
+  uint8_t *buf = data;
+  memset(buf, RDM_DISC_RESPONSE_PREAMBLE, preamble_len);
+  buf += preamble_len;
+  *buf++ = RDM_DISC_RESPONSE_DELIMITER;
+
+  // Each byte of the UID is sent twice, OR'd with 0xaa and with 0x55
+  uint8_t uid_bytes[6];
+  rdm_put_uid(uid_bytes, uid);
+  uint16_t checksum = 0;
+  for (int i = 0; i < 6; ++i) {
+    buf[i * 2] = uid_bytes[i] | 0xaa;
+    buf[i * 2 + 1] = uid_bytes[i] | 0x55;
+    checksum += buf[i * 2] + buf[i * 2 + 1];
+  }
+  buf[12] = (checksum >> 8) | 0xaa;
+  buf[13] = (checksum >> 8) | 0x55;
+  buf[14] = (checksum & 0xff) | 0xaa;
+  buf[15] = (checksum & 0xff) | 0x55;
+  return preamble_len + 17;
+}
+
+bool rdm_decode_disc_response(const uint8_t *data, rdm_uid_t *uid) {
+  // Find the delimiter after up to seven preamble bytes, which may have been
+  // corrupted by a collision
+  size_t preamble_len = 0;
+  while (preamble_len < RDM_DISC_RESPONSE_MAX_PREAMBLE &&
+         data[preamble_len] != RDM_DISC_RESPONSE_DELIMITER) {
+    ++preamble_len;
+  }
+  if (data[preamble_len] != RDM_DISC_RESPONSE_DELIMITER) {
+    return false;
+  }
+  const uint8_t *const buf = &data[preamble_len + 1];
+
+  uint8_t uid_bytes[6];
+  uint16_t sum = 0;
+  for (int i = 0; i < 6; ++i) {
+    uid_bytes[i] = buf[i * 2] & buf[i * 2 + 1];
+    sum += buf[i * 2] + buf[i * 2 + 1];
+  }
+  const uint16_t checksum = (buf[12] & buf[13]) << 8 | (buf[14] & buf[15]);
+  *uid = rdm_get_uid_from(uid_bytes);
+  return sum == checksum;
+}
+
+size_t rdm_encode_mute(void *pd, const rdm_disc_mute_t *param) {
+  uint8_t *const buf = pd;
+  buf[0] = 0;
+  buf[1] = param->managed_proxy | param->sub_device << 1 |
+           param->boot_loader << 2 | param->proxied_device << 3;
+  if (param->binding_uid == 0) {
+    return 2;
+  }
+  rdm_put_uid(&buf[2], param->binding_uid);
+  return 8;
+}
+
+size_t rdm_decode_mute(const void *pd, rdm_disc_mute_t *param, size_t num,
+                       size_t pdl) {
+  if (num == 0 || pdl < 2) {
+    return 0;
+  }
+  const uint8_t *const buf = pd;
+  param->managed_proxy = buf[1] & 0x01;
+  param->sub_device = buf[1] & 0x02;
+  param->boot_loader = buf[1] & 0x04;
+  param->proxied_device = buf[1] & 0x08;
+  param->binding_uid = pdl >= 8 ? rdm_get_uid_from(&buf[2]) : 0;
+  return 1;
+}
+
+size_t rdm_encode_uids(void *pd, const rdm_uid_t *uids, size_t num) {
+  uint8_t *const buf = pd;
+  for (size_t i = 0; i < num; ++i) {
+    rdm_put_uid(&buf[i * 6], uids[i]);
+  }
+  return num * 6;
+}
+
+size_t rdm_encode_8bit(void *pd, const void *data, size_t num) {
+  memcpy(pd, data, num);
+  return num;
+}
+
+size_t rdm_decode_8bit(const void *pd, void *data, size_t num, size_t pdl) {
+  const size_t num_decoded = pdl < num ? pdl : num;
+  memcpy(data, pd, num_decoded);
+  return num_decoded;
+}
+
+size_t rdm_encode_16bit(void *pd, const void *data, size_t num) {
+  uint8_t *const buf = pd;
+  const uint16_t *const values = data;
+  for (size_t i = 0; i < num; ++i) {
+    buf[i * 2] = values[i] >> 8;
+    buf[i * 2 + 1] = values[i];
+  }
+  return num * 2;
+}
+
+size_t rdm_decode_16bit(const void *pd, void *data, size_t num, size_t pdl) {
+  const uint8_t *const buf = pd;
+  uint16_t *const values = data;
+  const size_t num_decoded = pdl / 2 < num ? pdl / 2 : num;
+  for (size_t i = 0; i < num_decoded; ++i) {
+    values[i] = buf[i * 2] << 8 | buf[i * 2 + 1];
+  }
+  return num_decoded;
+}
+
+size_t rdm_decode_string(const void *pd, void *data, size_t size, size_t pdl) {
+  if (size == 0) {
+    return 0;
+  }
+  size_t len = pdl < RDM_MAX_STRING_LEN ? pdl : RDM_MAX_STRING_LEN;
+  if (len > size - 1) {
+    len = size - 1;
+  }
+  memcpy(data, pd, len);
+  ((char *)data)[len] = '\0';
+  return len;
+}
+
+size_t rdm_encode_device_info_(void *pd, const rdm_device_info_t *device_info) {
+  uint8_t *const buf = pd;
+  buf[0] = device_info->major_rdm_version;
+  buf[1] = device_info->minor_rdm_version;
+  buf[2] = device_info->model_id >> 8;
+  buf[3] = device_info->model_id;
+  buf[4] = device_info->coarse_product_category;
+  buf[5] = device_info->fine_product_category;
+  buf[6] = device_info->software_version_id >> 24;
+  buf[7] = device_info->software_version_id >> 16;
+  buf[8] = device_info->software_version_id >> 8;
+  buf[9] = device_info->software_version_id;
+  buf[10] = device_info->footprint >> 8;
+  buf[11] = device_info->footprint;
+  buf[12] = device_info->current_personality;
+  buf[13] = device_info->personality_count;
+  buf[14] = device_info->start_address >> 8;
+  buf[15] = device_info->start_address;
+  buf[16] = device_info->sub_device_count >> 8;
+  buf[17] = device_info->sub_device_count;
+  buf[18] = device_info->sensor_count;
+  return RDM_DEVICE_INFO_PDL;
+}
+
+size_t rdm_decode_device_info(const void *pd, void *data, size_t num,
+                              size_t pdl) {
+  if (num == 0 || pdl < RDM_DEVICE_INFO_PDL) {
+    return 0;
+  }
+  const uint8_t *const buf = pd;
+  rdm_device_info_t *const device_info = data;
+  device_info->major_rdm_version = buf[0];
+  device_info->minor_rdm_version = buf[1];
+  device_info->model_id = buf[2] << 8 | buf[3];
+  device_info->coarse_product_category = buf[4];
+  device_info->fine_product_category = buf[5];
+  device_info->software_version_id = (uint32_t)buf[6] << 24 |
+                                     buf[7] << 16 | buf[8] << 8 | buf[9];
+  device_info->footprint = buf[10] << 8 | buf[11];
+  device_info->current_personality = buf[12];
+  device_info->personality_count = buf[13];
+  // A start address of 0xffff means the device has no DMX footprint
+  const uint16_t start_address = buf[14] << 8 | buf[15];
+  device_info->start_address = start_address == 0xffff ? -1 : start_address;
+  device_info->sub_device_count = buf[16] << 8 | buf[17];
+  device_info->sensor_count = buf[18];
+  return 1;
+}
@@ -0,0 +1,177 @@
+/**
+ * @file functions.h
+ * @brief This file contains the functions which encode and decode RDM packets
+ * and the parameter data of the discovery PIDs between host values and the
+ * big-endian wire format. The parameter data of other PIDs is encoded by the
+ * table-driven codec in esp_rdm_codec.h.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rdm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Encodes an RDM header and its checksum. The parameter data must
+ * already be written after the header, at offset 24.
+ *
+ * @param[out] data The buffer of the packet. It must fit the parameter data
+ * and the checksum.
+ * @param[in] header The header to encode.
+ * @return The size of the header and the checksum, which is 26. Add the
+ * parameter data length to get the size of the packet.
+ */
+size_t rdm_encode_header(void *data, const rdm_header_t *header);
+
+/**
+ * @brief Decodes an RDM header and verifies its checksum.
+ *
+ * @param[in] data The buffer of the packet. It must hold at least the number
+ * of bytes in the message length field plus the checksum.
+ * @param[out] header The decoded header. Its checksum_is_valid field reports
+ * whether the checksum matched.
+ * @return true if the packet is an RDM packet or false if it is not.
+ */
+bool rdm_decode_header(const void *data, rdm_header_t *header);
+
+/**
+ * @brief Encodes a DISC_UNIQUE_BRANCH response, which is sent without a DMX
+ * break.
+ *
+ * @param[out] data The buffer of the response. It must fit preamble_len + 17
+ * bytes.
+ * @param preamble_len The number of preamble bytes, from 0 to 7.
+ * @param uid The UID of the responder.
+ * @return The size of the response.
+ */
+size_t rdm_encode_disc_response(void *data, size_t preamble_len,
+                                rdm_uid_t uid);
+
+/**
+ * @brief Decodes a DISC_UNIQUE_BRANCH response and verifies its checksum.
+ *
+ * @param[in] data The received response, starting with its preamble. It must
+ * hold at least 24 bytes.
+ * @param[out] uid The decoded UID.
+ * @return true if the checksum matched or false if the response is invalid,
+ * e.g. because several responders collided.
+ */
+bool rdm_decode_disc_response(const uint8_t *data, rdm_uid_t *uid);
+
+/**
+ * @brief Encodes the parameter data of a DISC_MUTE or DISC_UN_MUTE response.
+ *
+ * @param[out] pd The parameter data buffer. It must fit 8 bytes.
+ * @param[in] param The control field and binding UID.
+ * @return The parameter data length, which is 8 if the binding UID is not 0
+ * or 2 otherwise.
+ */
+size_t rdm_encode_mute(void *pd, const rdm_disc_mute_t *param);
+
+/**
+ * @brief Decodes the parameter data of a DISC_MUTE or DISC_UN_MUTE response.
+ *
+ * @param[in] pd The parameter data.
+ * @param[out] param The control field and binding UID.
+ * @param num The number of parameters which fit in param.
+ * @param pdl The parameter data length.
+ * @return The number of parameters which were decoded, which is 0 if the
+ * parameter data is too short.
+ */
+size_t rdm_decode_mute(const void *pd, rdm_disc_mute_t *param, size_t num,
+                       size_t pdl);
+
+/**
+ * @brief Encodes a list of UIDs.
+ *
+ * @param[out] pd The parameter data buffer. It must fit 6 bytes per UID.
+ * @param[in] uids The UIDs to encode.
+ * @param num The number of UIDs.
+ * @return The parameter data length.
+ */
+size_t rdm_encode_uids(void *pd, const rdm_uid_t *uids, size_t num);
+
+/**
+ * @brief Encodes a list of 8-bit values.
+ *
+ * @param[out] pd The parameter data buffer.
+ * @param[in] data An array of uint8_t.
+ * @param num The number of values.
+ * @return The parameter data length.
+ */
+size_t rdm_encode_8bit(void *pd, const void *data, size_t num);
+
+/**
+ * @brief Decodes a list of 8-bit values.
+ *
+ * @param[in] pd The parameter data.
+ * @param[out] data An array of uint8_t.
+ * @param num The number of values which fit in data.
+ * @param pdl The parameter data length.
+ * @return The number of values which were decoded.
+ */
+size_t rdm_decode_8bit(const void *pd, void *data, size_t num, size_t pdl);
+
+/**
+ * @brief Encodes a list of 16-bit values.
+ *
+ * @param[out] pd The parameter data buffer.
+ * @param[in] data An array of uint16_t.
+ * @param num The number of values.
+ * @return The parameter data length.
+ */
+size_t rdm_encode_16bit(void *pd, const void *data, size_t num);
+
+/**
+ * @brief Decodes a list of 16-bit values.
+ *
+ * @param[in] pd The parameter data.
+ * @param[out] data An array of uint16_t.
+ * @param num The number of values which fit in data.
+ * @param pdl The parameter data length.
+ * @return The number of values which were decoded.
+ */
+size_t rdm_decode_16bit(const void *pd, void *data, size_t num, size_t pdl);
+
+/**
+ * @brief Decodes a string, which is not null-terminated on the line.
+ *
+ * @param[in] pd The parameter data.
+ * @param[out] data A char array. The string is always null-terminated.
+ * @param size The size of the char array.
+ * @param pdl The parameter data length.
+ * @return The length of the decoded string.
+ */
+size_t rdm_decode_string(const void *pd, void *data, size_t size, size_t pdl);
+
+/**
+ * @brief Encodes the parameter data of a DEVICE_INFO response.
+ *
+ * @param[out] pd The parameter data buffer. It must fit 19 bytes.
+ * @param[in] device_info The device info to encode.
+ * @return The parameter data length, which is 19.
+ */
+size_t rdm_encode_device_info_(void *pd, const rdm_device_info_t *device_info);
+
+/**
+ * @brief Decodes the parameter data of a DEVICE_INFO response.
+ *
+ * @param[in] pd The parameter data.
+ * @param[out] data An array of rdm_device_info_t.
+ * @param num The number of parameters which fit in data.
+ * @param pdl The parameter data length.
+ * @return The number of parameters which were decoded, which is 0 if the
+ * parameter data is too short.
+ */
+size_t rdm_decode_device_info(const void *pd, void *data, size_t num,
+                              size_t pdl);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,34 @@
+/**
+ * @file types.h
+ * @brief This file contains the wire layout of RDM packets, which is used to
+ * read the fields of a packet in the driver buffer without decoding it.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* An RDM packet as it is sent on the line. Multi-byte fields are big-endian
+and must be converted before they are used. */
+typedef struct __attribute__((packed)) rdm_data_t {
+  uint8_t sc;                  // The start code, which is always RDM_SC.
+  uint8_t sub_sc;              // The sub-start code, which is always RDM_SUB_SC.
+  uint8_t message_len;         // The length of the message, up to but not including the checksum.
+  uint8_t destination_uid[6];  // The UID of the target device(s).
+  uint8_t source_uid[6];       // The UID of the device originating the packet.
+  uint8_t tn;                  // The transaction number.
+  uint8_t port_id;             // The port ID of a request, or the response type of a response.
+  uint8_t message_count;       // The number of queued messages of a responder.
+  uint16_t sub_device;         // The sub-device.
+  uint8_t cc;                  // The command class.
+  uint16_t pid;                // The parameter ID.
+  uint8_t pdl;                 // The parameter data length.
+  uint8_t pd[231];             // The parameter data, followed by the checksum.
+} rdm_data_t;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,94 @@
+/**
+ * @file rdm_responder.h
+ * @brief This file contains the per-port state which the DMX interrupt
+ * handlers use to respond to RDM requests without waking a task.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "rdm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum rdm_disc_fast_path_size_t {
+  RDM_DISC_RESPONSE_PREAMBLE_LEN = 7,  // The preamble length of pre-encoded DISC_UNIQUE_BRANCH responses.
+  RDM_DISC_RESPONSE_SIZE = 24,         // The size of a DISC_UNIQUE_BRANCH response with a full preamble.
+};
+
+/* State of the DISC_UNIQUE_BRANCH fast path of each DMX port. When enabled,
+the DMX interrupt handler compares the bounds of each DISC_UNIQUE_BRANCH request
+against the UID and mute flag of the port and sends the pre-encoded response
+itself. The response is encoded in task context whenever the UID changes and is
+only read in the interrupt handlers. */
+typedef struct rdm_disc_fast_path_t {
+  bool is_enabled;        // True if the interrupt handler responds to DISC_UNIQUE_BRANCH requests.
+  bool is_responding;     // True while the interrupt handler is sending a response.
+  rdm_uid_t uid;          // The UID which was encoded into the response.
+  TaskHandle_t receiver;  // The task which was waiting to receive when the response was started. It is not notified of the response.
+  uint8_t response[RDM_DISC_RESPONSE_SIZE];  // The pre-encoded DISC_UNIQUE_BRANCH response.
+} rdm_disc_fast_path_t;
+
+extern rdm_disc_fast_path_t rdm_disc_fast_path[DMX_NUM_MAX];
+
+/* State of the RDM responder task of each DMX port which is read in the DMX
+interrupt handler. While the responder is enabled, the interrupt handler does
+not notify the receiving task of RDM packets which are not addressed to the
+port so that the responder task is only woken for DMX packets and RDM requests
+to which it may need to respond. */
+typedef struct rdm_responder_isr_t {
+  bool is_enabled;       // True if RDM packets which are not addressed to the port are filtered.
+  uint32_t num_dropped;  // The number of RDM requests addressed to the port which arrived while the responder task was busy.
+} rdm_responder_isr_t;
+
+extern rdm_responder_isr_t rdm_responder_isr[DMX_NUM_MAX];
+
+/* A slot of the virtual responder hash table. A UID of 0 marks a free slot. */
+typedef struct rdm_virtual_slot_t {
+  rdm_uid_t uid;   // The UID of the virtual responder.
+  uint16_t index;  // The index of the virtual responder in its pool.
+} rdm_virtual_slot_t;
+
+/* UIDs of the virtual responders of each DMX port, in an open-addressed hash
+table with linear probing. The table is allocated in internal RAM and is only
+modified inside the DMX spinlock so that the DMX interrupt handler can look up
+the destination of each request in constant time. */
+typedef struct rdm_virtual_table_t {
+  rdm_virtual_slot_t *slots;  // The slots of the table, or NULL if no virtual responders are installed.
+  size_t mask;                // The number of slots minus one. The number of slots is a power of two.
+} rdm_virtual_table_t;
+
+extern rdm_virtual_table_t rdm_virtual_table[DMX_NUM_MAX];
+
+// Returns the first slot to probe for a UID.
+static inline size_t rdm_virtual_hash(const rdm_virtual_table_t *table,
+                                      rdm_uid_t uid) {
+  return (size_t)((uid * 0x9e3779b97f4a7c15ull) >> 40) & table->mask;
+}
+
+// Returns the pool index of a virtual responder, or -1 if the UID is not a
+// virtual responder. Must be called inside the DMX spinlock.
+static inline int rdm_virtual_lookup(const rdm_virtual_table_t *table,
+                                     rdm_uid_t uid) {
+  if (table->slots == NULL || uid == 0) {
+    return -1;
+  }
+  for (size_t i = rdm_virtual_hash(table, uid);; i = (i + 1) & table->mask) {
+    const rdm_virtual_slot_t *const slot = &table->slots[i];
+    if (slot->uid == uid) {
+      return slot->index;
+    } else if (slot->uid == 0) {
+      return -1;
+    }
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
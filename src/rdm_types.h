@@ -56,6 +56,11 @@ static const rdm_sub_device_t RDM_ROOT_DEVICE = 0;
  */
 static const rdm_sub_device_t RDM_ALL_SUB_DEVICES = 0xffff;
 
+/**
+ * @brief The highest sub-device number which may be used.
+ */
+static const rdm_sub_device_t RDM_MAX_SUB_DEVICE = 512;
+
 /**
  * @brief The RDM command class (CC) type. The command class specifies the
  * action of the message. Responders shall always generate a response to
@@ -103,6 +108,34 @@ typedef enum rdm_nr_t {
   RDM_NR_PROXY_BUFFER_FULL = 0x000a           // The proxy buffer is full and cannot store any more queued message or status message responses.
 } rdm_nr_t;
 
+/**
+ * @brief The status type of RDM status messages. In QUEUED_MESSAGE and
+ * STATUS_MESSAGES requests, the status type selects the lowest severity of
+ * status messages which are returned.
+ */
+typedef enum rdm_status_t {
+  RDM_STATUS_NONE = 0x00,              // Not allowed in status messages. Requests that no status messages are returned.
+  RDM_STATUS_GET_LAST_MESSAGE = 0x01,  // Not allowed in status messages. Requests the last message which was returned.
+  RDM_STATUS_ADVISORY = 0x02,          // The device is reporting an advisory condition.
+  RDM_STATUS_WARNING = 0x03,           // The device is reporting a warning condition.
+  RDM_STATUS_ERROR = 0x04,             // The device is reporting an error condition.
+  RDM_STATUS_ADVISORY_CLEARED = 0x12,  // A previously reported advisory condition has been cleared.
+  RDM_STATUS_WARNING_CLEARED = 0x13,   // A previously reported warning condition has been cleared.
+  RDM_STATUS_ERROR_CLEARED = 0x14,     // A previously reported error condition has been cleared.
+} rdm_status_t;
+
+/**
+ * @brief A status message which is collected with QUEUED_MESSAGE or
+ * STATUS_MESSAGES requests.
+ */
+typedef struct rdm_status_message_t {
+  rdm_sub_device_t sub_device;  // The sub-device which is reporting the status message.
+  rdm_status_t status_type;     // The severity of the status message.
+  uint16_t message_id;          // The status message ID. IDs below 0x8000 are defined in the RDM standard.
+  int16_t data1;                // The first data value of the status message.
+  int16_t data2;                // The second data value of the status message.
+} rdm_status_message_t;
+
 /**
  * @brief The parameter ID (PID) is a 16-bit number that identifies a specific
  * type of parameter data. The PID may represent either a well known parameter
@@ -268,6 +301,22 @@ typedef struct rdm_device_info_t {
   size_t sensor_count;           // This field indicates the number of available sensors in a root device or sub-device. When this parameter is directed to a sub-device, the reply shall be identical for any sub-device owned by a specific root device.
 } rdm_device_info_t;
 
+/**
+ * @brief Response latency statistics of a single RDM responder, as measured by
+ * the RDM controller. Latency is measured from the moment the controller
+ * finishes sending a request to the moment the first slot of the response is
+ * received.
+ */
+typedef struct rdm_latency_stats_t {
+  rdm_uid_t uid;           // The UID of the responder.
+  uint32_t ewma_us;        // The exponentially weighted moving average of the response latency in microseconds.
+  uint32_t max_us;         // The largest response latency that has been measured in microseconds.
+  uint32_t num_responses;  // The number of responses that have been measured.
+  uint32_t num_lost;       // The number of requests for which no response was received.
+  uint32_t timeout_us;     // The response timeout in microseconds that is currently used for requests to this responder.
+  uint32_t attempts;       // The number of attempts that are currently made for discovery requests to this responder.
+} rdm_latency_stats_t;
+
 
 /**
  * All parameters of a rdm client device
@@ -1,38 +1,362 @@
 #include "rdmsensors.h"
-#include "string.h"
-RDMSensor sensors[8];
-uint8_t numOfSensors = 0;
 
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
 
-void addRDMSensor(uint8_t sensorNum, uint8_t sensorType, uint8_t sensorUnit, uint8_t sensorPrefix, int16_t range_min, int16_t range_max, int16_t normal_min, int16_t normal_max, char *sensor_desc){
-    
-    sensors[numOfSensors].sdef.sensorNum = sensorNum;
-    sensors[numOfSensors].sdef.sensorType = sensorType;
-    sensors[numOfSensors].sdef.sensorUnit = sensorUnit;
-    sensors[numOfSensors].sdef.sensorPrefix = sensorPrefix;
-    sensors[numOfSensors].sdef.range_min = range_min;
-    sensors[numOfSensors].sdef.range_max = range_max;
-    sensors[numOfSensors].sdef.normal_min = normal_min;
-    sensors[numOfSensors].sdef.normal_max = normal_max;
-    strcpy(sensors[numOfSensors].sdef.sensorDesc,sensor_desc);
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_rdm_client.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// Used for argument checking at the beginning of each function.
+#define RDM_SENSOR_CHECK(a, err_code, format, ...) \
+  ESP_RETURN_ON_FALSE(a, err_code, TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "rdm_sensors";  // The log tagline for the file.
+
+// The number of times a reader retries before it waits for the writer with the
+// spinlock of the sensor.
+#define RDM_SENSOR_READ_RETRIES (4)
+
+enum {
+  RDM_SENSOR_REQUEST_RECORD = 1 << 16,  // Set the recorded value to the request value.
+  RDM_SENSOR_REQUEST_RESET = 1 << 17,   // Set the minimum and maximum values to the request value.
+  RDM_SENSOR_REQUEST_VALUE_MASK = 0xffff,
+};
+
+// The state of a single sensor.
+typedef struct rdm_sensor_t {
+  sensorDef_t def;                  // The definition of the sensor.
+  atomic_uint seq;                  // Odd while the value parameter data is being written.
+  spinlock_t spinlock;              // Held while the value parameter data is being written.
+  uint8_t pd[RDM_SENSOR_VALUE_PDL];  // The SENSOR_VALUE parameter data, in wire format.
+  atomic_uint requests;             // Record and reset requests which have not been applied by a publish.
+  int16_t min;                      // The minimum value. Only accessed by the publishing task.
+  int16_t max;                      // The maximum value. Only accessed by the publishing task.
+  int16_t recorded;                 // The recorded value. Only accessed by the publishing task.
+  bool has_value;                   // True once a value has been published. Only accessed by the publishing task.
+} rdm_sensor_t;
+
+// The sensor registry of a DMX port.
+typedef struct rdm_sensors_t {
+  SemaphoreHandle_t mux;  // Serializes adding sensors.
+  size_t capacity;        // The maximum number of sensors.
+  atomic_size_t count;    // The number of sensors which have been added.
+  rdm_sensor_t sensors[]; // The sensors.
+} rdm_sensors_t;
 
+static rdm_sensors_t *rdm_sensors[DMX_NUM_MAX] = {0};
 
-    numOfSensors++;
+static void rdm_sensor_put_16(uint8_t *pd, int16_t value) {
+  pd[0] = (uint16_t)value >> 8;
+  pd[1] = value;
 }
 
+static int16_t rdm_sensor_get_16(const uint8_t *pd) {
+  return (int16_t)((pd[0] << 8) | pd[1]);
+}
+
+// Returns the sensor or NULL if it does not exist.
+static rdm_sensor_t *rdm_sensor_find(dmx_port_t dmx_num, uint8_t sensor_num) {
+  if (dmx_num >= DMX_NUM_MAX || rdm_sensors[dmx_num] == NULL ||
+      sensor_num >= atomic_load_explicit(&rdm_sensors[dmx_num]->count,
+                                         memory_order_acquire)) {
+    return NULL;
+  }
+  return &rdm_sensors[dmx_num]->sensors[sensor_num];
+}
+
+// Copies the parameter data of a sensor without blocking the publishing task.
+// The publishing task writes the parameter data with the spinlock held, so it
+// cannot be preempted by a reader on its own core. A reader on the other core
+// which keeps seeing a write in progress takes the spinlock instead of
+// spinning.
+static void rdm_sensor_read(rdm_sensor_t *sensor, uint8_t *pd) {
+  for (int i = 0; i < RDM_SENSOR_READ_RETRIES; ++i) {
+    const unsigned seq =
+        atomic_load_explicit(&sensor->seq, memory_order_acquire);
+    memcpy(pd, sensor->pd, RDM_SENSOR_VALUE_PDL);
+    atomic_thread_fence(memory_order_acquire);
+    if (!(seq & 1) &&
+        seq == atomic_load_explicit(&sensor->seq, memory_order_relaxed)) {
+      break;
+    } else if (i == RDM_SENSOR_READ_RETRIES - 1) {
+      taskENTER_CRITICAL(&sensor->spinlock);
+      memcpy(pd, sensor->pd, RDM_SENSOR_VALUE_PDL);
+      taskEXIT_CRITICAL(&sensor->spinlock);
+    }
+  }
+
+  // Apply requests which have not been published yet
+  const unsigned requests =
+      atomic_load_explicit(&sensor->requests, memory_order_acquire);
+  const int16_t value = requests & RDM_SENSOR_REQUEST_VALUE_MASK;
+  if ((requests & RDM_SENSOR_REQUEST_RESET) &&
+      (sensor->def.sensorHistory & MINMAXSUPPORTED)) {
+    rdm_sensor_put_16(&pd[3], value);
+    rdm_sensor_put_16(&pd[5], value);
+  }
+  if ((requests & (RDM_SENSOR_REQUEST_RECORD | RDM_SENSOR_REQUEST_RESET)) &&
+      (sensor->def.sensorHistory & RECSUPPORTED)) {
+    rdm_sensor_put_16(&pd[7], value);
+  }
+}
+
+// Posts a request which is applied by the next publish of the sensor.
+static void rdm_sensor_request(rdm_sensor_t *sensor, unsigned request) {
+  uint8_t pd[RDM_SENSOR_VALUE_PDL];
+  unsigned expected = atomic_load_explicit(&sensor->requests,
+                                           memory_order_relaxed);
+  unsigned desired;
+  do {
+    rdm_sensor_read(sensor, pd);
+    const uint16_t value = rdm_sensor_get_16(&pd[1]);
+    desired = (expected & ~RDM_SENSOR_REQUEST_VALUE_MASK) | request | value;
+  } while (!atomic_compare_exchange_weak_explicit(
+      &sensor->requests, &expected, desired, memory_order_release,
+      memory_order_relaxed));
+}
+
+esp_err_t rdm_sensors_install(dmx_port_t dmx_num, size_t capacity) {
+  RDM_SENSOR_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                   "dmx_num error");
+  RDM_SENSOR_CHECK(capacity > 0 && capacity < RDM_SENSOR_ALL,
+                   ESP_ERR_INVALID_ARG, "capacity error");
+  RDM_SENSOR_CHECK(rdm_sensors[dmx_num] == NULL, ESP_ERR_INVALID_STATE,
+                   "sensors already installed");
+
+  rdm_sensors_t *registry =
+      calloc(1, sizeof(rdm_sensors_t) + capacity * sizeof(rdm_sensor_t));
+  if (registry == NULL) {
+    ESP_LOGE(TAG, "sensor registry malloc error");
+    return ESP_ERR_NO_MEM;
+  }
+  registry->mux = xSemaphoreCreateMutex();
+  if (registry->mux == NULL) {
+    ESP_LOGE(TAG, "sensor registry mutex malloc error");
+    free(registry);
+    return ESP_ERR_NO_MEM;
+  }
+  registry->capacity = capacity;
+  atomic_init(&registry->count, 0);
+
+  rdm_sensors[dmx_num] = registry;
+  return ESP_OK;
+}
+
+esp_err_t rdm_sensors_delete(dmx_port_t dmx_num) {
+  RDM_SENSOR_CHECK(dmx_num < DMX_NUM_MAX, ESP_ERR_INVALID_ARG,
+                   "dmx_num error");
+
+  rdm_sensors_t *registry = rdm_sensors[dmx_num];
+  if (registry != NULL) {
+    rdm_sensors[dmx_num] = NULL;
+    vSemaphoreDelete(registry->mux);
+    free(registry);
+  }
+  rdm_client_set_sensor_count(dmx_num, 0);
+  return ESP_OK;
+}
+
+int rdm_sensor_add(dmx_port_t dmx_num, const sensorDef_t *def) {
+  RDM_SENSOR_CHECK(dmx_num < DMX_NUM_MAX, -1, "dmx_num error");
+  RDM_SENSOR_CHECK(def != NULL, -1, "def is null");
+
+  if (rdm_sensors[dmx_num] == NULL &&
+      rdm_sensors_install(dmx_num, CONFIG_RDM_SENSORS_DEFAULT_CAPACITY) !=
+          ESP_OK) {
+    return -1;
+  }
+  rdm_sensors_t *registry = rdm_sensors[dmx_num];
+
+  xSemaphoreTake(registry->mux, portMAX_DELAY);
+  const size_t sensor_num =
+      atomic_load_explicit(&registry->count, memory_order_relaxed);
+  if (sensor_num >= registry->capacity) {
+    xSemaphoreGive(registry->mux);
+    ESP_LOGE(TAG, "max num sensors reached");
+    return -1;
+  }
+
+  // Initialize the sensor before it is made visible to readers
+  rdm_sensor_t *sensor = &registry->sensors[sensor_num];
+  sensor->def = *def;
+  sensor->def.sensorNum = sensor_num;
+  sensor->def.sensorDesc[sizeof(sensor->def.sensorDesc) - 1] = '\0';
+  atomic_init(&sensor->seq, 0);
+  portMUX_INITIALIZE(&sensor->spinlock);
+  atomic_init(&sensor->requests, 0);
+  memset(sensor->pd, 0, sizeof(sensor->pd));
+  sensor->pd[0] = sensor_num;
+  sensor->min = 0;
+  sensor->max = 0;
+  sensor->recorded = 0;
+  sensor->has_value = false;
+  atomic_store_explicit(&registry->count, sensor_num + 1,
+                        memory_order_release);
+  xSemaphoreGive(registry->mux);
+
+  rdm_client_set_sensor_count(dmx_num, sensor_num + 1);
+  return sensor_num;
+}
+
+size_t rdm_sensor_count(dmx_port_t dmx_num) {
+  if (dmx_num >= DMX_NUM_MAX || rdm_sensors[dmx_num] == NULL) {
+    return 0;
+  }
+  return atomic_load_explicit(&rdm_sensors[dmx_num]->count,
+                              memory_order_acquire);
+}
+
+const sensorDef_t *rdm_sensor_get_definition(dmx_port_t dmx_num,
+                                             uint8_t sensor_num) {
+  const rdm_sensor_t *sensor = rdm_sensor_find(dmx_num, sensor_num);
+  return sensor != NULL ? &sensor->def : NULL;
+}
+
+bool rdm_sensor_set_value(dmx_port_t dmx_num, uint8_t sensor_num,
+                          int16_t value) {
+  rdm_sensor_t *sensor = rdm_sensor_find(dmx_num, sensor_num);
+  if (sensor == NULL) {
+    return false;
+  }
+
+  // Apply pending requests and track the minimum and maximum values. Requests
+  // carry the last published value, so until a value has been published they
+  // carry no value and the first value seeds the minimum, maximum, and
+  // recorded values instead.
+  const unsigned requests = atomic_exchange_explicit(&sensor->requests, 0,
+                                                     memory_order_acquire);
+  const int16_t request_value = requests & RDM_SENSOR_REQUEST_VALUE_MASK;
+  if (!sensor->has_value) {
+    sensor->min = value;
+    sensor->max = value;
+    sensor->recorded = value;
+    sensor->has_value = true;
+  } else {
+    if (requests & RDM_SENSOR_REQUEST_RESET) {
+      sensor->min = request_value;
+      sensor->max = request_value;
+    }
+    if (requests & (RDM_SENSOR_REQUEST_RECORD | RDM_SENSOR_REQUEST_RESET)) {
+      sensor->recorded = request_value;
+    }
+  }
+  if (value < sensor->min) {
+    sensor->min = value;
+  }
+  if (value > sensor->max) {
+    sensor->max = value;
+  }
+
+  // Publish the new parameter data
+  const uint8_t history = sensor->def.sensorHistory;
+  taskENTER_CRITICAL(&sensor->spinlock);
+  const unsigned seq = atomic_load_explicit(&sensor->seq, memory_order_relaxed);
+  atomic_store_explicit(&sensor->seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  const bool has_min_max = history & MINMAXSUPPORTED;
+  const bool has_recorded = history & RECSUPPORTED;
+  rdm_sensor_put_16(&sensor->pd[1], value);
+  rdm_sensor_put_16(&sensor->pd[3], has_min_max ? sensor->min : 0);
+  rdm_sensor_put_16(&sensor->pd[5], has_min_max ? sensor->max : 0);
+  rdm_sensor_put_16(&sensor->pd[7], has_recorded ? sensor->recorded : 0);
+  atomic_store_explicit(&sensor->seq, seq + 2, memory_order_release);
+  taskEXIT_CRITICAL(&sensor->spinlock);
+
+  return true;
+}
+
+bool rdm_sensor_record(dmx_port_t dmx_num, uint8_t sensor_num) {
+  if (sensor_num == RDM_SENSOR_ALL) {
+    const size_t count = rdm_sensor_count(dmx_num);
+    for (size_t i = 0; i < count; ++i) {
+      rdm_sensor_t *sensor = rdm_sensor_find(dmx_num, i);
+      if (sensor->def.sensorHistory & RECSUPPORTED) {
+        rdm_sensor_request(sensor, RDM_SENSOR_REQUEST_RECORD);
+      }
+    }
+    return true;
+  }
+
+  rdm_sensor_t *sensor = rdm_sensor_find(dmx_num, sensor_num);
+  if (sensor == NULL || !(sensor->def.sensorHistory & RECSUPPORTED)) {
+    return false;
+  }
+  rdm_sensor_request(sensor, RDM_SENSOR_REQUEST_RECORD);
+  return true;
+}
+
+bool rdm_sensor_reset(dmx_port_t dmx_num, uint8_t sensor_num) {
+  if (sensor_num == RDM_SENSOR_ALL) {
+    const size_t count = rdm_sensor_count(dmx_num);
+    for (size_t i = 0; i < count; ++i) {
+      rdm_sensor_request(rdm_sensor_find(dmx_num, i), RDM_SENSOR_REQUEST_RESET);
+    }
+    return true;
+  }
+
+  rdm_sensor_t *sensor = rdm_sensor_find(dmx_num, sensor_num);
+  if (sensor == NULL) {
+    return false;
+  }
+  rdm_sensor_request(sensor, RDM_SENSOR_REQUEST_RESET);
+  return true;
+}
+
+size_t rdm_sensor_read_pd(dmx_port_t dmx_num, uint8_t sensor_num, void *pd) {
+  rdm_sensor_t *sensor = rdm_sensor_find(dmx_num, sensor_num);
+  if (sensor == NULL || pd == NULL) {
+    return 0;
+  }
+  rdm_sensor_read(sensor, pd);
+  return RDM_SENSOR_VALUE_PDL;
+}
+
+bool rdm_sensor_get_value(dmx_port_t dmx_num, uint8_t sensor_num,
+                          sensorData_t *data) {
+  uint8_t pd[RDM_SENSOR_VALUE_PDL];
+  if (data == NULL || !rdm_sensor_read_pd(dmx_num, sensor_num, pd)) {
+    return false;
+  }
+  data->sensorNum = pd[0];
+  data->sensorVal = rdm_sensor_get_16(&pd[1]);
+  data->minVal = rdm_sensor_get_16(&pd[3]);
+  data->maxVal = rdm_sensor_get_16(&pd[5]);
+  data->recVal = rdm_sensor_get_16(&pd[7]);
+  return true;
+}
+
+void addRDMSensor(uint8_t sensorNum, uint8_t sensorType, uint8_t sensorUnit, uint8_t sensorPrefix, int16_t range_min, int16_t range_max, int16_t normal_min, int16_t normal_max, char *sensor_desc){
+    sensorDef_t def = {
+        .sensorType = sensorType,
+        .sensorUnit = sensorUnit,
+        .sensorPrefix = sensorPrefix,
+        .range_min = range_min,
+        .range_max = range_max,
+        .normal_min = normal_min,
+        .normal_max = normal_max,
+        .sensorHistory = MINMAXSUPPORTED,
+    };
+    strncpy(def.sensorDesc, sensor_desc, sizeof(def.sensorDesc) - 1);
+
+    const int added = rdm_sensor_add(0, &def);
+    if (added >= 0 && added != sensorNum) {
+        ESP_LOGW(TAG, "sensor %d was added as sensor %d", sensorNum, added);
+    }
+}
 
 sensorData_t *getSensorData(uint8_t sensorNum){
-    
-   return &(sensors[sensorNum].sdata);
+    static sensorData_t data;
+    return rdm_sensor_get_value(0, sensorNum, &data) ? &data : NULL;
 }
 
 sensorDef_t *getSensorDef(uint8_t sensorNum){
-    return &(sensors[sensorNum].sdef);
+    return (sensorDef_t *)rdm_sensor_get_definition(0, sensorNum);
 }
 
-
 void setSensorVal(uint8_t sensorNum, int16_t val){
-    sensors[sensorNum].sdata.sensorVal = val;
-    if(val<sensors[sensorNum].sdata.minVal) sensors[sensorNum].sdata.minVal = val;
-    if(val<sensors[sensorNum].sdata.maxVal) sensors[sensorNum].sdata.maxVal = val;
-}
\ No newline at end of file
+    rdm_sensor_set_value(0, sensorNum, val);
+}
@@ -1,11 +1,30 @@
+/**
+ * @file rdmsensors.h
+ * @brief This file declares the RDM sensor registry. Each DMX port has its own
+ * registry with a fixed capacity. Sensor values are published with a seqlock
+ * so that a sampling task may update them at a high rate while the RDM
+ * responder reads consistent SENSOR_VALUE parameter data. The writer holds a
+ * spinlock only while it writes the parameter data, so that it cannot be
+ * preempted by a reader, and readers fall back to the spinlock after a few
+ * retries instead of spinning.
+ */
 #pragma once
 
-#include "stdint.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dmx_types.h"
+#include "esp_err.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#ifndef CONFIG_RDM_SENSORS_DEFAULT_CAPACITY
+#define CONFIG_RDM_SENSORS_DEFAULT_CAPACITY 8
+#endif
+
 
 typedef struct __attribute__ ((packed)) sensorData_t {
                         uint8_t sensorNum;
@@ -107,14 +126,132 @@ typedef struct RDMSensor {
 #define MINMAXSUPPORTED 2
 #define MINMAXANDRECSUPPORTED 3
 
-//extern RDMSensor sensors[8];
-//extern uint8_t numOfSensors;
- void addRDMSensor(uint8_t sensorNum, uint8_t sensorType, uint8_t sensorUnit, uint8_t sensorPrefix, int16_t range_min, int16_t range_max, int16_t normal_min, int16_t normal_max, char *sensorDesc);
+enum {
+  RDM_SENSOR_ALL = 0xff,           // The sensor number which addresses all sensors.
+  RDM_SENSOR_VALUE_PDL = 9,        // The parameter data length of SENSOR_VALUE.
+};
+
+/**
+ * @brief Installs the sensor registry of a DMX port. Sensors which are added
+ * to a port without an installed registry install one with a capacity of
+ * CONFIG_RDM_SENSORS_DEFAULT_CAPACITY.
+ *
+ * @param dmx_num The DMX port number.
+ * @param capacity The maximum number of sensors. Must be less than 255.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ * @retval ESP_ERR_INVALID_STATE if the registry is already installed.
+ * @retval ESP_ERR_NO_MEM if there is not enough memory.
+ */
+esp_err_t rdm_sensors_install(dmx_port_t dmx_num, size_t capacity);
+
+/**
+ * @brief Deletes the sensor registry of a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval ESP_OK on success.
+ * @retval ESP_ERR_INVALID_ARG if there is an argument error.
+ */
+esp_err_t rdm_sensors_delete(dmx_port_t dmx_num);
+
+/**
+ * @brief Adds a sensor to the registry of a DMX port. The sensor number is
+ * assigned by the registry and overwrites def->sensorNum. The sensorHistory
+ * field of the definition selects whether minimum, maximum, and recorded values
+ * are tracked; unsupported values are reported as 0.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] def The definition of the sensor.
+ * @return The sensor number or -1 on failure.
+ */
+int rdm_sensor_add(dmx_port_t dmx_num, const sensorDef_t *def);
+
+/**
+ * @brief Gets the number of sensors of a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The number of sensors.
+ */
+size_t rdm_sensor_count(dmx_port_t dmx_num);
+
+/**
+ * @brief Gets the definition of a sensor.
+ *
+ * @param dmx_num The DMX port number.
+ * @param sensor_num The sensor number.
+ * @return A pointer to the definition or NULL if the sensor does not exist.
+ */
+const sensorDef_t *rdm_sensor_get_definition(dmx_port_t dmx_num,
+                                             uint8_t sensor_num);
 
+/**
+ * @brief Publishes a new sensor value and updates the minimum and maximum
+ * values. The first value which is published seeds the minimum, maximum, and
+ * recorded values, even if the sensor was reset or recorded before. Each
+ * sensor must only be published from one task at a time. This function only
+ * holds the spinlock of the sensor while it writes the parameter data and may
+ * be called at a high rate.
+ *
+ * @param dmx_num The DMX port number.
+ * @param sensor_num The sensor number.
+ * @param value The new sensor value.
+ * @return true if the value was published.
+ */
+bool rdm_sensor_set_value(dmx_port_t dmx_num, uint8_t sensor_num,
+                          int16_t value);
+
+/**
+ * @brief Records the current value of a sensor, as by a RECORD_SENSORS
+ * request.
+ *
+ * @param dmx_num The DMX port number.
+ * @param sensor_num The sensor number or RDM_SENSOR_ALL.
+ * @return true on success or false if the sensor does not exist or does not
+ * support recorded values.
+ */
+bool rdm_sensor_record(dmx_port_t dmx_num, uint8_t sensor_num);
+
+/**
+ * @brief Resets the minimum, maximum, and recorded values of a sensor to its
+ * current value, as by a SENSOR_VALUE SET request.
+ *
+ * @param dmx_num The DMX port number.
+ * @param sensor_num The sensor number or RDM_SENSOR_ALL.
+ * @return true on success or false if the sensor does not exist.
+ */
+bool rdm_sensor_reset(dmx_port_t dmx_num, uint8_t sensor_num);
+
+/**
+ * @brief Reads the SENSOR_VALUE parameter data of a sensor directly from the
+ * registry. The values are always from a single publish.
+ *
+ * @param dmx_num The DMX port number.
+ * @param sensor_num The sensor number.
+ * @param[out] pd A buffer of at least RDM_SENSOR_VALUE_PDL bytes.
+ * @return The parameter data length or 0 if the sensor does not exist.
+ */
+size_t rdm_sensor_read_pd(dmx_port_t dmx_num, uint8_t sensor_num, void *pd);
+
+/**
+ * @brief Reads the values of a sensor.
+ *
+ * @param dmx_num The DMX port number.
+ * @param sensor_num The sensor number.
+ * @param[out] data The sensor values.
+ * @return true if the sensor exists.
+ */
+bool rdm_sensor_get_value(dmx_port_t dmx_num, uint8_t sensor_num,
+                          sensorData_t *data);
+
+/* Legacy functions which operate on the sensors of DMX port 0. */
+void addRDMSensor(uint8_t sensorNum, uint8_t sensorType, uint8_t sensorUnit, uint8_t sensorPrefix, int16_t range_min, int16_t range_max, int16_t normal_min, int16_t normal_max, char *sensorDesc);
+
+/// @note Returns a pointer to a snapshot which is overwritten by the next call, or NULL if the sensor does not exist.
 sensorData_t *getSensorData(uint8_t sensorNum);
+/// @note Returns NULL if the sensor does not exist.
 sensorDef_t *getSensorDef(uint8_t sensorNum);
 void setSensorVal(uint8_t sensorNum, int16_t val);
 
 #ifdef __cplusplus
 }
-#endif
\ No newline at end of file
+#endif